@@ -438,6 +438,7 @@
         'ios/crb_protocol_observers_unittest.mm',
         'ios/device_util_unittest.mm',
         'ios/weak_nsobject_unittest.mm',
+        'json/arena_value_unittest.cc',
         'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
         'json/json_value_converter_unittest.cc',
@@ -788,14 +789,20 @@
       'target_name': 'base_perftests',
       'type': '<(gtest_target_type)',
       'dependencies': [
+        'allocator/allocator.gyp:allocator_features#target',
         'base',
         'test_support_base',
         '../testing/gtest.gyp:gtest',
       ],
       'sources': [
+        'json/json_perftest.cc',
         'message_loop/message_pump_perftest.cc',
+        'metrics/statistics_recorder_perftest.cc',
+        'task_scheduler/scheduler_thread_pool_impl_perftest.cc',
         'test/run_all_unittests.cc',
         'threading/thread_perftest.cc',
+        'trace_event/malloc_dump_provider_perftest.cc',
+        'trace_event/trace_event_perftest.cc',
         '../testing/perf/perf_test.cc'
       ],
       'conditions': [
@@ -24,6 +24,10 @@ const char kEnableHeapProfiling[]           = "enable-heap-profiling";
 // derived from trace events are reported.
 const char kEnableHeapProfilingModeNative[] = "native";
 
+// Report the native allocation traces of a sample of the allocations, which
+// makes the heap profiler cheap enough to leave enabled.
+const char kEnableHeapProfilingModeSampling[] = "sampling";
+
 // Generates full memory crash dump.
 const char kFullMemoryCrashReport[]         = "full-memory-crash-report";
 
@@ -16,6 +16,7 @@ extern const char kDisableLowEndDeviceMode[];
 extern const char kEnableCrashReporter[];
 extern const char kEnableHeapProfiling[];
 extern const char kEnableHeapProfilingModeNative[];
+extern const char kEnableHeapProfilingModeSampling[];
 extern const char kEnableLowEndDeviceMode[];
 extern const char kForceFieldTrials[];
 extern const char kFullMemoryCrashReport[];
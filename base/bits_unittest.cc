@@ -61,5 +61,15 @@ TEST(BitsTest, Align) {
   EXPECT_EQ(kSizeTMax / 2 + 1, Align(1, kSizeTMax / 2 + 1));
 }
 
+TEST(BitsTest, CountTrailingZeroBits) {
+  EXPECT_EQ(32, CountTrailingZeroBits(0));
+  EXPECT_EQ(0, CountTrailingZeroBits(1));
+  EXPECT_EQ(0, CountTrailingZeroBits(0xffffffffU));
+  for (int i = 1; i < 32; ++i) {
+    EXPECT_EQ(i, CountTrailingZeroBits(1U << i));
+    EXPECT_EQ(i, CountTrailingZeroBits(0xffffffffU << i));
+  }
+}
+
 }  // namespace bits
 }  // namespace base
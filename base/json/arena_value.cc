@@ -0,0 +1,407 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/arena_value.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+
+namespace base {
+
+namespace {
+
+// Alignment of the lists and dictionaries in the arena. Strings are not
+// aligned.
+const size_t kAlignment = 8;
+static_assert(ALIGNOF(ArenaValue) <= kAlignment, "Alignment too small");
+static_assert(ALIGNOF(internal::ArenaDictionaryEntry) <= kAlignment,
+              "Alignment too small");
+
+// Size of the first buffer of small arenas.
+const size_t kMinBufferSize = 4096;
+
+bool EntryKeyLess(const internal::ArenaDictionaryEntry& entry,
+                  StringPiece key) {
+  return entry.key < key;
+}
+
+bool EntriesKeyLess(const internal::ArenaDictionaryEntry& a,
+                    const internal::ArenaDictionaryEntry& b) {
+  return a.key < b.key;
+}
+
+}  // namespace
+
+bool ArenaValue::GetAsBoolean(bool* out_value) const {
+  if (out_value && IsType(Value::TYPE_BOOLEAN))
+    *out_value = boolean_;
+  return IsType(Value::TYPE_BOOLEAN);
+}
+
+bool ArenaValue::GetAsInteger(int* out_value) const {
+  if (out_value && IsType(Value::TYPE_INTEGER))
+    *out_value = integer_;
+  return IsType(Value::TYPE_INTEGER);
+}
+
+bool ArenaValue::GetAsDouble(double* out_value) const {
+  if (out_value && IsType(Value::TYPE_DOUBLE))
+    *out_value = double_;
+  else if (out_value && IsType(Value::TYPE_INTEGER))
+    *out_value = integer_;
+  return IsType(Value::TYPE_DOUBLE) || IsType(Value::TYPE_INTEGER);
+}
+
+bool ArenaValue::GetAsString(std::string* out_value) const {
+  if (out_value && IsType(Value::TYPE_STRING))
+    out_value->assign(string_, size_);
+  return IsType(Value::TYPE_STRING);
+}
+
+bool ArenaValue::GetAsString(StringPiece* out_value) const {
+  if (out_value && IsType(Value::TYPE_STRING))
+    out_value->set(string_, size_);
+  return IsType(Value::TYPE_STRING);
+}
+
+bool ArenaValue::GetAsList(const ArenaListValue** out_value) const {
+  if (out_value && IsType(Value::TYPE_LIST))
+    *out_value = static_cast<const ArenaListValue*>(this);
+  return IsType(Value::TYPE_LIST);
+}
+
+bool ArenaValue::GetAsDictionary(
+    const ArenaDictionaryValue** out_value) const {
+  if (out_value && IsType(Value::TYPE_DICTIONARY))
+    *out_value = static_cast<const ArenaDictionaryValue*>(this);
+  return IsType(Value::TYPE_DICTIONARY);
+}
+
+std::unique_ptr<Value> ArenaValue::CreateDeepCopy() const {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return WrapUnique(new FundamentalValue(boolean_));
+    case Value::TYPE_INTEGER:
+      return WrapUnique(new FundamentalValue(integer_));
+    case Value::TYPE_DOUBLE:
+      return WrapUnique(new FundamentalValue(double_));
+    case Value::TYPE_STRING:
+      return WrapUnique(new StringValue(std::string(string_, size_)));
+    case Value::TYPE_LIST: {
+      std::unique_ptr<ListValue> list(new ListValue);
+      for (uint32_t i = 0; i < size_; ++i)
+        list->Append(items_[i].CreateDeepCopy());
+      return std::move(list);
+    }
+    case Value::TYPE_DICTIONARY: {
+      std::unique_ptr<DictionaryValue> dict(new DictionaryValue);
+      for (uint32_t i = 0; i < size_; ++i) {
+        dict->SetWithoutPathExpansion(entries_[i].key.as_string(),
+                                      entries_[i].value.CreateDeepCopy());
+      }
+      return std::move(dict);
+    }
+    default:
+      NOTREACHED();
+      return nullptr;
+  }
+}
+
+bool ArenaValue::Equals(const Value* other) const {
+  return CreateDeepCopy()->Equals(other);
+}
+
+bool ArenaListValue::Get(size_t index, const ArenaValue** out_value) const {
+  if (index >= size_)
+    return false;
+  if (out_value)
+    *out_value = &items_[index];
+  return true;
+}
+
+bool ArenaListValue::GetBoolean(size_t index, bool* out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsBoolean(out_value);
+}
+
+bool ArenaListValue::GetInteger(size_t index, int* out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsInteger(out_value);
+}
+
+bool ArenaListValue::GetDouble(size_t index, double* out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsDouble(out_value);
+}
+
+bool ArenaListValue::GetString(size_t index, std::string* out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsString(out_value);
+}
+
+bool ArenaListValue::GetString(size_t index, StringPiece* out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsString(out_value);
+}
+
+bool ArenaListValue::GetDictionary(
+    size_t index,
+    const ArenaDictionaryValue** out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsDictionary(out_value);
+}
+
+bool ArenaListValue::GetList(size_t index,
+                             const ArenaListValue** out_value) const {
+  const ArenaValue* value;
+  return Get(index, &value) && value->GetAsList(out_value);
+}
+
+ArenaDictionaryValue::Iterator::Iterator(const ArenaDictionaryValue& target)
+    : current_(target.entries_), end_(target.entries_ + target.size_) {}
+
+void ArenaDictionaryValue::Iterator::Advance() {
+  DCHECK(!IsAtEnd());
+  ++current_;
+}
+
+StringPiece ArenaDictionaryValue::Iterator::key() const {
+  DCHECK(!IsAtEnd());
+  return current_->key;
+}
+
+const ArenaValue& ArenaDictionaryValue::Iterator::value() const {
+  DCHECK(!IsAtEnd());
+  return current_->value;
+}
+
+bool ArenaDictionaryValue::HasKey(StringPiece key) const {
+  return GetWithoutPathExpansion(key, nullptr);
+}
+
+bool ArenaDictionaryValue::Get(StringPiece path,
+                               const ArenaValue** out_value) const {
+  StringPiece current_path(path);
+  const ArenaDictionaryValue* current_dictionary = this;
+  for (size_t delimiter_position = current_path.find('.');
+       delimiter_position != StringPiece::npos;
+       delimiter_position = current_path.find('.')) {
+    const ArenaValue* child = nullptr;
+    if (!current_dictionary->GetWithoutPathExpansion(
+            current_path.substr(0, delimiter_position), &child) ||
+        !child->GetAsDictionary(&current_dictionary)) {
+      return false;
+    }
+    current_path = current_path.substr(delimiter_position + 1);
+  }
+
+  return current_dictionary->GetWithoutPathExpansion(current_path, out_value);
+}
+
+bool ArenaDictionaryValue::GetBoolean(StringPiece path, bool* out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsBoolean(out_value);
+}
+
+bool ArenaDictionaryValue::GetInteger(StringPiece path, int* out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsInteger(out_value);
+}
+
+bool ArenaDictionaryValue::GetDouble(StringPiece path,
+                                     double* out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsDouble(out_value);
+}
+
+bool ArenaDictionaryValue::GetString(StringPiece path,
+                                     std::string* out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsString(out_value);
+}
+
+bool ArenaDictionaryValue::GetString(StringPiece path,
+                                     StringPiece* out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsString(out_value);
+}
+
+bool ArenaDictionaryValue::GetDictionary(
+    StringPiece path,
+    const ArenaDictionaryValue** out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsDictionary(out_value);
+}
+
+bool ArenaDictionaryValue::GetList(StringPiece path,
+                                   const ArenaListValue** out_value) const {
+  const ArenaValue* value;
+  return Get(path, &value) && value->GetAsList(out_value);
+}
+
+bool ArenaDictionaryValue::GetWithoutPathExpansion(
+    StringPiece key,
+    const ArenaValue** out_value) const {
+  const internal::ArenaDictionaryEntry* end = entries_ + size_;
+  const internal::ArenaDictionaryEntry* entry =
+      std::lower_bound(entries_, end, key, &EntryKeyLess);
+  if (entry == end || entry->key != key)
+    return false;
+  if (out_value)
+    *out_value = &entry->value;
+  return true;
+}
+
+ValueArena::ValueArena(size_t initial_buffer_size) : used_(0) {
+  Buffer buffer = {std::unique_ptr<char[]>(new char[initial_buffer_size]),
+                   initial_buffer_size};
+  buffers_.push_back(std::move(buffer));
+}
+
+ValueArena::~ValueArena() {}
+
+size_t ValueArena::MemoryUsageInBytes() const {
+  size_t size = sizeof(*this) + buffers_.capacity() * sizeof(Buffer);
+  for (const Buffer& buffer : buffers_)
+    size += buffer.size;
+  return size;
+}
+
+void* ValueArena::Allocate(size_t size, size_t alignment) {
+  size_t offset = bits::Align(used_, alignment);
+  if (offset > buffers_.back().size || size > buffers_.back().size - offset) {
+    // Doubles the size of the buffers, as cc::ContiguousContainer does. New
+    // buffers are aligned for any type.
+    size_t buffer_size = std::max(2 * buffers_.back().size, size);
+    Buffer buffer = {std::unique_ptr<char[]>(new char[buffer_size]),
+                     buffer_size};
+    buffers_.push_back(std::move(buffer));
+    offset = 0;
+  }
+  used_ = offset + size;
+  return buffers_.back().data.get() + offset;
+}
+
+namespace internal {
+
+ArenaValueBuilder::ArenaValueBuilder(size_t size_hint)
+    : arena_(new ValueArena(std::max(size_hint, kMinBufferSize))) {}
+
+ArenaValueBuilder::~ArenaValueBuilder() {}
+
+ArenaValue ArenaValueBuilder::CreateNull() {
+  return ArenaValue();
+}
+
+ArenaValue ArenaValueBuilder::CreateBoolean(bool value) {
+  ArenaValue result;
+  result.type_ = Value::TYPE_BOOLEAN;
+  result.boolean_ = value;
+  return result;
+}
+
+ArenaValue ArenaValueBuilder::CreateInteger(int value) {
+  ArenaValue result;
+  result.type_ = Value::TYPE_INTEGER;
+  result.integer_ = value;
+  return result;
+}
+
+ArenaValue ArenaValueBuilder::CreateDouble(double value) {
+  ArenaValue result;
+  result.type_ = Value::TYPE_DOUBLE;
+  result.double_ = value;
+  return result;
+}
+
+ArenaValue ArenaValueBuilder::CreateString(StringPiece value) {
+  ArenaValue result;
+  result.type_ = Value::TYPE_STRING;
+  result.size_ = static_cast<uint32_t>(value.size());
+  result.string_ = static_cast<const char*>(Copy(value.data(), value.size()));
+  return result;
+}
+
+size_t ArenaValueBuilder::BeginContainer() {
+  return stack_.size();
+}
+
+void ArenaValueBuilder::Append(const ArenaValue& value) {
+  stack_.push_back({StringPiece(), value});
+}
+
+void ArenaValueBuilder::Set(StringPiece key, const ArenaValue& value) {
+  StringPiece arena_key(static_cast<const char*>(Copy(key.data(), key.size())),
+                        key.size());
+  stack_.push_back({arena_key, value});
+}
+
+ArenaValue ArenaValueBuilder::EndList(size_t mark) {
+  DCHECK_LE(mark, stack_.size());
+  ArenaValue result;
+  result.type_ = Value::TYPE_LIST;
+  result.size_ = static_cast<uint32_t>(stack_.size() - mark);
+  ArenaValue* items = static_cast<ArenaValue*>(
+      arena_->Allocate(result.size_ * sizeof(ArenaValue), kAlignment));
+  for (uint32_t i = 0; i < result.size_; ++i)
+    new (&items[i]) ArenaValue(stack_[mark + i].value);
+  result.items_ = items;
+  stack_.erase(stack_.begin() + mark, stack_.end());
+  return result;
+}
+
+ArenaValue ArenaValueBuilder::EndDictionary(size_t mark) {
+  DCHECK_LE(mark, stack_.size());
+  auto begin = stack_.begin() + mark;
+  std::stable_sort(begin, stack_.end(), &EntriesKeyLess);
+
+  // Drops all but the last of the entries with the same key.
+  auto last = begin;
+  for (auto it = begin; it != stack_.end(); ++it) {
+    if (it + 1 != stack_.end() && (it + 1)->key == it->key)
+      continue;
+    *last++ = *it;
+  }
+  stack_.erase(last, stack_.end());
+
+  ArenaValue result;
+  result.type_ = Value::TYPE_DICTIONARY;
+  result.size_ = static_cast<uint32_t>(stack_.size() - mark);
+  ArenaDictionaryEntry* entries = static_cast<ArenaDictionaryEntry*>(
+      arena_->Allocate(result.size_ * sizeof(ArenaDictionaryEntry),
+                       kAlignment));
+  for (uint32_t i = 0; i < result.size_; ++i)
+    new (&entries[i]) ArenaDictionaryEntry(stack_[mark + i]);
+  result.entries_ = entries;
+  stack_.erase(stack_.begin() + mark, stack_.end());
+  return result;
+}
+
+std::unique_ptr<ValueArena> ArenaValueBuilder::Finish(const ArenaValue& root) {
+  DCHECK(stack_.empty());
+  arena_->root_ = root;
+  return std::move(arena_);
+}
+
+const void* ArenaValueBuilder::Copy(const void* data, size_t size) {
+  if (!size)
+    return "";
+  void* copy = arena_->Allocate(size, 1);
+  memcpy(copy, data, size);
+  return copy;
+}
+
+}  // namespace internal
+
+}  // namespace base
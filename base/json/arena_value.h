@@ -0,0 +1,254 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ArenaValue is a read-only counterpart of base::Value for bulk parsing. Where
+// JSONReader::Read() allocates every Value, list item and dictionary key on
+// its own, JSONReader::ReadToArena() places the whole tree, strings included,
+// in a few large buffers owned by a ValueArena, which frees them in one shot.
+// Like cc::ContiguousContainer, the arena grows by adding buffers rather than
+// by reallocating, so values never move once created.
+//
+// The read accessors mirror those of Value, ListValue and DictionaryValue.
+// Trees that need to be modified or kept piecemeal can be converted to regular
+// Values with CreateDeepCopy().
+
+#ifndef BASE_JSON_ARENA_VALUE_H_
+#define BASE_JSON_ARENA_VALUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+class ArenaDictionaryValue;
+class ArenaListValue;
+
+namespace internal {
+class ArenaValueBuilder;
+struct ArenaDictionaryEntry;
+}
+
+class BASE_EXPORT ArenaValue {
+ public:
+  // Creates a null value.
+  ArenaValue() : type_(Value::TYPE_NULL), size_(0), pointer_(nullptr) {}
+
+  Value::Type GetType() const { return type_; }
+  bool IsType(Value::Type type) const { return type == type_; }
+
+  // These return true and set |out_value| if the value is of the matching
+  // type. As for Value, GetAsDouble() also converts integers. |out_value| may
+  // be null.
+  bool GetAsBoolean(bool* out_value) const;
+  bool GetAsInteger(int* out_value) const;
+  bool GetAsDouble(double* out_value) const;
+  bool GetAsString(std::string* out_value) const;
+  // |out_value| points into the arena.
+  bool GetAsString(StringPiece* out_value) const;
+  bool GetAsList(const ArenaListValue** out_value) const;
+  bool GetAsDictionary(const ArenaDictionaryValue** out_value) const;
+
+  // Returns a regular Value with the same contents.
+  std::unique_ptr<Value> CreateDeepCopy() const;
+
+  // Returns true if |other| is a regular Value with the same contents.
+  bool Equals(const Value* other) const;
+
+ protected:
+  friend class internal::ArenaValueBuilder;
+
+  Value::Type type_;
+
+  // Number of characters of a string, items of a list or entries of a
+  // dictionary.
+  uint32_t size_;
+
+  union {
+    bool boolean_;
+    int integer_;
+    double double_;
+    const char* string_;
+    const ArenaValue* items_;
+    const internal::ArenaDictionaryEntry* entries_;
+    const void* pointer_;
+  };
+};
+
+class BASE_EXPORT ArenaListValue : public ArenaValue {
+ public:
+  using const_iterator = const ArenaValue*;
+
+  size_t GetSize() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const { return items_; }
+  const_iterator end() const { return items_ + size_; }
+
+  // These return true and set |out_value| if |index| is in the list and
+  // holds a value of the matching type.
+  bool Get(size_t index, const ArenaValue** out_value) const;
+  bool GetBoolean(size_t index, bool* out_value) const;
+  bool GetInteger(size_t index, int* out_value) const;
+  bool GetDouble(size_t index, double* out_value) const;
+  bool GetString(size_t index, std::string* out_value) const;
+  bool GetString(size_t index, StringPiece* out_value) const;
+  bool GetDictionary(size_t index,
+                     const ArenaDictionaryValue** out_value) const;
+  bool GetList(size_t index, const ArenaListValue** out_value) const;
+
+ private:
+  ArenaListValue() = delete;
+};
+
+class BASE_EXPORT ArenaDictionaryValue : public ArenaValue {
+ public:
+  // Iterates over the entries in key order, like DictionaryValue::Iterator.
+  class BASE_EXPORT Iterator {
+   public:
+    explicit Iterator(const ArenaDictionaryValue& target);
+
+    bool IsAtEnd() const { return current_ == end_; }
+    void Advance();
+
+    StringPiece key() const;
+    const ArenaValue& value() const;
+
+   private:
+    const internal::ArenaDictionaryEntry* current_;
+    const internal::ArenaDictionaryEntry* const end_;
+  };
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool HasKey(StringPiece key) const;
+
+  // Like DictionaryValue::Get(), |path| is a list of keys separated by '.'.
+  // These return true and set |out_value| if there is a value of the
+  // matching type at |path|.
+  bool Get(StringPiece path, const ArenaValue** out_value) const;
+  bool GetBoolean(StringPiece path, bool* out_value) const;
+  bool GetInteger(StringPiece path, int* out_value) const;
+  bool GetDouble(StringPiece path, double* out_value) const;
+  bool GetString(StringPiece path, std::string* out_value) const;
+  bool GetString(StringPiece path, StringPiece* out_value) const;
+  bool GetDictionary(StringPiece path,
+                     const ArenaDictionaryValue** out_value) const;
+  bool GetList(StringPiece path, const ArenaListValue** out_value) const;
+
+  // Same as Get(), but without path expansion: |key| can contain '.'.
+  bool GetWithoutPathExpansion(StringPiece key,
+                               const ArenaValue** out_value) const;
+
+ private:
+  ArenaDictionaryValue() = delete;
+};
+
+namespace internal {
+
+// Dictionaries are arrays of entries sorted by key, looked up with a binary
+// search.
+struct ArenaDictionaryEntry {
+  StringPiece key;
+  ArenaValue value;
+};
+
+}  // namespace internal
+
+// Owns a tree of ArenaValues and the memory they are in.
+class BASE_EXPORT ValueArena {
+ public:
+  ~ValueArena();
+
+  const ArenaValue& root() const { return root_; }
+
+  // Returns the number of bytes allocated by the arena.
+  size_t MemoryUsageInBytes() const;
+
+ private:
+  friend class internal::ArenaValueBuilder;
+
+  explicit ValueArena(size_t initial_buffer_size);
+
+  // Returns |size| bytes aligned on |alignment|, in the last buffer if it has
+  // room, else in a new one.
+  void* Allocate(size_t size, size_t alignment);
+
+  struct Buffer {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  std::vector<Buffer> buffers_;
+
+  // Position of the next allocation in the last buffer.
+  size_t used_;
+
+  ArenaValue root_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueArena);
+};
+
+namespace internal {
+
+// Builds a ValueArena bottom-up, in the order JSONParser reads the values:
+// scalars are created directly, and lists and dictionaries from the values
+// added since they were begun, which are kept on a stack until then.
+class BASE_EXPORT ArenaValueBuilder {
+ public:
+  // |size_hint| is the size of the input, from which the size of the first
+  // buffer of the arena is chosen.
+  explicit ArenaValueBuilder(size_t size_hint);
+  ~ArenaValueBuilder();
+
+  ArenaValue CreateNull();
+  ArenaValue CreateBoolean(bool value);
+  ArenaValue CreateInteger(int value);
+  ArenaValue CreateDouble(double value);
+  // Copies |value| into the arena.
+  ArenaValue CreateString(StringPiece value);
+
+  // Begins a list or a dictionary, returning the mark to pass to EndList() or
+  // EndDictionary() once all its values are added.
+  size_t BeginContainer();
+
+  // Adds a value to the innermost container being built.
+  void Append(const ArenaValue& value);
+  void Set(StringPiece key, const ArenaValue& value);
+
+  // Finishes the container begun at |mark|. As with
+  // DictionaryValue::SetWithoutPathExpansion(), the last value set for a key
+  // wins.
+  ArenaValue EndList(size_t mark);
+  ArenaValue EndDictionary(size_t mark);
+
+  // Returns the arena, with |root| as its root.
+  std::unique_ptr<ValueArena> Finish(const ArenaValue& root);
+
+ private:
+  // Copies |size| bytes of |data| into the arena.
+  const void* Copy(const void* data, size_t size);
+
+  std::unique_ptr<ValueArena> arena_;
+
+  // Values of the containers being built. Keys are empty in lists.
+  std::vector<ArenaDictionaryEntry> stack_;
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaValueBuilder);
+};
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_JSON_ARENA_VALUE_H_
@@ -0,0 +1,182 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/arena_value.h"
+
+#include <memory>
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+std::unique_ptr<ValueArena> ReadToArena(StringPiece json) {
+  JSONReader reader(JSON_ALLOW_TRAILING_COMMAS);
+  return reader.ReadToArena(json);
+}
+
+}  // namespace
+
+TEST(ArenaValueTest, Scalars) {
+  std::unique_ptr<ValueArena> arena =
+      ReadToArena("[null, true, 42, 4.5, \"s\"]");
+  ASSERT_TRUE(arena);
+  const ArenaListValue* list = nullptr;
+  ASSERT_TRUE(arena->root().GetAsList(&list));
+  ASSERT_EQ(5u, list->GetSize());
+
+  const ArenaValue* value = nullptr;
+  ASSERT_TRUE(list->Get(0, &value));
+  EXPECT_TRUE(value->IsType(Value::TYPE_NULL));
+  EXPECT_FALSE(value->GetAsBoolean(nullptr));
+
+  bool bool_value = false;
+  EXPECT_TRUE(list->GetBoolean(1, &bool_value));
+  EXPECT_TRUE(bool_value);
+
+  int int_value = 0;
+  double double_value = 0;
+  EXPECT_TRUE(list->GetInteger(2, &int_value));
+  EXPECT_EQ(42, int_value);
+  // Integers convert to doubles, but not the other way around.
+  EXPECT_TRUE(list->GetDouble(2, &double_value));
+  EXPECT_EQ(42, double_value);
+  EXPECT_TRUE(list->GetDouble(3, &double_value));
+  EXPECT_EQ(4.5, double_value);
+  EXPECT_FALSE(list->GetInteger(3, &int_value));
+
+  std::string string_value;
+  StringPiece string_piece;
+  EXPECT_TRUE(list->GetString(4, &string_value));
+  EXPECT_EQ("s", string_value);
+  EXPECT_TRUE(list->GetString(4, &string_piece));
+  EXPECT_EQ("s", string_piece);
+  EXPECT_FALSE(list->GetString(2, &string_value));
+
+  EXPECT_FALSE(list->Get(5, &value));
+  EXPECT_FALSE(list->GetBoolean(5, &bool_value));
+}
+
+TEST(ArenaValueTest, Dictionary) {
+  std::unique_ptr<ValueArena> arena = ReadToArena(
+      "{\"b\": {\"c\": [1, {\"d\": \"e\"}]}, \"a.b\": 1, \"a\": 2, \"a\": 3,}");
+  ASSERT_TRUE(arena);
+  const ArenaDictionaryValue* dict = nullptr;
+  ASSERT_TRUE(arena->root().GetAsDictionary(&dict));
+
+  // The last value of a key wins, as with DictionaryValue.
+  EXPECT_EQ(3u, dict->size());
+  int int_value = 0;
+  EXPECT_TRUE(dict->GetInteger("a", &int_value));
+  EXPECT_EQ(3, int_value);
+
+  // Paths are expanded unless asked not to.
+  EXPECT_FALSE(dict->GetInteger("a.b", &int_value));
+  const ArenaValue* value = nullptr;
+  ASSERT_TRUE(dict->GetWithoutPathExpansion("a.b", &value));
+  EXPECT_TRUE(value->GetAsInteger(&int_value));
+  EXPECT_EQ(1, int_value);
+
+  const ArenaListValue* list = nullptr;
+  ASSERT_TRUE(dict->GetList("b.c", &list));
+  const ArenaDictionaryValue* inner = nullptr;
+  ASSERT_TRUE(list->GetDictionary(1, &inner));
+  StringPiece string_value;
+  EXPECT_TRUE(inner->GetString("d", &string_value));
+  EXPECT_EQ("e", string_value);
+  EXPECT_FALSE(dict->Get("b.c.d", &value));
+  EXPECT_FALSE(dict->Get("b.x", &value));
+
+  EXPECT_TRUE(dict->HasKey("b"));
+  EXPECT_FALSE(dict->HasKey("c"));
+
+  // Entries are iterated in key order.
+  ArenaDictionaryValue::Iterator it(*dict);
+  ASSERT_FALSE(it.IsAtEnd());
+  EXPECT_EQ("a", it.key());
+  it.Advance();
+  ASSERT_FALSE(it.IsAtEnd());
+  EXPECT_EQ("a.b", it.key());
+  it.Advance();
+  ASSERT_FALSE(it.IsAtEnd());
+  EXPECT_EQ("b", it.key());
+  EXPECT_TRUE(it.value().IsType(Value::TYPE_DICTIONARY));
+  it.Advance();
+  EXPECT_TRUE(it.IsAtEnd());
+}
+
+TEST(ArenaValueTest, MatchesRead) {
+  const char kJSON[] =
+      "{\"list\": [1, -2.5e3, true, false, null, [], {}, [[[\"deep\"]]]],"
+      " \"escapes\": \"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\ud83d\\ude00\","
+      " \"utf8\": \"D\xC3\xA9j\xC3\xA0 vu\", \"\": \"\", \"z\": {\"y\": 0}}";
+  std::unique_ptr<Value> value = JSONReader::Read(kJSON);
+  ASSERT_TRUE(value);
+  std::unique_ptr<ValueArena> arena = ReadToArena(kJSON);
+  ASSERT_TRUE(arena);
+  EXPECT_TRUE(arena->root().Equals(value.get()));
+
+  // The arena holds copies of all the strings.
+  std::string json(kJSON);
+  arena = ReadToArena(json);
+  json.assign(json.size(), ' ');
+  ASSERT_TRUE(arena);
+  EXPECT_TRUE(arena->root().Equals(value.get()));
+}
+
+TEST(ArenaValueTest, Errors) {
+  const char* const kInvalid[] = {
+      "", "[1,", "{\"a\" 1}", "[1] 2", "\"\\q\"", "{1: 2}", "[\"\xFF\"]",
+  };
+  for (const char* json : kInvalid) {
+    SCOPED_TRACE(json);
+    JSONReader reader;
+    EXPECT_FALSE(reader.ReadToArena(json));
+    JSONReader::JsonParseError error_code = reader.error_code();
+    std::string error_message = reader.GetErrorMessage();
+    EXPECT_NE(JSONReader::JSON_NO_ERROR, error_code);
+    EXPECT_FALSE(reader.ReadToValue(json));
+    EXPECT_EQ(error_code, reader.error_code());
+    EXPECT_EQ(error_message, reader.GetErrorMessage());
+  }
+}
+
+TEST(ArenaValueTest, LargeDocument) {
+  // Needs more than the first buffer of the arena.
+  std::string json = "[";
+  for (int i = 0; i < 10000; ++i)
+    json += StringPrintf("{\"key%d\": [%d, \"value%d\"]},", i, i, i);
+  json.back() = ']';
+
+  std::unique_ptr<ValueArena> arena = ReadToArena(json);
+  ASSERT_TRUE(arena);
+  EXPECT_GT(arena->MemoryUsageInBytes(), json.size());
+  const ArenaListValue* list = nullptr;
+  ASSERT_TRUE(arena->root().GetAsList(&list));
+  ASSERT_EQ(10000u, list->GetSize());
+  int i = 0;
+  for (const ArenaValue& item : *list) {
+    const ArenaDictionaryValue* dict = nullptr;
+    ASSERT_TRUE(item.GetAsDictionary(&dict));
+    const ArenaListValue* pair = nullptr;
+    ASSERT_TRUE(dict->GetList(StringPrintf("key%d", i), &pair));
+    int int_value = 0;
+    std::string string_value;
+    EXPECT_TRUE(pair->GetInteger(0, &int_value));
+    EXPECT_EQ(i, int_value);
+    EXPECT_TRUE(pair->GetString(1, &string_value));
+    EXPECT_EQ(StringPrintf("value%d", i), string_value);
+    ++i;
+  }
+
+  EXPECT_TRUE(arena->root().Equals(JSONReader::Read(json).get()));
+}
+
+}  // namespace base
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <utility>
 
+#include "base/json/arena_value.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
@@ -18,6 +19,15 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/third_party/icu/icu_utf.h"
 #include "base/values.h"
+#include "build/build_config.h"
+
+// SSE2 is part of the x86-64 baseline, and x86 builds require it.
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#if defined(COMPILER_MSVC)
+#include <intrin.h>
+#endif
+#endif
 
 namespace base {
 namespace internal {
@@ -167,6 +177,69 @@ class JSONStringValue : public Value {
   DISALLOW_COPY_AND_ASSIGN(JSONStringValue);
 };
 
+#if defined(ARCH_CPU_X86_FAMILY)
+// Returns the index of the lowest set bit of |mask|, which must not be 0.
+inline size_t LowestSetBit(uint32_t mask) {
+#if defined(COMPILER_MSVC)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Returns the number of bytes at the start of [|begin|, |end|) that are ASCII
+// characters ConsumeStringRaw() takes as is, i.e. anything but '"', '\\' and
+// the bytes of multi-byte UTF-8 sequences.
+size_t CountPlainStringBytes(const char* begin, const char* end) {
+  const char* pos = begin;
+#if defined(ARCH_CPU_X86_FAMILY)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; end - pos >= 16; pos += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    // The top bit of each byte of |special| is set for non-ASCII bytes and for
+    // matches of either comparison.
+    __m128i special =
+        _mm_or_si128(bytes, _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                                         _mm_cmpeq_epi8(bytes, backslash)));
+    uint32_t mask = _mm_movemask_epi8(special);
+    if (mask)
+      return pos - begin + LowestSetBit(mask);
+  }
+#endif
+  for (; pos < end; ++pos) {
+    unsigned char c = *pos;
+    if (c >= kExtendedASCIIStart || c == '"' || c == '\\')
+      break;
+  }
+  return pos - begin;
+}
+
+// Returns the number of spaces and tabs at the start of [|begin|, |end|).
+size_t CountBlankBytes(const char* begin, const char* end) {
+  const char* pos = begin;
+#if defined(ARCH_CPU_X86_FAMILY)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  for (; end - pos >= 16; pos += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+                                 _mm_cmpeq_epi8(bytes, tab));
+    uint32_t mask = _mm_movemask_epi8(blank) ^ 0xFFFF;
+    if (mask)
+      return pos - begin + LowestSetBit(mask);
+  }
+#endif
+  for (; pos < end; ++pos) {
+    if (*pos != ' ' && *pos != '\t')
+      break;
+  }
+  return pos - begin;
+}
+
 // Simple class that checks for maximum recursion/"stack overflow."
 class StackMarker {
  public:
@@ -190,6 +263,105 @@ class StackMarker {
 
 }  // namespace
 
+// HeapBuilder /////////////////////////////////////////////////////////////////
+
+// Creates the Values returned by Parse().
+class JSONParser::HeapBuilder {
+ public:
+  using ValueType = std::unique_ptr<Value>;
+  using ListType = std::unique_ptr<ListValue>;
+  using DictionaryType = std::unique_ptr<DictionaryValue>;
+
+  explicit HeapBuilder(int options) : options_(options) {}
+
+  ValueType CreateNull() { return Value::CreateNullValue(); }
+  ValueType CreateBoolean(bool value) {
+    return WrapUnique(new FundamentalValue(value));
+  }
+  ValueType CreateInteger(int value) {
+    return WrapUnique(new FundamentalValue(value));
+  }
+  ValueType CreateDouble(double value) {
+    return WrapUnique(new FundamentalValue(value));
+  }
+  ValueType CreateString(StringBuilder* string) {
+    // Create the Value representation, using a hidden root, if configured
+    // to do so, and if the string can be represented by StringPiece.
+    if (string->CanBeStringPiece() && !(options_ & JSON_DETACHABLE_CHILDREN))
+      return WrapUnique(new JSONStringValue(string->AsStringPiece()));
+    return WrapUnique(new StringValue(string->AsString()));
+  }
+
+  ListType BeginList() { return WrapUnique(new ListValue); }
+  void Append(ListType* list, ValueType value) {
+    (*list)->Append(std::move(value));
+  }
+  ValueType EndList(ListType list) { return std::move(list); }
+
+  DictionaryType BeginDictionary() { return WrapUnique(new DictionaryValue); }
+  void Set(DictionaryType* dict, StringBuilder* key, ValueType value) {
+    (*dict)->SetWithoutPathExpansion(key->AsString(), std::move(value));
+  }
+  ValueType EndDictionary(DictionaryType dict) { return std::move(dict); }
+
+ private:
+  const int options_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapBuilder);
+};
+
+// ArenaBuilder ////////////////////////////////////////////////////////////////
+
+// Creates the ArenaValues of ParseToArena(). Lists and dictionaries are
+// represented by their mark in the ArenaValueBuilder while being built.
+class JSONParser::ArenaBuilder {
+ public:
+  using ValueType = ArenaValue;
+  using ListType = size_t;
+  using DictionaryType = size_t;
+
+  explicit ArenaBuilder(size_t size_hint) : builder_(size_hint) {}
+
+  ValueType CreateNull() { return builder_.CreateNull(); }
+  ValueType CreateBoolean(bool value) { return builder_.CreateBoolean(value); }
+  ValueType CreateInteger(int value) { return builder_.CreateInteger(value); }
+  ValueType CreateDouble(double value) { return builder_.CreateDouble(value); }
+  ValueType CreateString(StringBuilder* string) {
+    return builder_.CreateString(AsStringPiece(string));
+  }
+
+  ListType BeginList() { return builder_.BeginContainer(); }
+  void Append(ListType* list, const ValueType& value) {
+    builder_.Append(value);
+  }
+  ValueType EndList(ListType list) { return builder_.EndList(list); }
+
+  DictionaryType BeginDictionary() { return builder_.BeginContainer(); }
+  void Set(DictionaryType* dict, StringBuilder* key, const ValueType& value) {
+    builder_.Set(AsStringPiece(key), value);
+  }
+  ValueType EndDictionary(DictionaryType dict) {
+    return builder_.EndDictionary(dict);
+  }
+
+  std::unique_ptr<ValueArena> Finish(const ArenaValue& root) {
+    return builder_.Finish(root);
+  }
+
+ private:
+  // The strings are copied into the arena either way, so there is no need to
+  // Convert() them.
+  static StringPiece AsStringPiece(StringBuilder* string) {
+    if (string->CanBeStringPiece())
+      return string->AsStringPiece();
+    return string->AsString();
+  }
+
+  ArenaValueBuilder builder_;
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaBuilder);
+};
+
 JSONParser::JSONParser(int options)
     : options_(options),
       start_pos_(NULL),
@@ -218,39 +390,13 @@ std::unique_ptr<Value> JSONParser::Parse(StringPiece input) {
   } else {
     start_pos_ = input.data();
   }
-  pos_ = start_pos_;
   end_pos_ = start_pos_ + input.length();
-  index_ = 0;
-  line_number_ = 1;
-  index_last_line_ = 0;
-
-  error_code_ = JSONReader::JSON_NO_ERROR;
-  error_line_ = 0;
-  error_column_ = 0;
-
-  // When the input JSON string starts with a UTF-8 Byte-Order-Mark
-  // <0xEF 0xBB 0xBF>, advance the start position to avoid the
-  // ParseNextToken function mis-treating a Unicode BOM as an invalid
-  // character and returning NULL.
-  if (CanConsume(3) && static_cast<uint8_t>(*pos_) == 0xEF &&
-      static_cast<uint8_t>(*(pos_ + 1)) == 0xBB &&
-      static_cast<uint8_t>(*(pos_ + 2)) == 0xBF) {
-    NextNChars(3);
-  }
 
-  // Parse the first and any nested tokens.
-  std::unique_ptr<Value> root(ParseNextToken());
-  if (!root)
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> root;
+  if (!ParseInput(&builder, &root))
     return nullptr;
 
-  // Make sure the input stream is at an end.
-  if (GetNextToken() != T_END_OF_INPUT) {
-    if (!CanConsume(1) || (NextChar() && GetNextToken() != T_END_OF_INPUT)) {
-      ReportError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, 1);
-      return nullptr;
-    }
-  }
-
   // Dictionaries and lists can contain JSONStringValues, so wrap them in a
   // hidden root.
   if (!(options_ & JSON_DETACHABLE_CHILDREN)) {
@@ -272,6 +418,18 @@ std::unique_ptr<Value> JSONParser::Parse(StringPiece input) {
   return root;
 }
 
+std::unique_ptr<ValueArena> JSONParser::ParseToArena(StringPiece input) {
+  // Strings are copied into the arena, so the input need not outlive it.
+  start_pos_ = input.data();
+  end_pos_ = start_pos_ + input.length();
+
+  ArenaBuilder builder(input.length());
+  ArenaValue root;
+  if (!ParseInput(&builder, &root))
+    return nullptr;
+  return builder.Finish(root);
+}
+
 JSONReader::JsonParseError JSONParser::error_code() const {
   return error_code_;
 }
@@ -328,6 +486,15 @@ void JSONParser::StringBuilder::AppendString(const std::string& str) {
   string_->append(str);
 }
 
+void JSONParser::StringBuilder::AppendRun(const char* str, size_t length) {
+  if (string_) {
+    string_->append(str, length);
+  } else {
+    DCHECK_EQ(pos_ + length_, str);
+    length_ += length;
+  }
+}
+
 void JSONParser::StringBuilder::Convert() {
   if (string_)
     return;
@@ -421,10 +588,11 @@ void JSONParser::EatWhitespaceAndComments() {
         // Don't increment line_number_ twice for "\r\n".
         if (!(*pos_ == '\n' && pos_ > start_pos_ && *(pos_ - 1) == '\r'))
           ++line_number_;
-        // Fall through.
+        NextChar();
+        break;
       case ' ':
       case '\t':
-        NextChar();
+        NextNChars(static_cast<int>(CountBlankBytes(pos_, end_pos_)));
         break;
       case '/':
         if (!EatComment())
@@ -469,56 +637,100 @@ bool JSONParser::EatComment() {
   return false;
 }
 
-Value* JSONParser::ParseNextToken() {
-  return ParseToken(GetNextToken());
+template <typename Builder>
+bool JSONParser::ParseInput(Builder* builder,
+                            typename Builder::ValueType* root) {
+  pos_ = start_pos_;
+  index_ = 0;
+  line_number_ = 1;
+  index_last_line_ = 0;
+
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+
+  // When the input JSON string starts with a UTF-8 Byte-Order-Mark
+  // <0xEF 0xBB 0xBF>, advance the start position to avoid the
+  // ParseNextToken function mis-treating a Unicode BOM as an invalid
+  // character and returning NULL.
+  if (CanConsume(3) && static_cast<uint8_t>(*pos_) == 0xEF &&
+      static_cast<uint8_t>(*(pos_ + 1)) == 0xBB &&
+      static_cast<uint8_t>(*(pos_ + 2)) == 0xBF) {
+    NextNChars(3);
+  }
+
+  // Parse the first and any nested tokens.
+  if (!ParseNextToken(builder, root))
+    return false;
+
+  // Make sure the input stream is at an end.
+  if (GetNextToken() != T_END_OF_INPUT) {
+    if (!CanConsume(1) || (NextChar() && GetNextToken() != T_END_OF_INPUT)) {
+      ReportError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, 1);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template <typename Builder>
+bool JSONParser::ParseNextToken(Builder* builder,
+                                typename Builder::ValueType* out) {
+  return ParseToken(GetNextToken(), builder, out);
 }
 
-Value* JSONParser::ParseToken(Token token) {
+template <typename Builder>
+bool JSONParser::ParseToken(Token token,
+                            Builder* builder,
+                            typename Builder::ValueType* out) {
   switch (token) {
     case T_OBJECT_BEGIN:
-      return ConsumeDictionary();
+      return ConsumeDictionary(builder, out);
     case T_ARRAY_BEGIN:
-      return ConsumeList();
+      return ConsumeList(builder, out);
     case T_STRING:
-      return ConsumeString();
+      return ConsumeString(builder, out);
     case T_NUMBER:
-      return ConsumeNumber();
+      return ConsumeNumber(builder, out);
     case T_BOOL_TRUE:
     case T_BOOL_FALSE:
     case T_NULL:
-      return ConsumeLiteral();
+      return ConsumeLiteral(builder, out);
     default:
       ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
-      return NULL;
+      return false;
   }
 }
 
-Value* JSONParser::ConsumeDictionary() {
+template <typename Builder>
+bool JSONParser::ConsumeDictionary(Builder* builder,
+                                   typename Builder::ValueType* out) {
   if (*pos_ != '{') {
     ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
-    return NULL;
+    return false;
   }
 
   StackMarker depth_check(&stack_depth_);
   if (depth_check.IsTooDeep()) {
     ReportError(JSONReader::JSON_TOO_MUCH_NESTING, 1);
-    return NULL;
+    return false;
   }
 
-  std::unique_ptr<DictionaryValue> dict(new DictionaryValue);
+  typename Builder::DictionaryType dict = builder->BeginDictionary();
 
   NextChar();
   Token token = GetNextToken();
   while (token != T_OBJECT_END) {
     if (token != T_STRING) {
       ReportError(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, 1);
-      return NULL;
+      return false;
     }
 
     // First consume the key.
     StringBuilder key;
     if (!ConsumeStringRaw(&key)) {
-      return NULL;
+      return false;
     }
 
     // Read the separator.
@@ -526,18 +738,18 @@ Value* JSONParser::ConsumeDictionary() {
     token = GetNextToken();
     if (token != T_OBJECT_PAIR_SEPARATOR) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
     }
 
     // The next token is the value. Ownership transfers to |dict|.
     NextChar();
-    Value* value = ParseNextToken();
-    if (!value) {
+    typename Builder::ValueType value;
+    if (!ParseNextToken(builder, &value)) {
       // ReportError from deeper level.
-      return NULL;
+      return false;
     }
 
-    dict->SetWithoutPathExpansion(key.AsString(), value);
+    builder->Set(&dict, &key, std::move(value));
 
     NextChar();
     token = GetNextToken();
@@ -546,41 +758,44 @@ Value* JSONParser::ConsumeDictionary() {
       token = GetNextToken();
       if (token == T_OBJECT_END && !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
         ReportError(JSONReader::JSON_TRAILING_COMMA, 1);
-        return NULL;
+        return false;
       }
     } else if (token != T_OBJECT_END) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 0);
-      return NULL;
+      return false;
     }
   }
 
-  return dict.release();
+  *out = builder->EndDictionary(std::move(dict));
+  return true;
 }
 
-Value* JSONParser::ConsumeList() {
+template <typename Builder>
+bool JSONParser::ConsumeList(Builder* builder,
+                             typename Builder::ValueType* out) {
   if (*pos_ != '[') {
     ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
-    return NULL;
+    return false;
   }
 
   StackMarker depth_check(&stack_depth_);
   if (depth_check.IsTooDeep()) {
     ReportError(JSONReader::JSON_TOO_MUCH_NESTING, 1);
-    return NULL;
+    return false;
   }
 
-  std::unique_ptr<ListValue> list(new ListValue);
+  typename Builder::ListType list = builder->BeginList();
 
   NextChar();
   Token token = GetNextToken();
   while (token != T_ARRAY_END) {
-    Value* item = ParseToken(token);
-    if (!item) {
+    typename Builder::ValueType item;
+    if (!ParseToken(token, builder, &item)) {
       // ReportError from deeper level.
-      return NULL;
+      return false;
     }
 
-    list->Append(item);
+    builder->Append(&list, std::move(item));
 
     NextChar();
     token = GetNextToken();
@@ -589,31 +804,27 @@ Value* JSONParser::ConsumeList() {
       token = GetNextToken();
       if (token == T_ARRAY_END && !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
         ReportError(JSONReader::JSON_TRAILING_COMMA, 1);
-        return NULL;
+        return false;
       }
     } else if (token != T_ARRAY_END) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
     }
   }
 
-  return list.release();
+  *out = builder->EndList(std::move(list));
+  return true;
 }
 
-Value* JSONParser::ConsumeString() {
+template <typename Builder>
+bool JSONParser::ConsumeString(Builder* builder,
+                               typename Builder::ValueType* out) {
   StringBuilder string;
   if (!ConsumeStringRaw(&string))
-    return NULL;
+    return false;
 
-  // Create the Value representation, using a hidden root, if configured
-  // to do so, and if the string can be represented by StringPiece.
-  if (string.CanBeStringPiece() && !(options_ & JSON_DETACHABLE_CHILDREN)) {
-    return new JSONStringValue(string.AsStringPiece());
-  } else {
-    if (string.CanBeStringPiece())
-      string.Convert();
-    return new StringValue(string.AsString());
-  }
+  *out = builder->CreateString(&string);
+  return true;
 }
 
 bool JSONParser::ConsumeStringRaw(StringBuilder* out) {
@@ -631,6 +842,14 @@ bool JSONParser::ConsumeStringRaw(StringBuilder* out) {
   int32_t next_char = 0;
 
   while (CanConsume(1)) {
+    // Take the characters that need no decoding in bulk. This leaves the
+    // parser in the same state as going through them one at a time below.
+    size_t run = CountPlainStringBytes(start_pos_ + index_, end_pos_);
+    if (run) {
+      string.AppendRun(start_pos_ + index_, run);
+      index_ += static_cast<int>(run);
+    }
+
     pos_ = start_pos_ + index_;  // CBU8_NEXT is postcrement.
     CBU8_NEXT(start_pos_, index_, length, next_char);
     if (next_char < 0 || !IsValidCharacter(next_char)) {
@@ -827,7 +1046,9 @@ void JSONParser::DecodeUTF8(const int32_t& point, StringBuilder* dest) {
   }
 }
 
-Value* JSONParser::ConsumeNumber() {
+template <typename Builder>
+bool JSONParser::ConsumeNumber(Builder* builder,
+                               typename Builder::ValueType* out) {
   const char* num_start = pos_;
   const int start_index = index_;
   int end_index = start_index;
@@ -837,7 +1058,7 @@ Value* JSONParser::ConsumeNumber() {
 
   if (!ReadInt(false)) {
     ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-    return NULL;
+    return false;
   }
   end_index = index_;
 
@@ -845,12 +1066,12 @@ Value* JSONParser::ConsumeNumber() {
   if (*pos_ == '.') {
     if (!CanConsume(1)) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
     }
     NextChar();
     if (!ReadInt(true)) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
     }
     end_index = index_;
   }
@@ -862,7 +1083,7 @@ Value* JSONParser::ConsumeNumber() {
       NextChar();
     if (!ReadInt(true)) {
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
     }
     end_index = index_;
   }
@@ -882,7 +1103,7 @@ Value* JSONParser::ConsumeNumber() {
       break;
     default:
       ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-      return NULL;
+      return false;
   }
 
   pos_ = exit_pos;
@@ -891,16 +1112,19 @@ Value* JSONParser::ConsumeNumber() {
   StringPiece num_string(num_start, end_index - start_index);
 
   int num_int;
-  if (StringToInt(num_string, &num_int))
-    return new FundamentalValue(num_int);
+  if (StringToInt(num_string, &num_int)) {
+    *out = builder->CreateInteger(num_int);
+    return true;
+  }
 
   double num_double;
   if (StringToDouble(num_string.as_string(), &num_double) &&
       std::isfinite(num_double)) {
-    return new FundamentalValue(num_double);
+    *out = builder->CreateDouble(num_double);
+    return true;
   }
 
-  return NULL;
+  return false;
 }
 
 bool JSONParser::ReadInt(bool allow_leading_zeros) {
@@ -922,7 +1146,9 @@ bool JSONParser::ReadInt(bool allow_leading_zeros) {
   return true;
 }
 
-Value* JSONParser::ConsumeLiteral() {
+template <typename Builder>
+bool JSONParser::ConsumeLiteral(Builder* builder,
+                                typename Builder::ValueType* out) {
   switch (*pos_) {
     case 't': {
       const char kTrueLiteral[] = "true";
@@ -930,10 +1156,11 @@ Value* JSONParser::ConsumeLiteral() {
       if (!CanConsume(kTrueLen - 1) ||
           !StringsAreEqual(pos_, kTrueLiteral, kTrueLen)) {
         ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-        return NULL;
+        return false;
       }
       NextNChars(kTrueLen - 1);
-      return new FundamentalValue(true);
+      *out = builder->CreateBoolean(true);
+      return true;
     }
     case 'f': {
       const char kFalseLiteral[] = "false";
@@ -941,10 +1168,11 @@ Value* JSONParser::ConsumeLiteral() {
       if (!CanConsume(kFalseLen - 1) ||
           !StringsAreEqual(pos_, kFalseLiteral, kFalseLen)) {
         ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-        return NULL;
+        return false;
       }
       NextNChars(kFalseLen - 1);
-      return new FundamentalValue(false);
+      *out = builder->CreateBoolean(false);
+      return true;
     }
     case 'n': {
       const char kNullLiteral[] = "null";
@@ -952,17 +1180,48 @@ Value* JSONParser::ConsumeLiteral() {
       if (!CanConsume(kNullLen - 1) ||
           !StringsAreEqual(pos_, kNullLiteral, kNullLen)) {
         ReportError(JSONReader::JSON_SYNTAX_ERROR, 1);
-        return NULL;
+        return false;
       }
       NextNChars(kNullLen - 1);
-      return Value::CreateNullValue().release();
+      *out = builder->CreateNull();
+      return true;
     }
     default:
       ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, 1);
-      return NULL;
+      return false;
   }
 }
 
+Value* JSONParser::ConsumeDictionary() {
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> value;
+  return ConsumeDictionary(&builder, &value) ? value.release() : nullptr;
+}
+
+Value* JSONParser::ConsumeList() {
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> value;
+  return ConsumeList(&builder, &value) ? value.release() : nullptr;
+}
+
+Value* JSONParser::ConsumeString() {
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> value;
+  return ConsumeString(&builder, &value) ? value.release() : nullptr;
+}
+
+Value* JSONParser::ConsumeNumber() {
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> value;
+  return ConsumeNumber(&builder, &value) ? value.release() : nullptr;
+}
+
+Value* JSONParser::ConsumeLiteral() {
+  HeapBuilder builder(options_);
+  std::unique_ptr<Value> value;
+  return ConsumeLiteral(&builder, &value) ? value.release() : nullptr;
+}
+
 // static
 bool JSONParser::StringsAreEqual(const char* one, const char* two, size_t len) {
   return strncmp(one, two, len) == 0;
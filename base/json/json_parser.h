@@ -21,6 +21,7 @@
 namespace base {
 
 class Value;
+class ValueArena;
 
 namespace internal {
 
@@ -34,9 +35,11 @@ class JSONParserTest;
 // objects by using "hidden roots," discussed in the implementation.
 //
 // Iteration happens on the byte level, with the functions CanConsume and
-// NextChar. The conversion from byte to JSON token happens without advancing
-// the parser in GetNextToken/ParseToken, that is tokenization operates on
-// the current parser position without advancing.
+// NextChar. Runs of whitespace and of string characters that need no decoding
+// are skipped in bulk, 16 bytes at a time on x86. The conversion from byte to
+// JSON token happens without advancing the parser in GetNextToken/ParseToken,
+// that is tokenization operates on the current parser position without
+// advancing.
 //
 // Built on top of these are a family of Consume functions that iterate
 // internally. Invariant: on entry of a Consume function, the parser is wound
@@ -53,6 +56,10 @@ class BASE_EXPORT JSONParser {
   // result as a Value owned by the caller.
   std::unique_ptr<Value> Parse(StringPiece input);
 
+  // Parses the input string like Parse(), but into a tree of ArenaValues,
+  // returned with the ValueArena that holds them.
+  std::unique_ptr<ValueArena> ParseToArena(StringPiece input);
+
   // Returns the error code.
   JSONReader::JsonParseError error_code() const;
 
@@ -111,6 +118,12 @@ class BASE_EXPORT JSONParser {
     // Appends a string to the std::string. Must be Convert()ed to use.
     void AppendString(const std::string& str);
 
+    // Appends the |length| ASCII characters at |str| in the input, either by
+    // increasing |length_| or by copying them if the StringBuilder has been
+    // converted. If it has not, |str| must immediately follow the characters
+    // already in the builder.
+    void AppendRun(const char* str, size_t length);
+
     // Converts the builder from its default StringPiece to a full std::string,
     // performing a copy. Once a builder is converted, it cannot be made a
     // StringPiece again.
@@ -159,24 +172,42 @@ class BASE_EXPORT JSONParser {
   // currently wound to a '/'.
   bool EatComment();
 
-  // Calls GetNextToken() and then ParseToken(). Caller owns the result.
-  Value* ParseNextToken();
+  // The functions below that create values take a Builder, so that the same
+  // code creates the Values of Parse() and the ArenaValues of ParseToArena().
+  // A Builder defines ValueType, and the ListType and DictionaryType used
+  // while filling containers; see HeapBuilder in json_parser.cc. The functions
+  // return true and set |out| on success.
+  class HeapBuilder;
+  class ArenaBuilder;
+
+  // Parses the input from |start_pos_| to |end_pos_|, which must hold a single
+  // value, into |root|.
+  template <typename Builder>
+  bool ParseInput(Builder* builder, typename Builder::ValueType* root);
+
+  // Calls GetNextToken() and then ParseToken().
+  template <typename Builder>
+  bool ParseNextToken(Builder* builder, typename Builder::ValueType* out);
 
   // Takes a token that represents the start of a Value ("a structural token"
-  // in RFC terms) and consumes it, returning the result as an object the
-  // caller owns.
-  Value* ParseToken(Token token);
+  // in RFC terms) and consumes it.
+  template <typename Builder>
+  bool ParseToken(Token token,
+                  Builder* builder,
+                  typename Builder::ValueType* out);
 
   // Assuming that the parser is currently wound to '{', this parses a JSON
-  // object into a DictionaryValue.
-  Value* ConsumeDictionary();
+  // object into a dictionary.
+  template <typename Builder>
+  bool ConsumeDictionary(Builder* builder, typename Builder::ValueType* out);
 
-  // Assuming that the parser is wound to '[', this parses a JSON list into a
-  // ListValue.
-  Value* ConsumeList();
+  // Assuming that the parser is wound to '[', this parses a JSON list.
+  template <typename Builder>
+  bool ConsumeList(Builder* builder, typename Builder::ValueType* out);
 
   // Calls through ConsumeStringRaw and wraps it in a value.
-  Value* ConsumeString();
+  template <typename Builder>
+  bool ConsumeString(Builder* builder, typename Builder::ValueType* out);
 
   // Assuming that the parser is wound to a double quote, this parses a string,
   // decoding any escape sequences and converts UTF-16 to UTF-8. Returns true on
@@ -196,13 +227,23 @@ class BASE_EXPORT JSONParser {
 
   // Assuming that the parser is wound to the start of a valid JSON number,
   // this parses and converts it to either an int or double value.
-  Value* ConsumeNumber();
+  template <typename Builder>
+  bool ConsumeNumber(Builder* builder, typename Builder::ValueType* out);
   // Helper that reads characters that are ints. Returns true if a number was
   // read and false on error.
   bool ReadInt(bool allow_leading_zeros);
 
   // Consumes the literal values of |true|, |false|, and |null|, assuming the
   // parser is wound to the first character of any of those.
+  template <typename Builder>
+  bool ConsumeLiteral(Builder* builder, typename Builder::ValueType* out);
+
+  // Versions of the Consume functions above that return regular Values, owned
+  // by the caller, or null on error.
+  Value* ConsumeDictionary();
+  Value* ConsumeList();
+  Value* ConsumeString();
+  Value* ConsumeNumber();
   Value* ConsumeLiteral();
 
   // Compares two string buffers of a given length.
@@ -256,6 +297,8 @@ class BASE_EXPORT JSONParser {
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLiterals);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeNumbers);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ErrorMessages);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, StringRuns);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, WhitespaceRuns);
 
   DISALLOW_COPY_AND_ASSIGN(JSONParser);
 };
@@ -323,5 +323,85 @@ TEST_F(JSONParserTest, DecodeUnicodeNonCharacter) {
   EXPECT_FALSE(JSONReader::Read("[\"\\ud83f\\udffe\"]"));
 }
 
+// Strings are consumed in runs of characters that need no decoding, up to 16 at
+// a time. Check that the characters stopping a run are handled the same at any
+// position.
+TEST_F(JSONParserTest, StringRuns) {
+  const std::string kAlphabet("abcdefghijklmnopqrstuvwxyz0123456789 {}[],:");
+  for (size_t length = 0; length <= kAlphabet.length(); ++length) {
+    const std::string plain = kAlphabet.substr(0, length);
+    for (size_t offset = 0; offset <= length; ++offset) {
+      std::string prefix = plain.substr(0, offset);
+      std::string suffix = plain.substr(offset);
+      SCOPED_TRACE(prefix + "|" + suffix);
+
+      std::string str;
+      std::unique_ptr<Value> value =
+          JSONReader::Read("[\"" + prefix + "\\n" + suffix + "\"]");
+      ASSERT_TRUE(value);
+      ListValue* list = nullptr;
+      ASSERT_TRUE(value->GetAsList(&list));
+      ASSERT_TRUE(list->GetString(0, &str));
+      EXPECT_EQ(prefix + "\n" + suffix, str);
+
+      value = JSONReader::Read("\"" + prefix + "\xC3\xA9" + suffix + "\"");
+      ASSERT_TRUE(value);
+      ASSERT_TRUE(value->GetAsString(&str));
+      EXPECT_EQ(prefix + "\xC3\xA9" + suffix, str);
+
+      // The string is parsed in place until it needs to be converted.
+      value = JSONReader::Read("\"" + plain + "\"");
+      ASSERT_TRUE(value);
+      ASSERT_TRUE(value->GetAsString(&str));
+      EXPECT_EQ(plain, str);
+
+      int error_code = 0;
+      std::string error_message;
+      value = JSONReader::ReadAndReturnError(
+          "[\"" + prefix + "\xFF" + suffix + "\"]", JSON_PARSE_RFC,
+          &error_code, &error_message);
+      EXPECT_FALSE(value);
+      EXPECT_EQ(JSONReader::JSON_UNSUPPORTED_ENCODING, error_code);
+      EXPECT_EQ(JSONParser::FormatErrorMessage(
+                    1, static_cast<int>(offset) + 4,
+                    JSONReader::kUnsupportedEncoding),
+                error_message);
+
+      // Unterminated string.
+      value = JSONReader::ReadAndReturnError("\"" + plain, JSON_PARSE_RFC,
+                                             &error_code, &error_message);
+      EXPECT_FALSE(value);
+      EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, error_code);
+    }
+  }
+}
+
+// Spaces and tabs are skipped in runs too. Line and column numbers must still
+// be reported past them.
+TEST_F(JSONParserTest, WhitespaceRuns) {
+  for (size_t length = 0; length <= 40; ++length) {
+    const std::string blank = length % 2 ? std::string(length, ' ')
+                                         : std::string(length, '\t');
+    SCOPED_TRACE(length);
+
+    std::unique_ptr<Value> value =
+        JSONReader::Read(blank + "{" + blank + "\"a\"" + blank + ":" + blank +
+                         "[" + blank + "1" + blank + "]" + blank + "}" + blank);
+    ASSERT_TRUE(value);
+    EXPECT_TRUE(value->IsType(Value::TYPE_DICTIONARY));
+
+    int error_code = 0;
+    std::string error_message;
+    value = JSONReader::ReadAndReturnError(
+        "{\n\"a\":\r\n" + blank + "x}", JSON_PARSE_RFC, &error_code,
+        &error_message);
+    EXPECT_FALSE(value);
+    EXPECT_EQ(JSONReader::JSON_UNEXPECTED_TOKEN, error_code);
+    EXPECT_EQ(JSONParser::FormatErrorMessage(3, static_cast<int>(length) + 2,
+                                             JSONReader::kUnexpectedToken),
+              error_message);
+  }
+}
+
 }  // namespace internal
 }  // namespace base
@@ -0,0 +1,220 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/allocator/features.h"
+#include "base/atomicops.h"
+#include "base/format_macros.h"
+#include "base/json/arena_value.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
+#include "base/allocator/allocator_shim.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// Size of the generated documents, before pretty-printing.
+const size_t kDocumentSize = 4 * 1024 * 1024;
+
+// Number of times each document is parsed.
+const int kNumIterations = 10;
+
+#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
+// Allocations made since the shim hooks were inserted, in all threads.
+subtle::Atomic32 g_allocation_count = 0;
+subtle::AtomicWord g_allocated_bytes = 0;
+
+using allocator::AllocatorDispatch;
+
+void CountAllocation(size_t size) {
+  subtle::NoBarrier_AtomicIncrement(&g_allocation_count, 1);
+  subtle::NoBarrier_AtomicIncrement(&g_allocated_bytes, size);
+}
+
+void* HookAlloc(const AllocatorDispatch* self, size_t size) {
+  CountAllocation(size);
+  return self->next->alloc_function(self->next, size);
+}
+
+void* HookZeroInitAlloc(const AllocatorDispatch* self, size_t n, size_t size) {
+  CountAllocation(n * size);
+  return self->next->alloc_zero_initialized_function(self->next, n, size);
+}
+
+void* HookAllocAligned(const AllocatorDispatch* self,
+                       size_t alignment,
+                       size_t size) {
+  CountAllocation(size);
+  return self->next->alloc_aligned_function(self->next, alignment, size);
+}
+
+void* HookRealloc(const AllocatorDispatch* self, void* address, size_t size) {
+  CountAllocation(size);
+  return self->next->realloc_function(self->next, address, size);
+}
+
+void HookFree(const AllocatorDispatch* self, void* address) {
+  self->next->free_function(self->next, address);
+}
+
+AllocatorDispatch g_allocator_hooks = {
+    &HookAlloc,         /* alloc_function */
+    &HookZeroInitAlloc, /* alloc_zero_initialized_function */
+    &HookAllocAligned,  /* alloc_aligned_function */
+    &HookRealloc,       /* realloc_function */
+    &HookFree,          /* free_function */
+    nullptr,            /* next */
+};
+#endif  // BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
+
+// Reports the number and total size of the allocations made by |parse|, when
+// the allocator shim allows counting them.
+template <typename Parse>
+void PrintAllocations(const std::string& trace, const Parse& parse) {
+#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
+  subtle::NoBarrier_Store(&g_allocation_count, 0);
+  subtle::NoBarrier_Store(&g_allocated_bytes, 0);
+  allocator::InsertAllocatorDispatch(&g_allocator_hooks);
+  parse();
+  allocator::RemoveAllocatorDispatchForTesting(&g_allocator_hooks);
+  perf_test::PrintResult(
+      "json_parse_allocations", "", trace,
+      static_cast<size_t>(subtle::NoBarrier_Load(&g_allocation_count)),
+      "allocations", true);
+  perf_test::PrintResult(
+      "json_parse_allocated_bytes", "", trace,
+      static_cast<size_t>(subtle::NoBarrier_Load(&g_allocated_bytes)),
+      "bytes", false);
+#endif
+}
+
+// Returns a list of records mostly made of strings, like the preferences and
+// extension manifests Chrome reads.
+std::unique_ptr<Value> CreateStringHeavyValue() {
+  std::unique_ptr<ListValue> list(new ListValue);
+  size_t size = 0;
+  for (size_t i = 0; size < kDocumentSize; ++i) {
+    std::unique_ptr<DictionaryValue> record(new DictionaryValue);
+    record->SetString("name", StringPrintf("record %" PRIuS, i));
+    record->SetString("url", StringPrintf("https://www.example.com/path/to/"
+                                          "some/resource/%" PRIuS ".html?q=%"
+                                          PRIuS, i, i * 31));
+    record->SetString("description",
+                      "A fairly long description of the record that takes a "
+                      "few dozen characters, with \"quotes\" and a \\ too.");
+    record->SetString("localized", "D\xC3\xA9j\xC3\xA0 vu \xE2\x80\x94 "
+                                   "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E");
+    record->SetBoolean("enabled", i % 2 == 0);
+    size += 250;
+    list->Append(std::move(record));
+  }
+  return std::move(list);
+}
+
+// Returns a list of lists of numbers, like the data of a chart.
+std::unique_ptr<Value> CreateNumberHeavyValue() {
+  std::unique_ptr<ListValue> list(new ListValue);
+  size_t size = 0;
+  for (int i = 0; size < kDocumentSize; ++i) {
+    std::unique_ptr<ListValue> point(new ListValue);
+    point->AppendInteger(i);
+    point->AppendInteger(-i * 7919);
+    point->AppendDouble(i / 3.0);
+    point->AppendDouble(i * 1.5e10);
+    size += 50;
+    list->Append(std::move(point));
+  }
+  return std::move(list);
+}
+
+void RunParse(const std::string& trace, const Value& value, int write_options) {
+  std::string json;
+  ASSERT_TRUE(JSONWriter::WriteWithOptions(value, write_options, &json));
+
+  ElapsedTimer timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    std::unique_ptr<Value> result = JSONReader::Read(json);
+    ASSERT_TRUE(result);
+  }
+  TimeDelta elapsed = timer.Elapsed();
+
+  double megabytes =
+      static_cast<double>(json.size()) * kNumIterations / (1024 * 1024);
+  perf_test::PrintResult("json_parse", "", trace,
+                         megabytes / elapsed.InSecondsF(), "MB/s", true);
+}
+
+// Compares parsing |value| written as compact JSON into Values and into a
+// ValueArena, including the time it takes to free them.
+void RunParseToArena(const std::string& trace, const Value& value) {
+  std::string json;
+  ASSERT_TRUE(JSONWriter::Write(value, &json));
+  double megabytes =
+      static_cast<double>(json.size()) * kNumIterations / (1024 * 1024);
+
+  JSONReader reader;
+  ElapsedTimer value_timer;
+  for (int i = 0; i < kNumIterations; ++i)
+    ASSERT_TRUE(reader.ReadToValue(json));
+  TimeDelta value_elapsed = value_timer.Elapsed();
+
+  ElapsedTimer arena_timer;
+  for (int i = 0; i < kNumIterations; ++i)
+    ASSERT_TRUE(reader.ReadToArena(json));
+  TimeDelta arena_elapsed = arena_timer.Elapsed();
+
+  perf_test::PrintResult("json_parse_and_free", "", trace + "_values",
+                         megabytes / value_elapsed.InSecondsF(), "MB/s", true);
+  perf_test::PrintResult("json_parse_and_free", "", trace + "_arena",
+                         megabytes / arena_elapsed.InSecondsF(), "MB/s", true);
+
+  std::unique_ptr<ValueArena> arena = reader.ReadToArena(json);
+  perf_test::PrintResult("json_arena_size", "", trace,
+                         arena->MemoryUsageInBytes(), "bytes", false);
+  arena.reset();
+
+  PrintAllocations(trace + "_values", [&reader, &json]() {
+    std::unique_ptr<Value> result = reader.ReadToValue(json);
+  });
+  PrintAllocations(trace + "_arena", [&reader, &json]() {
+    std::unique_ptr<ValueArena> result = reader.ReadToArena(json);
+  });
+}
+
+}  // namespace
+
+// Measures the throughput of JSONReader on documents dominated by strings and
+// by numbers, pretty-printed and compact.
+TEST(JSONPerfTest, Read) {
+  std::unique_ptr<Value> strings = CreateStringHeavyValue();
+  RunParse("strings_compact", *strings, 0);
+  RunParse("strings_pretty", *strings, JSONWriter::OPTIONS_PRETTY_PRINT);
+
+  std::unique_ptr<Value> numbers = CreateNumberHeavyValue();
+  RunParse("numbers_compact", *numbers, 0);
+  RunParse("numbers_pretty", *numbers, JSONWriter::OPTIONS_PRETTY_PRINT);
+}
+
+// Compares JSONReader::ReadToValue() and JSONReader::ReadToArena().
+TEST(JSONPerfTest, ReadToArena) {
+  RunParseToArena("strings", *CreateStringHeavyValue());
+  RunParseToArena("numbers", *CreateNumberHeavyValue());
+}
+
+}  // namespace base
@@ -4,6 +4,7 @@
 
 #include "base/json/json_reader.h"
 
+#include "base/json/arena_value.h"
 #include "base/json/json_parser.h"
 #include "base/logging.h"
 #include "base/values.h"
@@ -110,6 +111,10 @@ std::unique_ptr<Value> JSONReader::ReadToValue(StringPiece json) {
   return parser_->Parse(json);
 }
 
+std::unique_ptr<ValueArena> JSONReader::ReadToArena(StringPiece json) {
+  return parser_->ParseToArena(json);
+}
+
 JSONReader::JsonParseError JSONReader::error_code() const {
   return parser_->error_code();
 }
@@ -37,6 +37,7 @@
 namespace base {
 
 class Value;
+class ValueArena;
 
 namespace internal {
 class JSONParser;
@@ -119,7 +120,14 @@ class BASE_EXPORT JSONReader {
   // Parses an input string into a Value that is owned by the caller.
   std::unique_ptr<Value> ReadToValue(StringPiece json);
 
-  // Returns the error code if the last call to ReadToValue() failed.
+  // Parses an input string into a read-only tree of ArenaValues, which is
+  // built with far fewer allocations than a Value tree. The ValueArena
+  // returned holds the whole tree and does not refer to |json|. Returns null
+  // if the input is not properly formed.
+  std::unique_ptr<ValueArena> ReadToArena(StringPiece json);
+
+  // Returns the error code if the last call to ReadToValue() or ReadToArena()
+  // failed.
   // Returns JSON_NO_ERROR otherwise.
   JsonParseError error_code() const;
 
@@ -0,0 +1,338 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/io_uring_poller_linux.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/files/scoped_file.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "build/build_config.h"
+
+// The io_uring interface is only available with recent kernel headers. When
+// building against older ones, Create() always returns nullptr.
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define HAS_IO_URING 1
+#endif
+#endif
+
+namespace base {
+namespace internal {
+
+#if defined(HAS_IO_URING)
+
+// Memory shared with the kernel. The kernel advances |sq_head| and |cq_tail|;
+// the poller advances |sq_tail| and |cq_head|.
+struct IOUringPoller::Rings {
+  ~Rings() {
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqes_size);
+    if (cq_ring != MAP_FAILED)
+      munmap(cq_ring, cq_ring_size);
+    if (sq_ring != MAP_FAILED)
+      munmap(sq_ring, sq_ring_size);
+  }
+
+  ScopedFD fd;
+
+  void* sq_ring = MAP_FAILED;
+  size_t sq_ring_size = 0;
+  volatile subtle::Atomic32* sq_head = nullptr;
+  volatile subtle::Atomic32* sq_tail = nullptr;
+  uint32_t* sq_array = nullptr;
+  uint32_t sq_mask = 0;
+  uint32_t sq_entries = 0;
+
+  io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqes_size = 0;
+
+  void* cq_ring = MAP_FAILED;
+  size_t cq_ring_size = 0;
+  volatile subtle::Atomic32* cq_head = nullptr;
+  volatile subtle::Atomic32* cq_tail = nullptr;
+  const io_uring_cqe* cqes = nullptr;
+  uint32_t cq_mask = 0;
+};
+
+namespace {
+
+template <typename T>
+T* RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+void* MapRing(int fd, size_t size, off_t offset) {
+  return mmap(nullptr, size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, offset);
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<IOUringPoller> IOUringPoller::Create(uint32_t num_entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CLAMP;
+  std::unique_ptr<Rings> rings(new Rings);
+  rings->fd.reset(syscall(__NR_io_uring_setup, num_entries, &params));
+  if (!rings->fd.is_valid()) {
+    DPLOG(WARNING) << "io_uring_setup";
+    return nullptr;
+  }
+
+  // IORING_FEAT_EXT_ARG allows waiting with a timeout without queuing a
+  // timeout request, and IORING_FEAT_NODROP guarantees that no completion is
+  // lost when the completion ring overflows.
+  const uint32_t kRequiredFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((params.features & kRequiredFeatures) != kRequiredFeatures)
+    return nullptr;
+
+  const int fd = rings->fd.get();
+  rings->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  rings->sq_ring = MapRing(fd, rings->sq_ring_size, IORING_OFF_SQ_RING);
+  rings->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  rings->sqes = static_cast<io_uring_sqe*>(
+      MapRing(fd, rings->sqes_size, IORING_OFF_SQES));
+  rings->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  rings->cq_ring = MapRing(fd, rings->cq_ring_size, IORING_OFF_CQ_RING);
+  if (rings->sq_ring == MAP_FAILED || rings->sqes == MAP_FAILED ||
+      rings->cq_ring == MAP_FAILED) {
+    DPLOG(ERROR) << "mmap";
+    return nullptr;
+  }
+
+  void* sq_ring = rings->sq_ring;
+  rings->sq_head =
+      RingField<volatile subtle::Atomic32>(sq_ring, params.sq_off.head);
+  rings->sq_tail =
+      RingField<volatile subtle::Atomic32>(sq_ring, params.sq_off.tail);
+  rings->sq_array = RingField<uint32_t>(sq_ring, params.sq_off.array);
+  rings->sq_mask = *RingField<uint32_t>(sq_ring, params.sq_off.ring_mask);
+  rings->sq_entries = params.sq_entries;
+
+  void* cq_ring = rings->cq_ring;
+  rings->cq_head =
+      RingField<volatile subtle::Atomic32>(cq_ring, params.cq_off.head);
+  rings->cq_tail =
+      RingField<volatile subtle::Atomic32>(cq_ring, params.cq_off.tail);
+  rings->cqes = RingField<const io_uring_cqe>(cq_ring, params.cq_off.cqes);
+  rings->cq_mask = *RingField<uint32_t>(cq_ring, params.cq_off.ring_mask);
+
+  return WrapUnique(new IOUringPoller(std::move(rings)));
+}
+
+IOUringPoller::IOUringPoller(std::unique_ptr<Rings> rings)
+    : rings_(std::move(rings)) {}
+
+IOUringPoller::~IOUringPoller() {}
+
+void IOUringPoller::AddPoll(int fd, uint32_t poll_mask, uint64_t user_data) {
+  DCHECK_NE(0u, user_data);
+  Queue({IORING_OP_POLL_ADD, fd, poll_mask, 0, user_data});
+}
+
+void IOUringPoller::RemovePoll(uint64_t user_data) {
+  // The completion of the removal request itself carries a 0 |user_data| and
+  // is not reported.
+  Queue({IORING_OP_POLL_REMOVE, -1, 0, user_data, 0});
+}
+
+bool IOUringPoller::SubmitAndWait(TimeDelta timeout,
+                                  std::vector<Completion>* completions) {
+  if (!reaped_completions_.empty()) {
+    completions->insert(completions->end(), reaped_completions_.begin(),
+                        reaped_completions_.end());
+    reaped_completions_.clear();
+    timeout = TimeDelta();
+  }
+  // Don't block with requests left to submit, nor if completions are already
+  // available.
+  if (!QueueBacklog() || subtle::NoBarrier_Load(rings_->cq_head) !=
+                             subtle::Acquire_Load(rings_->cq_tail)) {
+    timeout = TimeDelta();
+  }
+  if (num_queued_ > 0 || !timeout.is_zero()) {
+    if (!Enter(num_queued_, timeout))
+      return false;
+  }
+  ReapCompletions(completions);
+  return true;
+}
+
+void IOUringPoller::Queue(const Request& request) {
+  if (backlog_.empty() && !IsSubmissionRingFull()) {
+    WriteRequest(request);
+    return;
+  }
+  backlog_.push_back(request);
+  QueueBacklog();
+}
+
+bool IOUringPoller::QueueBacklog() {
+  while (!backlog_.empty()) {
+    if (IsSubmissionRingFull()) {
+      // The kernel doesn't consume requests while the completion ring is
+      // overflowing (EBUSY), so completions are reaped first. It can also be
+      // temporarily short of resources (EAGAIN), in which case the requests
+      // stay in the backlog until the next attempt.
+      ReapCompletions(&reaped_completions_);
+      if (!Enter(num_queued_, TimeDelta()) || IsSubmissionRingFull())
+        return false;
+    }
+    WriteRequest(backlog_.front());
+    backlog_.pop_front();
+  }
+  return true;
+}
+
+bool IOUringPoller::IsSubmissionRingFull() const {
+  // The indices wrap around, so they are subtracted unsigned.
+  const uint32_t tail =
+      static_cast<uint32_t>(subtle::NoBarrier_Load(rings_->sq_tail));
+  const uint32_t head =
+      static_cast<uint32_t>(subtle::Acquire_Load(rings_->sq_head));
+  return tail - head == rings_->sq_entries;
+}
+
+void IOUringPoller::WriteRequest(const Request& request) {
+  DCHECK(!IsSubmissionRingFull());
+  const uint32_t tail =
+      static_cast<uint32_t>(subtle::NoBarrier_Load(rings_->sq_tail));
+  const uint32_t index = tail & rings_->sq_mask;
+  io_uring_sqe* sqe = &rings_->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = request.opcode;
+  sqe->fd = request.fd;
+  sqe->addr = request.addr;
+  uint32_t poll_mask = request.poll_mask;
+#if defined(ARCH_CPU_BIG_ENDIAN)
+  // The kernel swaps the 16-bit halves of the mask on big-endian machines.
+  poll_mask = (poll_mask << 16) | (poll_mask >> 16);
+#endif
+  sqe->poll32_events = poll_mask;
+  sqe->user_data = request.user_data;
+  rings_->sq_array[index] = index;
+
+  // Publishes the entry to the kernel.
+  subtle::Release_Store(rings_->sq_tail,
+                        static_cast<subtle::Atomic32>(tail + 1));
+  ++num_queued_;
+}
+
+bool IOUringPoller::Enter(uint32_t num_to_submit, TimeDelta timeout) {
+  io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  struct timespec ts;
+  unsigned flags = IORING_ENTER_EXT_ARG;
+  uint32_t min_complete = 0;
+  if (!timeout.is_zero()) {
+    flags |= IORING_ENTER_GETEVENTS;
+    min_complete = 1;
+    if (!timeout.is_max()) {
+      ts = timeout.ToTimeSpec();
+      arg.ts = reinterpret_cast<uintptr_t>(&ts);
+    }
+  }
+
+  const long rv = syscall(__NR_io_uring_enter, rings_->fd.get(), num_to_submit,
+                          min_complete, flags, &arg, sizeof(arg));
+  if (rv >= 0) {
+    num_queued_ -= static_cast<uint32_t>(rv);
+    return true;
+  }
+  // ETIME: the timeout elapsed. EINTR: interrupted by a signal. EAGAIN and
+  // EBUSY: the kernel is short of resources or the completion ring has
+  // overflowed; the requests that were not consumed are submitted on the
+  // next call, once the completions have been reaped.
+  if (errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY)
+    return true;
+  DPLOG(ERROR) << "io_uring_enter";
+  return false;
+}
+
+void IOUringPoller::ReapCompletions(std::vector<Completion>* completions) {
+  uint32_t head =
+      static_cast<uint32_t>(subtle::NoBarrier_Load(rings_->cq_head));
+  const uint32_t tail =
+      static_cast<uint32_t>(subtle::Acquire_Load(rings_->cq_tail));
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = rings_->cqes[head & rings_->cq_mask];
+    if (cqe.user_data)
+      completions->push_back({cqe.user_data, cqe.res});
+  }
+  // Hands the consumed entries back to the kernel.
+  subtle::Release_Store(rings_->cq_head, static_cast<subtle::Atomic32>(head));
+}
+
+#else  // defined(HAS_IO_URING)
+
+struct IOUringPoller::Rings {};
+
+// static
+std::unique_ptr<IOUringPoller> IOUringPoller::Create(uint32_t num_entries) {
+  return nullptr;
+}
+
+IOUringPoller::IOUringPoller(std::unique_ptr<Rings> rings) {}
+
+IOUringPoller::~IOUringPoller() {}
+
+void IOUringPoller::AddPoll(int fd, uint32_t poll_mask, uint64_t user_data) {
+  NOTREACHED();
+}
+
+void IOUringPoller::RemovePoll(uint64_t user_data) {
+  NOTREACHED();
+}
+
+bool IOUringPoller::SubmitAndWait(TimeDelta timeout,
+                                  std::vector<Completion>* completions) {
+  NOTREACHED();
+  return false;
+}
+
+void IOUringPoller::Queue(const Request& request) {
+  NOTREACHED();
+}
+
+bool IOUringPoller::QueueBacklog() {
+  NOTREACHED();
+  return false;
+}
+
+bool IOUringPoller::IsSubmissionRingFull() const {
+  NOTREACHED();
+  return false;
+}
+
+void IOUringPoller::WriteRequest(const Request& request) {
+  NOTREACHED();
+}
+
+bool IOUringPoller::Enter(uint32_t num_to_submit, TimeDelta timeout) {
+  NOTREACHED();
+  return false;
+}
+
+void IOUringPoller::ReapCompletions(std::vector<Completion>* completions) {
+  NOTREACHED();
+}
+
+#endif  // defined(HAS_IO_URING)
+
+}  // namespace internal
+}  // namespace base
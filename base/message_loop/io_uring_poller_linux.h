@@ -0,0 +1,116 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MESSAGE_LOOP_IO_URING_POLLER_LINUX_H_
+#define BASE_MESSAGE_LOOP_IO_URING_POLLER_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace internal {
+
+// Waits for file descriptor readiness through an io_uring instance. Poll
+// requests are queued in the submission ring and handed to the kernel in a
+// single io_uring_enter() call, which is also the call that waits for
+// completions, so arming any number of polls costs no extra system call.
+// Completions are read from the completion ring without system calls.
+//
+// Polls are one-shot: a file descriptor has to be polled again after each
+// completion. This class is not thread-safe.
+class BASE_EXPORT IOUringPoller {
+ public:
+  struct Completion {
+    // |user_data| passed to AddPoll().
+    uint64_t user_data;
+    // Mask of ready poll events (POLLIN, POLLOUT, ...), or a negative errno
+    // value.
+    int32_t result;
+  };
+
+  // Returns a poller whose rings can hold |num_entries| requests, or nullptr
+  // if the kernel does not support the io_uring features used by this class
+  // (Linux 5.11 or later) or if io_uring is blocked, e.g. by a seccomp policy.
+  static std::unique_ptr<IOUringPoller> Create(uint32_t num_entries);
+
+  ~IOUringPoller();
+
+  // Queues a one-shot poll of |fd| for the poll events in |poll_mask|. Its
+  // completion carries |user_data|, which must not be 0.
+  void AddPoll(int fd, uint32_t poll_mask, uint64_t user_data);
+
+  // Queues the cancellation of the poll added with |user_data|. A completion
+  // with result -ECANCELED is reported for the cancelled poll, unless it
+  // completed first.
+  void RemovePoll(uint64_t user_data);
+
+  // Submits the queued requests and appends the available completions to
+  // |completions|. If no completion is available and |timeout| is not zero,
+  // blocks until one is, or until |timeout| elapses. A TimeDelta::Max()
+  // |timeout| blocks indefinitely. Returns false on failure.
+  bool SubmitAndWait(TimeDelta timeout, std::vector<Completion>* completions);
+
+ private:
+  struct Rings;
+
+  explicit IOUringPoller(std::unique_ptr<Rings> rings);
+
+  struct Request {
+    uint8_t opcode;
+    int fd;
+    uint32_t poll_mask;
+    uint64_t addr;
+    uint64_t user_data;
+  };
+
+  // Queues a request in the submission ring. If the ring is full and the
+  // kernel can't consume the queued requests right now, the request is kept
+  // in |backlog_| instead.
+  void Queue(const Request& request);
+
+  // Moves the requests of |backlog_| to the submission ring, submitting the
+  // queued requests whenever the ring is full. Returns false if some requests
+  // are still in |backlog_|.
+  bool QueueBacklog();
+
+  // Returns true if the submission ring has no room for another request.
+  bool IsSubmissionRingFull() const;
+
+  // Writes |request| to the submission ring, which must not be full.
+  void WriteRequest(const Request& request);
+
+  // Makes the kernel consume up to |num_to_submit| queued requests and, if
+  // |timeout| is not zero, wait for a completion. Returns false on failure.
+  bool Enter(uint32_t num_to_submit, TimeDelta timeout);
+
+  // Appends all the available completions to |completions|.
+  void ReapCompletions(std::vector<Completion>* completions);
+
+  std::unique_ptr<Rings> rings_;
+
+  // Number of requests queued in the submission ring since the last Enter().
+  uint32_t num_queued_ = 0;
+
+  // Requests which didn't fit in the submission ring.
+  std::deque<Request> backlog_;
+
+  // Completions reaped to make room for requests, which are reported by the
+  // next SubmitAndWait().
+  std::vector<Completion> reaped_completions_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOUringPoller);
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_MESSAGE_LOOP_IO_URING_POLLER_LINUX_H_
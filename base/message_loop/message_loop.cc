@@ -10,6 +10,7 @@
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
@@ -242,8 +243,16 @@ std::unique_ptr<MessagePump> MessageLoop::CreateMessagePumpForType(Type type) {
       return message_pump_for_ui_factory_();
     return MESSAGE_PUMP_UI;
   }
-  if (type == MessageLoop::TYPE_IO)
+  if (type == MessageLoop::TYPE_IO) {
+#if defined(OS_LINUX) && !defined(OS_NACL)
+    if (FeatureList::GetInstance() &&
+        FeatureList::IsEnabled(kMessagePumpIOUringFeature)) {
+      return std::unique_ptr<MessagePump>(
+          new MessagePumpLibevent(MessagePumpLibevent::Backend::IO_URING));
+    }
+#endif
     return std::unique_ptr<MessagePump>(new MessagePumpForIO());
+  }
 
 #if defined(OS_ANDROID)
   if (type == MessageLoop::TYPE_JAVA)
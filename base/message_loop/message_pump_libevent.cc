@@ -5,6 +5,7 @@
 #include "base/message_loop/message_pump_libevent.h"
 
 #include <errno.h>
+#include <poll.h>
 #include <unistd.h>
 
 #include <memory>
@@ -43,15 +44,38 @@
 
 namespace base {
 
+#if defined(OS_LINUX)
+const Feature kMessagePumpIOUringFeature{
+  "MessagePumpIOUring", FEATURE_DISABLED_BY_DEFAULT
+};
+
+namespace {
+
+// Size of the io_uring submission ring. Requests are submitted early if more
+// are queued between two waits.
+const uint32_t kIOUringEntries = 256;
+
+// Poll id of the wakeup pipe. Watchers get ids from kFirstWatcherPollId on;
+// 0 is reserved by internal::IOUringPoller.
+const uint64_t kWakeupPollId = 1;
+const uint64_t kFirstWatcherPollId = 2;
+
+}  // namespace
+#endif  // defined(OS_LINUX)
+
 MessagePumpLibevent::FileDescriptorWatcher::FileDescriptorWatcher()
     : event_(NULL),
+      fd_(-1),
+      mode_(0),
+      persistent_(false),
+      poll_id_(0),
       pump_(NULL),
       watcher_(NULL),
       was_destroyed_(NULL) {
 }
 
 MessagePumpLibevent::FileDescriptorWatcher::~FileDescriptorWatcher() {
-  if (event_) {
+  if (event_ || fd_ >= 0) {
     StopWatchingFileDescriptor();
   }
   if (was_destroyed_) {
@@ -61,6 +85,19 @@ MessagePumpLibevent::FileDescriptorWatcher::~FileDescriptorWatcher() {
 }
 
 bool MessagePumpLibevent::FileDescriptorWatcher::StopWatchingFileDescriptor() {
+#if defined(OS_LINUX)
+  if (fd_ >= 0) {
+    if (poll_id_)
+      pump_->RemoveIOUringPoll(this);
+    fd_ = -1;
+    mode_ = 0;
+    persistent_ = false;
+    pump_ = NULL;
+    watcher_ = NULL;
+    return true;
+  }
+#endif
+
   event* e = ReleaseEvent();
   if (e == NULL)
     return true;
@@ -102,21 +139,25 @@ void MessagePumpLibevent::FileDescriptorWatcher::OnFileCanWriteWithoutBlocking(
 }
 
 MessagePumpLibevent::MessagePumpLibevent()
+    : MessagePumpLibevent(Backend::LIBEVENT) {}
+
+MessagePumpLibevent::MessagePumpLibevent(Backend backend)
     : keep_running_(true),
       in_run_(false),
       processed_io_events_(false),
-      event_base_(event_base_new()),
+      event_base_(NULL),
       wakeup_pipe_in_(-1),
-      wakeup_pipe_out_(-1) {
-  if (!Init())
+      wakeup_pipe_out_(-1),
+      wakeup_event_(NULL) {
+  if (!Init(backend))
      NOTREACHED();
 }
 
 MessagePumpLibevent::~MessagePumpLibevent() {
-  DCHECK(wakeup_event_);
-  DCHECK(event_base_);
-  event_del(wakeup_event_);
-  delete wakeup_event_;
+  if (wakeup_event_) {
+    event_del(wakeup_event_);
+    delete wakeup_event_;
+  }
   if (wakeup_pipe_in_ >= 0) {
     if (IGNORE_EINTR(close(wakeup_pipe_in_)) < 0)
       DPLOG(ERROR) << "close";
@@ -125,7 +166,16 @@ MessagePumpLibevent::~MessagePumpLibevent() {
     if (IGNORE_EINTR(close(wakeup_pipe_out_)) < 0)
       DPLOG(ERROR) << "close";
   }
-  event_base_free(event_base_);
+  if (event_base_)
+    event_base_free(event_base_);
+}
+
+MessagePumpLibevent::Backend MessagePumpLibevent::backend() const {
+#if defined(OS_LINUX)
+  if (io_uring_poller_)
+    return Backend::IO_URING;
+#endif
+  return Backend::LIBEVENT;
 }
 
 bool MessagePumpLibevent::WatchFileDescriptor(int fd,
@@ -141,6 +191,31 @@ bool MessagePumpLibevent::WatchFileDescriptor(int fd,
   // threadsafe, and your watcher may never be registered.
   DCHECK(watch_file_descriptor_caller_checker_.CalledOnValidThread());
 
+#if defined(OS_LINUX)
+  if (io_uring_poller_) {
+    if (controller->fd_ >= 0) {
+      // It's illegal to use this function to listen on 2 separate fds with the
+      // same |controller|.
+      if (controller->fd_ != fd) {
+        NOTREACHED() << "FDs don't match" << controller->fd_ << "!=" << fd;
+        return false;
+      }
+      // Combine old/new interests, and replace the armed poll request.
+      mode |= controller->mode_;
+      persistent |= controller->persistent_;
+      if (controller->poll_id_)
+        RemoveIOUringPoll(controller);
+    }
+    controller->fd_ = fd;
+    controller->mode_ = mode;
+    controller->persistent_ = persistent;
+    controller->set_watcher(delegate);
+    controller->set_pump(this);
+    AddIOUringPoll(controller);
+    return true;
+  }
+#endif
+
   int event_mask = persistent ? EV_PERSIST : 0;
   if (mode & WATCH_READ) {
     event_mask |= EV_READ;
@@ -218,7 +293,12 @@ void MessagePumpLibevent::Run(Delegate* delegate) {
     if (!keep_running_)
       break;
 
-    event_base_loop(event_base_, EVLOOP_NONBLOCK);
+#if defined(OS_LINUX)
+    if (io_uring_poller_)
+      ProcessIOUringEvents(TimeDelta());
+    else
+#endif
+      event_base_loop(event_base_, EVLOOP_NONBLOCK);
     did_work |= processed_io_events_;
     processed_io_events_ = false;
     if (!keep_running_)
@@ -241,10 +321,23 @@ void MessagePumpLibevent::Run(Delegate* delegate) {
     // EVLOOP_ONCE tells libevent to only block once,
     // but to service all pending events when it wakes up.
     if (delayed_work_time_.is_null()) {
-      event_base_loop(event_base_, EVLOOP_ONCE);
+#if defined(OS_LINUX)
+      if (io_uring_poller_)
+        ProcessIOUringEvents(TimeDelta::Max());
+      else
+#endif
+        event_base_loop(event_base_, EVLOOP_ONCE);
     } else {
       TimeDelta delay = delayed_work_time_ - TimeTicks::Now();
-      if (delay > TimeDelta()) {
+      if (delay <= TimeDelta()) {
+        // It looks like delayed_work_time_ indicates a time in the past, so we
+        // need to call DoDelayedWork now.
+        delayed_work_time_ = TimeTicks();
+#if defined(OS_LINUX)
+      } else if (io_uring_poller_) {
+        ProcessIOUringEvents(delay);
+#endif
+      } else {
         struct timeval poll_tv;
         poll_tv.tv_sec = delay.InSeconds();
         poll_tv.tv_usec = delay.InMicroseconds() % Time::kMicrosecondsPerSecond;
@@ -253,10 +346,6 @@ void MessagePumpLibevent::Run(Delegate* delegate) {
         event_add(timer_event.get(), &poll_tv);
         event_base_loop(event_base_, EVLOOP_ONCE);
         event_del(timer_event.get());
-      } else {
-        // It looks like delayed_work_time_ indicates a time in the past, so we
-        // need to call DoDelayedWork now.
-        delayed_work_time_ = TimeTicks();
       }
     }
 
@@ -288,7 +377,7 @@ void MessagePumpLibevent::ScheduleDelayedWork(
   delayed_work_time_ = delayed_work_time;
 }
 
-bool MessagePumpLibevent::Init() {
+bool MessagePumpLibevent::Init(Backend backend) {
   int fds[2];
   if (pipe(fds)) {
     DLOG(ERROR) << "pipe() failed, errno: " << errno;
@@ -305,6 +394,18 @@ bool MessagePumpLibevent::Init() {
   wakeup_pipe_out_ = fds[0];
   wakeup_pipe_in_ = fds[1];
 
+#if defined(OS_LINUX)
+  if (backend == Backend::IO_URING) {
+    io_uring_poller_ = internal::IOUringPoller::Create(kIOUringEntries);
+    if (io_uring_poller_) {
+      next_io_uring_poll_id_ = kFirstWatcherPollId;
+      io_uring_poller_->AddPoll(wakeup_pipe_out_, POLLIN, kWakeupPollId);
+      return true;
+    }
+  }
+#endif
+
+  event_base_ = event_base_new();
   wakeup_event_ = new event;
   event_set(wakeup_event_, wakeup_pipe_out_, EV_READ | EV_PERSIST,
             OnWakeup, this);
@@ -325,23 +426,31 @@ void MessagePumpLibevent::OnLibeventNotification(int fd,
   TRACE_EVENT1("toplevel", "MessagePumpLibevent::OnLibeventNotification",
                "fd", fd);
 
-  MessagePumpLibevent* pump = controller->pump();
-  pump->processed_io_events_ = true;
+  controller->pump()->OnFileDescriptorReady(
+      controller, fd, (flags & EV_READ) != 0, (flags & EV_WRITE) != 0);
+}
+
+void MessagePumpLibevent::OnFileDescriptorReady(
+    FileDescriptorWatcher* controller,
+    int fd,
+    bool can_read,
+    bool can_write) {
+  processed_io_events_ = true;
 
-  if ((flags & (EV_READ | EV_WRITE)) == (EV_READ | EV_WRITE)) {
+  if (can_read && can_write) {
     // Both callbacks will be called. It is necessary to check that |controller|
     // is not destroyed.
     bool controller_was_destroyed = false;
     controller->was_destroyed_ = &controller_was_destroyed;
-    controller->OnFileCanWriteWithoutBlocking(fd, pump);
+    controller->OnFileCanWriteWithoutBlocking(fd, this);
     if (!controller_was_destroyed)
-      controller->OnFileCanReadWithoutBlocking(fd, pump);
+      controller->OnFileCanReadWithoutBlocking(fd, this);
     if (!controller_was_destroyed)
       controller->was_destroyed_ = nullptr;
-  } else if (flags & EV_WRITE) {
-    controller->OnFileCanWriteWithoutBlocking(fd, pump);
-  } else if (flags & EV_READ) {
-    controller->OnFileCanReadWithoutBlocking(fd, pump);
+  } else if (can_write) {
+    controller->OnFileCanWriteWithoutBlocking(fd, this);
+  } else if (can_read) {
+    controller->OnFileCanReadWithoutBlocking(fd, this);
   }
 }
 
@@ -360,4 +469,80 @@ void MessagePumpLibevent::OnWakeup(int socket, short flags, void* context) {
   event_base_loopbreak(that->event_base_);
 }
 
+#if defined(OS_LINUX)
+void MessagePumpLibevent::AddIOUringPoll(FileDescriptorWatcher* controller) {
+  if (!controller->poll_id_) {
+    controller->poll_id_ = next_io_uring_poll_id_++;
+    io_uring_watchers_[controller->poll_id_] = controller;
+  }
+  uint32_t poll_mask = 0;
+  if (controller->mode_ & WATCH_READ)
+    poll_mask |= POLLIN;
+  if (controller->mode_ & WATCH_WRITE)
+    poll_mask |= POLLOUT;
+  io_uring_poller_->AddPoll(controller->fd_, poll_mask, controller->poll_id_);
+}
+
+void MessagePumpLibevent::RemoveIOUringPoll(FileDescriptorWatcher* controller) {
+  DCHECK(controller->poll_id_);
+  // A completion of the cancelled request is ignored, since its id is no
+  // longer mapped to a watcher.
+  io_uring_poller_->RemovePoll(controller->poll_id_);
+  io_uring_watchers_.erase(controller->poll_id_);
+  controller->poll_id_ = 0;
+}
+
+void MessagePumpLibevent::ProcessIOUringEvents(TimeDelta timeout) {
+  // Callbacks may run a nested loop, which then uses a vector of its own.
+  std::vector<internal::IOUringPoller::Completion> completions;
+  completions.swap(io_uring_completions_);
+  if (!io_uring_poller_->SubmitAndWait(timeout, &completions))
+    return;
+
+  for (const internal::IOUringPoller::Completion& completion : completions) {
+    if (completion.user_data == kWakeupPollId) {
+      // Remove and discard the wakeup bytes.
+      char buf[16];
+      while (HANDLE_EINTR(read(wakeup_pipe_out_, buf, sizeof(buf))) > 0) {
+      }
+      processed_io_events_ = true;
+      io_uring_poller_->AddPoll(wakeup_pipe_out_, POLLIN, kWakeupPollId);
+      continue;
+    }
+
+    // Completions of polls cancelled since they were queued are ignored.
+    auto it = io_uring_watchers_.find(completion.user_data);
+    if (it == io_uring_watchers_.end())
+      continue;
+    FileDescriptorWatcher* controller = it->second;
+    const int fd = controller->fd_;
+    TRACE_EVENT1("toplevel", "MessagePumpLibevent::ProcessIOUringEvents",
+                 "fd", fd);
+
+    // Persistent watchers are re-armed before their callbacks run, so that
+    // the callbacks can stop watching. The new requests are submitted with
+    // the next wait.
+    if (controller->persistent_) {
+      AddIOUringPoll(controller);
+    } else {
+      io_uring_watchers_.erase(it);
+      controller->poll_id_ = 0;
+    }
+
+    // A failed poll request is reported as an error condition on |fd|, which
+    // wakes up both readers and writers, as with libevent.
+    const int32_t events = completion.result < 0 ? POLLERR : completion.result;
+    const bool can_read = (controller->mode_ & WATCH_READ) &&
+                          (events & (POLLIN | POLLHUP | POLLERR));
+    const bool can_write = (controller->mode_ & WATCH_WRITE) &&
+                           (events & (POLLOUT | POLLHUP | POLLERR));
+    OnFileDescriptorReady(controller, fd, can_read, can_write);
+  }
+
+  completions.clear();
+  if (io_uring_completions_.capacity() < completions.capacity())
+    io_uring_completions_.swap(completions);
+}
+#endif  // defined(OS_LINUX)
+
 }  // namespace base
@@ -5,11 +5,23 @@
 #ifndef BASE_MESSAGE_LOOP_MESSAGE_PUMP_LIBEVENT_H_
 #define BASE_MESSAGE_LOOP_MESSAGE_PUMP_LIBEVENT_H_
 
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/macros.h"
 #include "base/message_loop/message_pump.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX)
+#include "base/message_loop/io_uring_poller_linux.h"
+#endif
 
 // Declare structs we need from libevent.h rather than including it
 struct event_base;
@@ -17,6 +29,12 @@ struct event;
 
 namespace base {
 
+#if defined(OS_LINUX)
+// Makes MessageLoop::TYPE_IO loops wait for file descriptor readiness through
+// io_uring instead of libevent, when the kernel supports it.
+BASE_EXPORT extern const Feature kMessagePumpIOUringFeature;
+#endif
+
 // Class to monitor sockets and issue callbacks when sockets are ready for I/O
 // TODO(dkegel): add support for background file IO somehow
 class BASE_EXPORT MessagePumpLibevent : public MessagePump {
@@ -66,7 +84,16 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump {
     void OnFileCanReadWithoutBlocking(int fd, MessagePumpLibevent* pump);
     void OnFileCanWriteWithoutBlocking(int fd, MessagePumpLibevent* pump);
 
+    // Used with the libevent backend.
     event* event_;
+
+    // Used with the io_uring backend. |fd_| is -1 when not watching. |poll_id_|
+    // identifies the poll request armed for |fd_|, and is 0 when none is.
+    int fd_;
+    int mode_;
+    bool persistent_;
+    uint64_t poll_id_;
+
     MessagePumpLibevent* pump_;
     Watcher* watcher_;
     // If this pointer is non-NULL, the pointee is set to true in the
@@ -82,9 +109,22 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump {
     WATCH_READ_WRITE = WATCH_READ | WATCH_WRITE
   };
 
+  // Mechanism used to wait for file descriptor readiness.
+  enum class Backend {
+    LIBEVENT,
+    // Only available on Linux 5.11 and later. MessagePumpLibevent falls back
+    // to LIBEVENT elsewhere.
+    IO_URING,
+  };
+
   MessagePumpLibevent();
+  explicit MessagePumpLibevent(Backend backend);
   ~MessagePumpLibevent() override;
 
+  // Returns the backend in use, which is LIBEVENT if IO_URING was requested
+  // but is not supported.
+  Backend backend() const;
+
   // Have the current thread's message loop watch for a a situation in which
   // reading/writing to the FD can be performed without blocking.
   // Callers must provide a preallocated FileDescriptorWatcher object which
@@ -116,7 +156,28 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump {
   void DidProcessIOEvent();
 
   // Risky part of constructor.  Returns true on success.
-  bool Init();
+  bool Init(Backend backend);
+
+  // Runs the callbacks of |controller| for the readiness of |fd|.
+  void OnFileDescriptorReady(FileDescriptorWatcher* controller,
+                             int fd,
+                             bool can_read,
+                             bool can_write);
+
+#if defined(OS_LINUX)
+  // Arms a one-shot poll request for the file descriptor watched by
+  // |controller|, with the io_uring backend.
+  void AddIOUringPoll(FileDescriptorWatcher* controller);
+
+  // Cancels the poll request armed for |controller|, with the io_uring
+  // backend.
+  void RemoveIOUringPoll(FileDescriptorWatcher* controller);
+
+  // Submits the pending poll requests and runs the callbacks of the file
+  // descriptors that are ready, waiting up to |timeout| for one to be. Used
+  // instead of event_base_loop() with the io_uring backend.
+  void ProcessIOUringEvents(TimeDelta timeout);
+#endif
 
   // Called by libevent to tell us a registered FD can be read/written to.
   static void OnLibeventNotification(int fd, short flags,
@@ -149,6 +210,20 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump {
   // ... libevent wrapper for read end
   event* wakeup_event_;
 
+#if defined(OS_LINUX)
+  // io_uring backend. Null when libevent is used.
+  std::unique_ptr<internal::IOUringPoller> io_uring_poller_;
+
+  // Watchers with an armed poll request, by poll id.
+  std::unordered_map<uint64_t, FileDescriptorWatcher*> io_uring_watchers_;
+
+  // Id of the next poll request.
+  uint64_t next_io_uring_poll_id_;
+
+  // Completions reaped by ProcessIOUringEvents(), kept to reuse the storage.
+  std::vector<internal::IOUringPoller::Completion> io_uring_completions_;
+#endif
+
   ThreadChecker watch_file_descriptor_caller_checker_;
   DISALLOW_COPY_AND_ASSIGN(MessagePumpLibevent);
 };
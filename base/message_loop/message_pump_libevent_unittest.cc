@@ -6,7 +6,10 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
@@ -22,6 +25,12 @@
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+#if defined(OS_LINUX)
+#include <poll.h>
+
+#include "base/message_loop/io_uring_poller_linux.h"
+#endif
+
 namespace base {
 
 class MessagePumpLibeventTest : public testing::Test {
@@ -275,6 +284,119 @@ TEST_F(MessagePumpLibeventTest, QuitWatcher) {
                                       Owned(watcher.release())));
 }
 
+#if defined(OS_LINUX)
+
+// Returns a pump using io_uring, or nullptr if io_uring is not supported.
+std::unique_ptr<MessagePumpLibevent> CreateIOUringPump() {
+  std::unique_ptr<MessagePumpLibevent> pump(
+      new MessagePumpLibevent(MessagePumpLibevent::Backend::IO_URING));
+  if (pump->backend() != MessagePumpLibevent::Backend::IO_URING)
+    return nullptr;
+  return pump;
+}
+
+// Reads one byte per notification, and stops watching and quits |run_loop|
+// after |num_reads| reads.
+class ReadBytesWatcher : public BaseWatcher {
+ public:
+  ReadBytesWatcher(MessagePumpLibevent::FileDescriptorWatcher* controller,
+                   int num_reads,
+                   RunLoop* run_loop)
+      : BaseWatcher(controller), num_reads_(num_reads), run_loop_(run_loop) {}
+  ~ReadBytesWatcher() override {}
+
+  int num_reads() const { return num_reads_; }
+
+  void OnFileCanReadWithoutBlocking(int fd) override {
+    char buf;
+    ASSERT_EQ(1, HANDLE_EINTR(read(fd, &buf, 1)));
+    if (--num_reads_ > 0)
+      return;
+    controller_->StopWatchingFileDescriptor();
+    run_loop_->Quit();
+  }
+
+ private:
+  int num_reads_;
+  RunLoop* run_loop_;  // weak
+};
+
+// Tests that a persistent watcher keeps being notified with io_uring.
+TEST_F(MessagePumpLibeventTest, IOUringPersistentWatcher) {
+  std::unique_ptr<MessagePumpLibevent> pump = CreateIOUringPump();
+  if (!pump)
+    return;
+  MessagePumpLibevent* pump_ptr = pump.get();
+  ui_loop_.reset();
+  MessageLoop loop(std::move(pump));
+  RunLoop run_loop;
+  MessagePumpLibevent::FileDescriptorWatcher controller;
+  ReadBytesWatcher delegate(&controller, 3, &run_loop);
+
+  const char buf[3] = {0, 1, 2};
+  ASSERT_TRUE(WriteFileDescriptor(pipefds_[1], buf, sizeof(buf)));
+  ASSERT_TRUE(pump_ptr->WatchFileDescriptor(pipefds_[0], true,
+                                            MessagePumpLibevent::WATCH_READ,
+                                            &controller, &delegate));
+  run_loop.Run();
+  EXPECT_EQ(0, delegate.num_reads());
+}
+
+// Tests that no notification is received with io_uring once a watcher has
+// stopped watching, even if its poll request was already submitted.
+TEST_F(MessagePumpLibeventTest, IOUringStopWatching) {
+  std::unique_ptr<MessagePumpLibevent> pump = CreateIOUringPump();
+  if (!pump)
+    return;
+  MessagePumpLibevent* pump_ptr = pump.get();
+  ui_loop_.reset();
+  MessageLoop loop(std::move(pump));
+  MessagePumpLibevent::FileDescriptorWatcher controller;
+  BaseWatcher delegate(&controller);
+
+  ASSERT_TRUE(pump_ptr->WatchFileDescriptor(pipefds_[0], true,
+                                            MessagePumpLibevent::WATCH_READ,
+                                            &controller, &delegate));
+  // Submit the poll request.
+  RunLoop().RunUntilIdle();
+  controller.StopWatchingFileDescriptor();
+
+  const char buf = 0;
+  ASSERT_TRUE(WriteFileDescriptor(pipefds_[1], &buf, 1));
+  RunLoop().RunUntilIdle();
+}
+
+// Tests that requests which don't fit in the submission ring are submitted
+// later instead of being lost.
+TEST_F(MessagePumpLibeventTest, IOUringPollerQueuesMoreRequestsThanEntries) {
+  const uint32_t kNumEntries = 2;
+  std::unique_ptr<internal::IOUringPoller> poller =
+      internal::IOUringPoller::Create(kNumEntries);
+  if (!poller)
+    return;
+
+  const char buf = 0;
+  ASSERT_TRUE(WriteFileDescriptor(pipefds_[1], &buf, 1));
+  const uint64_t kNumPolls = 4 * kNumEntries;
+  for (uint64_t i = 1; i <= kNumPolls; ++i)
+    poller->AddPoll(pipefds_[0], POLLIN, i);
+
+  std::vector<internal::IOUringPoller::Completion> completions;
+  while (completions.size() < kNumPolls)
+    ASSERT_TRUE(poller->SubmitAndWait(TimeDelta::Max(), &completions));
+  ASSERT_EQ(kNumPolls, completions.size());
+  std::vector<uint64_t> user_data;
+  for (const internal::IOUringPoller::Completion& completion : completions) {
+    EXPECT_EQ(POLLIN, completion.result & POLLIN);
+    user_data.push_back(completion.user_data);
+  }
+  std::sort(user_data.begin(), user_data.end());
+  for (uint64_t i = 1; i <= kNumPolls; ++i)
+    EXPECT_EQ(i, user_data[i - 1]);
+}
+
+#endif  // defined(OS_LINUX)
+
 }  // namespace
 
 }  // namespace base
@@ -5,10 +5,18 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "base/bind.h"
 #include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
@@ -23,6 +31,16 @@
 #include "base/android/java_handler_thread.h"
 #endif
 
+#if defined(OS_LINUX)
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/message_loop/message_pump_libevent.h"
+#include "base/posix/eintr_wrapper.h"
+#endif
+
 namespace base {
 
 class ScheduleWorkTest : public testing::Test {
@@ -302,4 +320,99 @@ TEST_F(PostTaskTest, OneHundredTasksPerReload) {
   Run(1000, 100);
 }
 
+#if defined(OS_LINUX)
+// Reads one byte whenever its file descriptor becomes readable and writes it
+// back, so that the byte bounces between the two ends of a socket pair.
+class PingPongWatcher : public MessagePumpLibevent::Watcher {
+ public:
+  PingPongWatcher(uint64_t* num_events, uint64_t max_events, RunLoop* run_loop)
+      : num_events_(num_events),
+        max_events_(max_events),
+        run_loop_(run_loop) {}
+  ~PingPongWatcher() override {}
+
+  MessagePumpLibevent::FileDescriptorWatcher* controller() {
+    return &controller_;
+  }
+
+  // MessagePumpLibevent::Watcher:
+  void OnFileCanReadWithoutBlocking(int fd) override {
+    char buf;
+    CHECK_EQ(1, HANDLE_EINTR(read(fd, &buf, 1)));
+    if (++*num_events_ == max_events_)
+      run_loop_->Quit();
+    CHECK_EQ(1, HANDLE_EINTR(write(fd, &buf, 1)));
+  }
+  void OnFileCanWriteWithoutBlocking(int fd) override {}
+
+ private:
+  MessagePumpLibevent::FileDescriptorWatcher controller_;
+  uint64_t* const num_events_;
+  const uint64_t max_events_;
+  RunLoop* const run_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(PingPongWatcher);
+};
+
+class FileDescriptorWatcherPerfTest : public testing::Test {
+ public:
+  // Bounces one byte over each of |num_socket_pairs| socket pairs until
+  // |kNumEvents| read notifications are delivered by a pump using |backend|.
+  void Run(MessagePumpLibevent::Backend backend, size_t num_socket_pairs) {
+    MessagePumpLibevent* pump = new MessagePumpLibevent(backend);
+    if (pump->backend() != backend) {
+      LOG(WARNING) << "io_uring is not supported, skipping.";
+      delete pump;
+      return;
+    }
+    MessageLoop loop(WrapUnique(pump));
+    RunLoop run_loop;
+    uint64_t num_events = 0;
+    std::vector<ScopedFD> fds;
+    std::vector<std::unique_ptr<PingPongWatcher>> watchers;
+    for (size_t i = 0; i < num_socket_pairs; ++i) {
+      int pair[2];
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+      for (int fd : pair) {
+        fds.push_back(ScopedFD(fd));
+        watchers.push_back(WrapUnique(
+            new PingPongWatcher(&num_events, kNumEvents, &run_loop)));
+        ASSERT_TRUE(pump->WatchFileDescriptor(
+            fd, true, MessagePumpLibevent::WATCH_READ,
+            watchers.back()->controller(), watchers.back().get()));
+      }
+      const char buf = 0;
+      ASSERT_TRUE(WriteFileDescriptor(pair[0], &buf, 1));
+    }
+
+    const TimeTicks start = TimeTicks::Now();
+    run_loop.Run();
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    std::string trace = StringPrintf(
+        "%s_%" PRIuS "_socket_pairs",
+        backend == MessagePumpLibevent::Backend::IO_URING ? "io_uring"
+                                                          : "libevent",
+        num_socket_pairs);
+    perf_test::PrintResult(
+        "fd_event", "", trace,
+        elapsed.InMicroseconds() / static_cast<double>(num_events),
+        "us/event", true);
+  }
+
+ private:
+  static const uint64_t kNumEvents = 500000;
+};
+
+TEST_F(FileDescriptorWatcherPerfTest, Libevent) {
+  Run(MessagePumpLibevent::Backend::LIBEVENT, 1);
+  Run(MessagePumpLibevent::Backend::LIBEVENT, 100);
+}
+
+TEST_F(FileDescriptorWatcherPerfTest, IOUring) {
+  Run(MessagePumpLibevent::Backend::IO_URING, 1);
+  Run(MessagePumpLibevent::Backend::IO_URING, 100);
+}
+#endif  // defined(OS_LINUX)
+
 }  // namespace base
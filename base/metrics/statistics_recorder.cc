@@ -5,8 +5,10 @@
 #include "base/metrics/statistics_recorder.h"
 
 #include <memory>
+#include <unordered_map>
 
 #include "base/at_exit.h"
+#include "base/compiler_specific.h"
 #include "base/debug/leak_annotations.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
@@ -17,6 +19,7 @@
 #include "base/stl_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/synchronization/read_write_lock.h"
 #include "base/values.h"
 
 namespace {
@@ -25,6 +28,78 @@ namespace {
 base::LazyInstance<base::StatisticsRecorder>::Leaky g_statistics_recorder_ =
     LAZY_INSTANCE_INITIALIZER;
 
+// Number of shards in HistogramIndex. Lookups of different names rarely land
+// on the same shard when there are many more shards than concurrent threads.
+const size_t kNumHistogramIndexShards = 64;
+
+// An index of registered histograms keyed by the hash of their name, split in
+// shards that each have their own reader-writer lock. It caches entries of
+// StatisticsRecorder::histograms_ so that looking up a histogram by name (e.g.
+// from Histogram::FactoryGet() when the static pointer of a histogram macro
+// isn't set) doesn't contend on the global lock. Histograms are never deleted
+// once registered, so a pointer returned by Find() remains valid after the
+// shard lock is released.
+class HistogramIndex {
+ public:
+  HistogramIndex() = default;
+
+  // Returns the histogram named |name|, whose name hash is |name_hash|, if it
+  // is in the index. Returns nullptr otherwise.
+  base::HistogramBase* Find(uint64_t name_hash, base::StringPiece name) {
+    Shard& shard = GetShard(name_hash);
+    base::subtle::AutoReadLock auto_lock(shard.lock);
+    auto it = shard.histograms.find(name_hash);
+    if (it == shard.histograms.end() || it->second->histogram_name() != name)
+      return nullptr;
+    return it->second;
+  }
+
+  // Adds |histogram| to the index. On the (unlikely) collision of the name
+  // hashes of two different histograms, the histogram already in the index is
+  // kept and the other one can only be found through the global map.
+  void Insert(uint64_t name_hash, base::HistogramBase* histogram) {
+    Shard& shard = GetShard(name_hash);
+    base::subtle::AutoWriteLock auto_lock(shard.lock);
+    shard.histograms.insert(std::make_pair(name_hash, histogram));
+  }
+
+  // Removes the histogram named |name| from the index, if present.
+  void Erase(uint64_t name_hash, base::StringPiece name) {
+    Shard& shard = GetShard(name_hash);
+    base::subtle::AutoWriteLock auto_lock(shard.lock);
+    auto it = shard.histograms.find(name_hash);
+    if (it != shard.histograms.end() && it->second->histogram_name() == name)
+      shard.histograms.erase(it);
+  }
+
+  // Removes all histograms from the index.
+  void Clear() {
+    for (Shard& shard : shards_) {
+      base::subtle::AutoWriteLock auto_lock(shard.lock);
+      shard.histograms.clear();
+    }
+  }
+
+ private:
+  // Aligned on a cache line so that threads using different shards don't
+  // write to the same cache line when they acquire a shard lock.
+  struct ALIGNAS(64) Shard {
+    base::subtle::ReadWriteLock lock;
+    std::unordered_map<uint64_t, base::HistogramBase*> histograms;
+  };
+
+  Shard& GetShard(uint64_t name_hash) {
+    return shards_[name_hash % kNumHistogramIndexShards];
+  }
+
+  Shard shards_[kNumHistogramIndexShards];
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramIndex);
+};
+
+base::LazyInstance<HistogramIndex>::Leaky g_histogram_index =
+    LAZY_INSTANCE_INITIALIZER;
+
 bool HistogramNameLesser(const base::HistogramBase* a,
                          const base::HistogramBase* b) {
   return a->histogram_name() < b->histogram_name();
@@ -118,6 +193,18 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
     return histogram;
   }
 
+  // Look for an identically named histogram in the index first, to avoid
+  // acquiring the global lock when |histogram| is a duplicate.
+  const uint64_t name_hash = histogram->name_hash();
+  DCHECK_EQ(HashMetricName(histogram->histogram_name()), name_hash);
+  HistogramBase* const indexed_histogram =
+      g_histogram_index.Get().Find(name_hash, histogram->histogram_name());
+  if (indexed_histogram) {
+    if (indexed_histogram != histogram)
+      delete histogram;
+    return indexed_histogram;
+  }
+
   HistogramBase* histogram_to_delete = NULL;
   HistogramBase* histogram_to_return = NULL;
   {
@@ -131,6 +218,7 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
         // The StringKey references the name within |histogram| rather than
         // making a copy.
         (*histograms_)[name] = histogram;
+        g_histogram_index.Get().Insert(name_hash, histogram);
         ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
         // If there are callbacks for this histogram, we set the kCallbackExists
         // flag.
@@ -144,11 +232,13 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
         histogram_to_return = histogram;
       } else if (histogram == it->second) {
         // The histogram was registered before.
+        g_histogram_index.Get().Insert(name_hash, histogram);
         histogram_to_return = histogram;
       } else {
         // We already have one histogram with this name.
         DCHECK_EQ(histogram->histogram_name(),
                   it->second->histogram_name()) << "hash collision";
+        g_histogram_index.Get().Insert(name_hash, it->second);
         histogram_to_return = it->second;
         histogram_to_delete = histogram;
       }
@@ -303,6 +393,15 @@ HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
 
   if (lock_ == NULL)
     return NULL;
+
+  // The index only contains histograms that are in |histograms_|, which makes
+  // it possible to return a histogram found in it without acquiring |lock_|.
+  const uint64_t name_hash = HashMetricName(name);
+  HistogramBase* const histogram =
+      g_histogram_index.Get().Find(name_hash, name);
+  if (histogram)
+    return histogram;
+
   base::AutoLock auto_lock(*lock_);
   if (histograms_ == NULL)
     return NULL;
@@ -310,6 +409,7 @@ HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
   HistogramMap::iterator it = histograms_->find(name);
   if (histograms_->end() == it)
     return NULL;
+  g_histogram_index.Get().Insert(name_hash, it->second);
   return it->second;
 }
 
@@ -417,8 +517,10 @@ size_t StatisticsRecorder::GetHistogramCount() {
 
 // static
 void StatisticsRecorder::ForgetHistogramForTesting(base::StringPiece name) {
-  if (histograms_)
+  if (histograms_) {
     histograms_->erase(name);
+    g_histogram_index.Get().Erase(HashMetricName(name), name);
+  }
 }
 
 // static
@@ -482,6 +584,9 @@ StatisticsRecorder::StatisticsRecorder() {
   callbacks_ = new CallbackMap;
   ranges_ = new RangesMap;
 
+  // Histograms of the previous StatisticsRecorder must not be found by name.
+  g_histogram_index.Get().Clear();
+
   if (VLOG_IS_ON(1))
     AtExitManager::RegisterCallback(&DumpHistogramsToVlog, this);
 }
@@ -505,6 +610,7 @@ void StatisticsRecorder::Reset() {
     histograms_ = NULL;
     callbacks_ = NULL;
     ranges_ = NULL;
+    g_histogram_index.Get().Clear();
   }
   // We are going to leak the histograms and the ranges.
 }
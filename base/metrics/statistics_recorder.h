@@ -133,7 +133,9 @@ class BASE_EXPORT StatisticsRecorder {
   static void GetBucketRanges(std::vector<const BucketRanges*>* output);
 
   // Find a histogram by name. It matches the exact name. This method is thread
-  // safe.  It returns NULL if a matching histogram is not found.
+  // safe.  It returns NULL if a matching histogram is not found. Lookups of
+  // registered histograms go through a sharded index and don't acquire the
+  // global lock, so concurrent calls don't contend with each other.
   static HistogramBase* FindHistogram(base::StringPiece name);
 
   // Support for iterating over known histograms.
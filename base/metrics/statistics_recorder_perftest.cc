@@ -0,0 +1,140 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/statistics_recorder.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+
+namespace {
+
+// Number of registered histograms. Lookups cycle through all of them.
+const size_t kNumHistograms = 1000;
+
+// Number of lookups done by each thread.
+const size_t kNumLookupsPerThread = 200000;
+
+// How histograms are looked up by a thread.
+enum class LookupMethod {
+  FIND_HISTOGRAM,
+  FACTORY_GET,
+};
+
+// Waits for |start_event| and then looks up |kNumLookupsPerThread| histograms
+// by name.
+class HistogramLookupThread : public SimpleThread {
+ public:
+  HistogramLookupThread(const std::vector<std::string>& names,
+                        LookupMethod lookup_method,
+                        WaitableEvent* start_event)
+      : SimpleThread("HistogramLookupThread"),
+        names_(names),
+        lookup_method_(lookup_method),
+        start_event_(start_event) {}
+
+  // SimpleThread:
+  void Run() override {
+    start_event_->Wait();
+    for (size_t i = 0; i < kNumLookupsPerThread; ++i) {
+      const std::string& name = names_[i % names_.size()];
+      HistogramBase* histogram =
+          lookup_method_ == LookupMethod::FIND_HISTOGRAM
+              ? StatisticsRecorder::FindHistogram(name)
+              : Histogram::FactoryGet(name, 1, 1000, 50,
+                                      HistogramBase::kNoFlags);
+      CHECK(histogram);
+    }
+  }
+
+ private:
+  const std::vector<std::string>& names_;
+  const LookupMethod lookup_method_;
+  WaitableEvent* const start_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramLookupThread);
+};
+
+class StatisticsRecorderPerfTest : public testing::Test {
+ protected:
+  StatisticsRecorderPerfTest() {
+    StatisticsRecorder::UninitializeForTesting();
+    statistics_recorder_ = StatisticsRecorder::CreateTemporaryForTesting();
+    for (size_t i = 0; i < kNumHistograms; ++i) {
+      names_.push_back("PerfTest.Histogram" + SizeTToString(i));
+      Histogram::FactoryGet(names_.back(), 1, 1000, 50,
+                            HistogramBase::kNoFlags);
+    }
+  }
+
+  ~StatisticsRecorderPerfTest() override {
+    statistics_recorder_.reset();
+    StatisticsRecorder::UninitializeForTesting();
+  }
+
+  // Looks up histograms from |num_threads| concurrent threads and prints the
+  // total number of lookups per second.
+  void RunLookupTest(const std::string& name,
+                     LookupMethod lookup_method,
+                     size_t num_threads) {
+    WaitableEvent start_event(WaitableEvent::ResetPolicy::MANUAL,
+                              WaitableEvent::InitialState::NOT_SIGNALED);
+    std::vector<std::unique_ptr<HistogramLookupThread>> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads.push_back(WrapUnique(
+          new HistogramLookupThread(names_, lookup_method, &start_event)));
+      threads.back()->Start();
+    }
+
+    const TimeTicks start = TimeTicks::Now();
+    start_event.Signal();
+    for (const auto& thread : threads)
+      thread->Join();
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    perf_test::PrintResult(
+        "histogram_lookup", "", StringPrintf("%s_%" PRIuS "_threads",
+                                             name.c_str(), num_threads),
+        num_threads * kNumLookupsPerThread / elapsed.InSecondsF(),
+        "lookups/s", true);
+  }
+
+ private:
+  std::unique_ptr<StatisticsRecorder> statistics_recorder_;
+  std::vector<std::string> names_;
+
+  DISALLOW_COPY_AND_ASSIGN(StatisticsRecorderPerfTest);
+};
+
+const size_t kNumThreads[] = {1, 32};
+
+}  // namespace
+
+TEST_F(StatisticsRecorderPerfTest, FindHistogram) {
+  for (size_t num_threads : kNumThreads)
+    RunLookupTest("FindHistogram", LookupMethod::FIND_HISTOGRAM, num_threads);
+}
+
+TEST_F(StatisticsRecorderPerfTest, FactoryGet) {
+  for (size_t num_threads : kNumThreads)
+    RunLookupTest("FactoryGet", LookupMethod::FACTORY_GET, num_threads);
+}
+
+}  // namespace base
@@ -14,6 +14,8 @@
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/sparse_histogram.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -212,6 +214,68 @@ TEST_P(StatisticsRecorderTest, FindHistogram) {
   EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
 }
 
+TEST_P(StatisticsRecorderTest, ForgetHistogram) {
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 10, HistogramBase::kNoFlags);
+  EXPECT_EQ(histogram, StatisticsRecorder::FindHistogram("TestHistogram"));
+
+  StatisticsRecorder::ForgetHistogramForTesting("TestHistogram");
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
+  EXPECT_EQ(0u, StatisticsRecorder::GetHistogramCount());
+}
+
+namespace {
+
+// Looks up histograms named "TestHistogram0" to "TestHistogram<N-1>" through
+// FactoryGet() and FindHistogram() and verifies that the expected histograms
+// are returned.
+class HistogramLookupDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  explicit HistogramLookupDelegate(
+      const std::vector<HistogramBase*>& histograms)
+      : histograms_(histograms) {}
+
+  // DelegateSimpleThread::Delegate:
+  void Run() override {
+    for (int iteration = 0; iteration < 100; ++iteration) {
+      for (size_t i = 0; i < histograms_.size(); ++i) {
+        const std::string name = "TestHistogram" + SizeTToString(i);
+        EXPECT_EQ(histograms_[i],
+                  Histogram::FactoryGet(name, 1, 1000, 10,
+                                        HistogramBase::kNoFlags));
+        EXPECT_EQ(histograms_[i], StatisticsRecorder::FindHistogram(name));
+      }
+    }
+  }
+
+ private:
+  const std::vector<HistogramBase*>& histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramLookupDelegate);
+};
+
+}  // namespace
+
+TEST_P(StatisticsRecorderTest, LookupFromMultipleThreads) {
+  const size_t kNumHistograms = 100;
+  const int kNumThreads = 8;
+
+  std::vector<HistogramBase*> histograms;
+  for (size_t i = 0; i < kNumHistograms; ++i) {
+    histograms.push_back(
+        Histogram::FactoryGet("TestHistogram" + SizeTToString(i), 1, 1000, 10,
+                              HistogramBase::kNoFlags));
+  }
+
+  HistogramLookupDelegate delegate(histograms);
+  DelegateSimpleThreadPool pool("HistogramLookup", kNumThreads);
+  pool.AddWork(&delegate, kNumThreads);
+  pool.Start();
+  pool.JoinAll();
+
+  EXPECT_EQ(kNumHistograms, StatisticsRecorder::GetHistogramCount());
+}
+
 TEST_P(StatisticsRecorderTest, GetSnapshot) {
   Histogram::FactoryGet("TestHistogram1", 1, 1000, 10, Histogram::kNoFlags);
   Histogram::FactoryGet("TestHistogram2", 1, 1000, 10, Histogram::kNoFlags);
@@ -71,6 +71,7 @@ void PriorityQueue::Transaction::Push(
     const SequenceSortKey& sequence_sort_key) {
   DCHECK(CalledOnValidThread());
   outer_queue_->container_.emplace(std::move(sequence), sequence_sort_key);
+  subtle::NoBarrier_AtomicIncrement(&outer_queue_->num_sequences_, 1);
 }
 
 const SequenceSortKey& PriorityQueue::Transaction::PeekSortKey() const {
@@ -92,6 +93,7 @@ scoped_refptr<Sequence> PriorityQueue::Transaction::PopSequence() {
           outer_queue_->container_.top())
           .take_sequence();
   outer_queue_->container_.pop();
+  subtle::NoBarrier_AtomicIncrement(&outer_queue_->num_sequences_, -1);
   return sequence;
 }
 
@@ -108,6 +110,10 @@ PriorityQueue::PriorityQueue(const PriorityQueue* predecessor_priority_queue)
 
 PriorityQueue::~PriorityQueue() = default;
 
+bool PriorityQueue::HasSequencesHint() const {
+  return subtle::NoBarrier_Load(&num_sequences_) != 0;
+}
+
 std::unique_ptr<PriorityQueue::Transaction> PriorityQueue::BeginTransaction() {
   return WrapUnique(new Transaction(this));
 }
@@ -9,6 +9,7 @@
 #include <queue>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -84,6 +85,13 @@ class BASE_EXPORT PriorityQueue {
   // PriorityQueue.
   std::unique_ptr<Transaction> BeginTransaction();
 
+  // Returns true if this PriorityQueue contained Sequences at the end of the
+  // last Transaction that modified it. This doesn't begin a Transaction: the
+  // result may be stale by the time it is returned and must be confirmed within
+  // a Transaction before being relied upon. Used by threads that want to avoid
+  // contending on |container_lock_| when the queue is most likely empty.
+  bool HasSequencesHint() const;
+
   const SchedulerLock* container_lock() const { return &container_lock_; }
 
  private:
@@ -98,6 +106,10 @@ class BASE_EXPORT PriorityQueue {
 
   ContainerType container_;
 
+  // Number of Sequences in |container_|. Only modified within a Transaction,
+  // but can be read without one through HasSequencesHint().
+  subtle::Atomic32 num_sequences_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(PriorityQueue);
 };
 
@@ -83,6 +83,7 @@ TEST(TaskSchedulerPriorityQueueTest, PushPopPeek) {
 
   // Create a PriorityQueue and a Transaction.
   PriorityQueue pq;
+  EXPECT_FALSE(pq.HasSequencesHint());
   auto transaction(pq.BeginTransaction());
   EXPECT_TRUE(transaction->IsEmpty());
 
@@ -90,6 +91,7 @@ TEST(TaskSchedulerPriorityQueueTest, PushPopPeek) {
   // highest priority.
   transaction->Push(sequence_a, sort_key_a);
   EXPECT_EQ(sort_key_a, transaction->PeekSortKey());
+  EXPECT_TRUE(pq.HasSequencesHint());
 
   // Push |sequence_b| in the PriorityQueue. It becomes the sequence with the
   // highest priority.
@@ -124,6 +126,7 @@ TEST(TaskSchedulerPriorityQueueTest, PushPopPeek) {
   // Pop |sequence_d| from the PriorityQueue. It is now empty.
   EXPECT_EQ(sequence_d, transaction->PopSequence());
   EXPECT_TRUE(transaction->IsEmpty());
+  EXPECT_FALSE(pq.HasSequencesHint());
 }
 
 // Check that creating Transactions on the same thread for 2 unrelated
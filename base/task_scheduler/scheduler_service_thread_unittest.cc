@@ -56,6 +56,7 @@ class TaskSchedulerServiceThreadTest : public testing::Test {
     scheduler_thread_pool_ = SchedulerThreadPoolImpl::Create(
         "TestThreadPoolForSchedulerThread", ThreadPriority::BACKGROUND, 1u,
         SchedulerThreadPoolImpl::IORestriction::DISALLOWED,
+        SchedulerThreadPoolImpl::WorkStealing::DISABLED,
         Bind(&ReEnqueueSequenceCallback), &task_tracker_,
         &delayed_task_manager_);
     ASSERT_TRUE(scheduler_thread_pool_);
@@ -35,6 +35,11 @@ LazyInstance<ThreadLocalPointer<const SchedulerThreadPool>>::Leaky
 LazyInstance<ThreadLocalPointer<const SchedulerWorkerThread>>::Leaky
     tls_current_worker_thread = LAZY_INSTANCE_INITIALIZER;
 
+// Local PriorityQueue of the SchedulerWorkerThread that owns the current
+// thread, if any. Only set when the owning pool has work stealing enabled.
+LazyInstance<ThreadLocalPointer<PriorityQueue>>::Leaky
+    tls_local_priority_queue = LAZY_INSTANCE_INITIALIZER;
+
 // A task runner that runs tasks with the PARALLEL ExecutionMode.
 class SchedulerParallelTaskRunner : public TaskRunner {
  public:
@@ -184,8 +189,8 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
   // |re_enqueue_sequence_callback| is invoked when ReEnqueueSequence() is
   // called with a non-single-threaded Sequence. |shared_priority_queue| is a
   // PriorityQueue whose transactions may overlap with the worker thread's
-  // single-threaded PriorityQueue's transactions. |index| will be appended to
-  // this thread's name to uniquely identify it.
+  // local and single-threaded PriorityQueues' transactions. |index| will be
+  // appended to this thread's name to uniquely identify it.
   SchedulerWorkerThreadDelegateImpl(
       SchedulerThreadPoolImpl* outer,
       const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
@@ -197,6 +202,8 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
     return &single_threaded_priority_queue_;
   }
 
+  PriorityQueue* local_priority_queue() { return &local_priority_queue_; }
+
   // SchedulerWorkerThread::Delegate:
   void OnMainEntry(SchedulerWorkerThread* worker_thread) override;
   scoped_refptr<Sequence> GetWork(
@@ -205,9 +212,19 @@ class SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl
   TimeDelta GetSleepTimeout() override;
 
  private:
+  // Implementation of GetWork() when work stealing is enabled.
+  scoped_refptr<Sequence> GetWorkWithStealing(
+      SchedulerWorkerThread* worker_thread);
+
   SchedulerThreadPoolImpl* outer_;
   const ReEnqueueSequenceCallback re_enqueue_sequence_callback_;
 
+  // PriorityQueue in which the worker thread enqueues the Sequences it posts or
+  // re-enqueues when work stealing is enabled. Other worker threads of the pool
+  // steal from it when they run out of work. Unused when work stealing is
+  // disabled.
+  PriorityQueue local_priority_queue_;
+
   // Single-threaded PriorityQueue for the worker thread.
   PriorityQueue single_threaded_priority_queue_;
 
@@ -232,12 +249,13 @@ std::unique_ptr<SchedulerThreadPoolImpl> SchedulerThreadPoolImpl::Create(
     ThreadPriority thread_priority,
     size_t max_threads,
     IORestriction io_restriction,
+    WorkStealing work_stealing,
     const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
     TaskTracker* task_tracker,
     DelayedTaskManager* delayed_task_manager) {
   std::unique_ptr<SchedulerThreadPoolImpl> thread_pool(
-      new SchedulerThreadPoolImpl(name, io_restriction, task_tracker,
-                                  delayed_task_manager));
+      new SchedulerThreadPoolImpl(name, io_restriction, work_stealing,
+                                  task_tracker, delayed_task_manager));
   if (thread_pool->Initialize(thread_priority, max_threads,
                               re_enqueue_sequence_callback)) {
     return thread_pool;
@@ -293,6 +311,17 @@ scoped_refptr<TaskRunner> SchedulerThreadPoolImpl::CreateTaskRunnerWithTraits(
 void SchedulerThreadPoolImpl::ReEnqueueSequence(
     scoped_refptr<Sequence> sequence,
     const SequenceSortKey& sequence_sort_key) {
+  PriorityQueue* const local_priority_queue =
+      GetLocalPriorityQueueForCurrentThread();
+  if (local_priority_queue) {
+    // The current thread will get |sequence| from its local PriorityQueue when
+    // it calls GetWork(), unless an idle thread steals it first. There is no
+    // need to wake up another thread.
+    local_priority_queue->BeginTransaction()->Push(std::move(sequence),
+                                                   sequence_sort_key);
+    return;
+  }
+
   shared_priority_queue_.BeginTransaction()->Push(std::move(sequence),
                                                   sequence_sort_key);
 
@@ -345,14 +374,17 @@ void SchedulerThreadPoolImpl::PostTaskWithSequenceNow(
   DCHECK_LE(task->delayed_run_time, delayed_task_manager_->Now());
 
   // Because |worker_thread| belongs to this thread pool, we know that the type
-  // of its delegate is SchedulerWorkerThreadDelegateImpl.
-  PriorityQueue* const priority_queue =
+  // of its delegate is SchedulerWorkerThreadDelegateImpl. A Sequence that isn't
+  // bound to a worker thread goes to the local PriorityQueue of the current
+  // thread, if any, to avoid contention on |shared_priority_queue_|.
+  PriorityQueue* priority_queue =
       worker_thread
           ? static_cast<SchedulerWorkerThreadDelegateImpl*>(
                 worker_thread->delegate())
                 ->single_threaded_priority_queue()
-          : &shared_priority_queue_;
-  DCHECK(priority_queue);
+          : GetLocalPriorityQueueForCurrentThread();
+  if (!priority_queue)
+    priority_queue = &shared_priority_queue_;
 
   const bool sequence_was_empty = sequence->PushTask(std::move(task));
   if (sequence_was_empty) {
@@ -366,7 +398,9 @@ void SchedulerThreadPoolImpl::PostTaskWithSequenceNow(
     priority_queue->BeginTransaction()->Push(std::move(sequence),
                                              sequence_sort_key);
 
-    // Wake up a worker thread to process |sequence|.
+    // Wake up a worker thread to process |sequence|. If |sequence| was inserted
+    // in the local PriorityQueue of the current thread, the woken up thread
+    // will steal it unless the current thread gets to it first.
     if (worker_thread)
       worker_thread->WakeUp();
     else
@@ -382,7 +416,11 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
         int index)
     : outer_(outer),
       re_enqueue_sequence_callback_(re_enqueue_sequence_callback),
-      single_threaded_priority_queue_(shared_priority_queue),
+      local_priority_queue_(shared_priority_queue),
+      single_threaded_priority_queue_(
+          outer_->work_stealing_ == WorkStealing::ENABLED
+              ? &local_priority_queue_
+              : shared_priority_queue),
       index_(index) {}
 
 SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
@@ -404,6 +442,8 @@ void SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::OnMainEntry(
   DCHECK(!tls_current_thread_pool.Get().Get());
   tls_current_worker_thread.Get().Set(worker_thread);
   tls_current_thread_pool.Get().Set(outer_);
+  if (outer_->work_stealing_ == WorkStealing::ENABLED)
+    tls_local_priority_queue.Get().Set(&local_priority_queue_);
 
   ThreadRestrictions::SetIOAllowed(outer_->io_restriction_ ==
                                    IORestriction::ALLOWED);
@@ -414,6 +454,9 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::GetWork(
     SchedulerWorkerThread* worker_thread) {
   DCHECK(ContainsWorkerThread(outer_->worker_threads_, worker_thread));
 
+  if (outer_->work_stealing_ == WorkStealing::ENABLED)
+    return GetWorkWithStealing(worker_thread);
+
   scoped_refptr<Sequence> sequence;
   {
     std::unique_ptr<PriorityQueue::Transaction> shared_transaction(
@@ -465,6 +508,89 @@ SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::GetWork(
   return sequence;
 }
 
+scoped_refptr<Sequence>
+SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::GetWorkWithStealing(
+    SchedulerWorkerThread* worker_thread) {
+  scoped_refptr<Sequence> sequence;
+  {
+    // |shared_priority_queue_| is only inspected when it is likely to contain
+    // Sequences: in steady state, Sequences are posted from worker threads and
+    // go to local PriorityQueues, which keeps this thread from contending on
+    // the lock of |shared_priority_queue_|. A Sequence missed because of a
+    // stale hint is picked up before this thread goes idle (see below).
+    std::unique_ptr<PriorityQueue::Transaction> shared_transaction;
+    if (outer_->shared_priority_queue_.HasSequencesHint())
+      shared_transaction = outer_->shared_priority_queue_.BeginTransaction();
+    std::unique_ptr<PriorityQueue::Transaction> local_transaction(
+        local_priority_queue_.BeginTransaction());
+    std::unique_ptr<PriorityQueue::Transaction> single_threaded_transaction(
+        single_threaded_priority_queue_.BeginTransaction());
+
+    // Pop from the PriorityQueue whose top Sequence is the most important. On a
+    // tie, the single-threaded PriorityQueue is preferred, then the local
+    // PriorityQueue.
+    PriorityQueue::Transaction* best_transaction = nullptr;
+    for (PriorityQueue::Transaction* transaction :
+         {single_threaded_transaction.get(), local_transaction.get(),
+          shared_transaction.get()}) {
+      if (!transaction || transaction->IsEmpty())
+        continue;
+      if (!best_transaction ||
+          transaction->PeekSortKey() > best_transaction->PeekSortKey()) {
+        best_transaction = transaction;
+      }
+    }
+
+    if (best_transaction) {
+      sequence = best_transaction->PopSequence();
+      last_sequence_is_single_threaded_ =
+          best_transaction == single_threaded_transaction.get();
+    }
+  }
+
+  if (!sequence) {
+    sequence = outer_->StealSequence(static_cast<size_t>(index_));
+    last_sequence_is_single_threaded_ = false;
+  }
+
+  if (!sequence) {
+    std::unique_ptr<PriorityQueue::Transaction> shared_transaction(
+        outer_->shared_priority_queue_.BeginTransaction());
+    if (shared_transaction->IsEmpty()) {
+      // |shared_transaction| is kept alive while |worker_thread| is added to
+      // |idle_worker_threads_stack_| for the reason explained in GetWork().
+      // |local_priority_queue_| doesn't need to be checked again since only
+      // this thread inserts Sequences in it. A Sequence inserted in
+      // |single_threaded_priority_queue_| after it was checked above comes with
+      // a WakeUp() which prevents this thread from going to sleep.
+      outer_->AddToIdleWorkerThreadsStack(worker_thread);
+    } else {
+      sequence = shared_transaction->PopSequence();
+    }
+  }
+
+  if (!sequence) {
+    // A peer may have inserted a Sequence in its local PriorityQueue after
+    // StealSequence() checked it above, and then called WakeUpOneThread()
+    // before this thread was in |idle_worker_threads_stack_|. Without this
+    // second attempt, the Sequence would wait until the peer calls GetWork(),
+    // which never happens if the peer waits for the Sequence to run. A peer
+    // whose WakeUpOneThread() comes after this thread was added to
+    // |idle_worker_threads_stack_| wakes up an idle thread. A peer whose
+    // WakeUpOneThread() came before inserted its Sequence before this thread
+    // acquired |idle_worker_threads_stack_lock_|, so the Sequence is visible
+    // here, including to HasSequencesHint().
+    sequence = outer_->StealSequence(static_cast<size_t>(index_));
+    if (!sequence)
+      return nullptr;
+    last_sequence_is_single_threaded_ = false;
+  }
+  DCHECK(sequence);
+
+  outer_->RemoveFromIdleWorkerThreadsStack(worker_thread);
+  return sequence;
+}
+
 void SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
     ReEnqueueSequence(scoped_refptr<Sequence> sequence) {
   if (last_sequence_is_single_threaded_) {
@@ -488,10 +614,12 @@ TimeDelta SchedulerThreadPoolImpl::SchedulerWorkerThreadDelegateImpl::
 SchedulerThreadPoolImpl::SchedulerThreadPoolImpl(
     StringPiece name,
     IORestriction io_restriction,
+    WorkStealing work_stealing,
     TaskTracker* task_tracker,
     DelayedTaskManager* delayed_task_manager)
     : name_(name.as_string()),
       io_restriction_(io_restriction),
+      work_stealing_(work_stealing),
       idle_worker_threads_stack_lock_(shared_priority_queue_.container_lock()),
       idle_worker_threads_stack_cv_for_testing_(
           idle_worker_threads_stack_lock_.CreateConditionVariable()),
@@ -535,6 +663,41 @@ bool SchedulerThreadPoolImpl::Initialize(
   return !worker_threads_.empty();
 }
 
+PriorityQueue* SchedulerThreadPoolImpl::GetLocalPriorityQueueForCurrentThread()
+    const {
+  if (work_stealing_ == WorkStealing::DISABLED ||
+      tls_current_thread_pool.Get().Get() != this) {
+    return nullptr;
+  }
+  return tls_local_priority_queue.Get().Get();
+}
+
+scoped_refptr<Sequence> SchedulerThreadPoolImpl::StealSequence(
+    size_t thief_index) {
+  DCHECK_EQ(WorkStealing::ENABLED, work_stealing_);
+
+  // Visit the other worker threads starting with the one that follows the thief
+  // to spread steals evenly across victims.
+  const size_t num_worker_threads = worker_threads_.size();
+  for (size_t i = 1; i < num_worker_threads; ++i) {
+    SchedulerWorkerThread* const victim =
+        worker_threads_[(thief_index + i) % num_worker_threads].get();
+    PriorityQueue* const victim_priority_queue =
+        static_cast<SchedulerWorkerThreadDelegateImpl*>(victim->delegate())
+            ->local_priority_queue();
+
+    // Skip the lock of PriorityQueues that are most likely empty.
+    if (!victim_priority_queue->HasSequencesHint())
+      continue;
+
+    std::unique_ptr<PriorityQueue::Transaction> transaction(
+        victim_priority_queue->BeginTransaction());
+    if (!transaction->IsEmpty())
+      return transaction->PopSequence();
+  }
+  return nullptr;
+}
+
 void SchedulerThreadPoolImpl::WakeUpOneThread() {
   SchedulerWorkerThread* worker_thread;
   {
@@ -43,6 +43,19 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
     DISALLOWED,
   };
 
+  // Indicates how Sequences posted from the worker threads of a thread pool
+  // are distributed among them.
+  enum class WorkStealing {
+    // All Sequences that aren't bound to a worker thread go through the shared
+    // PriorityQueue.
+    DISABLED,
+    // Each worker thread owns a local PriorityQueue in which it enqueues the
+    // Sequences it posts or re-enqueues. Idle worker threads steal Sequences
+    // from the local PriorityQueues of other worker threads. The shared
+    // PriorityQueue only receives Sequences posted from outside the pool.
+    ENABLED,
+  };
+
   // Callback invoked when a Sequence isn't empty after a worker thread pops a
   // Task from it.
   using ReEnqueueSequenceCallback = Callback<void(scoped_refptr<Sequence>)>;
@@ -55,6 +68,8 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // Creates a SchedulerThreadPool labeled |name| with up to |max_threads|
   // threads of priority |thread_priority|. |io_restriction| indicates whether
   // Tasks on the constructed thread pool are allowed to make I/O calls.
+  // |work_stealing| indicates whether worker threads get work from per-thread
+  // PriorityQueues with stealing, in addition to the shared PriorityQueue.
   // |re_enqueue_sequence_callback| will be invoked after a thread of this
   // thread pool tries to run a Task. |task_tracker| is used to handle shutdown
   // behavior of Tasks. |delayed_task_manager| handles Tasks posted with a
@@ -65,6 +80,7 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
       ThreadPriority thread_priority,
       size_t max_threads,
       IORestriction io_restriction,
+      WorkStealing work_stealing,
       const ReEnqueueSequenceCallback& re_enqueue_sequence_callback,
       TaskTracker* task_tracker,
       DelayedTaskManager* delayed_task_manager);
@@ -94,6 +110,7 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
 
   SchedulerThreadPoolImpl(StringPiece name,
                           IORestriction io_restriction,
+                          WorkStealing work_stealing,
                           TaskTracker* task_tracker,
                           DelayedTaskManager* delayed_task_manager);
 
@@ -102,6 +119,16 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
       size_t max_threads,
       const ReEnqueueSequenceCallback& re_enqueue_sequence_callback);
 
+  // Returns the local PriorityQueue of the current thread if it is a worker
+  // thread of this pool and work stealing is enabled. Returns nullptr
+  // otherwise.
+  PriorityQueue* GetLocalPriorityQueueForCurrentThread() const;
+
+  // Pops a Sequence from the local PriorityQueue of a worker thread other than
+  // the one at index |thief_index| in |worker_threads_|. Returns nullptr if all
+  // other local PriorityQueues are empty.
+  scoped_refptr<Sequence> StealSequence(size_t thief_index);
+
   // Wakes up the last thread from this thread pool to go idle, if any.
   void WakeUpOneThread();
 
@@ -125,12 +152,18 @@ class BASE_EXPORT SchedulerThreadPoolImpl : public SchedulerThreadPool {
   // threaded TaskRunner returned by this pool.
   size_t next_worker_thread_index_ = 0;
 
-  // PriorityQueue from which all threads of this thread pool get work.
+  // PriorityQueue from which all threads of this thread pool get work. When
+  // work stealing is enabled, it only holds Sequences posted or re-enqueued
+  // from outside this thread pool.
   PriorityQueue shared_priority_queue_;
 
   // Indicates whether Tasks on this thread pool are allowed to make I/O calls.
   const IORestriction io_restriction_;
 
+  // Indicates whether worker threads have local PriorityQueues from which other
+  // worker threads can steal Sequences.
+  const WorkStealing work_stealing_;
+
   // Synchronizes access to |idle_worker_threads_stack_| and
   // |idle_worker_threads_stack_cv_for_testing_|. Has |shared_priority_queue_|'s
   // lock as its predecessor so that a thread can be pushed to
@@ -0,0 +1,140 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task_scheduler/scheduler_thread_pool_impl.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/format_macros.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task_runner.h"
+#include "base/task_scheduler/delayed_task_manager.h"
+#include "base/task_scheduler/sequence.h"
+#include "base/task_scheduler/sequence_sort_key.h"
+#include "base/task_scheduler/task_tracker.h"
+#include "base/task_scheduler/task_traits.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+using IORestriction = SchedulerThreadPoolImpl::IORestriction;
+using WorkStealing = SchedulerThreadPoolImpl::WorkStealing;
+
+// Total number of tasks run by each measurement.
+const int kNumTasks = 200000;
+
+// Number of independent chains of tasks per worker thread. Each task of a
+// chain posts the next task of the chain from a worker thread, which exercises
+// the path where work stealing keeps Sequences in local PriorityQueues.
+const size_t kNumChainsPerWorkerThread = 4;
+
+// Measures the throughput of a SchedulerThreadPoolImpl for an increasing number
+// of worker threads.
+class TaskSchedulerThreadPoolImplPerfTest : public testing::Test {
+ protected:
+  TaskSchedulerThreadPoolImplPerfTest()
+      : delayed_task_manager_(Bind(&DoNothing)),
+        all_tasks_ran_(WaitableEvent::ResetPolicy::MANUAL,
+                       WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  // Runs |kNumTasks| tasks on a thread pool with |num_worker_threads| threads
+  // and prints the number of tasks run per second.
+  void RunThroughputTest(size_t num_worker_threads,
+                         WorkStealing work_stealing) {
+    thread_pool_ = SchedulerThreadPoolImpl::Create(
+        "PerfTestThreadPool", ThreadPriority::NORMAL, num_worker_threads,
+        IORestriction::DISALLOWED, work_stealing,
+        Bind(&TaskSchedulerThreadPoolImplPerfTest::ReEnqueueSequenceCallback,
+             Unretained(this)),
+        &task_tracker_, &delayed_task_manager_);
+    ASSERT_TRUE(thread_pool_);
+
+    task_runner_ = thread_pool_->CreateTaskRunnerWithTraits(
+        TaskTraits(), ExecutionMode::PARALLEL);
+    subtle::NoBarrier_Store(&num_tasks_posted_, 0);
+    subtle::NoBarrier_Store(&num_tasks_ran_, 0);
+    all_tasks_ran_.Reset();
+
+    const TimeTicks start = TimeTicks::Now();
+    for (size_t i = 0; i < num_worker_threads * kNumChainsPerWorkerThread; ++i)
+      PostChainedTask();
+    all_tasks_ran_.Wait();
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+    thread_pool_->JoinForTesting();
+    task_runner_ = nullptr;
+    thread_pool_.reset();
+
+    perf_test::PrintResult(
+        "task_throughput",
+        work_stealing == WorkStealing::ENABLED ? "_work_stealing" : "_shared",
+        StringPrintf("%" PRIuS "_workers", num_worker_threads),
+        kNumTasks / elapsed.InSecondsF(), "tasks/s", true);
+  }
+
+ private:
+  // Posts a task that posts another task when it runs, until |kNumTasks| tasks
+  // have been posted.
+  void PostChainedTask() {
+    if (subtle::NoBarrier_AtomicIncrement(&num_tasks_posted_, 1) > kNumTasks)
+      return;
+    task_runner_->PostTask(
+        FROM_HERE, Bind(&TaskSchedulerThreadPoolImplPerfTest::RunChainedTask,
+                        Unretained(this)));
+  }
+
+  void RunChainedTask() {
+    PostChainedTask();
+    if (subtle::Barrier_AtomicIncrement(&num_tasks_ran_, 1) == kNumTasks)
+      all_tasks_ran_.Signal();
+  }
+
+  void ReEnqueueSequenceCallback(scoped_refptr<Sequence> sequence) {
+    const SequenceSortKey sort_key(sequence->GetSortKey());
+    thread_pool_->ReEnqueueSequence(std::move(sequence), sort_key);
+  }
+
+  TaskTracker task_tracker_;
+  DelayedTaskManager delayed_task_manager_;
+  std::unique_ptr<SchedulerThreadPoolImpl> thread_pool_;
+  scoped_refptr<TaskRunner> task_runner_;
+
+  subtle::Atomic32 num_tasks_posted_ = 0;
+  subtle::Atomic32 num_tasks_ran_ = 0;
+  WaitableEvent all_tasks_ran_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskSchedulerThreadPoolImplPerfTest);
+};
+
+const size_t kNumWorkerThreads[] = {1, 2, 4, 8, 16, 32, 64};
+
+}  // namespace
+
+TEST_F(TaskSchedulerThreadPoolImplPerfTest, SharedPriorityQueueThroughput) {
+  for (size_t num_worker_threads : kNumWorkerThreads)
+    RunThroughputTest(num_worker_threads, WorkStealing::DISABLED);
+}
+
+TEST_F(TaskSchedulerThreadPoolImplPerfTest, WorkStealingThroughput) {
+  for (size_t num_worker_threads : kNumWorkerThreads)
+    RunThroughputTest(num_worker_threads, WorkStealing::ENABLED);
+}
+
+}  // namespace internal
+}  // namespace base
@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include <memory>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 
@@ -40,6 +41,7 @@ const size_t kNumThreadsPostingTasks = 4;
 const size_t kNumTasksPostedPerThread = 150;
 
 using IORestriction = SchedulerThreadPoolImpl::IORestriction;
+using WorkStealing = SchedulerThreadPoolImpl::WorkStealing;
 
 class TestDelayedTaskManager : public DelayedTaskManager {
  public:
@@ -57,7 +59,7 @@ class TestDelayedTaskManager : public DelayedTaskManager {
 };
 
 class TaskSchedulerThreadPoolImplTest
-    : public testing::TestWithParam<ExecutionMode> {
+    : public testing::TestWithParam<std::tuple<ExecutionMode, WorkStealing>> {
  protected:
   TaskSchedulerThreadPoolImplTest() = default;
 
@@ -65,6 +67,7 @@ class TaskSchedulerThreadPoolImplTest
     thread_pool_ = SchedulerThreadPoolImpl::Create(
         "TestThreadPoolWithFileIO", ThreadPriority::NORMAL,
         kNumThreadsInThreadPool, IORestriction::ALLOWED,
+        std::get<1>(GetParam()),
         Bind(&TaskSchedulerThreadPoolImplTest::ReEnqueueSequenceCallback,
              Unretained(this)),
         &task_tracker_, &delayed_task_manager_);
@@ -76,6 +79,8 @@ class TaskSchedulerThreadPoolImplTest
     thread_pool_->JoinForTesting();
   }
 
+  ExecutionMode GetExecutionMode() const { return std::get<0>(GetParam()); }
+
   std::unique_ptr<SchedulerThreadPoolImpl> thread_pool_;
 
   TaskTracker task_tracker_;
@@ -151,6 +156,18 @@ void ShouldNotRunCallback() {
   ADD_FAILURE() << "Ran a task that shouldn't run.";
 }
 
+// Posts a task that signals |nested_task_ran| to |task_runner|, waits for it to
+// run and signals |task_done|.
+void PostTaskAndWait(scoped_refptr<TaskRunner> task_runner,
+                     WaitableEvent* nested_task_ran,
+                     WaitableEvent* task_done) {
+  EXPECT_TRUE(task_runner->PostTask(
+      FROM_HERE,
+      Bind(&WaitableEvent::Signal, Unretained(nested_task_ran))));
+  nested_task_ran->Wait();
+  task_done->Signal();
+}
+
 }  // namespace
 
 TEST_P(TaskSchedulerThreadPoolImplTest, PostTasks) {
@@ -158,7 +175,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasks) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(), WaitBeforePostTask::NO_WAIT,
+        thread_pool_.get(), GetExecutionMode(), WaitBeforePostTask::NO_WAIT,
         PostNestedTask::NO)));
     threads_posting_tasks.back()->Start();
   }
@@ -181,7 +198,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWaitAllThreadsIdle) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(),
+        thread_pool_.get(), GetExecutionMode(),
         WaitBeforePostTask::WAIT_FOR_ALL_THREADS_IDLE, PostNestedTask::NO)));
     threads_posting_tasks.back()->Start();
   }
@@ -203,7 +220,7 @@ TEST_P(TaskSchedulerThreadPoolImplTest, NestedPostTasks) {
   std::vector<std::unique_ptr<ThreadPostingTasks>> threads_posting_tasks;
   for (size_t i = 0; i < kNumThreadsPostingTasks; ++i) {
     threads_posting_tasks.push_back(WrapUnique(new ThreadPostingTasks(
-        thread_pool_.get(), GetParam(), WaitBeforePostTask::NO_WAIT,
+        thread_pool_.get(), GetExecutionMode(), WaitBeforePostTask::NO_WAIT,
         PostNestedTask::YES)));
     threads_posting_tasks.back()->Start();
   }
@@ -228,8 +245,9 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWithOneAvailableThread) {
   std::vector<std::unique_ptr<test::TestTaskFactory>> blocked_task_factories;
   for (size_t i = 0; i < (kNumThreadsInThreadPool - 1); ++i) {
     blocked_task_factories.push_back(WrapUnique(new test::TestTaskFactory(
-        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-        GetParam())));
+        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                                 GetExecutionMode()),
+        GetExecutionMode())));
     EXPECT_TRUE(blocked_task_factories.back()->PostTask(
         PostNestedTask::NO, Bind(&WaitableEvent::Wait, Unretained(&event))));
     blocked_task_factories.back()->WaitForAllTasksToRun();
@@ -238,8 +256,9 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostTasksWithOneAvailableThread) {
   // Post |kNumTasksPostedPerThread| tasks that should all run despite the fact
   // that only one thread in |thread_pool_| isn't busy.
   test::TestTaskFactory short_task_factory(
-      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-      GetParam());
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                               GetExecutionMode()),
+      GetExecutionMode());
   for (size_t i = 0; i < kNumTasksPostedPerThread; ++i)
     EXPECT_TRUE(short_task_factory.PostTask(PostNestedTask::NO, Closure()));
   short_task_factory.WaitForAllTasksToRun();
@@ -262,8 +281,9 @@ TEST_P(TaskSchedulerThreadPoolImplTest, Saturate) {
   std::vector<std::unique_ptr<test::TestTaskFactory>> factories;
   for (size_t i = 0; i < kNumThreadsInThreadPool; ++i) {
     factories.push_back(WrapUnique(new test::TestTaskFactory(
-        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam()),
-        GetParam())));
+        thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(),
+                                                 GetExecutionMode()),
+        GetExecutionMode())));
     EXPECT_TRUE(factories.back()->PostTask(
         PostNestedTask::NO, Bind(&WaitableEvent::Wait, Unretained(&event))));
     factories.back()->WaitForAllTasksToRun();
@@ -279,8 +299,8 @@ TEST_P(TaskSchedulerThreadPoolImplTest, Saturate) {
 
 // Verify that a Task can't be posted after shutdown.
 TEST_P(TaskSchedulerThreadPoolImplTest, PostTaskAfterShutdown) {
-  auto task_runner =
-      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam());
+  auto task_runner = thread_pool_->CreateTaskRunnerWithTraits(
+      TaskTraits(), GetExecutionMode());
   task_tracker_.Shutdown();
   EXPECT_FALSE(task_runner->PostTask(FROM_HERE, Bind(&ShouldNotRunCallback)));
 }
@@ -293,10 +313,11 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostDelayedTask) {
   // Post a delayed task.
   WaitableEvent task_ran(WaitableEvent::ResetPolicy::MANUAL,
                          WaitableEvent::InitialState::NOT_SIGNALED);
-  EXPECT_TRUE(thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetParam())
-                  ->PostDelayedTask(FROM_HERE, Bind(&WaitableEvent::Signal,
-                                                    Unretained(&task_ran)),
-                                    TimeDelta::FromSeconds(10)));
+  EXPECT_TRUE(
+      thread_pool_->CreateTaskRunnerWithTraits(TaskTraits(), GetExecutionMode())
+          ->PostDelayedTask(FROM_HERE, Bind(&WaitableEvent::Signal,
+                                            Unretained(&task_ran)),
+                            TimeDelta::FromSeconds(10)));
 
   // The task should have been added to the DelayedTaskManager.
   EXPECT_FALSE(delayed_task_manager_.GetDelayedRunTime().is_null());
@@ -313,15 +334,57 @@ TEST_P(TaskSchedulerThreadPoolImplTest, PostDelayedTask) {
   task_ran.Wait();
 }
 
-INSTANTIATE_TEST_CASE_P(Parallel,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::PARALLEL));
-INSTANTIATE_TEST_CASE_P(Sequenced,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::SEQUENCED));
-INSTANTIATE_TEST_CASE_P(SingleThreaded,
-                        TaskSchedulerThreadPoolImplTest,
-                        ::testing::Values(ExecutionMode::SINGLE_THREADED));
+// Verify that a task posted from a worker thread runs when the other worker
+// threads are going idle, even if the posting worker thread waits for it. With
+// work stealing, the task is in the local PriorityQueue of the posting worker
+// thread, so another worker thread must steal it.
+TEST_P(TaskSchedulerThreadPoolImplTest, PostTaskWhileAllThreadsGoIdle) {
+  const size_t kNumIterations = 100;
+  // The tasks are PARALLEL so that the nested task can run while the task that
+  // posted it is running.
+  auto task_runner = thread_pool_->CreateTaskRunnerWithTraits(
+      TaskTraits(), ExecutionMode::PARALLEL);
+  WaitableEvent nested_task_ran(WaitableEvent::ResetPolicy::AUTOMATIC,
+                                WaitableEvent::InitialState::NOT_SIGNALED);
+  WaitableEvent task_done(WaitableEvent::ResetPolicy::AUTOMATIC,
+                          WaitableEvent::InitialState::NOT_SIGNALED);
+
+  for (size_t i = 0; i < kNumIterations; ++i) {
+    thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+
+    // Wake up all worker threads. One of them posts a task and waits for it,
+    // while the others run a task that returns right away and go idle.
+    EXPECT_TRUE(task_runner->PostTask(
+        FROM_HERE, Bind(&PostTaskAndWait, task_runner,
+                        Unretained(&nested_task_ran), Unretained(&task_done))));
+    for (size_t j = 1; j < kNumThreadsInThreadPool; ++j)
+      EXPECT_TRUE(task_runner->PostTask(FROM_HERE, Bind(&DoNothing)));
+
+    // This hangs if the nested task is never run.
+    task_done.Wait();
+  }
+
+  thread_pool_->WaitForAllWorkerThreadsIdleForTesting();
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Parallel,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Combine(::testing::Values(ExecutionMode::PARALLEL),
+                       ::testing::Values(WorkStealing::DISABLED,
+                                         WorkStealing::ENABLED)));
+INSTANTIATE_TEST_CASE_P(
+    Sequenced,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Combine(::testing::Values(ExecutionMode::SEQUENCED),
+                       ::testing::Values(WorkStealing::DISABLED,
+                                         WorkStealing::ENABLED)));
+INSTANTIATE_TEST_CASE_P(
+    SingleThreaded,
+    TaskSchedulerThreadPoolImplTest,
+    ::testing::Combine(::testing::Values(ExecutionMode::SINGLE_THREADED),
+                       ::testing::Values(WorkStealing::DISABLED,
+                                         WorkStealing::ENABLED)));
 
 namespace {
 
@@ -364,8 +427,8 @@ TEST_P(TaskSchedulerThreadPoolImplIORestrictionTest, IORestriction) {
 
   auto thread_pool = SchedulerThreadPoolImpl::Create(
       "TestThreadPoolWithParam", ThreadPriority::NORMAL, 1U, GetParam(),
-      Bind(&NotReachedReEnqueueSequenceCallback), &task_tracker,
-      &delayed_task_manager);
+      WorkStealing::DISABLED, Bind(&NotReachedReEnqueueSequenceCallback),
+      &task_tracker, &delayed_task_manager);
   ASSERT_TRUE(thread_pool);
 
   WaitableEvent task_ran(WaitableEvent::ResetPolicy::MANUAL,
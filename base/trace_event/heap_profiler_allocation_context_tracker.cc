@@ -8,7 +8,9 @@
 #include <iterator>
 
 #include "base/atomicops.h"
+#include "base/debug/debugging_flags.h"
 #include "base/debug/leak_annotations.h"
+#include "base/debug/stack_trace.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread_local_storage.h"
 #include "base/trace_event/heap_profiler_allocation_context.h"
@@ -17,6 +19,15 @@
 #include <sys/prctl.h>
 #endif
 
+// The stack can only be walked with frame pointers when they are built in,
+// which is the case in profiling and debug builds. Otherwise it is unwound.
+#if HAVE_TRACE_STACK_FRAME_POINTERS && !defined(OS_NACL) && \
+    (BUILDFLAG(ENABLE_PROFILING) || !defined(NDEBUG))
+#define USE_TRACE_STACK_FRAME_POINTERS 1
+#else
+#define USE_TRACE_STACK_FRAME_POINTERS 0
+#endif
+
 namespace base {
 namespace trace_event {
 
@@ -154,8 +165,16 @@ void AllocationContextTracker::PopCurrentTaskContext(const char* context) {
   task_contexts_.pop_back();
 }
 
-// static
 AllocationContext AllocationContextTracker::GetContextSnapshot() {
+  return GetContextSnapshotInternal(false /* allow_unwinding */);
+}
+
+AllocationContext AllocationContextTracker::GetContextSnapshotWithUnwinding() {
+  return GetContextSnapshotInternal(true /* allow_unwinding */);
+}
+
+AllocationContext AllocationContextTracker::GetContextSnapshotInternal(
+    bool allow_unwinding) {
   AllocationContext ctx;
 
   if (ignore_scope_depth_) {
@@ -210,11 +229,25 @@ AllocationContext AllocationContextTracker::GetContextSnapshot() {
         const void* frames[128];
         static_assert(arraysize(frames) >= Backtrace::kMaxFrameCount,
                       "not requesting enough frames to fill Backtrace");
-#if HAVE_TRACE_STACK_FRAME_POINTERS && !defined(OS_NACL)
+#if USE_TRACE_STACK_FRAME_POINTERS
         size_t frame_count = debug::TraceStackFramePointers(
             frames,
             arraysize(frames),
             1 /* exclude this function from the trace */ );
+#elif !defined(OS_NACL)
+        // Without frame pointers the stack is unwound, which is much slower.
+        size_t frame_count = 0;
+        if (allow_unwinding) {
+          // The unwinder can allocate, e.g. glibc's backtrace() on its first
+          // call. Those allocations are ignored rather than unwound again.
+          ignore_scope_depth_++;
+          debug::StackTrace stack_trace;
+          ignore_scope_depth_--;
+          const void* const* addresses = stack_trace.Addresses(&frame_count);
+          std::copy(addresses, addresses + frame_count, frames);
+        } else {
+          NOTREACHED();
+        }
 #else
         size_t frame_count = 0;
         NOTREACHED();
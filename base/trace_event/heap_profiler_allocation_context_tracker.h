@@ -82,11 +82,19 @@ class BASE_EXPORT AllocationContextTracker {
   // Returns a snapshot of the current thread-local context.
   AllocationContext GetContextSnapshot();
 
+  // Same as GetContextSnapshot(), except that in NATIVE_STACK mode the stack
+  // is unwound when frame pointers are not available. Unwinding is much
+  // slower, so this is only used for the few allocations recorded by the
+  // sampling heap profiler.
+  AllocationContext GetContextSnapshotWithUnwinding();
+
   ~AllocationContextTracker();
 
  private:
   AllocationContextTracker();
 
+  AllocationContext GetContextSnapshotInternal(bool allow_unwinding);
+
   static subtle::Atomic32 capture_mode_;
 
   // The pseudo stack where frames are |TRACE_EVENT| names.
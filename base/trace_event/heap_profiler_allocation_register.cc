@@ -13,22 +13,29 @@ AllocationRegister::AllocationRegister()
     : AllocationRegister(kNumBuckets * kNumCellsPerBucket) {}
 
 AllocationRegister::AllocationRegister(uint32_t num_cells)
+    : AllocationRegister(num_cells, kNumBuckets) {}
+
+AllocationRegister::AllocationRegister(uint32_t num_cells, uint32_t num_buckets)
     // Reserve enough address space to store |num_cells_| entries if necessary,
     // with a guard page after it to crash the program when attempting to store
     // more entries.
     : num_cells_(num_cells),
+      num_buckets_(num_buckets),
+      num_buckets_mask_(num_buckets - 1),
       cells_(static_cast<Cell*>(AllocateVirtualMemory(num_cells_ *
                                                       sizeof(Cell)))),
       buckets_(static_cast<CellIndex*>(
-          AllocateVirtualMemory(kNumBuckets * sizeof(CellIndex)))),
+          AllocateVirtualMemory(num_buckets_ * sizeof(CellIndex)))),
 
       // The free list is empty. The first unused cell is cell 1, because index
       // 0 is used as list terminator.
       free_list_(0),
-      next_unused_cell_(1) {}
+      next_unused_cell_(1) {
+  DCHECK(num_buckets_ && !(num_buckets_ & num_buckets_mask_));
+}
 
 AllocationRegister::~AllocationRegister() {
-  FreeVirtualMemory(buckets_, kNumBuckets * sizeof(CellIndex));
+  FreeVirtualMemory(buckets_, num_buckets_ * sizeof(CellIndex));
   FreeVirtualMemory(cells_, num_cells_ * sizeof(Cell));
 }
 
@@ -166,8 +173,7 @@ AllocationRegister::CellIndex AllocationRegister::GetFreeCell() {
   return idx;
 }
 
-// static
-uint32_t AllocationRegister::Hash(void* address) {
+uint32_t AllocationRegister::Hash(void* address) const {
   // The multiplicative hashing scheme from [Knuth 1998]. The value of |a| has
   // been chosen carefully based on measurements with real-word data (addresses
   // recorded from a Chrome trace run). It is the first prime after 2^17. For
@@ -178,7 +184,7 @@ uint32_t AllocationRegister::Hash(void* address) {
   const uintptr_t a = 131101;
   const uintptr_t shift = 14;
   const uintptr_t h = (key * a) >> shift;
-  return static_cast<uint32_t>(h) & kNumBucketsMask;
+  return static_cast<uint32_t>(h) & num_buckets_mask_;
 }
 
 void AllocationRegister::EstimateTraceMemoryOverhead(
@@ -191,7 +197,7 @@ void AllocationRegister::EstimateTraceMemoryOverhead(
                     // Include size of touched cells (size of |*cells_|).
                     + sizeof(Cell) * next_unused_cell_
                     // Size of |*buckets_|.
-                    + sizeof(CellIndex) * kNumBuckets;
+                    + sizeof(CellIndex) * num_buckets_;
   overhead->Add("AllocationRegister", allocated, resident);
 }
 
@@ -63,6 +63,11 @@ class BASE_EXPORT AllocationRegister {
   AllocationRegister();
   explicit AllocationRegister(uint32_t num_cells);
 
+  // Creates a table with |num_buckets| buckets, which must be a power of two.
+  // A table which is expected to hold few entries, such as the allocations
+  // of a sampling heap profiler, can use fewer buckets to stay small.
+  AllocationRegister(uint32_t num_cells, uint32_t num_buckets);
+
   ~AllocationRegister();
 
   // Inserts allocation details into the table. If the address was present
@@ -111,7 +116,6 @@ class BASE_EXPORT AllocationRegister {
   // chasing down the linked list, until the size is 2^18. The number of buckets
   // is a power of two so modular indexing can be done with bitwise and.
   static const uint32_t kNumBuckets = 0x20000;
-  static const uint32_t kNumBucketsMask = kNumBuckets - 1;
 
   // Reserve address space to store at most this number of entries. High
   // capacity does not imply high memory usage due to the access pattern. The
@@ -122,8 +126,8 @@ class BASE_EXPORT AllocationRegister {
   // dozens of MiB of address space.
   static const uint32_t kNumCellsPerBucket = 10;
 
-  // Returns a value in the range [0, kNumBuckets - 1] (inclusive).
-  static uint32_t Hash(void* address);
+  // Returns a value in the range [0, num_buckets_ - 1] (inclusive).
+  uint32_t Hash(void* address) const;
 
   // Allocates a region of virtual address space of |size| rounded up to the
   // system page size. The memory is zeroed by the system. A guard page is
@@ -147,6 +151,10 @@ class BASE_EXPORT AllocationRegister {
   // The maximum number of cells which can be allocated.
   uint32_t const num_cells_;
 
+  // The number of buckets, a power of two, and the mask for modular indexing.
+  uint32_t const num_buckets_;
+  uint32_t const num_buckets_mask_;
+
   // The array of cells. This array is backed by mmapped memory. Lower indices
   // are accessed first, higher indices are only accessed when required. In
   // this way, even if a huge amount of address space has been mmapped, only
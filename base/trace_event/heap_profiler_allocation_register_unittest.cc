@@ -169,6 +169,31 @@ TEST_F(AllocationRegisterTest, InsertRemoveCollisions) {
   EXPECT_EQ(expected_sum, SumAllSizes(reg));
 }
 
+// Check that a register with few buckets, where most entries collide, stores
+// and removes them correctly.
+TEST_F(AllocationRegisterTest, InsertRemoveWithFewBuckets) {
+  const uint32_t kNumBuckets = 16;
+  const uintptr_t kNumEntries = 1000;
+  size_t expected_sum = 0;
+  AllocationRegister reg(kNumEntries + 1, kNumBuckets);
+  AllocationContext ctx;
+
+  for (uintptr_t i = 1; i <= kNumEntries; i++) {
+    expected_sum += i;
+    reg.Insert(reinterpret_cast<void*>(i * 16), i, ctx);
+  }
+  EXPECT_EQ(expected_sum, SumAllSizes(reg));
+  EXPECT_EQ(kNumEntries + 1, GetHighWaterMark(reg));
+
+  for (uintptr_t i = 1; i <= kNumEntries; i += 2) {
+    expected_sum -= i;
+    reg.Remove(reinterpret_cast<void*>(i * 16));
+    EXPECT_EQ(nullptr, reg.Get(reinterpret_cast<void*>(i * 16)));
+  }
+  EXPECT_EQ(expected_sum, SumAllSizes(reg));
+  EXPECT_EQ(2u, reg.Get(reinterpret_cast<void*>(2 * 16))->size);
+}
+
 // The previous tests are not particularly good for testing iterators, because
 // elements are removed and inserted in the same order, meaning that the cells
 // fill up from low to high index, and are then freed from low to high index.
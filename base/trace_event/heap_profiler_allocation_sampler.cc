@@ -0,0 +1,108 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/rand_util.h"
+#include "base/trace_event/trace_event_memory_overhead.h"
+
+namespace base {
+namespace trace_event {
+
+AllocationSampler::AllocationSampler(size_t sampling_interval)
+    : sampling_interval_(sampling_interval),
+      random_state_(0),
+      address_counts_(new subtle::Atomic32[kNumAddressBuckets]()) {
+  DCHECK_GT(sampling_interval_, 0u);
+  // Xorshift never leaves the zero state, so the seed must not be zero.
+  uint32_t seed = 0;
+  while (!seed)
+    seed = static_cast<uint32_t>(RandUint64());
+  random_state_ = static_cast<subtle::Atomic32>(seed);
+}
+
+AllocationSampler::~AllocationSampler() {
+  bytes_until_sample_.Free();
+}
+
+bool AllocationSampler::ShouldSample(size_t size) {
+  uintptr_t bytes_until_sample =
+      reinterpret_cast<uintptr_t>(bytes_until_sample_.Get());
+  if (!bytes_until_sample)
+    bytes_until_sample = NextSampleInterval();
+
+  bool sample = size >= bytes_until_sample;
+  // The sampled bytes are a Poisson process, so the bytes until the next
+  // sample don't depend on how many samples the allocation contains.
+  bytes_until_sample =
+      sample ? NextSampleInterval() : bytes_until_sample - size;
+  bytes_until_sample_.Set(reinterpret_cast<void*>(bytes_until_sample));
+  return sample;
+}
+
+size_t AllocationSampler::GetEstimatedSize(size_t size) const {
+  if (!size)
+    return 0;
+  // An allocation of |size| bytes is sampled with probability
+  // 1 - exp(-size / sampling_interval), the probability that it contains at
+  // least one sampled byte. Dividing by it gives an unbiased estimate.
+  double probability =
+      -expm1(-static_cast<double>(size) / sampling_interval_);
+  return static_cast<size_t>(size / probability + 0.5);
+}
+
+void AllocationSampler::AddSampledAddress(void* address) {
+  subtle::NoBarrier_AtomicIncrement(&address_counts_[AddressHash(address)], 1);
+}
+
+void AllocationSampler::RemoveSampledAddress(void* address) {
+  subtle::Atomic32 count = subtle::NoBarrier_AtomicIncrement(
+      &address_counts_[AddressHash(address)], -1);
+  DCHECK_GE(count, 0);
+}
+
+void AllocationSampler::ClearSampledAddresses() {
+  for (uint32_t i = 0; i < kNumAddressBuckets; ++i)
+    subtle::NoBarrier_Store(&address_counts_[i], 0);
+}
+
+void AllocationSampler::EstimateTraceMemoryOverhead(
+    TraceEventMemoryOverhead* overhead) const {
+  size_t allocated = sizeof(AllocationSampler) +
+                     kNumAddressBuckets * sizeof(subtle::Atomic32);
+  overhead->Add("AllocationSampler", allocated, allocated);
+}
+
+// static
+uint32_t AllocationSampler::AddressHash(void* address) {
+  // Fibonacci hashing of the address, without the low bits which are the same
+  // for all the allocations because of their alignment. The top 16 bits of the
+  // product index the 2^16 buckets.
+  const uint32_t key =
+      static_cast<uint32_t>(reinterpret_cast<uintptr_t>(address) >> 4);
+  return (key * 2654435761u) >> 16;
+}
+
+size_t AllocationSampler::NextSampleInterval() {
+  // Xorshift32 is good enough to draw the intervals, and fast.
+  uint32_t x = static_cast<uint32_t>(subtle::NoBarrier_Load(&random_state_));
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  subtle::NoBarrier_Store(&random_state_, static_cast<subtle::Atomic32>(x));
+
+  // |x| is never zero, so |uniform| is in (0, 1], and the interval is drawn
+  // from the exponential distribution whose mean is the sampling interval.
+  double uniform = x / 4294967296.0;
+  double interval = -log(uniform) * sampling_interval_;
+  return std::max<size_t>(1, static_cast<size_t>(interval));
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,107 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_HEAP_PROFILER_ALLOCATION_SAMPLER_H_
+#define BASE_TRACE_EVENT_HEAP_PROFILER_ALLOCATION_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+namespace trace_event {
+
+class TraceEventMemoryOverhead;
+
+// The allocation sampler decides which allocations a sampling heap profiler
+// records, so that its overhead is low enough to leave it enabled. The
+// allocated bytes are sampled as a Poisson process: on average one byte every
+// |sampling_interval| bytes is sampled, and the allocation containing it is
+// recorded. The number of bytes between two samples is drawn from an
+// exponential distribution, so that allocations of any size can be scaled
+// back without bias, and allocations made with a fixed stride don't alias
+// with the sampling interval.
+//
+// The sampler also keeps track of the addresses of the sampled allocations
+// which haven't been freed yet, so that the frees of the allocations which
+// weren't sampled, almost all of them, can be ignored without a lookup.
+class BASE_EXPORT AllocationSampler {
+ public:
+  // One sample every 128 KiB allocated keeps the overhead of the heap profiler
+  // negligible, and is enough to find the sources of large heap usage.
+  static const size_t kDefaultSamplingInterval = 128 * 1024;
+
+  explicit AllocationSampler(size_t sampling_interval);
+  ~AllocationSampler();
+
+  // Returns true if an allocation of |size| bytes is to be recorded. This is
+  // called on every allocation, and only touches a thread-local counter unless
+  // the allocation is sampled.
+  bool ShouldSample(size_t size);
+
+  // Returns the number of bytes a sampled allocation of |size| bytes stands
+  // for: the sum of the sizes of the allocations of |size| bytes, sampled or
+  // not, is estimated by the sum of this for those which were sampled.
+  size_t GetEstimatedSize(size_t size) const;
+
+  // Record that the allocation at |address| was sampled, and that it was
+  // freed, respectively.
+  void AddSampledAddress(void* address);
+  void RemoveSampledAddress(void* address);
+
+  // Forgets all the sampled addresses, when the sampled allocations are no
+  // longer recorded.
+  void ClearSampledAddresses();
+
+  // Returns false if |address| is certainly not the address of a sampled
+  // allocation which hasn't been freed yet. Can return true for any address.
+  bool MaybeSampledAddress(void* address) const {
+    return subtle::NoBarrier_Load(&address_counts_[AddressHash(address)]) != 0;
+  }
+
+  size_t sampling_interval() const { return sampling_interval_; }
+
+  // Estimates memory overhead including |sizeof(AllocationSampler)|.
+  void EstimateTraceMemoryOverhead(TraceEventMemoryOverhead* overhead) const;
+
+ private:
+  // The number of buckets of |address_counts_|. With the default sampling
+  // interval, a heap of 1 GiB has 8192 sampled allocations, so most of the
+  // buckets are still empty.
+  static const uint32_t kNumAddressBuckets = 0x10000;
+
+  static uint32_t AddressHash(void* address);
+
+  // Returns the number of bytes to allocate until the next sample.
+  size_t NextSampleInterval();
+
+  const size_t sampling_interval_;
+
+  // The number of bytes the current thread can allocate until the next sample.
+  // It is never zero once set, so zero marks a thread which hasn't allocated
+  // yet.
+  ThreadLocalStorage::Slot bytes_until_sample_;
+
+  // The state of the random number generator for the sampling intervals. It is
+  // shared by all the threads without synchronization: a race can only make
+  // two intervals equal, which doesn't bias the samples.
+  subtle::Atomic32 random_state_;
+
+  // The number of sampled allocations which haven't been freed yet, by hash of
+  // their address.
+  std::unique_ptr<subtle::Atomic32[]> address_counts_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSampler);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_HEAP_PROFILER_ALLOCATION_SAMPLER_H_
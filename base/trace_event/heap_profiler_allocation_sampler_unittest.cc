@@ -0,0 +1,89 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+TEST(AllocationSamplerTest, SamplesOnAverageOncePerInterval) {
+  const size_t kSamplingInterval = 1024;
+  const size_t kNumAllocations = 1000000;
+  AllocationSampler sampler(kSamplingInterval);
+
+  // 64 MB in small allocations are expected to be sampled 62500 times. The
+  // standard deviation is 250, so the bounds are very unlikely to be crossed.
+  size_t num_samples = 0;
+  for (size_t i = 0; i < kNumAllocations; i++) {
+    if (sampler.ShouldSample(64))
+      num_samples++;
+  }
+  EXPECT_GT(num_samples, 60000u);
+  EXPECT_LT(num_samples, 65000u);
+}
+
+TEST(AllocationSamplerTest, EstimatedSizeIsUnbiased) {
+  const size_t kSamplingInterval = 1024;
+  AllocationSampler sampler(kSamplingInterval);
+
+  EXPECT_EQ(0u, sampler.GetEstimatedSize(0));
+
+  // A sampled small allocation stands for the whole interval.
+  EXPECT_GE(sampler.GetEstimatedSize(1), kSamplingInterval);
+  EXPECT_LE(sampler.GetEstimatedSize(1), kSamplingInterval + 1);
+
+  // A large allocation is almost always sampled, and stands for itself.
+  EXPECT_EQ(1024u * 1024, sampler.GetEstimatedSize(1024 * 1024));
+
+  // Scaling the sampled allocations back estimates the allocated bytes, for
+  // allocations smaller and larger than the sampling interval.
+  for (size_t size : {16u, 1000u, 5000u}) {
+    const size_t kNumAllocations = 1000000;
+    size_t estimated_bytes = 0;
+    for (size_t i = 0; i < kNumAllocations; i++) {
+      if (sampler.ShouldSample(size))
+        estimated_bytes += sampler.GetEstimatedSize(size);
+    }
+    double ratio =
+        static_cast<double>(estimated_bytes) / (kNumAllocations * size);
+    EXPECT_GT(ratio, 0.95) << size;
+    EXPECT_LT(ratio, 1.05) << size;
+  }
+}
+
+TEST(AllocationSamplerTest, SampledAddresses) {
+  AllocationSampler sampler(AllocationSampler::kDefaultSamplingInterval);
+  void* address1 = reinterpret_cast<void*>(0x10000);
+  void* address2 = reinterpret_cast<void*>(0x20000);
+
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address1));
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address2));
+
+  sampler.AddSampledAddress(address1);
+  EXPECT_TRUE(sampler.MaybeSampledAddress(address1));
+
+  sampler.AddSampledAddress(address2);
+  sampler.RemoveSampledAddress(address1);
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address1));
+  EXPECT_TRUE(sampler.MaybeSampledAddress(address2));
+
+  sampler.RemoveSampledAddress(address2);
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address1));
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address2));
+
+  sampler.AddSampledAddress(address1);
+  sampler.AddSampledAddress(address1);
+  sampler.AddSampledAddress(address2);
+  sampler.ClearSampledAddresses();
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address1));
+  EXPECT_FALSE(sampler.MaybeSampledAddress(address2));
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -9,9 +9,11 @@
 #include "base/allocator/allocator_extension.h"
 #include "base/allocator/allocator_shim.h"
 #include "base/allocator/features.h"
+#include "base/debug/stack_trace.h"
 #include "base/trace_event/heap_profiler_allocation_context.h"
 #include "base/trace_event/heap_profiler_allocation_context_tracker.h"
 #include "base/trace_event/heap_profiler_allocation_register.h"
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
 #include "base/trace_event/heap_profiler_heap_dump_writer.h"
 #include "base/trace_event/process_memory_dump.h"
 #include "base/trace_event/trace_event_argument.h"
@@ -26,9 +28,16 @@
 namespace base {
 namespace trace_event {
 
-#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
 namespace {
 
+// When sampling, the register is sized for the sampled allocations: with the
+// default sampling interval these are enough for a heap of 4 GiB. Further
+// sampled allocations are ignored.
+const uint32_t kNumSampledAllocationCells = 0x8000;
+const uint32_t kNumSampledAllocationBuckets = 0x2000;
+const size_t kMaxSampledAllocations = kNumSampledAllocationCells - 1;
+
+#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
 using allocator::AllocatorDispatch;
 
 void* HookAlloc(const AllocatorDispatch* self, size_t size) {
@@ -81,9 +90,9 @@ AllocatorDispatch g_allocator_hooks = {
     &HookFree,          /* free_function */
     nullptr,            /* next */
 };
+#endif  // BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
 
 }  // namespace
-#endif  // BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
 
 // static
 const char MallocDumpProvider::kAllocatedObjects[] = "malloc/allocated_objects";
@@ -95,7 +104,9 @@ MallocDumpProvider* MallocDumpProvider::GetInstance() {
 }
 
 MallocDumpProvider::MallocDumpProvider()
-    : heap_profiler_enabled_(false), tid_dumping_heap_(kInvalidThreadId) {}
+    : heap_profiler_enabled_(false),
+      num_sampled_allocations_(0),
+      tid_dumping_heap_(kInvalidThreadId) {}
 
 MallocDumpProvider::~MallocDumpProvider() {}
 
@@ -182,14 +193,11 @@ bool MallocDumpProvider::OnMemoryDump(const MemoryDumpArgs& args,
     {
       AutoLock lock(allocation_register_lock_);
       if (allocation_register_) {
-        if (args.level_of_detail == MemoryDumpLevelOfDetail::DETAILED) {
-          for (const auto& alloc_size : *allocation_register_) {
-            AllocationMetrics& metrics = metrics_by_context[alloc_size.context];
-            metrics.size += alloc_size.size;
-            metrics.count++;
-          }
-        }
+        if (args.level_of_detail == MemoryDumpLevelOfDetail::DETAILED)
+          GetMetricsByContext(&metrics_by_context);
         allocation_register_->EstimateTraceMemoryOverhead(&overhead);
+        if (sampler_)
+          sampler_->EstimateTraceMemoryOverhead(&overhead);
       }
     }  // lock(allocation_register_lock_)
     pmd->DumpHeapUsage(metrics_by_context, overhead, "malloc");
@@ -199,17 +207,44 @@ bool MallocDumpProvider::OnMemoryDump(const MemoryDumpArgs& args,
   return true;
 }
 
+void MallocDumpProvider::GetMetricsByContext(
+    hash_map<AllocationContext, AllocationMetrics>* metrics_by_context) const {
+  allocation_register_lock_.AssertAcquired();
+  for (const auto& alloc_size : *allocation_register_) {
+    AllocationMetrics& metrics = (*metrics_by_context)[alloc_size.context];
+    if (sampler_) {
+      // Scale the sampled allocations up to the heap they stand for.
+      size_t estimated_size = sampler_->GetEstimatedSize(alloc_size.size);
+      metrics.size += estimated_size;
+      metrics.count += estimated_size / alloc_size.size;
+    } else {
+      metrics.size += alloc_size.size;
+      metrics.count++;
+    }
+  }
+}
+
 void MallocDumpProvider::OnHeapProfilingEnabled(bool enabled) {
 #if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM)
   if (enabled) {
     {
       AutoLock lock(allocation_register_lock_);
-      allocation_register_.reset(new AllocationRegister());
+      if (sampler_) {
+        allocation_register_.reset(new AllocationRegister(
+            kNumSampledAllocationCells, kNumSampledAllocationBuckets));
+      } else {
+        allocation_register_.reset(new AllocationRegister());
+      }
     }
     allocator::InsertAllocatorDispatch(&g_allocator_hooks);
   } else {
     AutoLock lock(allocation_register_lock_);
     allocation_register_.reset();
+    // The frees of the sampled allocations are no longer recorded, so they
+    // must not be looked up anymore either.
+    num_sampled_allocations_ = 0;
+    if (sampler_)
+      sampler_->ClearSampledAddresses();
     // Insert/RemoveAllocation below will no-op if the register is torn down.
     // Once disabled, heap profiling will not re-enabled anymore for the
     // lifetime of the process.
@@ -218,7 +253,21 @@ void MallocDumpProvider::OnHeapProfilingEnabled(bool enabled) {
   heap_profiler_enabled_ = enabled;
 }
 
+void MallocDumpProvider::EnableSampling(size_t sampling_interval) {
+  DCHECK(!heap_profiler_enabled_);
+  DCHECK(!sampler_);
+  sampler_.reset(new AllocationSampler(sampling_interval));
+  // The first stack unwinding can allocate, e.g. when glibc's backtrace()
+  // loads its unwinder. Do it now, before the allocator hooks are inserted.
+  debug::StackTrace();
+}
+
 void MallocDumpProvider::InsertAllocation(void* address, size_t size) {
+  // When sampling, this is the only cost of the allocations which aren't
+  // sampled.
+  if (sampler_ && !sampler_->ShouldSample(size))
+    return;
+
   // CurrentId() can be a slow operation (crbug.com/497226). This apparently
   // redundant condition short circuits the CurrentID() calls when unnecessary.
   if (tid_dumping_heap_ != kInvalidThreadId &&
@@ -232,16 +281,34 @@ void MallocDumpProvider::InsertAllocation(void* address, size_t size) {
   auto tracker = AllocationContextTracker::GetInstanceForCurrentThread();
   if (!tracker)
     return;
-  AllocationContext context = tracker->GetContextSnapshot();
+  // Only the sampled allocations get here when sampling, so they can afford
+  // to unwind the stack.
+  AllocationContext context = sampler_
+                                  ? tracker->GetContextSnapshotWithUnwinding()
+                                  : tracker->GetContextSnapshot();
 
   AutoLock lock(allocation_register_lock_);
   if (!allocation_register_)
     return;
 
+  // An address which is already in the register was inserted again because
+  // its free was missed, and is only counted once.
+  if (sampler_ && !allocation_register_->Get(address)) {
+    if (num_sampled_allocations_ == kMaxSampledAllocations)
+      return;
+    num_sampled_allocations_++;
+    sampler_->AddSampledAddress(address);
+  }
+
   allocation_register_->Insert(address, size, context);
 }
 
 void MallocDumpProvider::RemoveAllocation(void* address) {
+  // When sampling, almost all the freed allocations weren't sampled, and are
+  // ignored without taking the lock.
+  if (sampler_ && !sampler_->MaybeSampledAddress(address))
+    return;
+
   // No re-entrancy is expected here as none of the calls below should
   // cause a free()-s (|allocation_register_| does its own heap management).
   if (tid_dumping_heap_ != kInvalidThreadId &&
@@ -250,6 +317,12 @@ void MallocDumpProvider::RemoveAllocation(void* address) {
   AutoLock lock(allocation_register_lock_);
   if (!allocation_register_)
     return;
+  if (sampler_) {
+    if (!allocation_register_->Get(address))
+      return;
+    num_sampled_allocations_--;
+    sampler_->RemoveSampledAddress(address);
+  }
   allocation_register_->Remove(address);
 }
 
@@ -8,10 +8,12 @@
 #include <istream>
 #include <memory>
 
+#include "base/containers/hash_tables.h"
 #include "base/macros.h"
 #include "base/memory/singleton.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
+#include "base/trace_event/heap_profiler_allocation_context.h"
 #include "base/trace_event/memory_dump_provider.h"
 #include "build/build_config.h"
 
@@ -24,6 +26,7 @@ namespace base {
 namespace trace_event {
 
 class AllocationRegister;
+class AllocationSampler;
 
 // Dump provider which collects process-wide memory stats.
 class BASE_EXPORT MallocDumpProvider : public MemoryDumpProvider {
@@ -40,6 +43,12 @@ class BASE_EXPORT MallocDumpProvider : public MemoryDumpProvider {
 
   void OnHeapProfilingEnabled(bool enabled) override;
 
+  // Makes the heap profiler record a sample of the allocations, on average
+  // one every |sampling_interval| bytes allocated, and scale them back in the
+  // heap dumps. This is cheap enough to leave heap profiling enabled. Must be
+  // called before heap profiling is enabled.
+  void EnableSampling(size_t sampling_interval);
+
   // For heap profiling.
   void InsertAllocation(void* address, size_t size);
   void RemoveAllocation(void* address);
@@ -47,14 +56,30 @@ class BASE_EXPORT MallocDumpProvider : public MemoryDumpProvider {
  private:
   friend struct DefaultSingletonTraits<MallocDumpProvider>;
 
+  friend class MallocDumpProviderTest;
+
   MallocDumpProvider();
   ~MallocDumpProvider() override;
 
+  // Sums up the allocations of |allocation_register_| by context, scaling the
+  // sampled allocations up to the heap they stand for. Must be called with
+  // |allocation_register_lock_| held.
+  void GetMetricsByContext(
+      hash_map<AllocationContext, AllocationMetrics>* metrics_by_context) const;
+
   // For heap profiling.
   bool heap_profiler_enabled_;
   std::unique_ptr<AllocationRegister> allocation_register_;
   Lock allocation_register_lock_;
 
+  // Set when sampling. Never reset, as the allocator hooks use it without
+  // taking the lock.
+  std::unique_ptr<AllocationSampler> sampler_;
+
+  // The number of sampled allocations in |allocation_register_|, which is
+  // bounded when sampling. Guarded by |allocation_register_lock_|.
+  size_t num_sampled_allocations_;
+
   // When in OnMemoryDump(), this contains the current thread ID.
   // This is to prevent re-entrancy in the heap profiler when the heap dump
   // generation is malloc/new-ing for its own bookeeping data structures.
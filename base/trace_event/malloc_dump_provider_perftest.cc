@@ -0,0 +1,81 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/malloc_dump_provider.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "base/allocator/features.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/trace_event/heap_profiler_allocation_context_tracker.h"
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const int kNumIterations = 2000000;
+
+// The number of allocations alive at any time.
+const size_t kNumLiveAllocations = 4096;
+
+// Sizes typical of the allocations of Chrome, most of which are small.
+const size_t kAllocationSizes[] = {16,  24,  32,   48,   64,   96,
+                                   128, 256, 512, 1024, 4096, 32768};
+
+// Allocates and frees memory, keeping kNumLiveAllocations allocations alive,
+// and returns the time it took.
+TimeDelta AllocateAndFree() {
+  std::vector<void*> allocations(kNumLiveAllocations, nullptr);
+  ElapsedTimer timer;
+  for (int i = 0; i < kNumIterations; i++) {
+    void*& allocation = allocations[i % kNumLiveAllocations];
+    free(allocation);
+    allocation = malloc(kAllocationSizes[i % arraysize(kAllocationSizes)]);
+  }
+  TimeDelta elapsed = timer.Elapsed();
+  for (void* allocation : allocations)
+    free(allocation);
+  return elapsed;
+}
+
+void PrintTimePerAllocation(const std::string& trace, TimeDelta elapsed) {
+  perf_test::PrintResult("malloc_free", "", trace,
+                         elapsed.InMillisecondsF() * 1000000 / kNumIterations,
+                         "ns", true);
+}
+
+}  // namespace
+
+// Measures the cost of a malloc() and free() pair without heap profiling, and
+// with the sampling heap profiler recording a sample every 128 KiB allocated.
+// Disabling heap profiling afterwards stops the recording, but the allocator
+// hooks stay inserted, and the sampler stays set, for the rest of the process.
+TEST(MallocDumpProviderPerfTest, SamplingHeapProfilerOverhead) {
+  PrintTimePerAllocation("unprofiled", AllocateAndFree());
+
+#if BUILDFLAG(USE_EXPERIMENTAL_ALLOCATOR_SHIM) && \
+    defined(MALLOC_MEMORY_TRACING_SUPPORTED)
+  AllocationContextTracker::SetCaptureMode(
+      AllocationContextTracker::CaptureMode::NATIVE_STACK);
+  MallocDumpProvider::GetInstance()->EnableSampling(
+      AllocationSampler::kDefaultSamplingInterval);
+  MallocDumpProvider::GetInstance()->OnHeapProfilingEnabled(true);
+  PrintTimePerAllocation("sampled_128k", AllocateAndFree());
+  MallocDumpProvider::GetInstance()->OnHeapProfilingEnabled(false);
+  AllocationContextTracker::SetCaptureMode(
+      AllocationContextTracker::CaptureMode::DISABLED);
+#endif
+}
+
+}  // namespace trace_event
+}  // namespace base
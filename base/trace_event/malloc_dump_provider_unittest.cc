@@ -0,0 +1,106 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/malloc_dump_provider.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/trace_event/heap_profiler_allocation_register.h"
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+class MallocDumpProviderTest : public testing::Test {
+ public:
+  MallocDumpProviderTest() : provider_(nullptr) {}
+
+  void TearDown() override { delete provider_; }
+
+ protected:
+  // Creates a provider which samples one allocation every |sampling_interval|
+  // bytes. It records them as if heap profiling was enabled, without inserting
+  // the allocator hooks.
+  void CreateSamplingProvider(size_t sampling_interval) {
+    provider_ = new MallocDumpProvider;
+    provider_->EnableSampling(sampling_interval);
+    provider_->allocation_register_.reset(new AllocationRegister);
+  }
+
+  MallocDumpProvider* provider() { return provider_; }
+  AllocationSampler* sampler() { return provider_->sampler_.get(); }
+
+  size_t num_sampled_allocations() {
+    AutoLock lock(provider_->allocation_register_lock_);
+    return provider_->num_sampled_allocations_;
+  }
+
+  void InsertIntoRegister(void* address, size_t size) {
+    AutoLock lock(provider_->allocation_register_lock_);
+    provider_->allocation_register_->Insert(address, size,
+                                            AllocationContext());
+  }
+
+  AllocationMetrics GetMetrics() {
+    hash_map<AllocationContext, AllocationMetrics> metrics_by_context;
+    {
+      AutoLock lock(provider_->allocation_register_lock_);
+      provider_->GetMetricsByContext(&metrics_by_context);
+    }
+    EXPECT_EQ(1u, metrics_by_context.size());
+    return metrics_by_context[AllocationContext()];
+  }
+
+ private:
+  MallocDumpProvider* provider_;
+};
+
+TEST_F(MallocDumpProviderTest, SampledAllocations) {
+  // With a sampling interval of 1 byte, allocations of 1 KiB are always
+  // sampled.
+  CreateSamplingProvider(1);
+  void* address1 = reinterpret_cast<void*>(0x1000);
+  void* address2 = reinterpret_cast<void*>(0x2000);
+  void* address3 = reinterpret_cast<void*>(0x3000);
+
+  provider()->InsertAllocation(address1, 1024);
+  provider()->InsertAllocation(address2, 1024);
+  EXPECT_EQ(2u, num_sampled_allocations());
+  EXPECT_TRUE(sampler()->MaybeSampledAddress(address1));
+  EXPECT_TRUE(sampler()->MaybeSampledAddress(address2));
+
+  // An allocation whose free was missed is only counted once.
+  provider()->InsertAllocation(address1, 1024);
+  EXPECT_EQ(2u, num_sampled_allocations());
+
+  // The frees of allocations which weren't sampled are ignored.
+  provider()->RemoveAllocation(address3);
+  EXPECT_EQ(2u, num_sampled_allocations());
+
+  provider()->RemoveAllocation(address1);
+  EXPECT_EQ(1u, num_sampled_allocations());
+  EXPECT_FALSE(sampler()->MaybeSampledAddress(address1));
+  provider()->RemoveAllocation(address2);
+  EXPECT_EQ(0u, num_sampled_allocations());
+  EXPECT_FALSE(sampler()->MaybeSampledAddress(address2));
+}
+
+TEST_F(MallocDumpProviderTest, SampledAllocationsAreScaled) {
+  CreateSamplingProvider(4096);
+  InsertIntoRegister(reinterpret_cast<void*>(0x1000), 1024);
+  InsertIntoRegister(reinterpret_cast<void*>(0x2000), 1024);
+  InsertIntoRegister(reinterpret_cast<void*>(0x3000), 8192);
+
+  // An allocation of 1 KiB is sampled with probability 1 - exp(-1/4), so it
+  // stands for 4629 bytes, that is 4 allocations. One of 8 KiB is sampled with
+  // probability 1 - exp(-2), so it stands for 9474 bytes, and itself only.
+  AllocationMetrics metrics = GetMetrics();
+  EXPECT_EQ(2 * 4629u + 9474u, metrics.size);
+  EXPECT_EQ(2 * 4u + 1u, metrics.count);
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -18,6 +18,7 @@
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/trace_event/heap_profiler.h"
 #include "base/trace_event/heap_profiler_allocation_context_tracker.h"
+#include "base/trace_event/heap_profiler_allocation_sampler.h"
 #include "base/trace_event/heap_profiler_stack_frame_deduplicator.h"
 #include "base/trace_event/heap_profiler_type_name_deduplicator.h"
 #include "base/trace_event/malloc_dump_provider.h"
@@ -136,7 +137,8 @@ MemoryDumpManager::MemoryDumpManager()
       memory_tracing_enabled_(0),
       tracing_process_id_(kInvalidTracingProcessId),
       dumper_registrations_ignored_for_testing_(false),
-      heap_profiling_enabled_(false) {
+      heap_profiling_enabled_(false),
+      heap_profiling_sampled_(false) {
   g_next_guid.GetNext();  // Make sure that first guid is not zero.
 
   // At this point the command line may not be initialized but we try to
@@ -174,15 +176,45 @@ void MemoryDumpManager::EnableHeapProfilingIfNeeded() {
     CHECK(false) << "'" << profiling_mode << "' mode for "
                  << switches::kEnableHeapProfiling << " flag is not supported "
                  << "for this platform / build type.";
+#endif
+  } else if (profiling_mode == switches::kEnableHeapProfilingModeSampling) {
+#if defined(MALLOC_MEMORY_TRACING_SUPPORTED)
+    // Only the sampled allocations capture their native stack, so they can
+    // afford to unwind it in builds without frame pointers.
+    MallocDumpProvider::GetInstance()->EnableSampling(
+        AllocationSampler::kDefaultSamplingInterval);
+    AllocationContextTracker::SetCaptureMode(
+        AllocationContextTracker::CaptureMode::NATIVE_STACK);
+    heap_profiling_sampled_ = true;
+#else
+    CHECK(false) << "'" << profiling_mode << "' mode for "
+                 << switches::kEnableHeapProfiling << " flag is not supported "
+                 << "for this platform.";
 #endif
   } else {
     CHECK(false) << "Invalid mode '" << profiling_mode << "' for "
                << switches::kEnableHeapProfiling << " flag.";
   }
 
-  for (auto mdp : dump_providers_)
-    mdp->dump_provider->OnHeapProfilingEnabled(true);
   heap_profiling_enabled_ = true;
+  for (auto mdp : dump_providers_) {
+    if (IsHeapProfilingEnabledFor(mdp->dump_provider))
+      mdp->dump_provider->OnHeapProfilingEnabled(true);
+  }
+}
+
+bool MemoryDumpManager::IsHeapProfilingEnabledFor(
+    const MemoryDumpProvider* mdp) const {
+  if (!heap_profiling_enabled_)
+    return false;
+#if defined(MALLOC_MEMORY_TRACING_SUPPORTED)
+  if (mdp == MallocDumpProvider::GetInstance())
+    return true;
+#endif
+  // Only malloc allocations are sampled. The other dump providers would record
+  // all of their allocations, and unwind the stack of each of them when there
+  // are no frame pointers.
+  return !heap_profiling_sampled_;
 }
 
 void MemoryDumpManager::Initialize(MemoryDumpManagerDelegate* delegate,
@@ -271,7 +303,7 @@ void MemoryDumpManager::RegisterDumpProviderInternal(
       return;
   }
 
-  if (heap_profiling_enabled_)
+  if (IsHeapProfilingEnabledFor(mdp))
     mdp->OnHeapProfilingEnabled(true);
 }
 
@@ -307,6 +307,9 @@ class BASE_EXPORT MemoryDumpManager : public TraceLog::EnabledStateObserver {
   // Enable heap profiling if kEnableHeapProfiling is specified.
   void EnableHeapProfilingIfNeeded();
 
+  // Returns true if |mdp| must be told to enable heap profiling.
+  bool IsHeapProfilingEnabledFor(const MemoryDumpProvider* mdp) const;
+
   // Internal, used only by MemoryDumpManagerDelegate.
   // Creates a memory dump for the current process and appends it to the trace.
   // |callback| will be invoked asynchronously upon completion on the same
@@ -373,6 +376,10 @@ class BASE_EXPORT MemoryDumpManager : public TraceLog::EnabledStateObserver {
   // Whether new memory dump providers should be told to enable heap profiling.
   bool heap_profiling_enabled_;
 
+  // Whether heap profiling is in sampling mode, in which only the malloc dump
+  // provider is told to enable heap profiling.
+  bool heap_profiling_sampled_;
+
   DISALLOW_COPY_AND_ASSIGN(MemoryDumpManager);
 };
 
@@ -10,6 +10,7 @@
 
 #include "base/macros.h"
 #include "base/trace_event/heap_profiler.h"
+#include "base/trace_event/trace_chunk_streamer.h"
 #include "base/trace_event/trace_event_impl.h"
 
 namespace base {
@@ -240,6 +241,52 @@ class TraceBufferVector : public TraceBuffer {
   DISALLOW_COPY_AND_ASSIGN(TraceBufferVector);
 };
 
+class TraceBufferStreaming : public TraceBuffer {
+ public:
+  explicit TraceBufferStreaming(
+      scoped_refptr<TraceChunkStreamer> chunk_streamer)
+      : chunk_streamer_(std::move(chunk_streamer)) {}
+
+  // Finishing the streamer blocks, so TraceLog does it once it has released
+  // its lock, rather than when the buffer is destroyed.
+  ~TraceBufferStreaming() override {}
+
+  std::unique_ptr<TraceBufferChunk> GetChunk(size_t* index) override {
+    return chunk_streamer_->GetChunk(index);
+  }
+
+  void ReturnChunk(size_t index,
+                   std::unique_ptr<TraceBufferChunk> chunk) override {
+    chunk_streamer_->ReturnChunk(index, std::move(chunk));
+  }
+
+  bool IsFull() const override { return false; }
+
+  size_t Size() const override { return chunk_streamer_->Size(); }
+
+  size_t Capacity() const override { return chunk_streamer_->Capacity(); }
+
+  TraceEvent* GetEventByHandle(TraceEventHandle handle) override {
+    return NULL;
+  }
+
+  const TraceBufferChunk* NextChunk() override { return NULL; }
+
+  void EstimateTraceMemoryOverhead(
+      TraceEventMemoryOverhead* overhead) override {
+    overhead->Add("TraceBufferStreaming", sizeof(*this));
+    overhead->Add("TraceBufferChunk",
+                  chunk_streamer_->Size() /
+                      TraceBufferChunk::kTraceBufferChunkSize *
+                      sizeof(TraceBufferChunk));
+  }
+
+ private:
+  scoped_refptr<TraceChunkStreamer> chunk_streamer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceBufferStreaming);
+};
+
 }  // namespace
 
 TraceBufferChunk::TraceBufferChunk(uint32_t seq) : next_free_(0), seq_(seq) {}
@@ -340,5 +387,10 @@ TraceBuffer* TraceBuffer::CreateTraceBufferVectorOfSize(size_t max_chunks) {
   return new TraceBufferVector(max_chunks);
 }
 
+TraceBuffer* TraceBuffer::CreateTraceBufferStreaming(
+    scoped_refptr<TraceChunkStreamer> chunk_streamer) {
+  return new TraceBufferStreaming(std::move(chunk_streamer));
+}
+
 }  // namespace trace_event
 }  // namespace base
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include "base/base_export.h"
+#include "base/memory/ref_counted.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_impl.h"
 
@@ -16,6 +17,8 @@ namespace base {
 
 namespace trace_event {
 
+class TraceChunkStreamer;
+
 // TraceBufferChunk is the basic unit of TraceBuffer.
 class BASE_EXPORT TraceBufferChunk {
  public:
@@ -79,6 +82,11 @@ class BASE_EXPORT TraceBuffer {
 
   static TraceBuffer* CreateTraceBufferRingBuffer(size_t max_chunks);
   static TraceBuffer* CreateTraceBufferVectorOfSize(size_t max_chunks);
+  // Hands the chunks to |chunk_streamer| to be written to its file, and
+  // finishes it when destroyed. It can't be iterated, and its events can't be
+  // looked up once their chunk has been handed back.
+  static TraceBuffer* CreateTraceBufferStreaming(
+      scoped_refptr<TraceChunkStreamer> chunk_streamer);
 };
 
 // TraceResultBuffer collects and converts trace fragments returned by TraceLog
@@ -0,0 +1,250 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/trace_chunk_streamer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/format_macros.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const uint32_t kIndexMask = 0xffff;
+const int kTagShift = 16;
+
+// The events are buffered up to this size before being written.
+const size_t kWriteBufferSize = 100 * 1024;
+
+// The writer thread wakes up at least this often to write the full chunks.
+const int kWriteIntervalMs = 100;
+
+uint32_t IndexOf(subtle::Atomic32 list_head) {
+  return static_cast<uint32_t>(list_head) & kIndexMask;
+}
+
+uint32_t TagOf(subtle::Atomic32 list_head) {
+  return static_cast<uint32_t>(list_head) >> kTagShift;
+}
+
+subtle::Atomic32 MakeListHead(uint32_t tag, uint32_t index) {
+  return static_cast<subtle::Atomic32>((tag << kTagShift) | index);
+}
+
+}  // namespace
+
+TraceChunkStreamer::TraceChunkStreamer(
+    File file,
+    size_t max_chunks,
+    const ArgumentFilterPredicate& argument_filter_predicate)
+    : max_chunks_(max_chunks),
+      chunks_(new std::unique_ptr<TraceBufferChunk>[max_chunks]),
+      next_indices_(new subtle::Atomic32[max_chunks]),
+      free_list_head_(0),
+      full_list_head_(0),
+      num_created_chunks_(0),
+      num_full_chunks_(0),
+      next_chunk_seq_(0),
+      dropped_events_(0),
+      finishing_(0),
+      started_(false),
+      wake_up_event_(WaitableEvent::ResetPolicy::AUTOMATIC,
+                     WaitableEvent::InitialState::NOT_SIGNALED),
+      file_(std::move(file)),
+      argument_filter_predicate_(argument_filter_predicate),
+      has_written_event_(false) {
+  DCHECK(file_.IsValid());
+  DCHECK_GT(max_chunks, 0u);
+  CHECK_LE(max_chunks, kMaxChunks);
+}
+
+TraceChunkStreamer::~TraceChunkStreamer() {
+  DCHECK(!started_);
+}
+
+bool TraceChunkStreamer::Start() {
+  DCHECK(!started_);
+  started_ = PlatformThread::Create(0, this, &thread_handle_);
+  return started_;
+}
+
+std::unique_ptr<TraceBufferChunk> TraceChunkStreamer::GetChunk(size_t* index) {
+  if (PopFreeIndex(index)) {
+    std::unique_ptr<TraceBufferChunk> chunk = std::move(chunks_[*index]);
+    chunk->Reset(NextChunkSeq());
+    return chunk;
+  }
+
+  // Create a chunk if the pool isn't exhausted yet. The check before the
+  // increment keeps the counter from growing once it is.
+  if (static_cast<size_t>(subtle::NoBarrier_Load(&num_created_chunks_)) <
+      max_chunks_) {
+    *index = static_cast<size_t>(
+        subtle::NoBarrier_AtomicIncrement(&num_created_chunks_, 1) - 1);
+    if (*index < max_chunks_) {
+      return std::unique_ptr<TraceBufferChunk>(
+          new TraceBufferChunk(NextChunkSeq()));
+    }
+  }
+
+  subtle::NoBarrier_AtomicIncrement(&dropped_events_, 1);
+  return nullptr;
+}
+
+void TraceChunkStreamer::ReturnChunk(size_t index,
+                                     std::unique_ptr<TraceBufferChunk> chunk) {
+  DCHECK_LT(index, max_chunks_);
+  DCHECK(!chunks_[index]);
+  chunks_[index] = std::move(chunk);
+  PushIndex(&full_list_head_, index);
+  if (subtle::NoBarrier_AtomicIncrement(&num_full_chunks_, 1) ==
+      static_cast<subtle::Atomic32>(max_chunks_ / 4 + 1)) {
+    wake_up_event_.Signal();
+  }
+}
+
+void TraceChunkStreamer::Finish() {
+  if (!started_)
+    return;
+  subtle::Release_Store(&finishing_, 1);
+  wake_up_event_.Signal();
+  PlatformThread::Join(thread_handle_);
+  started_ = false;
+}
+
+size_t TraceChunkStreamer::Size() const {
+  size_t num_chunks = std::min(
+      static_cast<size_t>(subtle::NoBarrier_Load(&num_created_chunks_)),
+      max_chunks_);
+  return num_chunks * TraceBufferChunk::kTraceBufferChunkSize;
+}
+
+size_t TraceChunkStreamer::Capacity() const {
+  return max_chunks_ * TraceBufferChunk::kTraceBufferChunkSize;
+}
+
+void TraceChunkStreamer::ThreadMain() {
+  PlatformThread::SetName("TraceChunkStreamer");
+  buffer_ = "{\"traceEvents\":[";
+
+  bool finishing = false;
+  while (!finishing) {
+    wake_up_event_.TimedWait(TimeDelta::FromMilliseconds(kWriteIntervalMs));
+    // Chunks handed back before Finish() are in the list once this is seen.
+    finishing = !!subtle::Acquire_Load(&finishing_);
+    WriteFullChunks();
+  }
+
+  StringAppendF(&buffer_,
+                "],\"metadata\":{\"dropped-trace-events\":%" PRIuS "}}",
+                dropped_events());
+  WriteBuffer();
+  file_.Close();
+}
+
+uint32_t TraceChunkStreamer::NextChunkSeq() {
+  uint32_t seq;
+  // Zero isn't a valid sequence number.
+  do {
+    seq = static_cast<uint32_t>(
+        subtle::NoBarrier_AtomicIncrement(&next_chunk_seq_, 1));
+  } while (!seq);
+  return seq;
+}
+
+void TraceChunkStreamer::PushIndex(volatile subtle::Atomic32* list_head,
+                                   size_t index) {
+  subtle::Atomic32 head = subtle::NoBarrier_Load(list_head);
+  for (;;) {
+    subtle::NoBarrier_Store(&next_indices_[index],
+                            static_cast<subtle::Atomic32>(IndexOf(head)));
+    subtle::Atomic32 new_head =
+        MakeListHead(TagOf(head), static_cast<uint32_t>(index) + 1);
+    // Publishes the chunk along with the list.
+    subtle::Atomic32 previous_head =
+        subtle::Release_CompareAndSwap(list_head, head, new_head);
+    if (previous_head == head)
+      return;
+    head = previous_head;
+  }
+}
+
+bool TraceChunkStreamer::PopFreeIndex(size_t* index) {
+  subtle::Atomic32 head = subtle::Acquire_Load(&free_list_head_);
+  for (;;) {
+    uint32_t first = IndexOf(head);
+    if (!first)
+      return false;
+    uint32_t next = static_cast<uint32_t>(
+        subtle::NoBarrier_Load(&next_indices_[first - 1]));
+    subtle::Atomic32 new_head = MakeListHead(TagOf(head) + 1, next);
+    subtle::Atomic32 previous_head =
+        subtle::Acquire_CompareAndSwap(&free_list_head_, head, new_head);
+    if (previous_head == head) {
+      *index = first - 1;
+      return true;
+    }
+    head = previous_head;
+  }
+}
+
+void TraceChunkStreamer::WriteFullChunks() {
+  // Take the whole list at once. As there is a single consumer, its head
+  // doesn't need a tag.
+  subtle::Atomic32 head = subtle::NoBarrier_Load(&full_list_head_);
+  for (;;) {
+    if (!IndexOf(head))
+      return;
+    subtle::Atomic32 previous_head =
+        subtle::Acquire_CompareAndSwap(&full_list_head_, head, 0);
+    if (previous_head == head)
+      break;
+    head = previous_head;
+  }
+
+  full_indices_.clear();
+  for (uint32_t index = IndexOf(head); index;
+       index = static_cast<uint32_t>(
+           subtle::NoBarrier_Load(&next_indices_[index - 1]))) {
+    full_indices_.push_back(index - 1);
+  }
+  subtle::NoBarrier_AtomicIncrement(
+      &num_full_chunks_, -static_cast<subtle::Atomic32>(full_indices_.size()));
+
+  // The list is in the reverse order of the chunks being handed back.
+  for (auto it = full_indices_.rbegin(); it != full_indices_.rend(); ++it) {
+    TraceBufferChunk* chunk = chunks_[*it].get();
+    for (size_t i = 0; i < chunk->size(); ++i) {
+      if (has_written_event_)
+        buffer_.append(",\n");
+      has_written_event_ = true;
+      chunk->GetEventAt(i)->AppendAsJSON(&buffer_, argument_filter_predicate_);
+      if (buffer_.size() >= kWriteBufferSize)
+        WriteBuffer();
+    }
+    // Releasing the arguments here keeps it off the threads adding events.
+    chunk->Reset(chunk->seq());
+    PushIndex(&free_list_head_, *it);
+  }
+  WriteBuffer();
+}
+
+void TraceChunkStreamer::WriteBuffer() {
+  if (buffer_.empty())
+    return;
+  if (file_.WriteAtCurrentPos(buffer_.data(),
+                              static_cast<int>(buffer_.size())) < 0) {
+    DLOG(ERROR) << "Failed to write the trace events.";
+  }
+  buffer_.clear();
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,137 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_TRACE_CHUNK_STREAMER_H_
+#define BASE_TRACE_EVENT_TRACE_CHUNK_STREAMER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/files/file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_buffer.h"
+#include "base/trace_event/trace_event_impl.h"
+
+namespace base {
+namespace trace_event {
+
+// TraceChunkStreamer writes trace events to a file as the chunks holding them
+// fill up, so that the length of a trace isn't bounded by an in-memory buffer.
+//
+// The chunks come from a pool of at most |max_chunks| chunks. Getting an empty
+// chunk and handing back a full one are lock-free, so the threads adding trace
+// events don't contend on TraceLog's lock when their thread-local chunk fills
+// up. A background thread writes the full chunks to the file in the JSON trace
+// format, and recycles them into the pool. When the writer falls behind and
+// every chunk is in use, events are dropped rather than blocking the threads
+// adding them, and the number of dropped events is recorded in the file.
+class BASE_EXPORT TraceChunkStreamer
+    : public RefCountedThreadSafe<TraceChunkStreamer>,
+      public PlatformThread::Delegate {
+ public:
+  // The pool is indexed with 16 bits.
+  static const size_t kMaxChunks = 0xffff;
+
+  // Writes to |file|, which must be valid, empty and open for writing. The
+  // arguments of the events are filtered with |argument_filter_predicate| if
+  // it isn't null.
+  TraceChunkStreamer(File file,
+                     size_t max_chunks,
+                     const ArgumentFilterPredicate& argument_filter_predicate);
+
+  // Starts the writer thread. Returns false if it couldn't be created.
+  bool Start();
+
+  // Returns an empty chunk and stores its index in |index|, or returns null if
+  // all the chunks are in use, in which case the event the chunk was wanted
+  // for is counted as dropped. Thread-safe and lock-free.
+  std::unique_ptr<TraceBufferChunk> GetChunk(size_t* index);
+
+  // Hands back |chunk|, which was returned by GetChunk() with |index|, for its
+  // events to be written. Thread-safe and lock-free. Chunks handed back after
+  // Finish() are discarded.
+  void ReturnChunk(size_t index, std::unique_ptr<TraceBufferChunk> chunk);
+
+  // Writes the chunks which were handed back and the end of the file, and
+  // closes it. Blocks until the writer thread is done. Does nothing if called
+  // again, or if Start() failed.
+  void Finish();
+
+  // Approximate number of events held by the pool, and its capacity.
+  size_t Size() const;
+  size_t Capacity() const;
+
+  // Number of events dropped because all the chunks were in use.
+  size_t dropped_events() const {
+    return static_cast<size_t>(subtle::NoBarrier_Load(&dropped_events_));
+  }
+
+  // PlatformThread::Delegate implementation.
+  void ThreadMain() override;
+
+ private:
+  friend class RefCountedThreadSafe<TraceChunkStreamer>;
+
+  ~TraceChunkStreamer() override;
+
+  uint32_t NextChunkSeq();
+
+  // The free list and the list of full chunks are singly linked lists of
+  // chunk indices, threaded through |next_indices_|. Their heads pack the
+  // index of the first chunk, plus one, in the low 16 bits, and a tag in the
+  // high 16 bits, which PopFreeIndex() bumps so that a concurrent pop and push
+  // of the same chunk can't be mistaken for an unchanged list.
+  void PushIndex(volatile subtle::Atomic32* list_head, size_t index);
+  bool PopFreeIndex(size_t* index);
+
+  // Called on the writer thread.
+  void WriteFullChunks();
+  void WriteBuffer();
+
+  const size_t max_chunks_;
+  std::unique_ptr<std::unique_ptr<TraceBufferChunk>[]> chunks_;
+  std::unique_ptr<subtle::Atomic32[]> next_indices_;
+
+  subtle::Atomic32 free_list_head_;
+  subtle::Atomic32 full_list_head_;
+
+  // Number of chunks which have been created. Chunks are only created when the
+  // free list is empty.
+  subtle::Atomic32 num_created_chunks_;
+
+  // Number of chunks in the list of full chunks. The writer thread is woken up
+  // early when it reaches a quarter of the pool.
+  subtle::Atomic32 num_full_chunks_;
+
+  subtle::Atomic32 next_chunk_seq_;
+  subtle::AtomicWord dropped_events_;
+  subtle::Atomic32 finishing_;
+
+  PlatformThreadHandle thread_handle_;
+  bool started_;
+  WaitableEvent wake_up_event_;
+
+  // Only accessed on the writer thread once it has started.
+  File file_;
+  const ArgumentFilterPredicate argument_filter_predicate_;
+  std::string buffer_;
+  std::vector<size_t> full_indices_;
+  bool has_written_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceChunkStreamer);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_TRACE_CHUNK_STREAMER_H_
@@ -0,0 +1,137 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/location.h"
+#include "base/memory/ptr_util.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kCategory[] = "perftest";
+const int kNumEventsPerThread = 100000;
+const int kNumThreads[] = {1, 4};
+
+void AddScopedEvents(WaitableEvent* complete_event) {
+  for (int i = 0; i < kNumEventsPerThread; ++i) {
+    TRACE_EVENT0(kCategory, "scoped event");
+  }
+  complete_event->Signal();
+}
+
+// Adds kNumEventsPerThread scoped events on each of |num_threads| threads at
+// the same time, and returns the time it took.
+TimeDelta AddEventsOnThreads(int num_threads) {
+  std::vector<std::unique_ptr<Thread>> threads;
+  std::vector<std::unique_ptr<WaitableEvent>> complete_events;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(
+        WrapUnique(new Thread(StringPrintf("TraceEventPerfTest%d", i))));
+    threads.back()->Start();
+    complete_events.push_back(WrapUnique(
+        new WaitableEvent(WaitableEvent::ResetPolicy::AUTOMATIC,
+                          WaitableEvent::InitialState::NOT_SIGNALED)));
+  }
+
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->task_runner()->PostTask(
+        FROM_HERE, Bind(&AddScopedEvents, complete_events[i].get()));
+  }
+  for (int i = 0; i < num_threads; ++i)
+    complete_events[i]->Wait();
+  TimeDelta elapsed = TimeTicks::Now() - start;
+
+  // Stopping the threads hands their last chunk back to the trace buffer, so
+  // that the trace can be flushed without them.
+  for (int i = 0; i < num_threads; ++i)
+    threads[i]->Stop();
+  return elapsed;
+}
+
+void OnTraceDataCollected(const scoped_refptr<RefCountedString>& events,
+                          bool has_more_events) {}
+
+void DisableAndFlush() {
+  TraceLog::GetInstance()->SetDisabled();
+  // There are no threads with a thread-local buffer left, so this finishes
+  // synchronously.
+  TraceLog::GetInstance()->Flush(Bind(&OnTraceDataCollected));
+}
+
+void PrintTimePerEvent(const std::string& trace,
+                       int num_threads,
+                       TimeDelta elapsed) {
+  perf_test::PrintResult(
+      "add_event", StringPrintf("_%d_threads", num_threads), trace,
+      elapsed.InMillisecondsF() * 1000 / kNumEventsPerThread, "us", true);
+}
+
+}  // namespace
+
+// Measures the time it takes a thread to add a scoped trace event when
+// tracing is disabled, when the events are kept in the in-memory ring buffer,
+// and when they are streamed to a file, with threads adding events
+// concurrently.
+TEST(TraceEventPerfTest, AddEventOverhead) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  for (int num_threads : kNumThreads) {
+    PrintTimePerEvent("disabled", num_threads,
+                      AddEventsOnThreads(num_threads));
+
+    TraceLog::GetInstance()->SetEnabled(
+        TraceConfig(kCategory, RECORD_CONTINUOUSLY), TraceLog::RECORDING_MODE);
+    PrintTimePerEvent("ring_buffer", num_threads,
+                      AddEventsOnThreads(num_threads));
+    DisableAndFlush();
+
+    const FilePath path = temp_dir.path().AppendASCII(
+        StringPrintf("trace_%d_threads.json", num_threads));
+    TraceLog::GetInstance()->SetEnabledWithStreaming(
+        TraceConfig(kCategory, ""), TraceLog::RECORDING_MODE,
+        File(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE));
+    TimeTicks start = TimeTicks::Now();
+    PrintTimePerEvent("streaming", num_threads,
+                      AddEventsOnThreads(num_threads));
+    DisableAndFlush();
+    // Includes writing the rest of the events to the file.
+    perf_test::PrintResult("total_time",
+                           StringPrintf("_%d_threads", num_threads),
+                           "streaming",
+                           (TimeTicks::Now() - start).InMillisecondsF(), "ms",
+                           false);
+    int64_t file_size = 0;
+    ASSERT_TRUE(GetFileSize(path, &file_size));
+    perf_test::PrintResult("file_size",
+                           StringPrintf("_%d_threads", num_threads),
+                           "streaming", file_size / (1024.0 * 1024.0), "MB",
+                           false);
+  }
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -14,6 +14,10 @@
 
 #include "base/bind.h"
 #include "base/command_line.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
 #include "base/location.h"
@@ -30,6 +34,7 @@
 #include "base/threading/thread.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_buffer.h"
+#include "base/trace_event/trace_chunk_streamer.h"
 #include "base/trace_event/trace_event_synthetic_delay.h"
 #include "base/values.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -2878,6 +2883,149 @@ TEST_F(TraceEventTestFixture, TraceRecordAsMuchAsPossibleMode) {
   TraceLog::GetInstance()->SetDisabled();
 }
 
+// Reads a trace written by TraceChunkStreamer.
+std::unique_ptr<DictionaryValue> ReadStreamedTrace(const FilePath& path) {
+  std::string json;
+  if (!ReadFileToString(path, &json))
+    return nullptr;
+  return DictionaryValue::From(JSONReader::Read(json));
+}
+
+size_t CountEventsWithNamePhase(const ListValue& trace_events,
+                                const std::string& name,
+                                const std::string& phase) {
+  size_t count = 0;
+  for (size_t i = 0; i < trace_events.GetSize(); ++i) {
+    const DictionaryValue* event;
+    std::string event_name;
+    std::string event_phase;
+    if (trace_events.GetDictionary(i, &event) &&
+        event->GetString("name", &event_name) &&
+        event->GetString("ph", &event_phase) && event_name == name &&
+        event_phase == phase) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void AddInstantEventToChunk(TraceBufferChunk* chunk, const char* name) {
+  size_t event_index;
+  chunk->AddTraceEvent(&event_index)
+      ->Initialize(0, TimeTicks(), ThreadTicks(), TRACE_EVENT_PHASE_INSTANT,
+                   TraceLog::GetCategoryGroupEnabled("cat"), name,
+                   trace_event_internal::kGlobalScope,
+                   trace_event_internal::kNoId, trace_event_internal::kNoId, 0,
+                   nullptr, nullptr, nullptr, nullptr, TRACE_EVENT_FLAG_NONE);
+}
+
+TEST_F(TraceEventTestFixture, TraceChunkStreamerRecyclesChunks) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("trace.json");
+  scoped_refptr<TraceChunkStreamer> streamer(new TraceChunkStreamer(
+      File(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE), 2,
+      ArgumentFilterPredicate()));
+  ASSERT_TRUE(streamer->Start());
+  EXPECT_EQ(2 * TraceBufferChunk::kTraceBufferChunkSize, streamer->Capacity());
+
+  size_t index0;
+  size_t index1;
+  std::unique_ptr<TraceBufferChunk> chunk0 = streamer->GetChunk(&index0);
+  std::unique_ptr<TraceBufferChunk> chunk1 = streamer->GetChunk(&index1);
+  ASSERT_TRUE(chunk0);
+  ASSERT_TRUE(chunk1);
+  EXPECT_NE(index0, index1);
+  EXPECT_GT(chunk1->seq(), chunk0->seq());
+
+  // All the chunks are in use.
+  size_t index2;
+  EXPECT_FALSE(streamer->GetChunk(&index2));
+  EXPECT_EQ(1u, streamer->dropped_events());
+
+  AddInstantEventToChunk(chunk0.get(), "event0");
+  streamer->ReturnChunk(index0, std::move(chunk0));
+
+  // The chunk is recycled once the writer thread has written it.
+  std::unique_ptr<TraceBufferChunk> chunk2;
+  while (!(chunk2 = streamer->GetChunk(&index2)))
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(index0, index2);
+  EXPECT_EQ(0u, chunk2->size());
+  EXPECT_GT(chunk2->seq(), chunk1->seq());
+
+  AddInstantEventToChunk(chunk1.get(), "event1");
+  streamer->ReturnChunk(index1, std::move(chunk1));
+  streamer->ReturnChunk(index2, std::move(chunk2));
+  streamer->Finish();
+
+  std::unique_ptr<DictionaryValue> trace = ReadStreamedTrace(path);
+  ASSERT_TRUE(trace);
+  ListValue* trace_events;
+  ASSERT_TRUE(trace->GetList("traceEvents", &trace_events));
+  ASSERT_EQ(2u, trace_events->GetSize());
+  EXPECT_EQ(1u, CountEventsWithNamePhase(*trace_events, "event0", "I"));
+  EXPECT_EQ(1u, CountEventsWithNamePhase(*trace_events, "event1", "I"));
+  int dropped_events;
+  ASSERT_TRUE(
+      trace->GetInteger("metadata.dropped-trace-events", &dropped_events));
+  EXPECT_LE(1, dropped_events);
+}
+
+TEST_F(TraceEventTestFixture, TraceStreamingToFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("trace.json");
+  TraceLog::GetInstance()->SetEnabledWithStreaming(
+      TraceConfig(kRecordAllCategoryFilter, ""), TraceLog::RECORDING_MODE,
+      File(path, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE));
+  EXPECT_TRUE(TraceLog::GetInstance()->IsEnabled());
+
+  // Events of a thread with a message loop fill chunks of its own, while the
+  // events of this thread go to the shared chunk.
+  const int kNumEvents = 10 * TraceBufferChunk::kTraceBufferChunkSize;
+  {
+    TRACE_EVENT0("all", "scoped event");
+    Thread thread("streaming thread");
+    thread.Start();
+    WaitableEvent task_complete_event(
+        WaitableEvent::ResetPolicy::AUTOMATIC,
+        WaitableEvent::InitialState::NOT_SIGNALED);
+    thread.task_runner()->PostTask(
+        FROM_HERE,
+        Bind(&TraceManyInstantEvents, 0, kNumEvents, &task_complete_event));
+    task_complete_event.Wait();
+    // Hands the last chunk of the thread back.
+    thread.Stop();
+  }
+
+  EndTraceAndFlush();
+  // The events were written to the file rather than flushed.
+  EXPECT_EQ(0u, trace_parsed_.GetSize());
+
+  std::unique_ptr<DictionaryValue> trace = ReadStreamedTrace(path);
+  ASSERT_TRUE(trace);
+  ListValue* trace_events;
+  ASSERT_TRUE(trace->GetList("traceEvents", &trace_events));
+  EXPECT_EQ(static_cast<size_t>(kNumEvents),
+            CountEventsWithNamePhase(*trace_events, "multi thread event", "I"));
+  // The COMPLETE event was written as BEGIN and END events.
+  EXPECT_EQ(1u, CountEventsWithNamePhase(*trace_events, "scoped event", "B"));
+  EXPECT_EQ(1u, CountEventsWithNamePhase(*trace_events, "scoped event", "E"));
+  EXPECT_EQ(0u, CountEventsWithNamePhase(*trace_events, "scoped event", "X"));
+  EXPECT_LT(0u, CountEventsWithNamePhase(*trace_events, "thread_name", "M"));
+  int dropped_events;
+  ASSERT_TRUE(
+      trace->GetInteger("metadata.dropped-trace-events", &dropped_events));
+  EXPECT_EQ(0, dropped_events);
+
+  // The next trace is kept in memory again.
+  BeginTrace();
+  TRACE_EVENT_INSTANT0("all", "in memory event", TRACE_EVENT_SCOPE_THREAD);
+  EndTraceAndFlush();
+  EXPECT_TRUE(FindNamePhase("in memory event", "I"));
+}
+
 void BlockUntilStopped(WaitableEvent* task_start_event,
                        WaitableEvent* task_stop_event) {
   task_start_event->Signal();
@@ -13,6 +13,7 @@
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/debug/leak_annotations.h"
+#include "base/files/file.h"
 #include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/macros.h"
@@ -36,6 +37,7 @@
 #include "base/trace_event/memory_dump_provider.h"
 #include "base/trace_event/process_memory_dump.h"
 #include "base/trace_event/trace_buffer.h"
+#include "base/trace_event/trace_chunk_streamer.h"
 #include "base/trace_event/trace_event.h"
 #include "base/trace_event/trace_event_synthetic_delay.h"
 #include "base/trace_event/trace_sampling_thread.h"
@@ -235,6 +237,9 @@ class TraceLog::ThreadLocalEventBuffer
 
   void FlushWhileLocked();
 
+  // Hands the chunk back to |chunk_streamer_|, which doesn't need the lock.
+  void FlushToStreamer();
+
   void CheckThisIsCurrentBuffer() const {
     DCHECK(trace_log_->thread_local_event_buffer_.Get() == this);
   }
@@ -245,14 +250,14 @@ class TraceLog::ThreadLocalEventBuffer
   std::unique_ptr<TraceBufferChunk> chunk_;
   size_t chunk_index_;
   int generation_;
+  // Set when the trace events of |generation_| are streamed to a file.
+  scoped_refptr<TraceChunkStreamer> chunk_streamer_;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadLocalEventBuffer);
 };
 
 TraceLog::ThreadLocalEventBuffer::ThreadLocalEventBuffer(TraceLog* trace_log)
-    : trace_log_(trace_log),
-      chunk_index_(0),
-      generation_(trace_log->generation()) {
+    : trace_log_(trace_log), chunk_index_(0), generation_(0) {
   // ThreadLocalEventBuffer is created only if the thread has a message loop, so
   // the following message_loop won't be NULL.
   MessageLoop* message_loop = MessageLoop::current();
@@ -263,6 +268,10 @@ TraceLog::ThreadLocalEventBuffer::ThreadLocalEventBuffer(TraceLog* trace_log)
       this, "ThreadLocalEventBuffer", ThreadTaskRunnerHandle::Get());
 
   AutoLock lock(trace_log->lock_);
+  // The generation and the streamer are only changed with the lock held, so
+  // they belong to the same trace.
+  generation_ = trace_log->generation();
+  chunk_streamer_ = trace_log->chunk_streamer_;
   trace_log->thread_message_loops_.insert(message_loop);
 }
 
@@ -283,15 +292,22 @@ TraceEvent* TraceLog::ThreadLocalEventBuffer::AddTraceEvent(
     TraceEventHandle* handle) {
   CheckThisIsCurrentBuffer();
 
-  if (chunk_ && chunk_->IsFull()) {
-    AutoLock lock(trace_log_->lock_);
-    FlushWhileLocked();
-    chunk_.reset();
-  }
-  if (!chunk_) {
-    AutoLock lock(trace_log_->lock_);
-    chunk_ = trace_log_->logged_events_->GetChunk(&chunk_index_);
-    trace_log_->CheckIfBufferIsFullWhileLocked();
+  if (chunk_streamer_) {
+    if (chunk_ && chunk_->IsFull())
+      FlushToStreamer();
+    if (!chunk_)
+      chunk_ = chunk_streamer_->GetChunk(&chunk_index_);
+  } else {
+    if (chunk_ && chunk_->IsFull()) {
+      AutoLock lock(trace_log_->lock_);
+      FlushWhileLocked();
+      chunk_.reset();
+    }
+    if (!chunk_) {
+      AutoLock lock(trace_log_->lock_);
+      chunk_ = trace_log_->logged_events_->GetChunk(&chunk_index_);
+      trace_log_->CheckIfBufferIsFullWhileLocked();
+    }
   }
   if (!chunk_)
     return NULL;
@@ -325,6 +341,10 @@ void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
     return;
 
   trace_log_->lock_.AssertAcquired();
+  if (chunk_streamer_) {
+    FlushToStreamer();
+    return;
+  }
   if (trace_log_->CheckGeneration(generation_)) {
     // Return the chunk to the buffer only if the generation matches.
     trace_log_->logged_events_->ReturnChunk(chunk_index_, std::move(chunk_));
@@ -333,6 +353,13 @@ void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
   // find the generation mismatch and delete this buffer soon.
 }
 
+void TraceLog::ThreadLocalEventBuffer::FlushToStreamer() {
+  // As in FlushWhileLocked(), the chunk of a previous trace is discarded.
+  if (trace_log_->CheckGeneration(generation_))
+    chunk_streamer_->ReturnChunk(chunk_index_, std::move(chunk_));
+  chunk_.reset();
+}
+
 struct TraceLog::RegisteredAsyncObserver {
   RegisteredAsyncObserver(WeakPtr<AsyncEnabledStateObserver> observer)
       : observer(observer), task_runner(ThreadTaskRunnerHandle::Get()) {}
@@ -391,7 +418,11 @@ TraceLog::TraceLog()
                                                          nullptr);
 }
 
-TraceLog::~TraceLog() {}
+TraceLog::~TraceLog() {
+  // Only happens in tests, when a streamed trace wasn't flushed.
+  if (chunk_streamer_)
+    chunk_streamer_->Finish();
+}
 
 void TraceLog::InitializeThreadLocalEventBufferIfSupported() {
   // A ThreadLocalEventBuffer needs the message loop
@@ -584,8 +615,22 @@ void TraceLog::GetKnownCategoryGroups(
 }
 
 void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
+  SetEnabledInternal(trace_config, mode, File());
+}
+
+void TraceLog::SetEnabledWithStreaming(const TraceConfig& trace_config,
+                                       Mode mode,
+                                       File file) {
+  DCHECK(file.IsValid());
+  SetEnabledInternal(trace_config, mode, std::move(file));
+}
+
+void TraceLog::SetEnabledInternal(const TraceConfig& trace_config,
+                                  Mode mode,
+                                  File streaming_file) {
   std::vector<EnabledStateObserver*> observer_list;
   std::map<AsyncEnabledStateObserver*, RegisteredAsyncObserver> observer_map;
+  scoped_refptr<TraceChunkStreamer> previous_chunk_streamer;
   {
     AutoLock lock(lock_);
 
@@ -598,7 +643,10 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
     InternalTraceOptions old_options = trace_options();
 
     if (IsEnabled()) {
-      if (new_options != old_options) {
+      if (streaming_file.IsValid())
+        DLOG(ERROR) << "Cannot stream a trace which is already enabled.";
+
+      if (new_options != (old_options & ~kInternalStreamToFile)) {
         DLOG(ERROR) << "Attempting to re-enable tracing with a different "
                     << "set of options.";
       }
@@ -620,7 +668,26 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
 
     mode_ = mode;
 
-    if (new_options != old_options) {
+    // A streamed trace which wasn't flushed ends with its buffer, which is
+    // replaced below. Its streamer is finished once the lock is released.
+    previous_chunk_streamer.swap(chunk_streamer_);
+
+    if (streaming_file.IsValid()) {
+      chunk_streamer_ = new TraceChunkStreamer(
+          std::move(streaming_file), kTraceEventRingBufferChunks,
+          (new_options & kInternalEnableArgumentFilter)
+              ? argument_filter_predicate_
+              : ArgumentFilterPredicate());
+      if (chunk_streamer_->Start()) {
+        new_options |= kInternalStreamToFile;
+      } else {
+        DLOG(ERROR) << "Failed to start streaming the trace.";
+        chunk_streamer_ = nullptr;
+      }
+    }
+
+    // A streamed trace always needs a buffer of its own.
+    if (new_options != old_options || (new_options & kInternalStreamToFile)) {
       subtle::NoBarrier_Store(&trace_options_, new_options);
       UseNextTraceBuffer();
     }
@@ -652,6 +719,9 @@ void TraceLog::SetEnabled(const TraceConfig& trace_config, Mode mode) {
     observer_list = enabled_state_observer_list_;
     observer_map = async_observers_;
   }
+  if (previous_chunk_streamer)
+    FinishChunkStreamer(std::move(previous_chunk_streamer), OutputCallback());
+
   // Notify observers outside the lock in case they trigger trace events.
   for (size_t i = 0; i < observer_list.size(); ++i)
     observer_list[i]->OnTraceLogEnabled();
@@ -960,6 +1030,7 @@ void TraceLog::ConvertTraceEventsToTraceFormat(
 
 void TraceLog::FinishFlush(int generation, bool discard_events) {
   std::unique_ptr<TraceBuffer> previous_logged_events;
+  scoped_refptr<TraceChunkStreamer> chunk_streamer;
   OutputCallback flush_output_callback;
   ArgumentFilterPredicate argument_filter_predicate;
 
@@ -970,6 +1041,13 @@ void TraceLog::FinishFlush(int generation, bool discard_events) {
     AutoLock lock(lock_);
 
     previous_logged_events.swap(logged_events_);
+    if (trace_options() & kInternalStreamToFile) {
+      // The next trace is only streamed if SetEnabledWithStreaming() is called
+      // again.
+      chunk_streamer.swap(chunk_streamer_);
+      subtle::NoBarrier_Store(&trace_options_,
+                              trace_options() & ~kInternalStreamToFile);
+    }
     UseNextTraceBuffer();
     thread_message_loops_.clear();
 
@@ -983,6 +1061,14 @@ void TraceLog::FinishFlush(int generation, bool discard_events) {
     }
   }
 
+  // All the chunks have been handed back to the streamer by now, so the file
+  // is complete once it finishes. The events are in the file rather than in
+  // |previous_logged_events|.
+  if (chunk_streamer) {
+    FinishChunkStreamer(std::move(chunk_streamer), flush_output_callback);
+    return;
+  }
+
   if (discard_events) {
     if (!flush_output_callback.is_null()) {
       scoped_refptr<RefCountedString> empty_result = new RefCountedString;
@@ -1005,6 +1091,34 @@ void TraceLog::FinishFlush(int generation, bool discard_events) {
                                   argument_filter_predicate);
 }
 
+// static
+void TraceLog::FinishChunkStreamer(
+    scoped_refptr<TraceChunkStreamer> chunk_streamer,
+    const OutputCallback& flush_output_callback) {
+  // Finishing joins the writer thread, which waits for its file I/O, so it is
+  // done on a worker thread rather than on the flushing thread, which can be
+  // the UI thread.
+  if (WorkerPool::PostTask(FROM_HERE,
+                           Bind(&TraceLog::FinishChunkStreamerOnWorkerThread,
+                                std::move(chunk_streamer),
+                                flush_output_callback),
+                           true)) {
+    return;
+  }
+  FinishChunkStreamerOnWorkerThread(std::move(chunk_streamer),
+                                    flush_output_callback);
+}
+
+// static
+void TraceLog::FinishChunkStreamerOnWorkerThread(
+    scoped_refptr<TraceChunkStreamer> chunk_streamer,
+    const OutputCallback& flush_output_callback) {
+  chunk_streamer->Finish();
+  // The flush completes once the file does.
+  if (!flush_output_callback.is_null())
+    flush_output_callback.Run(new RefCountedString, false);
+}
+
 // Run in each thread holding a local event buffer.
 void TraceLog::FlushCurrentThread(int generation, bool discard_events) {
   {
@@ -1051,6 +1165,8 @@ void TraceLog::OnFlushTimeout(int generation, bool discard_events) {
 }
 
 void TraceLog::UseNextTraceBuffer() {
+  if (!(trace_options() & kInternalStreamToFile))
+    chunk_streamer_ = nullptr;
   logged_events_.reset(CreateTraceBuffer());
   subtle::NoBarrier_AtomicIncrement(&generation_, 1);
   thread_shared_chunk_.reset();
@@ -1214,6 +1330,13 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamp(
   DCHECK(name);
   DCHECK(!timestamp.is_null());
 
+  // The chunk of a COMPLETE event may be written before the event ends, so
+  // UpdateTraceEventDuration() adds an END event instead.
+  if (phase == TRACE_EVENT_PHASE_COMPLETE &&
+      (trace_options() & kInternalStreamToFile)) {
+    phase = TRACE_EVENT_PHASE_BEGIN;
+  }
+
   if (flags & TRACE_EVENT_FLAG_MANGLE_ID) {
     if ((flags & TRACE_EVENT_FLAG_FLOW_IN) ||
         (flags & TRACE_EVENT_FLAG_FLOW_OUT))
@@ -1453,6 +1576,17 @@ void TraceLog::UpdateTraceEventDuration(
   if (thread_is_in_trace_event_.Get())
     return;
 
+  // The event was recorded as a BEGIN event.
+  if (trace_options() & kInternalStreamToFile) {
+    AddTraceEventWithThreadIdAndTimestamp(
+        TRACE_EVENT_PHASE_END, category_group_enabled, name,
+        trace_event_internal::kGlobalScope, trace_event_internal::kNoId,
+        trace_event_internal::kNoId,
+        static_cast<int>(PlatformThread::CurrentId()), TimeTicks::Now(), 0,
+        nullptr, nullptr, nullptr, nullptr, TRACE_EVENT_FLAG_NONE);
+    return;
+  }
+
   AutoThreadLocalBoolean thread_is_in_trace_event(&thread_is_in_trace_event_);
 
   ThreadTicks thread_now = ThreadNow();
@@ -1534,7 +1668,9 @@ void TraceLog::AddMetadataEventsWhileLocked() {
   // Move metadata added by |AddMetadataEvent| into the trace log.
   while (!metadata_events_.empty()) {
     TraceEvent* event = AddEventToThreadSharedChunkWhileLocked(nullptr, false);
-    event->MoveFrom(std::move(metadata_events_.back()));
+    // A streaming buffer may have no chunk left.
+    if (event)
+      event->MoveFrom(std::move(metadata_events_.back()));
     metadata_events_.pop_back();
   }
 
@@ -1702,6 +1838,8 @@ void TraceLog::SetCurrentThreadBlocksMessageLoop() {
 TraceBuffer* TraceLog::CreateTraceBuffer() {
   HEAP_PROFILER_SCOPED_IGNORE;
   InternalTraceOptions options = trace_options();
+  if (options & kInternalStreamToFile)
+    return TraceBuffer::CreateTraceBufferStreaming(chunk_streamer_);
   if (options & kInternalRecordContinuously)
     return TraceBuffer::CreateTraceBufferRingBuffer(
         kTraceEventRingBufferChunks);
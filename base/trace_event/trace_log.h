@@ -16,6 +16,7 @@
 #include "base/containers/hash_tables.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_vector.h"
 #include "base/trace_event/memory_dump_provider.h"
 #include "base/trace_event/trace_config.h"
@@ -24,6 +25,8 @@
 
 namespace base {
 
+class File;
+
 template <typename Type>
 struct DefaultSingletonTraits;
 class RefCountedString;
@@ -32,6 +35,7 @@ namespace trace_event {
 
 class TraceBuffer;
 class TraceBufferChunk;
+class TraceChunkStreamer;
 class TraceEvent;
 class TraceEventMemoryOverhead;
 class TraceSamplingThread;
@@ -82,6 +86,18 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   // be merged into the current category filter.
   void SetEnabled(const TraceConfig& trace_config, Mode mode);
 
+  // Enables tracing like SetEnabled(), but instead of keeping the trace events
+  // in a bounded in-memory buffer, streams them to |file| in the JSON trace
+  // format from a background thread, as the chunks of the threads fill up.
+  // The record mode of |trace_config| is ignored. COMPLETE events are recorded
+  // as BEGIN and END events, as their chunk may have been written by the time
+  // they end. |file| is complete once the Flush() following SetDisabled() has
+  // run its callback, which gets no events. Tracing must not already be
+  // enabled.
+  void SetEnabledWithStreaming(const TraceConfig& trace_config,
+                               Mode mode,
+                               File file);
+
   // Disables normal tracing for all categories.
   void SetDisabled();
 
@@ -391,6 +407,9 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
 
   TraceLog();
   ~TraceLog() override;
+  void SetEnabledInternal(const TraceConfig& trace_config,
+                          Mode mode,
+                          File streaming_file);
   const unsigned char* GetCategoryGroupEnabledInternal(const char* name);
   void AddMetadataEventsWhileLocked();
 
@@ -427,6 +446,14 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
       const TraceLog::OutputCallback& flush_output_callback,
       const ArgumentFilterPredicate& argument_filter_predicate);
   void FinishFlush(int generation, bool discard_events);
+  // Finishes |chunk_streamer| on a worker thread, since it blocks, then runs
+  // |flush_output_callback| if it isn't null. Call without |lock_| held.
+  static void FinishChunkStreamer(
+      scoped_refptr<TraceChunkStreamer> chunk_streamer,
+      const OutputCallback& flush_output_callback);
+  static void FinishChunkStreamerOnWorkerThread(
+      scoped_refptr<TraceChunkStreamer> chunk_streamer,
+      const OutputCallback& flush_output_callback);
   void OnFlushTimeout(int generation, bool discard_events);
 
   int generation() const {
@@ -451,6 +478,7 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   static const InternalTraceOptions kInternalEnableSampling;
   static const InternalTraceOptions kInternalRecordAsMuchAsPossible;
   static const InternalTraceOptions kInternalEnableArgumentFilter;
+  static const InternalTraceOptions kInternalStreamToFile;
 
   // This lock protects TraceLog member accesses (except for members protected
   // by thread_info_lock_) from arbitrary threads.
@@ -461,6 +489,10 @@ class BASE_EXPORT TraceLog : public MemoryDumpProvider {
   Mode mode_;
   int num_traces_recorded_;
   std::unique_ptr<TraceBuffer> logged_events_;
+  // Set when kInternalStreamToFile is; |logged_events_| then hands its chunks
+  // to it. Thread-local event buffers keep a reference to it, so that they
+  // can get and hand back chunks without taking |lock_|.
+  scoped_refptr<TraceChunkStreamer> chunk_streamer_;
   std::vector<std::unique_ptr<TraceEvent>> metadata_events_;
   subtle::AtomicWord /* EventCallback */ event_callback_;
   bool dispatching_to_observer_list_;
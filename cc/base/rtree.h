@@ -8,9 +8,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <deque>
 #include <vector>
 
+#include "base/logging.h"
 #include "cc/base/cc_export.h"
 #include "ui/gfx/geometry/rect.h"
 
@@ -36,6 +36,11 @@ namespace cc {
 //  Beckmann, N.; Kriegel, H. P.; Schneider, R.; Seeger, B. (1990).
 //  "The R*-tree: an efficient and robust access method for points and
 //  rectangles"
+//
+// Once built, the tree is packed into a single array of nodes, in breadth-first
+// order, and each node stores the bounds of its children as a structure of
+// arrays, so that a query rect is tested against all the children of a node
+// with a few SIMD compares.
 class CC_EXPORT RTree {
  public:
   RTree();
@@ -45,30 +50,22 @@ class CC_EXPORT RTree {
   void Build(const Container& items, const Functor& bounds_getter) {
     DCHECK_EQ(0u, num_data_elements_);
 
-    std::vector<Branch> branches;
-    branches.reserve(items.size());
+    std::vector<gfx::Rect> bounds;
+    bounds.reserve(items.size());
+    item_indices_.reserve(items.size());
 
     for (size_t i = 0; i < items.size(); i++) {
-      const gfx::Rect& bounds = bounds_getter(items[i]);
-      if (bounds.IsEmpty())
+      const gfx::Rect& item_bounds = bounds_getter(items[i]);
+      if (item_bounds.IsEmpty())
         continue;
 
-      branches.push_back(Branch());
-      Branch& branch = branches.back();
-      branch.bounds = bounds;
-      branch.index = i;
+      bounds.push_back(item_bounds);
+      item_indices_.push_back(i);
     }
 
-    num_data_elements_ = branches.size();
-    if (num_data_elements_ == 1u) {
-      Node* node = AllocateNodeAtLevel(0);
-      node->num_children = 1;
-      node->children[0] = branches[0];
-      root_.subtree = node;
-      root_.bounds = branches[0].bounds;
-    } else if (num_data_elements_ > 1u) {
-      root_ = BuildRecursive(&branches, 0);
-    }
+    num_data_elements_ = bounds.size();
+    if (num_data_elements_ > 0u)
+      BuildNodes(bounds);
   }
 
   template <typename Container>
@@ -76,46 +73,66 @@ class CC_EXPORT RTree {
     Build(items, [](const gfx::Rect& bounds) { return bounds; });
   }
 
+  // Appends the indices of the items whose bounds intersect |query| to
+  // |results|, in increasing order.
   void Search(const gfx::Rect& query, std::vector<size_t>* results) const;
 
+  // Searches for all of |queries| in a single traversal of the tree, so that
+  // the nodes which several queries intersect, such as the top of the tree,
+  // are only loaded once. |results| is resized to the number of queries, and
+  // (*results)[i] holds what Search(queries[i], ...) would have appended.
+  void SearchBatch(const std::vector<gfx::Rect>& queries,
+                   std::vector<std::vector<size_t>>* results) const;
+
   gfx::Rect GetBounds() const;
 
  private:
   // These values were empirically determined to produce reasonable performance
-  // in most cases.
-  enum { MIN_CHILDREN = 6, MAX_CHILDREN = 11 };
-
-  struct Node;
-  struct Branch {
-    // When the node level is 0, then the node is a leaf and the branch has a
-    // valid index pointing to an element in the vector that was used to build
-    // this rtree. When the level is not 0, it's an internal node and it has a
-    // valid subtree pointer.
-    union {
-      Node* subtree;
-      size_t index;
-    };
-    gfx::Rect bounds;
-  };
+  // in most cases. The bounds of the children of a node are padded to
+  // NUM_LANES, a multiple of the width of a SIMD register of int32_t.
+  enum { MIN_CHILDREN = 6, MAX_CHILDREN = 11, NUM_LANES = 12 };
+
+  // The number of queries SearchBatch() runs in one traversal, one per bit of
+  // a uint32_t.
+  enum { MAX_BATCH_QUERIES = 32 };
 
   struct Node {
+    // The edges of the bounds of the children. The lanes past |num_children|
+    // hold inverted bounds, which no query intersects.
+    int32_t left[NUM_LANES];
+    int32_t top[NUM_LANES];
+    int32_t right[NUM_LANES];
+    int32_t bottom[NUM_LANES];
+    // The children of a node are contiguous. For a leaf, this is the index of
+    // the first child in |item_indices_|, and otherwise in |nodes_|.
+    uint32_t first_child;
     uint16_t num_children;
     uint16_t level;
-    Branch children[MAX_CHILDREN];
   };
 
-  void SearchRecursive(Node* root,
+  // Returns a mask of the children of |node| which intersect |query|, with bit
+  // i set if child i does.
+  static uint32_t IntersectingChildren(const Node& node,
+                                       const gfx::Rect& query);
+
+  void BuildNodes(const std::vector<gfx::Rect>& bounds);
+
+  void SearchRecursive(const Node& node,
                        const gfx::Rect& query,
                        std::vector<size_t>* results) const;
-
-  // Consumes the input array.
-  Branch BuildRecursive(std::vector<Branch>* branches, int level);
-  Node* AllocateNodeAtLevel(int level);
+  // |query_mask| has bit i set for each of |queries| which intersects |node|.
+  void SearchBatchRecursive(const Node& node,
+                            const gfx::Rect* queries,
+                            uint32_t query_mask,
+                            std::vector<size_t>** results) const;
 
   // This is the count of data elements (rather than total nodes in the tree)
   size_t num_data_elements_;
-  Branch root_;
-  std::deque<Node> nodes_;
+  gfx::Rect bounds_;
+  // The nodes, root first, each level of the tree after the one above it.
+  std::vector<Node> nodes_;
+  // The indices of the items with non-empty bounds, in the order of the leaves.
+  std::vector<size_t> item_indices_;
 };
 
 }  // namespace cc
@@ -0,0 +1,128 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/base/rtree.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "cc/debug/lap_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace cc {
+namespace {
+
+static const int kTimeLimitMillis = 2000;
+static const int kWarmupRuns = 5;
+static const int kTimeCheckInterval = 10;
+
+// The size of the layer the display items cover, and of the tiles it is
+// rastered in.
+static const int kLayerWidth = 1024;
+static const int kTileSize = 256;
+
+class RTreePerfTest : public testing::Test {
+ public:
+  RTreePerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+ protected:
+  // Lays out |num_items| display items the way a page does: mostly small
+  // items, row after row, some of them overlapping, and a few large ones.
+  std::vector<gfx::Rect> CreateItemBounds(int num_items) {
+    std::vector<gfx::Rect> items;
+    const int kItemsPerRow = 50;
+    const int kRowHeight = 20;
+    for (int i = 0; i < num_items; ++i) {
+      int row = i / kItemsPerRow;
+      int column = i % kItemsPerRow;
+      if (i % 1000 == 0) {
+        items.push_back(gfx::Rect(0, row * kRowHeight, kLayerWidth, 500));
+        continue;
+      }
+      int x = column * kLayerWidth / kItemsPerRow + (i * 7) % 13;
+      int y = row * kRowHeight + (i * 11) % 7;
+      items.push_back(
+          gfx::Rect(x, y, 10 + (i * 13) % 40, 10 + (i * 17) % 20));
+    }
+    return items;
+  }
+
+  // Returns the tiles covering |bounds|, row by row.
+  std::vector<gfx::Rect> CreateTiles(const gfx::Rect& bounds) {
+    std::vector<gfx::Rect> tiles;
+    for (int y = bounds.y(); y < bounds.bottom(); y += kTileSize) {
+      for (int x = bounds.x(); x < bounds.right(); x += kTileSize)
+        tiles.push_back(gfx::Rect(x, y, kTileSize, kTileSize));
+    }
+    return tiles;
+  }
+
+  void RunBuildTest(const std::string& test_name, int num_items) {
+    std::vector<gfx::Rect> items = CreateItemBounds(num_items);
+
+    timer_.Reset();
+    do {
+      RTree rtree;
+      rtree.Build(items);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("rtree_build", "", test_name,
+                           timer_.LapsPerSecond(), "runs/s", true);
+  }
+
+  // Measures finding the items of every tile of the layer, one tile at a time
+  // and with all the tiles in a batch.
+  void RunSearchTest(const std::string& test_name, int num_items) {
+    RTree rtree;
+    rtree.Build(CreateItemBounds(num_items));
+    std::vector<gfx::Rect> tiles = CreateTiles(rtree.GetBounds());
+
+    std::vector<size_t> results;
+    timer_.Reset();
+    do {
+      for (const gfx::Rect& tile : tiles) {
+        results.clear();
+        rtree.Search(tile, &results);
+      }
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("rtree_search", "", test_name,
+                           timer_.LapsPerSecond() * tiles.size(), "tiles/s",
+                           true);
+
+    std::vector<std::vector<size_t>> batch_results;
+    timer_.Reset();
+    do {
+      rtree.SearchBatch(tiles, &batch_results);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("rtree_search_batch", "", test_name,
+                           timer_.LapsPerSecond() * tiles.size(), "tiles/s",
+                           true);
+  }
+
+  LapTimer timer_;
+};
+
+TEST_F(RTreePerfTest, Build) {
+  RunBuildTest("1000", 1000);
+  RunBuildTest("100000", 100000);
+}
+
+TEST_F(RTreePerfTest, Search) {
+  RunSearchTest("1000", 1000);
+  RunSearchTest("100000", 100000);
+}
+
+}  // namespace
+}  // namespace cc
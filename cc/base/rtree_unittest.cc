@@ -67,6 +67,70 @@ TEST(RTreeTest, Overlap) {
   }
 }
 
+TEST(RTreeTest, EmptyRectsAreSkipped) {
+  std::vector<gfx::Rect> rects;
+  rects.push_back(gfx::Rect(0, 0, 10, 10));
+  rects.push_back(gfx::Rect(5, 5, 0, 10));
+  rects.push_back(gfx::Rect(5, 5, 10, 10));
+
+  RTree rtree;
+  rtree.Build(rects);
+
+  std::vector<size_t> results;
+  rtree.Search(gfx::Rect(0, 0, 20, 20), &results);
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(0u, results[0]);
+  EXPECT_EQ(2u, results[1]);
+
+  results.clear();
+  rtree.Search(gfx::Rect(5, 5, 0, 0), &results);
+  EXPECT_TRUE(results.empty());
+}
+
+TEST(RTreeTest, SearchBatch) {
+  std::vector<gfx::Rect> rects;
+  for (int y = 0; y < 50; ++y) {
+    for (int x = 0; x < 50; ++x) {
+      rects.push_back(gfx::Rect(x * 10, y * 10, 15, 15));
+    }
+  }
+
+  RTree rtree;
+  rtree.Build(rects);
+
+  // More queries than a single traversal handles, some of which overlap and
+  // some of which don't intersect anything.
+  std::vector<gfx::Rect> queries;
+  for (int y = -50; y < 550; y += 40) {
+    for (int x = -50; x < 550; x += 60)
+      queries.push_back(gfx::Rect(x, y, 70, 50));
+  }
+  queries.push_back(gfx::Rect());
+  ASSERT_GT(queries.size(), 32u);
+
+  std::vector<std::vector<size_t>> batch_results;
+  rtree.SearchBatch(queries, &batch_results);
+  ASSERT_EQ(queries.size(), batch_results.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    std::vector<size_t> results;
+    rtree.Search(queries[i], &results);
+    EXPECT_EQ(results, batch_results[i]) << queries[i].ToString();
+  }
+  EXPECT_TRUE(batch_results.back().empty());
+}
+
+TEST(RTreeTest, SearchBatchEmpty) {
+  RTree rtree;
+  rtree.Build(std::vector<gfx::Rect>());
+
+  std::vector<gfx::Rect> queries(2, gfx::Rect(0, 0, 10, 10));
+  std::vector<std::vector<size_t>> batch_results;
+  rtree.SearchBatch(queries, &batch_results);
+  ASSERT_EQ(2u, batch_results.size());
+  EXPECT_TRUE(batch_results[0].empty());
+  EXPECT_TRUE(batch_results[1].empty());
+}
+
 TEST(RTreeTest, GetBoundsEmpty) {
   RTree rtree;
   ASSERT_EQ(gfx::Rect(), rtree.GetBounds());
@@ -10,6 +10,7 @@ DrawProperties::DrawProperties()
     : opacity(0.f),
       screen_space_transform_is_animating(false),
       is_clipped(false),
+      visible_rects_pass_id(0),
       maximum_animation_contents_scale(0.f),
       starting_animation_contents_scale(0.f) {}
 
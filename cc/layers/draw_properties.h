@@ -57,6 +57,10 @@ struct CC_EXPORT DrawProperties {
   // value is used to avoid unnecessarily changing GL scissor state.
   gfx::Rect clip_rect;
 
+  // The PropertyTrees::visible_rects_pass_id of the pass that computed
+  // visible_layer_rect and clip_rect.
+  int visible_rects_pass_id;
+
   // The maximum scale during the layers current animation at which content
   // should be rastered at to be crisp.
   float maximum_animation_contents_scale;
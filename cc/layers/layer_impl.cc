@@ -531,7 +531,7 @@ void LayerImpl::UpdatePropertyTreeTransform() {
       node->data.needs_local_transform_update = true;
       node->data.transform_changed = true;
       property_trees->changed = true;
-      property_trees->transform_tree.set_needs_update(true);
+      property_trees->transform_tree.SetNodeNeedsUpdate(node->id);
       // TODO(ajuma): The current criteria for creating clip nodes means that
       // property trees may need to be rebuilt when the new transform isn't
       // axis-aligned wrt the old transform (see Layer::SetTransform). Since
@@ -599,7 +599,7 @@ void LayerImpl::UpdatePropertyTreeOpacity(float opacity) {
     node->data.opacity = opacity;
     node->data.effect_changed = true;
     property_trees->changed = true;
-    property_trees->effect_tree.set_needs_update(true);
+    property_trees->effect_tree.SetNodeNeedsUpdate(node->id);
   }
 }
 
@@ -992,7 +992,7 @@ void LayerImpl::UpdatePropertyTreeScrollOffset() {
   if (node->data.scroll_offset != current_offset) {
     node->data.scroll_offset = current_offset;
     node->data.needs_local_transform_update = true;
-    transform_tree.set_needs_update(true);
+    transform_tree.SetNodeNeedsUpdate(node->id);
   }
 }
 
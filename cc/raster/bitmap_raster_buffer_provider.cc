@@ -25,10 +25,12 @@ namespace {
 class RasterBufferImpl : public RasterBuffer {
  public:
   RasterBufferImpl(ResourceProvider* resource_provider,
+                   TaskGraphRunner* band_task_graph_runner,
                    const Resource* resource,
                    uint64_t resource_content_id,
                    uint64_t previous_content_id)
       : lock_(resource_provider, resource->id()),
+        band_task_graph_runner_(band_task_graph_runner),
         resource_(resource),
         resource_has_previous_content_(
             resource_content_id && resource_content_id == previous_content_id) {
@@ -51,6 +53,13 @@ class RasterBufferImpl : public RasterBuffer {
         << "Why are we rastering a tile that's not dirty?";
 
     size_t stride = 0u;
+    if (band_task_graph_runner_) {
+      RasterBufferProvider::PlaybackToMemoryInBands(
+          lock_.sk_bitmap().getPixels(), resource_->format(),
+          resource_->size(), stride, raster_source, raster_full_rect,
+          playback_rect, scale, playback_settings, band_task_graph_runner_);
+      return;
+    }
     RasterBufferProvider::PlaybackToMemory(
         lock_.sk_bitmap().getPixels(), resource_->format(), resource_->size(),
         stride, raster_source, raster_full_rect, playback_rect, scale,
@@ -59,6 +68,7 @@ class RasterBufferImpl : public RasterBuffer {
 
  private:
   ResourceProvider::ScopedWriteLockSoftware lock_;
+  TaskGraphRunner* band_task_graph_runner_;
   const Resource* resource_;
   bool resource_has_previous_content_;
 
@@ -69,14 +79,17 @@ class RasterBufferImpl : public RasterBuffer {
 
 // static
 std::unique_ptr<RasterBufferProvider> BitmapRasterBufferProvider::Create(
-    ResourceProvider* resource_provider) {
-  return base::WrapUnique<RasterBufferProvider>(
-      new BitmapRasterBufferProvider(resource_provider));
+    ResourceProvider* resource_provider,
+    TaskGraphRunner* band_task_graph_runner) {
+  return base::WrapUnique<RasterBufferProvider>(new BitmapRasterBufferProvider(
+      resource_provider, band_task_graph_runner));
 }
 
 BitmapRasterBufferProvider::BitmapRasterBufferProvider(
-    ResourceProvider* resource_provider)
-    : resource_provider_(resource_provider) {}
+    ResourceProvider* resource_provider,
+    TaskGraphRunner* band_task_graph_runner)
+    : resource_provider_(resource_provider),
+      band_task_graph_runner_(band_task_graph_runner) {}
 
 BitmapRasterBufferProvider::~BitmapRasterBufferProvider() {}
 
@@ -85,8 +98,9 @@ BitmapRasterBufferProvider::AcquireBufferForRaster(
     const Resource* resource,
     uint64_t resource_content_id,
     uint64_t previous_content_id) {
-  return std::unique_ptr<RasterBuffer>(new RasterBufferImpl(
-      resource_provider_, resource, resource_content_id, previous_content_id));
+  return std::unique_ptr<RasterBuffer>(
+      new RasterBufferImpl(resource_provider_, band_task_graph_runner_,
+                           resource, resource_content_id, previous_content_id));
 }
 
 void BitmapRasterBufferProvider::ReleaseBufferForRaster(
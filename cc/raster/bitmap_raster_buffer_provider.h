@@ -19,13 +19,18 @@ class ConvertableToTraceFormat;
 
 namespace cc {
 class ResourceProvider;
+class TaskGraphRunner;
 
 class CC_EXPORT BitmapRasterBufferProvider : public RasterBufferProvider {
  public:
   ~BitmapRasterBufferProvider() override;
 
+  // If |band_task_graph_runner| isn't null, the tiles are split into bands
+  // which are rastered concurrently by tasks scheduled on it. It must be the
+  // runner the raster tasks run on, or one which doesn't wait for them.
   static std::unique_ptr<RasterBufferProvider> Create(
-      ResourceProvider* resource_provider);
+      ResourceProvider* resource_provider,
+      TaskGraphRunner* band_task_graph_runner);
 
   // Overridden from RasterBufferProvider:
   std::unique_ptr<RasterBuffer> AcquireBufferForRaster(
@@ -39,13 +44,15 @@ class CC_EXPORT BitmapRasterBufferProvider : public RasterBufferProvider {
   void Shutdown() override;
 
  protected:
-  explicit BitmapRasterBufferProvider(ResourceProvider* resource_provider);
+  BitmapRasterBufferProvider(ResourceProvider* resource_provider,
+                             TaskGraphRunner* band_task_graph_runner);
 
  private:
   std::unique_ptr<base::trace_event::ConvertableToTraceFormat> StateAsValue()
       const;
 
   ResourceProvider* resource_provider_;
+  TaskGraphRunner* band_task_graph_runner_;
 
   DISALLOW_COPY_AND_ASSIGN(BitmapRasterBufferProvider);
 };
@@ -6,8 +6,13 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
 #include "base/trace_event/trace_event.h"
 #include "cc/playback/raster_source.h"
+#include "cc/raster/task_category.h"
 #include "cc/raster/texture_compressor.h"
 #include "cc/resources/platform_color.h"
 #include "cc/resources/resource_format_utils.h"
@@ -40,6 +45,111 @@ bool IsSupportedPlaybackToMemoryFormat(ResourceFormat format) {
   return false;
 }
 
+// Returns the properties of the surfaces |raster_source| is played back into.
+SkSurfaceProps GetSurfacePropsForPlayback(const RasterSource* raster_source) {
+  // Use unknown pixel geometry to disable LCD text.
+  SkSurfaceProps surface_props(0, kUnknown_SkPixelGeometry);
+  if (raster_source->CanUseLCDText()) {
+    // LegacyFontHost will get LCD text and skia figures out what type to use.
+    surface_props = SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType);
+  }
+  return surface_props;
+}
+
+// Bands are at least this tall, so that the fixed cost of a band, such as
+// finding the display items which intersect it, stays small.
+const int kMinBandHeight = 64;
+
+// A tile is split into at most this many bands.
+const int kMaxBands = 8;
+
+// The bands of a playback rect, which are shared by the thread rastering the
+// tile and the tasks helping it. Each band is rastered by the first thread
+// taking it, so that the calling thread never waits for a task to start.
+class BandPlayback {
+ public:
+  BandPlayback(void* memory,
+               const SkImageInfo& info,
+               size_t stride,
+               const SkSurfaceProps& surface_props,
+               const RasterSource* raster_source,
+               const gfx::Rect& canvas_bitmap_rect,
+               const gfx::Rect& canvas_playback_rect,
+               float scale,
+               const RasterSource::PlaybackSettings& playback_settings,
+               int num_bands)
+      : memory_(memory),
+        info_(info),
+        stride_(stride),
+        surface_props_(surface_props),
+        raster_source_(raster_source),
+        canvas_bitmap_rect_(canvas_bitmap_rect),
+        canvas_playback_rect_(canvas_playback_rect),
+        scale_(scale),
+        playback_settings_(playback_settings),
+        num_bands_(num_bands),
+        next_band_(0) {}
+
+  // Rasters the bands which haven't been taken yet, until there are none left.
+  void PlaybackBands() {
+    for (;;) {
+      int band = base::subtle::NoBarrier_AtomicIncrement(&next_band_, 1) - 1;
+      if (band >= num_bands_)
+        return;
+      PlaybackBand(band);
+    }
+  }
+
+ private:
+  void PlaybackBand(int band) {
+    TRACE_EVENT1("cc", "BandPlayback::PlaybackBand", "band", band);
+    int height = canvas_playback_rect_.height();
+    int top = canvas_playback_rect_.y() + height * band / num_bands_;
+    int bottom = canvas_playback_rect_.y() + height * (band + 1) / num_bands_;
+    gfx::Rect band_rect(canvas_playback_rect_.x(), top,
+                        canvas_playback_rect_.width(), bottom - top);
+
+    // Every band draws into the whole bitmap, clipped to the band, so that the
+    // display items are rastered at the same position as without bands, and
+    // the display list only replays the items intersecting the band.
+    sk_sp<SkSurface> surface =
+        SkSurface::MakeRasterDirect(info_, memory_, stride_, &surface_props_);
+    raster_source_->PlaybackToCanvas(surface->getCanvas(), canvas_bitmap_rect_,
+                                     band_rect, scale_, playback_settings_);
+  }
+
+  void* const memory_;
+  const SkImageInfo info_;
+  const size_t stride_;
+  const SkSurfaceProps surface_props_;
+  const RasterSource* const raster_source_;
+  const gfx::Rect canvas_bitmap_rect_;
+  const gfx::Rect canvas_playback_rect_;
+  const float scale_;
+  const RasterSource::PlaybackSettings playback_settings_;
+  const int num_bands_;
+  base::subtle::Atomic32 next_band_;
+
+  DISALLOW_COPY_AND_ASSIGN(BandPlayback);
+};
+
+class BandPlaybackTask : public Task {
+ public:
+  explicit BandPlaybackTask(BandPlayback* band_playback)
+      : band_playback_(band_playback) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override { band_playback_->PlaybackBands(); }
+
+ protected:
+  ~BandPlaybackTask() override {}
+
+ private:
+  BandPlayback* band_playback_;
+
+  DISALLOW_COPY_AND_ASSIGN(BandPlaybackTask);
+};
+
 }  // anonymous namespace
 
 // static
@@ -62,12 +172,7 @@ void RasterBufferProvider::PlaybackToMemory(
   SkImageInfo info =
       SkImageInfo::MakeN32(size.width(), size.height(), kPremul_SkAlphaType);
 
-  // Use unknown pixel geometry to disable LCD text.
-  SkSurfaceProps surface_props(0, kUnknown_SkPixelGeometry);
-  if (raster_source->CanUseLCDText()) {
-    // LegacyFontHost will get LCD text and skia figures out what type to use.
-    surface_props = SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType);
-  }
+  SkSurfaceProps surface_props = GetSurfacePropsForPlayback(raster_source);
 
   if (!stride)
     stride = info.minRowBytes();
@@ -129,6 +234,72 @@ void RasterBufferProvider::PlaybackToMemory(
   NOTREACHED();
 }
 
+// static
+void RasterBufferProvider::PlaybackToMemoryInBands(
+    void* memory,
+    ResourceFormat format,
+    const gfx::Size& size,
+    size_t stride,
+    const RasterSource* raster_source,
+    const gfx::Rect& canvas_bitmap_rect,
+    const gfx::Rect& canvas_playback_rect,
+    float scale,
+    const RasterSource::PlaybackSettings& playback_settings,
+    TaskGraphRunner* task_graph_runner) {
+  DCHECK(task_graph_runner);
+
+  // Only the formats which are rastered directly into |memory| can be rastered
+  // concurrently, the others are converted from a temporary surface.
+  int num_bands =
+      std::min(kMaxBands, canvas_playback_rect.height() / kMinBandHeight);
+  if (num_bands < 2 || (format != RGBA_8888 && format != BGRA_8888) ||
+      playback_settings.playback_to_shared_canvas) {
+    PlaybackToMemory(memory, format, size, stride, raster_source,
+                     canvas_bitmap_rect, canvas_playback_rect, scale,
+                     playback_settings);
+    return;
+  }
+
+  TRACE_EVENT1("cc", "RasterBufferProvider::PlaybackToMemoryInBands",
+               "num_bands", num_bands);
+
+  // Uses kPremul_SkAlphaType since the result is not known to be opaque.
+  SkImageInfo info =
+      SkImageInfo::MakeN32(size.width(), size.height(), kPremul_SkAlphaType);
+  if (!stride)
+    stride = info.minRowBytes();
+  DCHECK_GT(stride, 0u);
+
+  BandPlayback band_playback(memory, info, stride,
+                             GetSurfacePropsForPlayback(raster_source),
+                             raster_source, canvas_bitmap_rect,
+                             canvas_playback_rect, scale, playback_settings,
+                             num_bands);
+
+  // One task fewer than bands, as this thread rasters bands too.
+  Task::Vector tasks;
+  TaskGraph graph;
+  for (int i = 1; i < num_bands; ++i) {
+    tasks.push_back(make_scoped_refptr(new BandPlaybackTask(&band_playback)));
+    graph.nodes.push_back(
+        TaskGraph::Node(tasks.back().get(), TASK_CATEGORY_FOREGROUND,
+                        0u /* priority */, 0u /* dependencies */));
+  }
+  NamespaceToken token = task_graph_runner->GetNamespaceToken();
+  task_graph_runner->ScheduleTasks(token, &graph);
+
+  band_playback.PlaybackBands();
+
+  // All the bands have been taken. Cancel the tasks which haven't started, so
+  // that this only waits for the bands other threads are rastering, even when
+  // all the worker threads are busy.
+  TaskGraph empty_graph;
+  task_graph_runner->ScheduleTasks(token, &empty_graph);
+  task_graph_runner->WaitForTasksToFinishRunning(token);
+  Task::Vector completed_tasks;
+  task_graph_runner->CollectCompletedTasks(token, &completed_tasks);
+}
+
 bool RasterBufferProvider::ResourceFormatRequiresSwizzle(
     ResourceFormat format) {
   switch (format) {
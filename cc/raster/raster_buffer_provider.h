@@ -44,6 +44,23 @@ class CC_EXPORT RasterBufferProvider {
       float scale,
       const RasterSource::PlaybackSettings& playback_settings);
 
+  // Like PlaybackToMemory(), but splits |canvas_playback_rect| into horizontal
+  // bands which are rastered concurrently, by the calling thread and by tasks
+  // scheduled on |task_graph_runner|, so that a large tile doesn't keep a
+  // single core busy. The result is identical to PlaybackToMemory(). Must not
+  // be called from a task of a SynchronousTaskGraphRunner.
+  static void PlaybackToMemoryInBands(
+      void* memory,
+      ResourceFormat format,
+      const gfx::Size& size,
+      size_t stride,
+      const RasterSource* raster_source,
+      const gfx::Rect& canvas_bitmap_rect,
+      const gfx::Rect& canvas_playback_rect,
+      float scale,
+      const RasterSource::PlaybackSettings& playback_settings,
+      TaskGraphRunner* task_graph_runner);
+
   // Acquire raster buffer.
   virtual std::unique_ptr<RasterBuffer> AcquireBufferForRaster(
       const Resource* resource,
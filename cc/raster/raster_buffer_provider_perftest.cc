@@ -5,9 +5,17 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
 #include "base/test/test_simple_task_runner.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "cc/debug/lap_timer.h"
 #include "cc/output/context_provider.h"
@@ -16,6 +24,7 @@
 #include "cc/raster/one_copy_raster_buffer_provider.h"
 #include "cc/raster/raster_buffer_provider.h"
 #include "cc/raster/synchronous_task_graph_runner.h"
+#include "cc/raster/task_graph_work_queue.h"
 #include "cc/raster/zero_copy_raster_buffer_provider.h"
 #include "cc/resources/platform_color.h"
 #include "cc/resources/resource_pool.h"
@@ -23,6 +32,8 @@
 #include "cc/resources/scoped_resource.h"
 #include "cc/test/fake_output_surface.h"
 #include "cc/test/fake_output_surface_client.h"
+#include "cc/test/fake_raster_source.h"
+#include "cc/test/fake_recording_source.h"
 #include "cc/test/fake_resource_provider.h"
 #include "cc/test/test_context_support.h"
 #include "cc/test/test_gpu_memory_buffer_manager.h"
@@ -33,6 +44,7 @@
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
 #include "third_party/khronos/GLES2/gl2.h"
+#include "third_party/skia/include/core/SkPaint.h"
 #include "third_party/skia/include/gpu/GrContext.h"
 #include "third_party/skia/include/gpu/gl/GrGLInterface.h"
 
@@ -128,6 +140,7 @@ enum RasterBufferProviderType {
 static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
+static const int kLargeTileSize = 1024;
 
 class PerfTileTask : public TileTask {
  public:
@@ -342,8 +355,8 @@ class RasterBufferProviderPerfTest
         break;
       case RASTER_BUFFER_PROVIDER_TYPE_BITMAP:
         CreateSoftwareOutputSurfaceAndResourceProvider();
-        raster_buffer_provider_ =
-            BitmapRasterBufferProvider::Create(resource_provider_.get());
+        raster_buffer_provider_ = BitmapRasterBufferProvider::Create(
+            resource_provider_.get(), nullptr);
         break;
     }
 
@@ -598,5 +611,171 @@ TEST_F(RasterBufferProviderCommonPerfTest, BuildTileTaskGraph) {
   RunBuildTileTaskGraphTest("32_4", 32, 4);
 }
 
+// Runs the tasks on a number of worker threads, like the worker pool of the
+// renderer, which can't be used from cc.
+class PerfWorkerPool : public TaskGraphRunner,
+                       public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit PerfWorkerPool(int num_threads)
+      : has_ready_to_run_tasks_cv_(&lock_),
+        has_namespaces_with_finished_running_tasks_cv_(&lock_),
+        shutdown_(false) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.push_back(base::WrapUnique(new base::DelegateSimpleThread(
+          this, base::StringPrintf("PerfWorker%d", i))));
+      threads_.back()->Start();
+    }
+  }
+
+  ~PerfWorkerPool() override {
+    {
+      base::AutoLock lock(lock_);
+      DCHECK(!work_queue_.HasAnyNamespaces());
+      shutdown_ = true;
+      has_ready_to_run_tasks_cv_.Broadcast();
+    }
+    for (const auto& thread : threads_)
+      thread->Join();
+  }
+
+  // Overridden from TaskGraphRunner:
+  NamespaceToken GetNamespaceToken() override {
+    base::AutoLock lock(lock_);
+    return work_queue_.GetNamespaceToken();
+  }
+  void ScheduleTasks(NamespaceToken token, TaskGraph* graph) override {
+    base::AutoLock lock(lock_);
+    work_queue_.ScheduleTasks(token, graph);
+    if (work_queue_.HasReadyToRunTasks())
+      has_ready_to_run_tasks_cv_.Broadcast();
+  }
+  void WaitForTasksToFinishRunning(NamespaceToken token) override {
+    base::AutoLock lock(lock_);
+    auto* task_namespace = work_queue_.GetNamespaceForToken(token);
+    if (!task_namespace)
+      return;
+    while (!work_queue_.HasFinishedRunningTasksInNamespace(task_namespace))
+      has_namespaces_with_finished_running_tasks_cv_.Wait();
+  }
+  void CollectCompletedTasks(NamespaceToken token,
+                             Task::Vector* completed_tasks) override {
+    base::AutoLock lock(lock_);
+    work_queue_.CollectCompletedTasks(token, completed_tasks);
+  }
+
+  // Overridden from base::DelegateSimpleThread::Delegate:
+  void Run() override {
+    base::AutoLock lock(lock_);
+    while (true) {
+      const auto& ready_to_run_namespaces =
+          work_queue_.ready_to_run_namespaces();
+      auto found = std::find_if(
+          ready_to_run_namespaces.cbegin(), ready_to_run_namespaces.cend(),
+          [](const std::pair<uint16_t,
+                             TaskGraphWorkQueue::TaskNamespace::Vector>& pair) {
+            return !pair.second.empty();
+          });
+      if (found == ready_to_run_namespaces.cend()) {
+        if (shutdown_)
+          return;
+        has_ready_to_run_tasks_cv_.Wait();
+        continue;
+      }
+
+      auto prioritized_task = work_queue_.GetNextTaskToRun(found->first);
+      {
+        base::AutoUnlock unlock(lock_);
+        prioritized_task.task->RunOnWorkerThread();
+      }
+      work_queue_.CompleteTask(prioritized_task);
+
+      // Several origin threads can be waiting for different namespaces.
+      if (work_queue_.HasFinishedRunningTasksInNamespace(
+              prioritized_task.task_namespace))
+        has_namespaces_with_finished_running_tasks_cv_.Broadcast();
+    }
+  }
+
+ private:
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads_;
+  base::Lock lock_;
+  TaskGraphWorkQueue work_queue_;
+  base::ConditionVariable has_ready_to_run_tasks_cv_;
+  base::ConditionVariable has_namespaces_with_finished_running_tasks_cv_;
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfWorkerPool);
+};
+
+class RasterBufferProviderBandPerfTest : public testing::Test {
+ public:
+  RasterBufferProviderBandPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+  // Overridden from testing::Test:
+  void SetUp() override {
+    // A tile as large as a viewport, covered by many antialiased rects, which
+    // is expensive enough to raster to be worth splitting.
+    std::unique_ptr<FakeRecordingSource> recording_source =
+        FakeRecordingSource::CreateFilledRecordingSource(
+            gfx::Size(kLargeTileSize, kLargeTileSize));
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 2000; ++i) {
+      paint.setColor(SkColorSetARGB(128, (i * 7) & 0xff, (i * 13) & 0xff,
+                                    (i * 29) & 0xff));
+      recording_source->add_draw_rectf_with_paint(
+          gfx::RectF((i * 37) % kLargeTileSize + 0.3f,
+                     (i * 53) % kLargeTileSize + 0.6f, 150.5f, 120.25f),
+          paint);
+    }
+    recording_source->Rerecord();
+    raster_source_ = FakeRasterSource::CreateFromRecordingSource(
+        recording_source.get(), false);
+    memory_.reset(new uint32_t[kLargeTileSize * kLargeTileSize]);
+  }
+
+  // Measures the latency of rastering a single tile on |num_cores| cores: the
+  // calling thread and |num_cores| - 1 worker threads.
+  void RunSingleTileTest(const std::string& test_name, int num_cores) {
+    std::unique_ptr<PerfWorkerPool> worker_pool;
+    if (num_cores > 1)
+      worker_pool.reset(new PerfWorkerPool(num_cores - 1));
+
+    gfx::Size size(kLargeTileSize, kLargeTileSize);
+    gfx::Rect rect(size);
+    RasterSource::PlaybackSettings settings;
+    timer_.Reset();
+    do {
+      if (worker_pool) {
+        RasterBufferProvider::PlaybackToMemoryInBands(
+            memory_.get(), RGBA_8888, size, 0, raster_source_.get(), rect, rect,
+            1.f, settings, worker_pool.get());
+      } else {
+        RasterBufferProvider::PlaybackToMemory(
+            memory_.get(), RGBA_8888, size, 0, raster_source_.get(), rect, rect,
+            1.f, settings);
+      }
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("single_tile_raster", "", test_name,
+                           timer_.MsPerLap(), "ms", true);
+  }
+
+ protected:
+  scoped_refptr<FakeRasterSource> raster_source_;
+  std::unique_ptr<uint32_t[]> memory_;
+  LapTimer timer_;
+};
+
+TEST_F(RasterBufferProviderBandPerfTest, SingleTileLatency) {
+  RunSingleTileTest("1_core", 1);
+  RunSingleTileTest("4_cores", 4);
+  RunSingleTileTest("8_cores", 8);
+}
+
 }  // namespace
 }  // namespace cc
@@ -30,13 +30,16 @@
 #include "cc/test/fake_output_surface.h"
 #include "cc/test/fake_output_surface_client.h"
 #include "cc/test/fake_raster_source.h"
+#include "cc/test/fake_recording_source.h"
 #include "cc/test/fake_resource_provider.h"
 #include "cc/test/test_gpu_memory_buffer_manager.h"
 #include "cc/test/test_shared_bitmap_manager.h"
+#include "cc/test/test_task_graph_runner.h"
 #include "cc/test/test_web_graphics_context_3d.h"
 #include "cc/tiles/tile_task_manager.h"
 #include "gpu/GLES2/gl2extchromium.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkPaint.h"
 
 namespace cc {
 namespace {
@@ -178,8 +181,8 @@ class RasterBufferProviderTest
         break;
       case RASTER_BUFFER_PROVIDER_TYPE_BITMAP:
         CreateSoftwareOutputSurfaceAndResourceProvider();
-        raster_buffer_provider_ =
-            BitmapRasterBufferProvider::Create(resource_provider_.get());
+        raster_buffer_provider_ = BitmapRasterBufferProvider::Create(
+            resource_provider_.get(), nullptr);
         break;
     }
 
@@ -391,5 +394,47 @@ INSTANTIATE_TEST_CASE_P(RasterBufferProviderTests,
                                           RASTER_BUFFER_PROVIDER_TYPE_GPU,
                                           RASTER_BUFFER_PROVIDER_TYPE_BITMAP));
 
+TEST(RasterBufferProviderPlaybackTest, PlaybackToMemoryInBands) {
+  gfx::Size layer_bounds(400, 500);
+  std::unique_ptr<FakeRecordingSource> recording_source =
+      FakeRecordingSource::CreateFilledRecordingSource(layer_bounds);
+  SkPaint paint;
+  paint.setAntiAlias(true);
+  // Antialiased rects with fractional edges, which straddle the bands.
+  for (int i = 0; i < 40; ++i) {
+    paint.setColor(SkColorSetARGB(128 + i, 255 - 6 * i, 6 * i, 3 * i));
+    recording_source->add_draw_rectf_with_paint(
+        gfx::RectF(7.3f * i, 11.7f * i, 50.5f, 37.25f), paint);
+  }
+  recording_source->Rerecord();
+  scoped_refptr<FakeRasterSource> raster_source =
+      FakeRasterSource::CreateFromRecordingSource(recording_source.get(),
+                                                  false);
+
+  TestTaskGraphRunner task_graph_runner;
+  const float kScale = 1.3f;
+  gfx::Size size(520, 650);
+  gfx::Rect bitmap_rect(size);
+  RasterSource::PlaybackSettings settings;
+  size_t num_pixels = size.GetArea();
+
+  // A full raster, and a partial raster of a rect which isn't band aligned.
+  for (const gfx::Rect& playback_rect :
+       {bitmap_rect, gfx::Rect(13, 17, 400, 555)}) {
+    std::unique_ptr<uint32_t[]> expected(new uint32_t[num_pixels]());
+    std::unique_ptr<uint32_t[]> actual(new uint32_t[num_pixels]());
+    RasterBufferProvider::PlaybackToMemory(
+        expected.get(), RGBA_8888, size, 0, raster_source.get(), bitmap_rect,
+        playback_rect, kScale, settings);
+    RasterBufferProvider::PlaybackToMemoryInBands(
+        actual.get(), RGBA_8888, size, 0, raster_source.get(), bitmap_rect,
+        playback_rect, kScale, settings, &task_graph_runner);
+    for (size_t i = 0; i < num_pixels; ++i) {
+      ASSERT_EQ(expected[i], actual[i]) << "x: " << i % size.width()
+                                        << " y: " << i / size.width();
+    }
+  }
+}
+
 }  // namespace
 }  // namespace cc
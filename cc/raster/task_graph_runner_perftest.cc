@@ -14,6 +14,7 @@
 #include "cc/base/completion_event.h"
 #include "cc/debug/lap_timer.h"
 #include "cc/raster/synchronous_task_graph_runner.h"
+#include "cc/raster/work_stealing_task_graph_runner.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
 
@@ -24,6 +25,16 @@ static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
 
+// The number of workers of the WorkStealingTaskGraphRunner. The workers are
+// only started to execute tasks, so that the other tests measure scheduling
+// alone.
+static const size_t kNumWorkers = 4;
+
+enum TaskGraphRunnerType {
+  TASK_GRAPH_RUNNER_TYPE_SYNCHRONOUS,
+  TASK_GRAPH_RUNNER_TYPE_WORK_STEALING,
+};
+
 class PerfTaskImpl : public Task {
  public:
   typedef std::vector<scoped_refptr<PerfTaskImpl>> Vector;
@@ -41,7 +52,8 @@ class PerfTaskImpl : public Task {
   DISALLOW_COPY_AND_ASSIGN(PerfTaskImpl);
 };
 
-class TaskGraphRunnerPerfTest : public testing::Test {
+class TaskGraphRunnerPerfTest
+    : public testing::TestWithParam<TaskGraphRunnerType> {
  public:
   TaskGraphRunnerPerfTest()
       : timer_(kWarmupRuns,
@@ -50,10 +62,27 @@ class TaskGraphRunnerPerfTest : public testing::Test {
 
   // Overridden from testing::Test:
   void SetUp() override {
-    task_graph_runner_ = base::WrapUnique(new SynchronousTaskGraphRunner);
+    switch (GetParam()) {
+      case TASK_GRAPH_RUNNER_TYPE_SYNCHRONOUS:
+        synchronous_task_graph_runner_ = new SynchronousTaskGraphRunner;
+        task_graph_runner_ = base::WrapUnique(synchronous_task_graph_runner_);
+        break;
+      case TASK_GRAPH_RUNNER_TYPE_WORK_STEALING:
+        work_stealing_task_graph_runner_ =
+            new WorkStealingTaskGraphRunner(kNumWorkers);
+        task_graph_runner_ =
+            base::WrapUnique(work_stealing_task_graph_runner_);
+        break;
+    }
     namespace_token_ = task_graph_runner_->GetNamespaceToken();
   }
-  void TearDown() override { task_graph_runner_ = nullptr; }
+  void TearDown() override {
+    if (work_stealing_task_graph_runner_)
+      work_stealing_task_graph_runner_->Shutdown();
+    synchronous_task_graph_runner_ = nullptr;
+    work_stealing_task_graph_runner_ = nullptr;
+    task_graph_runner_ = nullptr;
+  }
 
   void RunBuildTaskGraphTest(const std::string& test_name,
                              int num_top_level_tasks,
@@ -177,6 +206,58 @@ class TaskGraphRunnerPerfTest : public testing::Test {
                            true);
   }
 
+  // Schedules a graph and cancels all its tasks by scheduling an empty graph,
+  // which is what happens to the tasks which aren't needed anymore.
+  void RunScheduleAndCancelTasksTest(const std::string& test_name,
+                                     int num_top_level_tasks,
+                                     int num_tasks,
+                                     int num_leaf_tasks) {
+    PerfTaskImpl::Vector top_level_tasks;
+    PerfTaskImpl::Vector tasks;
+    PerfTaskImpl::Vector leaf_tasks;
+    CreateTasks(num_top_level_tasks, &top_level_tasks);
+    CreateTasks(num_tasks, &tasks);
+    CreateTasks(num_leaf_tasks, &leaf_tasks);
+
+    // Avoid unnecessary heap allocations by reusing the same graphs and
+    // completed tasks vector.
+    TaskGraph graph;
+    TaskGraph empty;
+    Task::Vector completed_tasks;
+
+    timer_.Reset();
+    do {
+      graph.Reset();
+      ResetTasks(top_level_tasks);
+      ResetTasks(tasks);
+      ResetTasks(leaf_tasks);
+      BuildTaskGraph(top_level_tasks, tasks, leaf_tasks, &graph);
+      task_graph_runner_->ScheduleTasks(namespace_token_, &graph);
+      // The runner can swap the graph it is given with the previous one.
+      empty.Reset();
+      task_graph_runner_->ScheduleTasks(namespace_token_, &empty);
+      CollectCompletedTasks(&completed_tasks);
+      completed_tasks.clear();
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("schedule_and_cancel_tasks",
+                           TestModifierString(),
+                           test_name,
+                           timer_.LapsPerSecond(),
+                           "runs/s",
+                           true);
+  }
+
+  // Starts the workers of the runners which have any. The tasks of the other
+  // tests are never run.
+  void StartWorkers() {
+    if (work_stealing_task_graph_runner_) {
+      work_stealing_task_graph_runner_->Start("PerfTestWorker",
+                                              base::SimpleThread::Options());
+    }
+  }
+
   void RunScheduleAndExecuteTasksTest(const std::string& test_name,
                                       int num_top_level_tasks,
                                       int num_tasks,
@@ -203,7 +284,7 @@ class TaskGraphRunnerPerfTest : public testing::Test {
       ResetTasks(leaf_tasks);
       BuildTaskGraph(top_level_tasks, tasks, leaf_tasks, &graph);
       task_graph_runner_->ScheduleTasks(namespace_token_, &graph);
-      task_graph_runner_->RunUntilIdle();
+      RunTasksUntilIdle();
       CollectCompletedTasks(&completed_tasks);
       completed_tasks.clear();
       timer_.NextLap();
@@ -218,8 +299,22 @@ class TaskGraphRunnerPerfTest : public testing::Test {
   }
 
  private:
-  static std::string TestModifierString() {
-    return std::string("_task_graph_runner");
+  std::string TestModifierString() const {
+    switch (GetParam()) {
+      case TASK_GRAPH_RUNNER_TYPE_SYNCHRONOUS:
+        return std::string("_task_graph_runner");
+      case TASK_GRAPH_RUNNER_TYPE_WORK_STEALING:
+        return std::string("_work_stealing_task_graph_runner");
+    }
+    NOTREACHED();
+    return std::string();
+  }
+
+  void RunTasksUntilIdle() {
+    if (synchronous_task_graph_runner_)
+      synchronous_task_graph_runner_->RunUntilIdle();
+    else
+      task_graph_runner_->WaitForTasksToFinishRunning(namespace_token_);
   }
 
   void CreateTasks(int num_tasks, PerfTaskImpl::Vector* tasks) {
@@ -283,14 +378,17 @@ class TaskGraphRunnerPerfTest : public testing::Test {
     return completed_tasks->size();
   }
 
-  // Test uses SynchronousTaskGraphRunner, as this implementation introduces
-  // minimal additional complexity over the TaskGraphWorkQueue helpers.
-  std::unique_ptr<SynchronousTaskGraphRunner> task_graph_runner_;
+  // SynchronousTaskGraphRunner measures the TaskGraphWorkQueue helpers with
+  // minimal additional complexity. Only the pointer to the type of the runner
+  // under test is set.
+  std::unique_ptr<TaskGraphRunner> task_graph_runner_;
+  SynchronousTaskGraphRunner* synchronous_task_graph_runner_ = nullptr;
+  WorkStealingTaskGraphRunner* work_stealing_task_graph_runner_ = nullptr;
   NamespaceToken namespace_token_;
   LapTimer timer_;
 };
 
-TEST_F(TaskGraphRunnerPerfTest, BuildTaskGraph) {
+TEST_P(TaskGraphRunnerPerfTest, BuildTaskGraph) {
   RunBuildTaskGraphTest("0_1_0", 0, 1, 0);
   RunBuildTaskGraphTest("0_32_0", 0, 32, 0);
   RunBuildTaskGraphTest("2_1_0", 2, 1, 0);
@@ -299,25 +397,37 @@ TEST_F(TaskGraphRunnerPerfTest, BuildTaskGraph) {
   RunBuildTaskGraphTest("2_32_1", 2, 32, 1);
 }
 
-TEST_F(TaskGraphRunnerPerfTest, ScheduleTasks) {
+TEST_P(TaskGraphRunnerPerfTest, ScheduleTasks) {
   RunScheduleTasksTest("0_1_0", 0, 1, 0);
   RunScheduleTasksTest("0_32_0", 0, 32, 0);
   RunScheduleTasksTest("2_1_0", 2, 1, 0);
   RunScheduleTasksTest("2_32_0", 2, 32, 0);
   RunScheduleTasksTest("2_1_1", 2, 1, 1);
   RunScheduleTasksTest("2_32_1", 2, 32, 1);
+  RunScheduleTasksTest("0_10000_0", 0, 10000, 0);
+  RunScheduleTasksTest("2_10000_1", 2, 10000, 1);
 }
 
-TEST_F(TaskGraphRunnerPerfTest, ScheduleAlternateTasks) {
+TEST_P(TaskGraphRunnerPerfTest, ScheduleAlternateTasks) {
   RunScheduleAlternateTasksTest("0_1_0", 0, 1, 0);
   RunScheduleAlternateTasksTest("0_32_0", 0, 32, 0);
   RunScheduleAlternateTasksTest("2_1_0", 2, 1, 0);
   RunScheduleAlternateTasksTest("2_32_0", 2, 32, 0);
   RunScheduleAlternateTasksTest("2_1_1", 2, 1, 1);
   RunScheduleAlternateTasksTest("2_32_1", 2, 32, 1);
+  RunScheduleAlternateTasksTest("0_10000_0", 0, 10000, 0);
+  RunScheduleAlternateTasksTest("2_10000_1", 2, 10000, 1);
 }
 
-TEST_F(TaskGraphRunnerPerfTest, ScheduleAndExecuteTasks) {
+TEST_P(TaskGraphRunnerPerfTest, ScheduleAndCancelTasks) {
+  RunScheduleAndCancelTasksTest("0_32_0", 0, 32, 0);
+  RunScheduleAndCancelTasksTest("2_32_1", 2, 32, 1);
+  RunScheduleAndCancelTasksTest("0_10000_0", 0, 10000, 0);
+  RunScheduleAndCancelTasksTest("2_10000_1", 2, 10000, 1);
+}
+
+TEST_P(TaskGraphRunnerPerfTest, ScheduleAndExecuteTasks) {
+  StartWorkers();
   RunScheduleAndExecuteTasksTest("0_1_0", 0, 1, 0);
   RunScheduleAndExecuteTasksTest("0_32_0", 0, 32, 0);
   RunScheduleAndExecuteTasksTest("2_1_0", 2, 1, 0);
@@ -326,5 +436,11 @@ TEST_F(TaskGraphRunnerPerfTest, ScheduleAndExecuteTasks) {
   RunScheduleAndExecuteTasksTest("2_32_1", 2, 32, 1);
 }
 
+INSTANTIATE_TEST_CASE_P(
+    TaskGraphRunnerPerfTests,
+    TaskGraphRunnerPerfTest,
+    ::testing::Values(TASK_GRAPH_RUNNER_TYPE_SYNCHRONOUS,
+                      TASK_GRAPH_RUNNER_TYPE_WORK_STEALING));
+
 }  // namespace
 }  // namespace cc
@@ -0,0 +1,634 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/work_stealing_task_graph_runner.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/trace_event/trace_event.h"
+#include "cc/raster/task_graph_work_queue.h"
+
+namespace cc {
+namespace {
+
+// The states of a task record. Only the transitions out of QUEUED race: a
+// worker starting the task competes with ScheduleTasks() canceling or
+// unqueuing it, and the compare-and-swap decides which one wins.
+enum TaskRecordState {
+  // Some of the dependencies of the task haven't completed yet.
+  WAITING,
+  // The task is in a ready queue.
+  QUEUED,
+  RUNNING,
+  FINISHED,
+  CANCELED,
+};
+
+// Queues with fewer stale entries than this aren't worth compacting.
+const size_t kMinStaleTasksToCompact = 32;
+
+}  // namespace
+
+// The state of a task in a namespace, kept from one ScheduleTasks() to the
+// next so that tasks which didn't change aren't queued again.
+class WorkStealingTaskGraphRunner::TaskRecord
+    : public base::RefCountedThreadSafe<TaskRecord> {
+ public:
+  TaskRecord(Task* task, TaskNamespace* task_namespace)
+      : task(task),
+        task_namespace(task_namespace),
+        generation(0),
+        category(0),
+        priority(0),
+        queue_index(0),
+        queued_category(0),
+        queued_priority(0),
+        completed(false),
+        remaining_dependencies(0),
+        state(WAITING),
+        version(0) {}
+
+  scoped_refptr<Task> task;
+  TaskNamespace* task_namespace;
+
+  // The following members are only changed by ScheduleTasks() and
+  // CollectCompletedTasks().
+  // The generation of the last graph of the namespace the task was in.
+  uint32_t generation;
+  uint16_t category;
+  uint16_t priority;
+  // The tasks which depend on this task in the current graph.
+  std::vector<TaskRecord*> dependents;
+
+  // The following members are changed by whoever moves the task to QUEUED.
+  size_t queue_index;
+  uint16_t queued_category;
+  uint16_t queued_priority;
+
+  // True while the task is in the completed tasks of the namespace, which
+  // haven't been collected yet. Protected by |completion_lock_|.
+  bool completed;
+
+  base::subtle::Atomic32 remaining_dependencies;
+  base::subtle::Atomic32 state;
+  // Incremented each time the task is queued, so that the older entries of
+  // the ready queues can be told apart.
+  base::subtle::Atomic32 version;
+
+ private:
+  friend class base::RefCountedThreadSafe<TaskRecord>;
+
+  ~TaskRecord() {}
+
+  DISALLOW_COPY_AND_ASSIGN(TaskRecord);
+};
+
+struct WorkStealingTaskGraphRunner::TaskNamespace {
+  TaskNamespace() : generation(0), num_active_tasks(0) {}
+
+  // The tasks of the current graph, and the tasks of the previous graphs
+  // which are still running or haven't been collected yet.
+  std::unordered_map<const Task*, scoped_refptr<TaskRecord>> records;
+  uint32_t generation;
+
+  // The number of tasks which are queued or running.
+  base::subtle::Atomic32 num_active_tasks;
+
+  // Protected by |completion_lock_|.
+  Task::Vector completed_tasks;
+};
+
+struct WorkStealingTaskGraphRunner::ReadyTask {
+  ReadyTask() : category(0), priority(0), version(0) {}
+  ReadyTask(TaskRecord* record,
+            uint16_t category,
+            uint16_t priority,
+            base::subtle::Atomic32 version)
+      : record(record),
+        category(category),
+        priority(priority),
+        version(version) {}
+
+  // Returns the entry for |record|, which is queued on the queue at
+  // |queue_index|. The older entries of the task become stale.
+  static ReadyTask Create(TaskRecord* record, size_t queue_index) {
+    record->queue_index = queue_index;
+    record->queued_category = record->category;
+    record->queued_priority = record->priority;
+    return ReadyTask(
+        record, record->category, record->priority,
+        base::subtle::Barrier_AtomicIncrement(&record->version, 1));
+  }
+
+  // Ordering for std::push_heap(), which puts the greatest element at the
+  // top: the lowest category, then the lowest priority, runs first.
+  static bool Compare(const ReadyTask& a, const ReadyTask& b) {
+    if (a.category != b.category)
+      return a.category > b.category;
+    return a.priority > b.priority;
+  }
+
+  // Returns true if the entry is for a task which was canceled, unqueued,
+  // started or queued again since.
+  bool IsStale() const {
+    return version != base::subtle::Acquire_Load(&record->version) ||
+           base::subtle::Acquire_Load(&record->state) != QUEUED;
+  }
+
+  scoped_refptr<TaskRecord> record;
+  uint16_t category;
+  uint16_t priority;
+  base::subtle::Atomic32 version;
+};
+
+struct WorkStealingTaskGraphRunner::ReadyQueue {
+  ReadyQueue() : num_stale_tasks(0), num_pending_stale_tasks(0) {}
+
+  base::Lock lock;
+  // A heap ordered by ReadyTask::Compare().
+  std::vector<ReadyTask> tasks;
+  // An upper bound of the number of stale entries of |tasks|.
+  size_t num_stale_tasks;
+
+  // The entries and stale entries ScheduleTasks() adds, protected by
+  // |graph_lock_|.
+  std::vector<ReadyTask> pending_tasks;
+  size_t num_pending_stale_tasks;
+};
+
+class WorkStealingTaskGraphRunner::Worker
+    : public base::DelegateSimpleThread::Delegate {
+ public:
+  Worker(WorkStealingTaskGraphRunner* runner, size_t index)
+      : runner_(runner), index_(index) {}
+
+  // Overridden from base::DelegateSimpleThread::Delegate:
+  void Run() override { runner_->RunWorker(index_); }
+
+ private:
+  WorkStealingTaskGraphRunner* runner_;
+  const size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+// static
+void WorkStealingTaskGraphRunner::ForgetTaskRecord(TaskRecord* record) {
+  // Stale entries of the ready queues can keep the record alive until a
+  // worker pops them. Release the task now so that it isn't destroyed on a
+  // worker thread. The task of a record which can't run anymore is never
+  // used again.
+  record->task = nullptr;
+  record->task_namespace = nullptr;
+}
+
+WorkStealingTaskGraphRunner::WorkStealingTaskGraphRunner(size_t num_workers)
+    : next_namespace_id_(1),
+      next_queue_index_(0),
+      has_namespaces_with_finished_running_tasks_cv_(&completion_lock_),
+      num_ready_tasks_(0),
+      num_idle_workers_(0),
+      has_ready_to_run_tasks_cv_(&idle_lock_),
+      shutdown_(false) {
+  DCHECK_GT(num_workers, 0u);
+  for (size_t i = 0; i < num_workers; ++i) {
+    queues_.push_back(base::WrapUnique(new ReadyQueue));
+    workers_.push_back(base::WrapUnique(new Worker(this, i)));
+  }
+}
+
+WorkStealingTaskGraphRunner::~WorkStealingTaskGraphRunner() {}
+
+void WorkStealingTaskGraphRunner::Start(
+    const std::string& thread_name_prefix,
+    const base::SimpleThread::Options& thread_options) {
+  DCHECK(threads_.empty());
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    std::unique_ptr<base::SimpleThread> thread(new base::DelegateSimpleThread(
+        workers_[i].get(), thread_name_prefix + base::SizeTToString(i + 1),
+        thread_options));
+    thread->Start();
+    threads_.push_back(std::move(thread));
+  }
+}
+
+void WorkStealingTaskGraphRunner::Shutdown() {
+  {
+    base::AutoLock lock(idle_lock_);
+
+    DCHECK(!shutdown_);
+    shutdown_ = true;
+
+    // Wake up the workers so they know they should exit.
+    has_ready_to_run_tasks_cv_.Broadcast();
+  }
+  for (const auto& thread : threads_)
+    thread->Join();
+  threads_.clear();
+}
+
+NamespaceToken WorkStealingTaskGraphRunner::GetNamespaceToken() {
+  base::subtle::AutoWriteLock lock(graph_lock_);
+  return NamespaceToken(next_namespace_id_++);
+}
+
+void WorkStealingTaskGraphRunner::ScheduleTasks(NamespaceToken token,
+                                                TaskGraph* graph) {
+  TRACE_EVENT2("cc", "WorkStealingTaskGraphRunner::ScheduleTasks", "num_nodes",
+               graph->nodes.size(), "num_edges", graph->edges.size());
+
+  DCHECK(token.IsValid());
+  DCHECK(!TaskGraphWorkQueue::DependencyMismatch(graph));
+
+  int num_new_ready_tasks;
+  {
+    base::subtle::AutoWriteLock lock(graph_lock_);
+    base::AutoLock completion_lock(completion_lock_);
+
+    std::unique_ptr<TaskNamespace>& task_namespace_ptr =
+        namespaces_[token.id_];
+    if (!task_namespace_ptr)
+      task_namespace_ptr.reset(new TaskNamespace);
+    TaskNamespace* task_namespace = task_namespace_ptr.get();
+    const uint32_t generation = ++task_namespace->generation;
+    task_namespace->records.reserve(graph->nodes.size());
+
+    // Find the records of the tasks of the new graph, and add the tasks which
+    // weren't in the previous graphs.
+    for (const TaskGraph::Node& node : graph->nodes) {
+      scoped_refptr<TaskRecord>& record = task_namespace->records[node.task];
+      if (!record) {
+        record = new TaskRecord(node.task, task_namespace);
+        // A task which ran in a namespace since removed.
+        if (node.task->state().IsFinished())
+          base::subtle::NoBarrier_Store(&record->state, FINISHED);
+      }
+      record->generation = generation;
+      record->category = node.category;
+      record->priority = node.priority;
+      record->dependents.clear();
+      base::subtle::NoBarrier_Store(&record->remaining_dependencies,
+                                    node.dependencies);
+    }
+
+    // Cancel the tasks which were removed from the graph and haven't started
+    // yet. Forget the ones which have completed and been collected.
+    for (auto it = task_namespace->records.begin();
+         it != task_namespace->records.end();) {
+      TaskRecord* record = it->second.get();
+      if (record->generation == generation) {
+        ++it;
+        continue;
+      }
+      record->dependents.clear();
+
+      base::subtle::Atomic32 state =
+          base::subtle::NoBarrier_Load(&record->state);
+      if (state == WAITING || state == QUEUED) {
+        // A queued task can start running concurrently.
+        state = base::subtle::Acquire_CompareAndSwap(&record->state, state,
+                                                     CANCELED);
+        if (state == QUEUED) {
+          AddPendingStaleTask(record->queue_index);
+          base::subtle::NoBarrier_AtomicIncrement(
+              &task_namespace->num_active_tasks, -1);
+        }
+        if (state == WAITING || state == QUEUED) {
+          record->task->state().DidCancel();
+          task_namespace->completed_tasks.push_back(record->task);
+          record->completed = true;
+        }
+      }
+
+      state = base::subtle::NoBarrier_Load(&record->state);
+      if ((state == FINISHED || state == CANCELED) && !record->completed) {
+        ForgetTaskRecord(record);
+        it = task_namespace->records.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // Build the dependents of the tasks. The tasks which have completed since
+    // the last CollectCompletedTasks() count as satisfied dependencies.
+    for (const TaskGraph::Edge& edge : graph->edges) {
+      auto it = task_namespace->records.find(edge.task);
+      if (it == task_namespace->records.end())
+        continue;
+      TaskRecord* record = it->second.get();
+      TaskRecord* dependent = task_namespace->records[edge.dependent].get();
+      DCHECK(dependent);
+      if (record->completed) {
+        base::subtle::NoBarrier_AtomicIncrement(
+            &dependent->remaining_dependencies, -1);
+      } else {
+        record->dependents.push_back(dependent);
+      }
+    }
+
+    // Queue the tasks which became ready, unqueue the ones which aren't ready
+    // anymore and move the ones whose priority changed. The other queued
+    // tasks keep their entries.
+    for (const TaskGraph::Node& node : graph->nodes) {
+      TaskRecord* record = task_namespace->records[node.task].get();
+      bool ready =
+          !base::subtle::NoBarrier_Load(&record->remaining_dependencies);
+      base::subtle::Atomic32 state =
+          base::subtle::NoBarrier_Load(&record->state);
+
+      if (state == WAITING) {
+        if (!ready)
+          continue;
+        record->task->state().DidSchedule();
+        base::subtle::Release_Store(&record->state, QUEUED);
+        base::subtle::NoBarrier_AtomicIncrement(
+            &task_namespace->num_active_tasks, 1);
+        AddPendingReadyTask(record, next_queue_index_);
+        next_queue_index_ = (next_queue_index_ + 1) % queues_.size();
+      } else if (state == QUEUED) {
+        if (!ready) {
+          if (base::subtle::Acquire_CompareAndSwap(&record->state, QUEUED,
+                                                   WAITING) != QUEUED) {
+            continue;
+          }
+          record->task->state().Reset();
+          AddPendingStaleTask(record->queue_index);
+          base::subtle::NoBarrier_AtomicIncrement(
+              &task_namespace->num_active_tasks, -1);
+        } else if (record->queued_category != record->category ||
+                   record->queued_priority != record->priority) {
+          // The task stays QUEUED: whichever of its entries a worker pops
+          // first runs it.
+          AddPendingStaleTask(record->queue_index);
+          AddPendingReadyTask(record, record->queue_index);
+        }
+      }
+    }
+
+    num_new_ready_tasks = FlushPendingReadyTasks();
+
+    // Canceling tasks may have finished the namespace.
+    if (!base::subtle::NoBarrier_Load(&task_namespace->num_active_tasks))
+      has_namespaces_with_finished_running_tasks_cv_.Broadcast();
+  }
+
+  if (num_new_ready_tasks)
+    WakeUpWorkers(num_new_ready_tasks);
+}
+
+void WorkStealingTaskGraphRunner::WaitForTasksToFinishRunning(
+    NamespaceToken token) {
+  TRACE_EVENT0("cc",
+               "WorkStealingTaskGraphRunner::WaitForTasksToFinishRunning");
+
+  DCHECK(token.IsValid());
+
+  // The namespace can only be removed by CollectCompletedTasks(), which is
+  // called on the same origin thread.
+  TaskNamespace* task_namespace;
+  {
+    base::subtle::AutoReadLock lock(graph_lock_);
+    auto it = namespaces_.find(token.id_);
+    if (it == namespaces_.end())
+      return;
+    task_namespace = it->second.get();
+  }
+
+  {
+    base::AutoLock lock(completion_lock_);
+    base::ThreadRestrictions::ScopedAllowWait allow_wait;
+
+    while (base::subtle::NoBarrier_Load(&task_namespace->num_active_tasks))
+      has_namespaces_with_finished_running_tasks_cv_.Wait();
+  }
+}
+
+void WorkStealingTaskGraphRunner::CollectCompletedTasks(
+    NamespaceToken token,
+    Task::Vector* completed_tasks) {
+  TRACE_EVENT0("cc", "WorkStealingTaskGraphRunner::CollectCompletedTasks");
+
+  DCHECK(token.IsValid());
+  DCHECK_EQ(0u, completed_tasks->size());
+
+  base::subtle::AutoWriteLock lock(graph_lock_);
+
+  auto it = namespaces_.find(token.id_);
+  if (it == namespaces_.end())
+    return;
+  TaskNamespace* task_namespace = it->second.get();
+
+  {
+    base::AutoLock completion_lock(completion_lock_);
+    completed_tasks->swap(task_namespace->completed_tasks);
+  }
+
+  // The collected tasks are forgotten unless they are in the current graph,
+  // whose next version could depend on them again.
+  for (const auto& task : *completed_tasks) {
+    auto record_it = task_namespace->records.find(task.get());
+    DCHECK(record_it != task_namespace->records.end());
+    TaskRecord* record = record_it->second.get();
+    record->completed = false;
+    if (record->generation != task_namespace->generation) {
+      ForgetTaskRecord(record);
+      task_namespace->records.erase(record_it);
+    }
+  }
+
+  // Remove the namespace once it has finished running all its tasks.
+  if (!base::subtle::NoBarrier_Load(&task_namespace->num_active_tasks)) {
+    for (const auto& pair : task_namespace->records)
+      ForgetTaskRecord(pair.second.get());
+    namespaces_.erase(it);
+  }
+}
+
+void WorkStealingTaskGraphRunner::RunWorker(size_t index) {
+  while (true) {
+    ReadyTask ready_task;
+    if (!PopReadyTask(index, &ready_task)) {
+      if (!WaitForReadyTasks())
+        break;
+      continue;
+    }
+    RunReadyTask(index, ready_task);
+  }
+}
+
+bool WorkStealingTaskGraphRunner::PopReadyTask(size_t index,
+                                               ReadyTask* ready_task) {
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    ReadyQueue* queue = queues_[(index + i) % queues_.size()].get();
+    base::AutoLock lock(queue->lock);
+    if (queue->tasks.empty())
+      continue;
+
+    std::pop_heap(queue->tasks.begin(), queue->tasks.end(),
+                  ReadyTask::Compare);
+    *ready_task = std::move(queue->tasks.back());
+    queue->tasks.pop_back();
+    base::subtle::Barrier_AtomicIncrement(&num_ready_tasks_, -1);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingTaskGraphRunner::RunReadyTask(size_t index,
+                                               const ReadyTask& ready_task) {
+  TaskRecord* record = ready_task.record.get();
+
+  // Skip the entry if the task was canceled, started from another entry, or
+  // queued again since.
+  if (ready_task.version != base::subtle::Acquire_Load(&record->version))
+    return;
+  if (base::subtle::Acquire_CompareAndSwap(&record->state, QUEUED, RUNNING) !=
+      QUEUED) {
+    return;
+  }
+
+  record->task->state().DidStart();
+  {
+    TRACE_EVENT0("toplevel", "WorkStealingTaskGraphRunner::RunTask");
+    record->task->RunOnWorkerThread();
+  }
+
+  int num_new_ready_tasks = 0;
+  {
+    base::subtle::AutoReadLock lock(graph_lock_);
+    TaskNamespace* task_namespace = record->task_namespace;
+
+    record->task->state().DidFinish();
+    base::subtle::Release_Store(&record->state, FINISHED);
+
+    // Queue the dependents which became ready on this worker's queue, where
+    // their inputs are likely still in cache.
+    for (TaskRecord* dependent : record->dependents) {
+      if (base::subtle::Barrier_AtomicIncrement(
+              &dependent->remaining_dependencies, -1)) {
+        continue;
+      }
+      if (base::subtle::Acquire_CompareAndSwap(&dependent->state, WAITING,
+                                               QUEUED) != WAITING) {
+        continue;
+      }
+      dependent->task->state().DidSchedule();
+      base::subtle::NoBarrier_AtomicIncrement(
+          &task_namespace->num_active_tasks, 1);
+      PushReadyTask(dependent, index);
+      ++num_new_ready_tasks;
+    }
+
+    base::AutoLock completion_lock(completion_lock_);
+    task_namespace->completed_tasks.push_back(record->task);
+    record->completed = true;
+    if (!base::subtle::Barrier_AtomicIncrement(
+            &task_namespace->num_active_tasks, -1)) {
+      has_namespaces_with_finished_running_tasks_cv_.Broadcast();
+    }
+  }
+
+  // This worker runs one of the new ready tasks itself.
+  if (num_new_ready_tasks > 1)
+    WakeUpWorkers(num_new_ready_tasks - 1);
+}
+
+void WorkStealingTaskGraphRunner::PushReadyTask(TaskRecord* record,
+                                                size_t queue_index) {
+  ReadyTask ready_task = ReadyTask::Create(record, queue_index);
+
+  ReadyQueue* queue = queues_[queue_index].get();
+  {
+    base::AutoLock lock(queue->lock);
+    CompactReadyQueueIfNeeded(queue);
+    queue->tasks.push_back(std::move(ready_task));
+    std::push_heap(queue->tasks.begin(), queue->tasks.end(),
+                   ReadyTask::Compare);
+  }
+  base::subtle::Barrier_AtomicIncrement(&num_ready_tasks_, 1);
+}
+
+void WorkStealingTaskGraphRunner::AddPendingReadyTask(TaskRecord* record,
+                                                      size_t queue_index) {
+  queues_[queue_index]->pending_tasks.push_back(
+      ReadyTask::Create(record, queue_index));
+}
+
+void WorkStealingTaskGraphRunner::AddPendingStaleTask(size_t queue_index) {
+  ++queues_[queue_index]->num_pending_stale_tasks;
+}
+
+int WorkStealingTaskGraphRunner::FlushPendingReadyTasks() {
+  int num_new_ready_tasks = 0;
+  for (const auto& queue : queues_) {
+    if (queue->pending_tasks.empty() && !queue->num_pending_stale_tasks)
+      continue;
+
+    base::AutoLock lock(queue->lock);
+    queue->num_stale_tasks += queue->num_pending_stale_tasks;
+    queue->num_pending_stale_tasks = 0;
+    CompactReadyQueueIfNeeded(queue.get());
+    for (ReadyTask& ready_task : queue->pending_tasks) {
+      queue->tasks.push_back(std::move(ready_task));
+      std::push_heap(queue->tasks.begin(), queue->tasks.end(),
+                     ReadyTask::Compare);
+    }
+    num_new_ready_tasks += static_cast<int>(queue->pending_tasks.size());
+    queue->pending_tasks.clear();
+  }
+  base::subtle::Barrier_AtomicIncrement(&num_ready_tasks_,
+                                        num_new_ready_tasks);
+  return num_new_ready_tasks;
+}
+
+void WorkStealingTaskGraphRunner::CompactReadyQueueIfNeeded(
+    ReadyQueue* queue) {
+  queue->lock.AssertAcquired();
+
+  if (queue->num_stale_tasks < kMinStaleTasksToCompact ||
+      queue->num_stale_tasks * 2 < queue->tasks.size()) {
+    return;
+  }
+
+  auto end = std::remove_if(
+      queue->tasks.begin(), queue->tasks.end(),
+      [](const ReadyTask& ready_task) { return ready_task.IsStale(); });
+  int num_stale_tasks = static_cast<int>(queue->tasks.end() - end);
+  queue->tasks.erase(end, queue->tasks.end());
+  std::make_heap(queue->tasks.begin(), queue->tasks.end(), ReadyTask::Compare);
+  queue->num_stale_tasks = 0;
+  base::subtle::Barrier_AtomicIncrement(&num_ready_tasks_, -num_stale_tasks);
+}
+
+bool WorkStealingTaskGraphRunner::WaitForReadyTasks() {
+  base::AutoLock lock(idle_lock_);
+
+  base::subtle::Barrier_AtomicIncrement(&num_idle_workers_, 1);
+  while (!shutdown_ && !base::subtle::Acquire_Load(&num_ready_tasks_))
+    has_ready_to_run_tasks_cv_.Wait();
+  base::subtle::Barrier_AtomicIncrement(&num_idle_workers_, -1);
+
+  // Exit when shutdown is set and no more tasks are queued.
+  return !shutdown_ || base::subtle::Acquire_Load(&num_ready_tasks_);
+}
+
+void WorkStealingTaskGraphRunner::WakeUpWorkers(int num_ready_tasks) {
+  // |num_ready_tasks_| was incremented with a barrier, so a worker which isn't
+  // counted as idle yet will see the new tasks before it waits.
+  if (!base::subtle::Acquire_Load(&num_idle_workers_))
+    return;
+
+  base::AutoLock lock(idle_lock_);
+  if (num_ready_tasks > 1)
+    has_ready_to_run_tasks_cv_.Broadcast();
+  else
+    has_ready_to_run_tasks_cv_.Signal();
+}
+
+}  // namespace cc
@@ -0,0 +1,150 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
+#define CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/read_write_lock.h"
+#include "base/threading/simple_thread.h"
+#include "cc/base/cc_export.h"
+#include "cc/raster/task_graph_runner.h"
+
+namespace cc {
+
+// Runs TaskGraphs on a pool of worker threads, each with its own queue of the
+// tasks which are ready to run. A worker runs the tasks of its own queue first,
+// and steals from the queues of the other workers when its queue is empty.
+//
+// The dependencies of a task are counted down atomically by the workers
+// running the tasks it depends on, so that finishing a task doesn't need the
+// lock of the whole graph exclusively. ScheduleTasks() diffs the new graph
+// against the tasks the namespace already has: a task which is still queued
+// with the same category and priority stays where it is, and only the tasks
+// which were added, removed or changed are queued or canceled.
+//
+// This task graph runner treats categories as an additional priority, but
+// priorities are only followed within the queue of each worker.
+class CC_EXPORT WorkStealingTaskGraphRunner : public TaskGraphRunner {
+ public:
+  explicit WorkStealingTaskGraphRunner(size_t num_workers);
+  ~WorkStealingTaskGraphRunner() override;
+
+  // Overridden from TaskGraphRunner:
+  NamespaceToken GetNamespaceToken() override;
+  void ScheduleTasks(NamespaceToken token, TaskGraph* graph) override;
+  void WaitForTasksToFinishRunning(NamespaceToken token) override;
+  void CollectCompletedTasks(NamespaceToken token,
+                             Task::Vector* completed_tasks) override;
+
+  // Starts the worker threads, named |thread_name_prefix| followed by their
+  // index. Tasks scheduled before this stay queued until it is called.
+  void Start(const std::string& thread_name_prefix,
+             const base::SimpleThread::Options& thread_options);
+  void Shutdown();
+
+ private:
+  class TaskRecord;
+  struct TaskNamespace;
+  struct ReadyTask;
+  struct ReadyQueue;
+  class Worker;
+
+  // Called on the records a namespace drops, which won't run again.
+  static void ForgetTaskRecord(TaskRecord* record);
+
+  // Runs the tasks of the queue at |index|, and the tasks it steals, until
+  // shutdown.
+  void RunWorker(size_t index);
+
+  // Removes the next task to run from the queue at |index| or, if it is
+  // empty, from the queue of another worker. Returns false if all the queues
+  // are empty.
+  bool PopReadyTask(size_t index, ReadyTask* ready_task);
+
+  // Runs the task of |ready_task| unless it was canceled or queued again since
+  // it was popped, and queues its dependents which become ready on the queue
+  // at |index|.
+  void RunReadyTask(size_t index, const ReadyTask& ready_task);
+
+  // Adds |record|, which must be in the QUEUED state, to the queue at
+  // |queue_index|.
+  void PushReadyTask(TaskRecord* record, size_t queue_index);
+
+  // Like PushReadyTask(), but the entry is only added to the queue by
+  // FlushPendingReadyTasks(), so that ScheduleTasks() acquires the lock of
+  // each queue once. Must be called with |graph_lock_| acquired exclusively.
+  void AddPendingReadyTask(TaskRecord* record, size_t queue_index);
+
+  // Records that the queue at |queue_index| holds one more entry for a task
+  // which was canceled, unqueued or queued again. Must be called with
+  // |graph_lock_| acquired exclusively.
+  void AddPendingStaleTask(size_t queue_index);
+
+  // Adds the pending entries and stale entries to the queues. Returns the
+  // number of entries added.
+  int FlushPendingReadyTasks();
+
+  // Removes the stale entries of |queue| once they are most of it. Must be
+  // called with the lock of |queue| acquired.
+  void CompactReadyQueueIfNeeded(ReadyQueue* queue);
+
+  // Waits until there are tasks to run or shutdown starts. Returns false if
+  // the worker should exit.
+  bool WaitForReadyTasks();
+  void WakeUpWorkers(int num_ready_tasks);
+
+  std::vector<std::unique_ptr<ReadyQueue>> queues_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<base::SimpleThread>> threads_;
+
+  // Taken exclusively by ScheduleTasks() and CollectCompletedTasks(), which
+  // change the graph, and shared by the workers finishing tasks, which only
+  // count down dependencies.
+  base::subtle::ReadWriteLock graph_lock_;
+
+  // The namespaces and the queue for the next task ScheduleTasks() makes
+  // ready, protected by |graph_lock_|.
+  std::map<int, std::unique_ptr<TaskNamespace>> namespaces_;
+  int next_namespace_id_;
+  size_t next_queue_index_;
+
+  // Protects the completed tasks of the namespaces, and is the lock of the
+  // condition variable waited on by origin threads until a namespace has
+  // finished running all its tasks. Acquired after |graph_lock_|.
+  base::Lock completion_lock_;
+  base::ConditionVariable has_namespaces_with_finished_running_tasks_cv_;
+
+  // The number of entries of all the queues, stale ones included, and the
+  // number of workers waiting for one of them.
+  base::subtle::Atomic32 num_ready_tasks_;
+  base::subtle::Atomic32 num_idle_workers_;
+
+  // Lock of the condition variable idle workers wait on until there are tasks
+  // to run or shutdown starts, and of |shutdown_|.
+  base::Lock idle_lock_;
+  base::ConditionVariable has_ready_to_run_tasks_cv_;
+
+  // Set during shutdown. Tells the workers to exit when no more tasks are
+  // queued.
+  bool shutdown_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingTaskGraphRunner);
+};
+
+}  // namespace cc
+
+#endif  // CC_RASTER_WORK_STEALING_TASK_GRAPH_RUNNER_H_
@@ -0,0 +1,198 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/raster/work_stealing_task_graph_runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+#include "cc/test/task_graph_runner_test_template.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace cc {
+namespace {
+
+const size_t kNumWorkers = 4;
+
+class WorkStealingTaskGraphRunnerTestDelegate {
+ public:
+  WorkStealingTaskGraphRunnerTestDelegate()
+      : work_stealing_task_graph_runner_(kNumWorkers) {}
+
+  void StartTaskGraphRunner() {
+    work_stealing_task_graph_runner_.Start(
+        "WorkStealingTaskGraphRunnerTestDelegate",
+        base::SimpleThread::Options());
+  }
+
+  TaskGraphRunner* GetTaskGraphRunner() {
+    return &work_stealing_task_graph_runner_;
+  }
+
+  void StopTaskGraphRunner() {}
+
+  ~WorkStealingTaskGraphRunnerTestDelegate() {
+    work_stealing_task_graph_runner_.Shutdown();
+  }
+
+ private:
+  WorkStealingTaskGraphRunner work_stealing_task_graph_runner_;
+};
+
+INSTANTIATE_TYPED_TEST_CASE_P(WorkStealingTaskGraphRunner,
+                              TaskGraphRunnerTest,
+                              WorkStealingTaskGraphRunnerTestDelegate);
+
+// Records the order the tasks run in.
+class OrderedTaskImpl : public Task {
+ public:
+  OrderedTaskImpl(base::Lock* lock, std::vector<const Task*>* run_tasks)
+      : lock_(lock), run_tasks_(run_tasks) {}
+
+  // Overridden from Task:
+  void RunOnWorkerThread() override {
+    base::AutoLock lock(*lock_);
+    run_tasks_->push_back(this);
+  }
+
+ private:
+  ~OrderedTaskImpl() override {}
+
+  base::Lock* lock_;
+  std::vector<const Task*>* run_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(OrderedTaskImpl);
+};
+
+class WorkStealingTaskGraphRunnerTest : public testing::Test {
+ public:
+  WorkStealingTaskGraphRunnerTest() : task_graph_runner_(kNumWorkers) {}
+
+  void SetUp() override {
+    namespace_token_ = task_graph_runner_.GetNamespaceToken();
+  }
+
+  void TearDown() override {
+    TaskGraph empty;
+    task_graph_runner_.ScheduleTasks(namespace_token_, &empty);
+    Task::Vector completed_tasks;
+    task_graph_runner_.CollectCompletedTasks(namespace_token_,
+                                             &completed_tasks);
+    task_graph_runner_.Shutdown();
+  }
+
+ protected:
+  scoped_refptr<Task> CreateTask() {
+    return make_scoped_refptr(new OrderedTaskImpl(&lock_, &run_tasks_));
+  }
+
+  void Start() {
+    task_graph_runner_.Start("WorkStealingTaskGraphRunnerTest",
+                             base::SimpleThread::Options());
+  }
+
+  void RunAllTasks(Task::Vector* completed_tasks) {
+    task_graph_runner_.WaitForTasksToFinishRunning(namespace_token_);
+    task_graph_runner_.CollectCompletedTasks(namespace_token_,
+                                             completed_tasks);
+  }
+
+  WorkStealingTaskGraphRunner task_graph_runner_;
+  NamespaceToken namespace_token_;
+  base::Lock lock_;
+  std::vector<const Task*> run_tasks_;
+};
+
+TEST_F(WorkStealingTaskGraphRunnerTest, RescheduleKeepsQueuedTasks) {
+  scoped_refptr<Task> tasks[] = {CreateTask(), CreateTask()};
+
+  // The workers aren't started, so the tasks stay queued across the
+  // reschedules, and none of them is canceled.
+  for (int i = 0; i < 3; ++i) {
+    TaskGraph graph;
+    for (const auto& task : tasks)
+      graph.nodes.push_back(TaskGraph::Node(task.get(), 0u, 0u, 0u));
+    task_graph_runner_.ScheduleTasks(namespace_token_, &graph);
+
+    Task::Vector completed_tasks;
+    task_graph_runner_.CollectCompletedTasks(namespace_token_,
+                                             &completed_tasks);
+    EXPECT_TRUE(completed_tasks.empty());
+  }
+
+  Start();
+  Task::Vector completed_tasks;
+  RunAllTasks(&completed_tasks);
+  EXPECT_EQ(2u, completed_tasks.size());
+  EXPECT_EQ(2u, run_tasks_.size());
+  for (const auto& task : tasks)
+    EXPECT_TRUE(task->state().IsFinished());
+}
+
+TEST_F(WorkStealingTaskGraphRunnerTest, CancelTasksRemovedFromGraph) {
+  scoped_refptr<Task> removed_task = CreateTask();
+  scoped_refptr<Task> kept_task = CreateTask();
+
+  TaskGraph graph;
+  graph.nodes.push_back(TaskGraph::Node(removed_task.get(), 0u, 0u, 0u));
+  graph.nodes.push_back(TaskGraph::Node(kept_task.get(), 0u, 0u, 0u));
+  task_graph_runner_.ScheduleTasks(namespace_token_, &graph);
+
+  graph.Reset();
+  graph.nodes.push_back(TaskGraph::Node(kept_task.get(), 0u, 0u, 0u));
+  task_graph_runner_.ScheduleTasks(namespace_token_, &graph);
+
+  Task::Vector completed_tasks;
+  task_graph_runner_.CollectCompletedTasks(namespace_token_, &completed_tasks);
+  ASSERT_EQ(1u, completed_tasks.size());
+  EXPECT_EQ(removed_task, completed_tasks[0]);
+  EXPECT_TRUE(removed_task->state().IsCanceled());
+
+  Start();
+  completed_tasks.clear();
+  RunAllTasks(&completed_tasks);
+  ASSERT_EQ(1u, completed_tasks.size());
+  EXPECT_EQ(kept_task, completed_tasks[0]);
+  ASSERT_EQ(1u, run_tasks_.size());
+  EXPECT_EQ(kept_task.get(), run_tasks_[0]);
+}
+
+TEST_F(WorkStealingTaskGraphRunnerTest, FanOutAndFanIn) {
+  const size_t kNumTasks = 1000;
+  scoped_refptr<Task> root_task = CreateTask();
+  scoped_refptr<Task> leaf_task = CreateTask();
+  Task::Vector tasks;
+  for (size_t i = 0; i < kNumTasks; ++i)
+    tasks.push_back(CreateTask());
+
+  // The tasks in between are queued by the worker finishing |root_task|, and
+  // the last of them to finish queues |leaf_task|.
+  TaskGraph graph;
+  graph.nodes.push_back(TaskGraph::Node(root_task.get(), 0u, 0u, 0u));
+  for (const auto& task : tasks) {
+    graph.nodes.push_back(TaskGraph::Node(task.get(), 0u, 0u, 1u));
+    graph.edges.push_back(TaskGraph::Edge(root_task.get(), task.get()));
+    graph.edges.push_back(TaskGraph::Edge(task.get(), leaf_task.get()));
+  }
+  graph.nodes.push_back(TaskGraph::Node(
+      leaf_task.get(), 0u, 0u, static_cast<uint32_t>(kNumTasks)));
+
+  Start();
+  task_graph_runner_.ScheduleTasks(namespace_token_, &graph);
+  Task::Vector completed_tasks;
+  RunAllTasks(&completed_tasks);
+
+  EXPECT_EQ(kNumTasks + 2, completed_tasks.size());
+  ASSERT_EQ(kNumTasks + 2, run_tasks_.size());
+  EXPECT_EQ(root_task.get(), run_tasks_.front());
+  EXPECT_EQ(leaf_task.get(), run_tasks_.back());
+}
+
+}  // namespace
+}  // namespace cc
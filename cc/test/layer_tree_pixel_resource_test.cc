@@ -132,7 +132,7 @@ void LayerTreeHostPixelResourceTest::CreateResourceAndRasterBufferProvider(
       EXPECT_EQ(PIXEL_TEST_SOFTWARE, test_type_);
 
       *raster_buffer_provider =
-          BitmapRasterBufferProvider::Create(resource_provider);
+          BitmapRasterBufferProvider::Create(resource_provider, nullptr);
       break;
     case RASTER_BUFFER_PROVIDER_TYPE_GPU:
       EXPECT_TRUE(compositor_context_provider);
@@ -0,0 +1,371 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/shared_image_decode_cache.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/hash.h"
+#include "base/lazy_instance.h"
+#include "base/memory/ptr_util.h"
+#include "base/sha1.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "cc/tiles/software_image_decode_controller.h"
+#include "third_party/skia/include/core/SkData.h"
+#include "third_party/skia/include/core/SkImage.h"
+
+namespace cc {
+namespace {
+
+// The number of SkImage ids for which to remember the content id. Computing
+// the id hashes the encoded data, so this avoids doing that on every decode.
+const size_t kMaxContentIds = 1000;
+
+// The number by which the budget is divided when consumers reduce their cache
+// usage, so that unused decodes don't keep the whole budget resident.
+const size_t kReducedLimitDivisor = 4;
+
+struct InstanceHolder {
+  InstanceHolder()
+      : cache(new SharedImageDecodeCache(
+            SharedImageDecodeCache::kDefaultLimitBytes)),
+        memory_pressure_listener(
+            base::Bind(&SharedImageDecodeCache::OnMemoryPressure,
+                       base::Unretained(cache.get()))) {}
+
+  scoped_refptr<SharedImageDecodeCache> cache;
+  // The cache is leaked, so it is never destroyed before the listener.
+  base::MemoryPressureListener memory_pressure_listener;
+};
+
+base::LazyInstance<InstanceHolder>::Leaky g_instance =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// Segment
+class SharedImageDecodeCache::Segment
+    : public base::RefCountedThreadSafe<Segment> {
+ public:
+  Segment(int id, size_t size)
+      : id_(id), size_(size), lock_count_(0), purged_(false) {}
+
+  base::DiscardableSharedMemory* shared_memory() { return &shared_memory_; }
+  int id() const { return id_; }
+  size_t size() const { return size_; }
+
+  // The lock state is guarded by the lock of the SharedImageDecodeCache.
+  int lock_count() const { return lock_count_; }
+  void set_lock_count(int lock_count) { lock_count_ = lock_count; }
+  bool purged() const { return purged_; }
+  void set_purged() { purged_ = true; }
+
+ private:
+  friend class base::RefCountedThreadSafe<Segment>;
+
+  ~Segment() {}
+
+  base::DiscardableSharedMemory shared_memory_;
+  const int id_;
+  const size_t size_;
+  int lock_count_;
+  bool purged_;
+
+  DISALLOW_COPY_AND_ASSIGN(Segment);
+};
+
+// Key
+// static
+SharedImageDecodeCache::Key SharedImageDecodeCache::Key::FromImageKey(
+    const ImageDecodeControllerKey& image_key,
+    const std::string& content_id,
+    ResourceFormat format) {
+  Key key;
+  key.content_id_ = content_id;
+  key.format_ = format;
+  key.src_rect_ = image_key.src_rect();
+  key.target_size_ = image_key.target_size();
+  key.filter_quality_ = image_key.filter_quality();
+  key.can_use_original_decode_ = image_key.can_use_original_decode();
+
+  // Like ImageDecodeControllerKey, all original decodes of the same content
+  // are equal, so only the content id and format go into their hash.
+  size_t content_hash = base::HashInts(base::Hash(content_id), format);
+  if (key.can_use_original_decode_) {
+    key.hash_ = content_hash;
+  } else {
+    uint64_t src_rect_hash = base::HashInts(
+        static_cast<uint64_t>(
+            base::HashInts(key.src_rect_.x(), key.src_rect_.y())),
+        static_cast<uint64_t>(
+            base::HashInts(key.src_rect_.width(), key.src_rect_.height())));
+    uint64_t target_size_hash =
+        base::HashInts(key.target_size_.width(), key.target_size_.height());
+    key.hash_ =
+        base::HashInts(base::HashInts(src_rect_hash, target_size_hash),
+                       base::HashInts(static_cast<uint64_t>(content_hash),
+                                      key.filter_quality_));
+  }
+  return key;
+}
+
+SharedImageDecodeCache::Key::Key()
+    : format_(RGBA_8888),
+      filter_quality_(kNone_SkFilterQuality),
+      can_use_original_decode_(false),
+      hash_(0) {}
+
+SharedImageDecodeCache::Key::Key(const Key& other) = default;
+
+SharedImageDecodeCache::Key::~Key() {}
+
+bool SharedImageDecodeCache::Key::operator==(const Key& other) const {
+  return content_id_ == other.content_id_ && format_ == other.format_ &&
+         can_use_original_decode_ == other.can_use_original_decode_ &&
+         (can_use_original_decode_ ||
+          (src_rect_ == other.src_rect_ &&
+           target_size_ == other.target_size_ &&
+           filter_quality_ == other.filter_quality_));
+}
+
+// Memory
+SharedImageDecodeCache::Memory::Memory(
+    scoped_refptr<SharedImageDecodeCache> cache,
+    scoped_refptr<Segment> segment)
+    : cache_(std::move(cache)), segment_(std::move(segment)), locked_(true) {}
+
+SharedImageDecodeCache::Memory::~Memory() {
+  if (locked_)
+    Unlock();
+}
+
+bool SharedImageDecodeCache::Memory::Lock() {
+  DCHECK(!locked_);
+  base::AutoLock hold(cache_->lock_);
+  if (!cache_->LockSegment(segment_.get()))
+    return false;
+  locked_ = true;
+  return true;
+}
+
+void SharedImageDecodeCache::Memory::Unlock() {
+  DCHECK(locked_);
+  base::AutoLock hold(cache_->lock_);
+  cache_->UnlockSegment(segment_.get());
+  locked_ = false;
+}
+
+void* SharedImageDecodeCache::Memory::data() const {
+  DCHECK(locked_);
+  return segment_->shared_memory()->memory();
+}
+
+base::trace_event::MemoryAllocatorDump*
+SharedImageDecodeCache::Memory::CreateMemoryAllocatorDump(
+    const char* name,
+    base::trace_event::ProcessMemoryDump* pmd) const {
+  base::trace_event::MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(name);
+  dump->AddScalar(base::trace_event::MemoryAllocatorDump::kNameSize,
+                  base::trace_event::MemoryAllocatorDump::kUnitsBytes,
+                  static_cast<uint64_t>(segment_->size()));
+
+  // A segment can have several consumers. They all own the same segment dump,
+  // so that its memory is only counted once.
+  base::trace_event::MemoryAllocatorDump* segment_dump =
+      pmd->GetOrCreateAllocatorDump(base::StringPrintf(
+          "cc/shared_image_decodes/segment_%d", segment_->id()));
+  segment_dump->AddScalar(base::trace_event::MemoryAllocatorDump::kNameSize,
+                          base::trace_event::MemoryAllocatorDump::kUnitsBytes,
+                          static_cast<uint64_t>(segment_->size()));
+  pmd->AddOwnershipEdge(dump->guid(), segment_dump->guid());
+  return dump;
+}
+
+// SharedImageDecodeCache
+const size_t SharedImageDecodeCache::kDefaultLimitBytes = 256 * 1024 * 1024;
+
+// static
+SharedImageDecodeCache* SharedImageDecodeCache::GetInstance() {
+  return g_instance.Get().cache.get();
+}
+
+SharedImageDecodeCache::SharedImageDecodeCache(size_t limit_bytes)
+    : limit_bytes_(limit_bytes),
+      entries_(SegmentMRUCache::NO_AUTO_EVICT),
+      content_ids_(kMaxContentIds),
+      bytes_(0),
+      hits_(0),
+      misses_(0) {}
+
+SharedImageDecodeCache::~SharedImageDecodeCache() {}
+
+std::string SharedImageDecodeCache::GetContentId(const SkImage* image) {
+  uint32_t image_id = image->uniqueID();
+  {
+    base::AutoLock hold(lock_);
+    auto it = content_ids_.Get(image_id);
+    if (it != content_ids_.end())
+      return it->second;
+  }
+
+  // The prefixes keep ids from encoded data and process local ids apart.
+  std::string content_id;
+  sk_sp<SkData> encoded(image->refEncoded());
+  if (encoded) {
+    unsigned char hash[base::kSHA1Length];
+    base::SHA1HashBytes(encoded->bytes(), encoded->size(), hash);
+    content_id = "e:" + std::string(reinterpret_cast<const char*>(hash),
+                                    base::kSHA1Length);
+  } else {
+    content_id = base::StringPrintf("i:%u", image_id);
+  }
+
+  base::AutoLock hold(lock_);
+  content_ids_.Put(image_id, content_id);
+  return content_id;
+}
+
+std::unique_ptr<SharedImageDecodeCache::Memory>
+SharedImageDecodeCache::LockEntry(const Key& key) {
+  base::AutoLock hold(lock_);
+  auto it = entries_.Get(key);
+  if (it == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+
+  scoped_refptr<Segment> segment = it->second;
+  if (!LockSegment(segment.get())) {
+    bytes_ -= segment->size();
+    entries_.Erase(it);
+    ++misses_;
+    return nullptr;
+  }
+
+  ++hits_;
+  return base::WrapUnique(new Memory(this, std::move(segment)));
+}
+
+std::unique_ptr<SharedImageDecodeCache::Memory>
+SharedImageDecodeCache::AllocateLocked(size_t size) {
+  scoped_refptr<Segment> segment(
+      new Segment(next_segment_id_.GetNext(), size));
+  // The segment is created locked. It can't be seen by other consumers until
+  // it is inserted, so there's no need to hold the lock yet.
+  if (!segment->shared_memory()->CreateAndMap(size))
+    return nullptr;
+  // The segment is never shared with another process. Close file descriptor to
+  // avoid running out, as every cached decode has its own segment.
+  segment->shared_memory()->Close();
+  segment->set_lock_count(1);
+  return base::WrapUnique(new Memory(this, std::move(segment)));
+}
+
+void SharedImageDecodeCache::Insert(const Key& key, const Memory& memory) {
+  DCHECK_EQ(this, memory.cache_.get());
+  DCHECK(memory.locked_);
+  base::AutoLock hold(lock_);
+  auto it = entries_.Peek(key);
+  if (it != entries_.end()) {
+    if (!it->second->purged())
+      return;
+    bytes_ -= it->second->size();
+    entries_.Erase(it);
+  }
+
+  entries_.Put(key, memory.segment_);
+  bytes_ += memory.segment_->size();
+  EvictUnlockedEntries(limit_bytes_);
+}
+
+void SharedImageDecodeCache::ReduceCacheUsage() {
+  base::AutoLock hold(lock_);
+  EvictUnlockedEntries(limit_bytes_ / kReducedLimitDivisor);
+}
+
+void SharedImageDecodeCache::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel level) {
+  switch (level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL: {
+      base::AutoLock hold(lock_);
+      EvictUnlockedEntries(0u);
+      break;
+    }
+  }
+}
+
+SharedImageDecodeCache::Stats SharedImageDecodeCache::GetStats() const {
+  base::AutoLock hold(lock_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.entries = entries_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
+bool SharedImageDecodeCache::LockSegment(Segment* segment) {
+  lock_.AssertAcquired();
+  if (segment->purged())
+    return false;
+
+  // Only the first consumer to lock the segment locks the shared memory. Note
+  // that locking an already locked range of shared memory is not allowed.
+  if (segment->lock_count() == 0) {
+    base::DiscardableSharedMemory::LockResult result =
+        segment->shared_memory()->Lock(0, 0);
+    if (result != base::DiscardableSharedMemory::SUCCESS) {
+      // A purged segment is still locked, but its contents are gone.
+      if (result == base::DiscardableSharedMemory::PURGED)
+        segment->shared_memory()->Unlock(0, 0);
+      segment->set_purged();
+      return false;
+    }
+  }
+  segment->set_lock_count(segment->lock_count() + 1);
+  return true;
+}
+
+void SharedImageDecodeCache::UnlockSegment(Segment* segment) {
+  lock_.AssertAcquired();
+  DCHECK_GT(segment->lock_count(), 0);
+  segment->set_lock_count(segment->lock_count() - 1);
+  if (segment->lock_count() == 0)
+    segment->shared_memory()->Unlock(0, 0);
+}
+
+void SharedImageDecodeCache::EvictUnlockedEntries(size_t limit_bytes) {
+  lock_.AssertAcquired();
+  for (auto it = entries_.rbegin();
+       bytes_ > limit_bytes && it != entries_.rend();) {
+    Segment* segment = it->second.get();
+    if (segment->lock_count() > 0) {
+      ++it;
+      continue;
+    }
+
+    // Consumers might still hold unlocked memory for the segment. Purge it so
+    // that the pages are released now; their next Lock() will fail. If that
+    // fails, the pages are still resident, so the entry is kept and its bytes
+    // stay counted.
+    if (!segment->purged()) {
+      if (!segment->shared_memory()->Purge(base::Time::Now())) {
+        ++it;
+        continue;
+      }
+      segment->set_purged();
+    }
+    bytes_ -= segment->size();
+    it = entries_.Erase(it);
+  }
+}
+
+}  // namespace cc
@@ -0,0 +1,189 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CC_TILES_SHARED_IMAGE_DECODE_CACHE_H_
+#define CC_TILES_SHARED_IMAGE_DECODE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/atomic_sequence_num.h"
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/discardable_memory.h"
+#include "base/memory/discardable_shared_memory.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "cc/base/cc_export.h"
+#include "cc/resources/resource_format.h"
+#include "third_party/skia/include/core/SkFilterQuality.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+class SkImage;
+
+namespace cc {
+
+class ImageDecodeControllerKey;
+
+// SharedImageDecodeCache holds decoded and scaled image pixels in
+// base::DiscardableSharedMemory segments so that they can be reused by every
+// SoftwareImageDecodeController that uses the cache, instead of each
+// controller decoding the same image again. Entries are keyed by the content
+// of the image rather than by the SkImage that was decoded, so consumers that
+// have their own SkImage for the same encoded data still share one decode.
+//
+// This class is thread-safe.
+class CC_EXPORT SharedImageDecodeCache
+    : public base::RefCountedThreadSafe<SharedImageDecodeCache> {
+ public:
+  // Owns one shared memory segment holding the pixels of a decode.
+  class Segment;
+
+  // Identifies one decode of an image's content. This mirrors
+  // ImageDecodeControllerKey, with the SkImage id replaced by |content_id|.
+  // Consumers can decode to different formats, so the format is part of the
+  // key as well.
+  class CC_EXPORT Key {
+   public:
+    static Key FromImageKey(const ImageDecodeControllerKey& image_key,
+                            const std::string& content_id,
+                            ResourceFormat format);
+
+    Key();
+    Key(const Key& other);
+    ~Key();
+
+    bool operator==(const Key& other) const;
+    bool operator!=(const Key& other) const { return !(*this == other); }
+
+    const std::string& content_id() const { return content_id_; }
+    size_t get_hash() const { return hash_; }
+
+   private:
+    std::string content_id_;
+    ResourceFormat format_;
+    gfx::Rect src_rect_;
+    gfx::Size target_size_;
+    SkFilterQuality filter_quality_;
+    bool can_use_original_decode_;
+    size_t hash_;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const { return key.get_hash(); }
+  };
+
+  // Discardable pixels backed by a segment of this cache. Every consumer of a
+  // segment gets its own Memory; the segment stays locked while any of them
+  // is locked.
+  class CC_EXPORT Memory : public base::DiscardableMemory {
+   public:
+    ~Memory() override;
+
+    // base::DiscardableMemory implementation.
+    bool Lock() override;
+    void Unlock() override;
+    void* data() const override;
+    base::trace_event::MemoryAllocatorDump* CreateMemoryAllocatorDump(
+        const char* name,
+        base::trace_event::ProcessMemoryDump* pmd) const override;
+
+   private:
+    friend class SharedImageDecodeCache;
+
+    // Memory is always handed out locked.
+    Memory(scoped_refptr<SharedImageDecodeCache> cache,
+           scoped_refptr<Segment> segment);
+
+    scoped_refptr<SharedImageDecodeCache> cache_;
+    scoped_refptr<Segment> segment_;
+    bool locked_;
+
+    DISALLOW_COPY_AND_ASSIGN(Memory);
+  };
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+  };
+
+  // Returns the cache shared by all compositors in this process. Its budget is
+  // kDefaultLimitBytes.
+  static SharedImageDecodeCache* GetInstance();
+
+  static const size_t kDefaultLimitBytes;
+
+  explicit SharedImageDecodeCache(size_t limit_bytes);
+
+  // Returns an id for the pixel content of |image|. This is a hash of the
+  // encoded data when |image| has it, so that it matches across SkImages and
+  // processes. Otherwise, it is only valid for |image| in this process.
+  std::string GetContentId(const SkImage* image);
+
+  // Returns locked pixels for |key| if a consumer has inserted them and they
+  // have not been purged. Returns nullptr otherwise.
+  std::unique_ptr<Memory> LockEntry(const Key& key);
+
+  // Allocates |size| bytes of locked memory to decode into. Returns nullptr if
+  // the shared memory could not be created.
+  std::unique_ptr<Memory> AllocateLocked(size_t size);
+
+  // Makes the pixels in |memory|, which must come from AllocateLocked() and be
+  // fully written, available to LockEntry() for |key|. If another consumer
+  // already inserted pixels for |key|, those are kept and |memory| stays
+  // private to its owner. Unlocked entries are evicted in LRU order when the
+  // cache goes over budget.
+  void Insert(const Key& key, const Memory& memory);
+
+  // Evicts unlocked entries, in LRU order, until the cache uses at most a
+  // quarter of its budget. Consumers call this when they reduce their own
+  // cache usage.
+  void ReduceCacheUsage();
+
+  // Evicts all unlocked entries. The cache returned by GetInstance() is
+  // notified of memory pressure.
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level);
+
+  Stats GetStats() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<SharedImageDecodeCache>;
+  using SegmentMRUCache =
+      base::HashingMRUCache<Key, scoped_refptr<Segment>, KeyHash>;
+
+  ~SharedImageDecodeCache();
+
+  // The functions below must be called with |lock_| held.
+  bool LockSegment(Segment* segment);
+  void UnlockSegment(Segment* segment);
+  void EvictUnlockedEntries(size_t limit_bytes);
+
+  const size_t limit_bytes_;
+
+  // The members below can only be accessed with |lock_| held. This includes
+  // the lock state of every segment.
+  mutable base::Lock lock_;
+  SegmentMRUCache entries_;
+  base::MRUCache<uint32_t, std::string> content_ids_;
+  size_t bytes_;
+  size_t hits_;
+  size_t misses_;
+
+  // Used to uniquely identify segments for memory traces.
+  base::AtomicSequenceNumber next_segment_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedImageDecodeCache);
+};
+
+}  // namespace cc
+
+#endif  // CC_TILES_SHARED_IMAGE_DECODE_CACHE_H_
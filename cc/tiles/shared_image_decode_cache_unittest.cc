@@ -0,0 +1,197 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cc/tiles/shared_image_decode_cache.h"
+
+#include <string.h>
+
+#include "cc/playback/draw_image.h"
+#include "cc/tiles/software_image_decode_controller.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkRefCnt.h"
+
+namespace cc {
+namespace {
+
+const size_t kSegmentSize = 4096;
+
+sk_sp<SkImage> CreateImage(int width, int height) {
+  SkBitmap bitmap;
+  bitmap.allocPixels(SkImageInfo::MakeN32Premul(width, height));
+  return SkImage::MakeFromBitmap(bitmap);
+}
+
+SharedImageDecodeCache::Key CreateKey(const std::string& content_id,
+                                      float scale) {
+  sk_sp<SkImage> image = CreateImage(100, 100);
+  SkMatrix matrix;
+  matrix.setScale(scale, scale);
+  DrawImage draw_image(image, SkIRect::MakeWH(100, 100),
+                       kMedium_SkFilterQuality, matrix);
+  return SharedImageDecodeCache::Key::FromImageKey(
+      ImageDecodeControllerKey::FromDrawImage(draw_image), content_id,
+      RGBA_8888);
+}
+
+// Allocates a segment filled with |value| and inserts it for |key|.
+std::unique_ptr<SharedImageDecodeCache::Memory> InsertEntry(
+    SharedImageDecodeCache* cache,
+    const SharedImageDecodeCache::Key& key,
+    char value) {
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory =
+      cache->AllocateLocked(kSegmentSize);
+  EXPECT_TRUE(memory);
+  memset(memory->data(), value, kSegmentSize);
+  cache->Insert(key, *memory);
+  return memory;
+}
+
+TEST(SharedImageDecodeCacheTest, KeysAreIndependentOfImage) {
+  // The images are different, but their content ids are the same.
+  EXPECT_EQ(CreateKey("a", 0.5f), CreateKey("a", 0.5f));
+  EXPECT_EQ(CreateKey("a", 0.5f).get_hash(), CreateKey("a", 0.5f).get_hash());
+
+  EXPECT_NE(CreateKey("a", 0.5f), CreateKey("b", 0.5f));
+  EXPECT_NE(CreateKey("a", 0.5f), CreateKey("a", 0.25f));
+
+  sk_sp<SkImage> image = CreateImage(100, 100);
+  DrawImage draw_image(image, SkIRect::MakeWH(100, 100),
+                       kNone_SkFilterQuality, SkMatrix::I());
+  ImageDecodeControllerKey image_key =
+      ImageDecodeControllerKey::FromDrawImage(draw_image);
+  EXPECT_NE(
+      SharedImageDecodeCache::Key::FromImageKey(image_key, "a", RGBA_8888),
+      SharedImageDecodeCache::Key::FromImageKey(image_key, "a", RGBA_4444));
+}
+
+TEST(SharedImageDecodeCacheTest, ContentIdOfImage) {
+  scoped_refptr<SharedImageDecodeCache> cache(
+      new SharedImageDecodeCache(kSegmentSize));
+  sk_sp<SkImage> image = CreateImage(10, 10);
+  sk_sp<SkImage> other_image = CreateImage(10, 10);
+
+  std::string content_id = cache->GetContentId(image.get());
+  EXPECT_FALSE(content_id.empty());
+  EXPECT_EQ(content_id, cache->GetContentId(image.get()));
+  // Images without encoded data only match themselves.
+  EXPECT_NE(content_id, cache->GetContentId(other_image.get()));
+}
+
+TEST(SharedImageDecodeCacheTest, LockEntryReturnsInsertedPixels) {
+  scoped_refptr<SharedImageDecodeCache> cache(
+      new SharedImageDecodeCache(4 * kSegmentSize));
+  SharedImageDecodeCache::Key key = CreateKey("a", 0.5f);
+
+  EXPECT_FALSE(cache->LockEntry(key));
+  EXPECT_EQ(1u, cache->GetStats().misses);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory =
+      InsertEntry(cache.get(), key, 7);
+  EXPECT_EQ(1u, cache->GetStats().entries);
+  EXPECT_EQ(kSegmentSize, cache->GetStats().bytes);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> other_memory =
+      cache->LockEntry(key);
+  ASSERT_TRUE(other_memory);
+  EXPECT_EQ(1u, cache->GetStats().hits);
+  EXPECT_EQ(memory->data(), other_memory->data());
+  EXPECT_EQ(7, static_cast<char*>(other_memory->data())[kSegmentSize - 1]);
+
+  // The segment stays locked until every consumer unlocked it.
+  memory->Unlock();
+  EXPECT_EQ(7, static_cast<char*>(other_memory->data())[0]);
+  other_memory->Unlock();
+  EXPECT_TRUE(memory->Lock());
+  memory->Unlock();
+}
+
+TEST(SharedImageDecodeCacheTest, InsertKeepsExistingEntry) {
+  scoped_refptr<SharedImageDecodeCache> cache(
+      new SharedImageDecodeCache(4 * kSegmentSize));
+  SharedImageDecodeCache::Key key = CreateKey("a", 0.5f);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory =
+      InsertEntry(cache.get(), key, 1);
+  std::unique_ptr<SharedImageDecodeCache::Memory> other_memory =
+      InsertEntry(cache.get(), key, 2);
+  EXPECT_EQ(1u, cache->GetStats().entries);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> locked_memory =
+      cache->LockEntry(key);
+  ASSERT_TRUE(locked_memory);
+  EXPECT_EQ(memory->data(), locked_memory->data());
+  // The second decode is still usable by its owner.
+  EXPECT_EQ(2, static_cast<char*>(other_memory->data())[0]);
+}
+
+TEST(SharedImageDecodeCacheTest, EvictsUnlockedEntriesOverBudget) {
+  scoped_refptr<SharedImageDecodeCache> cache(
+      new SharedImageDecodeCache(2 * kSegmentSize));
+  SharedImageDecodeCache::Key key_a = CreateKey("a", 0.5f);
+  SharedImageDecodeCache::Key key_b = CreateKey("b", 0.5f);
+  SharedImageDecodeCache::Key key_c = CreateKey("c", 0.5f);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_a =
+      InsertEntry(cache.get(), key_a, 1);
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_b =
+      InsertEntry(cache.get(), key_b, 2);
+  memory_b->Unlock();
+
+  // |key_a| is the least recently used entry, but it is locked, so |key_b| is
+  // evicted instead.
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_c =
+      InsertEntry(cache.get(), key_c, 3);
+  EXPECT_EQ(2u, cache->GetStats().entries);
+  EXPECT_EQ(2 * kSegmentSize, cache->GetStats().bytes);
+  EXPECT_FALSE(cache->LockEntry(key_b));
+  EXPECT_FALSE(memory_b->Lock());
+
+  memory_a->Unlock();
+  memory_c->Unlock();
+  cache->ReduceCacheUsage();
+  EXPECT_EQ(0u, cache->GetStats().entries);
+  EXPECT_EQ(0u, cache->GetStats().bytes);
+  EXPECT_FALSE(cache->LockEntry(key_a));
+}
+
+TEST(SharedImageDecodeCacheTest, ReduceCacheUsageKeepsRecentEntries) {
+  scoped_refptr<SharedImageDecodeCache> cache(
+      new SharedImageDecodeCache(8 * kSegmentSize));
+  SharedImageDecodeCache::Key key_a = CreateKey("a", 0.5f);
+  SharedImageDecodeCache::Key key_b = CreateKey("b", 0.5f);
+  SharedImageDecodeCache::Key key_c = CreateKey("c", 0.5f);
+
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_a =
+      InsertEntry(cache.get(), key_a, 1);
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_b =
+      InsertEntry(cache.get(), key_b, 2);
+  std::unique_ptr<SharedImageDecodeCache::Memory> memory_c =
+      InsertEntry(cache.get(), key_c, 3);
+  memory_a->Unlock();
+  memory_b->Unlock();
+  memory_c->Unlock();
+
+  // The cache is reduced to a quarter of its budget, so only the most
+  // recently used entries are kept.
+  cache->ReduceCacheUsage();
+  EXPECT_EQ(2u, cache->GetStats().entries);
+  EXPECT_EQ(2 * kSegmentSize, cache->GetStats().bytes);
+  EXPECT_FALSE(memory_a->Lock());
+  EXPECT_TRUE(memory_b->Lock());
+  memory_b->Unlock();
+
+  // Memory pressure evicts every unlocked entry.
+  EXPECT_TRUE(memory_c->Lock());
+  cache->OnMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  EXPECT_EQ(1u, cache->GetStats().entries);
+  EXPECT_EQ(kSegmentSize, cache->GetStats().bytes);
+  EXPECT_FALSE(memory_b->Lock());
+  EXPECT_EQ(3, static_cast<char*>(memory_c->data())[0]);
+}
+
+}  // namespace
+}  // namespace cc
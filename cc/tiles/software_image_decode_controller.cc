@@ -143,10 +143,19 @@ void RecordLockExistingCachedImageHistogram(TilePriority::PriorityBin bin,
 SoftwareImageDecodeController::SoftwareImageDecodeController(
     ResourceFormat format,
     size_t locked_memory_limit_bytes)
+    : SoftwareImageDecodeController(format,
+                                    locked_memory_limit_bytes,
+                                    nullptr) {}
+
+SoftwareImageDecodeController::SoftwareImageDecodeController(
+    ResourceFormat format,
+    size_t locked_memory_limit_bytes,
+    scoped_refptr<SharedImageDecodeCache> shared_cache)
     : decoded_images_(ImageMRUCache::NO_AUTO_EVICT),
       at_raster_decoded_images_(ImageMRUCache::NO_AUTO_EVICT),
       locked_images_budget_(locked_memory_limit_bytes),
-      format_(format) {
+      format_(format),
+      shared_cache_(std::move(shared_cache)) {
   // In certain cases, ThreadTaskRunnerHandle isn't set (Android Webview).
   // Don't register a dump provider in these cases.
   if (base::ThreadTaskRunnerHandle::IsSet()) {
@@ -494,15 +503,24 @@ SoftwareImageDecodeController::GetOriginalImageDecode(
     sk_sp<const SkImage> image) {
   SkImageInfo decoded_info =
       CreateImageInfo(image->width(), image->height(), format_);
+  SharedImageDecodeCache::Key shared_key;
+  if (shared_cache_) {
+    shared_key = SharedImageDecodeCache::Key::FromImageKey(
+        key, shared_cache_->GetContentId(image.get()), format_);
+    std::unique_ptr<DecodedImage> shared_decode =
+        LockSharedImageDecode(shared_key, decoded_info, SkSize::Make(0, 0));
+    if (shared_decode)
+      return shared_decode;
+  }
+
   std::unique_ptr<base::DiscardableMemory> decoded_pixels;
+  SharedImageDecodeCache::Memory* shared_memory = nullptr;
   {
     TRACE_EVENT0("disabled-by-default-cc.debug",
                  "SoftwareImageDecodeController::GetOriginalImageDecode - "
                  "allocate decoded pixels");
-    decoded_pixels =
-        base::DiscardableMemoryAllocator::GetInstance()
-            ->AllocateLockedDiscardableMemory(decoded_info.minRowBytes() *
-                                              decoded_info.height());
+    decoded_pixels = AllocateDecodedPixels(
+        decoded_info.minRowBytes() * decoded_info.height(), &shared_memory);
   }
   {
     TRACE_EVENT0("disabled-by-default-cc.debug",
@@ -517,6 +535,8 @@ SoftwareImageDecodeController::GetOriginalImageDecode(
       return nullptr;
     }
   }
+  if (shared_memory)
+    shared_cache_->Insert(shared_key, *shared_memory);
   return base::WrapUnique(
       new DecodedImage(decoded_info, std::move(decoded_pixels),
                        SkSize::Make(0, 0), next_tracing_id_.GetNext()));
@@ -526,6 +546,24 @@ std::unique_ptr<SoftwareImageDecodeController::DecodedImage>
 SoftwareImageDecodeController::GetScaledImageDecode(
     const ImageKey& key,
     sk_sp<const SkImage> image) {
+  DCHECK(!key.target_size().IsEmpty());
+  SkImageInfo scaled_info = CreateImageInfo(
+      key.target_size().width(), key.target_size().height(), format_);
+  SkSize src_rect_offset =
+      SkSize::Make(-key.src_rect().x(), -key.src_rect().y());
+
+  // If another consumer of the shared cache already scaled this image, we
+  // don't need the original decode at all.
+  SharedImageDecodeCache::Key shared_key;
+  if (shared_cache_) {
+    shared_key = SharedImageDecodeCache::Key::FromImageKey(
+        key, shared_cache_->GetContentId(image.get()), format_);
+    std::unique_ptr<DecodedImage> shared_decode =
+        LockSharedImageDecode(shared_key, scaled_info, src_rect_offset);
+    if (shared_decode)
+      return shared_decode;
+  }
+
   // Construct a key to use in GetDecodedImageForDrawInternal().
   // This allows us to reuse an image in any cache if available.
   gfx::Rect full_image_rect(image->width(), image->height());
@@ -555,17 +593,14 @@ SoftwareImageDecodeController::GetScaledImageDecode(
     DCHECK(result) << key.ToString();
   }
 
-  DCHECK(!key.target_size().IsEmpty());
-  SkImageInfo scaled_info = CreateImageInfo(
-      key.target_size().width(), key.target_size().height(), format_);
   std::unique_ptr<base::DiscardableMemory> scaled_pixels;
+  SharedImageDecodeCache::Memory* shared_memory = nullptr;
   {
     TRACE_EVENT0(
         "disabled-by-default-cc.debug",
         "SoftwareImageDecodeController::ScaleImage - allocate scaled pixels");
-    scaled_pixels = base::DiscardableMemoryAllocator::GetInstance()
-                        ->AllocateLockedDiscardableMemory(
-                            scaled_info.minRowBytes() * scaled_info.height());
+    scaled_pixels = AllocateDecodedPixels(
+        scaled_info.minRowBytes() * scaled_info.height(), &shared_memory);
   }
   SkPixmap scaled_pixmap(scaled_info, scaled_pixels->data(),
                          scaled_info.minRowBytes());
@@ -584,10 +619,47 @@ SoftwareImageDecodeController::GetScaledImageDecode(
   // deleted automatically when we return.
   DrawWithImageFinished(original_size_draw_image, decoded_draw_image);
 
-  return base::WrapUnique(
-      new DecodedImage(scaled_info, std::move(scaled_pixels),
-                       SkSize::Make(-key.src_rect().x(), -key.src_rect().y()),
-                       next_tracing_id_.GetNext()));
+  if (shared_memory)
+    shared_cache_->Insert(shared_key, *shared_memory);
+  return base::WrapUnique(new DecodedImage(scaled_info,
+                                           std::move(scaled_pixels),
+                                           src_rect_offset,
+                                           next_tracing_id_.GetNext()));
+}
+
+std::unique_ptr<SoftwareImageDecodeController::DecodedImage>
+SoftwareImageDecodeController::LockSharedImageDecode(
+    const SharedImageDecodeCache::Key& shared_key,
+    const SkImageInfo& info,
+    const SkSize& src_rect_offset) {
+  TRACE_EVENT0("disabled-by-default-cc.debug",
+               "SoftwareImageDecodeController::LockSharedImageDecode");
+  std::unique_ptr<base::DiscardableMemory> pixels =
+      shared_cache_->LockEntry(shared_key);
+  if (!pixels)
+    return nullptr;
+  return base::WrapUnique(new DecodedImage(info, std::move(pixels),
+                                           src_rect_offset,
+                                           next_tracing_id_.GetNext()));
+}
+
+std::unique_ptr<base::DiscardableMemory>
+SoftwareImageDecodeController::AllocateDecodedPixels(
+    size_t size,
+    SharedImageDecodeCache::Memory** shared_memory) {
+  *shared_memory = nullptr;
+  if (shared_cache_) {
+    std::unique_ptr<SharedImageDecodeCache::Memory> memory =
+        shared_cache_->AllocateLocked(size);
+    // If the shared memory could not be created, fall back to decoding into
+    // memory of our own.
+    if (memory) {
+      *shared_memory = memory.get();
+      return std::move(memory);
+    }
+  }
+  return base::DiscardableMemoryAllocator::GetInstance()
+      ->AllocateLockedDiscardableMemory(size);
 }
 
 void SoftwareImageDecodeController::DrawWithImageFinished(
@@ -666,6 +738,9 @@ void SoftwareImageDecodeController::UnrefAtRasterImage(const ImageKey& key) {
 
 void SoftwareImageDecodeController::ReduceCacheUsage() {
   TRACE_EVENT0("cc", "SoftwareImageDecodeController::ReduceCacheUsage");
+  if (shared_cache_)
+    shared_cache_->ReduceCacheUsage();
+
   base::AutoLock lock(lock_);
   size_t num_to_remove = (decoded_images_.size() > kMaxItemsInCache)
                              ? (decoded_images_.size() - kMaxItemsInCache)
@@ -24,6 +24,7 @@
 #include "cc/playback/draw_image.h"
 #include "cc/resources/resource_format.h"
 #include "cc/tiles/image_decode_controller.h"
+#include "cc/tiles/shared_image_decode_cache.h"
 #include "third_party/skia/include/core/SkRefCnt.h"
 
 namespace cc {
@@ -105,6 +106,12 @@ class CC_EXPORT SoftwareImageDecodeController
 
   SoftwareImageDecodeController(ResourceFormat format,
                                 size_t locked_memory_limit_bytes);
+  // If |shared_cache| is not null, decodes are looked up in it before being
+  // done here, and decodes done here are added to it.
+  SoftwareImageDecodeController(
+      ResourceFormat format,
+      size_t locked_memory_limit_bytes,
+      scoped_refptr<SharedImageDecodeCache> shared_cache);
   ~SoftwareImageDecodeController() override;
 
   // ImageDecodeController overrides.
@@ -241,6 +248,20 @@ class CC_EXPORT SoftwareImageDecodeController
       const ImageKey& key,
       sk_sp<const SkImage> image);
 
+  // Returns a DecodedImage for pixels of |key| that another consumer of
+  // |shared_cache_| already decoded, or nullptr if there are none.
+  std::unique_ptr<DecodedImage> LockSharedImageDecode(
+      const SharedImageDecodeCache::Key& shared_key,
+      const SkImageInfo& info,
+      const SkSize& src_rect_offset);
+
+  // Allocates locked memory to decode into. When |shared_cache_| is used, the
+  // memory comes from it and |*shared_memory| is set so that the decode can be
+  // inserted into the shared cache once the pixels are written.
+  std::unique_ptr<base::DiscardableMemory> AllocateDecodedPixels(
+      size_t size,
+      SharedImageDecodeCache::Memory** shared_memory);
+
   void SanityCheckState(int line, bool lock_acquired);
   void RefImage(const ImageKey& key);
   void RefAtRasterImage(const ImageKey& key);
@@ -271,6 +292,8 @@ class CC_EXPORT SoftwareImageDecodeController
 
   ResourceFormat format_;
 
+  scoped_refptr<SharedImageDecodeCache> shared_cache_;
+
   // Used to uniquely identify DecodedImages for memory traces.
   base::AtomicSequenceNumber next_tracing_id_;
 };
@@ -0,0 +1,121 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "cc/debug/lap_timer.h"
+#include "cc/playback/draw_image.h"
+#include "cc/resources/resource_format.h"
+#include "cc/tiles/shared_image_decode_cache.h"
+#include "cc/tiles/software_image_decode_controller.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkImage.h"
+
+namespace cc {
+namespace {
+
+static const int kTimeLimitMillis = 2000;
+static const int kWarmupRuns = 5;
+static const int kTimeCheckInterval = 10;
+
+static const size_t kLockedMemoryLimitBytes = 128 * 1024 * 1024;
+static const int kNumCompositors = 10;
+static const int kNumImages = 20;
+static const int kImageSize = 512;
+
+class SoftwareImageDecodeControllerPerfTest : public testing::Test {
+ public:
+  SoftwareImageDecodeControllerPerfTest()
+      : timer_(kWarmupRuns,
+               base::TimeDelta::FromMilliseconds(kTimeLimitMillis),
+               kTimeCheckInterval) {}
+
+ protected:
+  // Creates images that are drawn at half size with medium quality, so every
+  // draw needs both a decode and a scale, like a sprite or a logo.
+  std::vector<DrawImage> CreateDrawImages() {
+    SkMatrix matrix;
+    matrix.setScale(0.5f, 0.5f);
+    std::vector<DrawImage> draw_images;
+    for (int i = 0; i < kNumImages; ++i) {
+      SkBitmap bitmap;
+      bitmap.allocPixels(SkImageInfo::MakeN32Premul(kImageSize, kImageSize));
+      bitmap.eraseARGB(255, i * 10, 255 - i * 10, 128);
+      sk_sp<SkImage> image = SkImage::MakeFromBitmap(bitmap);
+      draw_images.push_back(DrawImage(image,
+                                      SkIRect::MakeWH(kImageSize, kImageSize),
+                                      kMedium_SkFilterQuality, matrix));
+    }
+    return draw_images;
+  }
+
+  // Measures |kNumCompositors| compositors each rastering the same images
+  // once. Each lap starts with empty caches, so it includes all of the decode
+  // and scale work for one frame of content shown in every compositor.
+  void RunFrameTest(const std::string& test_name, bool use_shared_cache) {
+    std::vector<DrawImage> draw_images = CreateDrawImages();
+
+    size_t decoded_bytes = 0;
+    timer_.Reset();
+    do {
+      scoped_refptr<SharedImageDecodeCache> shared_cache;
+      if (use_shared_cache)
+        shared_cache = new SharedImageDecodeCache(kLockedMemoryLimitBytes);
+
+      std::vector<std::unique_ptr<SoftwareImageDecodeController>> controllers;
+      for (int i = 0; i < kNumCompositors; ++i) {
+        controllers.push_back(
+            base::WrapUnique(new SoftwareImageDecodeController(
+                ResourceFormat::RGBA_8888, kLockedMemoryLimitBytes,
+                shared_cache)));
+      }
+
+      for (const auto& controller : controllers) {
+        for (const DrawImage& draw_image : draw_images) {
+          DecodedDrawImage decoded_image =
+              controller->GetDecodedImageForDraw(draw_image);
+          controller->DrawWithImageFinished(draw_image, decoded_image);
+        }
+      }
+
+      decoded_bytes = use_shared_cache ? shared_cache->GetStats().bytes
+                                       : PrivateDecodedBytes(draw_images);
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    perf_test::PrintResult("software_image_decode_frame", "", test_name,
+                           timer_.MsPerLap(), "ms", true);
+    perf_test::PrintResult("software_image_decode_memory", "", test_name,
+                           decoded_bytes, "bytes", true);
+  }
+
+  // Without a shared cache, every compositor keeps its own original decode
+  // and scaled decode of each image.
+  size_t PrivateDecodedBytes(const std::vector<DrawImage>& draw_images) {
+    size_t bytes = 0;
+    for (const DrawImage& draw_image : draw_images) {
+      bytes += ImageDecodeControllerKey::FromDrawImage(draw_image)
+                   .locked_bytes();
+      bytes += 4u * draw_image.image()->width() * draw_image.image()->height();
+    }
+    return bytes * kNumCompositors;
+  }
+
+  LapTimer timer_;
+};
+
+TEST_F(SoftwareImageDecodeControllerPerfTest, TenCompositorsSameContent) {
+  RunFrameTest("10_compositors_private_caches", false);
+  RunFrameTest("10_compositors_shared_cache", true);
+}
+
+}  // namespace
+}  // namespace cc
@@ -7,7 +7,9 @@
 #include "cc/playback/draw_image.h"
 #include "cc/resources/resource_format.h"
 #include "cc/test/test_tile_task_runner.h"
+#include "cc/tiles/shared_image_decode_cache.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkPixmap.h"
 #include "third_party/skia/include/core/SkRefCnt.h"
 
 namespace cc {
@@ -1431,5 +1433,93 @@ TEST(SoftwareImageDecodeControllerTest,
   controller.UnrefImage(draw_image_49);
 }
 
+TEST(SoftwareImageDecodeControllerTest, SharedCacheReusesOtherDecodes) {
+  scoped_refptr<SharedImageDecodeCache> shared_cache(
+      new SharedImageDecodeCache(kLockedMemoryLimitBytes));
+  SoftwareImageDecodeController controller(
+      ResourceFormat::RGBA_8888, kLockedMemoryLimitBytes, shared_cache);
+  SoftwareImageDecodeController other_controller(
+      ResourceFormat::RGBA_8888, kLockedMemoryLimitBytes, shared_cache);
+  bool is_decomposable = true;
+  SkFilterQuality quality = kHigh_SkFilterQuality;
+
+  sk_sp<SkImage> image = CreateImage(100, 100);
+  DrawImage draw_image(image, SkIRect::MakeWH(image->width(), image->height()),
+                       quality,
+                       CreateMatrix(SkSize::Make(0.5f, 0.5f), is_decomposable));
+
+  scoped_refptr<TileTask> task;
+  bool need_unref = controller.GetTaskForImageAndRef(
+      draw_image, ImageDecodeController::TracingInfo(), &task);
+  EXPECT_TRUE(need_unref);
+  EXPECT_TRUE(task);
+  TestTileTaskRunner::ProcessTask(task.get());
+
+  // The original and the scaled decode were both added to the shared cache.
+  SharedImageDecodeCache::Stats stats = shared_cache->GetStats();
+  EXPECT_EQ(2u, stats.entries);
+
+  scoped_refptr<TileTask> other_task;
+  need_unref = other_controller.GetTaskForImageAndRef(
+      draw_image, ImageDecodeController::TracingInfo(), &other_task);
+  EXPECT_TRUE(need_unref);
+  EXPECT_TRUE(other_task);
+  TestTileTaskRunner::ProcessTask(other_task.get());
+
+  // The other controller found the scaled decode and didn't decode again.
+  EXPECT_EQ(stats.hits + 1, shared_cache->GetStats().hits);
+  EXPECT_EQ(2u, shared_cache->GetStats().entries);
+
+  DecodedDrawImage decoded_draw_image =
+      controller.GetDecodedImageForDraw(draw_image);
+  DecodedDrawImage other_decoded_draw_image =
+      other_controller.GetDecodedImageForDraw(draw_image);
+  ASSERT_TRUE(decoded_draw_image.image());
+  ASSERT_TRUE(other_decoded_draw_image.image());
+  EXPECT_FALSE(decoded_draw_image.is_at_raster_decode());
+  EXPECT_FALSE(other_decoded_draw_image.is_at_raster_decode());
+  EXPECT_EQ(50, other_decoded_draw_image.image()->width());
+  EXPECT_EQ(50, other_decoded_draw_image.image()->height());
+
+  SkPixmap pixmap;
+  SkPixmap other_pixmap;
+  ASSERT_TRUE(decoded_draw_image.image()->peekPixels(&pixmap));
+  ASSERT_TRUE(other_decoded_draw_image.image()->peekPixels(&other_pixmap));
+  EXPECT_EQ(pixmap.addr(), other_pixmap.addr());
+
+  controller.DrawWithImageFinished(draw_image, decoded_draw_image);
+  controller.UnrefImage(draw_image);
+  other_controller.DrawWithImageFinished(draw_image, other_decoded_draw_image);
+  other_controller.UnrefImage(draw_image);
+}
+
+TEST(SoftwareImageDecodeControllerTest, SharedCacheKeepsFormatsApart) {
+  scoped_refptr<SharedImageDecodeCache> shared_cache(
+      new SharedImageDecodeCache(kLockedMemoryLimitBytes));
+  SoftwareImageDecodeController controller(
+      ResourceFormat::RGBA_8888, kLockedMemoryLimitBytes, shared_cache);
+  SoftwareImageDecodeController other_controller(
+      ResourceFormat::RGBA_4444, kLockedMemoryLimitBytes, shared_cache);
+  bool is_decomposable = true;
+  SkFilterQuality quality = kLow_SkFilterQuality;
+
+  sk_sp<SkImage> image = CreateImage(100, 100);
+  DrawImage draw_image(image, SkIRect::MakeWH(image->width(), image->height()),
+                       quality,
+                       CreateMatrix(SkSize::Make(1.f, 1.f), is_decomposable));
+
+  DecodedDrawImage decoded_draw_image =
+      controller.GetDecodedImageForDraw(draw_image);
+  DecodedDrawImage other_decoded_draw_image =
+      other_controller.GetDecodedImageForDraw(draw_image);
+  EXPECT_TRUE(decoded_draw_image.image());
+  EXPECT_TRUE(other_decoded_draw_image.image());
+  EXPECT_EQ(0u, shared_cache->GetStats().hits);
+  EXPECT_EQ(2u, shared_cache->GetStats().entries);
+
+  controller.DrawWithImageFinished(draw_image, decoded_draw_image);
+  other_controller.DrawWithImageFinished(draw_image, other_decoded_draw_image);
+}
+
 }  // namespace
 }  // namespace cc
@@ -8,6 +8,7 @@
 
 #include <vector>
 
+#include "base/atomic_sequence_num.h"
 #include "cc/base/math_util.h"
 #include "cc/layers/draw_properties.h"
 #include "cc/layers/layer.h"
@@ -24,6 +25,10 @@ namespace draw_property_utils {
 
 namespace {
 
+// Numbers the passes that compute visible rects. This is global so that the
+// ids stay unique when property trees are copied between layer trees.
+base::StaticAtomicSequenceNumber g_next_visible_rects_pass_id;
+
 static bool IsRootLayer(const Layer* layer) {
   return !layer->parent();
 }
@@ -642,154 +647,214 @@ static void ResetIfHasNanCoordinate(gfx::RectF* rect) {
     *rect = gfx::RectF();
 }
 
-void ComputeClips(ClipTree* clip_tree,
-                  const TransformTree& transform_tree,
-                  bool non_root_surfaces_enabled) {
-  if (!clip_tree->needs_update())
-    return;
-  for (int i = 1; i < static_cast<int>(clip_tree->size()); ++i) {
-    ClipNode* clip_node = clip_tree->Node(i);
+static void ComputeClip(ClipTree* clip_tree,
+                        int id,
+                        const TransformTree& transform_tree,
+                        bool non_root_surfaces_enabled) {
+  ClipNode* clip_node = clip_tree->Node(id);
 
-    if (clip_node->id == 1) {
-      ResetIfHasNanCoordinate(&clip_node->data.clip);
-      clip_node->data.clip_in_target_space = clip_node->data.clip;
-      clip_node->data.combined_clip_in_target_space = clip_node->data.clip;
-      continue;
-    }
-    const TransformNode* transform_node =
-        transform_tree.Node(clip_node->data.transform_id);
-    ClipNode* parent_clip_node = clip_tree->parent(clip_node);
-
-    gfx::Transform parent_to_current;
-    const TransformNode* parent_target_transform_node =
-        transform_tree.Node(parent_clip_node->data.target_id);
-    bool success = true;
-
-    // Clips must be combined in target space. We cannot, for example, combine
-    // clips in the space of the child clip. The reason is non-affine
-    // transforms. Say we have the following tree T->A->B->C, and B clips C, but
-    // draw into target T. It may be the case that A applies a perspective
-    // transform, and B and C are at different z positions. When projected into
-    // target space, the relative sizes and positions of B and C can shift.
-    // Since it's the relationship in target space that matters, that's where we
-    // must combine clips. For each clip node, we save the clip rects in its
-    // target space. So, we need to get the ancestor clip rect in the current
-    // clip node's target space.
-    gfx::RectF parent_combined_clip_in_target_space =
-        parent_clip_node->data.combined_clip_in_target_space;
-    gfx::RectF parent_clip_in_target_space =
-        parent_clip_node->data.clip_in_target_space;
-    if (parent_target_transform_node &&
-        parent_target_transform_node->id != clip_node->data.target_id &&
-        non_root_surfaces_enabled) {
-      success &= transform_tree.ComputeTransformWithDestinationSublayerScale(
-          parent_target_transform_node->id, clip_node->data.target_id,
-          &parent_to_current);
-      if (parent_target_transform_node->data.sublayer_scale.x() > 0 &&
-          parent_target_transform_node->data.sublayer_scale.y() > 0)
-        parent_to_current.Scale(
-            1.f / parent_target_transform_node->data.sublayer_scale.x(),
-            1.f / parent_target_transform_node->data.sublayer_scale.y());
-      // If we can't compute a transform, it's because we had to use the inverse
-      // of a singular transform. We won't draw in this case, so there's no need
-      // to compute clips.
-      if (!success)
-        continue;
-      parent_combined_clip_in_target_space = MathUtil::ProjectClippedRect(
-          parent_to_current,
-          parent_clip_node->data.combined_clip_in_target_space);
-      parent_clip_in_target_space = MathUtil::ProjectClippedRect(
-          parent_to_current, parent_clip_node->data.clip_in_target_space);
-    }
-    // Only nodes affected by ancestor clips will have their clip adjusted due
-    // to intersecting with an ancestor clip. But, we still need to propagate
-    // the combined clip to our children because if they are clipped, they may
-    // need to clip using our parent clip and if we don't propagate it here,
-    // it will be lost.
-    if (clip_node->data.resets_clip && non_root_surfaces_enabled) {
-      if (clip_node->data.applies_local_clip) {
-        clip_node->data.clip_in_target_space = MathUtil::MapClippedRect(
-            transform_tree.ToTarget(clip_node->data.transform_id),
-            clip_node->data.clip);
-        ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
-        clip_node->data.combined_clip_in_target_space =
-            gfx::IntersectRects(clip_node->data.clip_in_target_space,
-                                parent_combined_clip_in_target_space);
-      } else {
-        DCHECK(!clip_node->data.target_is_clipped);
-        DCHECK(!clip_node->data.layers_are_clipped);
-        clip_node->data.combined_clip_in_target_space =
-            parent_combined_clip_in_target_space;
-      }
-      ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
-      continue;
-    }
-    bool use_only_parent_clip = !clip_node->data.applies_local_clip;
-    if (use_only_parent_clip) {
+  if (clip_node->id == 1) {
+    ResetIfHasNanCoordinate(&clip_node->data.clip);
+    clip_node->data.clip_in_target_space = clip_node->data.clip;
+    clip_node->data.combined_clip_in_target_space = clip_node->data.clip;
+    return;
+  }
+  const TransformNode* transform_node =
+      transform_tree.Node(clip_node->data.transform_id);
+  ClipNode* parent_clip_node = clip_tree->parent(clip_node);
+
+  gfx::Transform parent_to_current;
+  const TransformNode* parent_target_transform_node =
+      transform_tree.Node(parent_clip_node->data.target_id);
+  bool success = true;
+
+  // Clips must be combined in target space. We cannot, for example, combine
+  // clips in the space of the child clip. The reason is non-affine
+  // transforms. Say we have the following tree T->A->B->C, and B clips C, but
+  // draw into target T. It may be the case that A applies a perspective
+  // transform, and B and C are at different z positions. When projected into
+  // target space, the relative sizes and positions of B and C can shift.
+  // Since it's the relationship in target space that matters, that's where we
+  // must combine clips. For each clip node, we save the clip rects in its
+  // target space. So, we need to get the ancestor clip rect in the current
+  // clip node's target space.
+  gfx::RectF parent_combined_clip_in_target_space =
+      parent_clip_node->data.combined_clip_in_target_space;
+  gfx::RectF parent_clip_in_target_space =
+      parent_clip_node->data.clip_in_target_space;
+  if (parent_target_transform_node &&
+      parent_target_transform_node->id != clip_node->data.target_id &&
+      non_root_surfaces_enabled) {
+    success &= transform_tree.ComputeTransformWithDestinationSublayerScale(
+        parent_target_transform_node->id, clip_node->data.target_id,
+        &parent_to_current);
+    if (parent_target_transform_node->data.sublayer_scale.x() > 0 &&
+        parent_target_transform_node->data.sublayer_scale.y() > 0)
+      parent_to_current.Scale(
+          1.f / parent_target_transform_node->data.sublayer_scale.x(),
+          1.f / parent_target_transform_node->data.sublayer_scale.y());
+    // If we can't compute a transform, it's because we had to use the inverse
+    // of a singular transform. We won't draw in this case, so there's no need
+    // to compute clips.
+    if (!success)
+      return;
+    parent_combined_clip_in_target_space = MathUtil::ProjectClippedRect(
+        parent_to_current,
+        parent_clip_node->data.combined_clip_in_target_space);
+    parent_clip_in_target_space = MathUtil::ProjectClippedRect(
+        parent_to_current, parent_clip_node->data.clip_in_target_space);
+  }
+  // Only nodes affected by ancestor clips will have their clip adjusted due
+  // to intersecting with an ancestor clip. But, we still need to propagate
+  // the combined clip to our children because if they are clipped, they may
+  // need to clip using our parent clip and if we don't propagate it here,
+  // it will be lost.
+  if (clip_node->data.resets_clip && non_root_surfaces_enabled) {
+    if (clip_node->data.applies_local_clip) {
+      clip_node->data.clip_in_target_space = MathUtil::MapClippedRect(
+          transform_tree.ToTarget(clip_node->data.transform_id),
+          clip_node->data.clip);
+      ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
+      clip_node->data.combined_clip_in_target_space =
+          gfx::IntersectRects(clip_node->data.clip_in_target_space,
+                              parent_combined_clip_in_target_space);
+    } else {
+      DCHECK(!clip_node->data.target_is_clipped);
+      DCHECK(!clip_node->data.layers_are_clipped);
       clip_node->data.combined_clip_in_target_space =
           parent_combined_clip_in_target_space;
-      if (!non_root_surfaces_enabled) {
-        clip_node->data.clip_in_target_space =
-            parent_clip_node->data.clip_in_target_space;
-      } else if (!clip_node->data.target_is_clipped) {
-        clip_node->data.clip_in_target_space = parent_clip_in_target_space;
-      } else {
-        // Render Surface applies clip and the owning layer itself applies
-        // no clip. So, clip_in_target_space is not used and hence we can set
-        // it to an empty rect.
-        clip_node->data.clip_in_target_space = gfx::RectF();
-      }
+    }
+    ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+    return;
+  }
+  bool use_only_parent_clip = !clip_node->data.applies_local_clip;
+  if (use_only_parent_clip) {
+    clip_node->data.combined_clip_in_target_space =
+        parent_combined_clip_in_target_space;
+    if (!non_root_surfaces_enabled) {
+      clip_node->data.clip_in_target_space =
+          parent_clip_node->data.clip_in_target_space;
+    } else if (!clip_node->data.target_is_clipped) {
+      clip_node->data.clip_in_target_space = parent_clip_in_target_space;
     } else {
-      gfx::Transform source_to_target;
-
-      if (!non_root_surfaces_enabled) {
-        source_to_target =
-            transform_tree.ToScreen(clip_node->data.transform_id);
-      } else if (transform_tree.ContentTargetId(transform_node->id) ==
-                 clip_node->data.target_id) {
-        source_to_target =
-            transform_tree.ToTarget(clip_node->data.transform_id);
-      } else {
-        success = transform_tree.ComputeTransformWithDestinationSublayerScale(
-            transform_node->id, clip_node->data.target_id, &source_to_target);
-        // source_to_target computation should be successful as target is an
-        // ancestor of the transform node.
-        DCHECK(success);
-      }
+      // Render Surface applies clip and the owning layer itself applies
+      // no clip. So, clip_in_target_space is not used and hence we can set
+      // it to an empty rect.
+      clip_node->data.clip_in_target_space = gfx::RectF();
+    }
+  } else {
+    gfx::Transform source_to_target;
 
-      gfx::RectF source_clip_in_target_space =
-          MathUtil::MapClippedRect(source_to_target, clip_node->data.clip);
-
-      // With surfaces disabled, the only case where we use only the local clip
-      // for layer clipping is the case where no non-viewport ancestor node
-      // applies a local clip.
-      bool layer_clipping_uses_only_local_clip =
-          non_root_surfaces_enabled
-              ? clip_node->data.layer_clipping_uses_only_local_clip
-              : !parent_clip_node->data
-                     .layers_are_clipped_when_surfaces_disabled;
-      if (!layer_clipping_uses_only_local_clip) {
-        clip_node->data.clip_in_target_space = gfx::IntersectRects(
-            parent_clip_in_target_space, source_clip_in_target_space);
-      } else {
-        clip_node->data.clip_in_target_space = source_clip_in_target_space;
-      }
+    if (!non_root_surfaces_enabled) {
+      source_to_target = transform_tree.ToScreen(clip_node->data.transform_id);
+    } else if (transform_tree.ContentTargetId(transform_node->id) ==
+               clip_node->data.target_id) {
+      source_to_target = transform_tree.ToTarget(clip_node->data.transform_id);
+    } else {
+      success = transform_tree.ComputeTransformWithDestinationSublayerScale(
+          transform_node->id, clip_node->data.target_id, &source_to_target);
+      // source_to_target computation should be successful as target is an
+      // ancestor of the transform node.
+      DCHECK(success);
+    }
 
-      clip_node->data.combined_clip_in_target_space = gfx::IntersectRects(
-          parent_combined_clip_in_target_space, source_clip_in_target_space);
+    gfx::RectF source_clip_in_target_space =
+        MathUtil::MapClippedRect(source_to_target, clip_node->data.clip);
+
+    // With surfaces disabled, the only case where we use only the local clip
+    // for layer clipping is the case where no non-viewport ancestor node
+    // applies a local clip.
+    bool layer_clipping_uses_only_local_clip =
+        non_root_surfaces_enabled
+            ? clip_node->data.layer_clipping_uses_only_local_clip
+            : !parent_clip_node->data
+                   .layers_are_clipped_when_surfaces_disabled;
+    if (!layer_clipping_uses_only_local_clip) {
+      clip_node->data.clip_in_target_space = gfx::IntersectRects(
+          parent_clip_in_target_space, source_clip_in_target_space);
+    } else {
+      clip_node->data.clip_in_target_space = source_clip_in_target_space;
     }
-    ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
-    ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+
+    clip_node->data.combined_clip_in_target_space = gfx::IntersectRects(
+        parent_combined_clip_in_target_space, source_clip_in_target_space);
   }
-  clip_tree->set_needs_update(false);
+  ResetIfHasNanCoordinate(&clip_node->data.clip_in_target_space);
+  ResetIfHasNanCoordinate(&clip_node->data.combined_clip_in_target_space);
+}
+
+// A clip node's clip rects depend on its parent clip node and on the transform
+// nodes of its own and its parent's targets.
+static bool ClipNodeNeedsUpdate(const ClipTree& clip_tree,
+                                const ClipNode* clip_node,
+                                const TransformTree& transform_tree) {
+  if (clip_tree.NodeNeedsUpdate(clip_node->id))
+    return true;
+  if (clip_node->id == 1)
+    return false;
+  const ClipNode* parent_clip_node = clip_tree.parent(clip_node);
+  return clip_tree.NodeWasUpdated(parent_clip_node->id) ||
+         transform_tree.NodeWasUpdated(clip_node->data.transform_id) ||
+         transform_tree.NodeWasUpdated(clip_node->data.target_id) ||
+         transform_tree.NodeWasUpdated(parent_clip_node->data.target_id);
+}
+
+void ComputeClips(ClipTree* clip_tree,
+                  const TransformTree& transform_tree,
+                  bool non_root_surfaces_enabled) {
+  if (!clip_tree->CanUpdatePartially() ||
+      !transform_tree.last_update_was_partial()) {
+    clip_tree->BeginUpdate(false);
+    for (int i = 1; i < static_cast<int>(clip_tree->size()); ++i)
+      ComputeClip(clip_tree, i, transform_tree, non_root_surfaces_enabled);
+    clip_tree->EndUpdate();
+    return;
+  }
+
+  // Transform changes can affect clip nodes anywhere in the tree, so every
+  // node is checked, but only the affected ones are recomputed.
+  clip_tree->BeginUpdate(true);
+  for (int i = 1; i < static_cast<int>(clip_tree->size()); ++i) {
+    if (!ClipNodeNeedsUpdate(*clip_tree, clip_tree->Node(i), transform_tree))
+      continue;
+    ComputeClip(clip_tree, i, transform_tree, non_root_surfaces_enabled);
+    clip_tree->SetNodeUpdated(i);
+  }
+  clip_tree->EndUpdate();
+}
+
+// A transform node depends on its ancestors and, for fixed-position nodes, on
+// its source node, which always has a smaller id.
+static bool TransformNodeNeedsUpdate(const TransformTree& transform_tree,
+                                     const TransformNode* node) {
+  return transform_tree.NodeNeedsUpdate(node->id) ||
+         transform_tree.NodeWasUpdated(node->parent_id) ||
+         (node->data.source_node_id != node->parent_id &&
+          transform_tree.NodeWasUpdated(node->data.source_node_id));
 }
 
 void ComputeTransforms(TransformTree* transform_tree) {
-  if (!transform_tree->needs_update())
+  if (!transform_tree->CanUpdatePartially()) {
+    transform_tree->BeginUpdate(false);
+    for (int i = 1; i < static_cast<int>(transform_tree->size()); ++i)
+      transform_tree->UpdateTransforms(i);
+    transform_tree->EndUpdate();
     return;
-  for (int i = 1; i < static_cast<int>(transform_tree->size()); ++i)
-    transform_tree->UpdateTransforms(i);
-  transform_tree->set_needs_update(false);
+  }
+
+  // Only the subtrees of the changed nodes are updated. Since parents come
+  // before their children, nothing before the first changed node is affected.
+  transform_tree->BeginUpdate(true);
+  int first_id = transform_tree->first_node_needing_update();
+  if (first_id != -1) {
+    for (int i = first_id; i < static_cast<int>(transform_tree->size()); ++i) {
+      if (!TransformNodeNeedsUpdate(*transform_tree, transform_tree->Node(i)))
+        continue;
+      transform_tree->UpdateTransforms(i);
+      transform_tree->SetNodeUpdated(i);
+    }
+  }
+  transform_tree->EndUpdate();
 }
 
 void UpdateRenderTarget(EffectTree* effect_tree,
@@ -809,12 +874,39 @@ void UpdateRenderTarget(EffectTree* effect_tree,
   }
 }
 
+// An effect node depends on its parent and on its transform node, which is
+// used for backface visibility.
+static bool EffectNodeNeedsUpdate(const EffectTree& effect_tree,
+                                  const EffectNode* node,
+                                  const TransformTree& transform_tree) {
+  return effect_tree.NodeNeedsUpdate(node->id) ||
+         effect_tree.NodeWasUpdated(node->parent_id) ||
+         transform_tree.NodeWasUpdated(node->data.transform_id);
+}
+
 void ComputeEffects(EffectTree* effect_tree) {
-  if (!effect_tree->needs_update())
+  const TransformTree* transform_tree =
+      effect_tree->property_trees()
+          ? &effect_tree->property_trees()->transform_tree
+          : nullptr;
+  if (!transform_tree || !effect_tree->CanUpdatePartially() ||
+      !transform_tree->last_update_was_partial()) {
+    effect_tree->BeginUpdate(false);
+    for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i)
+      effect_tree->UpdateEffects(i);
+    effect_tree->EndUpdate();
     return;
-  for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i)
+  }
+
+  effect_tree->BeginUpdate(true);
+  for (int i = 1; i < static_cast<int>(effect_tree->size()); ++i) {
+    if (!EffectNodeNeedsUpdate(*effect_tree, effect_tree->Node(i),
+                               *transform_tree))
+      continue;
     effect_tree->UpdateEffects(i);
-  effect_tree->set_needs_update(false);
+    effect_tree->SetNodeUpdated(i);
+  }
+  effect_tree->EndUpdate();
 }
 
 static void ComputeClipsWithEffectTree(PropertyTrees* property_trees) {
@@ -888,6 +980,36 @@ static void ComputeLayerClipRect(const PropertyTrees* property_trees,
   }
 }
 
+// Returns true if |layer|'s visible rect and clip rect from the previous pass
+// are still valid. They are if the layer was visible in that pass, and neither
+// the layer nor any of the property nodes its rects depend on changed since.
+static bool CanReuseVisibleRects(const LayerImpl* layer,
+                                 const PropertyTrees& property_trees,
+                                 int last_pass_id) {
+  if (last_pass_id == 0 ||
+      layer->draw_properties().visible_rects_pass_id != last_pass_id)
+    return false;
+  if (layer->LayerPropertyChanged())
+    return false;
+
+  const TransformTree& transform_tree = property_trees.transform_tree;
+  const ClipTree& clip_tree = property_trees.clip_tree;
+  const EffectTree& effect_tree = property_trees.effect_tree;
+  // Ancestor changes propagate to descendants, so this also covers changes to
+  // the transforms of the layer's target and of its clip's target.
+  const ClipNode* clip_node = clip_tree.Node(layer->clip_tree_index());
+  if (transform_tree.NodeWasUpdated(layer->transform_tree_index()) ||
+      transform_tree.NodeWasUpdated(clip_node->data.target_id) ||
+      clip_tree.NodeWasUpdated(clip_node->id) ||
+      effect_tree.NodeWasUpdated(layer->effect_tree_index()))
+    return false;
+
+  // Visible rects below a copy request depend on the copy request's transform,
+  // which can be anywhere above the layer.
+  return effect_tree.ClosestAncestorWithCopyRequest(
+             layer->effect_tree_index()) <= 1;
+}
+
 static void ComputeVisibleRectsInternal(
     LayerImpl* root_layer,
     PropertyTrees* property_trees,
@@ -912,12 +1034,27 @@ static void ComputeVisibleRectsInternal(
   FindLayersThatNeedUpdates(root_layer->layer_tree_impl(),
                             property_trees->transform_tree,
                             property_trees->effect_tree, visible_layer_list);
-  CalculateClipRects<LayerImpl>(*visible_layer_list, property_trees->clip_tree,
-                                property_trees->transform_tree,
-                                property_trees->effect_tree,
-                                can_render_to_separate_surface);
+
+  // When only part of the property trees changed, most layers keep the rects
+  // computed by the previous pass.
+  int last_pass_id = property_trees->visible_rects_pass_id;
+  // Pass ids start at 1, since 0 means that there was no pass.
+  property_trees->visible_rects_pass_id =
+      g_next_visible_rects_pass_id.GetNext() + 1;
+  LayerImplList layers_needing_visible_rects;
+  for (LayerImpl* layer : *visible_layer_list) {
+    if (!CanReuseVisibleRects(layer, *property_trees, last_pass_id))
+      layers_needing_visible_rects.push_back(layer);
+    layer->draw_properties().visible_rects_pass_id =
+        property_trees->visible_rects_pass_id;
+  }
+
+  CalculateClipRects<LayerImpl>(
+      layers_needing_visible_rects, property_trees->clip_tree,
+      property_trees->transform_tree, property_trees->effect_tree,
+      can_render_to_separate_surface);
   CalculateVisibleRects<LayerImpl>(
-      *visible_layer_list, property_trees->clip_tree,
+      layers_needing_visible_rects, property_trees->clip_tree,
       property_trees->transform_tree, property_trees->effect_tree,
       can_render_to_separate_surface);
 }
@@ -937,6 +1074,9 @@ void UpdatePropertyTrees(PropertyTrees* property_trees,
   ComputeClips(&property_trees->clip_tree, property_trees->transform_tree,
                can_render_to_separate_surface);
   ComputeEffects(&property_trees->effect_tree);
+  // The nodes updated here are not taken into account by the next visible
+  // rects pass.
+  property_trees->visible_rects_pass_id = 0;
 }
 
 void ComputeVisibleRectsForTesting(PropertyTrees* property_trees,
@@ -1359,7 +1499,7 @@ static void UpdateElasticOverscrollInternal(
 
   node->data.scroll_offset = gfx::ScrollOffset(elastic_overscroll);
   node->data.needs_local_transform_update = true;
-  property_trees->transform_tree.set_needs_update(true);
+  property_trees->transform_tree.SetNodeNeedsUpdate(node->id);
 }
 
 void UpdateElasticOverscroll(PropertyTrees* property_trees,
@@ -29,16 +29,21 @@ class PropertyTrees;
 namespace draw_property_utils {
 
 // Computes combined clips for every node in |clip_tree|. This function requires
-// that |transform_tree| has been updated via |ComputeTransforms|.
+// that |transform_tree| has been updated via |ComputeTransforms|. Unless
+// |clip_tree| or |transform_tree| needed a full update, only the nodes that
+// depend on changed nodes are recomputed.
 void CC_EXPORT ComputeClips(ClipTree* clip_tree,
                             const TransformTree& transform_tree,
                             bool non_root_surfaces_enabled);
 
 // Computes combined (screen space) transforms for every node in the transform
-// tree. This must be done prior to calling |ComputeClips|.
+// tree. This must be done prior to calling |ComputeClips| and
+// |ComputeEffects|. When only some nodes were marked with
+// SetNodeNeedsUpdate(), only their subtrees are recomputed.
 void CC_EXPORT ComputeTransforms(TransformTree* transform_tree);
 
-// Computes screen space opacity for every node in the opacity tree.
+// Computes screen space opacity for every node in the opacity tree. Like
+// |ComputeClips|, this only recomputes the affected nodes when it can.
 void CC_EXPORT ComputeEffects(EffectTree* effect_tree);
 
 void CC_EXPORT BuildPropertyTreesAndComputeVisibleRects(
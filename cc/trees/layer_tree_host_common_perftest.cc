@@ -16,6 +16,8 @@
 #include "base/time/time.h"
 #include "cc/debug/lap_timer.h"
 #include "cc/layers/layer.h"
+#include "cc/layers/layer_impl.h"
+#include "cc/layers/picture_layer.h"
 #include "cc/output/bsp_tree.h"
 #include "cc/quads/draw_polygon.h"
 #include "cc/quads/draw_quad.h"
@@ -35,6 +37,9 @@ static const int kTimeLimitMillis = 2000;
 static const int kWarmupRuns = 5;
 static const int kTimeCheckInterval = 10;
 
+static const int kNumContainers = 50;
+static const int kLayersPerContainer = 100;
+
 class LayerTreeHostCommonPerfTest : public LayerTreeTest {
  public:
   LayerTreeHostCommonPerfTest()
@@ -124,6 +129,84 @@ class CalcDrawPropsTest : public LayerTreeHostCommonPerfTest {
   }
 };
 
+// Measures a frame in which one layer out of 5000 runs a transform animation,
+// optionally forcing the property trees to be updated in full like they were
+// before only the changed subtrees were updated.
+class CalcDrawPropsSingleAnimationTest : public CalcDrawPropsTest {
+ public:
+  CalcDrawPropsSingleAnimationTest()
+      : animated_layer_id_(Layer::INVALID_ID), force_full_update_(false) {}
+
+  void SetForceFullUpdate(bool force_full_update) {
+    force_full_update_ = force_full_update;
+  }
+
+  // Builds rows of clipped layers that each have a transform node, like a grid
+  // of tiles in which any one tile can animate.
+  void SetupTree() override {
+    gfx::Size viewport = gfx::Size(720, 1038);
+    layer_tree_host()->SetViewportSize(viewport);
+    content_layer_client_.set_bounds(viewport);
+
+    scoped_refptr<Layer> root = Layer::Create();
+    root->SetBounds(viewport);
+    gfx::Transform scale;
+    scale.Scale(0.5f, 0.5f);
+    for (int i = 0; i < kNumContainers; ++i) {
+      scoped_refptr<Layer> container = Layer::Create();
+      container->SetPosition(gfx::PointF(0.f, i * 20.f));
+      container->SetBounds(gfx::Size(viewport.width(), 20));
+      container->SetMasksToBounds(true);
+      root->AddChild(container);
+      for (int j = 0; j < kLayersPerContainer; ++j) {
+        scoped_refptr<PictureLayer> layer =
+            PictureLayer::Create(&content_layer_client_);
+        layer->SetPosition(gfx::PointF(j * 10.f, 0.f));
+        layer->SetBounds(gfx::Size(40, 40));
+        layer->SetTransform(scale);
+        layer->SetIsDrawable(true);
+        container->AddChild(layer);
+        if (i == kNumContainers / 2 && j == kLayersPerContainer / 2)
+          animated_layer_id_ = layer->id();
+      }
+    }
+    layer_tree_host()->SetRootLayer(root);
+  }
+
+  void DrawLayersOnThread(LayerTreeHostImpl* host_impl) override {
+    LayerTreeImpl* active_tree = host_impl->active_tree();
+    LayerImpl* animated_layer = active_tree->LayerById(animated_layer_id_);
+    ASSERT_TRUE(animated_layer);
+
+    int frame = 0;
+    timer_.Reset();
+    do {
+      // Alternate between two transforms so that every frame has a change.
+      gfx::Transform transform;
+      transform.Translate(frame++ % 2, 0.f);
+      transform.Scale(0.5f, 0.5f);
+      animated_layer->OnTransformAnimated(transform);
+      if (force_full_update_)
+        active_tree->property_trees()->transform_tree.set_needs_update(true);
+
+      bool can_render_to_separate_surface = true;
+      int max_texture_size = 8096;
+      DoCalcDrawPropertiesImpl(can_render_to_separate_surface,
+                               max_texture_size, active_tree, host_impl);
+      // Drawing the frame resets the change tracking.
+      active_tree->ResetAllChangeTracking();
+
+      timer_.NextLap();
+    } while (!timer_.HasTimeLimitExpired());
+
+    EndTest();
+  }
+
+ private:
+  int animated_layer_id_;
+  bool force_full_update_;
+};
+
 class BspTreePerfTest : public CalcDrawPropsTest {
  public:
   BspTreePerfTest() : num_duplicates_(1) {}
@@ -211,6 +294,17 @@ TEST_F(CalcDrawPropsTest, TouchRegionHeavy) {
   RunCalcDrawProps();
 }
 
+TEST_F(CalcDrawPropsSingleAnimationTest, FiveThousandLayers) {
+  SetTestName("single_animation_5000_layers");
+  RunCalcDrawProps();
+}
+
+TEST_F(CalcDrawPropsSingleAnimationTest, FiveThousandLayersFullUpdate) {
+  SetTestName("single_animation_5000_layers_full_update");
+  SetForceFullUpdate(true);
+  RunCalcDrawProps();
+}
+
 TEST_F(BspTreePerfTest, LayerSorterCubes) {
   SetTestName("layer_sort_cubes");
   ReadTestFile("layer_sort_cubes");
@@ -6617,6 +6617,48 @@ TEST_F(LayerTreeHostCommonTest, TransformAnimationUpdatesBackfaceVisibility) {
                   ->data.hidden_by_backface_visibility);
 }
 
+TEST_F(LayerTreeHostCommonTest, TransformAnimationUpdatesOnlyAffectedLayers) {
+  LayerImpl* root = root_layer();
+  LayerImpl* clip_layer = AddChild<LayerImpl>(root);
+  LayerImpl* animated = AddChild<LayerImpl>(clip_layer);
+  LayerImpl* sibling = AddChild<LayerImpl>(clip_layer);
+
+  gfx::Transform identity_transform;
+  gfx::Transform scale;
+  scale.Scale(2.f, 1.f);
+  SetLayerPropertiesForTesting(root, identity_transform, gfx::Point3F(),
+                               gfx::PointF(), gfx::Size(100, 100), true, false,
+                               true);
+  SetLayerPropertiesForTesting(clip_layer, identity_transform, gfx::Point3F(),
+                               gfx::PointF(), gfx::Size(50, 50), true, false,
+                               false);
+  SetLayerPropertiesForTesting(animated, scale, gfx::Point3F(), gfx::PointF(),
+                               gfx::Size(50, 50), true, false, false);
+  SetLayerPropertiesForTesting(sibling, identity_transform, gfx::Point3F(),
+                               gfx::PointF(25.f, 25.f), gfx::Size(50, 50), true,
+                               false, false);
+  clip_layer->SetMasksToBounds(true);
+  animated->SetDrawsContent(true);
+  sibling->SetDrawsContent(true);
+
+  ExecuteCalculateDrawProperties(root);
+  EXPECT_EQ(gfx::Rect(0, 0, 25, 50), animated->visible_layer_rect());
+  EXPECT_EQ(gfx::Rect(0, 0, 25, 25), sibling->visible_layer_rect());
+
+  animated->OnTransformAnimated(identity_transform);
+  ExecuteCalculateDrawProperties(root);
+
+  // Only the animated layer's transform node is recomputed.
+  const TransformTree& tree =
+      root->layer_tree_impl()->property_trees()->transform_tree;
+  EXPECT_TRUE(tree.last_update_was_partial());
+  EXPECT_TRUE(tree.NodeWasUpdated(animated->transform_tree_index()));
+  EXPECT_FALSE(tree.NodeWasUpdated(sibling->transform_tree_index()));
+
+  EXPECT_EQ(gfx::Rect(0, 0, 50, 50), animated->visible_layer_rect());
+  EXPECT_EQ(gfx::Rect(0, 0, 25, 25), sibling->visible_layer_rect());
+}
+
 TEST_F(LayerTreeHostCommonTest, ClippedByScrollParent) {
   // Checks that the simple case (being clipped by a scroll parent that would
   // have been processed before you anyhow) results in the right clips.
@@ -2187,7 +2187,10 @@ void LayerTreeHostImpl::CreateTileManagerResources() {
     image_decode_controller_ =
         base::WrapUnique(new SoftwareImageDecodeController(
             settings_.renderer_settings.preferred_tile_format,
-            settings_.software_decoded_image_budget_bytes));
+            settings_.software_decoded_image_budget_bytes,
+            settings_.use_shared_software_image_decode_cache
+                ? SharedImageDecodeCache::GetInstance()
+                : nullptr));
   }
 
   // Pass the single-threaded synchronous task graph runner to the worker pool
@@ -2226,8 +2229,14 @@ void LayerTreeHostImpl::CreateResourceAndRasterBufferProvider(
     *resource_pool =
         ResourcePool::Create(resource_provider_.get(), GetTaskRunner());
 
-    *raster_buffer_provider =
-        BitmapRasterBufferProvider::Create(resource_provider_.get());
+    // Tiles are not split into bands when rastering synchronously, as there
+    // are no other threads to raster the bands.
+    TaskGraphRunner* band_task_graph_runner =
+        settings_.use_band_raster && !is_synchronous_single_threaded_
+            ? task_graph_runner_
+            : nullptr;
+    *raster_buffer_provider = BitmapRasterBufferProvider::Create(
+        resource_provider_.get(), band_task_graph_runner);
     return;
   }
 
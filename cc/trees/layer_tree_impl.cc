@@ -151,7 +151,7 @@ void LayerTreeImpl::DidUpdateScrollOffset(int layer_id, int transform_id) {
         scroll_tree.current_scroll_offset(layer_id)) {
       node->data.scroll_offset = scroll_tree.current_scroll_offset(layer_id);
       node->data.needs_local_transform_update = true;
-      transform_tree.set_needs_update(true);
+      transform_tree.SetNodeNeedsUpdate(node->id);
     }
     node->data.transform_changed = true;
     property_trees()->changed = true;
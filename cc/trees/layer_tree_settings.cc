@@ -107,6 +107,7 @@ bool LayerTreeSettings::operator==(const LayerTreeSettings& other) const {
              other.max_memory_for_prepaint_percentage &&
          use_zero_copy == other.use_zero_copy &&
          use_partial_raster == other.use_partial_raster &&
+         use_band_raster == other.use_band_raster &&
          enable_elastic_overscroll == other.enable_elastic_overscroll &&
          use_image_texture_targets == other.use_image_texture_targets &&
          ignore_root_layer_flings == other.ignore_root_layer_flings &&
@@ -115,6 +116,8 @@ bool LayerTreeSettings::operator==(const LayerTreeSettings& other) const {
              other.use_occlusion_for_tile_prioritization &&
          verify_clip_tree_calculations == other.verify_clip_tree_calculations &&
          image_decode_tasks_enabled == other.image_decode_tasks_enabled &&
+         use_shared_software_image_decode_cache ==
+             other.use_shared_software_image_decode_cache &&
          wait_for_beginframe_interval == other.wait_for_beginframe_interval &&
          max_staging_buffer_usage_in_bytes ==
              other.max_staging_buffer_usage_in_bytes &&
@@ -168,12 +171,15 @@ void LayerTreeSettings::ToProtobuf(proto::LayerTreeSettings* proto) const {
       max_memory_for_prepaint_percentage);
   proto->set_use_zero_copy(use_zero_copy);
   proto->set_use_partial_raster(use_partial_raster);
+  proto->set_use_band_raster(use_band_raster);
   proto->set_enable_elastic_overscroll(enable_elastic_overscroll);
   proto->set_ignore_root_layer_flings(ignore_root_layer_flings);
   proto->set_scheduled_raster_task_limit(scheduled_raster_task_limit);
   proto->set_use_occlusion_for_tile_prioritization(
       use_occlusion_for_tile_prioritization);
   proto->set_image_decode_tasks_enabled(image_decode_tasks_enabled);
+  proto->set_use_shared_software_image_decode_cache(
+      use_shared_software_image_decode_cache);
   proto->set_wait_for_beginframe_interval(wait_for_beginframe_interval);
   proto->set_max_staging_buffer_usage_in_bytes(
       max_staging_buffer_usage_in_bytes);
@@ -229,6 +235,7 @@ void LayerTreeSettings::FromProtobuf(const proto::LayerTreeSettings& proto) {
       proto.max_memory_for_prepaint_percentage();
   use_zero_copy = proto.use_zero_copy();
   use_partial_raster = proto.use_partial_raster();
+  use_band_raster = proto.use_band_raster();
   enable_elastic_overscroll = proto.enable_elastic_overscroll();
   // |use_image_texture_targets| contains default values, so clear first.
   use_image_texture_targets.clear();
@@ -237,6 +244,8 @@ void LayerTreeSettings::FromProtobuf(const proto::LayerTreeSettings& proto) {
   use_occlusion_for_tile_prioritization =
       proto.use_occlusion_for_tile_prioritization();
   image_decode_tasks_enabled = proto.image_decode_tasks_enabled();
+  use_shared_software_image_decode_cache =
+      proto.use_shared_software_image_decode_cache();
   wait_for_beginframe_interval = proto.wait_for_beginframe_interval();
   max_staging_buffer_usage_in_bytes = proto.max_staging_buffer_usage_in_bytes();
   memory_policy_.FromProtobuf(proto.memory_policy());
@@ -84,6 +84,9 @@ class CC_EXPORT LayerTreeSettings {
   size_t max_memory_for_prepaint_percentage = 100;
   bool use_zero_copy = false;
   bool use_partial_raster = false;
+  // If set to true, software raster splits each tile into bands which are
+  // rastered concurrently on the worker threads.
+  bool use_band_raster = false;
   bool enable_elastic_overscroll = false;
   // An array of image texture targets for each GpuMemoryBuffer format.
   std::vector<unsigned> use_image_texture_targets;
@@ -99,6 +102,9 @@ class CC_EXPORT LayerTreeSettings {
   ManagedMemoryPolicy memory_policy_;
   size_t gpu_decoded_image_budget_bytes = 96 * 1024 * 1024;
   size_t software_decoded_image_budget_bytes = 128 * 1024 * 1024;
+  // If set to true, software image decodes are shared with the other
+  // compositors in this process through SharedImageDecodeCache.
+  bool use_shared_software_image_decode_cache = false;
   int max_preraster_distance_in_screen_pixels = 1000;
 
   // If set to true, the display item list will internally cache a SkPicture for
@@ -76,6 +76,7 @@ TEST(LayerTreeSettingsTest, AllMembersChanged) {
       settings.max_memory_for_prepaint_percentage * 3 + 1;
   settings.use_zero_copy = !settings.use_zero_copy;
   settings.use_partial_raster = !settings.use_partial_raster;
+  settings.use_band_raster = !settings.use_band_raster;
   settings.enable_elastic_overscroll = !settings.enable_elastic_overscroll;
   settings.use_image_texture_targets.push_back(54);
   settings.use_image_texture_targets.push_back(55);
@@ -86,6 +87,8 @@ TEST(LayerTreeSettingsTest, AllMembersChanged) {
       !settings.use_occlusion_for_tile_prioritization;
   settings.wait_for_beginframe_interval =
       !settings.wait_for_beginframe_interval;
+  settings.use_shared_software_image_decode_cache =
+      !settings.use_shared_software_image_decode_cache;
   settings.max_staging_buffer_usage_in_bytes =
       settings.max_staging_buffer_usage_in_bytes * 3 + 1;
   settings.memory_policy_ = ManagedMemoryPolicy(
@@ -134,6 +137,7 @@ TEST(LayerTreeSettingsTest, ArbitraryValues) {
   settings.max_memory_for_prepaint_percentage = 62;
   settings.use_zero_copy = true;
   settings.use_partial_raster = true;
+  settings.use_band_raster = true;
   settings.enable_elastic_overscroll = false;
   settings.use_image_texture_targets.push_back(10);
   settings.use_image_texture_targets.push_back(19);
@@ -141,6 +145,7 @@ TEST(LayerTreeSettingsTest, ArbitraryValues) {
   settings.scheduled_raster_task_limit = 41;
   settings.use_occlusion_for_tile_prioritization = true;
   settings.wait_for_beginframe_interval = true;
+  settings.use_shared_software_image_decode_cache = true;
   settings.max_staging_buffer_usage_in_bytes = 70;
   settings.memory_policy_ = ManagedMemoryPolicy(
       71, gpu::MemoryAllocation::CUTOFF_ALLOW_NICE_TO_HAVE, 77);
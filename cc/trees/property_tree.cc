@@ -65,7 +65,10 @@ template struct TreeNode<ScrollNodeData>;
 
 template <typename T>
 PropertyTree<T>::PropertyTree()
-    : needs_update_(false) {
+    : needs_update_(false),
+      property_trees_(nullptr),
+      first_node_needing_update_(-1),
+      last_update_was_partial_(false) {
   nodes_.push_back(T());
   back()->id = 0;
   back()->parent_id = -1;
@@ -102,6 +105,47 @@ void PropertyTree<T>::clear() {
   nodes_.push_back(T());
   back()->id = 0;
   back()->parent_id = -1;
+  node_needs_update_.clear();
+  first_node_needing_update_ = -1;
+  node_updated_.clear();
+  last_update_was_partial_ = false;
+}
+
+template <typename T>
+void PropertyTree<T>::SetNodeNeedsUpdate(int id) {
+  DCHECK_GT(id, 0);
+  DCHECK_LT(id, static_cast<int>(size()));
+  if (node_needs_update_.size() != nodes_.size())
+    node_needs_update_.resize(nodes_.size());
+  node_needs_update_[id] = true;
+  if (first_node_needing_update_ == -1 || id < first_node_needing_update_)
+    first_node_needing_update_ = id;
+}
+
+template <typename T>
+bool PropertyTree<T>::NodeNeedsUpdate(int id) const {
+  return id < static_cast<int>(node_needs_update_.size()) &&
+         node_needs_update_[id];
+}
+
+template <typename T>
+bool PropertyTree<T>::CanUpdatePartially() const {
+  // Nodes that were added since the last update have never been computed.
+  return !needs_update_ && node_updated_.size() == nodes_.size();
+}
+
+template <typename T>
+void PropertyTree<T>::BeginUpdate(bool partial) {
+  last_update_was_partial_ = partial;
+  node_updated_.assign(nodes_.size(), false);
+}
+
+template <typename T>
+void PropertyTree<T>::EndUpdate() {
+  needs_update_ = false;
+  if (first_node_needing_update_ != -1)
+    node_needs_update_.assign(nodes_.size(), false);
+  first_node_needing_update_ = -1;
 }
 
 template <typename T>
@@ -2160,7 +2204,8 @@ PropertyTrees::PropertyTrees()
       full_tree_damaged(false),
       sequence_number(0),
       is_main_thread(true),
-      is_active(false) {
+      is_active(false),
+      visible_rects_pass_id(0) {
   transform_tree.SetPropertyTrees(this);
   effect_tree.SetPropertyTrees(this);
   clip_tree.SetPropertyTrees(this);
@@ -2205,6 +2250,9 @@ PropertyTrees& PropertyTrees::operator=(const PropertyTrees& from) {
   sequence_number = from.sequence_number;
   is_main_thread = from.is_main_thread;
   is_active = from.is_active;
+  // The layers that use these trees did not compute their visible rects with
+  // |from|.
+  visible_rects_pass_id = 0;
   inner_viewport_container_bounds_delta_ =
       from.inner_viewport_container_bounds_delta();
   outer_viewport_container_bounds_delta_ =
@@ -389,6 +389,28 @@ class CC_EXPORT PropertyTree {
   void set_needs_update(bool needs_update) { needs_update_ = needs_update; }
   bool needs_update() const { return needs_update_; }
 
+  // Marks only the node at |id| as changed. Unless the whole tree needs an
+  // update, the next update recomputes this node and the nodes that depend on
+  // it, and leaves the rest of the tree alone.
+  void SetNodeNeedsUpdate(int id);
+  bool NodeNeedsUpdate(int id) const;
+
+  // Used by the update passes in draw_property_utils. A partial update visits
+  // the nodes from first_node_needing_update() on and records the nodes it
+  // recomputes, so that passes over dependent trees (and the visible rects of
+  // layers) can skip everything that did not change.
+  bool CanUpdatePartially() const;
+  int first_node_needing_update() const { return first_node_needing_update_; }
+  void BeginUpdate(bool partial);
+  void SetNodeUpdated(int id) { node_updated_[id] = true; }
+  void EndUpdate();
+  // Returns true if the last update recomputed the node at |id|. Every node
+  // counts as updated after a full update.
+  bool NodeWasUpdated(int id) const {
+    return !last_update_was_partial_ || (id > -1 && node_updated_[id]);
+  }
+  bool last_update_was_partial() const { return last_update_was_partial_; }
+
   std::vector<T>& nodes() { return nodes_; }
   const std::vector<T>& nodes() const { return nodes_; }
 
@@ -410,6 +432,14 @@ class CC_EXPORT PropertyTree {
 
   bool needs_update_;
   PropertyTrees* property_trees_;
+
+  // Dirty tracking for partial updates. This is transient state and is not
+  // serialized or compared, since a tree that is sent elsewhere is fully
+  // updated there.
+  std::vector<bool> node_needs_update_;
+  int first_node_needing_update_;
+  std::vector<bool> node_updated_;
+  bool last_update_was_partial_;
 };
 
 class CC_EXPORT TransformTree final : public PropertyTree<TransformNode> {
@@ -763,6 +793,10 @@ class CC_EXPORT PropertyTrees final {
   int sequence_number;
   bool is_main_thread;
   bool is_active;
+  // Identifies the last pass that computed visible rects with these trees, so
+  // that layers whose property nodes did not change since can keep theirs.
+  // This is transient and is neither serialized nor copied; 0 means no pass.
+  int visible_rects_pass_id;
 
   void SetInnerViewportContainerBoundsDelta(gfx::Vector2dF bounds_delta);
   void SetOuterViewportContainerBoundsDelta(gfx::Vector2dF bounds_delta);
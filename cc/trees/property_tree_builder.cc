@@ -1308,7 +1308,8 @@ void BuildPropertyTreesTopLevelInternal(
   // The transform tree is kept up to date as it is built, but the
   // combined_clips stored in the clip tree and the screen_space_opacity and
   // is_drawn in the effect tree aren't computed during tree building.
-  property_trees->transform_tree.set_needs_update(false);
+  property_trees->transform_tree.BeginUpdate(false);
+  property_trees->transform_tree.EndUpdate();
   property_trees->clip_tree.set_needs_update(true);
   property_trees->effect_tree.set_needs_update(true);
   property_trees->scroll_tree.set_needs_update(false);
@@ -1066,6 +1066,94 @@ class PropertyTreeTestScreenSpaceOpacityUpdateTest : public PropertyTreeTest {
 DIRECT_AND_SERIALIZED_PROPERTY_TREE_TEST_F(
     PropertyTreeTestScreenSpaceOpacityUpdateTest);
 
+class PropertyTreeTestPartialTransformUpdate : public PropertyTreeTest {
+ protected:
+  void StartTest() override {
+    // This tests that changing a single node only updates its subtree.
+    PropertyTrees property_trees;
+    TransformTree& tree = property_trees.transform_tree;
+
+    int root = tree.Insert(TransformNode(), 0);
+    tree.SetTargetId(root, root);
+    tree.SetContentTargetId(root, root);
+    tree.Node(root)->data.source_node_id = 0;
+    int parent = tree.Insert(TransformNode(), root);
+    tree.SetTargetId(parent, root);
+    tree.SetContentTargetId(parent, root);
+    tree.Node(parent)->data.source_node_id = root;
+    int child = tree.Insert(TransformNode(), parent);
+    tree.SetTargetId(child, root);
+    tree.SetContentTargetId(child, root);
+    tree.Node(child)->data.source_node_id = parent;
+    tree.Node(child)->data.local.Translate(1.f, 2.f);
+    int sibling = tree.Insert(TransformNode(), root);
+    tree.SetTargetId(sibling, root);
+    tree.SetContentTargetId(sibling, root);
+    tree.Node(sibling)->data.source_node_id = root;
+
+    tree.set_needs_update(true);
+    draw_property_utils::ComputeTransforms(&tree);
+    EXPECT_FALSE(tree.last_update_was_partial());
+
+    tree.Node(parent)->data.local.Translate(10.f, 0.f);
+    tree.Node(parent)->data.needs_local_transform_update = true;
+    tree.SetNodeNeedsUpdate(parent);
+    draw_property_utils::ComputeTransforms(&tree);
+
+    EXPECT_TRUE(tree.last_update_was_partial());
+    EXPECT_FALSE(tree.NodeWasUpdated(root));
+    EXPECT_TRUE(tree.NodeWasUpdated(parent));
+    EXPECT_TRUE(tree.NodeWasUpdated(child));
+    EXPECT_FALSE(tree.NodeWasUpdated(sibling));
+
+    gfx::Transform expected;
+    expected.Translate(11.f, 2.f);
+    EXPECT_TRANSFORMATION_MATRIX_EQ(expected, tree.ToScreen(child));
+    EXPECT_TRANSFORMATION_MATRIX_EQ(gfx::Transform(), tree.ToScreen(sibling));
+
+    // Nothing changed, so nothing is updated.
+    draw_property_utils::ComputeTransforms(&tree);
+    EXPECT_TRUE(tree.last_update_was_partial());
+    EXPECT_FALSE(tree.NodeWasUpdated(parent));
+    EXPECT_FALSE(tree.NodeWasUpdated(child));
+  }
+};
+
+// Partial updates depend on state that isn't serialized.
+DIRECT_PROPERTY_TREE_TEST_F(PropertyTreeTestPartialTransformUpdate);
+
+class PropertyTreeTestPartialEffectUpdate : public PropertyTreeTest {
+ protected:
+  void StartTest() override {
+    // This tests that screen space opacity is only updated for the subtree of
+    // a node whose opacity changed.
+    PropertyTrees property_trees;
+    EffectTree& tree = property_trees.effect_tree;
+
+    int parent = tree.Insert(EffectNode(), 0);
+    int child = tree.Insert(EffectNode(), parent);
+    int sibling = tree.Insert(EffectNode(), 0);
+
+    tree.set_needs_update(true);
+    draw_property_utils::ComputeTransforms(&property_trees.transform_tree);
+    draw_property_utils::ComputeEffects(&tree);
+
+    tree.Node(parent)->data.opacity = 0.5f;
+    tree.SetNodeNeedsUpdate(parent);
+    draw_property_utils::ComputeTransforms(&property_trees.transform_tree);
+    draw_property_utils::ComputeEffects(&tree);
+
+    EXPECT_TRUE(tree.last_update_was_partial());
+    EXPECT_TRUE(tree.NodeWasUpdated(parent));
+    EXPECT_TRUE(tree.NodeWasUpdated(child));
+    EXPECT_FALSE(tree.NodeWasUpdated(sibling));
+    EXPECT_EQ(0.5f, tree.Node(child)->data.screen_space_opacity);
+    EXPECT_EQ(1.f, tree.Node(sibling)->data.screen_space_opacity);
+  }
+};
+
+DIRECT_PROPERTY_TREE_TEST_F(PropertyTreeTestPartialEffectUpdate);
+
 class PropertyTreeTestNonIntegerTranslationTest : public PropertyTreeTest {
  protected:
   void StartTest() override {
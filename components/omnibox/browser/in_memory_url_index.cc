@@ -70,6 +70,35 @@ InMemoryURLIndex::RebuildPrivateDataFromHistoryDBTask::
     ~RebuildPrivateDataFromHistoryDBTask() {
 }
 
+// RefreshPrivateDataFromHistoryDBTask -----------------------------------------
+
+InMemoryURLIndex::RefreshPrivateDataFromHistoryDBTask::
+    RefreshPrivateDataFromHistoryDBTask(
+        InMemoryURLIndex* index,
+        const SchemeSet& scheme_whitelist,
+        scoped_refptr<URLIndexPrivateData> data)
+    : index_(index),
+      scheme_whitelist_(scheme_whitelist),
+      succeeded_(false),
+      data_(data) {
+}
+
+bool InMemoryURLIndex::RefreshPrivateDataFromHistoryDBTask::RunOnDBThread(
+    history::HistoryBackend* backend,
+    history::HistoryDatabase* db) {
+  succeeded_ = data_->RefreshFromHistory(db, scheme_whitelist_);
+  return true;
+}
+
+void InMemoryURLIndex::RefreshPrivateDataFromHistoryDBTask::
+    DoneRunOnMainThread() {
+  index_->DoneRefreshingPrivateDataFromHistoryDB(succeeded_, data_);
+}
+
+InMemoryURLIndex::RefreshPrivateDataFromHistoryDBTask::
+    ~RefreshPrivateDataFromHistoryDBTask() {
+}
+
 // InMemoryURLIndex ------------------------------------------------------------
 
 InMemoryURLIndex::InMemoryURLIndex(
@@ -196,8 +225,12 @@ void InMemoryURLIndex::OnURLsDeleted(history::HistoryService* history_service,
 
 void InMemoryURLIndex::OnHistoryServiceLoaded(
     history::HistoryService* history_service) {
-  if (listen_to_history_service_loaded_)
-    ScheduleRebuildFromHistory();
+  if (listen_to_history_service_loaded_) {
+    if (restored_)
+      ScheduleRefreshFromHistory();
+    else
+      ScheduleRebuildFromHistory();
+  }
   listen_to_history_service_loaded_ = false;
 }
 
@@ -230,6 +263,15 @@ void InMemoryURLIndex::OnCacheLoadDone(
     restored_ = true;
     if (restore_cache_observer_)
       restore_cache_observer_->OnCacheRestoreFinished(true);
+    // A stale cache is searched while it is brought up to date, which only
+    // re-indexes the rows which changed, rather than rebuilt from scratch.
+    if (history_service_ && !shutdown_ &&
+        private_data_->NeedsRefreshFromHistory()) {
+      if (history_service_->backend_loaded())
+        ScheduleRefreshFromHistory();
+      else
+        listen_to_history_service_loaded_ = true;
+    }
   } else if (history_service_) {
     // When unable to restore from the cache file delete the cache file, if
     // it exists, and then rebuild from the history database if it's available,
@@ -299,6 +341,26 @@ void InMemoryURLIndex::DoneRebuidingPrivateDataFromHistoryDB(
     restore_cache_observer_->OnCacheRestoreFinished(succeeded);
 }
 
+void InMemoryURLIndex::ScheduleRefreshFromHistory() {
+  DCHECK(history_service_);
+  history_service_->ScheduleDBTask(
+      std::unique_ptr<history::HistoryDBTask>(
+          new InMemoryURLIndex::RefreshPrivateDataFromHistoryDBTask(
+              this, scheme_whitelist_, private_data_->Duplicate())),
+      &cache_reader_tracker_);
+}
+
+void InMemoryURLIndex::DoneRefreshingPrivateDataFromHistoryDB(
+    bool succeeded,
+    scoped_refptr<URLIndexPrivateData> private_data) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  if (!succeeded)
+    return;  // Keep searching the stale private data.
+  private_data_tracker_.TryCancelAll();
+  private_data_ = private_data;
+  PostSaveToCacheFileTask();  // Cache the refreshed index.
+}
+
 void InMemoryURLIndex::RebuildFromHistory(
     history::HistoryDatabase* history_db) {
   private_data_tracker_.TryCancelAll();
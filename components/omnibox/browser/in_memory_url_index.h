@@ -174,6 +174,30 @@ class InMemoryURLIndex : public KeyedService,
     DISALLOW_COPY_AND_ASSIGN(RebuildPrivateDataFromHistoryDBTask);
   };
 
+  // HistoryDBTask used to bring a copy of our private data, restored from a
+  // stale cache, up to date with the history database.
+  class RefreshPrivateDataFromHistoryDBTask : public history::HistoryDBTask {
+   public:
+    RefreshPrivateDataFromHistoryDBTask(
+        InMemoryURLIndex* index,
+        const SchemeSet& scheme_whitelist,
+        scoped_refptr<URLIndexPrivateData> data);
+
+    bool RunOnDBThread(history::HistoryBackend* backend,
+                       history::HistoryDatabase* db) override;
+    void DoneRunOnMainThread() override;
+
+   private:
+    ~RefreshPrivateDataFromHistoryDBTask() override;
+
+    InMemoryURLIndex* index_;  // Call back to this index at completion.
+    SchemeSet scheme_whitelist_;  // Schemes to be indexed.
+    bool succeeded_;  // Indicates if the refresh was successful.
+    scoped_refptr<URLIndexPrivateData> data_;  // The refreshed private data.
+
+    DISALLOW_COPY_AND_ASSIGN(RefreshPrivateDataFromHistoryDBTask);
+  };
+
   // Initializes all index data members in preparation for restoring the index
   // from the cache or a complete rebuild from the history database.
   void ClearPrivateData();
@@ -200,6 +224,18 @@ class InMemoryURLIndex : public KeyedService,
       bool succeeded,
       scoped_refptr<URLIndexPrivateData> private_data);
 
+  // Schedules a history task to refresh a copy of our private data, which was
+  // restored from a stale cache file, from the history database.
+  void ScheduleRefreshFromHistory();
+
+  // Callback used by RefreshPrivateDataFromHistoryDBTask to signal completion
+  // of refreshing our private data from the history database. If |succeeded|,
+  // |private_data| replaces our private data, otherwise the stale private
+  // data is kept.
+  void DoneRefreshingPrivateDataFromHistoryDB(
+      bool succeeded,
+      scoped_refptr<URLIndexPrivateData> private_data);
+
   // Rebuilds the history index from the history database in |history_db|.
   // Used for unit testing only.
   void RebuildFromHistory(history::HistoryDatabase* history_db);
@@ -208,8 +244,9 @@ class InMemoryURLIndex : public KeyedService,
   // file or if the private data must be rebuilt from the history database.
   // |private_data_ptr|'s data will be NULL if the cache file load failed. If
   // successful, sets the private data and notifies any
-  // |restore_cache_observer_|. Otherwise, kicks off a rebuild from the history
-  // database.
+  // |restore_cache_observer_|, then kicks off a refresh from the history
+  // database if the cache is stale. Otherwise, kicks off a rebuild from the
+  // history database.
   void OnCacheLoadDone(scoped_refptr<URLIndexPrivateData> private_data_ptr);
 
   // Callback function that sets the private data from the just-restored-from-
@@ -313,7 +350,8 @@ class InMemoryURLIndex : public KeyedService,
   bool needs_to_be_cached_;
 
   // This flag is set to true if we want to listen to the
-  // HistoryServiceLoaded Notification.
+  // HistoryServiceLoaded Notification, to rebuild our private data or, if it
+  // was restored from a stale cache, to refresh it.
   bool listen_to_history_service_loaded_;
 
   base::ThreadChecker thread_checker_;
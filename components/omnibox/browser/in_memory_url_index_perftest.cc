@@ -0,0 +1,233 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/sys_info.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/history/core/browser/history_database.h"
+#include "components/history/core/browser/history_types.h"
+#include "components/history/core/test/test_history_database.h"
+#include "components/omnibox/browser/in_memory_url_index_cache.pb.h"
+#include "components/omnibox/browser/url_index_private_data.h"
+#include "sql/init_status.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/base/page_transition_types.h"
+#include "url/gurl.h"
+#include "url/url_constants.h"
+
+namespace {
+
+// Number of significant URLs in the history database, like a profile which
+// has been used for years.
+const size_t kNumUrls = 100000;
+
+// Number of URLs changed, deleted or added by browsing after the cache was
+// saved.
+const size_t kNumChangedUrls = 1000;
+
+const char* const kWords[] = {
+    "account", "article", "best",   "blog",    "book",   "cheap",
+    "city",    "cloud",   "code",   "day",     "docs",   "forum",
+    "game",    "guide",   "health", "home",    "how",    "image",
+    "issue",   "login",   "mail",   "map",     "market", "music",
+    "news",    "online",  "photo",  "price",   "recipe", "review",
+    "search",  "shop",    "sport",  "store",   "travel", "video",
+    "weather", "wiki",    "world",  "your",
+};
+
+const char* const kTlds[] = {".com", ".net", ".org", ".co.uk", ".de", ".io"};
+
+// Returns a word, some of which are unique to a few URLs, like the names and
+// numbers in real URLs and titles.
+std::string RandomWord() {
+  std::string word = kWords[base::RandGenerator(arraysize(kWords))];
+  if (base::RandGenerator(2))
+    word += base::SizeTToString(base::RandGenerator(10000));
+  return word;
+}
+
+// Returns a URL like "https://news42.example.com/video/music123".
+GURL RandomUrl() {
+  std::string url = base::RandGenerator(2) ? "https://" : "http://";
+  url += RandomWord() + "." + RandomWord() +
+         kTlds[base::RandGenerator(arraysize(kTlds))];
+  for (size_t i = base::RandGenerator(4); i > 0; --i)
+    url += "/" + RandomWord();
+  return GURL(url);
+}
+
+// Returns a title of a few words.
+base::string16 RandomTitle() {
+  std::string title = RandomWord();
+  for (size_t i = base::RandGenerator(8); i > 0; --i)
+    title += " " + RandomWord();
+  return base::UTF8ToUTF16(title);
+}
+
+// Adds to |db| |kNumUrls| URLs which were visited or typed recently enough to
+// be indexed, with up to a dozen visits each.
+void PopulateHistoryDatabase(history::HistoryDatabase* db) {
+  const base::Time now = base::Time::Now();
+  history::HistoryDatabase::TransactionScoper transaction(db);
+  for (size_t i = 0; i < kNumUrls; ++i) {
+    history::URLRow row(RandomUrl());
+    row.set_title(RandomTitle());
+    row.set_visit_count(1 + base::RandGenerator(12));
+    row.set_typed_count(base::RandGenerator(2));
+    row.set_last_visit(now -
+                       base::TimeDelta::FromHours(base::RandGenerator(48)));
+    const history::URLID url_id = db->AddURL(row);
+    ASSERT_TRUE(url_id);
+    for (int visit = 0; visit < row.visit_count(); ++visit) {
+      history::VisitRow visit_row(
+          url_id, row.last_visit() - base::TimeDelta::FromDays(visit), 0,
+          ui::PAGE_TRANSITION_LINK, 0);
+      ASSERT_TRUE(db->AddVisit(&visit_row, history::SOURCE_BROWSED));
+    }
+  }
+}
+
+// Changes the title and visits of |kNumChangedUrls| URLs of |db|, deletes as
+// many and adds as many new ones.
+void BrowseHistoryDatabase(history::HistoryDatabase* db) {
+  const base::Time now = base::Time::Now();
+  history::HistoryDatabase::TransactionScoper transaction(db);
+  for (size_t i = 0; i < kNumChangedUrls; ++i) {
+    history::URLRow row;
+    const history::URLID url_id = 1 + base::RandGenerator(kNumUrls);
+    if (!db->GetURLRow(url_id, &row))
+      continue;
+    row.set_title(RandomTitle());
+    row.set_visit_count(row.visit_count() + 1);
+    row.set_last_visit(now);
+    ASSERT_TRUE(db->UpdateURLRow(url_id, row));
+  }
+  for (size_t i = 0; i < kNumChangedUrls; ++i)
+    db->DeleteURLRow(1 + base::RandGenerator(kNumUrls));
+  for (size_t i = 0; i < kNumChangedUrls; ++i) {
+    history::URLRow row(RandomUrl());
+    row.set_title(RandomTitle());
+    row.set_visit_count(1);
+    row.set_last_visit(now);
+    ASSERT_TRUE(db->AddURL(row));
+  }
+}
+
+void PrintTime(const std::string& measurement,
+               const std::string& trace,
+               base::TimeDelta elapsed,
+               bool important) {
+  perf_test::PrintResult(measurement, "", trace, elapsed.InMillisecondsF(),
+                         "ms", important);
+}
+
+}  // namespace
+
+// Measures how long the HistoryQuickProvider has to wait for a usable index of
+// a large history: after rebuilding it from the history database, after
+// restoring it from the cache file and, when the cache is stale, after
+// rebuilding it or restoring it to refresh it later. Compares the rebuild and
+// the restore on one thread and on several, and the refresh with a rebuild.
+TEST(InMemoryURLIndexPerfTest, TimeToUsableIndex) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  history::TestHistoryDatabase db;
+  ASSERT_EQ(sql::INIT_OK, db.Init(temp_dir.path().AppendASCII("History")));
+  PopulateHistoryDatabase(&db);
+  if (HasFatalFailure())
+    return;
+
+  std::set<std::string> scheme_whitelist;
+  scheme_whitelist.insert(url::kHttpScheme);
+  scheme_whitelist.insert(url::kHttpsScheme);
+  const size_t num_threads = std::min(
+      static_cast<size_t>(base::SysInfo::NumberOfProcessors()),
+      static_cast<size_t>(4));
+
+  // Rebuild from history. Reading the database is the same either way.
+  base::ElapsedTimer read_timer;
+  URLIndexPrivateData::RowsToIndex rows;
+  ASSERT_TRUE(
+      URLIndexPrivateData::ReadRowsFromHistory(&db, scheme_whitelist, &rows));
+  const base::TimeDelta read_time = read_timer.Elapsed();
+  PrintTime("read_history", "", read_time, false);
+  ASSERT_EQ(kNumUrls, rows.size());
+
+  base::ElapsedTimer serial_index_timer;
+  scoped_refptr<URLIndexPrivateData> serial_data =
+      URLIndexPrivateData::IndexRows(rows, 1);
+  const base::TimeDelta serial_rebuild_time =
+      read_time + serial_index_timer.Elapsed();
+  PrintTime("rebuild_from_history", "serial", serial_rebuild_time, true);
+
+  base::ElapsedTimer parallel_index_timer;
+  scoped_refptr<URLIndexPrivateData> parallel_data =
+      URLIndexPrivateData::IndexRows(rows, num_threads);
+  PrintTime("rebuild_from_history", "parallel",
+            read_time + parallel_index_timer.Elapsed(), true);
+  EXPECT_EQ(serial_data->word_list_, parallel_data->word_list_);
+  EXPECT_EQ(serial_data->history_info_map_.size(),
+            parallel_data->history_info_map_.size());
+
+  // Restore from the cache file.
+  const base::FilePath cache_path = temp_dir.path().AppendASCII("Cache");
+  ASSERT_TRUE(serial_data->SaveToFile(cache_path));
+  base::TimeDelta last_restore_time;
+  for (size_t threads : {static_cast<size_t>(1), num_threads}) {
+    const bool parallel = threads > 1;
+    base::ElapsedTimer restore_timer;
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(cache_path, &contents));
+    in_memory_url_index::InMemoryURLIndexCacheItem cache;
+    ASSERT_TRUE(cache.ParseFromString(contents));
+    scoped_refptr<URLIndexPrivateData> restored_data(new URLIndexPrivateData);
+    ASSERT_TRUE(restored_data->RestorePrivateData(cache, threads, threads));
+    const base::TimeDelta restore_time = restore_timer.Elapsed();
+    PrintTime("restore_from_cache", parallel ? "parallel" : "serial",
+              restore_time, true);
+    // The index is restored with |num_threads| threads last.
+    last_restore_time = restore_time;
+    EXPECT_EQ(serial_data->word_list_, restored_data->word_list_);
+    EXPECT_EQ(serial_data->history_info_map_.size(),
+              restored_data->history_info_map_.size());
+  }
+
+  // Bring a stale index up to date after some browsing.
+  BrowseHistoryDatabase(&db);
+  if (HasFatalFailure())
+    return;
+  scoped_refptr<URLIndexPrivateData> stale_data = serial_data->Duplicate();
+  base::ElapsedTimer refresh_timer;
+  ASSERT_TRUE(stale_data->RefreshFromHistory(&db, scheme_whitelist));
+  PrintTime("update_stale_index", "refresh", refresh_timer.Elapsed(), true);
+  base::ElapsedTimer rebuild_timer;
+  scoped_refptr<URLIndexPrivateData> rebuilt_data =
+      URLIndexPrivateData::RebuildFromHistory(&db, scheme_whitelist);
+  ASSERT_TRUE(rebuilt_data);
+  PrintTime("update_stale_index", "rebuild", rebuild_timer.Elapsed(), false);
+  EXPECT_EQ(rebuilt_data->history_info_map_.size(),
+            stale_data->history_info_map_.size());
+  EXPECT_EQ(rebuilt_data->word_map_.size(), stale_data->word_map_.size());
+
+  // A stale cache used to be thrown away and the index rebuilt from history
+  // before it could be searched; now it is searched while it is refreshed.
+  PrintTime("time_to_usable_index", "stale_cache_rebuilt", serial_rebuild_time,
+            false);
+  PrintTime("time_to_usable_index", "stale_cache_refreshed",
+            last_restore_time, true);
+}
@@ -1100,7 +1100,7 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
   ExpectPrivateDataEqual(*old_data.get(), new_data);
 }
 
-TEST_F(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld) {
+TEST_F(InMemoryURLIndexTest, RefreshFromHistoryIfCacheOld) {
   base::ScopedTempDir temp_directory;
   ASSERT_TRUE(temp_directory.CreateUniqueTempDir());
   set_history_dir(temp_directory.path());
@@ -1124,7 +1124,7 @@ TEST_F(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld) {
   EXPECT_EQ(0, private_data.restored_cache_version_);
 
   // Overwrite the build time so that we'll think the data is too old
-  // and rebuild the cache from history.
+  // and refresh the cache from history.
   const base::Time fake_rebuild_time =
       private_data.last_time_rebuilt_from_history_ -
       base::TimeDelta::FromDays(30);
@@ -1141,6 +1141,7 @@ TEST_F(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld) {
     PostSaveToCacheFileTask();
     run_loop.Run();
     EXPECT_TRUE(save_observer.succeeded());
+    url_index_->set_save_cache_observer(nullptr);
   }
 
   // Clear and then prove it's clear before restoring.
@@ -1161,13 +1162,23 @@ TEST_F(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld) {
     PostRestoreFromCacheFileTask();
     run_loop.Run();
     EXPECT_TRUE(restore_observer.succeeded());
+    url_index_->set_restore_cache_observer(nullptr);
   }
 
+  // The stale cache is restored, and so can be searched right away.
+  EXPECT_GT(GetPrivateData()->restored_cache_version_, 0);
+  EXPECT_EQ(fake_rebuild_time,
+            GetPrivateData()->last_time_rebuilt_from_history_);
+  ExpectPrivateDataEqual(*old_data.get(), *GetPrivateData());
+
+  // Wait for the refresh from history.
+  history::BlockUntilHistoryProcessesPendingRequests(history_service_.get());
+
   URLIndexPrivateData& new_data(*GetPrivateData());
 
-  // Make sure the data we have was rebuilt from history.  (Version 0
-  // means rebuilt from history; anything else means restored from
-  // a cache version.)
+  // Make sure the data we have was refreshed from history.  (Version 0
+  // means rebuilt or refreshed from history; anything else means restored
+  // from a cache version.)
   EXPECT_EQ(0, new_data.restored_cache_version_);
   EXPECT_NE(fake_rebuild_time, new_data.last_time_rebuilt_from_history_);
 
@@ -1175,6 +1186,128 @@ TEST_F(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld) {
   ExpectPrivateDataEqual(*old_data.get(), new_data);
 }
 
+TEST_F(InMemoryURLIndexTest, ParallelRebuild) {
+  // Index the rows one at a time, as they are read from history.
+  scoped_refptr<URLIndexPrivateData> expected_data(new URLIndexPrivateData);
+  history::URLDatabase::URLEnumerator history_enum;
+  ASSERT_TRUE(history_database_->InitURLEnumeratorForSignificant(
+      &history_enum));
+  for (history::URLRow row; history_enum.GetNextURL(&row);) {
+    expected_data->IndexRow(history_database_, nullptr, row,
+                            scheme_whitelist(), nullptr);
+  }
+
+  URLIndexPrivateData::RowsToIndex rows;
+  ASSERT_TRUE(URLIndexPrivateData::ReadRowsFromHistory(
+      history_database_, scheme_whitelist(), &rows));
+  EXPECT_EQ(expected_data->history_info_map_.size(), rows.size());
+
+  // Merging the shards gives the same word IDs as indexing in one pass.
+  for (size_t num_shards : {1u, 2u, 3u, 7u}) {
+    SCOPED_TRACE(num_shards);
+    scoped_refptr<URLIndexPrivateData> data =
+        URLIndexPrivateData::IndexRows(rows, num_shards);
+    ExpectPrivateDataNotEmpty(*data);
+    ExpectPrivateDataEqual(*expected_data, *data);
+  }
+}
+
+TEST_F(InMemoryURLIndexTest, ParallelRestore) {
+  URLIndexPrivateData& private_data(*GetPrivateData());
+  in_memory_url_index::InMemoryURLIndexCacheItem cache;
+  private_data.SavePrivateData(&cache);
+
+  for (size_t num_shards : {1u, 2u, 3u}) {
+    SCOPED_TRACE(num_shards);
+    scoped_refptr<URLIndexPrivateData> serial_data(new URLIndexPrivateData);
+    ASSERT_TRUE(serial_data->RestorePrivateData(cache, 1, num_shards));
+    ExpectPrivateDataEqual(private_data, *serial_data);
+
+    scoped_refptr<URLIndexPrivateData> parallel_data(new URLIndexPrivateData);
+    ASSERT_TRUE(parallel_data->RestorePrivateData(cache, 4, num_shards));
+    ExpectPrivateDataEqual(private_data, *parallel_data);
+  }
+
+  // The word starts are recalculated if the cache does not have them.
+  cache.clear_word_starts_map();
+  scoped_refptr<URLIndexPrivateData> data(new URLIndexPrivateData);
+  ASSERT_TRUE(data->RestorePrivateData(cache, 4, 3));
+  ExpectPrivateDataEqual(private_data, *data);
+
+  // A corrupt history info map fails the restore.
+  cache.mutable_history_info_map()->set_item_count(
+      cache.history_info_map().item_count() + 1);
+  data = new URLIndexPrivateData;
+  EXPECT_FALSE(data->RestorePrivateData(cache, 4, 3));
+}
+
+TEST_F(InMemoryURLIndexTest, RefreshFromHistory) {
+  // Change the title of a row.
+  const history::URLID changed_id = 3;
+  history::URLRow changed_row;
+  ASSERT_TRUE(history_database_->GetURLRow(changed_id, &changed_row));
+  changed_row.set_title(ASCIIToUTF16("Does eat oats and little lambs eat ivy"));
+  ASSERT_TRUE(history_database_->UpdateURLRow(changed_id, changed_row));
+
+  // Delete a row.
+  ScoredHistoryMatches matches = url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("DrudgeReport"), base::string16::npos, kMaxMatches);
+  ASSERT_EQ(1U, matches.size());
+  ASSERT_TRUE(history_database_->DeleteURLRow(matches[0].url_info.id()));
+
+  // Add a row.
+  history::URLRow new_row(GURL("http://www.brokeandaloneinmanitoba.com/"));
+  new_row.set_last_visit(base::Time::Now());
+  new_row.set_typed_count(1);
+  ASSERT_TRUE(history_database_->AddURL(new_row));
+
+  // Nothing changes until the index is refreshed.
+  EXPECT_TRUE(url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("does eat oats little lambs ivy"), base::string16::npos,
+      kMaxMatches).empty());
+  EXPECT_TRUE(url_index_->HistoryItemsForTerms(ASCIIToUTF16("brokeandalone"),
+                                               base::string16::npos,
+                                               kMaxMatches).empty());
+
+  URLIndexPrivateData& private_data(*GetPrivateData());
+  private_data.last_time_rebuilt_from_history_ -= base::TimeDelta::FromDays(30);
+  EXPECT_TRUE(private_data.NeedsRefreshFromHistory());
+  EXPECT_TRUE(
+      private_data.RefreshFromHistory(history_database_, scheme_whitelist()));
+  EXPECT_FALSE(private_data.NeedsRefreshFromHistory());
+
+  matches = url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("does eat oats little lambs ivy"), base::string16::npos,
+      kMaxMatches);
+  ASSERT_EQ(1U, matches.size());
+  EXPECT_EQ(changed_id, matches[0].url_info.id());
+  EXPECT_TRUE(url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("lebronomics could high taxes influence"),
+      base::string16::npos, kMaxMatches).empty());
+  EXPECT_TRUE(url_index_->HistoryItemsForTerms(ASCIIToUTF16("DrudgeReport"),
+                                               base::string16::npos,
+                                               kMaxMatches).empty());
+  EXPECT_EQ(1U, url_index_->HistoryItemsForTerms(ASCIIToUTF16("brokeandalone"),
+                                                 base::string16::npos,
+                                                 kMaxMatches).size());
+
+  // The refreshed index has the same rows and words as a rebuilt one.
+  scoped_refptr<URLIndexPrivateData> rebuilt_data =
+      URLIndexPrivateData::RebuildFromHistory(history_database_,
+                                              scheme_whitelist());
+  ASSERT_TRUE(rebuilt_data);
+  EXPECT_EQ(rebuilt_data->history_info_map_.size(),
+            private_data.history_info_map_.size());
+  EXPECT_EQ(rebuilt_data->history_id_word_map_.size(),
+            private_data.history_id_word_map_.size());
+  EXPECT_EQ(rebuilt_data->word_map_.size(), private_data.word_map_.size());
+  EXPECT_EQ(rebuilt_data->char_word_map_.size(),
+            private_data.char_word_map_.size());
+  EXPECT_EQ(rebuilt_data->word_list_.size(),
+            private_data.word_list_.size() -
+                private_data.available_words_.size());
+}
+
 TEST_F(InMemoryURLIndexTest, AddHistoryMatch) {
   const struct {
     const char* search_string;
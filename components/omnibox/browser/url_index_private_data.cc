@@ -6,21 +6,28 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <string>
 #include <vector>
 
+#include "base/bind.h"
+#include "base/callback.h"
 #include "base/files/file_util.h"
 #include "base/i18n/break_iterator.h"
 #include "base/i18n/case_conversion.h"
 #include "base/macros.h"
+#include "base/memory/ptr_util.h"
 #include "base/metrics/histogram.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "components/bookmarks/browser/bookmark_model.h"
 #include "components/bookmarks/browser/bookmark_utils.h"
@@ -43,8 +50,90 @@ using in_memory_url_index::InMemoryURLIndexCacheItem;
 
 namespace {
 static const size_t kMaxVisitsToStoreInCache = 10u;
+
+// The most threads used to rebuild the index or restore it from the cache.
+const size_t kMaxIndexingThreads = 4u;
+
+// The fewest rows indexed, or history info map entries restored, by a thread.
+// Starting a thread costs more than indexing fewer rows.
+const size_t kMinRowsPerShard = 1000u;
+
+// Copies from |recent_visits| the only fields the index needs, up to
+// kMaxVisitsToStoreInCache of them.
+void CopyRecentVisits(const history::VisitVector& recent_visits,
+                      VisitInfoVector* visits) {
+  visits->clear();
+  const size_t size = std::min(recent_visits.size(), kMaxVisitsToStoreInCache);
+  visits->reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    visits->push_back(std::make_pair(recent_visits[i].visit_time,
+                                     recent_visits[i].transition));
+  }
+}
+
+size_t NumIndexingThreads() {
+  return std::min(static_cast<size_t>(base::SysInfo::NumberOfProcessors()),
+                  kMaxIndexingThreads);
+}
+
+// Returns the number of parts |num_rows| rows are split into to be processed
+// by up to |num_threads| threads.
+size_t NumShards(size_t num_rows, size_t num_threads) {
+  return std::max<size_t>(1u,
+                          std::min(num_threads, num_rows / kMinRowsPerShard));
 }
 
+// Runs a task of RunInParallel() and records whether it succeeded.
+class ParallelTask : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit ParallelTask(const base::Callback<bool()>& task)
+      : task_(task), succeeded_(false) {}
+
+  // base::DelegateSimpleThread::Delegate:
+  void Run() override { succeeded_ = task_.Run(); }
+
+  bool succeeded() const { return succeeded_; }
+
+ private:
+  const base::Callback<bool()> task_;
+  bool succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelTask);
+};
+
+// Runs |tasks| on up to |num_threads| threads and returns whether they all
+// succeeded. With a single thread, the tasks run in order on the calling
+// thread and stop at the first failure. The tasks must not touch the same
+// data.
+bool RunInParallel(const std::vector<base::Callback<bool()>>& tasks,
+                   size_t num_threads) {
+  if (num_threads <= 1 || tasks.size() <= 1) {
+    for (const base::Callback<bool()>& task : tasks) {
+      if (!task.Run())
+        return false;
+    }
+    return true;
+  }
+
+  std::vector<std::unique_ptr<ParallelTask>> parallel_tasks;
+  base::DelegateSimpleThreadPool pool(
+      "URLIndexPrivateData",
+      static_cast<int>(std::min(num_threads, tasks.size())));
+  for (const base::Callback<bool()>& task : tasks) {
+    parallel_tasks.push_back(base::MakeUnique<ParallelTask>(task));
+    pool.AddWork(parallel_tasks.back().get());
+  }
+  pool.Start();
+  pool.JoinAll();
+  for (const std::unique_ptr<ParallelTask>& task : parallel_tasks) {
+    if (!task->succeeded())
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 typedef in_memory_url_index::InMemoryURLIndexCacheItem_WordListItem
     WordListItem;
 typedef in_memory_url_index::InMemoryURLIndexCacheItem_WordMapItem_WordMapEntry
@@ -352,18 +441,8 @@ void URLIndexPrivateData::UpdateRecentVisits(
     history::URLID url_id,
     const history::VisitVector& recent_visits) {
   HistoryInfoMap::iterator row_pos = history_info_map_.find(url_id);
-  if (row_pos != history_info_map_.end()) {
-    VisitInfoVector* visits = &row_pos->second.visits;
-    visits->clear();
-    const size_t size =
-        std::min(recent_visits.size(), kMaxVisitsToStoreInCache);
-    visits->reserve(size);
-    for (size_t i = 0; i < size; i++) {
-      // Copy from the history::VisitVector the only fields visits needs.
-      visits->push_back(std::make_pair(recent_visits[i].visit_time,
-                                       recent_visits[i].transition));
-    }
-  }
+  if (row_pos != history_info_map_.end())
+    CopyRecentVisits(recent_visits, &row_pos->second.visits);
   // Else: Oddly, the URL doesn't seem to exist in the private index.
   // Ignore this update.  This can happen if, for instance, the user
   // removes the URL from URLIndexPrivateData before the historyDB call
@@ -426,7 +505,11 @@ scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RestoreFromFile(
     return restored_data;
   }
 
-  if (!restored_data->RestorePrivateData(index_cache))
+  const size_t num_threads = NumIndexingThreads();
+  const size_t num_shards = NumShards(
+      index_cache.history_info_map().history_info_map_entry_size(),
+      num_threads);
+  if (!restored_data->RestorePrivateData(index_cache, num_threads, num_shards))
     return nullptr;
 
   UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexRestoreCacheTime",
@@ -452,16 +535,13 @@ scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RebuildFromHistory(
 
   base::TimeTicks beginning_time = base::TimeTicks::Now();
 
-  scoped_refptr<URLIndexPrivateData>
-      rebuilt_data(new URLIndexPrivateData);
-  history::URLDatabase::URLEnumerator history_enum;
-  if (!history_db->InitURLEnumeratorForSignificant(&history_enum))
+  const base::Time rebuild_time = base::Time::Now();
+  RowsToIndex rows;
+  if (!ReadRowsFromHistory(history_db, scheme_whitelist, &rows))
     return nullptr;
-  rebuilt_data->last_time_rebuilt_from_history_ = base::Time::Now();
-  for (history::URLRow row; history_enum.GetNextURL(&row);) {
-    rebuilt_data->IndexRow(
-        history_db, nullptr, row, scheme_whitelist, nullptr);
-  }
+  scoped_refptr<URLIndexPrivateData> rebuilt_data =
+      IndexRows(rows, NumShards(rows.size(), NumIndexingThreads()));
+  rebuilt_data->last_time_rebuilt_from_history_ = rebuild_time;
 
   UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexingTime",
                       base::TimeTicks::Now() - beginning_time);
@@ -474,6 +554,61 @@ scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RebuildFromHistory(
   return rebuilt_data;
 }
 
+bool URLIndexPrivateData::RefreshFromHistory(
+    history::HistoryDatabase* history_db,
+    const std::set<std::string>& scheme_whitelist) {
+  if (!history_db)
+    return false;
+
+  const base::Time refresh_time = base::Time::Now();
+  history::URLDatabase::URLEnumerator history_enum;
+  if (!history_db->InitURLEnumeratorForSignificant(&history_enum))
+    return false;
+  HistoryIDSet indexed_ids;
+  for (history::URLRow row; history_enum.GetNextURL(&row);) {
+    HistoryID history_id = static_cast<HistoryID>(row.id());
+    HistoryInfoMap::const_iterator row_pos = history_info_map_.find(history_id);
+    if (row_pos != history_info_map_.end()) {
+      // The URL of a row never changes, and neither do its visits unless its
+      // visit count or last visit do.
+      const history::URLRow& indexed_row = row_pos->second.url_row;
+      if (indexed_row.visit_count() == row.visit_count() &&
+          indexed_row.typed_count() == row.typed_count() &&
+          indexed_row.last_visit() == row.last_visit() &&
+          indexed_row.title() == row.title()) {
+        indexed_ids.insert(history_id);
+        continue;
+      }
+      RemoveRowFromIndex(row);
+    }
+    if (IndexRow(history_db, nullptr, row, scheme_whitelist, nullptr))
+      indexed_ids.insert(history_id);
+  }
+
+  // Remove the rows which were deleted or expired, or are no longer
+  // significant.
+  std::vector<history::URLRow> rows_to_remove;
+  for (const auto& entry : history_info_map_) {
+    if (indexed_ids.find(entry.first) == indexed_ids.end())
+      rows_to_remove.push_back(entry.second.url_row);
+  }
+  for (const history::URLRow& row : rows_to_remove)
+    RemoveRowFromIndex(row);
+
+  last_time_rebuilt_from_history_ = refresh_time;
+  search_term_cache_.clear();  // This invalidates the cache.
+  return true;
+}
+
+bool URLIndexPrivateData::NeedsRefreshFromHistory() const {
+  const base::TimeDelta rebuilt_ago =
+      base::Time::Now() - last_time_rebuilt_from_history_;
+  // Allow one day in the future to not refresh on simple system clock changes
+  // such as time zone changes.
+  return rebuilt_ago > base::TimeDelta::FromDays(7) ||
+         rebuilt_ago < base::TimeDelta::FromDays(-1);
+}
+
 // static
 bool URLIndexPrivateData::WritePrivateDataToCacheFileTask(
     scoped_refptr<URLIndexPrivateData> private_data,
@@ -700,12 +835,38 @@ bool URLIndexPrivateData::IndexRow(
     const history::URLRow& row,
     const std::set<std::string>& scheme_whitelist,
     base::CancelableTaskTracker* tracker) {
-  const GURL& gurl(row.url());
-
   // Index only URLs with a whitelisted scheme.
-  if (!URLSchemeIsWhitelisted(gurl, scheme_whitelist))
+  if (!URLSchemeIsWhitelisted(row.url(), scheme_whitelist))
     return false;
 
+  AddRowToIndex(row);
+
+  // Update the recent visits information or schedule the update
+  // as appropriate.
+  history::URLID row_id = row.id();
+  if (history_db) {
+    // We'd like to check that we're on the history DB thread.
+    // However, unittest code actually calls this on the UI thread.
+    // So we don't do any thread checks.
+    history::VisitVector recent_visits;
+    // Make sure the private data is going to get as many recent visits as
+    // ScoredHistoryMatch::GetFrequency() hopes to use.
+    DCHECK_GE(kMaxVisitsToStoreInCache, ScoredHistoryMatch::kMaxVisitsToScore);
+    if (history_db->GetMostRecentVisitsForURL(row_id,
+                                              kMaxVisitsToStoreInCache,
+                                              &recent_visits))
+      UpdateRecentVisits(row_id, recent_visits);
+  } else {
+    DCHECK(tracker);
+    DCHECK(history_service);
+    ScheduleUpdateRecentVisits(history_service, row_id, tracker);
+  }
+
+  return true;
+}
+
+void URLIndexPrivateData::AddRowToIndex(const history::URLRow& row) {
+  const GURL& gurl(row.url());
   history::URLID row_id = row.id();
   // Strip out username and password before saving and indexing.
   base::string16 url(url_formatter::FormatUrl(
@@ -727,30 +888,106 @@ bool URLIndexPrivateData::IndexRow(
   RowWordStarts word_starts;
   AddRowWordsToIndex(new_row, &word_starts);
   word_starts_map_[history_id] = word_starts;
+}
 
-  // Update the recent visits information or schedule the update
-  // as appropriate.
-  if (history_db) {
-    // We'd like to check that we're on the history DB thread.
-    // However, unittest code actually calls this on the UI thread.
-    // So we don't do any thread checks.
-    history::VisitVector recent_visits;
-    // Make sure the private data is going to get as many recent visits as
-    // ScoredHistoryMatch::GetFrequency() hopes to use.
-    DCHECK_GE(kMaxVisitsToStoreInCache, ScoredHistoryMatch::kMaxVisitsToScore);
-    if (history_db->GetMostRecentVisitsForURL(row_id,
+// static
+bool URLIndexPrivateData::ReadRowsFromHistory(
+    history::HistoryDatabase* history_db,
+    const std::set<std::string>& scheme_whitelist,
+    RowsToIndex* rows) {
+  history::URLDatabase::URLEnumerator history_enum;
+  if (!history_db->InitURLEnumeratorForSignificant(&history_enum))
+    return false;
+  // Make sure the private data is going to get as many recent visits as
+  // ScoredHistoryMatch::GetFrequency() hopes to use.
+  DCHECK_GE(kMaxVisitsToStoreInCache, ScoredHistoryMatch::kMaxVisitsToScore);
+  history::VisitVector recent_visits;
+  for (history::URLRow row; history_enum.GetNextURL(&row);) {
+    if (!URLSchemeIsWhitelisted(row.url(), scheme_whitelist))
+      continue;
+    rows->push_back(RowToIndex());
+    rows->back().row = row;
+    recent_visits.clear();
+    if (history_db->GetMostRecentVisitsForURL(row.id(),
                                               kMaxVisitsToStoreInCache,
                                               &recent_visits))
-      UpdateRecentVisits(row_id, recent_visits);
-  } else {
-    DCHECK(tracker);
-    DCHECK(history_service);
-    ScheduleUpdateRecentVisits(history_service, row_id, tracker);
+      CopyRecentVisits(recent_visits, &rows->back().visits);
   }
+  return true;
+}
 
+// static
+scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::IndexRows(
+    const RowsToIndex& rows,
+    size_t num_shards) {
+  DCHECK_GE(num_shards, 1u);
+  std::vector<scoped_refptr<URLIndexPrivateData>> shards;
+  std::vector<base::Callback<bool()>> tasks;
+  for (size_t i = 0; i < num_shards; ++i) {
+    shards.push_back(new URLIndexPrivateData);
+    tasks.push_back(base::Bind(&URLIndexPrivateData::IndexRowRange,
+                               base::Unretained(shards.back().get()), &rows,
+                               rows.size() * i / num_shards,
+                               rows.size() * (i + 1) / num_shards));
+  }
+  RunInParallel(tasks, num_shards);
+  for (size_t i = 1; i < num_shards; ++i)
+    shards[0]->MergeShard(*shards[i]);
+  return shards[0];
+}
+
+bool URLIndexPrivateData::IndexRowRange(const RowsToIndex* rows,
+                                        size_t begin,
+                                        size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    const RowToIndex& row_to_index = (*rows)[i];
+    AddRowToIndex(row_to_index.row);
+    history_info_map_[static_cast<HistoryID>(row_to_index.row.id())].visits =
+        row_to_index.visits;
+  }
   return true;
 }
 
+void URLIndexPrivateData::MergeShard(const URLIndexPrivateData& shard) {
+  // Both indexes were freshly built, so no word was ever removed from them.
+  DCHECK(available_words_.empty());
+  DCHECK(shard.available_words_.empty());
+
+  // Map the word IDs of |shard| to those of this index, adding its new words.
+  std::vector<WordID> word_ids(shard.word_list_.size());
+  for (WordID shard_word_id = 0; shard_word_id < shard.word_list_.size();
+       ++shard_word_id) {
+    const base::string16& word = shard.word_list_[shard_word_id];
+    WordMap::const_iterator word_pos = word_map_.find(word);
+    if (word_pos != word_map_.end()) {
+      word_ids[shard_word_id] = word_pos->second;
+      continue;
+    }
+    const WordID word_id = word_list_.size();
+    word_list_.push_back(word);
+    word_map_[word] = word_id;
+    word_ids[shard_word_id] = word_id;
+    Char16Set characters = Char16SetFromString16(word);
+    for (base::char16 uni_char : characters)
+      char_word_map_[uni_char].insert(word_id);
+  }
+
+  for (const auto& entry : shard.word_id_history_map_) {
+    HistoryIDSet& history_id_set = word_id_history_map_[word_ids[entry.first]];
+    history_id_set.insert(entry.second.begin(), entry.second.end());
+  }
+  for (const auto& entry : shard.history_id_word_map_) {
+    WordIDSet& word_id_set = history_id_word_map_[entry.first];
+    for (WordID shard_word_id : entry.second)
+      word_id_set.insert(word_ids[shard_word_id]);
+  }
+  history_info_map_.insert(shard.history_info_map_.begin(),
+                           shard.history_info_map_.end());
+  word_starts_map_.insert(shard.word_starts_map_.begin(),
+                          shard.word_starts_map_.end());
+  search_term_cache_.clear();  // Invalidate the term cache.
+}
+
 void URLIndexPrivateData::AddRowWordsToIndex(const history::URLRow& row,
                                              RowWordStarts* word_starts) {
   HistoryID history_id = static_cast<HistoryID>(row.id());
@@ -1040,20 +1277,15 @@ void URLIndexPrivateData::SaveWordStartsMap(
 }
 
 bool URLIndexPrivateData::RestorePrivateData(
-    const InMemoryURLIndexCacheItem& cache) {
+    const InMemoryURLIndexCacheItem& cache,
+    size_t num_threads,
+    size_t num_shards) {
+  DCHECK_GE(num_shards, 1u);
+  // A cache more than a week old or, somehow, from some time in the future is
+  // still restored, so that it can be searched while InMemoryURLIndex
+  // refreshes it from history (see NeedsRefreshFromHistory()).
   last_time_rebuilt_from_history_ =
       base::Time::FromInternalValue(cache.last_rebuild_timestamp());
-  const base::TimeDelta rebuilt_ago =
-      base::Time::Now() - last_time_rebuilt_from_history_;
-  if ((rebuilt_ago > base::TimeDelta::FromDays(7)) ||
-      (rebuilt_ago < base::TimeDelta::FromDays(-1))) {
-    // Cache is more than a week old or, somehow, from some time in the future.
-    // It's probably a good time to rebuild the index from history to
-    // allow synced entries to now appear, expired entries to disappear, etc.
-    // Allow one day in the future to make the cache not rebuild on simple
-    // system clock changes such as time zone changes.
-    return false;
-  }
   if (cache.has_version()) {
     if (cache.version() < kCurrentCacheFileVersion) {
       // Don't try to restore an old format cache file.  (This will cause
@@ -1063,9 +1295,44 @@ bool URLIndexPrivateData::RestorePrivateData(
     }
     restored_cache_version_ = cache.version();
   }
-  return RestoreWordList(cache) && RestoreWordMap(cache) &&
-      RestoreCharWordMap(cache) && RestoreWordIDHistoryMap(cache) &&
-      RestoreHistoryInfoMap(cache) && RestoreWordStartsMap(cache);
+
+  // Each map is restored by its own task, and the history info map, which
+  // takes the longest, in contiguous parts which are then merged.
+  std::vector<base::Callback<bool()>> tasks;
+  tasks.push_back(base::Bind(&URLIndexPrivateData::RestoreWordList,
+                             base::Unretained(this), base::ConstRef(cache)));
+  tasks.push_back(base::Bind(&URLIndexPrivateData::RestoreWordMap,
+                             base::Unretained(this), base::ConstRef(cache)));
+  tasks.push_back(base::Bind(&URLIndexPrivateData::RestoreCharWordMap,
+                             base::Unretained(this), base::ConstRef(cache)));
+  tasks.push_back(base::Bind(&URLIndexPrivateData::RestoreWordIDHistoryMap,
+                             base::Unretained(this), base::ConstRef(cache)));
+  const int num_entries =
+      cache.history_info_map().history_info_map_entry_size();
+  std::vector<HistoryInfoMap> history_info_maps(num_shards);
+  for (size_t i = 0; i < num_shards; ++i) {
+    tasks.push_back(base::Bind(
+        &URLIndexPrivateData::RestoreHistoryInfoMap, base::ConstRef(cache),
+        static_cast<int>(num_entries * i / num_shards),
+        static_cast<int>(num_entries * (i + 1) / num_shards),
+        &history_info_maps[i]));
+  }
+  // Without word starts in the cache, they are recalculated from the history
+  // info map once it is complete.
+  const bool has_word_starts_map = cache.has_word_starts_map();
+  if (has_word_starts_map) {
+    tasks.push_back(base::Bind(&URLIndexPrivateData::RestoreWordStartsMap,
+                               base::Unretained(this), base::ConstRef(cache)));
+  }
+  if (!RunInParallel(tasks, num_threads))
+    return false;
+
+  history_info_map_.swap(history_info_maps[0]);
+  for (size_t i = 1; i < num_shards; ++i) {
+    history_info_map_.insert(history_info_maps[i].begin(),
+                             history_info_maps[i].end());
+  }
+  return has_word_starts_map || RestoreWordStartsMap(cache);
 }
 
 bool URLIndexPrivateData::RestoreWordList(
@@ -1158,8 +1425,12 @@ bool URLIndexPrivateData::RestoreWordIDHistoryMap(
   return true;
 }
 
+// static
 bool URLIndexPrivateData::RestoreHistoryInfoMap(
-    const InMemoryURLIndexCacheItem& cache) {
+    const InMemoryURLIndexCacheItem& cache,
+    int begin,
+    int end,
+    HistoryInfoMap* history_info_map) {
   if (!cache.has_history_info_map())
     return false;
   const HistoryInfoMapItem& list_item(cache.history_info_map());
@@ -1169,8 +1440,9 @@ bool URLIndexPrivateData::RestoreHistoryInfoMap(
     return false;
   const RepeatedPtrField<HistoryInfoMapEntry>&
       entries(list_item.history_info_map_entry());
+  history_info_map->reserve(end - begin);
   for (RepeatedPtrField<HistoryInfoMapEntry>::const_iterator iter =
-       entries.begin(); iter != entries.end(); ++iter) {
+       entries.begin() + begin; iter != entries.begin() + end; ++iter) {
     HistoryID history_id = iter->history_id();
     GURL url(iter->url());
     history::URLRow url_row(url, history_id);
@@ -1181,7 +1453,7 @@ bool URLIndexPrivateData::RestoreHistoryInfoMap(
       base::string16 title(base::UTF8ToUTF16(iter->title()));
       url_row.set_title(title);
     }
-    history_info_map_[history_id].url_row = url_row;
+    (*history_info_map)[history_id].url_row = url_row;
 
     // Restore visits list.
     VisitInfoVector visits;
@@ -1191,16 +1463,16 @@ bool URLIndexPrivateData::RestoreHistoryInfoMap(
           base::Time::FromInternalValue(iter->visits(i).visit_time()),
           ui::PageTransitionFromInt(iter->visits(i).transition_type())));
     }
-    history_info_map_[history_id].visits = visits;
+    (*history_info_map)[history_id].visits = visits;
   }
   return true;
 }
 
 bool URLIndexPrivateData::RestoreWordStartsMap(
     const InMemoryURLIndexCacheItem& cache) {
-  // Note that this function must be called after RestoreHistoryInfoMap() has
-  // been run as the word starts may have to be recalculated from the urls and
-  // page titles.
+  // Note that this function must be called after the history info map has
+  // been restored if the cache has no word starts, as they then have to be
+  // recalculated from the urls and page titles.
   if (cache.has_word_starts_map()) {
     const WordStartsMapItem& list_item(cache.word_starts_map());
     uint32_t expected_item_count = list_item.item_count();
@@ -1252,6 +1524,14 @@ bool URLIndexPrivateData::URLSchemeIsWhitelisted(
 }
 
 
+// RowToIndex ------------------------------------------------------------------
+
+URLIndexPrivateData::RowToIndex::RowToIndex() {}
+
+URLIndexPrivateData::RowToIndex::RowToIndex(const RowToIndex& other) = default;
+
+URLIndexPrivateData::RowToIndex::~RowToIndex() {}
+
 // SearchTermCacheItem ---------------------------------------------------------
 
 URLIndexPrivateData::SearchTermCacheItem::SearchTermCacheItem(
@@ -9,6 +9,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/gtest_prod_util.h"
@@ -109,7 +110,9 @@ class URLIndexPrivateData
 
   // Constructs a new object by restoring its contents from the cache file
   // at |path|. Returns the new URLIndexPrivateData which on success will
-  // contain the restored data but upon failure will be empty.
+  // contain the restored data but upon failure will be empty. The maps of the
+  // cache are decoded in parallel, the history info map in several parts
+  // which are then merged.
   // This function should be run on the the file thread.
   static scoped_refptr<URLIndexPrivateData> RestoreFromFile(
       const base::FilePath& path);
@@ -117,10 +120,26 @@ class URLIndexPrivateData
   // Constructs a new object by rebuilding its contents from the history
   // database in |history_db|. Returns the new URLIndexPrivateData which on
   // success will contain the rebuilt data but upon failure will be empty.
+  // The rows are read from |history_db| on the calling thread, then indexed
+  // in parallel in contiguous shards which are merged into the same index a
+  // single pass would build.
   static scoped_refptr<URLIndexPrivateData> RebuildFromHistory(
       history::HistoryDatabase* history_db,
       const std::set<std::string>& scheme_whitelist);
 
+  // Brings the index up to date with the history database in |history_db|:
+  // rows which changed since they were indexed are re-indexed, new rows are
+  // added and rows which are no longer significant are removed. Returns false
+  // if |history_db| cannot be read. Like RebuildFromHistory(), this runs on
+  // the history DB thread, so it must be given data not in use elsewhere.
+  bool RefreshFromHistory(history::HistoryDatabase* history_db,
+                          const std::set<std::string>& scheme_whitelist);
+
+  // Returns true if the data was last rebuilt or refreshed from the history
+  // database long enough ago, or so far in the future, that it should be
+  // refreshed to let synced entries appear and expired entries disappear.
+  bool NeedsRefreshFromHistory() const;
+
   // Writes |private_data| as a cache file to |file_path| and returns success.
   static bool WritePrivateDataToCacheFileTask(
       scoped_refptr<URLIndexPrivateData> private_data,
@@ -143,11 +162,15 @@ class URLIndexPrivateData
   friend class AddHistoryMatch;
   friend class ::HistoryQuickProviderTest;
   friend class InMemoryURLIndexTest;
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexPerfTest, TimeToUsableIndex);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, AddHistoryMatch);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheSaveRestore);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, HugeResultSet);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, ParallelRebuild);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, ParallelRestore);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, ReadVisitsFromHistory);
-  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, RebuildFromHistoryIfCacheOld);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, RefreshFromHistory);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, RefreshFromHistoryIfCacheOld);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, Scoring);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, TitleSearch);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, TypedCharacterCaching);
@@ -229,6 +252,18 @@ class URLIndexPrivateData
     const HistoryInfoMap& history_info_map_;
   };
 
+  // A significant row of the history database, with a whitelisted scheme,
+  // and its most recent visits.
+  struct RowToIndex {
+    RowToIndex();
+    RowToIndex(const RowToIndex& other);
+    ~RowToIndex();
+
+    history::URLRow row;
+    VisitInfoVector visits;
+  };
+  typedef std::vector<RowToIndex> RowsToIndex;
+
   // URL History indexing support functions.
 
   // Composes a set of history item IDs by intersecting the set for each word
@@ -256,6 +291,31 @@ class URLIndexPrivateData
                 const std::set<std::string>& scheme_whitelist,
                 base::CancelableTaskTracker* tracker);
 
+  // Adds |row| to the history info map and its words to the index. Does not
+  // check its scheme nor touch its visits.
+  void AddRowToIndex(const history::URLRow& row);
+
+  // Reads the rows to index from |history_db| into |rows|, in the order of
+  // the database. Returns false if |history_db| cannot be read.
+  static bool ReadRowsFromHistory(history::HistoryDatabase* history_db,
+                                  const std::set<std::string>& scheme_whitelist,
+                                  RowsToIndex* rows);
+
+  // Returns a new index of |rows|, built in |num_shards| contiguous shards
+  // which are indexed in parallel, then merged.
+  static scoped_refptr<URLIndexPrivateData> IndexRows(const RowsToIndex& rows,
+                                                      size_t num_shards);
+
+  // Indexes |rows| from |begin| to |end|. Always returns true, to run as a
+  // parallel task.
+  bool IndexRowRange(const RowsToIndex* rows, size_t begin, size_t end);
+
+  // Adds the rows indexed in |shard|, which follow those already indexed.
+  // Words new to this index are given IDs in the order |shard| added them, so
+  // that merging the shards of a list of rows in order gives the same word
+  // IDs as indexing the list in one pass.
+  void MergeShard(const URLIndexPrivateData& shard);
+
   // Parses and indexes the words in the URL and page title of |row| and
   // calculate the word starts in each, saving the starts in |word_starts|.
   void AddRowWordsToIndex(const history::URLRow& row,
@@ -306,9 +366,12 @@ class URLIndexPrivateData
       in_memory_url_index::InMemoryURLIndexCacheItem* cache) const;
 
   // Decode a data structure from the protobuf |cache|. Return false if there
-  // is any kind of failure.
+  // is any kind of failure. RestorePrivateData() decodes the maps with up to
+  // |num_threads| threads, the history info map in |num_shards| parts.
   bool RestorePrivateData(
-      const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
+      const in_memory_url_index::InMemoryURLIndexCacheItem& cache,
+      size_t num_threads,
+      size_t num_shards);
   bool RestoreWordList(
       const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
   bool RestoreWordMap(
@@ -317,8 +380,13 @@ class URLIndexPrivateData
       const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
   bool RestoreWordIDHistoryMap(
       const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
-  bool RestoreHistoryInfoMap(
-      const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
+  // Restores the entries of the history info map from |begin| to |end| into
+  // |history_info_map|.
+  static bool RestoreHistoryInfoMap(
+      const in_memory_url_index::InMemoryURLIndexCacheItem& cache,
+      int begin,
+      int end,
+      HistoryInfoMap* history_info_map);
   bool RestoreWordStartsMap(
       const in_memory_url_index::InMemoryURLIndexCacheItem& cache);
 
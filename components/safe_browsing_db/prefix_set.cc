@@ -5,6 +5,7 @@
 #include "components/safe_browsing_db/prefix_set.h"
 
 #include <limits.h>
+#include <string.h>
 
 #include <algorithm>
 #include <utility>
@@ -16,6 +17,11 @@
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram.h"
 #include "base/metrics/sparse_histogram.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
 
 namespace safe_browsing {
 
@@ -45,6 +51,9 @@ typedef struct {
   uint32_t full_hashes_size;
 } FileHeader;
 
+// Size of a cache line, on which |PrefixSet::offsets_| is aligned.
+const size_t kCacheLineBytes = 64;
+
 // Common std::vector<> implementations add capacity by multiplying from the
 // current size (usually either by 2 or 1.5) to satisfy push_back() running in
 // amortized constant time.  This is not necessary for insert() at end(), but
@@ -80,6 +89,24 @@ size_t EstimateFinalCount(SBPrefix current_prefix, size_t current_count) {
   return estimated_prefix_count + estimated_prefix_count / 100;
 }
 
+// Returns true if |offset| is in the |end - begin| offsets at |begin|, which
+// are a multiple of 8 aligned on 16 bytes.
+bool OffsetsContain(const uint16_t* begin, const uint16_t* end,
+                    uint16_t offset) {
+#if defined(ARCH_CPU_X86_FAMILY)
+  const __m128i needle = _mm_set1_epi16(static_cast<int16_t>(offset));
+  __m128i matches = _mm_setzero_si128();
+  for (const uint16_t* group = begin; group != end; group += 8) {
+    const __m128i offsets =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi16(offsets, needle));
+  }
+  return _mm_movemask_epi8(matches) != 0;
+#else
+  return std::find(begin, end, offset) != end;
+#endif
+}
+
 }  // namespace
 
 // For |std::upper_bound()| to find a prefix w/in a vector of pairs.
@@ -88,50 +115,83 @@ bool PrefixSet::PrefixLess(const IndexPair& a, const IndexPair& b) {
   return a.first < b.first;
 }
 
-PrefixSet::PrefixSet() {
-}
-
 PrefixSet::PrefixSet(IndexVector* index,
-                     std::vector<uint16_t>* deltas,
-                     std::vector<SBFullHash>* full_hashes) {
-  DCHECK(index && deltas && full_hashes);
+                     const std::vector<uint16_t>& offsets,
+                     std::vector<SBFullHash>* full_hashes)
+    : offsets_size_(offsets.size()), directory_shift_(0) {
+  DCHECK(index && full_hashes);
+  DCHECK_EQ(0u, offsets_size_ % kGroupSize);
   index_.swap(*index);
-  deltas_.swap(*deltas);
   full_hashes_.swap(*full_hashes);
+  if (offsets_size_) {
+    const size_t offsets_bytes = sizeof(offsets[0]) * offsets_size_;
+    offsets_.reset(static_cast<uint16_t*>(
+        base::AlignedAlloc(offsets_bytes, kCacheLineBytes)));
+    memcpy(offsets_.get(), offsets.data(), offsets_bytes);
+  }
+
+  if (index_.empty())
+    return;
+
+  // Use the smallest directory with at most |kEntriesPerBucket| entries per
+  // bucket on average.
+  size_t bits = 1;
+  while (bits < 24 && (index_.size() >> bits) > kEntriesPerBucket)
+    ++bits;
+  directory_shift_ = 32 - bits;
+  const size_t bucket_count = static_cast<size_t>(1) << bits;
+  directory_.resize(bucket_count + 1);
+  size_t ii = 0;
+  for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+    while (ii < index_.size() && index_[ii].first >> directory_shift_ < bucket)
+      ++ii;
+    directory_[bucket] = static_cast<uint32_t>(ii);
+  }
+  directory_[bucket_count] = static_cast<uint32_t>(index_.size());
 }
 
 PrefixSet::~PrefixSet() {}
 
-bool PrefixSet::PrefixExists(SBPrefix prefix) const {
-  if (index_.empty())
-    return false;
+PrefixSet::IndexVector::const_iterator PrefixSet::FindEntry(
+    SBPrefix prefix) const {
+  DCHECK(!index_.empty());
 
-  // Find the first position after |prefix| in |index_|.
-  IndexVector::const_iterator iter =
-      std::upper_bound(index_.begin(), index_.end(),
-                       IndexPair(prefix, 0), PrefixLess);
+  // Find the first position after |prefix| in |index_|, which is within the
+  // bucket of |prefix| or at its end.
+  const size_t bucket = prefix >> directory_shift_;
+  return std::upper_bound(index_.begin() + directory_[bucket],
+                          index_.begin() + directory_[bucket + 1],
+                          IndexPair(prefix, 0), PrefixLess);
+}
 
+bool PrefixSet::EntryContains(IndexVector::const_iterator iter,
+                              SBPrefix prefix) const {
   // |prefix| comes before anything that's in the set.
   if (iter == index_.begin())
     return false;
 
-  // Capture the upper bound of our target entry's deltas.
-  const size_t bound = (iter == index_.end() ? deltas_.size() : iter->second);
+  // Capture the upper bound of our target entry's offsets.
+  const size_t bound = (iter == index_.end() ? offsets_size_ : iter->second);
 
   // Back up to the entry our target is in.
   --iter;
 
-  // All prefixes in |index_| are in the set.
-  SBPrefix current = iter->first;
-  if (current == prefix)
+  // All prefixes in |index_| are in the set, and the others are at most
+  // 2^16 - 1 above one.
+  const uint32_t offset = prefix - iter->first;
+  if (offset == 0)
     return true;
+  if (offset > 0xFFFF)
+    return false;
 
-  // Scan forward accumulating deltas while a match is possible.
-  for (size_t di = iter->second; di < bound && current < prefix; ++di) {
-    current += deltas_[di];
-  }
+  return OffsetsContain(offsets_.get() + iter->second, offsets_.get() + bound,
+                        static_cast<uint16_t>(offset));
+}
 
-  return current == prefix;
+bool PrefixSet::PrefixExists(SBPrefix prefix) const {
+  if (index_.empty())
+    return false;
+  return EntryContains(FindEntry(prefix), prefix);
 }
 
 bool PrefixSet::Exists(const SBFullHash& hash) const {
@@ -142,24 +202,84 @@ bool PrefixSet::Exists(const SBFullHash& hash) const {
   return PrefixExists(hash.prefix);
 }
 
+void PrefixSet::GetPrefixHits(const std::vector<SBFullHash>& hashes,
+                              std::vector<SBPrefix>* prefix_hits) const {
+  std::vector<SBPrefix> prefixes;
+  prefixes.reserve(hashes.size());
+  for (const SBFullHash& hash : hashes) {
+    if (std::binary_search(full_hashes_.begin(), full_hashes_.end(),
+                           hash, SBFullHashLess)) {
+      prefix_hits->push_back(hash.prefix);
+    } else {
+      prefixes.push_back(hash.prefix);
+    }
+  }
+  if (index_.empty())
+    return;
+
+  // Find the entries of all the prefixes before reading any of their offsets,
+  // so that the cache misses of different prefixes overlap rather than add up.
+  std::vector<IndexVector::const_iterator> entries;
+  entries.reserve(prefixes.size());
+  for (SBPrefix prefix : prefixes)
+    entries.push_back(FindEntry(prefix));
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    if (EntryContains(entries[i], prefixes[i]))
+      prefix_hits->push_back(prefixes[i]);
+  }
+}
+
 void PrefixSet::GetPrefixes(std::vector<SBPrefix>* prefixes) const {
-  prefixes->reserve(index_.size() + deltas_.size());
+  prefixes->reserve(index_.size() + offsets_size_);
 
   for (size_t ii = 0; ii < index_.size(); ++ii) {
-    // The deltas for this |index_| entry run to the next index entry,
-    // or the end of the deltas.
-    const size_t deltas_end =
-        (ii + 1 < index_.size()) ? index_[ii + 1].second : deltas_.size();
+    // The offsets for this |index_| entry run to the next index entry,
+    // or the end of the offsets.
+    const size_t offsets_end =
+        (ii + 1 < index_.size()) ? index_[ii + 1].second : offsets_size_;
+
+    const SBPrefix base = index_[ii].first;
+    prefixes->push_back(base);
+
+    // Offsets increase, except for the padding.
+    uint16_t last_offset = 0;
+    for (size_t oi = index_[ii].second; oi < offsets_end; ++oi) {
+      const uint16_t offset = offsets_.get()[oi];
+      if (offset > last_offset) {
+        prefixes->push_back(base + offset);
+        last_offset = offset;
+      }
+    }
+  }
+}
 
-    SBPrefix current = index_[ii].first;
-    prefixes->push_back(current);
-    for (size_t di = index_[ii].second; di < deltas_end; ++di) {
-      current += deltas_[di];
-      prefixes->push_back(current);
+void PrefixSet::GetRuns(IndexVector* index,
+                        std::vector<uint16_t>* deltas) const {
+  std::vector<SBPrefix> prefixes;
+  GetPrefixes(&prefixes);
+
+  // Runs are broken by a too-large delta, or |kMaxRun|, whichever comes
+  // first.
+  size_t run_size = 0;
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    const unsigned delta = i ? prefixes[i] - prefixes[i - 1] : 0;
+    if (i == 0 || delta > 0xFFFF || run_size == kMaxRun) {
+      index->push_back(
+          std::make_pair(prefixes[i], static_cast<uint32_t>(deltas->size())));
+      run_size = 0;
+    } else {
+      deltas->push_back(static_cast<uint16_t>(delta));
+      ++run_size;
     }
   }
 }
 
+size_t PrefixSet::PrefixBytes() const {
+  return sizeof(index_[0]) * index_.size() +
+         sizeof(offsets_.get()[0]) * offsets_size_ +
+         sizeof(directory_[0]) * directory_.size();
+}
+
 // static
 std::unique_ptr<const PrefixSet> PrefixSet::LoadFile(
     const base::FilePath& filter_name) {
@@ -261,21 +381,47 @@ std::unique_ptr<const PrefixSet> PrefixSet::LoadFile(
   if (0 != memcmp(&file_digest, &calculated_digest, sizeof(file_digest)))
     return nullptr;
 
-  // Steals vector contents using swap().
-  return base::WrapUnique(new PrefixSet(&index, &deltas, &full_hashes));
+  // Convert the runs of deltas to blocks of offsets.  The prefixes must
+  // increase, and the runs be within |deltas|.
+  PrefixSetBuilder builder;
+  SBPrefix last_prefix = 0;
+  for (size_t ii = 0; ii < index.size(); ++ii) {
+    const size_t deltas_end =
+        (ii + 1 < index.size()) ? index[ii + 1].second : deltas.size();
+    if (index[ii].second > deltas_end || deltas_end > deltas.size())
+      return nullptr;
+
+    SBPrefix current = index[ii].first;
+    if (ii && current <= last_prefix)
+      return nullptr;
+    builder.AddPrefix(current);
+    for (size_t di = index[ii].second; di < deltas_end; ++di) {
+      const SBPrefix next = current + deltas[di];
+      if (next <= current)
+        return nullptr;
+      current = next;
+      builder.AddPrefix(current);
+    }
+    last_prefix = current;
+  }
+  return builder.GetPrefixSet(full_hashes);
 }
 
 bool PrefixSet::WriteFile(const base::FilePath& filter_name) const {
+  IndexVector index;
+  std::vector<uint16_t> deltas;
+  GetRuns(&index, &deltas);
+
   FileHeader header;
   header.magic = kMagic;
   header.version = kVersion;
-  header.index_size = static_cast<uint32_t>(index_.size());
-  header.deltas_size = static_cast<uint32_t>(deltas_.size());
+  header.index_size = static_cast<uint32_t>(index.size());
+  header.deltas_size = static_cast<uint32_t>(deltas.size());
   header.full_hashes_size = static_cast<uint32_t>(full_hashes_.size());
 
   // Sanity check that the 32-bit values never mess things up.
-  if (static_cast<size_t>(header.index_size) != index_.size() ||
-      static_cast<size_t>(header.deltas_size) != deltas_.size() ||
+  if (static_cast<size_t>(header.index_size) != index.size() ||
+      static_cast<size_t>(header.deltas_size) != deltas.size() ||
       static_cast<size_t>(header.full_hashes_size) != full_hashes_.size()) {
     NOTREACHED();
     return false;
@@ -298,27 +444,27 @@ bool PrefixSet::WriteFile(const base::FilePath& filter_name) const {
 
   // As for reads, the standard guarantees the ability to access the
   // contents of the vector by a pointer to an element.
-  if (index_.size()) {
-    const size_t index_bytes = sizeof(index_[0]) * index_.size();
-    written = fwrite(&(index_[0]), sizeof(index_[0]), index_.size(),
+  if (index.size()) {
+    const size_t index_bytes = sizeof(index[0]) * index.size();
+    written = fwrite(&(index[0]), sizeof(index[0]), index.size(),
                      file.get());
-    if (written != index_.size())
+    if (written != index.size())
       return false;
     base::MD5Update(&context,
                     base::StringPiece(
-                        reinterpret_cast<const char*>(&(index_[0])),
+                        reinterpret_cast<const char*>(&(index[0])),
                         index_bytes));
   }
 
-  if (deltas_.size()) {
-    const size_t deltas_bytes = sizeof(deltas_[0]) * deltas_.size();
-    written = fwrite(&(deltas_[0]), sizeof(deltas_[0]), deltas_.size(),
+  if (deltas.size()) {
+    const size_t deltas_bytes = sizeof(deltas[0]) * deltas.size();
+    written = fwrite(&(deltas[0]), sizeof(deltas[0]), deltas.size(),
                      file.get());
-    if (written != deltas_.size())
+    if (written != deltas.size())
       return false;
     base::MD5Update(&context,
                     base::StringPiece(
-                        reinterpret_cast<const char*>(&(deltas_[0])),
+                        reinterpret_cast<const char*>(&(deltas[0])),
                         deltas_bytes));
   }
 
@@ -347,27 +493,11 @@ bool PrefixSet::WriteFile(const base::FilePath& filter_name) const {
   return true;
 }
 
-void PrefixSet::AddRun(SBPrefix index_prefix,
-                       const uint16_t* run_begin,
-                       const uint16_t* run_end) {
-  // Preempt organic capacity decisions for |delta_| once strong estimates can
-  // be made.
-  if (index_prefix > kEstimateThreshold &&
-      deltas_.capacity() < deltas_.size() + (run_end - run_begin)) {
-    deltas_.reserve(EstimateFinalCount(index_prefix, deltas_.size()));
-  }
-
-  index_.push_back(
-      std::make_pair(index_prefix, static_cast<uint32_t>(deltas_.size())));
-  deltas_.insert(deltas_.end(), run_begin, run_end);
-}
-
-PrefixSetBuilder::PrefixSetBuilder()
-    : prefix_set_(new PrefixSet()) {
+PrefixSetBuilder::PrefixSetBuilder() : built_(false) {
 }
 
 PrefixSetBuilder::PrefixSetBuilder(const std::vector<SBPrefix>& prefixes)
-    : prefix_set_(new PrefixSet()) {
+    : built_(false) {
   for (size_t i = 0; i < prefixes.size(); ++i) {
     AddPrefix(prefixes[i]);
   }
@@ -378,63 +508,83 @@ PrefixSetBuilder::~PrefixSetBuilder() {
 
 std::unique_ptr<const PrefixSet> PrefixSetBuilder::GetPrefixSet(
     const std::vector<SBFullHash>& hashes) {
-  DCHECK(prefix_set_.get());
+  DCHECK(!built_);
 
-  // Flush runs until buffered data is gone.
+  // Flush blocks until buffered data is gone.
   while (!buffer_.empty()) {
-    EmitRun();
+    EmitBlock();
   }
+  built_ = true;
 
-  // Precisely size |index_| for read-only.  It's 50k-60k, so minor savings, but
-  // they're almost free.
-  PrefixSet::IndexVector(prefix_set_->index_).swap(prefix_set_->index_);
+  // Precisely size |index_| for read-only.  |offsets_| is copied anyway.
+  PrefixSet::IndexVector index(index_);
+  index_.clear();
 
-  prefix_set_->full_hashes_ = hashes;
-  std::sort(prefix_set_->full_hashes_.begin(), prefix_set_->full_hashes_.end(),
-            SBFullHashLess);
+  std::vector<SBFullHash> full_hashes(hashes);
+  std::sort(full_hashes.begin(), full_hashes.end(), SBFullHashLess);
 
-  return std::move(prefix_set_);
+  return base::WrapUnique(new PrefixSet(&index, offsets_, &full_hashes));
 }
 
 std::unique_ptr<const PrefixSet> PrefixSetBuilder::GetPrefixSetNoHashes() {
   return GetPrefixSet(std::vector<SBFullHash>());
 }
 
-void PrefixSetBuilder::EmitRun() {
-  DCHECK(prefix_set_.get());
-
-  SBPrefix prev_prefix = buffer_[0];
-  uint16_t run[PrefixSet::kMaxRun];
-  size_t run_pos = 0;
+void PrefixSetBuilder::EmitBlock() {
+  DCHECK(!built_);
 
+  const SBPrefix index_prefix = buffer_[0];
   size_t i;
-  for (i = 1; i < buffer_.size() && run_pos < PrefixSet::kMaxRun; ++i) {
-    // Calculate the delta.  |unsigned| is mandatory, because the
+  for (i = 1; i < buffer_.size() && i <= PrefixSet::kLineSize; ++i) {
+    // Calculate the offset.  |unsigned| is mandatory, because the
     // sorted_prefixes could be more than INT_MAX apart.
-    DCHECK_GT(buffer_[i], prev_prefix);
-    const unsigned delta = buffer_[i] - prev_prefix;
-    const uint16_t delta16 = static_cast<uint16_t>(delta);
+    DCHECK_GT(buffer_[i], buffer_[i - 1]);
+    const unsigned offset = buffer_[i] - index_prefix;
 
-    // Break the run if the delta doesn't fit.
-    if (delta != static_cast<unsigned>(delta16))
+    // Break the block if the offset doesn't fit.
+    if (offset > 0xFFFF)
       break;
+  }
+  const size_t block_size = i - 1;
+
+  // Pad the block to whole groups, and start it on the next cache line if it
+  // would cross one, extending the previous block over the rest of the line.
+  const size_t padded_size =
+      (block_size + PrefixSet::kGroupSize - 1) / PrefixSet::kGroupSize *
+      PrefixSet::kGroupSize;
+  const size_t line_offset = offsets_.size() % PrefixSet::kLineSize;
+  if (line_offset + padded_size > PrefixSet::kLineSize) {
+    // An empty previous block is padded with 0, which matches its prefix.
+    const bool previous_has_offsets =
+        !index_.empty() && index_.back().second < offsets_.size();
+    const uint16_t padding = previous_has_offsets ? offsets_.back() : 0;
+    offsets_.resize(offsets_.size() + PrefixSet::kLineSize - line_offset,
+                    padding);
+  }
 
-    // Continue the run of deltas.
-    run[run_pos++] = delta16;
-    DCHECK_EQ(static_cast<unsigned>(run[run_pos - 1]), delta);
-
-    prev_prefix = buffer_[i];
+  // Preempt organic capacity decisions for |offsets_| once strong estimates
+  // can be made.
+  if (index_prefix > kEstimateThreshold &&
+      offsets_.capacity() < offsets_.size() + padded_size) {
+    offsets_.reserve(EstimateFinalCount(index_prefix, offsets_.size()));
   }
-  prefix_set_->AddRun(buffer_[0], run, run + run_pos);
-  buffer_.erase(buffer_.begin(), buffer_.begin() + i);
+
+  index_.push_back(
+      std::make_pair(index_prefix, static_cast<uint32_t>(offsets_.size())));
+  for (size_t j = 1; j <= block_size; ++j)
+    offsets_.push_back(static_cast<uint16_t>(buffer_[j] - index_prefix));
+  const uint16_t padding = block_size ? offsets_.back() : 0;
+  offsets_.resize(offsets_.size() + padded_size - block_size, padding);
+
+  buffer_.erase(buffer_.begin(), buffer_.begin() + block_size + 1);
 }
 
 void PrefixSetBuilder::AddPrefix(SBPrefix prefix) {
-  DCHECK(prefix_set_.get());
+  DCHECK(!built_);
 
   if (buffer_.empty()) {
-    DCHECK(prefix_set_->index_.empty());
-    DCHECK(prefix_set_->deltas_.empty());
+    DCHECK(index_.empty());
+    DCHECK(offsets_.empty());
   } else {
     // Drop duplicates.
     if (buffer_.back() == prefix)
@@ -444,10 +594,10 @@ void PrefixSetBuilder::AddPrefix(SBPrefix prefix) {
   }
   buffer_.push_back(prefix);
 
-  // Flush buffer when a run can be constructed.  +1 for the index item, and +1
-  // to leave at least one item in the buffer for dropping duplicates.
-  if (buffer_.size() > PrefixSet::kMaxRun + 2)
-    EmitRun();
+  // Flush buffer when a block can be constructed.  +1 for the index item, and
+  // +1 to leave at least one item in the buffer for dropping duplicates.
+  if (buffer_.size() > PrefixSet::kLineSize + 2)
+    EmitBlock();
 }
 
 }  // namespace safe_browsing
@@ -3,48 +3,45 @@
 // found in the LICENSE file.
 //
 // A read-only set implementation for |SBPrefix| items.  Prefixes are
-// sorted and stored as 16-bit deltas from the previous prefix.  An
-// index structure provides quick random access, and also handles
-// cases where 16 bits cannot encode a delta.
+// sorted and grouped into blocks, each stored as a prefix in an index
+// followed by up to 32 16-bit offsets from that prefix, for the
+// prefixes within 2^16 of it.  The offsets are stored in groups of 8,
+// so that a lookup binary-searches the index and then compares the
+// prefix's offset with all of the block's offsets at once.  Blocks
+// never cross a 64-byte boundary, so a lookup touches a single cache
+// line of offsets.
 //
 // For example, the sequence {20, 25, 41, 65432, 150000, 160000} would
 // be stored as:
 //  A pair {20, 0} in |index_|.
-//  5, 16, 65391 in |deltas_|.
-//  A pair {150000, 3} in |index_|.
-//  10000 in |deltas_|.
-// |index_.size()| will be 2, |deltas_.size()| will be 4.
+//  5, 21, 65412, and 5 copies of 65412 as padding in |offsets_|.
+//  A pair {150000, 8} in |index_|.
+//  10000, and 7 copies of 10000 as padding in |offsets_|.
+// |index_.size()| will be 2, |offsets_size_| will be 16.
 //
 // This structure is intended for storage of sparse uniform sets of
-// prefixes of a certain size.  As of this writing, my safe-browsing
-// database contains:
-//   653132 add prefixes
-//   6446 are duplicates (from different chunks)
-//   24301 w/in 2^8 of the prior prefix
-//   622337 w/in 2^16 of the prior prefix
-//   47 further than 2^16 from the prior prefix
-// For this input, the memory usage is approximately 2 bytes per
-// prefix, a bit over 1.2M.  The bloom filter used 25 bits per prefix,
-// a bit over 1.9M on this data.
+// prefixes of a certain size.  With the 2M to 4M prefixes of current
+// lists, most blocks hold 20 to 32 offsets, and the set takes 2.2 to
+// 2.4 bytes per prefix, against 2.1 for the runs of deltas of the file
+// format.  Sparser sets take more, as blocks get shorter: about 3.5
+// bytes per prefix for 650k prefixes.  The worst case would be 2^16
+// items all 2^16 apart, which would need about 576k (versus 256k to
+// store the raw data).  A directory of the index, sized to about 4
+// index entries per range of prefixes, narrows the binary search.
 //
-// Experimenting with random selections of the above data, storage
-// size drops almost linearly as prefix count drops, until the index
-// overhead starts to become a problem a bit under 200k prefixes.  The
-// memory footprint gets worse than storing the raw prefix data around
-// 75k prefixes.  Fortunately, the actual memory footprint also falls.
-// If the prefix count increases the memory footprint should increase
-// approximately linearly.  The worst-case would be 2^16 items all
-// 2^16 apart, which would need 512k (versus 256k to store the raw
-// data).
-//
-// The on-disk format looks like:
+// On disk, the prefixes are stored as runs of 16-bit deltas, each from
+// the previous prefix.  The on-disk format looks like:
 //         4 byte magic number
 //         4 byte version number
-//         4 byte |index_.size()|
-//         4 byte |deltas_.size()|
-//     n * 8 byte |&index_[0]..&index_[n]|
-//     m * 2 byte |&deltas_[0]..&deltas_[m]|
+//         4 byte |index.size()|
+//         4 byte |deltas.size()|
+//         4 byte |full_hashes_.size()|
+//     n * 8 byte |&index[0]..&index[n]|
+//     m * 2 byte |&deltas[0]..&deltas[m]|
+//     k * 32 byte |&full_hashes_[0]..&full_hashes_[k]|
 //        16 byte digest
+// where each pair of |index| holds a prefix and the position in
+// |deltas| of the deltas following it.
 
 #ifndef COMPONENTS_SAFE_BROWSING_DB_PREFIX_SET_H_
 #define COMPONENTS_SAFE_BROWSING_DB_PREFIX_SET_H_
@@ -58,6 +55,7 @@
 
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
+#include "base/memory/aligned_memory.h"
 #include "components/safe_browsing_db/util.h"
 
 namespace base {
@@ -74,6 +72,12 @@ class PrefixSet {
   // |hash.prefix| is one of the prefixes passed to the set's builder.
   bool Exists(const SBFullHash& hash) const;
 
+  // Appends to |prefix_hits| the prefix of each of |hashes| for which
+  // |Exists()| is true.  Faster than calling |Exists()| for each hash, as
+  // the memory accesses of the lookups overlap.
+  void GetPrefixHits(const std::vector<SBFullHash>& hashes,
+                     std::vector<SBPrefix>* prefix_hits) const;
+
   // Persist the set on disk.
   static std::unique_ptr<const PrefixSet> LoadFile(
       const base::FilePath& filter_name);
@@ -84,15 +88,19 @@ class PrefixSet {
 
   friend class PrefixSetTest;
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, AllBig);
+  FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, BlockLayout);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, EdgeCases);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, Empty);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, FullHashBuild);
+  FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, GetRuns);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, IntMinMax);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, OneElement);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, ReadWrite);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, ReadWriteSigned);
   FRIEND_TEST_ALL_PREFIXES(PrefixSetTest, Version3);
 
+  FRIEND_TEST_ALL_PREFIXES(PrefixSetPerfTest, Lookup);
+
   FRIEND_TEST_ALL_PREFIXES(SafeBrowsingStoreFileTest, BasicStore);
   FRIEND_TEST_ALL_PREFIXES(SafeBrowsingStoreFileTest, DeleteChunks);
   FRIEND_TEST_ALL_PREFIXES(SafeBrowsingStoreFileTest, DetectsCorruption);
@@ -102,21 +110,39 @@ class PrefixSet {
   FRIEND_TEST_ALL_PREFIXES(SafeBrowsingStoreFileTest, Version7);
   FRIEND_TEST_ALL_PREFIXES(SafeBrowsingStoreFileTest, Version8);
 
-  // Maximum number of consecutive deltas to encode before generating
-  // a new index entry.  This helps keep the worst-case performance
-  // for |Exists()| under control.
+  // Maximum number of consecutive deltas in a run of the on-disk
+  // format.
   static const size_t kMaxRun = 100;
 
+  // Number of offsets compared at once, which make a 16-byte group.
+  static const size_t kGroupSize = 8;
+
+  // Number of offsets in a cache line, and maximum number of offsets
+  // in a block.
+  static const size_t kLineSize = 32;
+
+  // Average number of |index_| entries per bucket of |directory_|, at most.
+  static const size_t kEntriesPerBucket = 4;
+
   // Helpers to make |index_| easier to deal with.
   typedef std::pair<SBPrefix, uint32_t> IndexPair;
   typedef std::vector<IndexPair> IndexVector;
   static bool PrefixLess(const IndexPair& a, const IndexPair& b);
 
-  // Helper to let |PrefixSetBuilder| add a run of data.  |index_prefix| is
-  // added to |index_|, with the other elements added into |deltas_|.
-  void AddRun(SBPrefix index_prefix,
-              const uint16_t* run_begin,
-              const uint16_t* run_end);
+  // Returns the first entry of |index_| after |prefix|.  |index_| must not be
+  // empty.
+  IndexVector::const_iterator FindEntry(SBPrefix prefix) const;
+
+  // |true| if |prefix| is in the block of the entry before |iter|, the
+  // result of |FindEntry(prefix)|.
+  bool EntryContains(IndexVector::const_iterator iter, SBPrefix prefix) const;
+
+  // Returns the runs of deltas of the on-disk format, with the same
+  // layout as |index_| and |offsets_|.
+  void GetRuns(IndexVector* index, std::vector<uint16_t>* deltas) const;
+
+  // Returns the number of bytes used by the prefixes.
+  size_t PrefixBytes() const;
 
   // |true| if |prefix| is one of the prefixes passed to the set's builder.
   // Provided for testing purposes.
@@ -126,24 +152,31 @@ class PrefixSet {
   // |prefixes|.  Prefixes will be added in sorted order.  Useful for testing.
   void GetPrefixes(std::vector<SBPrefix>* prefixes) const;
 
-  // Used by |PrefixSetBuilder|.
-  PrefixSet();
-
-  // Helper for |LoadFile()|.  Steals vector contents using |swap()|.
+  // Helper for |PrefixSetBuilder|.  Steals vector contents using
+  // |swap()|, and copies |offsets| to aligned memory.
   PrefixSet(IndexVector* index,
-            std::vector<uint16_t>* deltas,
+            const std::vector<uint16_t>& offsets,
             std::vector<SBFullHash>* full_hashes);
 
-  // Top-level index of prefix to offset in |deltas_|.  Each pair
-  // indicates a base prefix and where the deltas from that prefix
-  // begin in |deltas_|.  The deltas for a pair end at the next pair's
-  // index into |deltas_|.
+  // Top-level index of prefix to offset in |offsets_|.  Each pair
+  // indicates a base prefix and where the offsets from that prefix
+  // begin in |offsets_|.  The offsets for a pair end at the next pair's
+  // index into |offsets_|.
   IndexVector index_;
 
-  // Deltas which are added to the prefix in |index_| to generate
-  // prefixes.  Deltas are only valid between consecutive items from
-  // |index_|, or the end of |deltas_| for the last |index_| pair.
-  std::vector<uint16_t> deltas_;
+  // Offsets which are added to the prefix in |index_| to generate
+  // prefixes, in increasing order.  The offsets of a pair are padded
+  // to a multiple of |kGroupSize| with copies of the last one, or
+  // with 0 if there is none, and never cross a multiple of
+  // |kLineSize|.  |offsets_| is aligned on a cache line.
+  std::unique_ptr<uint16_t, base::AlignedFreeDeleter> offsets_;
+  size_t offsets_size_;
+
+  // Position in |index_| of the first prefix of each range of
+  // 2^|directory_shift_| prefixes, followed by |index_.size()|.  This
+  // narrows the search of |index_| to a few entries.
+  std::vector<uint32_t> directory_;
+  uint32_t directory_shift_;
 
   // Full hashes ordered by SBFullHashLess.
   std::vector<SBFullHash> full_hashes_;
@@ -175,15 +208,20 @@ class PrefixSetBuilder {
   std::unique_ptr<const PrefixSet> GetPrefixSetNoHashes();
 
  private:
-  // Encode a run of deltas for |AddRun()|.  The run is broken by a too-large
-  // delta, or kMaxRun, whichever comes first.
-  void EmitRun();
+  // Encode a block of offsets into |index_| and |offsets_|.  The block is
+  // broken by a too-large offset, or |PrefixSet::kLineSize|, whichever comes
+  // first.
+  void EmitBlock();
 
-  // Buffers prefixes until enough are avaliable to emit a run.
+  // Buffers prefixes until enough are avaliable to emit a block.
   std::vector<SBPrefix> buffer_;
 
-  // The PrefixSet being built.
-  std::unique_ptr<PrefixSet> prefix_set_;
+  // The contents of the PrefixSet being built.
+  PrefixSet::IndexVector index_;
+  std::vector<uint16_t> offsets_;
+
+  // Set once |GetPrefixSet()| is called.
+  bool built_;
 };
 
 }  // namespace safe_browsing
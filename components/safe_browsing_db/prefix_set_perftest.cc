@@ -0,0 +1,140 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "components/safe_browsing_db/prefix_set.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/rand_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "components/safe_browsing_db/util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace safe_browsing {
+
+namespace {
+
+// Number of lookups timed for each set.
+const size_t kNumLookups = 2000000;
+
+// Number of full hashes checked for a URL: up to 5 host suffixes times up to
+// 6 path prefixes, see |UrlToFullHashes()|.
+const size_t kHashesPerUrl = 30;
+
+// One lookup in |kHitInterval| is for a prefix in the set.
+const size_t kHitInterval = 100;
+
+// Returns |count| distinct random prefixes, sorted.
+std::vector<SBPrefix> RandomPrefixes(size_t count) {
+  std::vector<SBPrefix> prefixes;
+  while (prefixes.size() < count) {
+    for (size_t i = prefixes.size(); i < count; ++i)
+      prefixes.push_back(static_cast<SBPrefix>(base::RandUint64()));
+    std::sort(prefixes.begin(), prefixes.end());
+    prefixes.erase(std::unique(prefixes.begin(), prefixes.end()),
+                   prefixes.end());
+  }
+  return prefixes;
+}
+
+// Returns |kNumLookups| hashes with random prefixes, mostly not in
+// |prefixes|.
+std::vector<SBFullHash> LookupHashes(const std::vector<SBPrefix>& prefixes) {
+  std::vector<SBFullHash> hashes(kNumLookups,
+                                 SBFullHashForString("www.example.com/"));
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    hashes[i].prefix =
+        i % kHitInterval
+            ? static_cast<SBPrefix>(base::RandUint64())
+            : prefixes[base::RandGenerator(prefixes.size())];
+  }
+  return hashes;
+}
+
+void PrintLookups(const std::string& measurement,
+                  const std::string& trace,
+                  base::TimeDelta elapsed) {
+  perf_test::PrintResult(measurement, "", trace,
+                         kNumLookups / elapsed.InSecondsF(), "lookups/s",
+                         true);
+}
+
+}  // namespace
+
+// Compares the lookups in a PrefixSet of 2M and 4M prefixes, one at a time and
+// a URL's worth at a time, with a binary search of the sorted prefixes, and
+// the memory they take.
+TEST(PrefixSetPerfTest, Lookup) {
+  for (size_t count : {2000000, 4000000}) {
+    const std::string trace =
+        base::StringPrintf("%" PRIuS "M", count / 1000000);
+    const std::vector<SBPrefix> prefixes = RandomPrefixes(count);
+    const std::vector<SBFullHash> hashes = LookupHashes(prefixes);
+    std::unique_ptr<const PrefixSet> prefix_set =
+        PrefixSetBuilder(prefixes).GetPrefixSetNoHashes();
+
+    size_t expected_hits = 0;
+    base::ElapsedTimer sorted_timer;
+    for (const SBFullHash& hash : hashes) {
+      if (std::binary_search(prefixes.begin(), prefixes.end(), hash.prefix))
+        ++expected_hits;
+    }
+    PrintLookups("prefix_lookups", trace + "_sorted_vector",
+                 sorted_timer.Elapsed());
+
+    size_t hits = 0;
+    base::ElapsedTimer exists_timer;
+    for (const SBFullHash& hash : hashes) {
+      if (prefix_set->Exists(hash))
+        ++hits;
+    }
+    PrintLookups("prefix_lookups", trace + "_prefix_set",
+                 exists_timer.Elapsed());
+    EXPECT_EQ(expected_hits, hits);
+
+    std::vector<SBFullHash> url_hashes;
+    std::vector<SBPrefix> prefix_hits;
+    base::ElapsedTimer batch_timer;
+    for (size_t i = 0; i < hashes.size(); i += kHashesPerUrl) {
+      url_hashes.assign(
+          hashes.begin() + i,
+          hashes.begin() + std::min(hashes.size(), i + kHashesPerUrl));
+      prefix_set->GetPrefixHits(url_hashes, &prefix_hits);
+    }
+    PrintLookups("prefix_lookups", trace + "_prefix_set_batched",
+                 batch_timer.Elapsed());
+    EXPECT_EQ(expected_hits, prefix_hits.size());
+
+    // The runs of deltas of the file format are how the prefixes used to be
+    // stored in memory too.
+    PrefixSet::IndexVector index;
+    std::vector<uint16_t> deltas;
+    prefix_set->GetRuns(&index, &deltas);
+    const size_t runs_bytes =
+        sizeof(index[0]) * index.size() + sizeof(deltas[0]) * deltas.size();
+
+    perf_test::PrintResult("bytes_per_prefix", "", trace + "_sorted_vector",
+                           static_cast<double>(sizeof(SBPrefix)), "bytes",
+                           false);
+    perf_test::PrintResult(
+        "bytes_per_prefix", "", trace + "_prefix_set",
+        static_cast<double>(prefix_set->PrefixBytes()) / count, "bytes",
+        true);
+    perf_test::PrintResult("bytes_per_prefix", "", trace + "_delta_runs",
+                           static_cast<double>(runs_bytes) / count, "bytes",
+                           false);
+  }
+}
+
+}  // namespace safe_browsing
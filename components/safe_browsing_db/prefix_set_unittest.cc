@@ -643,6 +643,122 @@ TEST_F(PrefixSetTest, FullHashBuild) {
   EXPECT_FALSE(prefix_set->PrefixExists(kHash6.prefix));
 }
 
+// Test that |GetPrefixHits()| agrees with |Exists()|.
+TEST_F(PrefixSetTest, GetPrefixHits) {
+  const SBFullHash kHash1 = SBFullHashForString("one");
+  const SBFullHash kHash2 = SBFullHashForString("two");
+  const SBFullHash kHash3 = SBFullHashForString("three");
+
+  std::vector<SBPrefix> prefixes(shared_prefixes_);
+  prefixes.push_back(kHash1.prefix);
+  std::sort(prefixes.begin(), prefixes.end());
+
+  std::vector<SBFullHash> hashes;
+  hashes.push_back(kHash2);
+
+  PrefixSetBuilder builder(prefixes);
+  std::unique_ptr<const PrefixSet> prefix_set = builder.GetPrefixSet(hashes);
+
+  // Look up hashes for the prefixes in the set, their neighbours, and
+  // |kHash1| to |kHash3| twice, in no particular order.
+  std::vector<SBFullHash> lookups;
+  for (size_t i = 0; i < shared_prefixes_.size(); i += 7) {
+    SBFullHash hash = kHash3;
+    for (SBPrefix prefix : {shared_prefixes_[i], shared_prefixes_[i] + 1,
+                            shared_prefixes_[i] - 1}) {
+      hash.prefix = prefix;
+      lookups.push_back(hash);
+    }
+  }
+  for (const SBFullHash& hash : {kHash1, kHash2, kHash3, kHash3, kHash2}) {
+    lookups.push_back(hash);
+  }
+  std::random_shuffle(lookups.begin(), lookups.end());
+
+  std::vector<SBPrefix> expected_hits;
+  for (const SBFullHash& hash : lookups) {
+    if (prefix_set->Exists(hash))
+      expected_hits.push_back(hash.prefix);
+  }
+  std::sort(expected_hits.begin(), expected_hits.end());
+  expected_hits.erase(std::unique(expected_hits.begin(), expected_hits.end()),
+                      expected_hits.end());
+
+  // Hits are appended.
+  std::vector<SBPrefix> prefix_hits(1, kHash3.prefix);
+  prefix_set->GetPrefixHits(lookups, &prefix_hits);
+  EXPECT_EQ(kHash3.prefix, prefix_hits[0]);
+  prefix_hits.erase(prefix_hits.begin());
+  std::sort(prefix_hits.begin(), prefix_hits.end());
+  prefix_hits.erase(std::unique(prefix_hits.begin(), prefix_hits.end()),
+                    prefix_hits.end());
+  EXPECT_EQ(expected_hits, prefix_hits);
+  EXPECT_TRUE(std::binary_search(prefix_hits.begin(), prefix_hits.end(),
+                                 kHash1.prefix));
+  EXPECT_TRUE(std::binary_search(prefix_hits.begin(), prefix_hits.end(),
+                                 kHash2.prefix));
+
+  prefix_hits.clear();
+  prefix_set->GetPrefixHits(std::vector<SBFullHash>(), &prefix_hits);
+  EXPECT_TRUE(prefix_hits.empty());
+}
+
+// Test that blocks are padded to whole groups and stay within a cache line,
+// whatever the spacing of the prefixes.
+TEST_F(PrefixSetTest, BlockLayout) {
+  std::vector<SBPrefix> prefixes(shared_prefixes_);
+  for (SBPrefix prefix = kHighBitClear, delta = 1; delta < 0x20000;
+       prefix += delta, delta += delta / 8 + 1) {
+    prefixes.push_back(prefix);
+  }
+  std::sort(prefixes.begin(), prefixes.end());
+  PrefixSetBuilder builder(prefixes);
+  std::unique_ptr<const PrefixSet> prefix_set = builder.GetPrefixSetNoHashes();
+  CheckPrefixes(*prefix_set, prefixes);
+
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(prefix_set->offsets_.get()) % 64);
+  EXPECT_EQ(0u, prefix_set->offsets_size_ % PrefixSet::kGroupSize);
+  const PrefixSet::IndexVector& index = prefix_set->index_;
+  for (size_t i = 0; i < index.size(); ++i) {
+    const size_t begin = index[i].second;
+    const size_t end =
+        i + 1 < index.size() ? index[i + 1].second : prefix_set->offsets_size_;
+    EXPECT_EQ(0u, begin % PrefixSet::kGroupSize);
+    if (begin != end) {
+      EXPECT_EQ(begin / PrefixSet::kLineSize,
+                (end - 1) / PrefixSet::kLineSize);
+    }
+  }
+}
+
+// Test that the on-disk runs of deltas match the format's description.
+TEST_F(PrefixSetTest, GetRuns) {
+  std::vector<SBPrefix> prefixes;
+  prefixes.push_back(20);
+  prefixes.push_back(25);
+  prefixes.push_back(41);
+  prefixes.push_back(65432);
+  prefixes.push_back(150000);
+  prefixes.push_back(160000);
+  PrefixSetBuilder builder(prefixes);
+  std::unique_ptr<const PrefixSet> prefix_set = builder.GetPrefixSetNoHashes();
+
+  EXPECT_EQ(2u, prefix_set->index_.size());
+  EXPECT_EQ(16u, prefix_set->offsets_size_);
+
+  PrefixSet::IndexVector index;
+  std::vector<uint16_t> deltas;
+  prefix_set->GetRuns(&index, &deltas);
+  ASSERT_EQ(2u, index.size());
+  EXPECT_EQ(PrefixSet::IndexPair(20, 0), index[0]);
+  EXPECT_EQ(PrefixSet::IndexPair(150000, 3), index[1]);
+  ASSERT_EQ(4u, deltas.size());
+  EXPECT_EQ(5u, deltas[0]);
+  EXPECT_EQ(16u, deltas[1]);
+  EXPECT_EQ(65391u, deltas[2]);
+  EXPECT_EQ(10000u, deltas[3]);
+}
+
 // Test that a version 1 file is discarded on read.
 TEST_F(PrefixSetTest, ReadSigned) {
   base::FilePath filename;
@@ -53,8 +53,11 @@ void V4Database::CreateOnTaskRunner(
   for (const auto& list_info : list_info_map) {
     const UpdateListIdentifier& update_list_identifier = list_info.first;
     const base::FilePath store_path = base_path.AppendASCII(list_info.second);
-    (*store_map)[update_list_identifier].reset(
+    std::unique_ptr<V4Store> store(
         factory_->CreateV4Store(db_task_runner, store_path));
+    // A store whose file is corrupt starts empty and gets a full update.
+    store->Initialize();
+    (*store_map)[update_list_identifier] = std::move(store);
   }
   std::unique_ptr<V4Database> v4_database(
       new V4Database(db_task_runner, std::move(store_map)));
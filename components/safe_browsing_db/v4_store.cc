@@ -4,8 +4,266 @@
 
 #include "components/safe_browsing_db/v4_store.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "crypto/secure_hash.h"
+#include "crypto/sha2.h"
+
 namespace safe_browsing {
 
+namespace {
+
+// Identifies a store file, and the version of its format.
+const uint32_t kFileMagic = 0x600D71FE;
+const uint32_t kFileVersion = 1;
+
+const size_t kMinPrefixSize = 4;
+const size_t kMaxPrefixSize = 32;
+
+// The prefixes of each size are written to the new file of an update through
+// a buffer of this size.
+const size_t kWriteBufferSize = 64 * 1024;
+
+// The file of a store starts with a FileHeader, followed by a GroupHeader for
+// each group of prefixes, by increasing prefix size, and by the client state.
+// The prefixes of each group, sorted and concatenated, start at the offset in
+// its header.
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t group_count;
+  uint32_t state_size;
+};
+
+struct GroupHeader {
+  uint32_t prefix_size;
+  uint32_t prefix_count;
+  uint64_t offset;
+};
+
+// A sorted run of hash prefixes of one size, either a group of a store or
+// additions of an update, and the next one to merge.
+struct PrefixRun {
+  PrefixRun(size_t prefix_size, const char* begin, const char* end)
+      : prefix_size(prefix_size), next(begin), end(end) {}
+
+  size_t prefix_size;
+  const char* next;
+  const char* end;
+};
+
+// Compares two prefixes lexicographically. A prefix sorts before the longer
+// prefixes which start with it.
+int ComparePrefixes(const char* a,
+                    size_t a_size,
+                    const char* b,
+                    size_t b_size) {
+  const int result = memcmp(a, b, std::min(a_size, b_size));
+  if (result)
+    return result;
+  return a_size < b_size ? -1 : (a_size > b_size ? 1 : 0);
+}
+
+// Returns true if the prefixes of |run| are sorted and distinct.
+bool IsSortedAndUnique(const PrefixRun& run) {
+  for (const char* prefix = run.next + run.prefix_size; prefix < run.end;
+       prefix += run.prefix_size) {
+    if (memcmp(prefix - run.prefix_size, prefix, run.prefix_size) >= 0)
+      return false;
+  }
+  return true;
+}
+
+// Receives the prefixes of the list resulting from an update, in order.
+class MergedPrefixSink {
+ public:
+  virtual ~MergedPrefixSink() {}
+  virtual void Add(const char* prefix, size_t prefix_size) = 0;
+};
+
+// Merges the prefixes of |old_runs|, less those at the sorted |removals|
+// indices of their merged list, with those of |added_runs|, and passes each
+// distinct prefix of the result to |sink| in lexicographic order. Returns
+// false if a removal is out of range.
+bool MergePrefixes(std::vector<PrefixRun> old_runs,
+                   const std::vector<int32_t>& removals,
+                   const std::vector<PrefixRun>& added_runs,
+                   MergedPrefixSink* sink) {
+  const size_t old_run_count = old_runs.size();
+  std::vector<PrefixRun> runs(std::move(old_runs));
+  runs.insert(runs.end(), added_runs.begin(), added_runs.end());
+
+  std::vector<int32_t>::const_iterator removal = removals.begin();
+  int32_t old_index = 0;
+  const char* last_prefix = nullptr;
+  size_t last_prefix_size = 0;
+  while (true) {
+    // There are at most a few runs, one per prefix size in the store and in
+    // the update, so they are simply scanned for the smallest next prefix.
+    size_t best = runs.size();
+    for (size_t i = 0; i < runs.size(); ++i) {
+      if (runs[i].next == runs[i].end)
+        continue;
+      if (best == runs.size() ||
+          ComparePrefixes(runs[i].next, runs[i].prefix_size, runs[best].next,
+                          runs[best].prefix_size) < 0) {
+        best = i;
+      }
+    }
+    if (best == runs.size())
+      break;
+
+    PrefixRun& run = runs[best];
+    const char* prefix = run.next;
+    run.next += run.prefix_size;
+    if (best < old_run_count) {
+      const int32_t index = old_index++;
+      if (removal != removals.end() && *removal == index) {
+        ++removal;
+        continue;
+      }
+    }
+    // An addition may already be in the store.
+    if (last_prefix && last_prefix_size == run.prefix_size &&
+        !memcmp(last_prefix, prefix, run.prefix_size)) {
+      continue;
+    }
+    last_prefix = prefix;
+    last_prefix_size = run.prefix_size;
+    sink->Add(prefix, run.prefix_size);
+  }
+  return removal == removals.end();
+}
+
+// Counts the merged prefixes of each size, and computes the checksum of the
+// merged list.
+class CountingSink : public MergedPrefixSink {
+ public:
+  CountingSink()
+      : checksum_(crypto::SecureHash::Create(crypto::SecureHash::SHA256)),
+        counts_() {}
+
+  void Add(const char* prefix, size_t prefix_size) override {
+    ++counts_[prefix_size];
+    checksum_->Update(prefix, prefix_size);
+  }
+
+  size_t count(size_t prefix_size) const { return counts_[prefix_size]; }
+
+  std::string FinishChecksum() {
+    std::string checksum(crypto::kSHA256Length, '\0');
+    checksum_->Finish(&checksum[0], checksum.size());
+    return checksum;
+  }
+
+ private:
+  std::unique_ptr<crypto::SecureHash> checksum_;
+  size_t counts_[kMaxPrefixSize + 1];
+
+  DISALLOW_COPY_AND_ASSIGN(CountingSink);
+};
+
+// Writes the merged prefixes of each size to their group in a store file.
+class FileWritingSink : public MergedPrefixSink {
+ public:
+  FileWritingSink(base::File* file, const std::vector<GroupHeader>& groups)
+      : file_(file), failed_(false) {
+    for (const GroupHeader& group : groups)
+      offsets_[group.prefix_size] = group.offset;
+  }
+
+  void Add(const char* prefix, size_t prefix_size) override {
+    std::string& buffer = buffers_[prefix_size];
+    buffer.append(prefix, prefix_size);
+    if (buffer.size() >= kWriteBufferSize)
+      Flush(prefix_size);
+  }
+
+  // Writes out what is left in the buffers. Returns false if any write
+  // failed.
+  bool Finish() {
+    for (size_t prefix_size = kMinPrefixSize; prefix_size <= kMaxPrefixSize;
+         ++prefix_size) {
+      Flush(prefix_size);
+    }
+    return !failed_;
+  }
+
+ private:
+  void Flush(size_t prefix_size) {
+    std::string& buffer = buffers_[prefix_size];
+    if (buffer.empty())
+      return;
+    const int size = static_cast<int>(buffer.size());
+    if (file_->Write(offsets_[prefix_size], buffer.data(), size) != size)
+      failed_ = true;
+    offsets_[prefix_size] += size;
+    buffer.clear();
+  }
+
+  base::File* file_;
+  int64_t offsets_[kMaxPrefixSize + 1];
+  std::string buffers_[kMaxPrefixSize + 1];
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileWritingSink);
+};
+
+// Writes to |path| a store file with the client |state| and the prefixes of
+// the merge of |old_runs|, |removals| and |added_runs|, whose counts are in
+// |counter|.
+bool WriteStoreFile(const base::FilePath& path,
+                    const std::vector<PrefixRun>& old_runs,
+                    const std::vector<int32_t>& removals,
+                    const std::vector<PrefixRun>& added_runs,
+                    const CountingSink& counter,
+                    const std::string& state) {
+  std::vector<GroupHeader> groups;
+  for (size_t prefix_size = kMinPrefixSize; prefix_size <= kMaxPrefixSize;
+       ++prefix_size) {
+    if (counter.count(prefix_size)) {
+      GroupHeader group = {static_cast<uint32_t>(prefix_size),
+                           static_cast<uint32_t>(counter.count(prefix_size)),
+                           0};
+      groups.push_back(group);
+    }
+  }
+  FileHeader header = {kFileMagic, kFileVersion,
+                       static_cast<uint32_t>(groups.size()),
+                       static_cast<uint32_t>(state.size())};
+  uint64_t offset =
+      sizeof(header) + groups.size() * sizeof(GroupHeader) + state.size();
+  for (GroupHeader& group : groups) {
+    group.offset = offset;
+    offset += static_cast<uint64_t>(group.prefix_size) * group.prefix_count;
+  }
+
+  base::File file(path, base::File::FLAG_CREATE_ALWAYS |
+                            base::File::FLAG_WRITE);
+  if (!file.IsValid())
+    return false;
+  std::string headers(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!groups.empty()) {
+    headers.append(reinterpret_cast<const char*>(&groups[0]),
+                   groups.size() * sizeof(GroupHeader));
+  }
+  headers.append(state);
+  const int headers_size = static_cast<int>(headers.size());
+  if (file.Write(0, headers.data(), headers_size) != headers_size)
+    return false;
+
+  FileWritingSink writer(&file, groups);
+  return MergePrefixes(old_runs, removals, added_runs, &writer) &&
+         writer.Finish();
+}
+
+}  // namespace
+
 V4Store* V4StoreFactory::CreateV4Store(
     const scoped_refptr<base::SequencedTaskRunner>& task_runner,
     const base::FilePath& store_path) {
@@ -18,9 +276,195 @@ V4Store::V4Store(const scoped_refptr<base::SequencedTaskRunner>& task_runner,
 
 V4Store::~V4Store() {}
 
+bool V4Store::Initialize() {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  file_.reset();
+  groups_.clear();
+  state_.clear();
+  if (!base::PathExists(store_path_))
+    return true;
+
+  file_.reset(new base::MemoryMappedFile);
+  if (file_->Initialize(store_path_) && ParseFile())
+    return true;
+  DLOG(WARNING) << "Deleting corrupt store: " << store_path_.value();
+  Reset();
+  return false;
+}
+
+bool V4Store::ApplyUpdate(
+    const FetchThreatListUpdatesResponse::ListUpdateResponse& response) {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  std::vector<PrefixRun> added_runs;
+  for (const ThreatEntrySet& additions : response.additions()) {
+    if (additions.compression_type() == RICE) {
+      DLOG(WARNING) << "Rice-Golomb encoded additions are not supported";
+      return false;
+    }
+    if (!additions.has_raw_hashes())
+      return false;
+    const RawHashes& raw_hashes = additions.raw_hashes();
+    const size_t prefix_size = raw_hashes.prefix_size();
+    const std::string& hashes = raw_hashes.raw_hashes();
+    if (prefix_size < kMinPrefixSize || prefix_size > kMaxPrefixSize ||
+        hashes.size() % prefix_size) {
+      return false;
+    }
+    PrefixRun run(prefix_size, hashes.data(), hashes.data() + hashes.size());
+    if (!IsSortedAndUnique(run))
+      return false;
+    added_runs.push_back(run);
+  }
+
+  std::vector<int32_t> removals;
+  for (const ThreatEntrySet& removal_set : response.removals()) {
+    if (removal_set.compression_type() == RICE) {
+      DLOG(WARNING) << "Rice-Golomb encoded removals are not supported";
+      return false;
+    }
+    if (!removal_set.has_raw_indices())
+      return false;
+    removals.insert(removals.end(),
+                    removal_set.raw_indices().indices().begin(),
+                    removal_set.raw_indices().indices().end());
+  }
+  std::sort(removals.begin(), removals.end());
+  removals.erase(std::unique(removals.begin(), removals.end()),
+                 removals.end());
+  if (!removals.empty() && removals.front() < 0)
+    return false;
+
+  // A partial update is merged with the prefixes of the store, a full update
+  // replaces them.
+  std::vector<PrefixRun> old_runs;
+  switch (response.response_type()) {
+    case FetchThreatListUpdatesResponse::ListUpdateResponse::PARTIAL_UPDATE:
+      for (const PrefixGroup& group : groups_) {
+        old_runs.push_back(PrefixRun(
+            group.prefix_size, group.prefixes,
+            group.prefixes + group.prefix_size * group.prefix_count));
+      }
+      break;
+    case FetchThreatListUpdatesResponse::ListUpdateResponse::FULL_UPDATE:
+      if (!removals.empty())
+        return false;
+      break;
+    default:
+      return false;
+  }
+
+  // Merge once to lay out the new file and verify the checksum of the new
+  // list before writing anything, then again to write the file.
+  CountingSink counter;
+  if (!MergePrefixes(old_runs, removals, added_runs, &counter))
+    return false;
+  const std::string checksum = counter.FinishChecksum();
+  if (response.has_checksum() && response.checksum().sha256() != checksum)
+    return false;
+
+  const base::FilePath new_path =
+      store_path_.AddExtension(FILE_PATH_LITERAL("new"));
+  if (!base::CreateDirectory(store_path_.DirName()) ||
+      !WriteStoreFile(new_path, old_runs, removals, added_runs, counter,
+                      response.new_client_state())) {
+    base::DeleteFile(new_path, false);
+    return false;
+  }
+
+  // The old file must be unmapped before it can be replaced on Windows.
+  file_.reset();
+  groups_.clear();
+  state_.clear();
+  if (!base::ReplaceFile(new_path, store_path_, nullptr)) {
+    base::DeleteFile(new_path, false);
+    Initialize();
+    return false;
+  }
+  return Initialize();
+}
+
+HashPrefix V4Store::GetMatchingHashPrefix(const FullHash& full_hash) const {
+  for (const PrefixGroup& group : groups_) {
+    if (group.prefix_size > full_hash.size())
+      break;
+    if (GroupContains(group, full_hash))
+      return full_hash.substr(0, group.prefix_size);
+  }
+  return HashPrefix();
+}
+
+size_t V4Store::GetPrefixCount() const {
+  size_t count = 0;
+  for (const PrefixGroup& group : groups_)
+    count += group.prefix_count;
+  return count;
+}
+
 bool V4Store::Reset() {
-  // TODO(vakh): Implement skeleton.
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  file_.reset();
+  groups_.clear();
+  state_.clear();
+  return base::DeleteFile(store_path_, false);
+}
+
+bool V4Store::ParseFile() {
+  const char* data = reinterpret_cast<const char*>(file_->data());
+  const size_t length = file_->length();
+  FileHeader header;
+  if (length < sizeof(header))
+    return false;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kFileMagic || header.version != kFileVersion ||
+      header.group_count > kMaxPrefixSize - kMinPrefixSize + 1) {
+    return false;
+  }
+
+  size_t offset = sizeof(header);
+  if (length - offset < header.group_count * sizeof(GroupHeader))
+    return false;
+  size_t previous_prefix_size = 0;
+  for (uint32_t i = 0; i < header.group_count; ++i) {
+    GroupHeader group_header;
+    memcpy(&group_header, data + offset, sizeof(group_header));
+    offset += sizeof(group_header);
+    const size_t prefix_size = group_header.prefix_size;
+    if (prefix_size < kMinPrefixSize || prefix_size > kMaxPrefixSize ||
+        prefix_size <= previous_prefix_size ||
+        group_header.offset > length ||
+        (length - group_header.offset) / prefix_size <
+            group_header.prefix_count) {
+      return false;
+    }
+    previous_prefix_size = prefix_size;
+    PrefixGroup group = {prefix_size, group_header.prefix_count,
+                         data + group_header.offset};
+    groups_.push_back(group);
+  }
+
+  if (length - offset < header.state_size)
+    return false;
+  state_.assign(data + offset, header.state_size);
   return true;
 }
 
+// static
+bool V4Store::GroupContains(const PrefixGroup& group,
+                            const FullHash& full_hash) {
+  size_t low = 0;
+  size_t high = group.prefix_count;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const int result = memcmp(group.prefixes + middle * group.prefix_size,
+                              full_hash.data(), group.prefix_size);
+    if (result < 0)
+      low = middle + 1;
+    else if (result > 0)
+      high = middle;
+    else
+      return true;
+  }
+  return false;
+}
+
 }  // namespace safe_browsing
@@ -5,14 +5,31 @@
 #ifndef COMPONENTS_SAFE_BROWSING_DB_V4_STORE_H_
 #define COMPONENTS_SAFE_BROWSING_DB_V4_STORE_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/gtest_prod_util.h"
+#include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/sequenced_task_runner.h"
+#include "components/safe_browsing_db/safebrowsing.pb.h"
 
 namespace safe_browsing {
 
 class V4Store;
 
+// A hash prefix of a list, of 4 to 32 bytes.
+typedef std::string HashPrefix;
+
+// The full SHA256 hash of a URL expression, of 32 bytes.
+typedef std::string FullHash;
+
 // Factory for creating V4Store. Tests implement this factory to create fake
 // stores for testing.
 class V4StoreFactory {
@@ -23,6 +40,13 @@ class V4StoreFactory {
       const base::FilePath& store_path);
 };
 
+// Stores the hash prefixes of a list on disk, in a file which is mapped into
+// memory and searched in place. The prefixes are grouped by length, and each
+// group is sorted, so a full hash is looked up with a binary search per group;
+// almost all the prefixes of a list are 4 bytes long, so there are few groups.
+// Updates are merged with the current prefixes into a new file, reading the
+// old file and the update once, in order, rather than building the new list in
+// memory.
 class V4Store {
  public:
   // The |task_runner| is used to ensure that the operations in this file are
@@ -32,9 +56,34 @@ class V4Store {
           const base::FilePath& store_path);
   virtual ~V4Store();
 
+  // Maps the file of the store into memory. A missing file makes an empty
+  // store, as does a corrupt one, which is deleted; both then need a full
+  // update. Returns false if the file was corrupt.
+  virtual bool Initialize();
+
+  // Applies |response|, a full or partial update of the list of this store,
+  // and saves its new client state. Only raw additions and removals are
+  // supported: there is no Rice-Golomb decoder, so Rice encoded updates are
+  // rejected. Returns false, leaving the store unchanged, if the update is not
+  // supported or not valid, or if the checksum of the resulting list does not
+  // match that of |response|.
+  virtual bool ApplyUpdate(
+      const FetchThreatListUpdatesResponse::ListUpdateResponse& response);
+
+  // Returns the prefix of |full_hash| which is in the store, or an empty
+  // string if there is none.
+  HashPrefix GetMatchingHashPrefix(const FullHash& full_hash) const;
+
+  // Returns the number of hash prefixes in the store.
+  size_t GetPrefixCount() const;
+
   // Reset internal state and delete the backing file.
   virtual bool Reset();
 
+  // The opaque client state of the list after the last update, to be sent
+  // with the next update request. Empty if the store was never updated.
+  const std::string& state() const { return state_; }
+
   const base::FilePath& store_path() const {
     return store_path_;
   }
@@ -43,6 +92,31 @@ class V4Store {
   const scoped_refptr<base::SequencedTaskRunner> task_runner_;
   const base::FilePath store_path_;
 
+ private:
+  FRIEND_TEST_ALL_PREFIXES(V4StorePerfTest, Lookup);
+
+  // The sorted hash prefixes of one size, in the mapped file.
+  struct PrefixGroup {
+    size_t prefix_size;
+    size_t prefix_count;
+    const char* prefixes;
+  };
+
+  // Validates the mapped |file_| and fills |groups_| and |state_| from it.
+  bool ParseFile();
+
+  // Returns true if |group| has the prefix of |full_hash| of its size.
+  static bool GroupContains(const PrefixGroup& group,
+                            const FullHash& full_hash);
+
+  // The mapped file, or null if the store is empty.
+  std::unique_ptr<base::MemoryMappedFile> file_;
+
+  // The groups of prefixes in |file_|, by increasing prefix size.
+  std::vector<PrefixGroup> groups_;
+
+  std::string state_;
+
   DISALLOW_COPY_AND_ASSIGN(V4Store);
 };
 
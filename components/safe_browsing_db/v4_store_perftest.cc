@@ -0,0 +1,146 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "components/safe_browsing_db/v4_store.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/rand_util.h"
+#include "base/test/test_simple_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace safe_browsing {
+
+namespace {
+
+typedef FetchThreatListUpdatesResponse::ListUpdateResponse ListUpdateResponse;
+
+// Number of 4-byte prefixes of a large list, like the malware list.
+const size_t kNumPrefixes = 2000000;
+
+// Number of full hashes in the list, for the prefixes which collide.
+const size_t kNumFullHashes = 1000;
+
+// Number of prefixes added and removed by a large partial update.
+const size_t kNumAddedPrefixes = 1000000;
+const size_t kNumRemovedPrefixes = 10000;
+
+// Number of full hashes looked up.
+const size_t kNumLookups = 1000000;
+
+// Returns |count| distinct random prefixes of |prefix_size| bytes, sorted and
+// concatenated.
+std::string RandomPrefixes(size_t prefix_size, size_t count) {
+  std::set<std::string> prefixes;
+  while (prefixes.size() < count)
+    prefixes.insert(base::RandBytesAsString(prefix_size));
+  std::string hashes;
+  hashes.reserve(prefix_size * count);
+  for (const std::string& prefix : prefixes)
+    hashes += prefix;
+  return hashes;
+}
+
+void AddRawHashes(size_t prefix_size,
+                  const std::string& hashes,
+                  ListUpdateResponse* response) {
+  ThreatEntrySet* additions = response->add_additions();
+  additions->set_compression_type(RAW);
+  additions->mutable_raw_hashes()->set_prefix_size(prefix_size);
+  additions->mutable_raw_hashes()->set_raw_hashes(hashes);
+}
+
+void PrintTime(const std::string& measurement, base::TimeDelta elapsed) {
+  perf_test::PrintResult(measurement, "", "v4_store", elapsed.InMillisecondsF(),
+                         "ms", true);
+}
+
+}  // namespace
+
+// Measures the time to apply a full update of a large list and a partial
+// update adding a million prefixes to it, the rate of lookups in the mapped
+// store, and how much of it they make resident.
+TEST(V4StorePerfTest, Lookup) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner(
+      new base::TestSimpleTaskRunner);
+  V4Store store(task_runner, temp_dir.path().AppendASCII("V4Store.store"));
+  ASSERT_TRUE(store.Initialize());
+
+  ListUpdateResponse full_update;
+  full_update.set_response_type(ListUpdateResponse::FULL_UPDATE);
+  AddRawHashes(4, RandomPrefixes(4, kNumPrefixes), &full_update);
+  AddRawHashes(32, RandomPrefixes(32, kNumFullHashes), &full_update);
+  base::ElapsedTimer full_update_timer;
+  ASSERT_TRUE(store.ApplyUpdate(full_update));
+  PrintTime("apply_full_update", full_update_timer.Elapsed());
+  full_update.Clear();
+
+  ListUpdateResponse partial_update;
+  partial_update.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, RandomPrefixes(4, kNumAddedPrefixes), &partial_update);
+  std::set<int32_t> removals;
+  while (removals.size() < kNumRemovedPrefixes)
+    removals.insert(base::RandGenerator(kNumPrefixes + kNumFullHashes));
+  ThreatEntrySet* removal_set = partial_update.add_removals();
+  removal_set->set_compression_type(RAW);
+  for (int32_t index : removals)
+    removal_set->mutable_raw_indices()->add_indices(index);
+  base::ElapsedTimer partial_update_timer;
+  ASSERT_TRUE(store.ApplyUpdate(partial_update));
+  PrintTime("apply_partial_update", partial_update_timer.Elapsed());
+  partial_update.Clear();
+
+  // Random prefixes may collide with the added ones.
+  const size_t num_prefixes = store.GetPrefixCount();
+  EXPECT_LE(kNumPrefixes + kNumFullHashes - kNumRemovedPrefixes, num_prefixes);
+  EXPECT_GE(kNumPrefixes + kNumFullHashes + kNumAddedPrefixes -
+                kNumRemovedPrefixes,
+            num_prefixes);
+
+  std::vector<FullHash> full_hashes;
+  full_hashes.reserve(kNumLookups);
+  for (size_t i = 0; i < kNumLookups; ++i)
+    full_hashes.push_back(base::RandBytesAsString(32));
+  size_t matches = 0;
+  base::ElapsedTimer lookup_timer;
+  for (const FullHash& full_hash : full_hashes) {
+    if (!store.GetMatchingHashPrefix(full_hash).empty())
+      ++matches;
+  }
+  const base::TimeDelta lookup_time = lookup_timer.Elapsed();
+  perf_test::PrintResult("lookups", "", "v4_store",
+                         kNumLookups / lookup_time.InSecondsF(), "lookups/s",
+                         true);
+  // About one random hash in a thousand matches a 4-byte prefix.
+  EXPECT_GT(kNumLookups / 100, matches);
+
+  int64_t file_size = 0;
+  ASSERT_TRUE(base::GetFileSize(store.store_path(), &file_size));
+  perf_test::PrintResult("file_size", "", "v4_store",
+                         file_size / (1024.0 * 1024.0), "MB", false);
+#if defined(COUNT_RESIDENT_BYTES_SUPPORTED)
+  // The mapping starts at a page boundary.
+  const size_t resident_bytes =
+      base::trace_event::ProcessMemoryDump::CountResidentBytes(
+          const_cast<uint8_t*>(store.file_->data()), store.file_->length());
+  perf_test::PrintResult("resident_memory", "", "v4_store",
+                         resident_bytes / (1024.0 * 1024.0), "MB", true);
+#endif
+}
+
+}  // namespace safe_browsing
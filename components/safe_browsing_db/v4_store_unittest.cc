@@ -0,0 +1,236 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "components/safe_browsing_db/v4_store.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/test/test_simple_task_runner.h"
+#include "crypto/sha2.h"
+#include "testing/platform_test.h"
+
+namespace safe_browsing {
+
+namespace {
+
+typedef FetchThreatListUpdatesResponse::ListUpdateResponse ListUpdateResponse;
+
+// Returns a full hash starting with |prefix|.
+FullHash FullHashWithPrefix(const std::string& prefix) {
+  return prefix + std::string(32 - prefix.size(), 'x');
+}
+
+void AddRawHashes(size_t prefix_size,
+                  const std::string& hashes,
+                  ListUpdateResponse* response) {
+  ThreatEntrySet* additions = response->add_additions();
+  additions->set_compression_type(RAW);
+  additions->mutable_raw_hashes()->set_prefix_size(prefix_size);
+  additions->mutable_raw_hashes()->set_raw_hashes(hashes);
+}
+
+void AddRawIndices(const std::vector<int32_t>& indices,
+                   ListUpdateResponse* response) {
+  ThreatEntrySet* removals = response->add_removals();
+  removals->set_compression_type(RAW);
+  for (int32_t index : indices)
+    removals->mutable_raw_indices()->add_indices(index);
+}
+
+}  // namespace
+
+class V4StoreTest : public PlatformTest {
+ public:
+  V4StoreTest() : task_runner_(new base::TestSimpleTaskRunner) {}
+
+  void SetUp() override {
+    PlatformTest::SetUp();
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    store_path_ = temp_dir_.path().AppendASCII("V4StoreTest.store");
+  }
+
+  std::unique_ptr<V4Store> CreateStore() {
+    std::unique_ptr<V4Store> store(new V4Store(task_runner_, store_path_));
+    EXPECT_TRUE(store->Initialize());
+    return store;
+  }
+
+  // Returns a full update with the 4-byte prefixes "aaaa", "cccc" and
+  // "eeee", and the 5-byte prefix "bbbbb".
+  ListUpdateResponse FullUpdate() {
+    ListUpdateResponse response;
+    response.set_response_type(ListUpdateResponse::FULL_UPDATE);
+    AddRawHashes(4, "aaaacccceeee", &response);
+    AddRawHashes(5, "bbbbb", &response);
+    response.set_new_client_state("state1");
+    return response;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath store_path_;
+  scoped_refptr<base::TestSimpleTaskRunner> task_runner_;
+};
+
+TEST_F(V4StoreTest, TestEmptyStore) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  EXPECT_EQ(0u, store->GetPrefixCount());
+  EXPECT_TRUE(store->state().empty());
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("aaaa")).empty());
+}
+
+TEST_F(V4StoreTest, TestFullUpdate) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  EXPECT_TRUE(store->ApplyUpdate(FullUpdate()));
+  EXPECT_EQ(4u, store->GetPrefixCount());
+  EXPECT_EQ("state1", store->state());
+  EXPECT_EQ("aaaa", store->GetMatchingHashPrefix(FullHashWithPrefix("aaaa")));
+  EXPECT_EQ("eeee", store->GetMatchingHashPrefix(FullHashWithPrefix("eeee")));
+  EXPECT_EQ("bbbbb",
+            store->GetMatchingHashPrefix(FullHashWithPrefix("bbbbb")));
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("bbbb")).empty());
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("dddd")).empty());
+
+  // A full update replaces the prefixes of the store.
+  ListUpdateResponse response;
+  response.set_response_type(ListUpdateResponse::FULL_UPDATE);
+  AddRawHashes(4, "dddd", &response);
+  EXPECT_TRUE(store->ApplyUpdate(response));
+  EXPECT_EQ(1u, store->GetPrefixCount());
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("aaaa")).empty());
+  EXPECT_EQ("dddd", store->GetMatchingHashPrefix(FullHashWithPrefix("dddd")));
+}
+
+TEST_F(V4StoreTest, TestPartialUpdate) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  ASSERT_TRUE(store->ApplyUpdate(FullUpdate()));
+
+  // The list is "aaaa", "bbbbb", "cccc", "eeee", so this removes "bbbbb" and
+  // "eeee".
+  ListUpdateResponse response;
+  response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, "ddddffff", &response);
+  AddRawHashes(6, "aaaaaa", &response);
+  AddRawIndices({3, 1}, &response);
+  response.set_new_client_state("state2");
+  EXPECT_TRUE(store->ApplyUpdate(response));
+  EXPECT_EQ(5u, store->GetPrefixCount());
+  EXPECT_EQ("state2", store->state());
+  EXPECT_EQ("aaaa", store->GetMatchingHashPrefix(FullHashWithPrefix("aaaa")));
+  EXPECT_EQ("cccc", store->GetMatchingHashPrefix(FullHashWithPrefix("cccc")));
+  EXPECT_EQ("dddd", store->GetMatchingHashPrefix(FullHashWithPrefix("dddd")));
+  EXPECT_EQ("ffff", store->GetMatchingHashPrefix(FullHashWithPrefix("ffff")));
+  EXPECT_TRUE(
+      store->GetMatchingHashPrefix(FullHashWithPrefix("bbbbb")).empty());
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("eeee")).empty());
+}
+
+TEST_F(V4StoreTest, TestPartialUpdateAddsExistingPrefix) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  ASSERT_TRUE(store->ApplyUpdate(FullUpdate()));
+
+  ListUpdateResponse response;
+  response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, "cccc", &response);
+  EXPECT_TRUE(store->ApplyUpdate(response));
+  EXPECT_EQ(4u, store->GetPrefixCount());
+}
+
+TEST_F(V4StoreTest, TestChecksum) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  ListUpdateResponse response = FullUpdate();
+  response.mutable_checksum()->set_sha256(
+      crypto::SHA256HashString("aaaabbbbbcccceeee"));
+  EXPECT_TRUE(store->ApplyUpdate(response));
+  EXPECT_EQ(4u, store->GetPrefixCount());
+
+  // An update whose checksum does not match leaves the store unchanged.
+  ListUpdateResponse bad_response;
+  bad_response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, "dddd", &bad_response);
+  bad_response.set_new_client_state("state2");
+  bad_response.mutable_checksum()->set_sha256(
+      crypto::SHA256HashString("aaaabbbbbcccceeee"));
+  EXPECT_FALSE(store->ApplyUpdate(bad_response));
+  EXPECT_EQ(4u, store->GetPrefixCount());
+  EXPECT_EQ("state1", store->state());
+  EXPECT_TRUE(store->GetMatchingHashPrefix(FullHashWithPrefix("dddd")).empty());
+  EXPECT_FALSE(base::PathExists(
+      store_path_.AddExtension(FILE_PATH_LITERAL("new"))));
+}
+
+TEST_F(V4StoreTest, TestInvalidUpdates) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  ASSERT_TRUE(store->ApplyUpdate(FullUpdate()));
+
+  // Removal out of range.
+  ListUpdateResponse response;
+  response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawIndices({4}, &response);
+  EXPECT_FALSE(store->ApplyUpdate(response));
+
+  // Unsorted additions.
+  response.Clear();
+  response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, "ddddbbbb", &response);
+  EXPECT_FALSE(store->ApplyUpdate(response));
+
+  // Additions which are not a whole number of prefixes.
+  response.Clear();
+  response.set_response_type(ListUpdateResponse::PARTIAL_UPDATE);
+  AddRawHashes(4, "ddddd", &response);
+  EXPECT_FALSE(store->ApplyUpdate(response));
+
+  // Removals in a full update.
+  response.Clear();
+  response.set_response_type(ListUpdateResponse::FULL_UPDATE);
+  AddRawIndices({0}, &response);
+  EXPECT_FALSE(store->ApplyUpdate(response));
+
+  // Rice-encoded additions.
+  response.Clear();
+  response.set_response_type(ListUpdateResponse::FULL_UPDATE);
+  response.add_additions()->set_compression_type(RICE);
+  EXPECT_FALSE(store->ApplyUpdate(response));
+
+  EXPECT_EQ(4u, store->GetPrefixCount());
+  EXPECT_EQ("state1", store->state());
+}
+
+TEST_F(V4StoreTest, TestReadFromFile) {
+  ASSERT_TRUE(CreateStore()->ApplyUpdate(FullUpdate()));
+
+  std::unique_ptr<V4Store> store = CreateStore();
+  EXPECT_EQ(4u, store->GetPrefixCount());
+  EXPECT_EQ("state1", store->state());
+  EXPECT_EQ("bbbbb",
+            store->GetMatchingHashPrefix(FullHashWithPrefix("bbbbb")));
+}
+
+TEST_F(V4StoreTest, TestCorruptFileIsDeleted) {
+  ASSERT_TRUE(CreateStore()->ApplyUpdate(FullUpdate()));
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(store_path_, &contents));
+  contents.resize(contents.size() - 1);
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(store_path_, contents.data(), contents.size()));
+
+  V4Store store(task_runner_, store_path_);
+  EXPECT_FALSE(store.Initialize());
+  EXPECT_EQ(0u, store.GetPrefixCount());
+  EXPECT_FALSE(base::PathExists(store_path_));
+}
+
+TEST_F(V4StoreTest, TestReset) {
+  std::unique_ptr<V4Store> store = CreateStore();
+  ASSERT_TRUE(store->ApplyUpdate(FullUpdate()));
+  EXPECT_TRUE(store->Reset());
+  EXPECT_EQ(0u, store->GetPrefixCount());
+  EXPECT_TRUE(store->state().empty());
+  EXPECT_FALSE(base::PathExists(store_path_));
+}
+
+}  // namespace safe_browsing
@@ -16,6 +16,19 @@ namespace url_matcher {
 
 namespace {
 
+// Nodes of the compact DFA up to this depth have dense transitions, as long as
+// there are at most |kMaxDenseNodes| of them. Most characters of a text that
+// does not match lead back to one of these nodes.
+const uint32_t kMaxDenseDepth = 2;
+const size_t kMaxDenseNodes = 1024;
+
+// Number of transitions of a dense node of the compact DFA.
+const size_t kAlphabetSize = 256;
+
+// Rough size of a node of a std::map or std::set: three pointers, a color and
+// the value, rounded up by the allocator.
+const size_t kRbTreeNodeSize = 48;
+
 // Compare StringPattern instances based on their string patterns.
 bool ComparePatterns(const StringPattern* a, const StringPattern* b) {
   return a->pattern() < b->pattern();
@@ -57,7 +70,10 @@ uint32_t TreeSize(const std::vector<const StringPattern*>& patterns) {
 // SubstringSetMatcher
 //
 
-SubstringSetMatcher::SubstringSetMatcher() {
+SubstringSetMatcher::SubstringSetMatcher() : SubstringSetMatcher(TREE) {}
+
+SubstringSetMatcher::SubstringSetMatcher(Representation representation)
+    : representation_(representation) {
   RebuildAhoCorasickTree(SubstringPatternVector());
 }
 
@@ -110,6 +126,20 @@ void SubstringSetMatcher::RegisterAndUnregisterPatterns(
 
 bool SubstringSetMatcher::Match(const std::string& text,
                                 std::set<StringPattern::ID>* matches) const {
+  return representation_ == COMPACT_DFA ? MatchDfa(text, matches)
+                                        : MatchTree(text, matches);
+}
+
+bool SubstringSetMatcher::IsEmpty() const {
+  // An empty tree consists of only the root node.
+  if (representation_ == COMPACT_DFA)
+    return patterns_.empty() && dfa_nodes_.size() == 1u;
+  return patterns_.empty() && tree_.size() == 1u;
+}
+
+bool SubstringSetMatcher::MatchTree(
+    const std::string& text,
+    std::set<StringPattern::ID>* matches) const {
   const size_t old_number_of_matches = matches->size();
 
   // Handle patterns matching the empty string.
@@ -135,9 +165,56 @@ bool SubstringSetMatcher::Match(const std::string& text,
   return old_number_of_matches != matches->size();
 }
 
-bool SubstringSetMatcher::IsEmpty() const {
-  // An empty tree consists of only the root node.
-  return patterns_.empty() && tree_.size() == 1u;
+bool SubstringSetMatcher::MatchDfa(const std::string& text,
+                                   std::set<StringPattern::ID>* matches) const {
+  const size_t old_number_of_matches = matches->size();
+
+  // Handle patterns matching the empty string.
+  matches->insert(match_ids_.begin() + dfa_nodes_[0].matches_begin,
+                  match_ids_.begin() + dfa_nodes_[0].matches_end);
+
+  const uint8_t* const labels = edge_labels_.data();
+  uint32_t current_node = 0;
+  for (std::string::const_iterator i = text.begin(); i != text.end(); ++i) {
+    const uint8_t c = static_cast<uint8_t>(*i);
+    // The root is dense, so this ends at the latest when the failure edges
+    // lead back to it.
+    while (true) {
+      const DfaNode& node = dfa_nodes_[current_node];
+      if (node.edge_count == DfaNode::kDenseNode) {
+        current_node = dense_transitions_[node.edges_begin * kAlphabetSize + c];
+        break;
+      }
+      const uint8_t* const begin = labels + node.edges_begin;
+      const uint8_t* const end = begin + node.edge_count;
+      const uint8_t* const edge = std::find(begin, end, c);
+      if (edge != end) {
+        current_node = edge_targets_[edge - labels];
+        break;
+      }
+      current_node = node.failure;
+    }
+    const DfaNode& node = dfa_nodes_[current_node];
+    if (node.matches_begin != node.matches_end) {
+      matches->insert(match_ids_.begin() + node.matches_begin,
+                      match_ids_.begin() + node.matches_end);
+    }
+  }
+
+  return old_number_of_matches != matches->size();
+}
+
+size_t SubstringSetMatcher::MemoryUsageInBytes() const {
+  size_t size = sizeof(AhoCorasickNode) * tree_.capacity();
+  for (const AhoCorasickNode& node : tree_) {
+    size += kRbTreeNodeSize * (node.edges().size() + node.matches().size());
+  }
+  size += sizeof(DfaNode) * dfa_nodes_.capacity() +
+          sizeof(uint32_t) * dense_transitions_.capacity() +
+          sizeof(uint8_t) * edge_labels_.capacity() +
+          sizeof(uint32_t) * edge_targets_.capacity() +
+          sizeof(StringPattern::ID) * match_ids_.capacity();
+  return size;
 }
 
 void SubstringSetMatcher::RebuildAhoCorasickTree(
@@ -157,6 +234,9 @@ void SubstringSetMatcher::RebuildAhoCorasickTree(
   }
 
   CreateFailureEdges();
+
+  if (representation_ == COMPACT_DFA)
+    CompileDfa();
 }
 
 void SubstringSetMatcher::InsertPatternIntoAhoCorasickTree(
@@ -230,6 +310,90 @@ void SubstringSetMatcher::CreateFailureEdges() {
   }
 }
 
+void SubstringSetMatcher::CompileDfa() {
+  typedef AhoCorasickNode::Edges Edges;
+
+  // Number the nodes in breadth-first order, so that the shallow nodes, which
+  // are visited the most, are together at the front, and a node's failure
+  // edge always leads to a node before it.
+  std::vector<uint32_t> order(1, 0);
+  std::vector<uint32_t> new_index(tree_.size(), 0);
+  std::vector<uint32_t> depth(tree_.size(), 0);
+  order.reserve(tree_.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (const Edges::value_type& edge : tree_[order[i]].edges()) {
+      new_index[edge.second] = order.size();
+      depth[edge.second] = depth[order[i]] + 1;
+      order.push_back(edge.second);
+    }
+  }
+
+  size_t dense_nodes = 0;
+  size_t sparse_edges = 0;
+  size_t match_count = 0;
+  for (uint32_t old_index : order) {
+    const AhoCorasickNode& node = tree_[old_index];
+    if (depth[old_index] <= kMaxDenseDepth && dense_nodes < kMaxDenseNodes)
+      ++dense_nodes;
+    else
+      sparse_edges += node.edges().size();
+    match_count += node.matches().size();
+  }
+
+  dfa_nodes_.clear();
+  dfa_nodes_.shrink_to_fit();
+  dfa_nodes_.resize(order.size());
+  dense_transitions_.clear();
+  dense_transitions_.shrink_to_fit();
+  dense_transitions_.resize(dense_nodes * kAlphabetSize);
+  edge_labels_.clear();
+  edge_labels_.shrink_to_fit();
+  edge_labels_.reserve(sparse_edges);
+  edge_targets_.clear();
+  edge_targets_.shrink_to_fit();
+  edge_targets_.reserve(sparse_edges);
+  match_ids_.clear();
+  match_ids_.shrink_to_fit();
+  match_ids_.reserve(match_count);
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    const AhoCorasickNode& node = tree_[order[i]];
+    DfaNode& dfa_node = dfa_nodes_[i];
+    dfa_node.failure = new_index[node.failure()];
+    dfa_node.matches_begin = match_ids_.size();
+    match_ids_.insert(match_ids_.end(), node.matches().begin(),
+                      node.matches().end());
+    dfa_node.matches_end = match_ids_.size();
+
+    if (i < dense_nodes) {
+      // The failure edge leads to a node before this one, whose row is
+      // complete. Those of the root lead back to it.
+      dfa_node.edges_begin = i;
+      dfa_node.edge_count = DfaNode::kDenseNode;
+      uint32_t* row = &dense_transitions_[i * kAlphabetSize];
+      if (i != 0) {
+        const uint32_t* failure_row =
+            &dense_transitions_[dfa_node.failure * kAlphabetSize];
+        std::copy(failure_row, failure_row + kAlphabetSize, row);
+      }
+      for (const Edges::value_type& edge : node.edges())
+        row[static_cast<uint8_t>(edge.first)] = new_index[edge.second];
+    } else {
+      dfa_node.edges_begin = edge_labels_.size();
+      dfa_node.edge_count = node.edges().size();
+      for (const Edges::value_type& edge : node.edges()) {
+        edge_labels_.push_back(static_cast<uint8_t>(edge.first));
+        edge_targets_.push_back(new_index[edge.second]);
+      }
+    }
+  }
+
+  tree_.clear();
+  tree_.shrink_to_fit();
+}
+
+const uint32_t SubstringSetMatcher::DfaNode::kDenseNode = 0xFFFFFFFF;
+
 const uint32_t SubstringSetMatcher::AhoCorasickNode::kNoSuchEdge = 0xFFFFFFFF;
 
 SubstringSetMatcher::AhoCorasickNode::AhoCorasickNode()
@@ -5,6 +5,7 @@
 #ifndef COMPONENTS_URL_MATCHER_SUBSTRING_SET_MATCHER_H_
 #define COMPONENTS_URL_MATCHER_SUBSTRING_SET_MATCHER_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <limits>
@@ -13,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "components/url_matcher/string_pattern.h"
 #include "components/url_matcher/url_matcher_export.h"
@@ -23,7 +25,22 @@ namespace url_matcher {
 // which string patterns occur in S.
 class URL_MATCHER_EXPORT SubstringSetMatcher {
  public:
+  // How the Aho-Corasick tree is kept for Match().
+  enum Representation {
+    // The nodes of the tree, with a std::map of edges and a std::set of
+    // matches each. Cheapest to rebuild, for small or often changing sets.
+    TREE,
+    // A DFA compiled from the tree after each change: the shallow nodes,
+    // which most characters of a text lead to, have a full row of 256
+    // transitions, and the others a short array of edges and a failure
+    // edge. Nodes and matches are in flat arrays, in breadth-first order.
+    // Takes a fraction of the memory of TREE and matches faster, for large
+    // sets that rarely change.
+    COMPACT_DFA,
+  };
+
   SubstringSetMatcher();
+  explicit SubstringSetMatcher(Representation representation);
   ~SubstringSetMatcher();
 
   // Registers all |patterns|. The ownership remains with the caller.
@@ -51,6 +68,9 @@ class URL_MATCHER_EXPORT SubstringSetMatcher {
   bool IsEmpty() const;
 
  private:
+  FRIEND_TEST_ALL_PREFIXES(SubstringSetMatcherTest, CompactDfaLayout);
+  FRIEND_TEST_ALL_PREFIXES(SubstringSetMatcherPerfTest, Match);
+
   // A node of an Aho Corasick Tree. This is implemented according to
   // http://www.cs.uku.fi/~kilpelai/BSA05/lectures/slides04.pdf
   //
@@ -116,6 +136,23 @@ class URL_MATCHER_EXPORT SubstringSetMatcher {
     Matches matches_;
   };
 
+  // A node of the compact DFA. Its edges are either the row |edges_begin| of
+  // |dense_transitions_|, which has the next node for each character with the
+  // failure edges already followed, or, if |edge_count| is not kDenseNode,
+  // |edge_count| entries of |edge_labels_| and |edge_targets_| from
+  // |edges_begin|, to try before following |failure|.
+  struct DfaNode {
+    static const uint32_t kDenseNode;
+
+    uint32_t edges_begin;
+    uint32_t edge_count;
+    uint32_t failure;
+    // The node's matches, which include those of the nodes its failure edges
+    // lead to, are |match_ids_| from |matches_begin| to |matches_end|.
+    uint32_t matches_begin;
+    uint32_t matches_end;
+  };
+
   typedef std::map<StringPattern::ID, const StringPattern*> SubstringPatternMap;
   typedef std::vector<const StringPattern*> SubstringPatternVector;
 
@@ -128,13 +165,34 @@ class URL_MATCHER_EXPORT SubstringSetMatcher {
   void InsertPatternIntoAhoCorasickTree(const StringPattern* pattern);
   void CreateFailureEdges();
 
+  // Compiles |tree_| into the compact DFA, then clears it.
+  void CompileDfa();
+
+  bool MatchTree(const std::string& text,
+                 std::set<StringPattern::ID>* matches) const;
+  bool MatchDfa(const std::string& text,
+                std::set<StringPattern::ID>* matches) const;
+
+  // Returns an estimate of the memory taken by the tree or the DFA.
+  size_t MemoryUsageInBytes() const;
+
+  const Representation representation_;
+
   // Set of all registered StringPatterns. Used to regenerate the
   // Aho-Corasick tree in case patterns are registered or unregistered.
   SubstringPatternMap patterns_;
 
-  // The nodes of a Aho-Corasick tree.
+  // The nodes of a Aho-Corasick tree. With COMPACT_DFA, only used while the
+  // DFA is compiled.
   std::vector<AhoCorasickNode> tree_;
 
+  // The compact DFA, see DfaNode. The root is the first node.
+  std::vector<DfaNode> dfa_nodes_;
+  std::vector<uint32_t> dense_transitions_;
+  std::vector<uint8_t> edge_labels_;
+  std::vector<uint32_t> edge_targets_;
+  std::vector<StringPattern::ID> match_ids_;
+
   DISALLOW_COPY_AND_ASSIGN(SubstringSetMatcher);
 };
 
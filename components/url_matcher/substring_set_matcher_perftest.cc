@@ -0,0 +1,155 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "components/url_matcher/substring_set_matcher.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace url_matcher {
+
+namespace {
+
+// Number of patterns registered, like the conditions of the declarative rules
+// of a few extensions plus a URL blacklist policy.
+const size_t kNumPatterns = 50000;
+
+// Number of URLs matched against them.
+const size_t kNumUrls = 100000;
+
+// One URL in |kHitInterval| contains a pattern.
+const size_t kHitInterval = 20;
+
+const char* const kWords[] = {
+    "ads",    "analytics", "api",     "app",    "banner", "blog",
+    "cdn",    "cloud",     "content", "data",   "docs",   "files",
+    "games",  "image",     "img",     "login",  "mail",   "maps",
+    "media",  "mobile",    "news",    "pixel",  "play",   "player",
+    "search", "shop",      "social",  "static", "stream", "track",
+    "video",  "web",       "widget",  "www",
+};
+
+const char* const kTlds[] = {".com", ".net", ".org", ".co.uk", ".de", ".io"};
+
+std::string RandomWord() {
+  return kWords[base::RandGenerator(arraysize(kWords))];
+}
+
+// Returns a host like "cdn.media42.net".
+std::string RandomHost() {
+  std::string host = RandomWord();
+  if (base::RandGenerator(2))
+    host = RandomWord() + "." + host;
+  return host + base::SizeTToString(base::RandGenerator(1000)) +
+         kTlds[base::RandGenerator(arraysize(kTlds))];
+}
+
+// Returns a path like "/news/video/7.html".
+std::string RandomPath() {
+  std::string path;
+  for (size_t i = base::RandGenerator(4); i > 0; --i)
+    path += "/" + RandomWord();
+  return path + "/" + base::SizeTToString(base::RandGenerator(100)) + ".html";
+}
+
+// Returns patterns like those URLMatcher registers: mostly host suffixes and
+// hosts with a path prefix, and some query parameters.
+std::vector<std::string> RandomPatterns() {
+  std::vector<std::string> patterns;
+  for (size_t i = 0; i < kNumPatterns; ++i) {
+    switch (base::RandGenerator(3)) {
+      case 0:
+        patterns.push_back("." + RandomHost() + "/");
+        break;
+      case 1:
+        patterns.push_back(RandomHost() + RandomPath());
+        break;
+      case 2:
+        patterns.push_back("?" + RandomWord() + "_id=" +
+                           base::SizeTToString(base::RandGenerator(1000)));
+        break;
+    }
+  }
+  return patterns;
+}
+
+// Returns URLs with random hosts and paths, one in |kHitInterval| containing
+// a pattern.
+std::vector<std::string> RandomUrls(const std::vector<std::string>& patterns) {
+  std::vector<std::string> urls;
+  for (size_t i = 0; i < kNumUrls; ++i) {
+    std::string url = "https://" + RandomHost() + RandomPath() + "?" +
+                      RandomWord() + "=" + RandomWord();
+    if (i % kHitInterval == 0)
+      url += patterns[base::RandGenerator(patterns.size())];
+    urls.push_back(url);
+  }
+  return urls;
+}
+
+}  // namespace
+
+// Compares the time it takes to register a large, realistic set of patterns
+// and to match URLs against it, and the memory it takes, with the tree and
+// the compact DFA.
+TEST(SubstringSetMatcherPerfTest, Match) {
+  const std::vector<std::string> strings = RandomPatterns();
+  const std::vector<std::string> urls = RandomUrls(strings);
+  std::vector<std::unique_ptr<StringPattern>> owned_patterns;
+  std::vector<const StringPattern*> patterns;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    owned_patterns.push_back(
+        base::MakeUnique<StringPattern>(strings[i], static_cast<int>(i)));
+    patterns.push_back(owned_patterns.back().get());
+  }
+
+  size_t expected_matches = 0;
+  for (SubstringSetMatcher::Representation representation :
+       {SubstringSetMatcher::TREE, SubstringSetMatcher::COMPACT_DFA}) {
+    const std::string trace =
+        representation == SubstringSetMatcher::TREE ? "tree" : "compact_dfa";
+
+    SubstringSetMatcher matcher(representation);
+    base::ElapsedTimer register_timer;
+    matcher.RegisterPatterns(patterns);
+    perf_test::PrintResult("register_patterns", "", trace,
+                           register_timer.Elapsed().InMillisecondsF(), "ms",
+                           false);
+    perf_test::PrintResult(
+        "matcher_size", "", trace,
+        matcher.MemoryUsageInBytes() / (1024.0 * 1024.0), "MB", true);
+
+    size_t total_matches = 0;
+    std::set<StringPattern::ID> matches;
+    base::ElapsedTimer match_timer;
+    for (const std::string& url : urls) {
+      matches.clear();
+      matcher.Match(url, &matches);
+      total_matches += matches.size();
+    }
+    const base::TimeDelta elapsed = match_timer.Elapsed();
+    perf_test::PrintResult(
+        "match_url", "", trace,
+        elapsed.InSecondsF() * base::Time::kNanosecondsPerSecond / urls.size(),
+        "ns", true);
+
+    if (representation == SubstringSetMatcher::TREE)
+      expected_matches = total_matches;
+    EXPECT_EQ(expected_matches, total_matches);
+  }
+}
+
+}  // namespace url_matcher
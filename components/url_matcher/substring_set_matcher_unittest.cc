@@ -6,16 +6,22 @@
 
 #include <stddef.h>
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "base/memory/ptr_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace url_matcher {
 
 namespace {
 
+const SubstringSetMatcher::Representation kRepresentations[] = {
+    SubstringSetMatcher::TREE, SubstringSetMatcher::COMPACT_DFA,
+};
+
 void TestOnePattern(const std::string& test_string,
                     const std::string& pattern,
                     bool is_match) {
@@ -25,14 +31,18 @@ void TestOnePattern(const std::string& test_string,
   std::vector<const StringPattern*> patterns;
   StringPattern substring_pattern(pattern, 1);
   patterns.push_back(&substring_pattern);
-  SubstringSetMatcher matcher;
-  matcher.RegisterPatterns(patterns);
-  std::set<int> matches;
-  matcher.Match(test_string, &matches);
+  for (SubstringSetMatcher::Representation representation :
+       kRepresentations) {
+    SubstringSetMatcher matcher(representation);
+    matcher.RegisterPatterns(patterns);
+    std::set<int> matches;
+    matcher.Match(test_string, &matches);
 
-  size_t expected_matches = (is_match ? 1 : 0);
-  EXPECT_EQ(expected_matches, matches.size()) << test;
-  EXPECT_EQ(is_match, matches.find(1) != matches.end()) << test;
+    size_t expected_matches = (is_match ? 1 : 0);
+    EXPECT_EQ(expected_matches, matches.size()) << test << representation;
+    EXPECT_EQ(is_match, matches.find(1) != matches.end()) << test
+                                                          << representation;
+  }
 }
 
 void TestTwoPatterns(const std::string& test_string,
@@ -46,28 +56,70 @@ void TestTwoPatterns(const std::string& test_string,
   StringPattern substring_pattern_1(pattern_1, 1);
   StringPattern substring_pattern_2(pattern_2, 2);
   // In order to make sure that the order in which patterns are registered
-  // does not make any difference we try both permutations.
-  for (int permutation = 0; permutation < 2; ++permutation) {
+  // does not make any difference we try both permutations, with both
+  // representations.
+  for (int permutation = 0; permutation < 4; ++permutation) {
     std::vector<const StringPattern*> patterns;
-    if (permutation == 0) {
+    if (permutation % 2 == 0) {
       patterns.push_back(&substring_pattern_1);
       patterns.push_back(&substring_pattern_2);
     } else {
       patterns.push_back(&substring_pattern_2);
       patterns.push_back(&substring_pattern_1);
     }
-    SubstringSetMatcher matcher;
+    SubstringSetMatcher matcher(kRepresentations[permutation / 2]);
     matcher.RegisterPatterns(patterns);
     std::set<int> matches;
     matcher.Match(test_string, &matches);
 
     size_t expected_matches = (is_match_1 ? 1 : 0) + (is_match_2 ? 1 : 0);
-    EXPECT_EQ(expected_matches, matches.size()) << test;
-    EXPECT_EQ(is_match_1, matches.find(1) != matches.end()) << test;
-    EXPECT_EQ(is_match_2, matches.find(2) != matches.end()) << test;
+    EXPECT_EQ(expected_matches, matches.size()) << test << permutation;
+    EXPECT_EQ(is_match_1, matches.find(1) != matches.end()) << test
+                                                            << permutation;
+    EXPECT_EQ(is_match_2, matches.find(2) != matches.end()) << test
+                                                            << permutation;
   }
 }
 
+void TestRegisterAndRemove(
+    SubstringSetMatcher::Representation representation) {
+  SubstringSetMatcher matcher(representation);
+  StringPattern pattern_1("a", 1);
+  StringPattern pattern_2("b", 2);
+  StringPattern pattern_3("c", 3);
+
+  std::vector<const StringPattern*> patterns;
+  patterns.push_back(&pattern_1);
+  matcher.RegisterPatterns(patterns);
+
+  patterns.clear();
+  patterns.push_back(&pattern_2);
+  patterns.push_back(&pattern_3);
+  matcher.RegisterPatterns(patterns);
+
+  std::set<int> matches;
+  matcher.Match("abd", &matches);
+  EXPECT_EQ(2u, matches.size());
+  EXPECT_TRUE(matches.end() != matches.find(1));
+  EXPECT_TRUE(matches.end() != matches.find(2));
+
+  patterns.clear();
+  patterns.push_back(&pattern_2);
+  matcher.UnregisterPatterns(patterns);
+
+  matches.clear();
+  matcher.Match("abd", &matches);
+  EXPECT_EQ(1u, matches.size());
+  EXPECT_TRUE(matches.end() != matches.find(1));
+  EXPECT_TRUE(matches.end() == matches.find(2));
+
+  patterns.clear();
+  patterns.push_back(&pattern_1);
+  patterns.push_back(&pattern_3);
+  matcher.UnregisterPatterns(patterns);
+  EXPECT_TRUE(matcher.IsEmpty());
+}
+
 }  // namespace
 
 TEST(SubstringSetMatcherTest, TestMatcher) {
@@ -124,49 +176,119 @@ TEST(SubstringSetMatcherTest, TestMatcher) {
 }
 
 TEST(SubstringSetMatcherTest, RegisterAndRemove) {
-  SubstringSetMatcher matcher;
+  for (SubstringSetMatcher::Representation representation :
+       kRepresentations) {
+    SCOPED_TRACE(representation);
+    TestRegisterAndRemove(representation);
+  }
+}
 
-  StringPattern pattern_1("a", 1);
-  StringPattern pattern_2("b", 2);
-  StringPattern pattern_3("c", 3);
+TEST(SubstringSetMatcherTest, TestEmptyMatcher) {
+  for (SubstringSetMatcher::Representation representation :
+       kRepresentations) {
+    SubstringSetMatcher matcher(representation);
+    std::set<int> matches;
+    matcher.Match("abd", &matches);
+    EXPECT_TRUE(matches.empty());
+    EXPECT_TRUE(matcher.IsEmpty());
+  }
+}
 
+// Checks that the compact DFA finds the same matches as the tree in a set
+// with more shallow nodes than get dense transitions, and tails long enough
+// to follow several failure edges in a row.
+TEST(SubstringSetMatcherTest, CompactDfaMatchesTree) {
+  // 41 * 41 nodes at depth 2 are more than get dense transitions.
+  const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789./?=&";
+  std::vector<std::string> strings;
+  for (const char* c1 = kAlphabet; *c1; ++c1) {
+    for (const char* c2 = kAlphabet; *c2; ++c2) {
+      for (const char* c3 = "ab."; *c3; ++c3)
+        strings.push_back(std::string() + *c1 + *c2 + *c3 + "ab" + *c1);
+    }
+  }
+  strings.push_back("a");
+  strings.push_back("b.");
+  strings.push_back("abababab");
+  strings.push_back("/a/b/c/");
+  strings.push_back(std::string("\x80\xff", 2));
+
+  std::vector<std::unique_ptr<StringPattern>> owned_patterns;
   std::vector<const StringPattern*> patterns;
-  patterns.push_back(&pattern_1);
-  matcher.RegisterPatterns(patterns);
+  for (size_t i = 0; i < strings.size(); ++i) {
+    owned_patterns.push_back(
+        base::MakeUnique<StringPattern>(strings[i], static_cast<int>(i)));
+    patterns.push_back(owned_patterns.back().get());
+  }
 
-  patterns.clear();
+  SubstringSetMatcher tree(SubstringSetMatcher::TREE);
+  SubstringSetMatcher dfa(SubstringSetMatcher::COMPACT_DFA);
+  tree.RegisterPatterns(patterns);
+  dfa.RegisterPatterns(patterns);
+
+  const char* const kTexts[] = {
+      "", "a", "abababababab", "http://a.b/c/abcab.c.ab.", "/a/b/c/a/b/c/",
+      "c.ab/.abc.ab.cab/", "?q=x.aab&y=./a.ab.", "xyz\x80\xff" "abc",
+  };
+  for (const char* text : kTexts) {
+    std::set<int> tree_matches;
+    std::set<int> dfa_matches;
+    EXPECT_EQ(tree.Match(text, &tree_matches), dfa.Match(text, &dfa_matches));
+    EXPECT_EQ(tree_matches, dfa_matches) << text;
+  }
+
+  // Every string matches itself and the strings it contains.
+  for (const std::string& text : strings) {
+    std::set<int> tree_matches;
+    std::set<int> dfa_matches;
+    EXPECT_TRUE(tree.Match(text, &tree_matches));
+    EXPECT_TRUE(dfa.Match(text, &dfa_matches));
+    EXPECT_EQ(tree_matches, dfa_matches) << text;
+  }
+}
+
+// Checks which nodes of the compact DFA get dense transitions.
+TEST(SubstringSetMatcherTest, CompactDfaLayout) {
+  StringPattern pattern_1("abcd", 1);
+  StringPattern pattern_2("abx", 2);
+  StringPattern pattern_3("bc", 3);
+  std::vector<const StringPattern*> patterns;
+  patterns.push_back(&pattern_1);
   patterns.push_back(&pattern_2);
   patterns.push_back(&pattern_3);
+  SubstringSetMatcher matcher(SubstringSetMatcher::COMPACT_DFA);
   matcher.RegisterPatterns(patterns);
 
-  std::set<int> matches;
-  matcher.Match("abd", &matches);
-  EXPECT_EQ(2u, matches.size());
-  EXPECT_TRUE(matches.end() != matches.find(1));
-  EXPECT_TRUE(matches.end() != matches.find(2));
+  // The tree is only kept while the DFA is compiled.
+  EXPECT_TRUE(matcher.tree_.empty());
 
-  patterns.clear();
-  patterns.push_back(&pattern_2);
-  matcher.UnregisterPatterns(patterns);
+  // The nodes, in breadth-first order, are: the root, "a", "b", "ab", "bc",
+  // "abc", "abx" and "abcd".
+  ASSERT_EQ(8u, matcher.dfa_nodes_.size());
+  const SubstringSetMatcher::DfaNode* nodes = matcher.dfa_nodes_.data();
+  for (size_t i = 0; i < 5; ++i)
+    EXPECT_EQ(SubstringSetMatcher::DfaNode::kDenseNode, nodes[i].edge_count);
+  EXPECT_EQ(5u * 256, matcher.dense_transitions_.size());
 
-  matches.clear();
-  matcher.Match("abd", &matches);
-  EXPECT_EQ(1u, matches.size());
-  EXPECT_TRUE(matches.end() != matches.find(1));
-  EXPECT_TRUE(matches.end() == matches.find(2));
+  // The row of "ab" has its own edges to "abc" and "abx", and for the other
+  // characters, those of "b" and the root, where its failure edges lead.
+  const uint32_t* ab_row = &matcher.dense_transitions_[3 * 256];
+  EXPECT_EQ(5u, ab_row['c']);
+  EXPECT_EQ(6u, ab_row['x']);
+  EXPECT_EQ(1u, ab_row['a']);
+  EXPECT_EQ(2u, ab_row['b']);
+  EXPECT_EQ(0u, ab_row['d']);
 
-  patterns.clear();
-  patterns.push_back(&pattern_1);
-  patterns.push_back(&pattern_3);
-  matcher.UnregisterPatterns(patterns);
-  EXPECT_TRUE(matcher.IsEmpty());
-}
+  // "abc" is sparse, with one edge and a failure edge to "bc".
+  EXPECT_EQ(1u, nodes[5].edge_count);
+  EXPECT_EQ('d', matcher.edge_labels_[nodes[5].edges_begin]);
+  EXPECT_EQ(7u, matcher.edge_targets_[nodes[5].edges_begin]);
+  EXPECT_EQ(4u, nodes[5].failure);
 
-TEST(SubstringSetMatcherTest, TestEmptyMatcher) {
-  SubstringSetMatcher matcher;
-  std::set<int> matches;
-  matcher.Match("abd", &matches);
-  EXPECT_TRUE(matches.empty());
+  // "abc" matches "bc" through its failure edge.
+  EXPECT_EQ(1u, nodes[5].matches_end - nodes[5].matches_begin);
+  EXPECT_EQ(3, matcher.match_ids_[nodes[5].matches_begin]);
+  EXPECT_EQ(nodes[0].matches_begin, nodes[0].matches_end);
 }
 
 }  // namespace url_matcher
@@ -804,7 +804,9 @@ bool URLMatcherConditionSet::IsMatch(
 // URLMatcher
 //
 
-URLMatcher::URLMatcher() {}
+URLMatcher::URLMatcher()
+    : full_url_matcher_(SubstringSetMatcher::COMPACT_DFA),
+      url_component_matcher_(SubstringSetMatcher::COMPACT_DFA) {}
 
 URLMatcher::~URLMatcher() {}
 
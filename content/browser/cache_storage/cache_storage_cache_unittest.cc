@@ -81,6 +81,12 @@ class DelayableBackend : public disk_cache::Backend {
 
     return backend_->OpenEntry(key, entry, callback);
   }
+  int OpenEntryWithReadAhead(const std::string& key,
+                             disk_cache::Entry** entry,
+                             int read_ahead_size,
+                             const CompletionCallback& callback) override {
+    return OpenEntry(key, entry, callback);
+  }
   int CreateEntry(const std::string& key,
                   disk_cache::Entry** entry,
                   const CompletionCallback& callback) override {
@@ -220,34 +220,6 @@ struct CookieSignature {
   std::string path;
 };
 
-// For a CookieItVector iterator range [|it_begin|, |it_end|),
-// sorts the first |num_sort| + 1 elements by LastAccessDate().
-// The + 1 element exists so for any interval of length <= |num_sort| starting
-// from |cookies_its_begin|, a LastAccessDate() bound can be found.
-void SortLeastRecentlyAccessed(CookieMonster::CookieItVector::iterator it_begin,
-                               CookieMonster::CookieItVector::iterator it_end,
-                               size_t num_sort) {
-  DCHECK_LT(static_cast<int>(num_sort), it_end - it_begin);
-  std::partial_sort(it_begin, it_begin + num_sort + 1, it_end, LRACookieSorter);
-}
-
-// Given a single cookie vector |cookie_its|, pushs all of the secure cookies in
-// |cookie_its| into |secure_cookie_its| and all of the non-secure cookies into
-// |non_secure_cookie_its|. Both |secure_cookie_its| and |non_secure_cookie_its|
-// must be non-NULL.
-void SplitCookieVectorIntoSecureAndNonSecure(
-    const CookieMonster::CookieItVector& cookie_its,
-    CookieMonster::CookieItVector* secure_cookie_its,
-    CookieMonster::CookieItVector* non_secure_cookie_its) {
-  DCHECK(secure_cookie_its && non_secure_cookie_its);
-  for (const auto& curit : cookie_its) {
-    if (curit->second->IsSecure())
-      secure_cookie_its->push_back(curit);
-    else
-      non_secure_cookie_its->push_back(curit);
-  }
-}
-
 bool LowerBoundAccessDateComparator(const CookieMonster::CookieMap::iterator it,
                                     const Time& access_date) {
   return it->second->LastAccessDate() < access_date;
@@ -360,6 +332,24 @@ bool IsCookieEligibleForEviction(CookiePriority current_priority_level,
 
 }  // namespace
 
+bool CookieMonster::LRACookieOrder::operator()(
+    const CookieMap::iterator& a,
+    const CookieMap::iterator& b) const {
+  if (LRACookieSorter(a, b))
+    return true;
+  if (LRACookieSorter(b, a))
+    return false;
+  return std::less<CanonicalCookie*>()(a->second, b->second);
+}
+
+bool CookieMonster::ExpiryCookieOrder::operator()(
+    const CookieMap::iterator& a,
+    const CookieMap::iterator& b) const {
+  if (a->second->ExpiryDate() != b->second->ExpiryDate())
+    return a->second->ExpiryDate() < b->second->ExpiryDate();
+  return std::less<CanonicalCookie*>()(a->second, b->second);
+}
+
 CookieMonster::CookieMonster(PersistentCookieStore* store,
                              CookieMonsterDelegate* delegate)
     : CookieMonster(
@@ -1117,8 +1107,7 @@ CookieList CookieMonster::GetAllCookies() {
   //
   // Note that this does not prune cookies to be below our limits (if we've
   // exceeded them) the way that calling GarbageCollect() would.
-  GarbageCollectExpired(
-      Time::Now(), CookieMapItPair(cookies_.begin(), cookies_.end()), NULL);
+  GarbageCollectAllExpired(Time::Now());
 
   // Copy the CanonicalCookie pointers from the map so that we can use the same
   // sorter as elsewhere, then copy the result out.
@@ -1148,7 +1137,7 @@ CookieList CookieMonster::GetCookieListWithOptions(
 
   std::vector<CanonicalCookie*> cookie_ptrs;
   FindCookiesForHostAndDomain(url, options, &cookie_ptrs);
-  std::sort(cookie_ptrs.begin(), cookie_ptrs.end(), CookieSorter);
+  DCHECK(std::is_sorted(cookie_ptrs.begin(), cookie_ptrs.end(), CookieSorter));
 
   cookies.reserve(cookie_ptrs.size());
   for (std::vector<CanonicalCookie*>::const_iterator it = cookie_ptrs.begin();
@@ -1224,7 +1213,7 @@ std::string CookieMonster::GetCookiesWithOptions(const GURL& url,
 
   std::vector<CanonicalCookie*> cookies;
   FindCookiesForHostAndDomain(url, options, &cookies);
-  std::sort(cookies.begin(), cookies.end(), CookieSorter);
+  DCHECK(std::is_sorted(cookies.begin(), cookies.end(), CookieSorter));
 
   std::string cookie_line = BuildCookieLine(cookies);
 
@@ -1630,7 +1619,7 @@ void CookieMonster::FindCookiesForKey(const std::string& key,
     // Add this cookie to the set of matching cookies. Update the access
     // time if we've been requested to do so.
     if (options.update_access_time()) {
-      InternalUpdateCookieAccessTime(cc, current);
+      InternalUpdateCookieAccessTime(curit, current);
     }
     cookies->push_back(cc);
   }
@@ -1714,8 +1703,16 @@ CookieMonster::CookieMap::iterator CookieMonster::InternalInsertCookie(
   if ((cc->IsPersistent() || persist_session_cookies_) && store_.get() &&
       sync_to_store)
     store_->AddCookie(*cc);
+  // Keep the cookies of |key| in CookieSorter() order by inserting |cc| before
+  // the first cookie that should be returned after it.
+  CookieMapItPair its = cookies_.equal_range(key);
+  while (its.first != its.second && !CookieSorter(cc, its.first->second))
+    ++its.first;
   CookieMap::iterator inserted =
-      cookies_.insert(CookieMap::value_type(key, cc));
+      cookies_.insert(its.first, CookieMap::value_type(key, cc));
+  cookies_by_access_date_.insert(inserted);
+  if (cc->IsPersistent())
+    cookies_by_expiry_date_.insert(inserted);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(*cc, false,
                                CookieMonsterDelegate::CHANGE_COOKIE_EXPLICIT);
@@ -1846,10 +1843,12 @@ bool CookieMonster::SetCanonicalCookies(const CookieList& list) {
   return true;
 }
 
-void CookieMonster::InternalUpdateCookieAccessTime(CanonicalCookie* cc,
+void CookieMonster::InternalUpdateCookieAccessTime(CookieMap::iterator it,
                                                    const Time& current) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
+  CanonicalCookie* cc = it->second;
+
   // Based off the Mozilla code.  When a cookie has been accessed recently,
   // don't bother updating its access time again.  This reduces the number of
   // updates we do during pageload, which in turn reduces the chance our storage
@@ -1857,7 +1856,10 @@ void CookieMonster::InternalUpdateCookieAccessTime(CanonicalCookie* cc,
   if ((current - cc->LastAccessDate()) < last_access_threshold_)
     return;
 
+  // The access date is part of the ordering of |cookies_by_access_date_|.
+  cookies_by_access_date_.erase(it);
   cc->SetLastAccessDate(current);
+  cookies_by_access_date_.insert(it);
   if ((cc->IsPersistent() || persist_session_cookies_) && store_.get())
     store_->UpdateCookieAccessTime(*cc);
 }
@@ -1894,6 +1896,9 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
   RunCookieChangedCallbacks(*cc, true);
+  cookies_by_access_date_.erase(it);
+  if (cc->IsPersistent())
+    cookies_by_expiry_date_.erase(it);
   cookies_.erase(it);
   delete cc;
 }
@@ -2012,38 +2017,28 @@ size_t CookieMonster::GarbageCollect(const Time& current,
   // cookies accessed in kSafeFromGlobalPurgeDays, otherwise evict.
   if (cookies_.size() > kMaxCookies && earliest_access_time_ < safe_date) {
     VLOG(kVlogGarbageCollection) << "GarbageCollect() everything";
-    CookieItVector cookie_its;
-
-    num_deleted += GarbageCollectExpired(
-        current, CookieMapItPair(cookies_.begin(), cookies_.end()),
-        &cookie_its);
+    num_deleted += GarbageCollectAllExpired(current);
 
-    if (cookie_its.size() > kMaxCookies) {
+    if (cookies_.size() > kMaxCookies) {
       VLOG(kVlogGarbageCollection) << "Deep Garbage Collect everything.";
-      size_t purge_goal = cookie_its.size() - (kMaxCookies - kPurgeCookies);
+      size_t purge_goal = cookies_.size() - (kMaxCookies - kPurgeCookies);
       DCHECK(purge_goal > kPurgeCookies);
 
       if (enforce_strict_secure) {
-        CookieItVector secure_cookie_its;
-        CookieItVector non_secure_cookie_its;
-        SplitCookieVectorIntoSecureAndNonSecure(cookie_its, &secure_cookie_its,
-                                                &non_secure_cookie_its);
-        size_t non_secure_purge_goal =
-            std::min<size_t>(purge_goal, non_secure_cookie_its.size() - 1);
-
         size_t just_deleted = GarbageCollectLeastRecentlyAccessed(
-            current, safe_date, non_secure_purge_goal, non_secure_cookie_its);
+            current, safe_date, purge_goal,
+            GarbageCollectionScope::NON_SECURE_COOKIES);
         num_deleted += just_deleted;
 
         if (just_deleted < purge_goal) {
-          size_t secure_purge_goal = std::min<size_t>(
-              purge_goal - just_deleted, secure_cookie_its.size() - 1);
           num_deleted += GarbageCollectLeastRecentlyAccessed(
-              current, safe_date, secure_purge_goal, secure_cookie_its);
+              current, safe_date, purge_goal - just_deleted,
+              GarbageCollectionScope::SECURE_COOKIES);
         }
       } else {
         num_deleted += GarbageCollectLeastRecentlyAccessed(
-            current, safe_date, purge_goal, cookie_its);
+            current, safe_date, purge_goal,
+            GarbageCollectionScope::ALL_COOKIES);
       }
     }
   }
@@ -2125,6 +2120,21 @@ size_t CookieMonster::GarbageCollectExpired(const Time& current,
   return num_deleted;
 }
 
+size_t CookieMonster::GarbageCollectAllExpired(const Time& current) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  size_t num_deleted = 0;
+  while (!cookies_by_expiry_date_.empty()) {
+    CookieMap::iterator it = *cookies_by_expiry_date_.begin();
+    if (!it->second->IsExpired(current))
+      break;
+    InternalDeleteCookie(it, true, DELETE_COOKIE_EXPIRED);
+    ++num_deleted;
+  }
+
+  return num_deleted;
+}
+
 size_t CookieMonster::GarbageCollectDeleteRange(
     const Time& current,
     DeletionCause cause,
@@ -2144,13 +2154,29 @@ size_t CookieMonster::GarbageCollectLeastRecentlyAccessed(
     const base::Time& current,
     const base::Time& safe_date,
     size_t purge_goal,
-    CookieItVector cookie_its) {
+    GarbageCollectionScope scope) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
-  // Sorts up to *and including* |cookie_its[purge_goal]|, so
-  // |earliest_access_time| will be properly assigned even if
+  // Collects the |purge_goal| + 1 least recently accessed cookies within
+  // |scope|, so |earliest_access_time| will be properly assigned even if
   // |global_purge_it| == |cookie_its.begin() + purge_goal|.
-  SortLeastRecentlyAccessed(cookie_its.begin(), cookie_its.end(), purge_goal);
+  CookieItVector cookie_its;
+  for (const CookieMap::iterator& it : cookies_by_access_date_) {
+    if (cookie_its.size() > purge_goal)
+      break;
+    if ((scope == GarbageCollectionScope::SECURE_COOKIES &&
+         !it->second->IsSecure()) ||
+        (scope == GarbageCollectionScope::NON_SECURE_COOKIES &&
+         it->second->IsSecure())) {
+      continue;
+    }
+    cookie_its.push_back(it);
+  }
+  if (cookie_its.empty())
+    return 0;
+  // Always keep at least one cookie within |scope|.
+  purge_goal = std::min(purge_goal, cookie_its.size() - 1);
+
   // Find boundary to cookies older than safe_date.
   CookieItVector::iterator global_purge_it = LowerBoundAccessDate(
       cookie_its.begin(), cookie_its.begin() + purge_goal, safe_date);
@@ -88,6 +88,10 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // not legal to have domain cookies without an eTLD+1).  This rule
   // excludes cookies for, e.g, ".com", ".co.uk", or ".internalnetwork".
   // This behavior is the same as the behavior in Firefox v 3.6.10.
+  //
+  // The cookies sharing a key are kept in the order in which they are returned
+  // to requests (longest path first, then oldest creation date first), so
+  // matching cookies for a request never requires sorting them.
 
   // NOTE(deanm):
   // I benchmarked hash_multimap vs multimap.  We're going to be query-heavy
@@ -245,6 +249,7 @@ class NET_EXPORT CookieMonster : public CookieStore {
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestTotalGarbageCollection);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, GarbageCollectionTriggers);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestGCTimes);
+  FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestLargeStore);
 
   // For validation of key values.
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestDomainTree);
@@ -374,6 +379,30 @@ class NET_EXPORT CookieMonster : public CookieStore {
     kUnknownFetch,
   };
 
+  // Which cookies GarbageCollectLeastRecentlyAccessed() may evict.
+  enum class GarbageCollectionScope {
+    ALL_COOKIES,
+    SECURE_COOKIES,
+    NON_SECURE_COOKIES,
+  };
+
+  // Orders iterators to |cookies_| from least to most recently accessed
+  // cookie. Ties are broken by creation date, then by address.
+  struct LRACookieOrder {
+    bool operator()(const CookieMap::iterator& a,
+                    const CookieMap::iterator& b) const;
+  };
+
+  // Orders iterators to |cookies_| from earliest to latest expiring cookie.
+  // Ties are broken by address.
+  struct ExpiryCookieOrder {
+    bool operator()(const CookieMap::iterator& a,
+                    const CookieMap::iterator& b) const;
+  };
+
+  typedef std::set<CookieMap::iterator, LRACookieOrder> CookieLRASet;
+  typedef std::set<CookieMap::iterator, ExpiryCookieOrder> CookieExpirySet;
+
   // The number of days since last access that cookies will not be subject
   // to global garbage collection.
   static const int kSafeFromGlobalPurgeDays;
@@ -522,7 +551,7 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // Helper function calling SetCanonicalCookie() for all cookies in |list|.
   bool SetCanonicalCookies(const CookieList& list);
 
-  void InternalUpdateCookieAccessTime(CanonicalCookie* cc,
+  void InternalUpdateCookieAccessTime(CookieMap::iterator it,
                                       const base::Time& current_time);
 
   // |deletion_cause| argument is used for collecting statistics and choosing
@@ -567,6 +596,11 @@ class NET_EXPORT CookieMonster : public CookieStore {
                                const CookieMapItPair& itpair,
                                CookieItVector* cookie_its);
 
+  // Deletes all expired cookies of the store. Only visits the expired cookies.
+  //
+  // Returns the number of cookies deleted.
+  size_t GarbageCollectAllExpired(const base::Time& current);
+
   // Helper for GarbageCollect(). Deletes all cookies in the range specified by
   // [|it_begin|, |it_end|). Returns the number of cookies deleted.
   size_t GarbageCollectDeleteRange(const base::Time& current,
@@ -574,13 +608,13 @@ class NET_EXPORT CookieMonster : public CookieStore {
                                    CookieItVector::iterator cookie_its_begin,
                                    CookieItVector::iterator cookie_its_end);
 
-  // Helper for GarbageCollect(). Deletes cookies in |cookie_its| from least to
-  // most recently used, but only before |safe_date|. Also will stop deleting
-  // when the number of remaining cookies hits |purge_goal|.
+  // Helper for GarbageCollect(). Deletes up to |purge_goal| cookies within
+  // |scope| from least to most recently used, but only those last accessed
+  // before |safe_date|. At least one cookie within |scope| is kept.
   size_t GarbageCollectLeastRecentlyAccessed(const base::Time& current,
                                              const base::Time& safe_date,
                                              size_t purge_goal,
-                                             CookieItVector cookie_its);
+                                             GarbageCollectionScope scope);
 
   // Find the key (for lookup in cookies_) based on the given domain.
   // See comment on keys before the CookieMap typedef.
@@ -642,6 +676,14 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   CookieMap cookies_;
 
+  // All the cookies of |cookies_|, kept in least recently accessed order so
+  // that global garbage collection does not have to sort the whole store.
+  CookieLRASet cookies_by_access_date_;
+
+  // The cookies of |cookies_| that have an expiry date, kept in expiry order so
+  // that expired cookies can be deleted without scanning the whole store.
+  CookieExpirySet cookies_by_expiry_date_;
+
   // Indicates whether the cookie store has been initialized.
   bool initialized_;
 
@@ -315,6 +315,65 @@ TEST_F(CookieMonsterTest, TestImport) {
   EXPECT_EQ("domain_1.com", cm->GetKey("www.Domain_1.com"));
 }
 
+// Measures lookups, updates and garbage collection on a store much larger than
+// kMaxCookies, as seen on proxies: 100k cookies spread over 10k domains, with a
+// quarter of the cookies not accessed for a long time.
+TEST_F(CookieMonsterTest, TestLargeStore) {
+  const int kNumDomains = 10000;
+  const int kNumCookiesPerDomain = 10;
+  const char* const kPaths[] = {"/", "/a", "/a/b", "/a/b/c"};
+
+  scoped_refptr<MockPersistentCookieStore> store(new MockPersistentCookieStore);
+  std::vector<CanonicalCookie*> initial_cookies;
+  std::vector<GURL> gurls;
+  const base::Time now = base::Time::Now();
+  const base::Time old_access_time =
+      now -
+      base::TimeDelta::FromDays(CookieMonster::kSafeFromGlobalPurgeDays * 2);
+  int64_t time_tick(now.ToInternalValue() - kNumDomains * kNumCookiesPerDomain);
+  for (int domain_num = 0; domain_num < kNumDomains; domain_num++) {
+    gurls.push_back(GURL(
+        base::StringPrintf("http://www.domain%05d.com/a/b/c", domain_num)));
+    for (int cookie_num = 0; cookie_num < kNumCookiesPerDomain; cookie_num++) {
+      std::string cookie_line(base::StringPrintf(
+          "Cookie_%d=1; Path=%s; max-age=86400", cookie_num,
+          kPaths[cookie_num % arraysize(kPaths)]));
+      AddCookieToList(gurls.back(), cookie_line,
+                      base::Time::FromInternalValue(time_tick++),
+                      &initial_cookies);
+      if (cookie_num % 4 == 0)
+        initial_cookies.back()->SetLastAccessDate(old_access_time);
+    }
+  }
+  store->SetLoadExpectation(true, initial_cookies);
+
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(store.get(), nullptr));
+  GetCookiesCallback getCookiesCallback;
+  SetCookieCallback setCookieCallback;
+
+  base::PerfTimeLogger timer("Cookie_monster_import_large_store");
+  getCookiesCallback.GetCookies(cm.get(), gurls[0]);
+  timer.Done();
+
+  base::PerfTimeLogger timer2("Cookie_monster_query_large_store");
+  for (int i = 0; i < kNumCookies; i++)
+    getCookiesCallback.GetCookies(cm.get(), gurls[i % gurls.size()]);
+  timer2.Done();
+
+  // The first cookie set triggers the global garbage collection of the old
+  // cookies.
+  base::PerfTimeLogger timer3("Cookie_monster_gc_large_store");
+  setCookieCallback.SetCookie(cm.get(), gurls[0], "z=1");
+  timer3.Done();
+
+  base::PerfTimeLogger timer4("Cookie_monster_update_large_store");
+  for (int i = 0; i < kNumCookies; i++) {
+    setCookieCallback.SetCookie(cm.get(), gurls[i % gurls.size()],
+                                "Cookie_1=2; Path=/a; max-age=86400");
+  }
+  timer4.Done();
+}
+
 TEST_F(CookieMonsterTest, TestGetKey) {
   std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
   base::PerfTimeLogger timer("Cookie_monster_get_key");
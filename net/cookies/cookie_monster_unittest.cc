@@ -2164,6 +2164,33 @@ TEST_F(CookieMonsterTest, CookieListOrdering) {
   }
 }
 
+// Cookies are returned oldest first regardless of the order in which they
+// were inserted, including after some of them are overwritten.
+TEST_F(CookieMonsterTest, CookieOrderingByCreationTime) {
+  std::unique_ptr<CookieMonster> cm(new CookieMonster(nullptr, nullptr));
+  const Time now = Time::Now();
+  const GURL url("http://www.google.com/aa/x.html");
+  const struct {
+    const char* name;
+    const char* path;
+    int age_in_days;
+  } kCookies[] = {
+      {"b", "/aa", 2}, {"c", "/", 1}, {"a", "/aa", 3}, {"d", "/", 4},
+  };
+  for (const auto& cookie : kCookies) {
+    EXPECT_TRUE(SetCookieWithDetails(
+        cm.get(), url, cookie.name, "1", std::string(), cookie.path,
+        now - TimeDelta::FromDays(cookie.age_in_days), Time(), Time(), false,
+        false, CookieSameSite::DEFAULT_MODE, COOKIE_PRIORITY_DEFAULT));
+  }
+  EXPECT_EQ("a=1; b=1; d=1; c=1", GetCookies(cm.get(), url));
+
+  // The overwritten cookie gets a new creation time and moves last within
+  // cookies of the same path length.
+  EXPECT_TRUE(SetCookie(cm.get(), url, "a=2; path=/aa"));
+  EXPECT_EQ("b=1; a=2; d=1; c=1", GetCookies(cm.get(), url));
+}
+
 // This test and CookieMonstertest.TestGCTimes (in cookie_monster_perftest.cc)
 // are somewhat complementary twins.  This test is probing for whether
 // garbage collection always happens when it should (i.e. that we actually
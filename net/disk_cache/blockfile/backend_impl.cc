@@ -56,6 +56,11 @@ const int kBaseTableLen = 64 * 1024;
 // Avoid trimming the cache for the first 5 minutes (10 timer ticks).
 const int kTrimDelay = 10;
 
+// The index is flushed at most this often (in ms) while the cache is busy;
+// opening, creating or dooming an entry, and every change to the rankings
+// lists, would otherwise flush it.
+const int kIndexFlushDelay = 100;
+
 int DesiredIndexTableLen(int32_t storage_size) {
   if (storage_size <= k64kEntriesStore)
     return kBaseTableLen;
@@ -292,7 +297,7 @@ int BackendImpl::SyncInit() {
     ReportError(ERR_NO_ERROR);
   }
 
-  FlushIndex();
+  FlushIndexNow();
 
   if (!disabled_ && should_create_timer) {
     // Create a recurrent timer of 30 secs.
@@ -324,7 +329,8 @@ void BackendImpl::CleanupCache() {
     }
   }
   block_files_.CloseFiles();
-  FlushIndex();
+  FlushIndexNow();
+  flush_timer_.reset();
   index_ = NULL;
   ptr_factory_.InvalidateWeakPtrs();
   done_.Signal();
@@ -1197,8 +1203,16 @@ int BackendImpl::SelfCheck() {
 }
 
 void BackendImpl::FlushIndex() {
-  if (index_.get() && !disabled_)
-    index_->Flush();
+  if (!index_.get() || disabled_)
+    return;
+
+  if (!flush_timer_)
+    flush_timer_.reset(new base::OneShotTimer());
+  if (!flush_timer_->IsRunning()) {
+    flush_timer_->Start(FROM_HERE,
+                        TimeDelta::FromMilliseconds(kIndexFlushDelay), this,
+                        &BackendImpl::FlushIndexNow);
+  }
 }
 
 // ------------------------------------------------------------------------
@@ -1229,6 +1243,13 @@ int BackendImpl::OpenEntry(const std::string& key, Entry** entry,
   return net::ERR_IO_PENDING;
 }
 
+int BackendImpl::OpenEntryWithReadAhead(const std::string& key,
+                                        Entry** entry,
+                                        int read_ahead_size,
+                                        const CompletionCallback& callback) {
+  return OpenEntry(key, entry, callback);
+}
+
 int BackendImpl::CreateEntry(const std::string& key, Entry** entry,
                              const CompletionCallback& callback) {
   DCHECK(!callback.is_null());
@@ -1484,6 +1505,13 @@ void BackendImpl::StoreStats() {
   file->Write(data.get(), size, offset);  // ignore result.
 }
 
+void BackendImpl::FlushIndexNow() {
+  if (flush_timer_)
+    flush_timer_->Stop();
+  if (index_.get() && !disabled_)
+    index_->Flush();
+}
+
 void BackendImpl::RestartCache(bool failure) {
   int64_t errors = stats_.GetCounter(Stats::FATAL_ERROR);
   int64_t full_dooms = stats_.GetCounter(Stats::DOOM_CACHE);
@@ -1521,6 +1549,7 @@ void BackendImpl::PrepareForRestart() {
 
   disabled_ = true;
   data_->header.crash = 0;
+  flush_timer_.reset();
   index_->Flush();
   index_ = NULL;
   data_ = NULL;
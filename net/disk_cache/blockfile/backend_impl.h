@@ -260,7 +260,8 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // or an error code (negative value).
   int SelfCheck();
 
-  // Ensures the index is flushed to disk (a no-op on platforms with mmap).
+  // Ensures the index is flushed to disk soon (a no-op on platforms with
+  // mmap). The flushes requested by a burst of operations are batched.
   void FlushIndex();
 
   // Backend implementation.
@@ -269,6 +270,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   int OpenEntry(const std::string& key,
                 Entry** entry,
                 const CompletionCallback& callback) override;
+  int OpenEntryWithReadAhead(const std::string& key,
+                             Entry** entry,
+                             int read_ahead_size,
+                             const CompletionCallback& callback) override;
   int CreateEntry(const std::string& key,
                   Entry** entry,
                   const CompletionCallback& callback) override;
@@ -305,6 +310,9 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   bool InitStats();
   void StoreStats();
 
+  // Flushes the index to disk now, rather than when |flush_timer_| fires.
+  void FlushIndexNow();
+
   // Deletes the cache and starts again.
   void RestartCache(bool failure);
   void PrepareForRestart();
@@ -405,6 +413,7 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
 
   Stats stats_;  // Usage statistics.
   std::unique_ptr<base::RepeatingTimer> timer_;  // Usage timer.
+  std::unique_ptr<base::OneShotTimer> flush_timer_;  // Batches index flushes.
   base::WaitableEvent done_;  // Signals the end of background work.
   scoped_refptr<TraceObject> trace_object_;  // Initializes internal tracing.
   base::WeakPtrFactory<BackendImpl> ptr_factory_;
@@ -12,6 +12,7 @@
 #include "base/files/file.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/sequenced_task_runner.h"
 #include "net/base/net_export.h"
 
 namespace base {
@@ -56,7 +57,10 @@ class NET_EXPORT_PRIVATE File : public base::RefCounted<File> {
   bool Write(const void* buffer, size_t buffer_len, size_t offset);
 
   // Performs asynchronous IO. callback will be called when the IO completes,
-  // as an APC on the thread that queued the operation.
+  // as an APC on the thread that queued the operation. The operations on a
+  // file which is not in mixed mode (the file of a single entry stream) run in
+  // the order they are queued; the operations on block files, which are
+  // shared by many entries, may run in any order.
   bool Read(void* buffer, size_t buffer_len, size_t offset,
             FileIOCallback* callback, bool* completed);
   bool Write(const void* buffer, size_t buffer_len, size_t offset,
@@ -86,6 +90,7 @@ class NET_EXPORT_PRIVATE File : public base::RefCounted<File> {
                   FileIOCallback* callback, bool* completed);
 
   // Infrastructure for async IO.
+  base::TaskRunner* GetIOTaskRunner();
   int DoRead(void* buffer, size_t buffer_len, size_t offset);
   int DoWrite(const void* buffer, size_t buffer_len, size_t offset);
   void OnOperationComplete(FileIOCallback* callback, int result);
@@ -95,6 +100,10 @@ class NET_EXPORT_PRIVATE File : public base::RefCounted<File> {
   base::File base_file_;  // Regular, asynchronous IO handle.
   base::File sync_base_file_;  // Synchronous IO handle.
 
+  // Sequence of the asynchronous operations on this file, created when the
+  // first one is queued.
+  scoped_refptr<base::SequencedTaskRunner> io_task_runner_;
+
   DISALLOW_COPY_AND_ASSIGN(File);
 };
 
@@ -93,7 +93,7 @@ bool File::Read(void* buffer, size_t buffer_len, size_t offset,
   }
 
   base::PostTaskAndReplyWithResult(
-      s_worker_pool.Pointer(), FROM_HERE,
+      GetIOTaskRunner(), FROM_HERE,
       base::Bind(&File::DoRead, this, buffer, buffer_len, offset),
       base::Bind(&File::OnOperationComplete, this, callback));
 
@@ -116,7 +116,7 @@ bool File::Write(const void* buffer, size_t buffer_len, size_t offset,
   }
 
   base::PostTaskAndReplyWithResult(
-      s_worker_pool.Pointer(), FROM_HERE,
+      GetIOTaskRunner(), FROM_HERE,
       base::Bind(&File::DoWrite, this, buffer, buffer_len, offset),
       base::Bind(&File::OnOperationComplete, this, callback));
 
@@ -163,6 +163,21 @@ base::PlatformFile File::platform_file() const {
   return base_file_.GetPlatformFile();
 }
 
+// A file in mixed mode is a block file, whose blocks belong to different
+// entries, so its operations are spread over the pool. Any other file holds the
+// data of one entry stream, and its operations run in order so that a read
+// never overtakes a write queued before it; the streams of different entries
+// still run in parallel.
+base::TaskRunner* File::GetIOTaskRunner() {
+  if (mixed_)
+    return s_worker_pool.Pointer();
+  if (!io_task_runner_) {
+    io_task_runner_ = s_worker_pool.Get().GetSequencedTaskRunner(
+        base::SequencedWorkerPool::GetSequenceToken());
+  }
+  return io_task_runner_.get();
+}
+
 // Runs on a worker thread.
 int File::DoRead(void* buffer, size_t buffer_len, size_t offset) {
   if (Read(const_cast<void*>(buffer), buffer_len, offset))
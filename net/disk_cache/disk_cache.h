@@ -110,6 +110,15 @@ class NET_EXPORT Backend {
   virtual int OpenEntry(const std::string& key, Entry** entry,
                         const CompletionCallback& callback) = 0;
 
+  // Like OpenEntry(), for callers which are about to read the entry from the
+  // beginning. Backends which can do so read up to |read_ahead_size| bytes of
+  // stream 1 together with the entry, so that reads of that range complete
+  // without more IO; others just open the entry.
+  virtual int OpenEntryWithReadAhead(const std::string& key,
+                                     Entry** entry,
+                                     int read_ahead_size,
+                                     const CompletionCallback& callback) = 0;
+
   // Creates a new entry. Upon success, the out param holds a pointer to an
   // Entry object representing the newly created disk cache entry. When the
   // entry pointer is no longer needed, its Close method should be called. The
@@ -2,20 +2,31 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <limits>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/hash.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
 #include "base/process/process_metrics.h"
+#include "base/rand_util.h"
 #include "base/run_loop.h"
 #include "base/strings/string_util.h"
 #include "base/test/perf_time_logger.h"
 #include "base/test/test_file_util.h"
 #include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
 #include "net/base/cache_type.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
@@ -26,7 +37,9 @@
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
 #include "net/disk_cache/simple/simple_backend_impl.h"
+#include "net/disk_cache/simple/simple_index.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
 #include "testing/platform_test.h"
 
 using base::Time;
@@ -52,6 +65,196 @@ struct TestEntry {
   int data_len;
 };
 
+// The latencies of each kind of operation, by name.
+typedef std::map<std::string, std::vector<base::TimeDelta>> LatencyMap;
+
+// One cycle of operations of a LatencyClient in |kCreateInterval| creates an
+// entry rather than opening one.
+const int kCreateInterval = 10;
+
+// The size of the headers of the entries, and the maximum size of their body
+// read or written by a LatencyClient.
+const int kClientHeadersSize = 800;
+const int kClientBodySize = 64 * 1024;
+
+// A client of the cache, like a request of a busy proxy: it opens a random
+// entry and reads its headers and body, or one time in |kCreateInterval|
+// creates and writes a new entry, and records the latency of each operation.
+// Many clients share the cache at the same time.
+class LatencyClient {
+ public:
+  LatencyClient(disk_cache::Backend* cache,
+                const std::vector<TestEntry>* entries,
+                int num_cycles,
+                LatencyMap* latencies,
+                const base::Closure& done_callback)
+      : cache_(cache),
+        entries_(entries),
+        cycles_left_(num_cycles),
+        latencies_(latencies),
+        done_callback_(done_callback),
+        entry_(nullptr),
+        data_len_(0),
+        buffer_(new net::IOBuffer(kClientBodySize)),
+        operation_(nullptr) {
+    CacheTestFillBuffer(buffer_->data(), kClientBodySize, false);
+  }
+
+  ~LatencyClient() { DCHECK(!entry_); }
+
+  // Runs the next cycle of operations, or notifies |done_callback_| when there
+  // are none left.
+  void StartCycle();
+
+ private:
+  // Starts timing operation |name|.
+  void StartOperation(const char* name);
+
+  // Records the latency of the operation in progress. Returns false if
+  // |result| is not |expected|.
+  bool OperationDone(int result, int expected);
+
+  void OnOpenDone(int result);
+  void OnReadHeadersDone(int result);
+  void OnReadBodyDone(int result);
+  void OnCreateDone(int result);
+  void OnWriteHeadersDone(int result);
+  void OnWriteBodyDone(int result);
+  void EndCycle();
+
+  disk_cache::Backend* const cache_;
+  const std::vector<TestEntry>* const entries_;
+  int cycles_left_;
+  LatencyMap* const latencies_;
+  const base::Closure done_callback_;
+
+  disk_cache::Entry* entry_;
+  int data_len_;
+  scoped_refptr<net::IOBuffer> buffer_;
+  const char* operation_;
+  std::unique_ptr<base::ElapsedTimer> operation_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyClient);
+};
+
+void LatencyClient::StartCycle() {
+  if (!cycles_left_--) {
+    done_callback_.Run();
+    return;
+  }
+
+  if (base::RandGenerator(kCreateInterval)) {
+    const TestEntry& test_entry =
+        (*entries_)[base::RandGenerator(entries_->size())];
+    data_len_ = std::min(test_entry.data_len, kClientBodySize);
+    StartOperation("open");
+    int rv = cache_->OpenEntry(
+        test_entry.key, &entry_,
+        base::Bind(&LatencyClient::OnOpenDone, base::Unretained(this)));
+    if (rv != net::ERR_IO_PENDING)
+      OnOpenDone(rv);
+    return;
+  }
+
+  data_len_ = base::RandInt(1, kClientBodySize);
+  StartOperation("create");
+  int rv = cache_->CreateEntry(
+      GenerateKey(true), &entry_,
+      base::Bind(&LatencyClient::OnCreateDone, base::Unretained(this)));
+  if (rv != net::ERR_IO_PENDING)
+    OnCreateDone(rv);
+}
+
+void LatencyClient::StartOperation(const char* name) {
+  operation_ = name;
+  operation_timer_.reset(new base::ElapsedTimer);
+}
+
+bool LatencyClient::OperationDone(int result, int expected) {
+  (*latencies_)[operation_].push_back(operation_timer_->Elapsed());
+  EXPECT_EQ(expected, result) << operation_;
+  return result == expected;
+}
+
+void LatencyClient::OnOpenDone(int result) {
+  if (!OperationDone(result, net::OK))
+    return EndCycle();
+
+  StartOperation("read_headers");
+  int rv = entry_->ReadData(
+      0, 0, buffer_.get(), kClientHeadersSize,
+      base::Bind(&LatencyClient::OnReadHeadersDone, base::Unretained(this)));
+  if (rv != net::ERR_IO_PENDING)
+    OnReadHeadersDone(rv);
+}
+
+void LatencyClient::OnReadHeadersDone(int result) {
+  if (!OperationDone(result, kClientHeadersSize))
+    return EndCycle();
+
+  StartOperation("read_body");
+  int rv = entry_->ReadData(
+      1, 0, buffer_.get(), data_len_,
+      base::Bind(&LatencyClient::OnReadBodyDone, base::Unretained(this)));
+  if (rv != net::ERR_IO_PENDING)
+    OnReadBodyDone(rv);
+}
+
+void LatencyClient::OnReadBodyDone(int result) {
+  OperationDone(result, data_len_);
+  EndCycle();
+}
+
+void LatencyClient::OnCreateDone(int result) {
+  if (!OperationDone(result, net::OK))
+    return EndCycle();
+
+  StartOperation("write_headers");
+  int rv = entry_->WriteData(
+      0, 0, buffer_.get(), kClientHeadersSize,
+      base::Bind(&LatencyClient::OnWriteHeadersDone, base::Unretained(this)),
+      false);
+  if (rv != net::ERR_IO_PENDING)
+    OnWriteHeadersDone(rv);
+}
+
+void LatencyClient::OnWriteHeadersDone(int result) {
+  if (!OperationDone(result, kClientHeadersSize))
+    return EndCycle();
+
+  StartOperation("write_body");
+  int rv = entry_->WriteData(
+      1, 0, buffer_.get(), data_len_,
+      base::Bind(&LatencyClient::OnWriteBodyDone, base::Unretained(this)),
+      false);
+  if (rv != net::ERR_IO_PENDING)
+    OnWriteBodyDone(rv);
+}
+
+void LatencyClient::OnWriteBodyDone(int result) {
+  OperationDone(result, data_len_);
+  EndCycle();
+}
+
+void LatencyClient::EndCycle() {
+  if (entry_) {
+    entry_->Close();
+    entry_ = nullptr;
+  }
+  // Start the next cycle from a fresh task, so that operations which complete
+  // synchronously do not recurse.
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE,
+      base::Bind(&LatencyClient::StartCycle, base::Unretained(this)));
+}
+
+// Runs |quit_closure| when the last of the clients counted by |clients_left|
+// is done.
+void OnClientDone(int* clients_left, const base::Closure& quit_closure) {
+  if (!--*clients_left)
+    quit_closure.Run();
+}
+
 class DiskCachePerfTest : public DiskCacheTestWithCache {
  public:
   DiskCachePerfTest() : saved_fd_limit_(MaybeGetMaxFds()) {
@@ -75,8 +278,13 @@ class DiskCachePerfTest : public DiskCacheTestWithCache {
   bool TimeRead(WhatToRead what_to_read, const char* timer_message);
   void ResetAndEvictSystemDiskCache();
 
+  // Runs |kNumClients| clients on the cache at the same time, and reports the
+  // median and 99th percentile latency of their operations.
+  void TimeConcurrentClients(const std::string& trace);
+
   // Complete perf tests.
   void CacheBackendPerformance();
+  void CacheBackendLatency(const std::string& trace);
 
   const size_t kFdLimitForCacheTests = 8192;
 
@@ -84,6 +292,9 @@ class DiskCachePerfTest : public DiskCacheTestWithCache {
   const int kHeadersSize = 800;
   const int kBodySize = 256 * 1024 - 1;
 
+  const int kNumClients = 32;
+  const int kCyclesPerClient = 200;
+
   std::vector<TestEntry> entries_;
 
  private:
@@ -259,6 +470,54 @@ void DiskCachePerfTest::CacheBackendPerformance() {
   base::RunLoop().RunUntilIdle();
 }
 
+void DiskCachePerfTest::TimeConcurrentClients(const std::string& trace) {
+  LatencyMap latencies;
+  base::RunLoop run_loop;
+  int clients_left = kNumClients;
+  const base::Closure done_callback =
+      base::Bind(&OnClientDone, &clients_left, run_loop.QuitClosure());
+
+  std::vector<std::unique_ptr<LatencyClient>> clients;
+  for (int i = 0; i < kNumClients; i++) {
+    clients.push_back(base::MakeUnique<LatencyClient>(
+        cache_.get(), &entries_, kCyclesPerClient, &latencies, done_callback));
+  }
+  base::ElapsedTimer timer;
+  for (const auto& client : clients)
+    client->StartCycle();
+  run_loop.Run();
+  const base::TimeDelta elapsed = timer.Elapsed();
+
+  int num_operations = 0;
+  for (auto& latency : latencies) {
+    std::vector<base::TimeDelta>& samples = latency.second;
+    std::sort(samples.begin(), samples.end());
+    num_operations += samples.size();
+    perf_test::PrintResult(
+        "cache_latency_p50", latency.first, trace,
+        samples[samples.size() / 2].InMillisecondsF(), "ms", true);
+    perf_test::PrintResult(
+        "cache_latency_p99", latency.first, trace,
+        samples[samples.size() * 99 / 100].InMillisecondsF(), "ms", true);
+  }
+  perf_test::PrintResult("cache_throughput", "", trace,
+                         num_operations / elapsed.InSecondsF(), "ops/s",
+                         false);
+}
+
+void DiskCachePerfTest::CacheBackendLatency(const std::string& trace) {
+  InitCache();
+  EXPECT_TRUE(TimeWrite());
+
+  disk_cache::SimpleBackendImpl::FlushWorkerPoolForTesting();
+  base::RunLoop().RunUntilIdle();
+
+  TimeConcurrentClients(trace);
+
+  disk_cache::SimpleBackendImpl::FlushWorkerPoolForTesting();
+  base::RunLoop().RunUntilIdle();
+}
+
 TEST_F(DiskCachePerfTest, CacheBackendPerformance) {
   CacheBackendPerformance();
 }
@@ -268,6 +527,17 @@ TEST_F(DiskCachePerfTest, SimpleCacheBackendPerformance) {
   CacheBackendPerformance();
 }
 
+// Measures the latency of the operations of many clients sharing the cache,
+// which depends on how much the backend serializes their I/O.
+TEST_F(DiskCachePerfTest, CacheBackendLatency) {
+  CacheBackendLatency("blockfile");
+}
+
+TEST_F(DiskCachePerfTest, SimpleCacheBackendLatency) {
+  SetSimpleCacheMode();
+  CacheBackendLatency("simple");
+}
+
 int BlockSize() {
   // We can use form 1 to 4 blocks.
   return (rand() & 0x3) + 1;
@@ -315,4 +585,45 @@ TEST_F(DiskCachePerfTest, BlockFilesPerformance) {
   base::RunLoop().RunUntilIdle();
 }
 
+// Measures the memory used by the simple cache index for a large number of
+// entries and the time it takes to rebuild it when the index file is loaded,
+// which inserts every entry into a table reserved for the entry count stored
+// in the index header.
+TEST_F(DiskCachePerfTest, SimpleIndexEntrySet) {
+  const size_t kNumIndexEntries = 1000000;
+  std::vector<uint64_t> hashes(kNumIndexEntries);
+  for (uint64_t& hash : hashes)
+    hash = base::RandUint64();
+  const disk_cache::EntryMetadata metadata(Time::Now(), 4096);
+
+  disk_cache::SimpleIndex::EntrySet entries;
+  base::PerfTimeLogger restore_timer("Restore simple cache index entries");
+  entries.reserve(kNumIndexEntries);
+  for (uint64_t hash : hashes)
+    disk_cache::SimpleIndex::InsertInEntrySet(hash, metadata, &entries);
+  restore_timer.Done();
+
+  const size_t table_bytes =
+      entries.bucket_count() *
+      sizeof(disk_cache::SimpleIndex::EntrySet::value_type);
+  perf_test::PrintResult("simple_index_memory", "", "bytes_per_entry",
+                         static_cast<double>(table_bytes) / entries.size(),
+                         "bytes", true);
+
+  base::PerfTimeLogger lookup_timer("Look up simple cache index entries");
+  size_t found = 0;
+  for (uint64_t hash : hashes)
+    found += entries.count(hash);
+  for (uint64_t hash : hashes)
+    found += entries.count(hash + 1);
+  lookup_timer.Done();
+  EXPECT_LE(kNumIndexEntries, found);
+
+  base::PerfTimeLogger remove_timer("Remove simple cache index entries");
+  for (uint64_t hash : hashes)
+    entries.erase(hash);
+  remove_timer.Done();
+  EXPECT_TRUE(entries.empty());
+}
+
 }  // namespace
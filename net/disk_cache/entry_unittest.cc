@@ -2675,6 +2675,99 @@ TEST_F(DiskCacheEntryTest, SimpleCacheBadChecksum) {
             ReadData(entry, 1, 0, read_buffer.get(), kReadBufferSize));
 }
 
+// Tests that the beginning of stream 1 read ahead when opening an entry is
+// read without IO, and that the rest of the stream is read from the disk.
+TEST_F(DiskCacheEntryTest, SimpleCacheOpenWithReadAhead) {
+  SetSimpleCacheMode();
+  InitCache();
+
+  const char key[] = "the first key";
+  const int kHeadersSize = 100;
+  const int kBodySize = 10000;
+  const int kReadAheadSize = 4096;
+  scoped_refptr<net::IOBuffer> headers(new net::IOBuffer(kHeadersSize));
+  scoped_refptr<net::IOBuffer> body(new net::IOBuffer(kBodySize));
+  CacheTestFillBuffer(headers->data(), kHeadersSize, false);
+  CacheTestFillBuffer(body->data(), kBodySize, false);
+  disk_cache::Entry* entry = NULL;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+  EXPECT_EQ(kHeadersSize,
+            WriteData(entry, 0, 0, headers.get(), kHeadersSize, false));
+  EXPECT_EQ(kBodySize, WriteData(entry, 1, 0, body.get(), kBodySize, false));
+  entry->Close();
+
+  net::TestCompletionCallback cb;
+  ASSERT_EQ(net::OK, cb.GetResult(cache_->OpenEntryWithReadAhead(
+                         key, &entry, kReadAheadSize, cb.callback())));
+  ScopedEntryPtr entry_closer(entry);
+  EXPECT_EQ(kBodySize, entry->GetDataSize(1));
+
+  // A read of the data read ahead completes at once, and stops at its end.
+  scoped_refptr<net::IOBuffer> read_buffer(new net::IOBuffer(kBodySize));
+  EXPECT_EQ(kReadAheadSize, entry->ReadData(1, 0, read_buffer.get(), kBodySize,
+                                            net::CompletionCallback()));
+  EXPECT_EQ(10, entry->ReadData(1, kReadAheadSize - 10, read_buffer.get(), 100,
+                                net::CompletionCallback()));
+  EXPECT_EQ(0, memcmp(read_buffer->data(),
+                      body->data() + kReadAheadSize - 10, 10));
+
+  EXPECT_EQ(kReadAheadSize,
+            ReadData(entry, 1, 0, read_buffer.get(), kBodySize));
+  EXPECT_EQ(kBodySize - kReadAheadSize,
+            ReadData(entry, 1, kReadAheadSize,
+                     read_buffer.get(), kBodySize));
+  EXPECT_EQ(0, memcmp(read_buffer->data(), body->data() + kReadAheadSize,
+                      kBodySize - kReadAheadSize));
+}
+
+// Tests that a stream 1 read ahead whole is replaced by writes to it.
+TEST_F(DiskCacheEntryTest, SimpleCacheOpenWithReadAheadThenWrite) {
+  SetSimpleCacheMode();
+  InitCache();
+
+  const char key[] = "the first key";
+  const int kBodySize = 1000;
+  scoped_refptr<net::IOBuffer> body(new net::IOBuffer(kBodySize));
+  CacheTestFillBuffer(body->data(), kBodySize, false);
+  disk_cache::Entry* entry = NULL;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+  EXPECT_EQ(kBodySize, WriteData(entry, 1, 0, body.get(), kBodySize, false));
+  entry->Close();
+
+  net::TestCompletionCallback cb;
+  ASSERT_EQ(net::OK, cb.GetResult(cache_->OpenEntryWithReadAhead(
+                         key, &entry, 32 * 1024, cb.callback())));
+  ScopedEntryPtr entry_closer(entry);
+  scoped_refptr<net::IOBuffer> read_buffer(new net::IOBuffer(kBodySize));
+  EXPECT_EQ(kBodySize, entry->ReadData(1, 0, read_buffer.get(), kBodySize,
+                                       net::CompletionCallback()));
+  EXPECT_EQ(0, memcmp(read_buffer->data(), body->data(), kBodySize));
+
+  CacheTestFillBuffer(body->data(), kBodySize, false);
+  EXPECT_EQ(kBodySize / 2,
+            WriteData(entry, 1, 0, body.get(), kBodySize / 2, true));
+  EXPECT_EQ(kBodySize / 2,
+            ReadData(entry, 1, 0, read_buffer.get(), kBodySize));
+  EXPECT_EQ(0, memcmp(read_buffer->data(), body->data(), kBodySize / 2));
+}
+
+// Tests that an entry whose stream 1 is read ahead whole is checked when it
+// is opened.
+TEST_F(DiskCacheEntryTest, SimpleCacheOpenWithReadAheadBadChecksum) {
+  SetSimpleCacheMode();
+  InitCache();
+
+  const char key[] = "the first key";
+  int size_unused;
+  ASSERT_TRUE(SimpleCacheMakeBadChecksumEntry(key, &size_unused));
+
+  disk_cache::Entry* entry = NULL;
+  net::TestCompletionCallback cb;
+  EXPECT_EQ(net::ERR_FAILED, cb.GetResult(cache_->OpenEntryWithReadAhead(
+                                 key, &entry, 200, cb.callback())));
+  EXPECT_NE(net::OK, OpenEntry(key, &entry));
+}
+
 // Tests that an entry that has had an IO error occur can still be Doomed().
 TEST_F(DiskCacheEntryTest, SimpleCacheErrorThenDoom) {
   SetSimpleCacheMode();
@@ -146,6 +146,14 @@ int MemBackendImpl::OpenEntry(const std::string& key,
   return net::OK;
 }
 
+int MemBackendImpl::OpenEntryWithReadAhead(
+    const std::string& key,
+    Entry** entry,
+    int read_ahead_size,
+    const CompletionCallback& callback) {
+  return OpenEntry(key, entry, callback);
+}
+
 int MemBackendImpl::CreateEntry(const std::string& key,
                                 Entry** entry,
                                 const CompletionCallback& callback) {
@@ -78,6 +78,10 @@ class NET_EXPORT_PRIVATE MemBackendImpl final : public Backend {
   int OpenEntry(const std::string& key,
                 Entry** entry,
                 const CompletionCallback& callback) override;
+  int OpenEntryWithReadAhead(const std::string& key,
+                             Entry** entry,
+                             int read_ahead_size,
+                             const CompletionCallback& callback) override;
   int CreateEntry(const std::string& key,
                   Entry** entry,
                   const CompletionCallback& callback) override;
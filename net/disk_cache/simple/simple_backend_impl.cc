@@ -374,6 +374,14 @@ int32_t SimpleBackendImpl::GetEntryCount() const {
 int SimpleBackendImpl::OpenEntry(const std::string& key,
                                  Entry** entry,
                                  const CompletionCallback& callback) {
+  return OpenEntryWithReadAhead(key, entry, 0, callback);
+}
+
+int SimpleBackendImpl::OpenEntryWithReadAhead(
+    const std::string& key,
+    Entry** entry,
+    int read_ahead_size,
+    const CompletionCallback& callback) {
   const uint64_t entry_hash = simple_util::GetEntryHashKey(key);
 
   // TODO(gavinp): Factor out this (not quite completely) repetitive code
@@ -382,15 +390,15 @@ int SimpleBackendImpl::OpenEntry(const std::string& key,
       entries_pending_doom_.find(entry_hash);
   if (it != entries_pending_doom_.end()) {
     Callback<int(const net::CompletionCallback&)> operation =
-        base::Bind(&SimpleBackendImpl::OpenEntry,
-                   base::Unretained(this), key, entry);
+        base::Bind(&SimpleBackendImpl::OpenEntryWithReadAhead,
+                   base::Unretained(this), key, entry, read_ahead_size);
     it->second.push_back(base::Bind(&RunOperationAndCallback,
                                     operation, callback));
     return net::ERR_IO_PENDING;
   }
   scoped_refptr<SimpleEntryImpl> simple_entry =
       CreateOrFindActiveEntry(entry_hash, key);
-  return simple_entry->OpenEntry(entry, callback);
+  return simple_entry->OpenEntry(entry, read_ahead_size, callback);
 }
 
 int SimpleBackendImpl::CreateEntry(const std::string& key,
@@ -645,7 +653,7 @@ int SimpleBackendImpl::OpenEntryFromHash(uint64_t entry_hash,
   CompletionCallback backend_callback =
       base::Bind(&SimpleBackendImpl::OnEntryOpenedFromHash,
                  AsWeakPtr(), entry_hash, entry, simple_entry, callback);
-  return simple_entry->OpenEntry(entry, backend_callback);
+  return simple_entry->OpenEntry(entry, 0, backend_callback);
 }
 
 int SimpleBackendImpl::DoomEntryFromHash(uint64_t entry_hash,
@@ -702,7 +710,7 @@ void SimpleBackendImpl::OnEntryOpenedFromHash(
     // finish. The entry created from hash needs to be closed, and the one
     // in |active_entries_| can be returned to the caller.
     simple_entry->Close();
-    it->second->OpenEntry(entry, callback);
+    it->second->OpenEntry(entry, 0, callback);
   }
 }
 
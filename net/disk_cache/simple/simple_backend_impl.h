@@ -96,6 +96,10 @@ class NET_EXPORT_PRIVATE SimpleBackendImpl : public Backend,
   int OpenEntry(const std::string& key,
                 Entry** entry,
                 const CompletionCallback& callback) override;
+  int OpenEntryWithReadAhead(const std::string& key,
+                             Entry** entry,
+                             int read_ahead_size,
+                             const CompletionCallback& callback) override;
   int CreateEntry(const std::string& key,
                   Entry** entry,
                   const CompletionCallback& callback) override;
@@ -206,6 +206,7 @@ void SimpleEntryImpl::SetActiveEntryProxy(
 }
 
 int SimpleEntryImpl::OpenEntry(Entry** out_entry,
+                               int read_ahead_size,
                                const CompletionCallback& callback) {
   DCHECK(backend_.get());
 
@@ -239,7 +240,7 @@ int SimpleEntryImpl::OpenEntry(Entry** out_entry,
   }
 
   pending_operations_.push(SimpleEntryOperation::OpenOperation(
-      this, have_index, callback, out_entry));
+      this, have_index, read_ahead_size, callback, out_entry));
   RunNextOperationIfNeeded();
   return net::ERR_IO_PENDING;
 }
@@ -375,6 +376,16 @@ int SimpleEntryImpl::ReadData(int stream_index,
     return 0;
   }
 
+  if (pending_operations_.empty() && state_ == STATE_READY &&
+      CanReadStream1Data(stream_index, offset)) {
+    int ret_value = ReadStream1Data(buf, offset, buf_len);
+    if (net_log_.IsCapturing()) {
+      net_log_.AddEvent(net::NetLog::TYPE_SIMPLE_CACHE_ENTRY_READ_END,
+          CreateNetLogReadWriteCompleteCallback(ret_value));
+    }
+    return ret_value;
+  }
+
   // TODO(clamy): return immediatly when reading from stream 0.
 
   // TODO(felipeg): Optimization: Add support for truly parallel read
@@ -568,6 +579,7 @@ void SimpleEntryImpl::MakeUninitialized() {
   for (size_t i = 0; i < arraysize(crc_check_state_); ++i) {
     crc_check_state_[i] = CRC_CHECK_NEVER_READ_AT_ALL;
   }
+  stream_1_data_ = NULL;
 }
 
 void SimpleEntryImpl::ReturnEntryToCaller(Entry** out_entry) {
@@ -606,6 +618,7 @@ void SimpleEntryImpl::RunNextOperationIfNeeded() {
     switch (operation->type()) {
       case SimpleEntryOperation::TYPE_OPEN:
         OpenEntryInternal(operation->have_index(),
+                          operation->length(),
                           operation->callback(),
                           operation->out_entry());
         break;
@@ -667,6 +680,7 @@ void SimpleEntryImpl::RunNextOperationIfNeeded() {
 }
 
 void SimpleEntryImpl::OpenEntryInternal(bool have_index,
+                                        int read_ahead_size,
                                         const CompletionCallback& callback,
                                         Entry** out_entry) {
   ScopedOperationRunner operation_runner(this);
@@ -698,7 +712,7 @@ void SimpleEntryImpl::OpenEntryInternal(bool have_index,
           last_used_, last_modified_, data_size_, sparse_data_size_)));
   Closure task =
       base::Bind(&SimpleSynchronousEntry::OpenEntry, cache_type_, path_, key_,
-                 entry_hash_, have_index, results.get());
+                 entry_hash_, have_index, read_ahead_size, results.get());
   Closure reply =
       base::Bind(&SimpleEntryImpl::CreationOperationComplete, this, callback,
                  start_time, base::Passed(&results), out_entry,
@@ -856,6 +870,16 @@ void SimpleEntryImpl::ReadDataInternal(int stream_index,
     return;
   }
 
+  // So is the beginning of stream 1 if it was read ahead.
+  if (CanReadStream1Data(stream_index, offset)) {
+    int ret_value = ReadStream1Data(buf, offset, buf_len);
+    if (!callback.is_null()) {
+      base::ThreadTaskRunnerHandle::Get()->PostTask(
+          FROM_HERE, base::Bind(callback, ret_value));
+    }
+    return;
+  }
+
   state_ = STATE_IO_PENDING;
   if (!doomed_ && backend_.get())
     backend_->index()->UseIfExists(entry_hash_);
@@ -938,6 +962,8 @@ void SimpleEntryImpl::WriteDataInternal(int stream_index,
   if (!doomed_ && backend_.get())
     backend_->index()->UseIfExists(entry_hash_);
 
+  if (stream_index == 1)
+    stream_1_data_ = NULL;
   AdvanceCrc(buf, offset, buf_len, stream_index);
 
   // |entry_stat| needs to be initialized before modifying |data_size_|.
@@ -1141,6 +1167,17 @@ void SimpleEntryImpl::CreationOperationComplete(
     crc32s_[0] = in_results->stream_0_crc32;
     crc32s_end_offset_[0] = in_results->entry_stat.data_size(0);
   }
+  if (in_results->stream_1_data.get()) {
+    stream_1_data_ = in_results->stream_1_data;
+    // The crc of what was read ahead was computed, and checked if that is
+    // the whole stream, in SimpleSynchronousEntry.
+    crc32s_[1] = in_results->stream_1_crc32;
+    crc32s_end_offset_[1] = stream_1_data_->size();
+    crc_check_state_[1] =
+        stream_1_data_->size() == in_results->entry_stat.data_size(1)
+            ? CRC_CHECK_DONE
+            : CRC_CHECK_NEVER_READ_TO_END;
+  }
   // If this entry was opened by hash, key_ could still be empty. If so, update
   // it with the key read from the synchronous entry.
   if (key_.empty()) {
@@ -1492,6 +1529,24 @@ int SimpleEntryImpl::ReadStream0Data(net::IOBuffer* buf,
   return buf_len;
 }
 
+bool SimpleEntryImpl::CanReadStream1Data(int stream_index, int offset) const {
+  return stream_index == 1 && stream_1_data_.get() && offset >= 0 &&
+         offset < stream_1_data_->size();
+}
+
+int SimpleEntryImpl::ReadStream1Data(net::IOBuffer* buf,
+                                     int offset,
+                                     int buf_len) {
+  DCHECK(CanReadStream1Data(1, offset));
+  buf_len = std::min(buf_len, stream_1_data_->size() - offset);
+  memcpy(buf->data(), stream_1_data_->data() + offset, buf_len);
+  UpdateDataFromEntryStat(
+      SimpleEntryStat(base::Time::Now(), last_modified_, data_size_,
+                      sparse_data_size_));
+  RecordReadResult(cache_type_, READ_RESULT_SUCCESS);
+  return buf_len;
+}
+
 int SimpleEntryImpl::SetStream0Data(net::IOBuffer* buf,
                                     int offset,
                                     int buf_len,
@@ -28,6 +28,7 @@ class TaskRunner;
 namespace net {
 class GrowableIOBuffer;
 class IOBuffer;
+class IOBufferWithSize;
 }
 
 namespace disk_cache {
@@ -68,8 +69,12 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
       std::unique_ptr<ActiveEntryProxy> active_entry_proxy);
 
   // Adds another reader/writer to this entry, if possible, returning |this| to
-  // |entry|.
-  int OpenEntry(Entry** entry, const CompletionCallback& callback);
+  // |entry|. If this opens the entry from disk, up to |read_ahead_size| bytes
+  // of stream 1 are read along with stream 0, and reads of them complete
+  // without going to the worker pool.
+  int OpenEntry(Entry** entry,
+                int read_ahead_size,
+                const CompletionCallback& callback);
 
   // Creates this entry, if possible. Returns |this| to |entry|.
   int CreateEntry(Entry** entry, const CompletionCallback& callback);
@@ -178,6 +183,7 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
   void RunNextOperationIfNeeded();
 
   void OpenEntryInternal(bool have_index,
+                         int read_ahead_size,
                          const CompletionCallback& callback,
                          Entry** out_entry);
 
@@ -294,6 +300,15 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
   // Reads from the stream 0 data kept in memory.
   int ReadStream0Data(net::IOBuffer* buf, int offset, int buf_len);
 
+  // Returns true if a read of stream |stream_index| at |offset| can be served
+  // from |stream_1_data_|.
+  bool CanReadStream1Data(int stream_index, int offset) const;
+
+  // Reads from the beginning of stream 1 read ahead when opening the entry.
+  // Returns the number of bytes read, which may be less than |buf_len| if the
+  // read goes past the data read ahead.
+  int ReadStream1Data(net::IOBuffer* buf, int offset, int buf_len);
+
   // Copies data from |buf| to the internal in-memory buffer for stream 0. If
   // |truncate| is set to true, the target buffer will be truncated at |offset|
   // + |buf_len| before being written.
@@ -382,6 +397,12 @@ class NET_EXPORT_PRIVATE SimpleEntryImpl : public Entry,
   // used to write HTTP headers, the memory consumption of keeping it in memory
   // is acceptable.
   scoped_refptr<net::GrowableIOBuffer> stream_0_data_;
+
+  // The beginning of stream 1, if it was read ahead when the entry was opened,
+  // so that small bodies can be read without a round trip to the worker pool.
+  // Its crc32 was computed when it was read. It is dropped on the first write
+  // to stream 1.
+  scoped_refptr<net::IOBufferWithSize> stream_1_data_;
 };
 
 }  // namespace disk_cache
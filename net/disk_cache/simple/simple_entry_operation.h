@@ -44,6 +44,7 @@ class SimpleEntryOperation {
 
   static SimpleEntryOperation OpenOperation(SimpleEntryImpl* entry,
                                             bool have_index,
+                                            int read_ahead_size,
                                             const CompletionCallback& callback,
                                             Entry** out_entry);
   static SimpleEntryOperation CreateOperation(
@@ -135,7 +136,8 @@ class SimpleEntryOperation {
   // Used in open and create operations.
   Entry** out_entry_;
 
-  // Used in write and read operations.
+  // Used in write and read operations. |length_| is also the read-ahead size
+  // of open operations.
   const int offset_;
   const int64_t sparse_offset_;
   const int length_;
@@ -49,6 +49,16 @@ const uint32_t kEvictionMarginDivisor = 20;
 
 const uint32_t kBytesInKb = 1024;
 
+// Smallest number of slots allocated by SimpleIndexEntrySet. Must be a power of
+// two.
+const size_t kMinEntrySetSlots = 16;
+
+// Returns whether a SimpleIndexEntrySet with |num_slots| slots can hold
+// |num_entries| entries without exceeding its maximum load factor of 3/4.
+bool EntrySetCanHold(size_t num_slots, size_t num_entries) {
+  return num_entries * 4 <= num_slots * 3;
+}
+
 // Utility class used for timestamp comparisons in entry metadata while sorting.
 class CompareHashesForTimestamp {
   typedef disk_cache::SimpleIndex SimpleIndex;
@@ -140,6 +150,156 @@ bool EntryMetadata::Deserialize(base::PickleIterator* it) {
   return true;
 }
 
+SimpleIndexEntrySet::SimpleIndexEntrySet() {}
+
+SimpleIndexEntrySet::SimpleIndexEntrySet(const SimpleIndexEntrySet& other) =
+    default;
+
+SimpleIndexEntrySet::~SimpleIndexEntrySet() {}
+
+SimpleIndexEntrySet& SimpleIndexEntrySet::operator=(
+    const SimpleIndexEntrySet& other) = default;
+
+std::pair<SimpleIndexEntrySet::iterator, bool> SimpleIndexEntrySet::insert(
+    const value_type& value) {
+  const uint64_t entry_hash = value.first;
+  if (entry_hash == 0) {
+    const bool inserted = !has_zero_key_;
+    if (inserted) {
+      zero_key_slot_ = value;
+      has_zero_key_ = true;
+      ++size_;
+    }
+    return std::make_pair(iterator(this, slots_.size()), inserted);
+  }
+
+  const size_t num_table_entries = size_ - (has_zero_key_ ? 1 : 0);
+  if (!EntrySetCanHold(slots_.size(), num_table_entries + 1))
+    Rehash(std::max(kMinEntrySetSlots, slots_.size() * 2));
+
+  const size_t mask = slots_.size() - 1;
+  size_t index = IdealIndex(entry_hash);
+  while (slots_[index].first != 0) {
+    if (slots_[index].first == entry_hash)
+      return std::make_pair(iterator(this, index), false);
+    index = (index + 1) & mask;
+  }
+  slots_[index] = value;
+  ++size_;
+  return std::make_pair(iterator(this, index), true);
+}
+
+void SimpleIndexEntrySet::erase(iterator it) {
+  DCHECK_EQ(this, it.set_);
+  DCHECK(it != end());
+  --size_;
+  size_t hole = it.index_;
+  if (hole == slots_.size()) {
+    DCHECK(has_zero_key_);
+    has_zero_key_ = false;
+    zero_key_slot_ = value_type();
+    return;
+  }
+
+  // Shift back the entries following |hole| in its cluster so that no probe
+  // sequence goes through an empty slot, which avoids tombstones.
+  const size_t mask = slots_.size() - 1;
+  size_t index = hole;
+  while (true) {
+    index = (index + 1) & mask;
+    if (slots_[index].first == 0)
+      break;
+    // The entry at |index| can fill |hole| unless its ideal slot lies
+    // cyclically in (|hole|, |index|].
+    const size_t ideal = IdealIndex(slots_[index].first);
+    if (((index - ideal) & mask) >= ((index - hole) & mask)) {
+      slots_[hole] = slots_[index];
+      hole = index;
+    }
+  }
+  slots_[hole] = value_type();
+}
+
+size_t SimpleIndexEntrySet::erase(uint64_t entry_hash) {
+  iterator it = find(entry_hash);
+  if (it == end())
+    return 0;
+  erase(it);
+  return 1;
+}
+
+void SimpleIndexEntrySet::clear() {
+  std::vector<value_type>().swap(slots_);
+  zero_key_slot_ = value_type();
+  has_zero_key_ = false;
+  size_ = 0;
+}
+
+void SimpleIndexEntrySet::swap(SimpleIndexEntrySet& other) {
+  slots_.swap(other.slots_);
+  std::swap(zero_key_slot_, other.zero_key_slot_);
+  std::swap(has_zero_key_, other.has_zero_key_);
+  std::swap(size_, other.size_);
+}
+
+void SimpleIndexEntrySet::reserve(size_t size) {
+  size_t num_slots = std::max(kMinEntrySetSlots, slots_.size());
+  while (!EntrySetCanHold(num_slots, size))
+    num_slots *= 2;
+  if (num_slots != slots_.size())
+    Rehash(num_slots);
+}
+
+size_t SimpleIndexEntrySet::NextOccupiedIndex(size_t index) const {
+  for (; index < slots_.size(); ++index) {
+    if (slots_[index].first != 0)
+      return index;
+  }
+  if (index == slots_.size() && has_zero_key_)
+    return index;
+  return EndIndex();
+}
+
+size_t SimpleIndexEntrySet::FindIndex(uint64_t entry_hash) const {
+  if (entry_hash == 0)
+    return has_zero_key_ ? slots_.size() : EndIndex();
+  if (slots_.empty())
+    return EndIndex();
+
+  const size_t mask = slots_.size() - 1;
+  for (size_t index = IdealIndex(entry_hash); slots_[index].first != 0;
+       index = (index + 1) & mask) {
+    if (slots_[index].first == entry_hash)
+      return index;
+  }
+  return EndIndex();
+}
+
+size_t SimpleIndexEntrySet::IdealIndex(uint64_t entry_hash) const {
+  // Entry hashes come from SHA-1 and are well distributed, but tests and
+  // corrupted indexes may use sequential values. Fibonacci hashing spreads
+  // those over the table.
+  const uint64_t kGoldenRatio = UINT64_C(0x9E3779B97F4A7C15);
+  return static_cast<size_t>((entry_hash * kGoldenRatio) >> 32) &
+         (slots_.size() - 1);
+}
+
+void SimpleIndexEntrySet::Rehash(size_t num_slots) {
+  DCHECK_EQ(0U, num_slots & (num_slots - 1));
+  std::vector<value_type> old_slots(num_slots);
+  old_slots.swap(slots_);
+
+  const size_t mask = num_slots - 1;
+  for (const value_type& slot : old_slots) {
+    if (slot.first == 0)
+      continue;
+    size_t index = IdealIndex(slot.first);
+    while (slots_[index].first != 0)
+      index = (index + 1) & mask;
+    slots_[index] = slot;
+  }
+}
+
 SimpleIndex::SimpleIndex(
     const scoped_refptr<base::SingleThreadTaskRunner>& io_thread,
     SimpleIndexDelegate* delegate,
@@ -7,10 +7,12 @@
 
 #include <stdint.h>
 
+#include <stddef.h>
+
 #include <list>
 #include <memory>
-#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base/callback.h"
@@ -75,6 +77,136 @@ class NET_EXPORT_PRIVATE EntryMetadata {
 };
 static_assert(sizeof(EntryMetadata) == 8, "incorrect metadata size");
 
+// A hash table from entry hashes to EntryMetadata. It uses open addressing
+// with linear probing, and stores the (hash, metadata) pairs inline in a single
+// array, so there is no allocation per entry and a lookup touches one or two
+// adjacent cache lines. It mirrors the subset of the std::unordered_map
+// interface used by the simple cache. Any insertion or erasure invalidates all
+// iterators. The key of an element must not be modified through an iterator.
+class NET_EXPORT_PRIVATE SimpleIndexEntrySet {
+ public:
+  using key_type = uint64_t;
+  using mapped_type = EntryMetadata;
+  using value_type = std::pair<uint64_t, EntryMetadata>;
+
+  template <typename SetType, typename ValueType>
+  class IteratorImpl {
+   public:
+    IteratorImpl(SetType* set, size_t index) : set_(set), index_(index) {}
+
+    // Allows conversion from iterator to const_iterator.
+    template <typename OtherSetType, typename OtherValueType>
+    IteratorImpl(const IteratorImpl<OtherSetType, OtherValueType>& other)
+        : set_(other.set_), index_(other.index_) {}
+
+    ValueType& operator*() const { return set_->SlotAt(index_); }
+    ValueType* operator->() const { return &set_->SlotAt(index_); }
+
+    IteratorImpl& operator++() {
+      index_ = set_->NextOccupiedIndex(index_ + 1);
+      return *this;
+    }
+
+    bool operator==(const IteratorImpl& other) const {
+      return set_ == other.set_ && index_ == other.index_;
+    }
+    bool operator!=(const IteratorImpl& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class SimpleIndexEntrySet;
+    template <typename OtherSetType, typename OtherValueType>
+    friend class IteratorImpl;
+
+    SetType* set_;
+    size_t index_;
+  };
+
+  using iterator = IteratorImpl<SimpleIndexEntrySet, value_type>;
+  using const_iterator =
+      IteratorImpl<const SimpleIndexEntrySet, const value_type>;
+
+  SimpleIndexEntrySet();
+  SimpleIndexEntrySet(const SimpleIndexEntrySet& other);
+  ~SimpleIndexEntrySet();
+
+  SimpleIndexEntrySet& operator=(const SimpleIndexEntrySet& other);
+
+  iterator begin() { return iterator(this, NextOccupiedIndex(0)); }
+  iterator end() { return iterator(this, EndIndex()); }
+  const_iterator begin() const {
+    return const_iterator(this, NextOccupiedIndex(0));
+  }
+  const_iterator end() const { return const_iterator(this, EndIndex()); }
+
+  iterator find(uint64_t entry_hash) {
+    return iterator(this, FindIndex(entry_hash));
+  }
+  const_iterator find(uint64_t entry_hash) const {
+    return const_iterator(this, FindIndex(entry_hash));
+  }
+  size_t count(uint64_t entry_hash) const {
+    return FindIndex(entry_hash) != EndIndex() ? 1 : 0;
+  }
+
+  // Inserts |value| unless an element with the same key already exists.
+  // Returns an iterator to the element with the key of |value| and whether the
+  // insertion took place.
+  std::pair<iterator, bool> insert(const value_type& value);
+
+  void erase(iterator it);
+  size_t erase(uint64_t entry_hash);
+
+  void clear();
+  void swap(SimpleIndexEntrySet& other);
+
+  // Grows the table so that it can hold |size| elements without being resized.
+  void reserve(size_t size);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns the number of slots of the table. Each slot takes
+  // sizeof(value_type) bytes whether it is used or not.
+  size_t bucket_count() const { return slots_.size(); }
+
+ private:
+  // Slots whose key is 0 are empty. An element whose key is 0 is stored in
+  // |zero_key_slot_|, which has index |slots_.size()|.
+  value_type& SlotAt(size_t index) {
+    return index < slots_.size() ? slots_[index] : zero_key_slot_;
+  }
+  const value_type& SlotAt(size_t index) const {
+    return index < slots_.size() ? slots_[index] : zero_key_slot_;
+  }
+
+  // Index one past the last slot, used for end().
+  size_t EndIndex() const { return slots_.size() + 1; }
+
+  // Returns the index of the first occupied slot at or after |index|, or
+  // EndIndex() if there is none.
+  size_t NextOccupiedIndex(size_t index) const;
+
+  // Returns the index of the slot holding |entry_hash|, or EndIndex().
+  size_t FindIndex(uint64_t entry_hash) const;
+
+  // Returns the slot at which the probe sequence of |entry_hash| starts.
+  size_t IdealIndex(uint64_t entry_hash) const;
+
+  // Reallocates |slots_| with |num_slots| slots and reinserts all elements.
+  void Rehash(size_t num_slots);
+
+  // Power-of-two sized array of slots, or empty if nothing was ever inserted.
+  std::vector<value_type> slots_;
+
+  value_type zero_key_slot_;
+  bool has_zero_key_ = false;
+
+  // Number of elements, including the one in |zero_key_slot_|.
+  size_t size_ = 0;
+};
+
 // This class is not Thread-safe.
 class NET_EXPORT_PRIVATE SimpleIndex
     : public base::SupportsWeakPtr<SimpleIndex> {
@@ -126,7 +258,7 @@ class NET_EXPORT_PRIVATE SimpleIndex
   // entry.
   bool UpdateEntrySize(uint64_t entry_hash, int64_t entry_size);
 
-  using EntrySet = std::unordered_map<uint64_t, EntryMetadata>;
+  using EntrySet = SimpleIndexEntrySet;
 
   static void InsertInEntrySet(uint64_t entry_hash,
                                const EntryMetadata& entry_metadata,
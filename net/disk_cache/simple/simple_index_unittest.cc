@@ -12,6 +12,7 @@
 #include "base/files/scoped_temp_dir.h"
 #include "base/hash.h"
 #include "base/logging.h"
+#include "base/macros.h"
 #include "base/pickle.h"
 #include "base/sha1.h"
 #include "base/strings/stringprintf.h"
@@ -198,6 +199,99 @@ TEST_F(EntryMetadataTest, Serialize) {
   CheckEntryMetadataValues(new_entry_metadata);
 }
 
+TEST(SimpleIndexEntrySetTest, InsertFindErase) {
+  SimpleIndexEntrySet entry_set;
+  EXPECT_TRUE(entry_set.empty());
+  EXPECT_TRUE(entry_set.begin() == entry_set.end());
+  EXPECT_TRUE(entry_set.find(1) == entry_set.end());
+
+  // Zero is a valid entry hash even though it marks empty slots internally.
+  const uint64_t kHashes[] = {0, 1, 2, 3, UINT64_C(0x8000000000000000),
+                              UINT64_C(0xffffffffffffffff)};
+  for (uint64_t hash : kHashes) {
+    std::pair<SimpleIndexEntrySet::iterator, bool> result =
+        entry_set.insert(std::make_pair(hash, EntryMetadata(base::Time(), 1)));
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(hash, result.first->first);
+  }
+  EXPECT_EQ(arraysize(kHashes), entry_set.size());
+
+  // Inserting an existing hash does not replace its metadata.
+  std::pair<SimpleIndexEntrySet::iterator, bool> result =
+      entry_set.insert(std::make_pair(2, EntryMetadata(base::Time(), 5)));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(1U, result.first->second.GetEntrySize());
+  EXPECT_EQ(arraysize(kHashes), entry_set.size());
+
+  for (uint64_t hash : kHashes) {
+    SimpleIndexEntrySet::iterator it = entry_set.find(hash);
+    ASSERT_TRUE(it != entry_set.end());
+    EXPECT_EQ(hash, it->first);
+    it->second.SetEntrySize(hash & 0xff);
+  }
+
+  size_t num_iterated = 0;
+  for (const SimpleIndexEntrySet::value_type& entry : entry_set) {
+    EXPECT_EQ(entry.first & 0xff, entry.second.GetEntrySize());
+    ++num_iterated;
+  }
+  EXPECT_EQ(arraysize(kHashes), num_iterated);
+
+  EXPECT_EQ(1U, entry_set.erase(0));
+  EXPECT_EQ(0U, entry_set.erase(0));
+  EXPECT_EQ(0U, entry_set.count(0));
+  entry_set.erase(entry_set.find(3));
+  EXPECT_EQ(0U, entry_set.count(3));
+  EXPECT_EQ(1U, entry_set.count(2));
+  EXPECT_EQ(arraysize(kHashes) - 2, entry_set.size());
+
+  entry_set.clear();
+  EXPECT_TRUE(entry_set.empty());
+  EXPECT_EQ(0U, entry_set.bucket_count());
+  EXPECT_TRUE(entry_set.begin() == entry_set.end());
+}
+
+// Erasing entries from colliding probe sequences must keep every remaining
+// entry reachable.
+TEST(SimpleIndexEntrySetTest, ManyEntries) {
+  const uint64_t kNumEntries = 10000;
+  SimpleIndexEntrySet entry_set;
+  for (uint64_t i = 1; i <= kNumEntries; ++i)
+    entry_set.insert(std::make_pair(i, EntryMetadata(base::Time(), i)));
+  EXPECT_EQ(kNumEntries, entry_set.size());
+
+  for (uint64_t i = 1; i <= kNumEntries; i += 3)
+    EXPECT_EQ(1U, entry_set.erase(i));
+  for (uint64_t i = 1; i <= kNumEntries; ++i) {
+    SimpleIndexEntrySet::const_iterator it = entry_set.find(i);
+    if (i % 3 == 1) {
+      EXPECT_TRUE(it == entry_set.end());
+    } else {
+      ASSERT_TRUE(it != entry_set.end());
+      EXPECT_EQ(i, it->second.GetEntrySize());
+    }
+  }
+
+  SimpleIndexEntrySet copy(entry_set);
+  SimpleIndexEntrySet swapped;
+  swapped.swap(entry_set);
+  EXPECT_TRUE(entry_set.empty());
+  EXPECT_EQ(copy.size(), swapped.size());
+  for (const SimpleIndexEntrySet::value_type& entry : copy)
+    EXPECT_EQ(1U, swapped.count(entry.first));
+}
+
+TEST(SimpleIndexEntrySetTest, Reserve) {
+  const size_t kNumEntries = 1000;
+  SimpleIndexEntrySet entry_set;
+  entry_set.reserve(kNumEntries);
+  const size_t bucket_count = entry_set.bucket_count();
+  EXPECT_LE(kNumEntries, bucket_count);
+  for (uint64_t i = 0; i < kNumEntries; ++i)
+    entry_set.insert(std::make_pair(i, EntryMetadata()));
+  EXPECT_EQ(bucket_count, entry_set.bucket_count());
+}
+
 TEST_F(SimpleIndexTest, IndexSizeCorrectOnMerge) {
   index()->SetMaxSize(100);
   index()->Insert(hashes_.at<2>());
@@ -212,6 +212,7 @@ SimpleEntryCreationResults::SimpleEntryCreationResults(
     : sync_entry(NULL),
       entry_stat(entry_stat),
       stream_0_crc32(crc32(0, Z_NULL, 0)),
+      stream_1_crc32(crc32(0, Z_NULL, 0)),
       result(net::OK) {
 }
 
@@ -258,6 +259,7 @@ void SimpleSynchronousEntry::OpenEntry(
     const std::string& key,
     const uint64_t entry_hash,
     const bool had_index,
+    const int read_ahead_size,
     SimpleEntryCreationResults* out_results) {
   base::ElapsedTimer open_time;
   SimpleSynchronousEntry* sync_entry =
@@ -265,11 +267,17 @@ void SimpleSynchronousEntry::OpenEntry(
   out_results->result = sync_entry->InitializeForOpen(
       &out_results->entry_stat, &out_results->stream_0_data,
       &out_results->stream_0_crc32);
+  if (out_results->result == net::OK && read_ahead_size > 0) {
+    out_results->result = sync_entry->ReadStream1Ahead(
+        read_ahead_size, &out_results->entry_stat, &out_results->stream_1_data,
+        &out_results->stream_1_crc32);
+  }
   if (out_results->result != net::OK) {
     sync_entry->Doom();
     delete sync_entry;
     out_results->sync_entry = NULL;
     out_results->stream_0_data = NULL;
+    out_results->stream_1_data = NULL;
     return;
   }
   UMA_HISTOGRAM_TIMES("SimpleCache.DiskOpenLatency", open_time.Elapsed());
@@ -1111,6 +1119,38 @@ int SimpleSynchronousEntry::InitializeForOpen(
   return net::OK;
 }
 
+int SimpleSynchronousEntry::ReadStream1Ahead(
+    int read_ahead_size,
+    SimpleEntryStat* entry_stat,
+    scoped_refptr<net::IOBufferWithSize>* stream_1_data,
+    uint32_t* out_stream_1_crc32) {
+  DCHECK(initialized_);
+  const int stream_1_size = entry_stat->data_size(1);
+  const int read_size = std::min(read_ahead_size, stream_1_size);
+  if (read_size <= 0)
+    return net::OK;
+
+  scoped_refptr<net::IOBufferWithSize> data(
+      new net::IOBufferWithSize(read_size));
+  int result = net::OK;
+  ReadData(EntryOperationData(1, 0, read_size), data.get(), out_stream_1_crc32,
+           entry_stat, &result);
+  if (result < 0)
+    return result;
+  if (result != read_size)
+    return net::ERR_CACHE_READ_FAILURE;
+
+  // As for stream 0, a stream read whole is checked now, since its readers
+  // will not go back to the disk.
+  if (read_size == stream_1_size) {
+    CheckEOFRecord(1, *entry_stat, *out_stream_1_crc32, &result);
+    if (result != net::OK)
+      return result;
+  }
+  *stream_1_data = data;
+  return net::OK;
+}
+
 bool SimpleSynchronousEntry::InitializeCreatedFile(
     int file_index,
     CreateEntryResult* out_result) {
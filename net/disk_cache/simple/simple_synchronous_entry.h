@@ -26,6 +26,7 @@
 namespace net {
 class GrowableIOBuffer;
 class IOBuffer;
+class IOBufferWithSize;
 }
 
 FORWARD_DECLARE_TEST(DiskCacheBackendTest, SimpleCacheEnumerationLongKeys);
@@ -79,8 +80,12 @@ struct SimpleEntryCreationResults {
 
   SimpleSynchronousEntry* sync_entry;
   scoped_refptr<net::GrowableIOBuffer> stream_0_data;
+  // The beginning of stream 1, if it was read ahead when opening the entry,
+  // and its crc32.
+  scoped_refptr<net::IOBufferWithSize> stream_1_data;
   SimpleEntryStat entry_stat;
   uint32_t stream_0_crc32;
+  uint32_t stream_1_crc32;
   int result;
 };
 
@@ -117,12 +122,14 @@ class SimpleSynchronousEntry {
 
   // Opens a disk cache entry on disk. The |key| parameter is optional, if empty
   // the operation may be slower. The |entry_hash| parameter is required.
-  // |had_index| is provided only for histograms.
+  // |had_index| is provided only for histograms. Up to |read_ahead_size| bytes
+  // of stream 1 are read into |out_results| along with stream 0.
   static void OpenEntry(net::CacheType cache_type,
                         const base::FilePath& path,
                         const std::string& key,
                         uint64_t entry_hash,
                         bool had_index,
+                        int read_ahead_size,
                         SimpleEntryCreationResults* out_results);
 
   static void CreateEntry(net::CacheType cache_type,
@@ -257,6 +264,14 @@ class SimpleSynchronousEntry {
                         scoped_refptr<net::GrowableIOBuffer>* stream_0_data,
                         uint32_t* out_stream_0_crc32);
 
+  // Reads up to |read_ahead_size| bytes from the beginning of stream 1 into
+  // |stream_1_data|, checking the EOF record of the stream if it was read
+  // whole. Returns a net error, i.e. net::OK on success.
+  int ReadStream1Ahead(int read_ahead_size,
+                       SimpleEntryStat* entry_stat,
+                       scoped_refptr<net::IOBufferWithSize>* stream_1_data,
+                       uint32_t* out_stream_1_crc32);
+
   // Writes the header and key to a newly-created stream file. |index| is the
   // index of the stream. Returns true on success; returns false and sets
   // |*out_result| on failure.
@@ -26,6 +26,14 @@ namespace {
 #define CACHE_HISTOGRAM_ENUM(name, value, max) \
   UMA_HISTOGRAM_ENUMERATION("DNS.HostCache." name, value, max)
 
+// Minimum number of hits for a valid entry to be refreshed ahead of its
+// expiration.
+const int kRefreshAheadMinHits = 2;
+
+// Entries are refreshed ahead of their expiration once less than
+// 1/kRefreshAheadDivisor of their lifetime is left.
+const int kRefreshAheadDivisor = 10;
+
 }  // namespace
 
 // Used in histograms; do not modify existing values.
@@ -75,9 +83,11 @@ HostCache::Entry::Entry(const HostCache::Entry& entry,
       addresses_(entry.addresses()),
       ttl_(entry.ttl()),
       expires_(now + ttl),
+      lifetime_(ttl),
       network_changes_(network_changes),
       total_hits_(0),
-      stale_hits_(0) {}
+      stale_hits_(0),
+      refresh_requested_(false) {}
 
 bool HostCache::Entry::IsStale(base::TimeTicks now, int network_changes) const {
   EntryStaleness stale;
@@ -87,6 +97,12 @@ bool HostCache::Entry::IsStale(base::TimeTicks now, int network_changes) const {
   return stale.is_stale();
 }
 
+bool HostCache::Entry::IsDueForRefresh(base::TimeTicks now) const {
+  return error_ == OK && !refresh_requested_ &&
+         total_hits_ >= kRefreshAheadMinHits &&
+         expires_ - now <= lifetime_ / kRefreshAheadDivisor;
+}
+
 void HostCache::Entry::CountHit(bool hit_is_stale) {
   ++total_hits_;
   if (hit_is_stale)
@@ -102,8 +118,32 @@ void HostCache::Entry::GetStaleness(base::TimeTicks now,
   out->stale_hits = stale_hits_;
 }
 
+HostCache::Counters::Counters()
+    : hits(0),
+      stale_hits(0),
+      negative_hits(0),
+      misses(0),
+      insertions(0),
+      evictions(0),
+      refreshes(0) {}
+
+HostCache::Counters& HostCache::Counters::operator+=(const Counters& other) {
+  hits += other.hits;
+  stale_hits += other.stale_hits;
+  negative_hits += other.negative_hits;
+  misses += other.misses;
+  insertions += other.insertions;
+  evictions += other.evictions;
+  refreshes += other.refreshes;
+  return *this;
+}
+
+HostCache::Shard::Shard() {}
+
+HostCache::Shard::~Shard() {}
+
 HostCache::HostCache(size_t max_entries)
-    : max_entries_(max_entries), network_changes_(0) {}
+    : num_entries_(0), max_entries_(max_entries), network_changes_(0) {}
 
 HostCache::~HostCache() {
   RecordEraseAll(ERASE_DESTRUCT, base::TimeTicks::Now());
@@ -111,103 +151,204 @@ HostCache::~HostCache() {
 
 const HostCache::Entry* HostCache::Lookup(const Key& key,
                                           base::TimeTicks now) {
-  DCHECK(CalledOnValidThread());
+  DCHECK(thread_checker_.CalledOnValidThread());
   if (caching_is_disabled())
     return nullptr;
 
-  HostCache::Entry* entry = LookupInternal(key);
-  if (!entry) {
-    RecordLookup(LOOKUP_MISS_ABSENT, now, nullptr);
-    return nullptr;
-  }
-  if (entry->IsStale(now, network_changes_)) {
-    RecordLookup(LOOKUP_MISS_STALE, now, entry);
-    return nullptr;
-  }
+  // The entry can only be removed or replaced on this thread, so it outlives
+  // the lock.
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  return LookupInternal(&shard, key, now, false /* allow_stale */);
+}
 
-  entry->CountHit(/* hit_is_stale= */ false);
-  RecordLookup(LOOKUP_HIT_VALID, now, entry);
-  return entry;
+bool HostCache::LookupCopy(const Key& key,
+                           base::TimeTicks now,
+                           Entry* entry_out) {
+  DCHECK(entry_out);
+  if (caching_is_disabled())
+    return false;
+
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  const Entry* entry =
+      LookupInternal(&shard, key, now, false /* allow_stale */);
+  if (!entry)
+    return false;
+  *entry_out = *entry;
+  return true;
 }
 
 const HostCache::Entry* HostCache::LookupStale(
     const Key& key,
     base::TimeTicks now,
     HostCache::EntryStaleness* stale_out) {
-  DCHECK(CalledOnValidThread());
+  DCHECK(thread_checker_.CalledOnValidThread());
   if (caching_is_disabled())
     return nullptr;
 
-  HostCache::Entry* entry = LookupInternal(key);
-  if (!entry) {
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  const Entry* entry = LookupInternal(&shard, key, now, true /* allow_stale */);
+  if (entry && stale_out)
+    entry->GetStaleness(now, network_changes(), stale_out);
+  return entry;
+}
+
+bool HostCache::LookupStaleCopy(const Key& key,
+                                base::TimeTicks now,
+                                Entry* entry_out,
+                                EntryStaleness* stale_out) {
+  DCHECK(entry_out);
+  if (caching_is_disabled())
+    return false;
+
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  const Entry* entry = LookupInternal(&shard, key, now, true /* allow_stale */);
+  if (!entry)
+    return false;
+  *entry_out = *entry;
+  if (stale_out)
+    entry->GetStaleness(now, network_changes(), stale_out);
+  return true;
+}
+
+bool HostCache::ShouldRefreshAhead(const Key& key, base::TimeTicks now) {
+  if (caching_is_disabled())
+    return false;
+
+  Shard& shard = GetShard(key);
+  base::AutoLock lock(shard.lock);
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end())
+    return false;
+  Entry* entry = &it->second;
+  if (entry->IsStale(now, network_changes()) || !entry->IsDueForRefresh(now))
+    return false;
+
+  entry->refresh_requested_ = true;
+  ++shard.counters.refreshes;
+  return true;
+}
+
+HostCache::Shard& HostCache::GetShard(const Key& key) {
+  return shards_[std::hash<std::string>()(key.hostname) % kNumShards];
+}
+
+HostCache::Entry* HostCache::LookupInternal(Shard* shard,
+                                            const Key& key,
+                                            base::TimeTicks now,
+                                            bool allow_stale) {
+  shard->lock.AssertAcquired();
+  auto it = shard->entries.find(key);
+  if (it == shard->entries.end()) {
+    ++shard->counters.misses;
     RecordLookup(LOOKUP_MISS_ABSENT, now, nullptr);
     return nullptr;
   }
 
-  bool is_stale = entry->IsStale(now, network_changes_);
+  Entry* entry = &it->second;
+  bool is_stale = entry->IsStale(now, network_changes());
+  if (is_stale && !allow_stale) {
+    ++shard->counters.misses;
+    RecordLookup(LOOKUP_MISS_STALE, now, entry);
+    return nullptr;
+  }
+
   entry->CountHit(/* hit_is_stale= */ is_stale);
+  if (is_stale)
+    ++shard->counters.stale_hits;
+  else
+    ++shard->counters.hits;
+  if (entry->error() != OK)
+    ++shard->counters.negative_hits;
   RecordLookup(is_stale ? LOOKUP_HIT_STALE : LOOKUP_HIT_VALID, now, entry);
-
-  if (stale_out)
-    entry->GetStaleness(now, network_changes_, stale_out);
   return entry;
 }
 
-HostCache::Entry* HostCache::LookupInternal(const Key& key) {
-  auto it = entries_.find(key);
-  return (it != entries_.end()) ? &it->second : nullptr;
-}
-
 void HostCache::Set(const Key& key,
                     const Entry& entry,
                     base::TimeTicks now,
                     base::TimeDelta ttl) {
   TRACE_EVENT0("net", "HostCache::Set");
-  DCHECK(CalledOnValidThread());
+  DCHECK(thread_checker_.CalledOnValidThread());
   if (caching_is_disabled())
     return;
 
-  auto it = entries_.find(key);
-  if (it != entries_.end()) {
-    bool is_stale = it->second.IsStale(now, network_changes_);
-    RecordSet(is_stale ? SET_UPDATE_STALE : SET_UPDATE_VALID, now, &it->second,
-              entry);
-    // TODO(juliatuttle): Remember some old metadata (hit count or frequency or
-    // something like that) if it's useful for better eviction algorithms?
-    entries_.erase(it);
-  } else {
-    if (size() == max_entries_)
-      EvictOneEntry(now);
-    RecordSet(SET_INSERT, now, nullptr, entry);
+  // Only this thread adds or removes entries, so the shard is not modified
+  // between the two critical sections below, and evicting from another shard
+  // does not require holding more than one lock at a time.
+  Shard& shard = GetShard(key);
+  {
+    base::AutoLock lock(shard.lock);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+      bool is_stale = it->second.IsStale(now, network_changes());
+      RecordSet(is_stale ? SET_UPDATE_STALE : SET_UPDATE_VALID, now,
+                &it->second, entry);
+      // TODO(juliatuttle): Remember some old metadata (hit count or frequency
+      // or something like that) if it's useful for better eviction
+      // algorithms?
+      it->second = Entry(entry, now, ttl, network_changes());
+      return;
+    }
   }
 
-  DCHECK_GT(max_entries_, size());
-  DCHECK_EQ(0u, entries_.count(key));
-  entries_.insert(
-      std::make_pair(Key(key), Entry(entry, now, ttl, network_changes_)));
-  DCHECK_GE(max_entries_, size());
+  if (num_entries_ == max_entries_)
+    EvictOneEntry(now);
+  RecordSet(SET_INSERT, now, nullptr, entry);
+
+  DCHECK_GT(max_entries_, num_entries_);
+  base::AutoLock lock(shard.lock);
+  shard.entries.insert(
+      std::make_pair(Key(key), Entry(entry, now, ttl, network_changes())));
+  ++shard.counters.insertions;
+  ++num_entries_;
 }
 
 void HostCache::OnNetworkChange() {
-  ++network_changes_;
+  DCHECK(thread_checker_.CalledOnValidThread());
+  base::subtle::NoBarrier_AtomicIncrement(&network_changes_, 1);
 }
 
 void HostCache::clear() {
-  DCHECK(CalledOnValidThread());
+  DCHECK(thread_checker_.CalledOnValidThread());
   RecordEraseAll(ERASE_CLEAR, base::TimeTicks::Now());
-  entries_.clear();
+  for (Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    shard.entries.clear();
+  }
+  num_entries_ = 0;
 }
 
 size_t HostCache::size() const {
-  DCHECK(CalledOnValidThread());
-  return entries_.size();
+  DCHECK(thread_checker_.CalledOnValidThread());
+  return num_entries_;
 }
 
 size_t HostCache::max_entries() const {
-  DCHECK(CalledOnValidThread());
   return max_entries_;
 }
 
+HostCache::EntryMap HostCache::GetEntries() const {
+  EntryMap entries;
+  for (const Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    entries.insert(shard.entries.begin(), shard.entries.end());
+  }
+  return entries;
+}
+
+HostCache::Counters HostCache::GetCounters() const {
+  Counters counters;
+  for (const Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    counters += shard.counters;
+  }
+  return counters;
+}
+
 // static
 std::unique_ptr<HostCache> HostCache::CreateDefaultCache() {
 // Cache capacity is determined by the field trial.
@@ -226,16 +367,28 @@ std::unique_ptr<HostCache> HostCache::CreateDefaultCache() {
 }
 
 void HostCache::EvictOneEntry(base::TimeTicks now) {
-  DCHECK_LT(0u, entries_.size());
-
-  auto oldest_it = entries_.begin();
-  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
-    if (it->second.expires() < oldest_it->second.expires())
-      oldest_it = it;
+  DCHECK_LT(0u, num_entries_);
+
+  // Only this thread adds or removes entries, so the iterator to the oldest
+  // entry remains valid after its shard is unlocked.
+  Shard* oldest_shard = nullptr;
+  EntryMap::iterator oldest_it;
+  for (Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    for (auto it = shard.entries.begin(); it != shard.entries.end(); ++it) {
+      if (!oldest_shard || it->second.expires() < oldest_it->second.expires()) {
+        oldest_shard = &shard;
+        oldest_it = it;
+      }
+    }
   }
+  DCHECK(oldest_shard);
 
+  base::AutoLock lock(oldest_shard->lock);
   RecordErase(ERASE_EVICT, now, oldest_it->second);
-  entries_.erase(oldest_it);
+  oldest_shard->entries.erase(oldest_it);
+  ++oldest_shard->counters.evictions;
+  --num_entries_;
 }
 
 void HostCache::RecordSet(SetOutcome outcome,
@@ -250,7 +403,7 @@ void HostCache::RecordSet(SetOutcome outcome,
       break;
     case SET_UPDATE_STALE: {
       EntryStaleness stale;
-      old_entry->GetStaleness(now, network_changes_, &stale);
+      old_entry->GetStaleness(now, network_changes(), &stale);
       CACHE_HISTOGRAM_TIME("UpdateStale.ExpiredBy", stale.expired_by);
       CACHE_HISTOGRAM_COUNT("UpdateStale.NetworkChanges",
                             stale.network_changes);
@@ -311,7 +464,7 @@ void HostCache::RecordLookup(LookupOutcome outcome,
     case LOOKUP_HIT_STALE:
       CACHE_HISTOGRAM_TIME("LookupStale.ExpiredBy", now - entry->expires());
       CACHE_HISTOGRAM_COUNT("LookupStale.NetworkChanges",
-                            network_changes_ - entry->network_changes());
+                            network_changes() - entry->network_changes());
       break;
     case MAX_LOOKUP_OUTCOME:
       NOTREACHED();
@@ -323,7 +476,7 @@ void HostCache::RecordErase(EraseReason reason,
                             base::TimeTicks now,
                             const Entry& entry) {
   HostCache::EntryStaleness stale;
-  entry.GetStaleness(now, network_changes_, &stale);
+  entry.GetStaleness(now, network_changes(), &stale);
   CACHE_HISTOGRAM_ENUM("Erase", reason, MAX_ERASE_REASON);
   if (stale.is_stale()) {
     CACHE_HISTOGRAM_TIME("EraseStale.ExpiredBy", stale.expired_by);
@@ -335,8 +488,11 @@ void HostCache::RecordErase(EraseReason reason,
 }
 
 void HostCache::RecordEraseAll(EraseReason reason, base::TimeTicks now) {
-  for (const auto& it : entries_)
-    RecordErase(reason, now, it.second);
+  for (const Shard& shard : shards_) {
+    base::AutoLock lock(shard.lock);
+    for (const auto& it : shard.entries)
+      RecordErase(reason, now, it.second);
+  }
 }
 
 }  // namespace net
@@ -8,13 +8,16 @@
 #include <stddef.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <tuple>
 
+#include "base/atomicops.h"
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
-#include "base/threading/non_thread_safe.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_checker.h"
 #include "base/time/time.h"
 #include "net/base/address_family.h"
 #include "net/base/address_list.h"
@@ -25,7 +28,14 @@
 namespace net {
 
 // Cache used by HostResolver to map hostnames to their resolved result.
-class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
+//
+// Entries are spread over several independently locked shards, so that the
+// cache can be read from any thread without contending on a single lock.
+// Set(), clear() and OnNetworkChange() must be called on the thread the cache
+// was created on, as must Lookup() and LookupStale(), whose returned pointers
+// are only valid until the next call to Set() or clear(). The other methods
+// are thread-safe unless noted otherwise.
+class NET_EXPORT HostCache {
  public:
   struct Key {
     Key(const std::string& hostname, AddressFamily address_family,
@@ -92,6 +102,7 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
     int stale_hits() const { return stale_hits_; }
 
     bool IsStale(base::TimeTicks now, int network_changes) const;
+    bool IsDueForRefresh(base::TimeTicks now) const;
     void CountHit(bool hit_is_stale);
     void GetStaleness(base::TimeTicks now,
                       int network_changes,
@@ -104,12 +115,39 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
     base::TimeDelta ttl_;
 
     base::TimeTicks expires_;
+    // How long the entry is valid for, from the time it was set.
+    base::TimeDelta lifetime_;
     // Copied from the cache's network_changes_ when the entry is set; can0
     // later be compared to it to see if the entry was received on the current
     // network.
     int network_changes_;
     int total_hits_;
     int stale_hits_;
+    // Whether ShouldRefreshAhead() already returned true for this entry.
+    bool refresh_requested_;
+  };
+
+  // Running totals of cache activity since the cache was created, shown in
+  // net-internals.
+  struct NET_EXPORT Counters {
+    Counters();
+
+    Counters& operator+=(const Counters& other);
+
+    // Lookups that returned a valid entry.
+    size_t hits;
+    // Lookups that returned a stale entry; only LookupStale() does.
+    size_t stale_hits;
+    // Hits, valid or stale, on an entry caching an error.
+    size_t negative_hits;
+    // Lookups that found no entry, or only a stale one.
+    size_t misses;
+    // Entries added for a key that was not in the cache.
+    size_t insertions;
+    // Entries removed to make room for another.
+    size_t evictions;
+    // Entries ShouldRefreshAhead() selected for refresh.
+    size_t refreshes;
   };
 
   using EntryMap = std::map<Key, Entry>;
@@ -123,6 +161,10 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
   // |now|. If there is no such entry, returns NULL.
   const Entry* Lookup(const Key& key, base::TimeTicks now);
 
+  // Thread-safe variant of Lookup(), which copies the entry into |*entry_out|.
+  // Returns false if there is no valid entry.
+  bool LookupCopy(const Key& key, base::TimeTicks now, Entry* entry_out);
+
   // Returns a pointer to the entry for |key|, whether it is valid or stale at
   // time |now|. Fills in |stale_out| with information about how stale it is.
   // If there is no entry for |key| at all, returns NULL.
@@ -130,6 +172,19 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
                            base::TimeTicks now,
                            EntryStaleness* stale_out);
 
+  // Thread-safe variant of LookupStale(), which copies the entry into
+  // |*entry_out|. Returns false if there is no entry at all.
+  bool LookupStaleCopy(const Key& key,
+                       base::TimeTicks now,
+                       Entry* entry_out,
+                       EntryStaleness* stale_out);
+
+  // Returns true if the entry for |key| should be resolved again ahead of its
+  // expiration: it is valid and successful at time |now|, has been hit
+  // several times, and is close to expiring. Returns true at most once per
+  // entry.
+  bool ShouldRefreshAhead(const Key& key, base::TimeTicks now);
+
   // Overwrites or creates an entry for |key|.
   // |entry| is the value to set, |now| is the current time
   // |ttl| is the "time to live".
@@ -150,7 +205,10 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
   // Following are used by net_internals UI.
   size_t max_entries() const;
 
-  const EntryMap& entries() const { return entries_; }
+  // Returns a snapshot of all the entries in the cache.
+  EntryMap GetEntries() const;
+
+  Counters GetCounters() const;
 
   // Creates a default cache.
   static std::unique_ptr<HostCache> CreateDefaultCache();
@@ -162,7 +220,32 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
   enum LookupOutcome : int;
   enum EraseReason : int;
 
-  Entry* LookupInternal(const Key& key);
+  // Number of independently locked shards the entries are spread over.
+  static const size_t kNumShards = 16;
+
+  struct Shard {
+    Shard();
+    ~Shard();
+
+    // Guards |entries| and |counters|.
+    mutable base::Lock lock;
+    EntryMap entries;
+    Counters counters;
+  };
+
+  Shard& GetShard(const Key& key);
+
+  // Looks up |key| in |shard|, whose lock must be held, counting the hit or
+  // miss. Returns null if there is no entry, or if it is stale and
+  // |allow_stale| is false.
+  Entry* LookupInternal(Shard* shard,
+                        const Key& key,
+                        base::TimeTicks now,
+                        bool allow_stale);
+
+  int network_changes() const {
+    return base::subtle::NoBarrier_Load(&network_changes_);
+  }
 
   void RecordSet(SetOutcome outcome,
                  base::TimeTicks now,
@@ -181,11 +264,16 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
 
   void EvictOneEntry(base::TimeTicks now);
 
-  // Map from hostname (presumably in lowercase canonicalized format) to
-  // a resolved result entry.
-  EntryMap entries_;
-  size_t max_entries_;
-  int network_changes_;
+  // Maps from hostname (presumably in lowercase canonicalized format) to
+  // a resolved result entry, split by hostname hash.
+  Shard shards_[kNumShards];
+  // Total number of entries across |shards_|. Only accessed on the owning
+  // thread.
+  size_t num_entries_;
+  const size_t max_entries_;
+  volatile base::subtle::Atomic32 network_changes_;
+
+  base::ThreadChecker thread_checker_;
 
   DISALLOW_COPY_AND_ASSIGN(HostCache);
 };
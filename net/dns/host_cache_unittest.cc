@@ -4,10 +4,16 @@
 
 #include "net/dns/host_cache.h"
 
+#include <memory>
+#include <vector>
+
 #include "base/format_macros.h"
+#include "base/memory/ptr_util.h"
 #include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "net/base/ip_address.h"
 #include "net/base/net_errors.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -395,6 +401,221 @@ TEST(HostCacheTest, Stale) {
   EXPECT_EQ(3, stale.stale_hits);
 }
 
+// Eviction should pick the entry with the oldest expiration time across all
+// the shards, not just among the entries sharing a shard with the new one.
+TEST(HostCacheTest, EvictAcrossShards) {
+  const size_t kMaxEntries = 50;
+  HostCache cache(kMaxEntries);
+
+  base::TimeTicks now;
+  HostCache::Entry entry = HostCache::Entry(OK, AddressList());
+
+  // "host0" expires first, then "host1", and so on.
+  for (size_t i = 0; i < kMaxEntries; ++i) {
+    cache.Set(Key(base::StringPrintf("host%" PRIuS, i)), entry, now,
+              base::TimeDelta::FromSeconds(10 + i));
+  }
+  EXPECT_EQ(kMaxEntries, cache.size());
+
+  for (size_t i = 0; i < kMaxEntries / 2; ++i) {
+    cache.Set(Key(base::StringPrintf("new%" PRIuS, i)), entry, now,
+              base::TimeDelta::FromSeconds(1000));
+    EXPECT_EQ(kMaxEntries, cache.size());
+    EXPECT_FALSE(cache.Lookup(Key(base::StringPrintf("host%" PRIuS, i)), now));
+    EXPECT_TRUE(
+        cache.Lookup(Key(base::StringPrintf("host%" PRIuS, i + 1)), now));
+  }
+
+  EXPECT_EQ(kMaxEntries, cache.GetEntries().size());
+  EXPECT_EQ(kMaxEntries / 2, cache.GetCounters().evictions);
+}
+
+TEST(HostCacheTest, LookupCopy) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(kMaxCacheEntries);
+
+  base::TimeTicks now;
+  HostCache::Key key = Key("foobar.com");
+  HostCache::Entry copy(ERR_UNEXPECTED, AddressList());
+  HostCache::EntryStaleness stale;
+
+  EXPECT_FALSE(cache.LookupCopy(key, now, &copy));
+  EXPECT_FALSE(cache.LookupStaleCopy(key, now, &copy, &stale));
+
+  AddressList addresses =
+      AddressList::CreateFromIPAddress(IPAddress(1, 2, 3, 4), 80);
+  cache.Set(key, HostCache::Entry(OK, addresses), now, kTTL);
+
+  EXPECT_TRUE(cache.LookupCopy(key, now, &copy));
+  EXPECT_EQ(OK, copy.error());
+  EXPECT_EQ(addresses.size(), copy.addresses().size());
+  EXPECT_EQ(now + kTTL, copy.expires());
+
+  // The copy stays valid when the entry is removed.
+  now += base::TimeDelta::FromSeconds(15);
+  EXPECT_FALSE(cache.LookupCopy(key, now, &copy));
+  EXPECT_TRUE(cache.LookupStaleCopy(key, now, &copy, &stale));
+  EXPECT_TRUE(stale.is_stale());
+  cache.clear();
+  EXPECT_EQ(OK, copy.error());
+  EXPECT_EQ(addresses.size(), copy.addresses().size());
+}
+
+// Popular entries should be refreshed once, shortly before they expire.
+TEST(HostCacheTest, RefreshAhead) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(100);
+
+  HostCache cache(kMaxCacheEntries);
+
+  base::TimeTicks now;
+  HostCache::Key key = Key("foobar.com");
+  HostCache::Key negative_key = Key("negative.com");
+  cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  cache.Set(negative_key,
+            HostCache::Entry(ERR_NAME_NOT_RESOLVED, AddressList()), now,
+            2 * kTTL);
+
+  // Not popular yet.
+  now += base::TimeDelta::FromSeconds(95);
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_FALSE(cache.ShouldRefreshAhead(key, now));
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_TRUE(cache.Lookup(negative_key, now));
+  EXPECT_TRUE(cache.Lookup(negative_key, now));
+
+  // Popular, but not close enough to expiring.
+  cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_FALSE(cache.ShouldRefreshAhead(key, now));
+
+  now += base::TimeDelta::FromSeconds(89);
+  EXPECT_FALSE(cache.ShouldRefreshAhead(key, now));
+  now += base::TimeDelta::FromSeconds(1);
+  EXPECT_TRUE(cache.ShouldRefreshAhead(key, now));
+  // Only once per entry.
+  EXPECT_FALSE(cache.ShouldRefreshAhead(key, now));
+
+  // Errors and stale entries are never refreshed ahead.
+  EXPECT_FALSE(cache.ShouldRefreshAhead(negative_key, now));
+  cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_TRUE(cache.Lookup(key, now));
+  cache.OnNetworkChange();
+  EXPECT_FALSE(cache.ShouldRefreshAhead(key, now + kTTL / 2));
+
+  EXPECT_EQ(1u, cache.GetCounters().refreshes);
+}
+
+TEST(HostCacheTest, Counters) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+
+  HostCache cache(kMaxCacheEntries);
+
+  base::TimeTicks now;
+  HostCache::EntryStaleness stale;
+  HostCache::Key key = Key("foobar.com");
+  HostCache::Key negative_key = Key("negative.com");
+
+  EXPECT_FALSE(cache.Lookup(key, now));
+  cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  cache.Set(negative_key,
+            HostCache::Entry(ERR_NAME_NOT_RESOLVED, AddressList()), now, kTTL);
+  EXPECT_TRUE(cache.Lookup(key, now));
+  EXPECT_TRUE(cache.LookupStale(key, now, &stale));
+  EXPECT_TRUE(cache.Lookup(negative_key, now));
+
+  now += base::TimeDelta::FromSeconds(15);
+  EXPECT_FALSE(cache.Lookup(key, now));
+  EXPECT_TRUE(cache.LookupStale(negative_key, now, &stale));
+
+  HostCache::Counters counters = cache.GetCounters();
+  EXPECT_EQ(3u, counters.hits);
+  EXPECT_EQ(1u, counters.stale_hits);
+  EXPECT_EQ(2u, counters.negative_hits);
+  EXPECT_EQ(2u, counters.misses);
+  EXPECT_EQ(2u, counters.insertions);
+  EXPECT_EQ(0u, counters.evictions);
+  EXPECT_EQ(0u, counters.refreshes);
+}
+
+namespace {
+
+// Looks up all the keys of a cache from another thread.
+class LookupThreadDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  LookupThreadDelegate(HostCache* cache,
+                       const std::vector<HostCache::Key>& keys,
+                       base::TimeTicks now)
+      : cache_(cache), keys_(keys), now_(now), num_hits_(0) {}
+
+  // base::DelegateSimpleThread::Delegate:
+  void Run() override {
+    HostCache::Entry entry(ERR_UNEXPECTED, AddressList());
+    for (int i = 0; i < 100; ++i) {
+      for (const HostCache::Key& key : keys_) {
+        if (cache_->LookupCopy(key, now_, &entry) && entry.error() == OK)
+          ++num_hits_;
+      }
+    }
+  }
+
+  int num_hits() const { return num_hits_; }
+
+ private:
+  HostCache* cache_;
+  const std::vector<HostCache::Key> keys_;
+  const base::TimeTicks now_;
+  int num_hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupThreadDelegate);
+};
+
+}  // namespace
+
+// Lookups from other threads may run while the owning thread updates the
+// cache.
+TEST(HostCacheTest, LookupFromOtherThreads) {
+  const base::TimeDelta kTTL = base::TimeDelta::FromSeconds(10);
+  const size_t kNumKeys = 20;
+  const size_t kNumThreads = 4;
+
+  HostCache cache(kNumKeys);
+  base::TimeTicks now;
+  std::vector<HostCache::Key> keys;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    keys.push_back(Key(base::StringPrintf("host%" PRIuS, i)));
+    cache.Set(keys.back(), HostCache::Entry(OK, AddressList()), now, kTTL);
+  }
+
+  std::vector<std::unique_ptr<LookupThreadDelegate>> delegates;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    delegates.push_back(
+        base::WrapUnique(new LookupThreadDelegate(&cache, keys, now)));
+    threads.push_back(base::WrapUnique(new base::DelegateSimpleThread(
+        delegates.back().get(), base::StringPrintf("Lookup%" PRIuS, i))));
+    threads.back()->Start();
+  }
+
+  // Keeps replacing the entries meanwhile.
+  for (int i = 0; i < 100; ++i) {
+    for (const HostCache::Key& key : keys)
+      cache.Set(key, HostCache::Entry(OK, AddressList()), now, kTTL);
+  }
+
+  for (const auto& thread : threads)
+    thread->Join();
+
+  // Every key is always present and valid.
+  for (const auto& delegate : delegates)
+    EXPECT_EQ(static_cast<int>(100 * kNumKeys), delegate->num_hits());
+  EXPECT_EQ(kNumKeys, cache.size());
+  EXPECT_EQ(kNumThreads * 100 * kNumKeys, cache.GetCounters().hits);
+}
+
 // Tests the less than and equal operators for HostCache::Key work.
 TEST(HostCacheTest, KeyComparators) {
   struct {
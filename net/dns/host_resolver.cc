@@ -87,7 +87,8 @@ PrioritizedDispatcher::Limits HostResolver::Options::GetDispatcherLimits()
 HostResolver::Options::Options()
     : max_concurrent_resolves(kDefaultParallelism),
       max_retry_attempts(kDefaultRetryAttempts),
-      enable_caching(true) {
+      enable_caching(true),
+      enable_refresh_ahead(false) {
 }
 
 HostResolver::RequestInfo::RequestInfo(const HostPortPair& host_port_pair)
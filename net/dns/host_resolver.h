@@ -49,6 +49,9 @@ class NET_EXPORT HostResolver {
   // resolution. Pass HostResolver::kDefaultRetryAttempts to choose a default
   // value.
   // |enable_caching| controls whether a HostCache is used.
+  // |enable_refresh_ahead| controls whether popular cache entries are resolved
+  // again in the background shortly before they expire. It has no effect
+  // unless |enable_caching| is true.
   struct NET_EXPORT Options {
     Options();
 
@@ -57,6 +60,7 @@ class NET_EXPORT HostResolver {
     size_t max_concurrent_resolves;
     size_t max_retry_attempts;
     bool enable_caching;
+    bool enable_refresh_ahead;
   };
 
   // The parameters for doing a Resolve(). A hostname and port are
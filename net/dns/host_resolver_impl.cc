@@ -449,6 +449,10 @@ void LogCancelRequest(const BoundNetLog& source_net_log,
   source_net_log.EndEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_REQUEST);
 }
 
+// Completion callback of the Requests keeping refresh-ahead Jobs alive. The
+// result only matters to the cache, which the Job updates.
+void OnRefreshAheadComplete(AddressList* addresses, int net_error) {}
+
 //-----------------------------------------------------------------------------
 
 // Keeps track of the highest priority.
@@ -1288,6 +1292,7 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job,
         priority_tracker_(priority),
         worker_task_runner_(std::move(worker_task_runner)),
         had_non_speculative_request_(false),
+        is_refresh_ahead_only_(false),
         had_dns_config_(false),
         num_occupied_job_slots_(0),
         dns_task_error_(OK),
@@ -1333,6 +1338,10 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job,
     }
   }
 
+  // Marks this Job as only refreshing a cache entry ahead of its expiration,
+  // until another Request is added.
+  void set_is_refresh_ahead_only() { is_refresh_ahead_only_ = true; }
+
   // Add this job to the dispatcher.  If "at_head" is true, adds at the front
   // of the queue.
   void Schedule(bool at_head) {
@@ -1355,6 +1364,7 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job,
   void AddRequest(std::unique_ptr<Request> req) {
     DCHECK_EQ(key_.hostname, req->info().hostname());
 
+    is_refresh_ahead_only_ = false;
     req->set_job(this);
     priority_tracker_.Add(req->priority());
 
@@ -1773,7 +1783,10 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job,
 
     bool did_complete = (entry.error() != ERR_NETWORK_CHANGED) &&
                         (entry.error() != ERR_HOST_RESOLVER_QUEUE_TOO_LARGE);
-    if (did_complete)
+    // A refresh-ahead starts while the entry is still valid and successful.
+    // Nobody is waiting for its result, so a failure keeps that entry rather
+    // than evicting a good address before it expires.
+    if (did_complete && !(is_refresh_ahead_only_ && entry.error() != OK))
       resolver_->CacheResult(key_, entry, ttl);
 
     // Complete all of the requests that were attached to the job.
@@ -1833,6 +1846,10 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job,
 
   bool had_non_speculative_request_;
 
+  // Whether the only Request of this Job is the one added by
+  // HostResolverImpl::MaybeRefreshAhead().
+  bool is_refresh_ahead_only_;
+
   // Distinguishes measurements taken while DnsClient was fully configured.
   bool had_dns_config_;
 
@@ -1980,7 +1997,8 @@ HostResolverImpl::HostResolverImpl(
     const Options& options,
     NetLog* net_log,
     scoped_refptr<base::TaskRunner> worker_task_runner)
-    : max_queued_jobs_(0),
+    : refresh_ahead_enabled_(options.enable_refresh_ahead),
+      max_queued_jobs_(0),
       proc_params_(NULL, options.max_retry_attempts),
       net_log_(net_log),
       received_dns_config_(false),
@@ -2061,6 +2079,7 @@ int HostResolverImpl::ResolveHelper(const Key& key,
   if (ServeFromCache(key, info, &net_error, addresses, allow_stale,
                      stale_info)) {
     source_net_log.AddEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_CACHE_HIT);
+    MaybeRefreshAhead(key, source_net_log);
     // |ServeFromCache()| will set |*stale_info| as needed.
     return net_error;
   }
@@ -2305,6 +2324,40 @@ bool HostResolverImpl::ServeLocalhost(const Key& key,
   return true;
 }
 
+void HostResolverImpl::MaybeRefreshAhead(const Key& key,
+                                         const BoundNetLog& source_net_log) {
+  if (!refresh_ahead_enabled_ || !cache_.get())
+    return;
+  // A Job for |key| will update the entry anyway. Refreshes are best-effort,
+  // so they are not allowed to evict queued Jobs either.
+  if (ContainsKey(jobs_, key) ||
+      dispatcher_->num_queued_jobs() >= max_queued_jobs_) {
+    return;
+  }
+  if (!cache_->ShouldRefreshAhead(key, base::TimeTicks::Now()))
+    return;
+
+  source_net_log.AddEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_REFRESH_AHEAD);
+
+  Job* job = new Job(weak_ptr_factory_.GetWeakPtr(), key, IDLE,
+                     worker_task_runner_, source_net_log);
+  job->Schedule(false);
+  jobs_.insert(std::make_pair(key, job));
+
+  // The Job needs a Request to run. Nobody waits for this one: it only keeps
+  // the Job alive until the result reaches the cache.
+  RequestInfo info(HostPortPair(key.hostname, 0));
+  info.set_address_family(key.address_family);
+  info.set_host_resolver_flags(key.host_resolver_flags);
+  info.set_is_speculative(true);
+  AddressList* addresses = new AddressList();
+  job->AddRequest(base::WrapUnique(new Request(
+      BoundNetLog(), info, IDLE,
+      base::Bind(&OnRefreshAheadComplete, base::Owned(addresses)),
+      addresses)));
+  job->set_is_refresh_ahead_only();
+}
+
 void HostResolverImpl::CacheResult(const Key& key,
                                    const HostCache::Entry& entry,
                                    base::TimeDelta ttl) {
@@ -109,6 +109,11 @@ class NET_EXPORT HostResolverImpl
   // If Options.enable_caching is true, a cache is created using
   // HostCache::CreateDefaultCache(). Otherwise no cache is used.
   //
+  // If Options.enable_refresh_ahead is also true, cache hits on popular
+  // entries that are about to expire start a background Job at IDLE priority
+  // to resolve them again, so that they are refreshed before any request
+  // misses the cache.
+  //
   // Options.GetDispatcherLimits() determines the maximum number of jobs that
   // the resolver will run at once. This upper-bounds the total number of
   // outstanding DNS transactions (not counting retransmissions and retries).
@@ -256,6 +261,11 @@ class NET_EXPORT HostResolverImpl
   // Asynchronously checks if only loopback IPs are available.
   virtual void RunLoopbackProbeJob();
 
+  // Starts a Job refreshing the cache entry for |key| if refresh-ahead is
+  // enabled and the entry is due for it. |source_net_log| is the log of the
+  // request whose cache hit prompted the refresh.
+  void MaybeRefreshAhead(const Key& key, const BoundNetLog& source_net_log);
+
   // Records the result in cache if cache is present.
   void CacheResult(const Key& key,
                    const HostCache::Entry& entry,
@@ -307,6 +317,9 @@ class NET_EXPORT HostResolverImpl
   // Cache of host resolution results.
   std::unique_ptr<HostCache> cache_;
 
+  // Whether popular entries of |cache_| are refreshed before they expire.
+  bool refresh_ahead_enabled_;
+
   // Map from HostCache::Key to a Job.
   JobMap jobs_;
 
@@ -24,6 +24,7 @@
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/test/test_timeouts.h"
+#include "base/threading/platform_thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
 #include "net/base/address_list.h"
@@ -1425,6 +1426,150 @@ TEST_F(HostResolverImplTest, ResolveStaleFromCache) {
   EXPECT_TRUE(requests_[5]->staleness().is_stale());
 }
 
+// Popular cache entries should be refreshed by a background Job shortly before
+// they expire, while still being served from the cache.
+TEST_F(HostResolverImplTest, RefreshAhead) {
+  HostResolverImpl::Options options = DefaultOptions();
+  options.enable_refresh_ahead = true;
+  resolver_.reset(new TestHostResolverImpl(options, NULL));
+  resolver_->set_proc_params_for_test(DefaultParams(proc_.get()));
+
+  proc_->AddRuleForAllFamilies("just.testing", "192.168.1.42");
+  proc_->SignalMultiple(1u);
+
+  Request* req = CreateRequest("just.testing", 80);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  EXPECT_EQ(OK, req->WaitForResult());
+
+  // Make the entry expire in 5 of its 60 seconds.
+  HostCache* cache = resolver_->GetHostCache();
+  HostCache::EntryMap entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  cache->Set(entries.begin()->first, entries.begin()->second,
+             base::TimeTicks::Now() - base::TimeDelta::FromSeconds(55),
+             base::TimeDelta::FromSeconds(60));
+  base::TimeTicks old_expiration =
+      cache->GetEntries().begin()->second.expires();
+
+  // The second hit makes the entry popular enough to be refreshed.
+  EXPECT_EQ(OK, CreateRequest("just.testing", 80)->Resolve());
+  EXPECT_EQ(1u, proc_->GetCaptureList().size());
+  EXPECT_EQ(OK, CreateRequest("just.testing", 80)->Resolve());
+  EXPECT_TRUE(proc_->WaitFor(1u));
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  // Meanwhile, the entry is still served from the cache and not refreshed
+  // again.
+  EXPECT_EQ(OK, CreateRequest("just.testing", 80)->Resolve());
+  EXPECT_TRUE(requests_.back()->HasOneAddress("192.168.1.42", 80));
+
+  // A request bypassing the cache shares the refresh Job.
+  HostResolver::RequestInfo info(HostPortPair("just.testing", 80));
+  info.set_allow_cached_response(false);
+  req = CreateRequest(info, DEFAULT_PRIORITY);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  proc_->SignalMultiple(1u);
+  EXPECT_EQ(OK, req->WaitForResult());
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_LT(old_expiration, entries.begin()->second.expires());
+  EXPECT_EQ(1u, cache->GetCounters().refreshes);
+}
+
+// A refresh Job with no other request should complete on its own.
+TEST_F(HostResolverImplTest, RefreshAheadWithoutRequests) {
+  HostResolverImpl::Options options = DefaultOptions();
+  options.enable_refresh_ahead = true;
+  resolver_.reset(new TestHostResolverImpl(options, NULL));
+  resolver_->set_proc_params_for_test(DefaultParams(proc_.get()));
+
+  proc_->SignalMultiple(2u);  // Initial resolution and refresh.
+
+  Request* req = CreateRequest("host1", 80);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  EXPECT_EQ(OK, req->WaitForResult());
+
+  HostCache* cache = resolver_->GetHostCache();
+  HostCache::EntryMap entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  cache->Set(entries.begin()->first, entries.begin()->second,
+             base::TimeTicks::Now() - base::TimeDelta::FromSeconds(55),
+             base::TimeDelta::FromSeconds(60));
+
+  EXPECT_EQ(OK, CreateRequest("host1", 80)->Resolve());
+  EXPECT_EQ(OK, CreateRequest("host1", 80)->Resolve());
+
+  EXPECT_EQ(1u, num_running_dispatcher_jobs());
+
+  // Wait for the refresh Job to complete.
+  base::TimeTicks deadline =
+      base::TimeTicks::Now() + TestTimeouts::action_timeout();
+  while (num_running_dispatcher_jobs() > 0 &&
+         base::TimeTicks::Now() < deadline) {
+    base::RunLoop().RunUntilIdle();
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  }
+  EXPECT_EQ(0u, num_running_dispatcher_jobs());
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_LT(base::TimeTicks::Now() + base::TimeDelta::FromSeconds(30),
+            entries.begin()->second.expires());
+}
+
+// A failed refresh should keep the entry it was refreshing until it expires.
+TEST_F(HostResolverImplTest, FailedRefreshAheadKeepsEntry) {
+  HostResolverImpl::Options options = DefaultOptions();
+  options.enable_refresh_ahead = true;
+  resolver_.reset(new TestHostResolverImpl(options, NULL));
+  resolver_->set_proc_params_for_test(DefaultParams(proc_.get()));
+
+  proc_->SignalMultiple(2u);  // Initial resolution and refresh.
+
+  Request* req = CreateRequest("host1", 80);
+  EXPECT_EQ(ERR_IO_PENDING, req->Resolve());
+  EXPECT_EQ(OK, req->WaitForResult());
+
+  // From now on, only "other" resolves, so the refresh fails.
+  proc_->AddRuleForAllFamilies("other", "192.168.1.42");
+
+  HostCache* cache = resolver_->GetHostCache();
+  HostCache::EntryMap entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  cache->Set(entries.begin()->first, entries.begin()->second,
+             base::TimeTicks::Now() - base::TimeDelta::FromSeconds(55),
+             base::TimeDelta::FromSeconds(60));
+  base::TimeTicks old_expiration =
+      cache->GetEntries().begin()->second.expires();
+
+  EXPECT_EQ(OK, CreateRequest("host1", 80)->Resolve());
+  EXPECT_EQ(OK, CreateRequest("host1", 80)->Resolve());
+
+  EXPECT_EQ(1u, num_running_dispatcher_jobs());
+
+  // Wait for the refresh Job to complete.
+  base::TimeTicks deadline =
+      base::TimeTicks::Now() + TestTimeouts::action_timeout();
+  while (num_running_dispatcher_jobs() > 0 &&
+         base::TimeTicks::Now() < deadline) {
+    base::RunLoop().RunUntilIdle();
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  }
+  EXPECT_EQ(0u, num_running_dispatcher_jobs());
+  EXPECT_EQ(2u, proc_->GetCaptureList().size());
+
+  // The entry is still the one of the initial resolution.
+  entries = cache->GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(OK, entries.begin()->second.error());
+  EXPECT_EQ(old_expiration, entries.begin()->second.expires());
+  EXPECT_EQ(OK, CreateRequest("host1", 80)->Resolve());
+  EXPECT_TRUE(requests_.back()->HasOneAddress("127.0.0.1", 80));
+}
+
 // Test the retry attempts simulating host resolver proc that takes too long.
 TEST_F(HostResolverImplTest, MultipleAttempts) {
   // Total number of attempts would be 3 and we want the 3rd attempt to resolve
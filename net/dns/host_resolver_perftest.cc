@@ -0,0 +1,247 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/format_macros.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/dns/dns_config_service.h"
+#include "net/dns/dns_protocol.h"
+#include "net/dns/dns_test_util.h"
+#include "net/dns/host_cache.h"
+#include "net/dns/host_resolver_impl.h"
+#include "net/dns/mock_host_resolver.h"
+#include "net/log/net_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+// Fits in the default HostCache of every configuration.
+const size_t kNumHostnames = 50;
+
+// Number of lookups of each hostname per thread in the HostCache benchmark.
+const int kLookupsPerHostname = 20000;
+
+// Number of cache hits on each hostname per simulated time step.
+const int kHitsPerStep = 3;
+
+// Simulated time between two rounds of cache hits, and number of rounds.
+const int kStepSeconds = 4;
+const int kNumSteps = 60;
+
+// Lifetime of the entries in the HostResolverImpl benchmarks.
+const int kLifetimeSeconds = 60;
+
+std::string Hostname(size_t i) {
+  return base::StringPrintf("host%" PRIuS ".example", i);
+}
+
+// Looks up every hostname of |keys| |kLookupsPerHostname| times from its own
+// thread.
+class LookupDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  LookupDelegate(HostCache* cache, const std::vector<HostCache::Key>& keys)
+      : cache_(cache), keys_(keys) {}
+
+  // base::DelegateSimpleThread::Delegate:
+  void Run() override {
+    base::TimeTicks now = base::TimeTicks::Now();
+    HostCache::Entry entry(ERR_UNEXPECTED, AddressList());
+    for (int i = 0; i < kLookupsPerHostname; ++i) {
+      for (const HostCache::Key& key : keys_)
+        EXPECT_TRUE(cache_->LookupCopy(key, now, &entry));
+    }
+  }
+
+ private:
+  HostCache* cache_;
+  const std::vector<HostCache::Key> keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupDelegate);
+};
+
+void RunCacheLookups(size_t num_threads) {
+  HostCache cache(kNumHostnames);
+  std::vector<HostCache::Key> keys;
+  AddressList addresses =
+      AddressList::CreateFromIPAddress(IPAddress(192, 168, 1, 1), 80);
+  for (size_t i = 0; i < kNumHostnames; ++i) {
+    keys.push_back(HostCache::Key(Hostname(i), ADDRESS_FAMILY_IPV4, 0));
+    cache.Set(keys.back(), HostCache::Entry(OK, addresses),
+              base::TimeTicks::Now(), base::TimeDelta::FromHours(1));
+  }
+
+  std::vector<std::unique_ptr<LookupDelegate>> delegates;
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    delegates.push_back(base::WrapUnique(new LookupDelegate(&cache, keys)));
+    threads.push_back(base::WrapUnique(new base::DelegateSimpleThread(
+        delegates.back().get(), base::StringPrintf("Lookup%" PRIuS, i))));
+  }
+
+  base::ElapsedTimer timer;
+  for (const auto& thread : threads)
+    thread->Start();
+  for (const auto& thread : threads)
+    thread->Join();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  double num_lookups =
+      static_cast<double>(num_threads) * kNumHostnames * kLookupsPerHostname;
+  perf_test::PrintResult("host_cache_lookups", "",
+                         base::StringPrintf("%" PRIuS "_threads", num_threads),
+                         num_lookups / elapsed.InSecondsF(), "lookups/s",
+                         true);
+}
+
+class HostResolverPerfTest : public testing::Test {
+ protected:
+  // Returns a HostResolverImpl resolving every IPv4 name with MockDnsClient.
+  std::unique_ptr<HostResolverImpl> CreateResolver(bool refresh_ahead) {
+    HostResolver::Options options;
+    options.enable_refresh_ahead = refresh_ahead;
+    std::unique_ptr<HostResolverImpl> resolver(
+        new HostResolverImpl(options, nullptr));
+
+    DnsConfig config;
+    config.nameservers.push_back(
+        IPEndPoint(IPAddress(192, 168, 1, 0), dns_protocol::kDefaultPort));
+    MockDnsClientRuleList rules;
+    rules.push_back(MockDnsClientRule(std::string(), dns_protocol::kTypeA,
+                                      MockDnsClientRule::OK, false));
+    resolver->SetDnsClient(
+        base::WrapUnique(new MockDnsClient(config, rules)));
+    return resolver;
+  }
+
+  // Resolves |hostname| with |resolver|, waiting for the result if it is not
+  // in the cache. Returns true if it was not.
+  bool Resolve(HostResolver* resolver, const std::string& hostname) {
+    HostResolver::RequestInfo info(HostPortPair(hostname, 80));
+    info.set_address_family(ADDRESS_FAMILY_IPV4);
+    AddressList addresses;
+    TestCompletionCallback callback;
+    HostResolver::RequestHandle request;
+    int rv = resolver->Resolve(info, DEFAULT_PRIORITY, &addresses,
+                               callback.callback(), &request, BoundNetLog());
+    bool missed = rv == ERR_IO_PENDING;
+    if (missed)
+      rv = callback.WaitForResult();
+    EXPECT_EQ(OK, rv);
+    return missed;
+  }
+
+  // Simulates the passing of |elapsed| time for all the entries of |cache|,
+  // assuming they all live for |kLifetimeSeconds|.
+  void AgeEntries(HostCache* cache, base::TimeDelta elapsed) {
+    const base::TimeDelta lifetime =
+        base::TimeDelta::FromSeconds(kLifetimeSeconds);
+    base::TimeTicks now = base::TimeTicks::Now();
+    for (const auto& pair : cache->GetEntries()) {
+      base::TimeDelta left = pair.second.expires() - now - elapsed;
+      cache->Set(pair.first, pair.second, now + left - lifetime, lifetime);
+    }
+  }
+
+  // Counts the requests that had to wait for a resolution while hot hostnames
+  // were hit every |kStepSeconds| of simulated time.
+  void RunHotHostnames(bool refresh_ahead) {
+    std::unique_ptr<HostResolverImpl> resolver = CreateResolver(refresh_ahead);
+    HostCache* cache = resolver->GetHostCache();
+    for (size_t i = 0; i < kNumHostnames; ++i)
+      Resolve(resolver.get(), Hostname(i));
+    // Gives all the entries the same lifetime.
+    AgeEntries(cache, base::TimeDelta());
+
+    size_t num_misses = 0;
+    base::ElapsedTimer timer;
+    for (int step = 0; step < kNumSteps; ++step) {
+      AgeEntries(cache, base::TimeDelta::FromSeconds(kStepSeconds));
+      for (int hit = 0; hit < kHitsPerStep; ++hit) {
+        for (size_t i = 0; i < kNumHostnames; ++i) {
+          if (Resolve(resolver.get(), Hostname(i)))
+            ++num_misses;
+        }
+      }
+      // Lets the refreshes complete.
+      base::RunLoop().RunUntilIdle();
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    const char* trace = refresh_ahead ? "refresh_ahead" : "default";
+    size_t num_requests = kNumSteps * kHitsPerStep * kNumHostnames;
+    perf_test::PrintResult("hot_hostname_blocking_misses", "", trace,
+                           num_misses, "requests", true);
+    perf_test::PrintResult("hot_hostname_requests", "", trace,
+                           num_requests / elapsed.InSecondsF(), "requests/s",
+                           false);
+    HostCache::Counters counters = cache->GetCounters();
+    perf_test::PrintResult("hot_hostname_refreshes", "", trace,
+                           counters.refreshes, "refreshes", false);
+  }
+
+  base::MessageLoopForIO message_loop_;
+};
+
+}  // namespace
+
+// Measures the throughput of HostCache lookups as threads are added.
+TEST(HostCachePerfTest, Lookup) {
+  RunCacheLookups(1);
+  RunCacheLookups(4);
+}
+
+// Measures how many requests for frequently used hostnames miss the cache as
+// their entries expire, with and without refresh-ahead.
+TEST_F(HostResolverPerfTest, HotHostnames) {
+  RunHotHostnames(false);
+  RunHotHostnames(true);
+}
+
+// Compares cache hits through HostResolverImpl and MockCachingHostResolver.
+TEST_F(HostResolverPerfTest, CachedResolve) {
+  const int kNumRounds = 1000;
+
+  std::unique_ptr<HostResolverImpl> resolver = CreateResolver(false);
+  MockCachingHostResolver mock_resolver;
+  HostResolver* resolvers[] = {resolver.get(), &mock_resolver};
+  const char* traces[] = {"host_resolver_impl", "mock_caching_host_resolver"};
+
+  for (size_t r = 0; r < arraysize(resolvers); ++r) {
+    for (size_t i = 0; i < kNumHostnames; ++i)
+      Resolve(resolvers[r], Hostname(i));
+
+    base::ElapsedTimer timer;
+    for (int round = 0; round < kNumRounds; ++round) {
+      for (size_t i = 0; i < kNumHostnames; ++i)
+        EXPECT_FALSE(Resolve(resolvers[r], Hostname(i)));
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+    perf_test::PrintResult("cached_resolves", "", traces[r],
+                           kNumRounds * kNumHostnames / elapsed.InSecondsF(),
+                           "resolves/s", true);
+  }
+}
+
+}  // namespace net
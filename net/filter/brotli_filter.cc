@@ -4,17 +4,30 @@
 
 #include "net/filter/brotli_filter.h"
 
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
 #include "base/bit_cast.h"
 #include "base/macros.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/numerics/safe_math.h"
+#include "base/values.h"
+#include "net/base/sdch_manager.h"
+#include "net/base/sdch_net_log_params.h"
+#include "net/url_request/url_request_context.h"
 #include "third_party/brotli/dec/decode.h"
+#include "url/gurl.h"
 
 namespace net {
 
 namespace {
 const uint8_t kGzipHeader[] = {0x1f, 0x8b, 0x08};
+
+// Size of the server hash of the dictionary, followed by a null byte, at the
+// start of a shared Brotli stream, like in a SDCH stream.
+const size_t kServerIdLength = 9;
 }
 
 // BrotliFilter applies Brotli content decoding to a data stream.
@@ -155,6 +168,16 @@ class BrotliFilter : public Filter {
     }
   }
 
+ protected:
+  // Makes the decoder use |dictionary| as custom dictionary, which must
+  // outlive the filter. Must be called before any data is decoded.
+  void SetCustomDictionary(const std::string& dictionary) {
+    DCHECK_EQ(0u, consumed_bytes_);
+    BrotliSetCustomDictionary(dictionary.size(),
+                              bit_cast<const uint8_t*>(dictionary.data()),
+                              brotli_state_);
+  }
+
  private:
   static void* AllocateMemory(void* opaque, size_t size) {
     BrotliFilter* filter = reinterpret_cast<BrotliFilter*>(opaque);
@@ -211,8 +234,126 @@ class BrotliFilter : public Filter {
   DISALLOW_COPY_AND_ASSIGN(BrotliFilter);
 };
 
+// SharedBrotliFilter applies Brotli content decoding with a shared dictionary
+// to a data stream. The dictionaries are fetched, stored and advertised like
+// SDCH ones by the SdchManager; as in a SDCH stream, the data starts with the
+// server hash of the dictionary it was encoded with and a null byte, and is
+// followed by a Brotli stream encoded with the dictionary text as custom
+// dictionary.
+class SharedBrotliFilter : public BrotliFilter {
+ public:
+  SharedBrotliFilter(FilterType type, const FilterContext& filter_context)
+      : BrotliFilter(type),
+        filter_context_(filter_context),
+        url_request_context_(filter_context.GetURLRequestContext()),
+        dictionary_text_(nullptr) {
+    bool success = filter_context.GetURL(&url_);
+    DCHECK(success);
+    DCHECK(url_request_context_->sdch_manager());
+  }
+
+  ~SharedBrotliFilter() override {}
+
+  FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len) override {
+    if (!dest_buffer || !dest_len)
+      return Filter::FILTER_ERROR;
+
+    if (!dictionary_text_) {
+      *dest_len = 0;
+      FilterStatus status = InitializeDictionary();
+      if (status != Filter::FILTER_OK)
+        return status;
+      if (!stream_data_len_)
+        return Filter::FILTER_NEED_MORE_DATA;
+    }
+    return BrotliFilter::ReadFilteredData(dest_buffer, dest_len);
+  }
+
+ private:
+  // Reads the server hash at the start of the stream and sets the dictionary
+  // it identifies as custom dictionary of the decoder.
+  FilterStatus InitializeDictionary() {
+    size_t bytes_needed = kServerIdLength - dictionary_hash_.size();
+    DCHECK_GT(bytes_needed, 0u);
+    if (!next_stream_data_)
+      return Filter::FILTER_NEED_MORE_DATA;
+    if (static_cast<size_t>(stream_data_len_) < bytes_needed) {
+      dictionary_hash_.append(next_stream_data_, stream_data_len_);
+      next_stream_data_ = nullptr;
+      stream_data_len_ = 0;
+      return Filter::FILTER_NEED_MORE_DATA;
+    }
+    dictionary_hash_.append(next_stream_data_, bytes_needed);
+    stream_data_len_ -= bytes_needed;
+    next_stream_data_ = stream_data_len_ ? next_stream_data_ + bytes_needed
+                                         : nullptr;
+
+    SdchProblemCode rv = SDCH_DICTIONARY_HASH_MALFORMED;
+    if (dictionary_hash_[kServerIdLength - 1] == '\0') {
+      std::string server_hash(dictionary_hash_, 0, kServerIdLength - 1);
+      SdchManager::DictionarySet* handle =
+          filter_context_.SdchDictionariesAdvertised();
+      if (handle)
+        dictionary_text_ = handle->GetDictionaryText(server_hash);
+      if (!dictionary_text_) {
+        // As for SDCH, resources encoded with dictionaries which were not
+        // advertised may live in the cache, so look up all the dictionaries
+        // usable for the URL.
+        unexpected_dictionary_handle_ =
+            url_request_context_->sdch_manager()->GetDictionarySetByHash(
+                url_, server_hash, &rv);
+        if (unexpected_dictionary_handle_) {
+          dictionary_text_ =
+              unexpected_dictionary_handle_->GetDictionaryText(server_hash);
+          rv = filter_context_.IsCachedContent()
+                   ? SDCH_UNADVERTISED_DICTIONARY_USED_CACHED
+                   : SDCH_UNADVERTISED_DICTIONARY_USED;
+        } else {
+          rv = SDCH_DICTIONARY_HASH_NOT_FOUND;
+        }
+      } else {
+        rv = SDCH_OK;
+      }
+    }
+
+    if (rv != SDCH_OK) {
+      SdchManager::SdchErrorRecovery(rv);
+      filter_context_.GetNetLog().AddEvent(
+          NetLog::TYPE_SDCH_DECODING_ERROR,
+          base::Bind(&NetLogSdchResourceProblemCallback, rv));
+    }
+    if (!dictionary_text_)
+      return Filter::FILTER_ERROR;
+
+    // The dictionary text is kept alive by the DictionarySet owned by the
+    // FilterContext, or by |unexpected_dictionary_handle_|.
+    SetCustomDictionary(*dictionary_text_);
+    return Filter::FILTER_OK;
+  }
+
+  const FilterContext& filter_context_;
+  const URLRequestContext* url_request_context_;
+  GURL url_;
+
+  // The server hash of the dictionary read so far from the stream.
+  std::string dictionary_hash_;
+
+  // The dictionary the stream is encoded with, once its hash has been read.
+  const std::string* dictionary_text_;
+
+  // Handle to the dictionary, when it was not advertised for the request.
+  std::unique_ptr<SdchManager::DictionarySet> unexpected_dictionary_handle_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedBrotliFilter);
+};
+
 Filter* CreateBrotliFilter(Filter::FilterType type_id) {
   return new BrotliFilter(type_id);
 }
 
+Filter* CreateSharedBrotliFilter(Filter::FilterType type_id,
+                                 const FilterContext& filter_context) {
+  return new SharedBrotliFilter(type_id, filter_context);
+}
+
 }  // namespace net
@@ -12,6 +12,14 @@ namespace net {
 // Creates instance of filter or returns nullptr if brotli is not supported.
 Filter* CreateBrotliFilter(Filter::FilterType type_id);
 
+// Creates instance of filter decoding Brotli streams encoded with a shared
+// dictionary, or returns nullptr if brotli is not supported. The dictionaries
+// are negotiated and stored like SDCH ones, and looked up in the dictionaries
+// advertised in |filter_context| or in the SdchManager of its
+// URLRequestContext, which must outlive the filter.
+Filter* CreateSharedBrotliFilter(Filter::FilterType type_id,
+                                 const FilterContext& filter_context);
+
 }  // namespace net
 
 #endif  // NET_FILTER_BROTLI_FILTER_H__
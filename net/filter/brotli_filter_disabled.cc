@@ -10,4 +10,9 @@ Filter* CreateBrotliFilter(Filter::FilterType type_id) {
   return nullptr;
 }
 
+Filter* CreateSharedBrotliFilter(Filter::FilterType type_id,
+                                 const FilterContext& filter_context) {
+  return nullptr;
+}
+
 }  // namespace net
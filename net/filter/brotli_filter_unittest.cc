@@ -9,13 +9,26 @@
 #include "base/files/file_util.h"
 #include "base/path_service.h"
 #include "net/base/io_buffer.h"
+#include "net/base/sdch_manager.h"
 #include "net/filter/mock_filter_context.h"
+#include "net/url_request/url_request_context.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
 namespace {
 const int kDefaultBufferSize = 4096;
 const int kSmallBufferSize = 128;
+const char kSharedBrotliUrl[] = "https://sdchtest.com/";
+// shared_brotli.br is encoded with the payload of this dictionary as custom
+// dictionary.
+const char kSharedBrotliDictionary[] =
+    "Domain: sdchtest.com\n\n"
+    "The quick brown fox jumps over the lazy dog. Shared Brotli dictionaries "
+    "hold the strings which the responses of a site have in common.\n";
+const char kOtherSharedBrotliDictionary[] =
+    "Domain: sdchtest.com\n\n"
+    "The QUICK brown fox jumps over the lazy dog. SHARED Brotli dictionaries "
+    "hold the strings which the responses of a site have in common.\n";
 }  // namespace
 
 namespace net {
@@ -44,6 +57,14 @@ class BrotliUnitTest : public PlatformTest {
     encoded_file_path = data_dir.AppendASCII("google.br");
     ASSERT_TRUE(base::ReadFileToString(encoded_file_path, &encoded_buffer_));
     ASSERT_GE(kDefaultBufferSize, static_cast<int>(encoded_buffer_.size()));
+
+    // Read the data encoded with the shared dictionary, and its original.
+    ASSERT_TRUE(base::ReadFileToString(
+        data_dir.AppendASCII("shared_brotli.txt"), &shared_source_buffer_));
+    ASSERT_TRUE(base::ReadFileToString(
+        data_dir.AppendASCII("shared_brotli.br"), &shared_encoded_buffer_));
+    ASSERT_GE(kDefaultBufferSize,
+              static_cast<int>(shared_encoded_buffer_.size()));
   }
 
   // Use filter to decode compressed data, and compare the decoded result with
@@ -131,18 +152,82 @@ class BrotliUnitTest : public PlatformTest {
     ASSERT_TRUE(filter_.get());
   }
 
+  // Returns true if the shared Brotli data |shared_encoded| decodes to the
+  // original of shared_brotli.br with |filter| in a single read.
+  bool DecodesToSharedSource(Filter* filter,
+                             const std::string& shared_encoded) {
+    char decode_buffer[kDefaultBufferSize];
+    int decode_size = kDefaultBufferSize;
+    int code = DecodeAllWithFilter(filter, shared_encoded.data(),
+                                   static_cast<int>(shared_encoded.size()),
+                                   decode_buffer, &decode_size);
+    return code != Filter::FILTER_ERROR &&
+           decode_size == shared_source_len() &&
+           memcmp(shared_source_buffer(), decode_buffer, decode_size) == 0;
+  }
+
+  // Initializes a shared Brotli filter with a buffer of |buffer_size| bytes,
+  // for a request which advertised the test dictionaries if
+  // |advertise_dictionary|. Returns shared_brotli.br, preceded by the server
+  // hash of |dictionary| as the one it is encoded with, in |shared_encoded|.
+  void InitSharedBrotliFilterWithBufferSize(int buffer_size,
+                                            bool advertise_dictionary,
+                                            const char* dictionary,
+                                            std::string* shared_encoded) {
+    sdch_manager_.reset(new SdchManager);
+    filter_context_.GetModifiableURLRequestContext()->set_sdch_manager(
+        sdch_manager_.get());
+    std::string server_hash;
+    std::string other_server_hash;
+    GURL url(kSharedBrotliUrl);
+    ASSERT_EQ(SDCH_OK,
+              sdch_manager_->AddSdchDictionary(dictionary, url, &server_hash));
+    const char* other_dictionary = dictionary == kSharedBrotliDictionary
+                                       ? kOtherSharedBrotliDictionary
+                                       : kSharedBrotliDictionary;
+    ASSERT_EQ(SDCH_OK, sdch_manager_->AddSdchDictionary(other_dictionary, url,
+                                                        &other_server_hash));
+    filter_context_.SetURL(url);
+    if (advertise_dictionary)
+      filter_context_.SetSdchResponse(sdch_manager_->GetDictionarySet(url));
+
+    *shared_encoded = server_hash;
+    shared_encoded->append(1, '\0');
+    shared_encoded->append(shared_encoded_buffer_);
+
+    std::vector<Filter::FilterType> filter_types;
+    filter_types.push_back(Filter::FILTER_TYPE_SHARED_BROTLI);
+    filter_ =
+        Filter::FactoryForTests(filter_types, filter_context_, buffer_size);
+    ASSERT_TRUE(filter_.get());
+  }
+
   const char* source_buffer() const { return source_buffer_.data(); }
   int source_len() const { return static_cast<int>(source_buffer_.size()); }
 
   const char* encoded_buffer() const { return encoded_buffer_.data(); }
   int encoded_len() const { return static_cast<int>(encoded_buffer_.size()); }
 
+  const char* shared_source_buffer() const {
+    return shared_source_buffer_.data();
+  }
+  int shared_source_len() const {
+    return static_cast<int>(shared_source_buffer_.size());
+  }
+
+  const std::string& shared_encoded_buffer() const {
+    return shared_encoded_buffer_;
+  }
+
   std::unique_ptr<Filter> filter_;
 
  private:
+  std::unique_ptr<SdchManager> sdch_manager_;
   MockFilterContext filter_context_;
   std::string source_buffer_;
   std::string encoded_buffer_;
+  std::string shared_source_buffer_;
+  std::string shared_encoded_buffer_;
 };
 
 // Basic scenario: decoding brotli data with big enough buffer.
@@ -268,4 +353,76 @@ TEST_F(BrotliUnitTest, DecodeEmptyData) {
   EXPECT_EQ(0, decode_size);
 }
 
+// Decodes a shared Brotli stream, whose data refers to the dictionary.
+TEST_F(BrotliUnitTest, DecodeSharedBrotli) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(
+      kDefaultBufferSize, true, kSharedBrotliDictionary, &shared_encoded);
+  DecodeAndCompareWithFilter(filter_.get(), shared_source_buffer(),
+                             shared_source_len(), shared_encoded.data(),
+                             static_cast<int>(shared_encoded.size()),
+                             kDefaultBufferSize);
+}
+
+// Tests the server hash of the dictionary can be split across reads.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliWithOneByteBuffer) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(1, true, kSharedBrotliDictionary,
+                                       &shared_encoded);
+  DecodeAndCompareWithFilter(filter_.get(), shared_source_buffer(),
+                             shared_source_len(), shared_encoded.data(),
+                             static_cast<int>(shared_encoded.size()),
+                             kSmallBufferSize);
+}
+
+// Resources cached with a dictionary which isn't advertised anymore are still
+// decoded with it.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliWithUnadvertisedDictionary) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(
+      kDefaultBufferSize, false, kSharedBrotliDictionary, &shared_encoded);
+  DecodeAndCompareWithFilter(filter_.get(), shared_source_buffer(),
+                             shared_source_len(), shared_encoded.data(),
+                             static_cast<int>(shared_encoded.size()),
+                             kDefaultBufferSize);
+}
+
+// The data doesn't decode to its original without the dictionary.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliDataWithoutDictionary) {
+  InitFilter();
+  EXPECT_FALSE(DecodesToSharedSource(filter_.get(), shared_encoded_buffer()));
+}
+
+// The data doesn't decode to its original with another dictionary.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliWithWrongDictionary) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(
+      kDefaultBufferSize, true, kOtherSharedBrotliDictionary, &shared_encoded);
+  EXPECT_FALSE(DecodesToSharedSource(filter_.get(), shared_encoded));
+}
+
+// The data decodes to its original in a single read with the dictionary, so
+// the failures above come from the missing or wrong dictionary.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliInSingleRead) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(
+      kDefaultBufferSize, true, kSharedBrotliDictionary, &shared_encoded);
+  EXPECT_TRUE(DecodesToSharedSource(filter_.get(), shared_encoded));
+}
+
+// Decoding shared Brotli data with an unknown dictionary fails.
+TEST_F(BrotliUnitTest, DecodeSharedBrotliWithUnknownDictionary) {
+  std::string shared_encoded;
+  InitSharedBrotliFilterWithBufferSize(
+      kDefaultBufferSize, true, kSharedBrotliDictionary, &shared_encoded);
+  shared_encoded[0] = shared_encoded[0] == 'A' ? 'B' : 'A';
+
+  char decode_buffer[kDefaultBufferSize];
+  int decode_size = kDefaultBufferSize;
+  int code = DecodeAllWithFilter(
+      filter_.get(), shared_encoded.data(),
+      static_cast<int>(shared_encoded.size()), decode_buffer, &decode_size);
+  EXPECT_EQ(Filter::FILTER_ERROR, code);
+}
+
 }  // namespace net
@@ -44,6 +44,7 @@ const char kDeflate[]      = "deflate";
 const char kGZip[]         = "gzip";
 const char kXGZip[]        = "x-gzip";
 const char kSdch[]         = "sdch";
+const char kSharedBrotli[] = "sbr";
 // compress and x-compress are currently not supported. If we decide to support
 // them, we'll need the same mime type compatibility hack we have for gzip. For
 // more information, see Firefox's nsHttpChannel::ProcessNormal.
@@ -78,6 +79,8 @@ std::string FilterTypeAsString(Filter::FilterType type_id) {
       return "FILTER_TYPE_SDCH_POSSIBLE  ";
     case Filter::FILTER_TYPE_UNSUPPORTED:
       return "FILTER_TYPE_UNSUPPORTED";
+    case Filter::FILTER_TYPE_SHARED_BROTLI:
+      return "FILTER_TYPE_SHARED_BROTLI";
     case Filter::FILTER_TYPE_MAX:
       return "FILTER_TYPE_MAX";
   }
@@ -212,6 +215,8 @@ Filter::FilterType Filter::ConvertEncodingToType(
     type_id = FILTER_TYPE_GZIP;
   } else if (base::LowerCaseEqualsASCII(filter_type, kSdch)) {
     type_id = FILTER_TYPE_SDCH;
+  } else if (base::LowerCaseEqualsASCII(filter_type, kSharedBrotli)) {
+    type_id = FILTER_TYPE_SHARED_BROTLI;
   } else {
     // Note we also consider "identity" and "uncompressed" UNSUPPORTED as
     // filter should be disabled in such cases.
@@ -248,6 +253,14 @@ void Filter::FixupEncodingTypes(
   // very strange things to the request, or the response, so we have to handle
   // them gracefully.
 
+  // Shared Brotli content is decoded with an advertised dictionary too, but
+  // its encoding is opaque to proxies since it is only advertised over secure
+  // connections, so it doesn't need any of the SDCH fixups.
+  if (!encoding_types->empty() &&
+      (FILTER_TYPE_SHARED_BROTLI == encoding_types->front())) {
+    return;
+  }
+
   // If content encoding included SDCH, then everything is "relatively" fine.
   if (!encoding_types->empty() &&
       (FILTER_TYPE_SDCH == encoding_types->front())) {
@@ -389,6 +402,20 @@ std::unique_ptr<Filter> Filter::InitGZipFilter(FilterType type_id,
   return gz_filter->InitDecoding(type_id) ? std::move(gz_filter) : nullptr;
 }
 
+// static
+std::unique_ptr<Filter> Filter::InitSharedBrotliFilter(
+    FilterType type_id,
+    const FilterContext& filter_context,
+    int buffer_size) {
+  std::unique_ptr<Filter> brotli_filter(
+      CreateSharedBrotliFilter(type_id, filter_context));
+  if (!brotli_filter.get())
+    return nullptr;
+
+  brotli_filter->InitBuffer(buffer_size);
+  return brotli_filter;
+}
+
 // static
 std::unique_ptr<Filter> Filter::InitSdchFilter(
     FilterType type_id,
@@ -422,6 +449,12 @@ std::unique_ptr<Filter> Filter::PrependNewFilter(
         first_filter = InitSdchFilter(type_id, filter_context, buffer_size);
       }
       break;
+    case FILTER_TYPE_SHARED_BROTLI:
+      if (filter_context.GetURLRequestContext()->sdch_manager()) {
+        first_filter =
+            InitSharedBrotliFilter(type_id, filter_context, buffer_size);
+      }
+      break;
     default:
       break;
   }
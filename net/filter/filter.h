@@ -161,6 +161,7 @@ class NET_EXPORT_PRIVATE Filter {
     FILTER_TYPE_SDCH,
     FILTER_TYPE_SDCH_POSSIBLE,  // Sdch possible, but pass through allowed.
     FILTER_TYPE_UNSUPPORTED,
+    FILTER_TYPE_SHARED_BROTLI,  // Brotli with a shared (SDCH) dictionary.
 
     FILTER_TYPE_MAX
   };
@@ -298,6 +299,10 @@ class NET_EXPORT_PRIVATE Filter {
                                                   int buffer_size);
   static std::unique_ptr<Filter> InitGZipFilter(FilterType type_id,
                                                 int buffer_size);
+  static std::unique_ptr<Filter> InitSharedBrotliFilter(
+      FilterType type_id,
+      const FilterContext& filter_context,
+      int buffer_size);
   static std::unique_ptr<Filter> InitSdchFilter(
       FilterType type_id,
       const FilterContext& filter_context,
@@ -46,6 +46,10 @@ TEST(FilterTest, ContentTypeId) {
             Filter::ConvertEncodingToType("sdch"));
   EXPECT_EQ(Filter::FILTER_TYPE_SDCH,
             Filter::ConvertEncodingToType("sDcH"));
+  EXPECT_EQ(Filter::FILTER_TYPE_SHARED_BROTLI,
+            Filter::ConvertEncodingToType("sbr"));
+  EXPECT_EQ(Filter::FILTER_TYPE_SHARED_BROTLI,
+            Filter::ConvertEncodingToType("SbR"));
   EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
             Filter::ConvertEncodingToType("weird"));
   EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
@@ -91,6 +95,21 @@ TEST(FilterTest, SdchEncoding) {
   EXPECT_EQ(Filter::FILTER_TYPE_GZIP_HELPING_SDCH, encoding_types[1]);
 }
 
+TEST(FilterTest, SharedBrotliEncoding) {
+  // Shared Brotli content is decoded with an advertised dictionary too, but
+  // doesn't get the SDCH fixups.
+  MockFilterContext filter_context;
+  filter_context.SetSdchResponse(
+      SdchManager::CreateEmptyDictionarySetForTesting());
+  filter_context.SetMimeType("text/html");
+
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(Filter::FILTER_TYPE_SHARED_BROTLI);
+  Filter::FixupEncodingTypes(filter_context, &encoding_types);
+  ASSERT_EQ(1U, encoding_types.size());
+  EXPECT_EQ(Filter::FILTER_TYPE_SHARED_BROTLI, encoding_types[0]);
+}
+
 TEST(FilterTest, MissingSdchEncoding) {
   // Handle interesting case where entire SDCH encoding assertion "got lost."
   const std::string kTextHtmlMime("text/html");
@@ -718,7 +718,7 @@ void HttpCache::DeletePendingOp(PendingOp* pending_op) {
 }
 
 int HttpCache::OpenEntry(const std::string& key, ActiveEntry** entry,
-                         Transaction* trans) {
+                         Transaction* trans, int read_ahead_size) {
   ActiveEntry* active_entry = FindActiveEntry(key);
   if (active_entry) {
     *entry = active_entry;
@@ -738,8 +738,15 @@ int HttpCache::OpenEntry(const std::string& key, ActiveEntry** entry,
   pending_op->callback = base::Bind(&HttpCache::OnPendingOpComplete,
                                     GetWeakPtr(), pending_op);
 
-  int rv = disk_cache_->OpenEntry(key, &(pending_op->disk_entry),
-                                  pending_op->callback);
+  int rv;
+  if (read_ahead_size) {
+    rv = disk_cache_->OpenEntryWithReadAhead(key, &(pending_op->disk_entry),
+                                             read_ahead_size,
+                                             pending_op->callback);
+  } else {
+    rv = disk_cache_->OpenEntry(key, &(pending_op->disk_entry),
+                                pending_op->callback);
+  }
   if (rv != ERR_IO_PENDING) {
     item->ClearTransaction();
     pending_op->callback.Run(rv);
@@ -325,9 +325,10 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
 
   // Opens the disk cache entry associated with |key|, returning an ActiveEntry
   // in |*entry|. |trans| will be notified via its IO callback if this method
-  // returns ERR_IO_PENDING.
+  // returns ERR_IO_PENDING. If |read_ahead_size| is not zero, the beginning of
+  // the body of the entry is read along with it, for |trans| to read.
   int OpenEntry(const std::string& key, ActiveEntry** entry,
-                Transaction* trans);
+                Transaction* trans, int read_ahead_size);
 
   // Creates the disk cache entry associated with |key|, returning an
   // ActiveEntry in |*entry|. |trans| will be notified via its IO callback if
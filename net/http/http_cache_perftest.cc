@@ -0,0 +1,186 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/disk_cache.h"
+#include "net/disk_cache/simple/simple_backend_impl.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction_test_util.h"
+#include "net/log/net_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+// Number of cached resources, each read once per measurement.
+const int kNumEntries = 500;
+
+// Size of the body of the resources; most cached resources are small.
+const int kBodySize = 8 * 1024;
+
+// Size of the reads of the body, like those of a URLRequestJob.
+const int kReadSize = 32 * 1024;
+
+// How much of the body is read ahead when opening entries, like the
+// HttpCache::Transaction does for a hit.
+const int kReadAheadSize = 32 * 1024;
+
+// Fetches |request| through |cache| and reads its whole body. Returns a net
+// error code.
+int FetchResource(HttpCache* cache, const HttpRequestInfo& request) {
+  std::unique_ptr<HttpTransaction> trans;
+  int rv = cache->CreateTransaction(DEFAULT_PRIORITY, &trans);
+  if (rv != OK)
+    return rv;
+  TestCompletionCallback callback;
+  rv = callback.GetResult(
+      trans->Start(&request, callback.callback(), BoundNetLog()));
+  if (rv != OK)
+    return rv;
+  scoped_refptr<IOBuffer> buf(new IOBuffer(kReadSize));
+  do {
+    rv = callback.GetResult(
+        trans->Read(buf.get(), kReadSize, callback.callback()));
+  } while (rv > 0);
+  return rv;
+}
+
+// Opens the entry of |key| in |backend|, reading ahead |read_ahead_size|
+// bytes of its body if that is not zero, and reads its headers and body like
+// the HttpCache does for a hit. Returns a net error code.
+int ReadEntry(disk_cache::Backend* backend,
+              const std::string& key,
+              int read_ahead_size) {
+  disk_cache::Entry* entry = nullptr;
+  TestCompletionCallback callback;
+  int rv = read_ahead_size
+               ? backend->OpenEntryWithReadAhead(key, &entry, read_ahead_size,
+                                                 callback.callback())
+               : backend->OpenEntry(key, &entry, callback.callback());
+  rv = callback.GetResult(rv);
+  if (rv != OK)
+    return rv;
+  const int headers_size = entry->GetDataSize(0);
+  scoped_refptr<IOBuffer> buf(new IOBuffer(std::max(headers_size, kReadSize)));
+  rv = callback.GetResult(
+      entry->ReadData(0, 0, buf.get(), headers_size, callback.callback()));
+  for (int offset = 0; rv >= 0 && offset < entry->GetDataSize(1);
+       offset += rv) {
+    rv = callback.GetResult(
+        entry->ReadData(1, offset, buf.get(), kReadSize, callback.callback()));
+    if (rv == 0)
+      rv = ERR_FAILED;
+  }
+  entry->Close();
+  return rv < 0 ? rv : OK;
+}
+
+// Waits for the entries closed by the previous reads to be closed on disk, so
+// that the next reads open them from the disk.
+void WaitForEntriesToClose() {
+  base::RunLoop().RunUntilIdle();
+  disk_cache::SimpleBackendImpl::FlushWorkerPoolForTesting();
+  base::RunLoop().RunUntilIdle();
+}
+
+void PrintLatencies(const std::string& trace,
+                    std::vector<base::TimeDelta>* latencies) {
+  std::sort(latencies->begin(), latencies->end());
+  perf_test::PrintResult(
+      "cache_hit_latency_p50", "", trace,
+      (*latencies)[latencies->size() / 2].InMillisecondsF(), "ms", true);
+  perf_test::PrintResult(
+      "cache_hit_latency_p99", "", trace,
+      (*latencies)[latencies->size() * 99 / 100].InMillisecondsF(), "ms",
+      true);
+}
+
+}  // namespace
+
+// Measures the latency of hits of small resources in an HttpCache backed by
+// the simple cache, which opens their entries with read-ahead, and compares
+// the reads of the entries with and without read-ahead in the backend.
+TEST(HttpCachePerfTest, SimpleCacheHitLatency) {
+  std::unique_ptr<base::MessageLoopForIO> message_loop;
+  if (!base::MessageLoop::current())
+    message_loop.reset(new base::MessageLoopForIO);
+  base::Thread cache_thread("CacheThread");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+      base::Thread::Options(base::MessageLoop::TYPE_IO, 0)));
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  MockNetworkLayer* network_layer = new MockNetworkLayer;
+  HttpCache cache(base::WrapUnique(network_layer),
+                  base::MakeUnique<HttpCache::DefaultBackend>(
+                      DISK_CACHE, CACHE_BACKEND_SIMPLE, temp_dir.path(), 0,
+                      cache_thread.task_runner()),
+                  false);
+
+  const std::string body(kBodySize, 'b');
+  std::vector<std::string> urls;
+  for (int i = 0; i < kNumEntries; ++i)
+    urls.push_back("http://www.example.com/" + base::IntToString(i));
+  std::vector<std::unique_ptr<ScopedMockTransaction>> transactions;
+  for (const std::string& url : urls) {
+    MockTransaction transaction(kSimpleGET_Transaction);
+    transaction.url = url.c_str();
+    transaction.data = body.c_str();
+    transactions.push_back(
+        base::MakeUnique<ScopedMockTransaction>(transaction));
+  }
+
+  // Populate the cache.
+  for (const auto& transaction : transactions)
+    ASSERT_EQ(OK, FetchResource(&cache, MockHttpRequest(*transaction)));
+  EXPECT_EQ(kNumEntries, network_layer->transaction_count());
+  WaitForEntriesToClose();
+
+  std::vector<base::TimeDelta> latencies;
+  for (const auto& transaction : transactions) {
+    base::ElapsedTimer timer;
+    ASSERT_EQ(OK, FetchResource(&cache, MockHttpRequest(*transaction)));
+    latencies.push_back(timer.Elapsed());
+  }
+  EXPECT_EQ(kNumEntries, network_layer->transaction_count());
+  PrintLatencies("http_cache", &latencies);
+  WaitForEntriesToClose();
+
+  disk_cache::Backend* backend = nullptr;
+  TestCompletionCallback callback;
+  ASSERT_EQ(OK, callback.GetResult(
+                    cache.GetBackend(&backend, callback.callback())));
+  for (int read_ahead_size : {0, kReadAheadSize}) {
+    latencies.clear();
+    for (const std::string& url : urls) {
+      base::ElapsedTimer timer;
+      ASSERT_EQ(OK, ReadEntry(backend, url, read_ahead_size));
+      latencies.push_back(timer.Elapsed());
+    }
+    PrintLatencies(read_ahead_size ? "open_with_read_ahead" : "open_and_read",
+                   &latencies);
+    WaitForEntriesToClose();
+  }
+}
+
+}  // namespace net
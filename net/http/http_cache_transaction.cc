@@ -53,6 +53,10 @@ namespace {
 // TODO(ricea): Move this to HttpResponseHeaders once it is standardised.
 static const char kFreshnessHeader[] = "Resource-Freshness";
 
+// How much of the body of an entry is read along with its headers when it is
+// opened to be read, which covers most cached resources.
+const int kCacheReadAheadSize = 32 * 1024;
+
 // From http://tools.ietf.org/html/draft-ietf-httpbis-p6-cache-21#section-6
 //      a "non-error response" is one with a 2xx (Successful) or 3xx
 //      (Redirection) status code.
@@ -960,7 +964,12 @@ int HttpCache::Transaction::DoOpenEntry() {
   cache_pending_ = true;
   net_log_.BeginEvent(NetLog::TYPE_HTTP_CACHE_OPEN_ENTRY);
   first_cache_access_since_ = TimeTicks::Now();
-  return cache_->OpenEntry(cache_key_, &new_entry_, this);
+  // A hit is likely to be read from the start, except for HEAD and range
+  // requests, so read ahead the beginning of its body.
+  const bool read_ahead =
+      (mode_ & READ_DATA) && !partial_ && request_->method != "HEAD";
+  return cache_->OpenEntry(cache_key_, &new_entry_, this,
+                           read_ahead ? kCacheReadAheadSize : 0);
 }
 
 int HttpCache::Transaction::DoOpenEntryComplete(int result) {
@@ -947,6 +947,8 @@ TEST(HttpCache, SimpleGET_LoadPreferringCache_Hit) {
   EXPECT_EQ(1, cache.network_layer()->transaction_count());
   EXPECT_EQ(1, cache.disk_cache()->open_count());
   EXPECT_EQ(1, cache.disk_cache()->create_count());
+  // The body of the hit was read ahead with the entry.
+  EXPECT_EQ(1, cache.disk_cache()->read_ahead_open_count());
 }
 
 TEST(HttpCache, SimpleGET_LoadPreferringCache_Miss) {
@@ -3199,6 +3201,8 @@ TEST(HttpCache, SimpleHEAD_LoadOnlyFromCache_Hit) {
   EXPECT_EQ(1, cache.network_layer()->transaction_count());
   EXPECT_EQ(1, cache.disk_cache()->open_count());
   EXPECT_EQ(1, cache.disk_cache()->create_count());
+  // There is no body to read ahead.
+  EXPECT_EQ(0, cache.disk_cache()->read_ahead_open_count());
   RemoveMockTransaction(&transaction);
 }
 
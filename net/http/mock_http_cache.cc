@@ -359,8 +359,12 @@ bool MockDiskEntry::ignore_callbacks_ = false;
 //-----------------------------------------------------------------------------
 
 MockDiskCache::MockDiskCache()
-    : open_count_(0), create_count_(0), fail_requests_(false),
-      soft_failures_(false), double_create_check_(true),
+    : open_count_(0),
+      create_count_(0),
+      read_ahead_open_count_(0),
+      fail_requests_(false),
+      soft_failures_(false),
+      double_create_check_(true),
       fail_sparse_requests_(false) {
 }
 
@@ -408,6 +412,17 @@ int MockDiskCache::OpenEntry(const std::string& key,
   return ERR_IO_PENDING;
 }
 
+int MockDiskCache::OpenEntryWithReadAhead(const std::string& key,
+                                          disk_cache::Entry** entry,
+                                          int read_ahead_size,
+                                          const CompletionCallback& callback) {
+  DCHECK_GT(read_ahead_size, 0);
+  int rv = OpenEntry(key, entry, callback);
+  if (rv == OK || rv == ERR_IO_PENDING)
+    read_ahead_open_count_++;
+  return rv;
+}
+
 int MockDiskCache::CreateEntry(const std::string& key,
                                disk_cache::Entry** entry,
                                const CompletionCallback& callback) {
@@ -119,6 +119,10 @@ class MockDiskCache : public disk_cache::Backend {
   int OpenEntry(const std::string& key,
                 disk_cache::Entry** entry,
                 const CompletionCallback& callback) override;
+  int OpenEntryWithReadAhead(const std::string& key,
+                             disk_cache::Entry** entry,
+                             int read_ahead_size,
+                             const CompletionCallback& callback) override;
   int CreateEntry(const std::string& key,
                   disk_cache::Entry** entry,
                   const CompletionCallback& callback) override;
@@ -141,6 +145,10 @@ class MockDiskCache : public disk_cache::Backend {
   // Returns number of times a cache entry was successfully created.
   int create_count() const { return create_count_; }
 
+  // Returns number of times a cache entry was successfully opened to be read
+  // from the start.
+  int read_ahead_open_count() const { return read_ahead_open_count_; }
+
   // Fail any subsequent CreateEntry and OpenEntry.
   void set_fail_requests() { fail_requests_ = true; }
 
@@ -164,6 +172,7 @@ class MockDiskCache : public disk_cache::Backend {
   EntryMap entries_;
   int open_count_;
   int create_count_;
+  int read_ahead_open_count_;
   bool fail_requests_;
   bool soft_failures_;
   bool double_create_check_;
@@ -0,0 +1,308 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/log/binary_net_log_format.h"
+
+#include <string.h>
+
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/json/json_writer.h"
+#include "base/memory/ptr_util.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/pickle.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "net/log/net_log.h"
+
+namespace net {
+
+const char kBinaryNetLogMagic[] = "NetLogB1";
+const size_t kBinaryNetLogMagicLength = sizeof(kBinaryNetLogMagic) - 1;
+
+namespace {
+
+// Values nested deeper than this are considered corrupt.
+const int kMaxValueDepth = 100;
+
+// Records bigger than this are considered corrupt.
+const uint32_t kMaxRecordSize = 64 * 1024 * 1024;
+
+std::unique_ptr<base::Value> ReadValue(base::PickleIterator* iter, int depth) {
+  int type;
+  if (depth > kMaxValueDepth || !iter->ReadInt(&type))
+    return nullptr;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool value;
+      if (!iter->ReadBool(&value))
+        return nullptr;
+      return base::MakeUnique<base::FundamentalValue>(value);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int value;
+      if (!iter->ReadInt(&value))
+        return nullptr;
+      return base::MakeUnique<base::FundamentalValue>(value);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double value;
+      if (!iter->ReadDouble(&value))
+        return nullptr;
+      return base::MakeUnique<base::FundamentalValue>(value);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string value;
+      if (!iter->ReadString(&value))
+        return nullptr;
+      return base::MakeUnique<base::StringValue>(value);
+    }
+    case base::Value::TYPE_BINARY: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length))
+        return nullptr;
+      return base::BinaryValue::CreateWithCopiedBuffer(data, length);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return nullptr;
+      std::unique_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!iter->ReadString(&key))
+          return nullptr;
+        std::unique_ptr<base::Value> value = ReadValue(iter, depth + 1);
+        if (!value)
+          return nullptr;
+        dict->SetWithoutPathExpansion(key, std::move(value));
+      }
+      return std::move(dict);
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return nullptr;
+      std::unique_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        std::unique_ptr<base::Value> value = ReadValue(iter, depth + 1);
+        if (!value)
+          return nullptr;
+        list->Append(std::move(value));
+      }
+      return std::move(list);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// Reads the next record of |file| into |record|. Returns false at the end of
+// the file, or if the record is truncated.
+bool ReadRecord(base::File* file, std::string* record) {
+  uint32_t payload_size;
+  if (file->ReadAtCurrentPos(reinterpret_cast<char*>(&payload_size),
+                             sizeof(payload_size)) != sizeof(payload_size)) {
+    return false;
+  }
+  if (payload_size > kMaxRecordSize)
+    return false;
+  record->resize(sizeof(payload_size) + payload_size);
+  memcpy(&(*record)[0], &payload_size, sizeof(payload_size));
+  return file->ReadAtCurrentPos(&(*record)[sizeof(payload_size)],
+                                payload_size) ==
+         static_cast<int>(payload_size);
+}
+
+std::unique_ptr<base::Value> CopyParameters(const base::Value* parameters,
+                                            NetLogCaptureMode capture_mode) {
+  return parameters->CreateDeepCopy();
+}
+
+// Reads the event of the record read by |iter|, and returns it in the format
+// of NetLog::Entry::ToValue(). Returns nullptr if the record is corrupt.
+std::unique_ptr<base::Value> ReadEvent(base::PickleIterator* iter) {
+  int64_t time;
+  uint32_t source_id;
+  int source_type;
+  int type;
+  int phase;
+  bool has_parameters;
+  if (!iter->ReadInt64(&time) || !iter->ReadUInt32(&source_id) ||
+      !iter->ReadInt(&source_type) || !iter->ReadInt(&type) ||
+      !iter->ReadInt(&phase) || !iter->ReadBool(&has_parameters)) {
+    return nullptr;
+  }
+  if (source_type < 0 || source_type >= NetLog::SOURCE_COUNT || type < 0 ||
+      type >= NetLog::EVENT_COUNT || phase < NetLog::PHASE_NONE ||
+      phase > NetLog::PHASE_END) {
+    return nullptr;
+  }
+  std::unique_ptr<base::Value> parameters;
+  if (has_parameters) {
+    parameters = ReadValue(iter, 0);
+    if (!parameters)
+      return nullptr;
+  }
+
+  // Use NetLog::Entry to get the very same format as the JSON logs.
+  NetLog::ParametersCallback parameters_callback =
+      base::Bind(&CopyParameters, base::Unretained(parameters.get()));
+  NetLog::EntryData entry_data(
+      static_cast<NetLog::EventType>(type),
+      NetLog::Source(static_cast<NetLog::SourceType>(source_type), source_id),
+      static_cast<NetLog::EventPhase>(phase),
+      base::TimeTicks::FromInternalValue(time),
+      parameters ? &parameters_callback : nullptr);
+  NetLog::Entry entry(&entry_data, NetLogCaptureMode::Default());
+  return base::WrapUnique(entry.ToValue());
+}
+
+}  // namespace
+
+void WriteValueToPickle(const base::Value& value, base::Pickle* pickle) {
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      break;
+    case base::Value::TYPE_BOOLEAN: {
+      bool bool_value = false;
+      value.GetAsBoolean(&bool_value);
+      pickle->WriteBool(bool_value);
+      break;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int int_value = 0;
+      value.GetAsInteger(&int_value);
+      pickle->WriteInt(int_value);
+      break;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double double_value = 0.0;
+      value.GetAsDouble(&double_value);
+      pickle->WriteDouble(double_value);
+      break;
+    }
+    case base::Value::TYPE_STRING: {
+      const base::StringValue* string_value = nullptr;
+      value.GetAsString(&string_value);
+      pickle->WriteString(string_value->GetString());
+      break;
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue* binary_value =
+          static_cast<const base::BinaryValue*>(&value);
+      pickle->WriteData(binary_value->GetBuffer(),
+                        base::checked_cast<int>(binary_value->GetSize()));
+      break;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict = nullptr;
+      value.GetAsDictionary(&dict);
+      pickle->WriteInt(base::checked_cast<int>(dict->size()));
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        pickle->WriteString(it.key());
+        WriteValueToPickle(it.value(), pickle);
+      }
+      break;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list = nullptr;
+      value.GetAsList(&list);
+      pickle->WriteInt(base::checked_cast<int>(list->GetSize()));
+      for (const auto& item : *list)
+        WriteValueToPickle(*item, pickle);
+      break;
+    }
+  }
+}
+
+std::unique_ptr<base::Value> ReadValueFromPickle(base::PickleIterator* iter) {
+  return ReadValue(iter, 0);
+}
+
+bool ConvertBinaryNetLogToJson(base::File* binary_file,
+                               FILE* json_file,
+                               int64_t* dropped_events) {
+  char magic[kBinaryNetLogMagicLength];
+  if (binary_file->ReadAtCurrentPos(magic, kBinaryNetLogMagicLength) !=
+          static_cast<int>(kBinaryNetLogMagicLength) ||
+      memcmp(magic, kBinaryNetLogMagic, kBinaryNetLogMagicLength) != 0) {
+    return false;
+  }
+
+  std::unique_ptr<base::Value> tab_info;
+  int64_t dropped = 0;
+  bool has_constants = false;
+  bool added_events = false;
+  std::string record;
+  while (ReadRecord(binary_file, &record)) {
+    base::Pickle pickle(record.data(), base::checked_cast<int>(record.size()));
+    base::PickleIterator iter(pickle);
+    int record_type;
+    if (!iter.ReadInt(&record_type))
+      return false;
+    if ((record_type == BINARY_NET_LOG_CONSTANTS) == has_constants)
+      return false;
+
+    switch (record_type) {
+      case BINARY_NET_LOG_CONSTANTS: {
+        std::unique_ptr<base::Value> constants = ReadValueFromPickle(&iter);
+        if (!constants)
+          return false;
+        std::string json;
+        base::JSONWriter::Write(*constants, &json);
+        fprintf(json_file, "{\"constants\": %s,\n", json.c_str());
+        fprintf(json_file, "\"events\": [\n");
+        has_constants = true;
+        break;
+      }
+      case BINARY_NET_LOG_EVENT: {
+        std::unique_ptr<base::Value> event = ReadEvent(&iter);
+        if (!event)
+          return false;
+        std::string json;
+        base::JSONWriter::Write(*event, &json);
+        fprintf(json_file, "%s%s", (added_events ? ",\n" : ""), json.c_str());
+        added_events = true;
+        break;
+      }
+      case BINARY_NET_LOG_TAB_INFO:
+        tab_info = ReadValueFromPickle(&iter);
+        if (!tab_info)
+          return false;
+        break;
+      case BINARY_NET_LOG_DROPPED_EVENTS:
+        if (!iter.ReadInt64(&dropped))
+          return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (!has_constants)
+    return false;
+
+  fprintf(json_file, "]");
+  if (tab_info) {
+    std::string json;
+    base::JSONWriter::Write(*tab_info, &json);
+    fprintf(json_file, ",\"tabInfo\": %s\n", json.c_str());
+  }
+  fprintf(json_file, "}");
+
+  if (dropped_events)
+    *dropped_events = dropped;
+  return true;
+}
+
+}  // namespace net
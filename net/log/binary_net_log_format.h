@@ -0,0 +1,73 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_LOG_BINARY_NET_LOG_FORMAT_H_
+#define NET_LOG_BINARY_NET_LOG_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <memory>
+
+#include "net/base/net_export.h"
+
+namespace base {
+class File;
+class Pickle;
+class PickleIterator;
+class Value;
+}
+
+namespace net {
+
+// A binary NetLog file, as written by BinaryNetLogObserver, starts with
+// kBinaryNetLogMagic, followed by length-prefixed records. Each record is a
+// base::Pickle, whose header holds the size of its payload, and whose payload
+// starts with a BinaryNetLogRecordType:
+//
+// - BINARY_NET_LOG_CONSTANTS is the first record, and holds the constants of
+//   the log as a Value.
+// - BINARY_NET_LOG_EVENT holds the time, the source id and type, the type and
+//   the phase of an event, then a bool telling whether it has parameters,
+//   followed by the parameters as a Value.
+// - BINARY_NET_LOG_TAB_INFO optionally follows the events, and holds the
+//   state of the URLRequestContext when logging stopped as a Value.
+// - BINARY_NET_LOG_DROPPED_EVENTS is the last record, and holds the number of
+//   events which were not logged as an int64_t.
+//
+// Values are written by WriteValueToPickle(). The last record of a log which
+// was not stopped, e.g. because of a crash, may be truncated.
+NET_EXPORT extern const char kBinaryNetLogMagic[];
+NET_EXPORT extern const size_t kBinaryNetLogMagicLength;
+
+enum BinaryNetLogRecordType {
+  BINARY_NET_LOG_CONSTANTS,
+  BINARY_NET_LOG_EVENT,
+  BINARY_NET_LOG_TAB_INFO,
+  BINARY_NET_LOG_DROPPED_EVENTS,
+};
+
+// Writes |value| to |pickle|, as its type followed by its contents.
+NET_EXPORT void WriteValueToPickle(const base::Value& value,
+                                   base::Pickle* pickle);
+
+// Reads a Value written by WriteValueToPickle() from |iter|. Returns nullptr
+// if the data is not a valid Value.
+NET_EXPORT std::unique_ptr<base::Value> ReadValueFromPickle(
+    base::PickleIterator* iter);
+
+// Converts the binary NetLog read from |binary_file| to the JSON format
+// written by WriteToFileNetLogObserver, which net-internals loads, and writes
+// it to |json_file|. A truncated last record is ignored, and the log is
+// closed as if logging had stopped. Sets |*dropped_events| to the number of
+// events which were not logged, if it is not null. Returns false if
+// |binary_file| is not a binary NetLog, or is corrupt.
+NET_EXPORT bool ConvertBinaryNetLogToJson(base::File* binary_file,
+                                          FILE* json_file,
+                                          int64_t* dropped_events);
+
+}  // namespace net
+
+#endif  // NET_LOG_BINARY_NET_LOG_FORMAT_H_
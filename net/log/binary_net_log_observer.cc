@@ -0,0 +1,285 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/log/binary_net_log_observer.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/sequenced_task_runner.h"
+#include "base/values.h"
+#include "net/log/binary_net_log_format.h"
+#include "net/log/net_log_util.h"
+#include "net/url_request/url_request_context.h"
+
+namespace net {
+
+namespace {
+
+// Serialized records are buffered up to this size before being written.
+const size_t kWriteBufferSize = 64 * 1024;
+
+}  // namespace
+
+const size_t BinaryNetLogObserver::kDefaultMaxPendingEntries = 64 * 1024;
+
+// FileWriter owns the ring buffer of the entries waiting to be written, and
+// the file they are written to. The ring buffer has a single producer, the
+// observer, whose calls to OnAddEntry() are serialized by the NetLog, and a
+// single consumer, the file task runner, so it only needs atomic indices.
+class BinaryNetLogObserver::FileWriter
+    : public base::RefCountedThreadSafe<FileWriter> {
+ public:
+  // An entry of the ring buffer.
+  struct PendingEntry {
+    NetLog::EventType type;
+    NetLog::Source source;
+    NetLog::EventPhase phase;
+    base::TimeTicks time;
+    std::unique_ptr<base::Value> parameters;
+  };
+
+  FileWriter(base::File file,
+             size_t capacity,
+             const scoped_refptr<base::SequencedTaskRunner>& task_runner)
+      : capacity_(capacity),
+        entries_(new PendingEntry[capacity]),
+        tail_(0),
+        head_(0),
+        pending_count_(0),
+        task_runner_(task_runner),
+        file_(std::move(file)) {
+    DCHECK_EQ(0u, capacity_ & (capacity_ - 1));
+  }
+
+  // Returns the slot to fill with the next entry, or nullptr if the ring
+  // buffer is full. Called by the producer.
+  PendingEntry* BeginPush() {
+    size_t head = static_cast<size_t>(base::subtle::Acquire_Load(&head_));
+    if (tail_ - head == capacity_)
+      return nullptr;
+    return &entries_[tail_ & (capacity_ - 1)];
+  }
+
+  // Hands the entry filled since BeginPush() to the consumer. Called by the
+  // producer.
+  void EndPush() {
+    ++tail_;
+    // Only post a task when the consumer isn't already draining the entries,
+    // so that there is at most one task per batch of entries.
+    if (base::subtle::Barrier_AtomicIncrement(&pending_count_, 1) == 1) {
+      task_runner_->PostTask(FROM_HERE,
+                             base::Bind(&FileWriter::Drain, this));
+    }
+  }
+
+  // Writes the header of the file. Called on the file task runner, before
+  // any other task.
+  void WriteConstants(std::unique_ptr<base::Value> constants) {
+    DCHECK(task_runner_->RunsTasksOnCurrentThread());
+    buffer_.append(kBinaryNetLogMagic, kBinaryNetLogMagicLength);
+    base::Pickle pickle;
+    pickle.WriteInt(BINARY_NET_LOG_CONSTANTS);
+    WriteValueToPickle(*constants, &pickle);
+    WriteRecord(pickle);
+  }
+
+  // Serializes and writes all the entries of the ring buffer. Called on the
+  // file task runner.
+  void Drain() {
+    DCHECK(task_runner_->RunsTasksOnCurrentThread());
+    // Entries pushed while draining are drained by the same task, since
+    // their producer doesn't post another one.
+    base::subtle::Atomic32 count = base::subtle::Acquire_Load(&pending_count_);
+    while (count > 0) {
+      size_t head = static_cast<size_t>(base::subtle::NoBarrier_Load(&head_));
+      for (base::subtle::Atomic32 i = 0; i < count; ++i) {
+        PendingEntry* entry = &entries_[head & (capacity_ - 1)];
+        WriteEntry(*entry);
+        entry->parameters.reset();
+        // Release the slot to the producer.
+        base::subtle::Release_Store(
+            &head_, static_cast<base::subtle::AtomicWord>(++head));
+      }
+      count = base::subtle::Barrier_AtomicIncrement(&pending_count_, -count);
+    }
+    Flush();
+  }
+
+  // Writes the remaining entries and the footer of the file, and closes it.
+  // Called on the file task runner once the observer has stopped observing.
+  void Finish(std::unique_ptr<base::Value> tab_info, int64_t dropped_entries) {
+    Drain();
+    if (tab_info) {
+      base::Pickle pickle;
+      pickle.WriteInt(BINARY_NET_LOG_TAB_INFO);
+      WriteValueToPickle(*tab_info, &pickle);
+      WriteRecord(pickle);
+    }
+    base::Pickle pickle;
+    pickle.WriteInt(BINARY_NET_LOG_DROPPED_EVENTS);
+    pickle.WriteInt64(dropped_entries);
+    WriteRecord(pickle);
+    Flush();
+    file_.Close();
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileWriter>;
+
+  ~FileWriter() {}
+
+  void WriteEntry(const PendingEntry& entry) {
+    base::Pickle pickle;
+    pickle.WriteInt(BINARY_NET_LOG_EVENT);
+    pickle.WriteInt64(entry.time.ToInternalValue());
+    pickle.WriteUInt32(entry.source.id);
+    pickle.WriteInt(entry.source.type);
+    pickle.WriteInt(entry.type);
+    pickle.WriteInt(entry.phase);
+    pickle.WriteBool(!!entry.parameters);
+    if (entry.parameters)
+      WriteValueToPickle(*entry.parameters, &pickle);
+    WriteRecord(pickle);
+  }
+
+  void WriteRecord(const base::Pickle& pickle) {
+    buffer_.append(static_cast<const char*>(pickle.data()), pickle.size());
+    if (buffer_.size() >= kWriteBufferSize)
+      Flush();
+  }
+
+  void Flush() {
+    if (buffer_.empty())
+      return;
+    // Like WriteToFileNetLogObserver, ignore write errors, as there's nothing
+    // useful to do about them.
+    file_.WriteAtCurrentPos(buffer_.data(), static_cast<int>(buffer_.size()));
+    buffer_.clear();
+  }
+
+  // The ring buffer. Its capacity is a power of two, so that the slot of an
+  // index is the index modulo the capacity, and indices may wrap around.
+  const size_t capacity_;
+  const std::unique_ptr<PendingEntry[]> entries_;
+
+  // Index of the next entry to push. Only accessed by the producer.
+  size_t tail_;
+
+  // Index of the next entry to pop. Only written by the consumer.
+  base::subtle::AtomicWord head_;
+
+  // Number of entries pushed and not yet claimed by Drain(). The producer
+  // posts a Drain() task when this goes from 0 to 1.
+  base::subtle::Atomic32 pending_count_;
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  // Only accessed on |task_runner_|.
+  base::File file_;
+  std::string buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileWriter);
+};
+
+BinaryNetLogObserver::BinaryNetLogObserver(
+    const scoped_refptr<base::SequencedTaskRunner>& file_task_runner,
+    size_t max_pending_entries)
+    : file_task_runner_(file_task_runner),
+      max_pending_entries_(max_pending_entries),
+      capture_mode_(NetLogCaptureMode::Default()),
+      dropped_entries_(0) {
+  DCHECK_GT(max_pending_entries, 0u);
+}
+
+BinaryNetLogObserver::~BinaryNetLogObserver() {
+  DCHECK(!file_writer_);
+}
+
+void BinaryNetLogObserver::set_capture_mode(NetLogCaptureMode capture_mode) {
+  DCHECK(!net_log());
+  capture_mode_ = capture_mode;
+}
+
+void BinaryNetLogObserver::StartObserving(
+    NetLog* net_log,
+    base::File file,
+    base::Value* constants,
+    URLRequestContext* url_request_context) {
+  DCHECK(file.IsValid());
+  DCHECK(!file_writer_);
+  size_t capacity = 1;
+  while (capacity < max_pending_entries_)
+    capacity <<= 1;
+  file_writer_ = new FileWriter(std::move(file), capacity, file_task_runner_);
+  dropped_entries_ = 0;
+
+  // Write constants to the output file. This allows loading files that have
+  // different source and event types, as they may be added and removed
+  // between Chrome versions.
+  std::unique_ptr<base::Value> constants_copy;
+  if (constants)
+    constants_copy = constants->CreateDeepCopy();
+  else
+    constants_copy = GetNetConstants();
+  file_task_runner_->PostTask(
+      FROM_HERE, base::Bind(&FileWriter::WriteConstants, file_writer_,
+                            base::Passed(&constants_copy)));
+
+  // Add events for in progress requests if a context is given.
+  if (url_request_context) {
+    DCHECK(url_request_context->CalledOnValidThread());
+
+    std::set<URLRequestContext*> contexts;
+    contexts.insert(url_request_context);
+    CreateNetLogEntriesForActiveObjects(contexts, this);
+  }
+
+  net_log->DeprecatedAddObserver(this, capture_mode_);
+}
+
+void BinaryNetLogObserver::StopObserving(URLRequestContext* url_request_context,
+                                         const base::Closure& callback) {
+  net_log()->DeprecatedRemoveObserver(this);
+
+  // Write state of the URLRequestContext when logging stopped.
+  std::unique_ptr<base::Value> tab_info;
+  if (url_request_context) {
+    DCHECK(url_request_context->CalledOnValidThread());
+    tab_info = GetNetInfo(url_request_context, NET_INFO_ALL_SOURCES);
+  }
+
+  file_task_runner_->PostTaskAndReply(
+      FROM_HERE, base::Bind(&FileWriter::Finish, file_writer_,
+                            base::Passed(&tab_info), dropped_entries_),
+      callback);
+  file_writer_ = nullptr;
+}
+
+void BinaryNetLogObserver::OnAddEntry(const NetLog::Entry& entry) {
+  FileWriter::PendingEntry* pending_entry = file_writer_->BeginPush();
+  if (!pending_entry) {
+    ++dropped_entries_;
+    return;
+  }
+  pending_entry->type = entry.type();
+  pending_entry->source = entry.source();
+  pending_entry->phase = entry.phase();
+  pending_entry->time = entry.time();
+  // The parameters callback may refer to objects which only live for the
+  // duration of the call, so the parameters must be gotten here. Serializing
+  // them is left to the file task runner.
+  pending_entry->parameters = entry.ParametersToValue();
+  file_writer_->EndPush();
+}
+
+}  // namespace net
@@ -0,0 +1,106 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_LOG_BINARY_NET_LOG_OBSERVER_H_
+#define NET_LOG_BINARY_NET_LOG_OBSERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/callback_forward.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/net_export.h"
+#include "net/log/net_log.h"
+
+namespace base {
+class File;
+class SequencedTaskRunner;
+class Value;
+}
+
+namespace net {
+
+class URLRequestContext;
+
+// BinaryNetLogObserver watches the NetLog event stream, and sends all entries
+// to a file specified on creation, in the compact binary format described in
+// binary_net_log_format.h. ConvertBinaryNetLogToJson() converts the file to
+// the JSON format of WriteToFileNetLogObserver, which net-internals loads.
+//
+// Unlike WriteToFileNetLogObserver, which serializes the entries to JSON and
+// writes them on the threads adding them, the observer only gets the
+// parameters of the entries on those threads, and hands the entries to a
+// background sequence through a lock-free ring buffer. They are serialized
+// and written to the file in batches on that sequence. When the ring buffer
+// is full, entries are dropped rather than blocking the threads adding them,
+// and the number of dropped entries is recorded at the end of the file.
+class NET_EXPORT BinaryNetLogObserver : public NetLog::ThreadSafeObserver {
+ public:
+  // Default number of entries which may be waiting to be written.
+  static const size_t kDefaultMaxPendingEntries;
+
+  // The entries are written on |file_task_runner|. At most
+  // |max_pending_entries|, rounded up to a power of two, may be waiting to be
+  // written.
+  BinaryNetLogObserver(
+      const scoped_refptr<base::SequencedTaskRunner>& file_task_runner,
+      size_t max_pending_entries);
+  ~BinaryNetLogObserver() override;
+
+  // Sets the capture mode to log at. Must be called before StartObserving.
+  void set_capture_mode(NetLogCaptureMode capture_mode);
+
+  // Starts observing |net_log| and writes output to |file|, which must be a
+  // valid empty file open for writing. Must not already be watching a NetLog.
+  //
+  // |constants| and |url_request_context| are as for
+  // WriteToFileNetLogObserver::StartObserving().
+  void StartObserving(NetLog* net_log,
+                      base::File file,
+                      base::Value* constants,
+                      URLRequestContext* url_request_context);
+
+  // Stops observing net_log(). Must already be watching. Must be called
+  // before destruction of the BinaryNetLogObserver and the NetLog. The
+  // entries which are still pending are written and the file is closed on
+  // the file task runner, after which |callback| is run on the calling
+  // thread.
+  //
+  // |url_request_context| is as for WriteToFileNetLogObserver::StopObserving().
+  void StopObserving(URLRequestContext* url_request_context,
+                     const base::Closure& callback);
+
+  // Returns the number of entries dropped since StartObserving() because too
+  // many entries were waiting to be written. Must not be called while
+  // observing.
+  int64_t dropped_entries() const { return dropped_entries_; }
+
+  // net::NetLog::ThreadSafeObserver implementation:
+  void OnAddEntry(const NetLog::Entry& entry) override;
+
+ private:
+  class FileWriter;
+
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+
+  const size_t max_pending_entries_;
+
+  // The capture mode to log at.
+  NetLogCaptureMode capture_mode_;
+
+  // Owns the ring buffer and the file, and writes the entries on
+  // |file_task_runner_|. Like the other members, it is accessed in
+  // OnAddEntry() without a lock, as NetLog notifies its observers serially.
+  scoped_refptr<FileWriter> file_writer_;
+
+  // Number of entries dropped because the ring buffer was full.
+  int64_t dropped_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(BinaryNetLogObserver);
+};
+
+}  // namespace net
+
+#endif  // NET_LOG_BINARY_NET_LOG_OBSERVER_H_
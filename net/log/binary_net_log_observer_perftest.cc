@@ -0,0 +1,120 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/log/binary_net_log_observer.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "net/log/net_log.h"
+#include "net/log/write_to_file_net_log_observer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+// Number of simulated requests, each of which adds kEntriesPerRequest
+// entries.
+const int kNumRequests = 100000;
+const int kEntriesPerRequest = 3;
+
+// Adds the entries of kNumRequests requests to |net_log|, and returns the
+// time it took.
+base::TimeDelta AddEntries(NetLog* net_log) {
+  std::string url = "https://www.example.com/resources/";
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kNumRequests; ++i) {
+    BoundNetLog bound_net_log =
+        BoundNetLog::Make(net_log, NetLog::SOURCE_URL_REQUEST);
+    std::string request_url = url + base::IntToString(i);
+    bound_net_log.BeginEvent(NetLog::TYPE_REQUEST_ALIVE,
+                             NetLog::StringCallback("url", &request_url));
+    bound_net_log.AddEvent(NetLog::TYPE_URL_REQUEST_DELEGATE,
+                           NetLog::IntCallback("load_flags", i));
+    bound_net_log.EndEvent(NetLog::TYPE_REQUEST_ALIVE);
+  }
+  return timer.Elapsed();
+}
+
+void PrintTimePerEntry(const std::string& trace, base::TimeDelta elapsed) {
+  perf_test::PrintResult(
+      "add_entry", "", trace,
+      elapsed.InMillisecondsF() * 1000 / (kNumRequests * kEntriesPerRequest),
+      "us", true);
+}
+
+void PrintFileSize(const std::string& trace, const base::FilePath& path) {
+  int64_t file_size = 0;
+  ASSERT_TRUE(base::GetFileSize(path, &file_size));
+  perf_test::PrintResult("file_size", "", trace,
+                         file_size / (1024.0 * 1024.0), "MB", false);
+}
+
+}  // namespace
+
+// Measures the overhead of the NetLog observers on the threads adding the
+// entries, compared to not capturing the NetLog, and the size of their
+// files.
+TEST(BinaryNetLogObserverPerfTest, CaptureOverhead) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  {
+    NetLog net_log;
+    PrintTimePerEntry("capture_off", AddEntries(&net_log));
+  }
+
+  {
+    NetLog net_log;
+    const base::FilePath path = temp_dir.path().AppendASCII("netlog.json");
+    base::ScopedFILE file(base::OpenFile(path, "w"));
+    ASSERT_TRUE(file);
+    WriteToFileNetLogObserver observer;
+    observer.StartObserving(&net_log, std::move(file), nullptr, nullptr);
+    PrintTimePerEntry("write_to_file", AddEntries(&net_log));
+    observer.StopObserving(nullptr);
+    PrintFileSize("write_to_file", path);
+  }
+
+  {
+    NetLog net_log;
+    base::Thread file_thread("NetLogFileThread");
+    ASSERT_TRUE(file_thread.Start());
+    const base::FilePath path = temp_dir.path().AppendASCII("netlog.bin");
+    base::File file(path,
+                    base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    BinaryNetLogObserver observer(
+        file_thread.task_runner(),
+        BinaryNetLogObserver::kDefaultMaxPendingEntries);
+    observer.StartObserving(&net_log, std::move(file), nullptr, nullptr);
+    base::ElapsedTimer timer;
+    PrintTimePerEntry("binary", AddEntries(&net_log));
+    base::RunLoop run_loop;
+    observer.StopObserving(nullptr, run_loop.QuitClosure());
+    run_loop.Run();
+    // Includes writing the entries on the file thread.
+    perf_test::PrintResult("total_time", "", "binary",
+                           timer.Elapsed().InMillisecondsF(), "ms", false);
+    perf_test::PrintResult("dropped_entries", "", "binary",
+                           static_cast<size_t>(observer.dropped_entries()),
+                           "entries", false);
+    PrintFileSize("binary", path);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,273 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/log/binary_net_log_observer.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/pickle.h"
+#include "base/run_loop.h"
+#include "base/test/test_simple_task_runner.h"
+#include "base/values.h"
+#include "net/log/binary_net_log_format.h"
+#include "net/log/net_log.h"
+#include "net/log/write_to_file_net_log_observer.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const size_t kMaxPendingEntries = 16;
+
+class BinaryNetLogObserverTest : public testing::Test {
+ public:
+  BinaryNetLogObserverTest()
+      : file_task_runner_(new base::TestSimpleTaskRunner),
+        observer_(file_task_runner_, kMaxPendingEntries) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    log_path_ = temp_dir_.path().AppendASCII("NetLogFile");
+    json_log_path_ = temp_dir_.path().AppendASCII("NetLogFile.json");
+  }
+
+ protected:
+  void StartObserving(base::Value* constants,
+                      URLRequestContext* url_request_context) {
+    base::File file(log_path_,
+                    base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    observer_.StartObserving(&net_log_, std::move(file), constants,
+                             url_request_context);
+  }
+
+  // Stops observing and waits for the file to be written.
+  void StopObserving(URLRequestContext* url_request_context) {
+    base::RunLoop run_loop;
+    observer_.StopObserving(url_request_context, run_loop.QuitClosure());
+    file_task_runner_->RunUntilIdle();
+    run_loop.Run();
+  }
+
+  // Converts the binary log to JSON, and returns it parsed, or nullptr on
+  // failure.
+  std::unique_ptr<base::DictionaryValue> ConvertLog(int64_t* dropped_events) {
+    base::File file(log_path_, base::File::FLAG_OPEN | base::File::FLAG_READ);
+    base::ScopedFILE json_file(base::OpenFile(json_log_path_, "w"));
+    if (!file.IsValid() || !json_file ||
+        !ConvertBinaryNetLogToJson(&file, json_file.get(), dropped_events)) {
+      return nullptr;
+    }
+    json_file.reset();
+    return ReadJsonLog(json_log_path_);
+  }
+
+  std::unique_ptr<base::DictionaryValue> ReadJsonLog(
+      const base::FilePath& path) {
+    std::string input;
+    if (!base::ReadFileToString(path, &input))
+      return nullptr;
+    return base::DictionaryValue::From(base::JSONReader::Read(input));
+  }
+
+  scoped_refptr<base::TestSimpleTaskRunner> file_task_runner_;
+  BinaryNetLogObserver observer_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath log_path_;
+  base::FilePath json_log_path_;
+  NetLog net_log_;
+};
+
+TEST_F(BinaryNetLogObserverTest, GeneratesValidJSONForNoEvents) {
+  StartObserving(nullptr, nullptr);
+  StopObserving(nullptr);
+
+  int64_t dropped_events = -1;
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(&dropped_events);
+  ASSERT_TRUE(dict);
+  base::ListValue* events;
+  ASSERT_TRUE(dict->GetList("events", &events));
+  EXPECT_EQ(0u, events->GetSize());
+  base::DictionaryValue* constants;
+  EXPECT_TRUE(dict->GetDictionary("constants", &constants));
+  EXPECT_FALSE(dict->HasKey("tabInfo"));
+  EXPECT_EQ(0, dropped_events);
+}
+
+TEST_F(BinaryNetLogObserverTest, CustomConstants) {
+  const char kConstantString[] = "awesome constant";
+  base::StringValue constants(kConstantString);
+  StartObserving(&constants, nullptr);
+  StopObserving(nullptr);
+
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(nullptr);
+  ASSERT_TRUE(dict);
+  std::string constants_string;
+  ASSERT_TRUE(dict->GetString("constants", &constants_string));
+  EXPECT_EQ(kConstantString, constants_string);
+}
+
+// The converted log has the same events as a log written by
+// WriteToFileNetLogObserver.
+TEST_F(BinaryNetLogObserverTest, MatchesWriteToFileNetLogObserver) {
+  // The default constants depend on the time they are gotten.
+  std::unique_ptr<base::DictionaryValue> constants(new base::DictionaryValue);
+  constants->SetInteger("logFormatVersion", 1);
+  base::ScopedFILE json_file(base::OpenFile(json_log_path_, "w"));
+  ASSERT_TRUE(json_file);
+  WriteToFileNetLogObserver json_observer;
+  json_observer.set_capture_mode(NetLogCaptureMode::IncludeSocketBytes());
+  json_observer.StartObserving(&net_log_, std::move(json_file),
+                               constants.get(), nullptr);
+  observer_.set_capture_mode(NetLogCaptureMode::IncludeSocketBytes());
+  StartObserving(constants.get(), nullptr);
+
+  const std::string kUrl = "https://www.example.com/";
+  net_log_.AddGlobalEntry(NetLog::TYPE_PROXY_SERVICE);
+  net_log_.AddGlobalEntry(NetLog::TYPE_REQUEST_ALIVE,
+                          NetLog::StringCallback("url", &kUrl));
+  // Entries written before the file task runner runs.
+  file_task_runner_->RunUntilIdle();
+  net_log_.AddGlobalEntry(NetLog::TYPE_CANCELLED, NetLog::IntCallback("a", 1));
+  NetLog::Source source(NetLog::SOURCE_HTTP2_SESSION, net_log_.NextID());
+  BoundNetLog::Make(&net_log_, NetLog::SOURCE_URL_REQUEST)
+      .BeginEvent(NetLog::TYPE_REQUEST_ALIVE,
+                  source.ToEventParametersCallback());
+
+  json_observer.StopObserving(nullptr);
+  StopObserving(nullptr);
+
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(nullptr);
+  ASSERT_TRUE(dict);
+  std::unique_ptr<base::DictionaryValue> json_dict =
+      ReadJsonLog(json_log_path_);
+  ASSERT_TRUE(json_dict);
+  base::ListValue* events;
+  ASSERT_TRUE(dict->GetList("events", &events));
+  EXPECT_EQ(4u, events->GetSize());
+  EXPECT_TRUE(dict->Equals(json_dict.get()));
+}
+
+TEST_F(BinaryNetLogObserverTest, DropsEntriesWhenFull) {
+  StartObserving(nullptr, nullptr);
+  for (size_t i = 0; i < kMaxPendingEntries + 2; ++i)
+    net_log_.AddGlobalEntry(NetLog::TYPE_CANCELLED);
+  // The ring buffer is drained by the file task runner.
+  file_task_runner_->RunUntilIdle();
+  net_log_.AddGlobalEntry(NetLog::TYPE_CANCELLED);
+  StopObserving(nullptr);
+  EXPECT_EQ(2, observer_.dropped_entries());
+
+  int64_t dropped_events = 0;
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(&dropped_events);
+  ASSERT_TRUE(dict);
+  base::ListValue* events;
+  ASSERT_TRUE(dict->GetList("events", &events));
+  EXPECT_EQ(kMaxPendingEntries + 1, events->GetSize());
+  EXPECT_EQ(2, dropped_events);
+}
+
+TEST_F(BinaryNetLogObserverTest,
+       GeneratesValidJSONWithContextWithActiveRequest) {
+  // Create context, start a request.
+  TestURLRequestContext context(true);
+  context.set_net_log(&net_log_);
+  context.Init();
+  TestDelegate delegate;
+
+  // URL doesn't matter.  Requests can't fail synchronously.
+  std::unique_ptr<URLRequest> request(
+      context.CreateRequest(GURL("blah:blah"), IDLE, &delegate));
+  request->Start();
+
+  StartObserving(nullptr, &context);
+  StopObserving(&context);
+
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(nullptr);
+  ASSERT_TRUE(dict);
+  base::ListValue* events;
+  ASSERT_TRUE(dict->GetList("events", &events));
+  EXPECT_EQ(1u, events->GetSize());
+
+  // Make sure additional information is present, but don't validate it.
+  base::DictionaryValue* tab_info;
+  EXPECT_TRUE(dict->GetDictionary("tabInfo", &tab_info));
+}
+
+// A log whose last record is truncated, e.g. because of a crash, is converted
+// up to that record.
+TEST_F(BinaryNetLogObserverTest, ConvertsTruncatedLog) {
+  StartObserving(nullptr, nullptr);
+  net_log_.AddGlobalEntry(NetLog::TYPE_CANCELLED);
+  net_log_.AddGlobalEntry(NetLog::TYPE_CANCELLED);
+  StopObserving(nullptr);
+
+  int64_t file_size = 0;
+  ASSERT_TRUE(base::GetFileSize(log_path_, &file_size));
+  {
+    base::File file(log_path_, base::File::FLAG_OPEN | base::File::FLAG_WRITE);
+    // Truncate the dropped events record and the last event.
+    ASSERT_TRUE(file.SetLength(file_size - 20));
+  }
+
+  std::unique_ptr<base::DictionaryValue> dict = ConvertLog(nullptr);
+  ASSERT_TRUE(dict);
+  base::ListValue* events;
+  ASSERT_TRUE(dict->GetList("events", &events));
+  EXPECT_EQ(1u, events->GetSize());
+}
+
+TEST_F(BinaryNetLogObserverTest, FailsToConvertInvalidLog) {
+  const char kJsonLog[] = "{\"constants\": {}, \"events\": []}";
+  ASSERT_EQ(static_cast<int>(sizeof(kJsonLog)),
+            base::WriteFile(log_path_, kJsonLog, sizeof(kJsonLog)));
+  EXPECT_FALSE(ConvertLog(nullptr));
+}
+
+TEST(BinaryNetLogFormatTest, ValueRoundTrip) {
+  base::DictionaryValue dict;
+  dict.Set("null", base::Value::CreateNullValue());
+  dict.SetBoolean("bool", true);
+  dict.SetInteger("int", -42);
+  dict.SetDouble("double", 3.5);
+  dict.SetString("string", "value");
+  const char kBinary[] = {0, 1, 2};
+  dict.Set("binary",
+           base::BinaryValue::CreateWithCopiedBuffer(kBinary, sizeof(kBinary)));
+  std::unique_ptr<base::ListValue> list(new base::ListValue);
+  list->AppendString("item");
+  list->Append(dict.CreateDeepCopy());
+  dict.Set("list", std::move(list));
+
+  base::Pickle pickle;
+  WriteValueToPickle(dict, &pickle);
+  base::PickleIterator iter(pickle);
+  std::unique_ptr<base::Value> value = ReadValueFromPickle(&iter);
+  ASSERT_TRUE(value);
+  EXPECT_TRUE(dict.Equals(value.get()));
+
+  // Truncated data isn't a valid Value.
+  base::Pickle truncated_pickle(static_cast<const char*>(pickle.data()),
+                                pickle.size() - 4);
+  base::PickleIterator truncated_iter(truncated_pickle);
+  EXPECT_FALSE(ReadValueFromPickle(&truncated_iter));
+}
+
+}  // namespace
+
+}  // namespace net
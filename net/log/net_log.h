@@ -130,6 +130,7 @@ class NET_EXPORT NetLog {
     EventType type() const { return data_->type; }
     Source source() const { return data_->source; }
     EventPhase phase() const { return data_->phase; }
+    base::TimeTicks time() const { return data_->time; }
 
     // Serializes the specified event to a Value.  The Value also includes the
     // current time.  Caller takes ownership of returned Value.  Takes in a time
@@ -66,6 +66,10 @@ EVENT_TYPE(HOST_RESOLVER_IMPL_IPV6_REACHABILITY_CHECK)
 // This event is logged when a request is handled by a cache entry.
 EVENT_TYPE(HOST_RESOLVER_IMPL_CACHE_HIT)
 
+// This event is logged when a request handled by a cache entry starts a Job to
+// refresh the entry before it expires.
+EVENT_TYPE(HOST_RESOLVER_IMPL_REFRESH_AHEAD)
+
 // This event is logged when a request is handled by a HOSTS entry.
 EVENT_TYPE(HOST_RESOLVER_IMPL_HOSTS_HIT)
 
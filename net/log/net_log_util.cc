@@ -379,9 +379,25 @@ NET_EXPORT std::unique_ptr<base::DictionaryValue> GetNetInfo(
       cache_info_dict->SetInteger("capacity",
                                   static_cast<int>(cache->max_entries()));
 
+      HostCache::Counters counters = cache->GetCounters();
+      base::DictionaryValue* counters_dict = new base::DictionaryValue();
+      counters_dict->SetInteger("hits", static_cast<int>(counters.hits));
+      counters_dict->SetInteger("stale_hits",
+                                static_cast<int>(counters.stale_hits));
+      counters_dict->SetInteger("negative_hits",
+                                static_cast<int>(counters.negative_hits));
+      counters_dict->SetInteger("misses", static_cast<int>(counters.misses));
+      counters_dict->SetInteger("insertions",
+                                static_cast<int>(counters.insertions));
+      counters_dict->SetInteger("evictions",
+                                static_cast<int>(counters.evictions));
+      counters_dict->SetInteger("refreshes",
+                                static_cast<int>(counters.refreshes));
+      cache_info_dict->Set("counters", counters_dict);
+
       base::ListValue* entry_list = new base::ListValue();
 
-      for (const auto& pair : cache->entries()) {
+      for (const auto& pair : cache->GetEntries()) {
         const HostCache::Key& key = pair.first;
         const HostCache::Entry& entry = pair.second;
 
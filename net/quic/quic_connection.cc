@@ -1363,6 +1363,12 @@ void QuicConnection::ProcessUdpPacket(const IPEndPoint& self_address,
 void QuicConnection::OnCanWrite() {
   DCHECK(!writer_->IsWriteBlocked());
 
+  // Send the packets a batch mode writer held back while it was blocked.
+  FlushWriter();
+  if (writer_->IsWriteBlocked()) {
+    return;
+  }
+
   WriteQueuedPackets();
   WritePendingRetransmissions();
 
@@ -1649,6 +1655,14 @@ bool QuicConnection::WritePacket(SerializedPacket* packet) {
   WriteResult result = writer_->WritePacket(
       packet->encrypted_buffer, encrypted_length, self_address().address(),
       peer_address(), per_packet_options_);
+  if (result.status == WRITE_STATUS_OK && writer_->IsBatchMode() &&
+      !packet_generator_.InBatchMode()) {
+    // The packet is not part of a bundled burst, send it right away.
+    const WriteResult flush_result = writer_->Flush();
+    if (flush_result.status != WRITE_STATUS_OK) {
+      result = flush_result;
+    }
+  }
   if (result.error_code == ERR_IO_PENDING) {
     DCHECK_EQ(WRITE_STATUS_BLOCKED, result.status);
   }
@@ -1755,6 +1769,21 @@ bool QuicConnection::ShouldDiscardPacket(const SerializedPacket& packet) {
   return false;
 }
 
+void QuicConnection::FlushWriter() {
+  if (!writer_->IsBatchMode() || writer_->IsWriteBlocked()) {
+    return;
+  }
+  const WriteResult result = writer_->Flush();
+  if (!connected_) {
+    return;
+  }
+  if (result.status == WRITE_STATUS_BLOCKED) {
+    visitor_->OnWriteBlocked();
+  } else if (result.status == WRITE_STATUS_ERROR) {
+    OnWriteError(result.error_code);
+  }
+}
+
 void QuicConnection::OnWriteError(int error_code) {
   const string error_details = "Write failed with error: " +
                                base::IntToString(error_code) + " (" +
@@ -2284,6 +2313,8 @@ QuicConnection::ScopedPacketBundler::~ScopedPacketBundler() {
   if (!already_in_batch_mode_) {
     DVLOG(1) << "Leaving Batch Mode.";
     connection_->packet_generator_.FinishBatchOperations();
+    // Send the burst of packets written in batch mode.
+    connection_->FlushWriter();
   }
   DCHECK_EQ(already_in_batch_mode_,
             connection_->packet_generator_.InBatchMode());
@@ -771,6 +771,10 @@ class NET_EXPORT_PRIVATE QuicConnection
   // blocked when this is called.
   void WriteQueuedPackets();
 
+  // Makes a batch mode writer send the packets it holds back. Called when a
+  // burst of packets has been written.
+  void FlushWriter();
+
   // Writes as many pending retransmissions as possible.
   void WritePendingRetransmissions();
 
@@ -280,6 +280,8 @@ class TestPacketWriter : public QuicPacketWriter {
         write_should_fail_(false),
         block_on_next_write_(false),
         is_write_blocked_data_buffered_(false),
+        is_batch_mode_(false),
+        num_flushes_(0),
         final_bytes_of_last_packet_(0),
         final_bytes_of_previous_packet_(0),
         use_tagging_decrypter_(false),
@@ -344,6 +346,13 @@ class TestPacketWriter : public QuicPacketWriter {
     return max_packet_size_;
   }
 
+  bool IsBatchMode() const override { return is_batch_mode_; }
+
+  WriteResult Flush() override {
+    ++num_flushes_;
+    return WriteResult(WRITE_STATUS_OK, 0);
+  }
+
   void BlockOnNextWrite() { block_on_next_write_ = true; }
 
   // Sets the amount of time that the writer should before the actual write.
@@ -389,6 +398,10 @@ class TestPacketWriter : public QuicPacketWriter {
     is_write_blocked_data_buffered_ = buffered;
   }
 
+  void set_is_batch_mode(bool is_batch_mode) { is_batch_mode_ = is_batch_mode; }
+
+  size_t num_flushes() const { return num_flushes_; }
+
   void set_perspective(Perspective perspective) {
     // We invert perspective here, because the framer needs to parse packets
     // we send.
@@ -429,6 +442,8 @@ class TestPacketWriter : public QuicPacketWriter {
   bool write_should_fail_;
   bool block_on_next_write_;
   bool is_write_blocked_data_buffered_;
+  bool is_batch_mode_;
+  size_t num_flushes_;
   uint32_t final_bytes_of_last_packet_;
   uint32_t final_bytes_of_previous_packet_;
   bool use_tagging_decrypter_;
@@ -1814,6 +1829,25 @@ TEST_P(QuicConnectionTest, FramePacking) {
   EXPECT_EQ(kClientDataStreamId2, writer_->stream_frames()[1]->stream_id);
 }
 
+TEST_P(QuicConnectionTest, FlushBatchModeWriterAfterBurst) {
+  writer_->set_is_batch_mode(true);
+  {
+    EXPECT_CALL(*send_algorithm_, OnPacketSent(_, _, _, _, _)).Times(2);
+    QuicConnection::ScopedPacketBundler bundler(&connection_,
+                                                QuicConnection::SEND_ACK);
+    connection_.SendStreamData3();
+    connection_.SendCryptoStreamData();
+    // Both packets are held back until the end of the burst.
+    EXPECT_EQ(0u, writer_->num_flushes());
+  }
+  EXPECT_EQ(1u, writer_->num_flushes());
+
+  // A packet written outside of a bundler is flushed right away.
+  EXPECT_CALL(*send_algorithm_, OnPacketSent(_, _, _, _, _)).Times(1);
+  connection_.SendAck();
+  EXPECT_EQ(2u, writer_->num_flushes());
+}
+
 TEST_P(QuicConnectionTest, FramePackingNonCryptoThenCrypto) {
   // Send an ack and two stream frames (one non-crypto, then one crypto) in 2
   // packets by queueing them.
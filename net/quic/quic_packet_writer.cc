@@ -0,0 +1,33 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/quic/quic_packet_writer.h"
+
+namespace net {
+
+bool QuicPacketWriter::IsBatchMode() const {
+  return false;
+}
+
+WriteResult QuicPacketWriter::Flush() {
+  return WriteResult(WRITE_STATUS_OK, 0);
+}
+
+WriteResult QuicPacketWriter::WritePacketForOwner(
+    const QuicPacketWriter* owner,
+    const char* buffer,
+    size_t buf_len,
+    const IPAddress& self_address,
+    const IPEndPoint& peer_address,
+    PerPacketOptions* options) {
+  return WritePacket(buffer, buf_len, self_address, peer_address, options);
+}
+
+WriteResult QuicPacketWriter::FlushForOwner(const QuicPacketWriter* owner) {
+  return Flush();
+}
+
+void QuicPacketWriter::RemoveOwner(const QuicPacketWriter* owner) {}
+
+}  // namespace net
@@ -9,11 +9,11 @@
 
 #include "net/base/ip_endpoint.h"
 #include "net/quic/quic_protocol.h"
+#include "net/quic/quic_types.h"
 
 namespace net {
 
 class IPAddress;
-struct WriteResult;
 
 class NET_EXPORT_PRIVATE PerPacketOptions {
  public:
@@ -66,6 +66,35 @@ class NET_EXPORT_PRIVATE QuicPacketWriter {
   // size of a valid QUIC packet.
   virtual QuicByteCount GetMaxPacketSize(
       const IPEndPoint& peer_address) const = 0;
+
+  // Returns true if the writer may hold written packets back, in order to
+  // send several of them with a single system call. Such writers report held
+  // back packets as written, and send them when Flush() is called.
+  virtual bool IsBatchMode() const;
+
+  // Sends the packets held back by a batch mode writer. If some of them could
+  // not be sent, the result's status is WRITE_STATUS_BLOCKED or
+  // WRITE_STATUS_ERROR, as for WritePacket(). Otherwise it is WRITE_STATUS_OK
+  // and bytes_written is the total size of the packets sent.
+  virtual WriteResult Flush();
+
+  // The methods below are used by writers which wrap a shared batch mode
+  // writer for a single connection. |owner| is the wrapping writer. Errors
+  // sending the packets held back for |owner| are only reported to |owner|,
+  // by its next WritePacketForOwner() or FlushForOwner() call, so that a
+  // connection is not closed for another connection's failed packets.
+  // Blocked writes affect all owners. By default, |owner| is ignored.
+  virtual WriteResult WritePacketForOwner(const QuicPacketWriter* owner,
+                                          const char* buffer,
+                                          size_t buf_len,
+                                          const IPAddress& self_address,
+                                          const IPEndPoint& peer_address,
+                                          PerPacketOptions* options);
+  virtual WriteResult FlushForOwner(const QuicPacketWriter* owner);
+
+  // Must be called before |owner| is destroyed. Its held back packets are
+  // still sent, but errors are no longer reported to it.
+  virtual void RemoveOwner(const QuicPacketWriter* owner);
 };
 
 }  // namespace net
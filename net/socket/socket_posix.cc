@@ -272,6 +272,41 @@ int SocketPosix::Write(IOBuffer* buf,
   return rv;
 }
 
+int SocketPosix::WriteGather(IOBuffer* const* bufs,
+                             const int* buf_lens,
+                             int num_bufs,
+                             const CompletionCallback& callback) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_fd_);
+  DCHECK(!waiting_connect_);
+  CHECK(write_callback_.is_null());
+  // Synchronous operation not supported
+  DCHECK(!callback.is_null());
+  DCHECK_LT(0, num_bufs);
+
+  std::vector<iovec> iovecs(num_bufs);
+  for (int i = 0; i < num_bufs; ++i) {
+    DCHECK_LT(0, buf_lens[i]);
+    iovecs[i].iov_base = bufs[i]->data();
+    iovecs[i].iov_len = buf_lens[i];
+  }
+  int rv = DoWriteGather(iovecs);
+  if (rv != ERR_IO_PENDING)
+    return rv;
+
+  if (!base::MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_fd_, true, base::MessageLoopForIO::WATCH_WRITE,
+          &write_socket_watcher_, this)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on write, errno " << errno;
+    return MapSystemError(errno);
+  }
+
+  write_gather_bufs_.assign(bufs, bufs + num_bufs);
+  write_iovecs_.swap(iovecs);
+  write_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
 int SocketPosix::WaitForWrite(IOBuffer* buf,
                               int buf_len,
                               const CompletionCallback& callback) {
@@ -454,8 +489,22 @@ int SocketPosix::DoWrite(IOBuffer* buf, int buf_len) {
   return rv >= 0 ? rv : MapSystemError(errno);
 }
 
+int SocketPosix::DoWriteGather(const std::vector<iovec>& iovecs) {
+  msghdr msg = {};
+  msg.msg_iov = const_cast<iovec*>(iovecs.data());
+  msg.msg_iovlen = iovecs.size();
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // See DoWrite() for MSG_NOSIGNAL.
+  int rv = HANDLE_EINTR(sendmsg(socket_fd_, &msg, MSG_NOSIGNAL));
+#else
+  int rv = HANDLE_EINTR(sendmsg(socket_fd_, &msg, 0));
+#endif
+  return rv >= 0 ? rv : MapSystemError(errno);
+}
+
 void SocketPosix::WriteCompleted() {
-  int rv = DoWrite(write_buf_.get(), write_buf_len_);
+  int rv = write_iovecs_.empty() ? DoWrite(write_buf_.get(), write_buf_len_)
+                                 : DoWriteGather(write_iovecs_);
   if (rv == ERR_IO_PENDING)
     return;
 
@@ -463,6 +512,8 @@ void SocketPosix::WriteCompleted() {
   DCHECK(ok);
   write_buf_ = NULL;
   write_buf_len_ = 0;
+  write_gather_bufs_.clear();
+  write_iovecs_.clear();
   base::ResetAndReturn(&write_callback_).Run(rv);
 }
 
@@ -488,6 +539,8 @@ void SocketPosix::StopWatchingAndCleanUp() {
   if (!write_callback_.is_null()) {
     write_buf_ = NULL;
     write_buf_len_ = 0;
+    write_gather_bufs_.clear();
+    write_iovecs_.clear();
     write_callback_.Reset();
   }
 
@@ -5,7 +5,10 @@
 #ifndef NET_SOCKET_SOCKET_POSIX_H_
 #define NET_SOCKET_SOCKET_POSIX_H_
 
+#include <sys/uio.h>
+
 #include <memory>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
@@ -60,6 +63,12 @@ class NET_EXPORT_PRIVATE SocketPosix : public base::MessageLoopForIO::Watcher {
   // TODO(byungchul): Need more robust way to pass system errno.
   int Read(IOBuffer* buf, int buf_len, const CompletionCallback& callback);
   int Write(IOBuffer* buf, int buf_len, const CompletionCallback& callback);
+  // Writes the |num_bufs| buffers in |bufs| with a single system call. See
+  // StreamSocket::WriteGather().
+  int WriteGather(IOBuffer* const* bufs,
+                  const int* buf_lens,
+                  int num_bufs,
+                  const CompletionCallback& callback);
 
   // Waits for next write event. This is called by TCPSocketPosix for TCP
   // fastopen after sending first data. Returns ERR_IO_PENDING if it starts
@@ -98,6 +107,7 @@ class NET_EXPORT_PRIVATE SocketPosix : public base::MessageLoopForIO::Watcher {
   void ReadCompleted();
 
   int DoWrite(IOBuffer* buf, int buf_len);
+  int DoWriteGather(const std::vector<iovec>& iovecs);
   void WriteCompleted();
 
   void StopWatchingAndCleanUp();
@@ -117,6 +127,9 @@ class NET_EXPORT_PRIVATE SocketPosix : public base::MessageLoopForIO::Watcher {
   base::MessageLoopForIO::FileDescriptorWatcher write_socket_watcher_;
   scoped_refptr<IOBuffer> write_buf_;
   int write_buf_len_;
+  // Buffers of a pending WriteGather(), and the iovecs pointing into them.
+  std::vector<scoped_refptr<IOBuffer>> write_gather_bufs_;
+  std::vector<iovec> write_iovecs_;
   // External callback; called when write or connect is complete.
   CompletionCallback write_callback_;
 
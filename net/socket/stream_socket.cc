@@ -4,13 +4,37 @@
 
 #include "net/socket/stream_socket.h"
 
+#include <string.h>
+
+#include "base/logging.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/values.h"
+#include "net/base/io_buffer.h"
 
 namespace net {
 
+int StreamSocket::WriteGather(IOBuffer* const* bufs,
+                              const int* buf_lens,
+                              int num_bufs,
+                              const CompletionCallback& callback) {
+  DCHECK_LT(0, num_bufs);
+  if (num_bufs == 1)
+    return Write(bufs[0], buf_lens[0], callback);
+
+  int total_len = 0;
+  for (int i = 0; i < num_bufs; ++i)
+    total_len += buf_lens[i];
+  scoped_refptr<IOBuffer> buf(new IOBuffer(total_len));
+  int offset = 0;
+  for (int i = 0; i < num_bufs; ++i) {
+    memcpy(buf->data() + offset, bufs[i]->data(), buf_lens[i]);
+    offset += buf_lens[i];
+  }
+  return Write(buf.get(), total_len, callback);
+}
+
 StreamSocket::UseHistory::UseHistory()
     : was_ever_connected_(false),
       was_used_to_convey_data_(false),
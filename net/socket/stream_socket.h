@@ -110,6 +110,17 @@ class NET_EXPORT_PRIVATE StreamSocket : public Socket {
   // Disconnect() is called.
   virtual int64_t GetTotalReceivedBytes() const = 0;
 
+  // Writes data gathered from the |num_bufs| buffers in |bufs|, up to
+  // |buf_lens[i]| bytes from |bufs[i]|, as if they were concatenated and passed
+  // to Write(). The same rules as for Write() apply; in particular, data may be
+  // written partially. The default implementation copies the buffers into a
+  // single one and calls Write(). Sockets which can pass the buffers on to the
+  // OS without copying them override it.
+  virtual int WriteGather(IOBuffer* const* bufs,
+                          const int* buf_lens,
+                          int num_bufs,
+                          const CompletionCallback& callback);
+
  protected:
   // The following class is only used to gather statistics about the history of
   // a socket.  It is only instantiated and used in basic sockets, such as
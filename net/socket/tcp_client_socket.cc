@@ -11,6 +11,7 @@
 #include "base/metrics/histogram_macros.h"
 #include "base/profiler/scoped_tracker.h"
 #include "base/time/time.h"
+#include "build/build_config.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
@@ -335,6 +336,26 @@ int64_t TCPClientSocket::GetTotalReceivedBytes() const {
   return total_received_bytes_;
 }
 
+int TCPClientSocket::WriteGather(IOBuffer* const* bufs,
+                                 const int* buf_lens,
+                                 int num_bufs,
+                                 const CompletionCallback& callback) {
+#if defined(OS_POSIX)
+  DCHECK(!callback.is_null());
+
+  // See Write().
+  CompletionCallback write_callback = base::Bind(
+      &TCPClientSocket::DidCompleteWrite, base::Unretained(this), callback);
+  int result = socket_->WriteGather(bufs, buf_lens, num_bufs, write_callback);
+  if (result > 0)
+    use_history_.set_was_used_to_convey_data();
+
+  return result;
+#else
+  return StreamSocket::WriteGather(bufs, buf_lens, num_bufs, callback);
+#endif
+}
+
 void TCPClientSocket::DidCompleteConnect(int result) {
   DCHECK_EQ(next_connect_state_, CONNECT_STATE_CONNECT_COMPLETE);
   DCHECK_NE(result, ERR_IO_PENDING);
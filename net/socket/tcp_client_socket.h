@@ -80,6 +80,10 @@ class NET_EXPORT TCPClientSocket : public StreamSocket {
   void ClearConnectionAttempts() override;
   void AddConnectionAttempts(const ConnectionAttempts& attempts) override;
   int64_t GetTotalReceivedBytes() const override;
+  int WriteGather(IOBuffer* const* bufs,
+                  const int* buf_lens,
+                  int num_bufs,
+                  const CompletionCallback& callback) override;
 
  private:
   // State machine for connecting the socket.
@@ -6,8 +6,11 @@
 
 #include <errno.h>
 #include <netinet/tcp.h>
+#include <string.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
@@ -312,6 +315,38 @@ int TCPSocketPosix::Write(IOBuffer* buf,
   return rv;
 }
 
+int TCPSocketPosix::WriteGather(IOBuffer* const* bufs,
+                                const int* buf_lens,
+                                int num_bufs,
+                                const CompletionCallback& callback) {
+  DCHECK(socket_);
+  DCHECK(!callback.is_null());
+  DCHECK_LT(0, num_bufs);
+
+  if (use_tcp_fastopen_ && !tcp_fastopen_write_attempted_) {
+    // The first write carries the connect request, and can't be gathered.
+    int total_len = 0;
+    for (int i = 0; i < num_bufs; ++i)
+      total_len += buf_lens[i];
+    scoped_refptr<IOBuffer> buf(new IOBuffer(total_len));
+    int offset = 0;
+    for (int i = 0; i < num_bufs; ++i) {
+      memcpy(buf->data() + offset, bufs[i]->data(), buf_lens[i]);
+      offset += buf_lens[i];
+    }
+    return Write(buf.get(), total_len, callback);
+  }
+
+  CompletionCallback write_callback = base::Bind(
+      &TCPSocketPosix::WriteGatherCompleted, base::Unretained(this),
+      std::vector<scoped_refptr<IOBuffer>>(bufs, bufs + num_bufs),
+      std::vector<int>(buf_lens, buf_lens + num_bufs), callback);
+  int rv = socket_->WriteGather(bufs, buf_lens, num_bufs, write_callback);
+  if (rv != ERR_IO_PENDING)
+    rv = HandleWriteGatherCompleted(bufs, buf_lens, num_bufs, rv);
+  return rv;
+}
+
 int TCPSocketPosix::GetLocalAddress(IPEndPoint* address) const {
   DCHECK(address);
 
@@ -631,6 +666,27 @@ void TCPSocketPosix::WriteCompleted(const scoped_refptr<IOBuffer>& buf,
 }
 
 int TCPSocketPosix::HandleWriteCompleted(IOBuffer* buf, int rv) {
+  // At most |rv| bytes of |buf| are logged.
+  return HandleWriteGatherCompleted(&buf, &rv, 1, rv);
+}
+
+void TCPSocketPosix::WriteGatherCompleted(
+    const std::vector<scoped_refptr<IOBuffer>>& bufs,
+    const std::vector<int>& buf_lens,
+    const CompletionCallback& callback,
+    int rv) {
+  DCHECK_NE(ERR_IO_PENDING, rv);
+  std::vector<IOBuffer*> raw_bufs;
+  for (const scoped_refptr<IOBuffer>& buf : bufs)
+    raw_bufs.push_back(buf.get());
+  callback.Run(HandleWriteGatherCompleted(raw_bufs.data(), buf_lens.data(),
+                                          static_cast<int>(bufs.size()), rv));
+}
+
+int TCPSocketPosix::HandleWriteGatherCompleted(IOBuffer* const* bufs,
+                                               const int* buf_lens,
+                                               int num_bufs,
+                                               int rv) {
   if (rv < 0) {
     if (tcp_fastopen_write_attempted_ && !tcp_fastopen_connected_) {
       // TCP FastOpen connect-with-write was attempted, and the write failed
@@ -652,8 +708,15 @@ int TCPSocketPosix::HandleWriteCompleted(IOBuffer* buf, int rv) {
   if (rv > 0)
     NotifySocketPerformanceWatcher();
 
-  net_log_.AddByteTransferEvent(NetLog::TYPE_SOCKET_BYTES_SENT, rv,
-                                buf->data());
+  // Logs the bytes sent from each buffer separately.
+  int bytes_to_log = rv;
+  int i = 0;
+  do {
+    const int len = std::min(buf_lens[i], bytes_to_log);
+    net_log_.AddByteTransferEvent(NetLog::TYPE_SOCKET_BYTES_SENT, len,
+                                  bufs[i]->data());
+    bytes_to_log -= len;
+  } while (bytes_to_log > 0 && ++i < num_bufs);
   NetworkActivityMonitor::GetInstance()->IncrementBytesSent(rv);
   return rv;
 }
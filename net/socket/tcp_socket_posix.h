@@ -8,10 +8,12 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/time/time.h"
 #include "net/base/address_family.h"
 #include "net/base/completion_callback.h"
@@ -59,6 +61,11 @@ class NET_EXPORT TCPSocketPosix {
   // Full duplex mode (reading and writing at the same time) is supported.
   int Read(IOBuffer* buf, int buf_len, const CompletionCallback& callback);
   int Write(IOBuffer* buf, int buf_len, const CompletionCallback& callback);
+  // See StreamSocket::WriteGather().
+  int WriteGather(IOBuffer* const* bufs,
+                  const int* buf_lens,
+                  int num_bufs,
+                  const CompletionCallback& callback);
 
   int GetLocalAddress(IPEndPoint* address) const;
   int GetPeerAddress(IPEndPoint* address) const;
@@ -204,6 +211,14 @@ class NET_EXPORT TCPSocketPosix {
                       const CompletionCallback& callback,
                       int rv);
   int HandleWriteCompleted(IOBuffer* buf, int rv);
+  void WriteGatherCompleted(const std::vector<scoped_refptr<IOBuffer>>& bufs,
+                            const std::vector<int>& buf_lens,
+                            const CompletionCallback& callback,
+                            int rv);
+  int HandleWriteGatherCompleted(IOBuffer* const* bufs,
+                                 const int* buf_lens,
+                                 int num_bufs,
+                                 int rv);
   int TcpFastOpenWrite(IOBuffer* buf,
                        int buf_len,
                        const CompletionCallback& callback);
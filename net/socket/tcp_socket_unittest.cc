@@ -385,6 +385,62 @@ TEST_F(TCPSocketTest, ReadWrite) {
   ASSERT_EQ(message, received_message);
 }
 
+#if defined(OS_POSIX)
+TEST_F(TCPSocketTest, WriteGather) {
+  ASSERT_NO_FATAL_FAILURE(SetUpListenIPv4());
+
+  TestCompletionCallback connect_callback;
+  TCPSocket connecting_socket(NULL, NULL, NetLog::Source());
+  int result = connecting_socket.Open(ADDRESS_FAMILY_IPV4);
+  ASSERT_EQ(OK, result);
+  connecting_socket.Connect(local_address_, connect_callback.callback());
+
+  TestCompletionCallback accept_callback;
+  std::unique_ptr<TCPSocket> accepted_socket;
+  IPEndPoint accepted_address;
+  result = socket_.Accept(&accepted_socket, &accepted_address,
+                          accept_callback.callback());
+  ASSERT_EQ(OK, accept_callback.GetResult(result));
+  ASSERT_TRUE(accepted_socket.get());
+  EXPECT_EQ(OK, connect_callback.WaitForResult());
+
+  const std::string pieces[] = {"test ", "gathered ", "message"};
+  std::vector<scoped_refptr<IOBuffer>> write_buffers;
+  std::vector<IOBuffer*> raw_write_buffers;
+  std::vector<int> write_sizes;
+  for (const std::string& piece : pieces) {
+    write_buffers.push_back(new StringIOBuffer(piece));
+    raw_write_buffers.push_back(write_buffers.back().get());
+    write_sizes.push_back(static_cast<int>(piece.size()));
+  }
+  const std::string message = pieces[0] + pieces[1] + pieces[2];
+
+  // A single system call writes the whole message to a loopback socket.
+  TestCompletionCallback write_callback;
+  int write_result = accepted_socket->WriteGather(
+      raw_write_buffers.data(), write_sizes.data(),
+      static_cast<int>(write_sizes.size()), write_callback.callback());
+  EXPECT_EQ(static_cast<int>(message.size()),
+            write_callback.GetResult(write_result));
+
+  std::vector<char> buffer(message.size());
+  size_t bytes_read = 0;
+  while (bytes_read < message.size()) {
+    scoped_refptr<IOBufferWithSize> read_buffer(
+        new IOBufferWithSize(message.size() - bytes_read));
+    TestCompletionCallback read_callback;
+    int read_result = connecting_socket.Read(
+        read_buffer.get(), read_buffer->size(), read_callback.callback());
+    read_result = read_callback.GetResult(read_result);
+    ASSERT_GT(read_result, 0);
+    memmove(&buffer[bytes_read], read_buffer->data(), read_result);
+    bytes_read += read_result;
+  }
+
+  EXPECT_EQ(message, std::string(buffer.begin(), buffer.end()));
+}
+#endif  // defined(OS_POSIX)
+
 // These tests require kernel support for tcp_info struct, and so they are
 // enabled only on certain platforms.
 #if defined(TCP_INFO) || defined(OS_LINUX)
@@ -473,12 +473,26 @@ SpdySerializedFrame* BufferedSpdyFramer::CreateDataFrame(SpdyStreamId stream_id,
                                                          const char* data,
                                                          uint32_t len,
                                                          SpdyDataFlags flags) {
-  SpdyDataIR data_ir(stream_id,
-                     base::StringPiece(data, len));
+  // The data is copied into the frame, so there is no need for |data_ir| to
+  // hold a copy too.
+  SpdyDataIR data_ir(stream_id);
+  data_ir.SetDataShallow(base::StringPiece(data, len));
   data_ir.set_fin((flags & DATA_FLAG_FIN) != 0);
   return new SpdySerializedFrame(spdy_framer_.SerializeData(data_ir));
 }
 
+SpdySerializedFrame* BufferedSpdyFramer::CreateDataFrameHeader(
+    SpdyStreamId stream_id,
+    const char* data,
+    uint32_t len,
+    SpdyDataFlags flags) {
+  SpdyDataIR data_ir(stream_id);
+  data_ir.SetDataShallow(base::StringPiece(data, len));
+  data_ir.set_fin((flags & DATA_FLAG_FIN) != 0);
+  return new SpdySerializedFrame(
+      spdy_framer_.SerializeDataFrameHeaderWithPaddingLengthField(data_ir));
+}
+
 // TODO(jgraettinger): Eliminate uses of this method (prefer SpdyPushPromiseIR).
 SpdySerializedFrame* BufferedSpdyFramer::CreatePushPromise(
     SpdyStreamId stream_id,
@@ -236,6 +236,12 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer
                                        const char* data,
                                        uint32_t len,
                                        SpdyDataFlags flags);
+  // Like CreateDataFrame(), but serializes only the frame header. The |len|
+  // bytes of payload at |data| are meant to be sent right after it.
+  SpdySerializedFrame* CreateDataFrameHeader(SpdyStreamId stream_id,
+                                             const char* data,
+                                             uint32_t len,
+                                             SpdyDataFlags flags);
   SpdySerializedFrame* CreatePushPromise(SpdyStreamId stream_id,
                                          SpdyStreamId promised_stream_id,
                                          const SpdyHeaderBlock* headers);
@@ -57,8 +57,31 @@ class SpdyBuffer::SharedFrameIOBuffer : public IOBuffer {
   DISALLOW_COPY_AND_ASSIGN(SharedFrameIOBuffer);
 };
 
+// This class is an IOBuffer implementation that holds a reference to
+// the payload of a SpdyBuffer and points into it. Used by
+// SpdyBuffer::GetIOBufferForRemainingData() and
+// SpdyBuffer::GetIOBuffersForRemainingData().
+class SpdyBuffer::PayloadIOBuffer : public IOBuffer {
+ public:
+  PayloadIOBuffer(const scoped_refptr<IOBuffer>& payload, const char* data)
+      : IOBuffer(const_cast<char*>(data)), payload_(payload) {}
+
+ private:
+  ~PayloadIOBuffer() override {
+    // Prevent ~IOBuffer() from trying to delete |data_|.
+    data_ = NULL;
+  }
+
+  const scoped_refptr<IOBuffer> payload_;
+
+  DISALLOW_COPY_AND_ASSIGN(PayloadIOBuffer);
+};
+
 SpdyBuffer::SpdyBuffer(std::unique_ptr<SpdySerializedFrame> frame)
-    : shared_frame_(new SharedFrame()), offset_(0) {
+    : shared_frame_(new SharedFrame()),
+      payload_data_(NULL),
+      payload_size_(0),
+      offset_(0) {
   shared_frame_->data = std::move(frame);
 }
 
@@ -66,23 +89,42 @@ SpdyBuffer::SpdyBuffer(std::unique_ptr<SpdySerializedFrame> frame)
 // |frame_| just as a container.
 SpdyBuffer::SpdyBuffer(const char* data, size_t size) :
     shared_frame_(new SharedFrame()),
+    payload_data_(NULL),
+    payload_size_(0),
     offset_(0) {
   CHECK_GT(size, 0u);
   CHECK_LE(size, kMaxSpdyFrameSize);
   shared_frame_->data = MakeSpdySerializedFrame(data, size);
 }
 
+SpdyBuffer::SpdyBuffer(std::unique_ptr<SpdySerializedFrame> header,
+                       IOBuffer* payload,
+                       size_t payload_size)
+    : shared_frame_(new SharedFrame()),
+      payload_(payload),
+      payload_data_(payload->data()),
+      payload_size_(payload_size),
+      offset_(0) {
+  CHECK_GT(header->size(), 0u);
+  CHECK_LE(header->size() + payload_size, kMaxSpdyFrameSize);
+  shared_frame_->data = std::move(header);
+}
+
 SpdyBuffer::~SpdyBuffer() {
   if (GetRemainingSize() > 0)
     ConsumeHelper(GetRemainingSize(), DISCARD);
 }
 
 const char* SpdyBuffer::GetRemainingData() const {
+  const size_t frame_size = GetFrameSize();
+  if (offset_ >= frame_size && payload_size_ > 0)
+    return payload_data_ + (offset_ - frame_size);
+  DCHECK_EQ(0u, payload_size_);
   return shared_frame_->data->data() + offset_;
 }
 
 size_t SpdyBuffer::GetRemainingSize() const {
-  return shared_frame_->data->size() - offset_;
+  return GetFrameSize() + payload_size_ - offset_;
 }
 
 void SpdyBuffer::AddConsumeCallback(const ConsumeCallback& consume_callback) {
@@ -94,9 +136,36 @@ void SpdyBuffer::Consume(size_t consume_size) {
 };
 
 IOBuffer* SpdyBuffer::GetIOBufferForRemainingData() {
+  const size_t frame_size = GetFrameSize();
+  if (offset_ >= frame_size && payload_size_ > 0)
+    return new PayloadIOBuffer(payload_, GetRemainingData());
+  DCHECK_EQ(0u, payload_size_);
   return new SharedFrameIOBuffer(shared_frame_, offset_);
 }
 
+void SpdyBuffer::GetIOBuffersForRemainingData(
+    std::vector<scoped_refptr<IOBuffer>>* buffers,
+    std::vector<int>* sizes) {
+  const size_t frame_size = GetFrameSize();
+  if (offset_ < frame_size) {
+    buffers->push_back(new SharedFrameIOBuffer(shared_frame_, offset_));
+    sizes->push_back(static_cast<int>(frame_size - offset_));
+  }
+  if (payload_size_ > 0) {
+    const size_t payload_offset =
+        offset_ > frame_size ? offset_ - frame_size : 0;
+    if (payload_offset < payload_size_) {
+      buffers->push_back(
+          new PayloadIOBuffer(payload_, payload_data_ + payload_offset));
+      sizes->push_back(static_cast<int>(payload_size_ - payload_offset));
+    }
+  }
+}
+
+size_t SpdyBuffer::GetFrameSize() const {
+  return shared_frame_->data->size();
+}
+
 void SpdyBuffer::ConsumeHelper(size_t consume_size,
                                ConsumeSource consume_source) {
   DCHECK_GE(consume_size, 1u);
@@ -24,6 +24,10 @@ class SpdySerializedFrame;
 // ref-counted and will include a way to get notified when Consume()
 // is called.
 //
+// The data of a DATA frame to be written may be split in two: the
+// serialized frame header, and a payload which is referenced rather
+// than copied.
+//
 // NOTE(akalin): This explicitly does not inherit from IOBuffer to
 // avoid the needless ref-counting and to avoid working around the
 // fact that IOBuffer member functions are not virtual.
@@ -53,11 +57,22 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   // non-NULL and |size| must be non-zero.
   SpdyBuffer(const char* data, size_t size);
 
+  // Construct with the frame header in |header| followed by the
+  // |payload_size| bytes at |payload->data()|, which are not copied.
+  // A reference to |payload| is kept, and the bytes must not change
+  // until they have been consumed. Note that |payload->data()| is read
+  // once, here.
+  SpdyBuffer(std::unique_ptr<SpdySerializedFrame> header,
+             IOBuffer* payload,
+             size_t payload_size);
+
   // If there are bytes remaining in the buffer, triggers a call to
   // any consume callbacks with a DISCARD source.
   ~SpdyBuffer();
 
-  // Returns the remaining (unconsumed) data.
+  // Returns the remaining (unconsumed) data. Must not be called while
+  // both the frame header and the payload of a buffer constructed with
+  // a separate payload remain.
   const char* GetRemainingData() const;
 
   // Returns the number of remaining (unconsumed) bytes.
@@ -81,8 +96,19 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
   // This is used with Socket::Write(), which takes an IOBuffer* that
   // may be written to even after the socket itself is destroyed. (See
   // http://crbug.com/249725 .)
+  //
+  // Like GetRemainingData(), must not be called while the remaining
+  // data isn't contiguous.
   IOBuffer* GetIOBufferForRemainingData();
 
+  // Like GetIOBufferForRemainingData(), but also works while the
+  // remaining data isn't contiguous: appends IOBuffers pointing to the
+  // successive pieces of the remaining data to |buffers|, and their
+  // sizes to |sizes|. Meant to be used with StreamSocket::WriteGather().
+  void GetIOBuffersForRemainingData(
+      std::vector<scoped_refptr<IOBuffer>>* buffers,
+      std::vector<int>* sizes);
+
  private:
   void ConsumeHelper(size_t consume_size, ConsumeSource consume_source);
 
@@ -92,8 +118,16 @@ class NET_EXPORT_PRIVATE SpdyBuffer {
       SharedFrame;
 
   class SharedFrameIOBuffer;
+  class PayloadIOBuffer;
+
+  // Size of the data held in |shared_frame_|.
+  size_t GetFrameSize() const;
 
   const scoped_refptr<SharedFrame> shared_frame_;
+  // Payload following the frame header in |shared_frame_|, if any.
+  const scoped_refptr<IOBuffer> payload_;
+  const char* const payload_data_;
+  const size_t payload_size_;
   std::vector<ConsumeCallback> consume_callbacks_;
   size_t offset_;
 
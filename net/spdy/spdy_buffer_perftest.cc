@@ -0,0 +1,119 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/spdy/spdy_buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+#include "net/base/io_buffer.h"
+#include "net/spdy/buffered_spdy_framer.h"
+#include "net/spdy/spdy_protocol.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+
+namespace {
+
+const int kUploadSize = 64 * 1024 * 1024;
+const int kMaxFrameChunkSize = 16 * 1024;
+
+// Sends a kUploadSize bytes upload in DATA frames the way SpdySession does,
+// and reports the number of payload bytes copied by the SPDY layer per
+// payload byte sent. Payload bytes written to the socket straight from the
+// upload buffer count as not copied. The socket is simulated by a copy into
+// a send buffer, as done by the kernel.
+class SpdyBufferPerfTest : public ::testing::Test {
+ protected:
+  SpdyBufferPerfTest()
+      : framer_(HTTP2),
+        upload_buffer_(new IOBufferWithSize(kUploadSize)),
+        send_buffer_(kMaxFrameChunkSize + framer_.GetFrameMinimumSize()) {
+    memset(upload_buffer_->data(), 'x', kUploadSize);
+  }
+
+  // Creates the SpdyBuffer for the DATA frame carrying the |len| bytes of
+  // |data|, by copying them into a serialized frame if |copy| is true, or by
+  // referencing them.
+  std::unique_ptr<SpdyBuffer> CreateDataBuffer(DrainableIOBuffer* data,
+                                               int len,
+                                               bool copy) {
+    if (copy) {
+      std::unique_ptr<SpdySerializedFrame> frame(framer_.CreateDataFrame(
+          1, data->data(), static_cast<uint32_t>(len), DATA_FLAG_NONE));
+      return std::unique_ptr<SpdyBuffer>(new SpdyBuffer(std::move(frame)));
+    }
+    std::unique_ptr<SpdySerializedFrame> header(framer_.CreateDataFrameHeader(
+        1, data->data(), static_cast<uint32_t>(len), DATA_FLAG_NONE));
+    return std::unique_ptr<SpdyBuffer>(
+        new SpdyBuffer(std::move(header), data, len));
+  }
+
+  void RunTest(const std::string& trace, bool copy) {
+    scoped_refptr<DrainableIOBuffer> data(
+        new DrainableIOBuffer(upload_buffer_.get(), kUploadSize));
+    const char* const upload_begin = upload_buffer_->data();
+    const char* const upload_end = upload_begin + kUploadSize;
+    int64_t payload_bytes_sent = 0;
+    int64_t payload_bytes_uncopied = 0;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (data->BytesRemaining() > 0) {
+      const int len = std::min(data->BytesRemaining(), kMaxFrameChunkSize);
+      std::unique_ptr<SpdyBuffer> buffer(CreateDataBuffer(data.get(), len,
+                                                          copy));
+      std::vector<scoped_refptr<IOBuffer>> io_buffers;
+      std::vector<int> sizes;
+      buffer->GetIOBuffersForRemainingData(&io_buffers, &sizes);
+      size_t offset = 0;
+      for (size_t i = 0; i < io_buffers.size(); ++i) {
+        const char* piece = io_buffers[i]->data();
+        memcpy(&send_buffer_[offset], piece, sizes[i]);
+        offset += sizes[i];
+        if (piece >= upload_begin && piece < upload_end)
+          payload_bytes_uncopied += sizes[i];
+      }
+      buffer->Consume(buffer->GetRemainingSize());
+      payload_bytes_sent += len;
+      data->DidConsume(len);
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    EXPECT_EQ(kUploadSize, payload_bytes_sent);
+    perf_test::PrintResult(
+        "bytes_copied_per_byte_sent", "", trace,
+        static_cast<double>(payload_bytes_sent - payload_bytes_uncopied) /
+            payload_bytes_sent,
+        "bytes", true);
+    perf_test::PrintResult("data_frame_throughput", "", trace,
+                           kUploadSize / elapsed.InSecondsF() / (1 << 20),
+                           "MB/s", true);
+  }
+
+  BufferedSpdyFramer framer_;
+  scoped_refptr<IOBufferWithSize> upload_buffer_;
+  std::vector<char> send_buffer_;
+};
+
+TEST_F(SpdyBufferPerfTest, CopiedPayload) {
+  RunTest("copied_payload", true);
+}
+
+TEST_F(SpdyBufferPerfTest, ReferencedPayload) {
+  RunTest("referenced_payload", false);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/memory/ref_counted.h"
@@ -130,6 +131,83 @@ TEST_F(SpdyBufferTest, IOBufferForRemainingDataOutlivesBuffer) {
   std::memcpy(io_buffer->data(), kData, kDataSize);
 }
 
+// Make a string from the pieces of data remaining in |buffer|.
+std::string BufferPiecesToString(SpdyBuffer* buffer,
+                                 size_t* num_pieces) {
+  std::vector<scoped_refptr<IOBuffer>> io_buffers;
+  std::vector<int> sizes;
+  buffer->GetIOBuffersForRemainingData(&io_buffers, &sizes);
+  EXPECT_EQ(io_buffers.size(), sizes.size());
+  std::string data;
+  for (size_t i = 0; i < io_buffers.size(); ++i)
+    data.append(io_buffers[i]->data(), sizes[i]);
+  *num_pieces = io_buffers.size();
+  return data;
+}
+
+// Construct a SpdyBuffer from a frame header and a payload and make
+// sure the payload isn't copied, even once it is partly consumed.
+TEST_F(SpdyBufferTest, HeaderAndPayloadConstructor) {
+  const char kHeader[] = "head";
+  const size_t kHeaderSize = 4;
+  scoped_refptr<DrainableIOBuffer> payload(new DrainableIOBuffer(
+      new WrappedIOBuffer(kData), kDataSize));
+  SpdyBuffer buffer(
+      std::unique_ptr<SpdySerializedFrame>(new SpdySerializedFrame(
+          const_cast<char*>(kHeader), kHeaderSize, false /* owns_buffer */)),
+      payload.get(), kDataSize);
+  // Draining |payload| mustn't affect |buffer|.
+  payload->DidConsume(2);
+
+  EXPECT_EQ(kHeaderSize + kDataSize, buffer.GetRemainingSize());
+  size_t num_pieces = 0;
+  EXPECT_EQ(std::string(kHeader, kHeaderSize) + std::string(kData, kDataSize),
+            BufferPiecesToString(&buffer, &num_pieces));
+  EXPECT_EQ(2u, num_pieces);
+
+  buffer.Consume(2);
+  EXPECT_EQ(std::string(kHeader + 2, kHeaderSize - 2) +
+                std::string(kData, kDataSize),
+            BufferPiecesToString(&buffer, &num_pieces));
+  EXPECT_EQ(2u, num_pieces);
+
+  // Once the header is consumed, the remaining data is contiguous.
+  buffer.Consume(kHeaderSize - 2 + 5);
+  EXPECT_EQ(kData + 5, buffer.GetRemainingData());
+  EXPECT_EQ(kDataSize - 5, buffer.GetRemainingSize());
+  scoped_refptr<IOBuffer> io_buffer = buffer.GetIOBufferForRemainingData();
+  EXPECT_EQ(kData + 5, io_buffer->data());
+  EXPECT_EQ(std::string(kData + 5, kDataSize - 5),
+            BufferPiecesToString(&buffer, &num_pieces));
+  EXPECT_EQ(1u, num_pieces);
+
+  buffer.Consume(kDataSize - 5);
+  EXPECT_EQ(0u, buffer.GetRemainingSize());
+  EXPECT_EQ(std::string(), BufferPiecesToString(&buffer, &num_pieces));
+  EXPECT_EQ(0u, num_pieces);
+}
+
+// Make sure the IOBuffers returned by GetIOBuffersForRemainingData()
+// keep the payload alive.
+TEST_F(SpdyBufferTest, IOBuffersForRemainingDataOutliveBuffer) {
+  scoped_refptr<IOBuffer> payload(new IOBuffer(kDataSize));
+  std::unique_ptr<SpdyBuffer> buffer(new SpdyBuffer(
+      std::unique_ptr<SpdySerializedFrame>(new SpdySerializedFrame(
+          const_cast<char*>(kData), kDataSize, false /* owns_buffer */)),
+      payload.get(), kDataSize));
+  payload = nullptr;
+
+  std::vector<scoped_refptr<IOBuffer>> io_buffers;
+  std::vector<int> sizes;
+  buffer->GetIOBuffersForRemainingData(&io_buffers, &sizes);
+  ASSERT_EQ(2u, io_buffers.size());
+  buffer.reset();
+
+  // This will cause a use-after-free error if |io_buffers[1]| doesn't
+  // keep the payload alive.
+  std::memcpy(io_buffers[1]->data(), kData, kDataSize);
+}
+
 }  // namespace
 
 }  // namespace net
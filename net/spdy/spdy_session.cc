@@ -8,6 +8,7 @@
 #include <limits>
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
@@ -1240,14 +1241,16 @@ std::unique_ptr<SpdyBuffer> SpdySession::CreateDataBuffer(
   if (effective_len > 0)
     SendPrefacePingIfNoneInFlight();
 
-  // TODO(mbelshe): reduce memory copies here.
+  // Only the frame header is serialized. The payload is written to the
+  // socket straight from |data|, without being copied.
   DCHECK(buffered_spdy_framer_.get());
-  std::unique_ptr<SpdySerializedFrame> frame(
-      buffered_spdy_framer_->CreateDataFrame(
+  std::unique_ptr<SpdySerializedFrame> header(
+      buffered_spdy_framer_->CreateDataFrameHeader(
           stream_id, data->data(), static_cast<uint32_t>(effective_len),
           flags));
 
-  std::unique_ptr<SpdyBuffer> data_buffer(new SpdyBuffer(std::move(frame)));
+  std::unique_ptr<SpdyBuffer> data_buffer(
+      new SpdyBuffer(std::move(header), data, effective_len));
 
   // Send window size is based on payload size, so nothing to do if this is
   // just a FIN with no payload.
@@ -1620,13 +1623,25 @@ int SpdySession::DoWrite() {
   // TODO(pkasting): Remove ScopedTracker below once crbug.com/457517 is fixed.
   tracked_objects::ScopedTracker tracking_profile2(
       FROM_HERE_WITH_EXPLICIT_FUNCTION("457517 SpdySession::DoWrite2"));
-  scoped_refptr<IOBuffer> write_io_buffer =
-      in_flight_write_->GetIOBufferForRemainingData();
-  return connection_->socket()->Write(
-      write_io_buffer.get(),
-      in_flight_write_->GetRemainingSize(),
-      base::Bind(&SpdySession::PumpWriteLoop,
-                 weak_factory_.GetWeakPtr(), WRITE_STATE_DO_WRITE_COMPLETE));
+  // The data of DATA frames is split between the frame header and the
+  // payload, which are written together with WriteGather().
+  std::vector<scoped_refptr<IOBuffer>> write_io_buffers;
+  std::vector<int> write_sizes;
+  in_flight_write_->GetIOBuffersForRemainingData(&write_io_buffers,
+                                                 &write_sizes);
+  CompletionCallback write_callback =
+      base::Bind(&SpdySession::PumpWriteLoop, weak_factory_.GetWeakPtr(),
+                 WRITE_STATE_DO_WRITE_COMPLETE);
+  if (write_io_buffers.size() == 1) {
+    return connection_->socket()->Write(write_io_buffers[0].get(),
+                                        write_sizes[0], write_callback);
+  }
+  std::vector<IOBuffer*> raw_write_io_buffers;
+  for (const scoped_refptr<IOBuffer>& buffer : write_io_buffers)
+    raw_write_io_buffers.push_back(buffer.get());
+  return connection_->socket()->WriteGather(
+      raw_write_io_buffers.data(), write_sizes.data(),
+      static_cast<int>(write_sizes.size()), write_callback);
 }
 
 int SpdySession::DoWriteComplete(int result) {
@@ -0,0 +1,62 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <iostream>
+
+#include "base/command_line.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "net/log/binary_net_log_format.h"
+
+namespace {
+
+// Print the command line help.
+void PrintHelp(const char* command_line_name) {
+  std::cout << command_line_name << " binary_net_log json_net_log" << std::endl
+            << std::endl;
+  std::cout << "Converts a NetLog written by BinaryNetLogObserver to the JSON "
+            << "format which net-internals loads." << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+
+  base::CommandLine::StringVector args = command_line.GetArgs();
+  if (args.size() != 2) {
+    PrintHelp(argv[0]);
+    return 1;
+  }
+
+  base::File binary_file(base::FilePath(args[0]),
+                         base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!binary_file.IsValid()) {
+    std::cerr << "Couldn't open the binary NetLog." << std::endl;
+    return 1;
+  }
+  base::ScopedFILE json_file(base::OpenFile(base::FilePath(args[1]), "w"));
+  if (!json_file) {
+    std::cerr << "Couldn't create the JSON NetLog." << std::endl;
+    return 1;
+  }
+
+  int64_t dropped_events = 0;
+  if (!net::ConvertBinaryNetLogToJson(&binary_file, json_file.get(),
+                                      &dropped_events)) {
+    std::cerr << "Invalid binary NetLog." << std::endl;
+    return 1;
+  }
+  if (dropped_events) {
+    std::cerr << dropped_events << " events were dropped while logging."
+              << std::endl;
+  }
+  return 0;
+}
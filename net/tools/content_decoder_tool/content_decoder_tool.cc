@@ -2,26 +2,91 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
 #include "net/base/io_buffer.h"
+#include "net/base/sdch_manager.h"
 #include "net/filter/filter.h"
 #include "net/filter/mock_filter_context.h"
+#include "net/url_request/url_request_context.h"
+#include "url/gurl.h"
 
 using net::Filter;
 
 namespace {
 
+// Path of a SDCH dictionary, as served with its headers, to decode "sdch" and
+// "sbr" content encodings with.
+const char kDictionarySwitch[] = "dictionary";
+
+// URL the dictionary was fetched from, which is also used as the URL of the
+// decoded content.
+const char kUrlSwitch[] = "url";
+
+// Number of times to decode the stdin to measure the decoding throughput.
+const char kThroughputSwitch[] = "throughput";
+
 // Print the command line help.
 void PrintHelp(const char* command_line_name) {
-  std::cout << command_line_name << " content_encoding [content_encoding]..."
+  std::cout << command_line_name << " [--" << kDictionarySwitch
+            << "=<file> --" << kUrlSwitch << "=<url>] [--" << kThroughputSwitch
+            << "=<iterations>] content_encoding [content_encoding]..."
             << std::endl
             << std::endl;
   std::cout << "Decodes the stdin into the stdout using an content_encoding "
             << "list given in arguments. This list is expected to be the "
             << "Content-Encoding HTTP response header's value split by ','."
+            << std::endl
             << std::endl;
+  std::cout << "--" << kDictionarySwitch << " loads a SDCH dictionary fetched "
+            << "from the URL given by --" << kUrlSwitch << ", for the 'sdch' "
+            << "and 'sbr' (shared Brotli) content encodings." << std::endl;
+  std::cout << "--" << kThroughputSwitch << " decodes the stdin the given "
+            << "number of times and prints the decoding throughput instead of "
+            << "the decoded data, e.g. to compare 'sbr' to 'br'." << std::endl;
+}
+
+// Decodes |input| with |filter| into |output|, which may be null to discard
+// the decoded data. Adds the number of decoded bytes to |*output_size|.
+// Returns false on decoding errors.
+bool Decode(Filter* filter,
+            std::istream* input,
+            std::ostream* output,
+            int64_t* output_size) {
+  net::IOBuffer* pre_filter_buf = filter->stream_buffer();
+  int pre_filter_buf_len = filter->stream_buffer_size();
+  while (*input) {
+    input->read(pre_filter_buf->data(), pre_filter_buf_len);
+    int pre_filter_data_len = input->gcount();
+    filter->FlushStreamBuffer(pre_filter_data_len);
+
+    while (true) {
+      const int kPostFilterBufLen = 4096;
+      char post_filter_buf[kPostFilterBufLen];
+      int post_filter_data_len = kPostFilterBufLen;
+      Filter::FilterStatus filter_status =
+          filter->ReadData(post_filter_buf, &post_filter_data_len);
+      if (output)
+        output->write(post_filter_buf, post_filter_data_len);
+      *output_size += post_filter_data_len;
+      if (filter_status == Filter::FILTER_ERROR)
+        return false;
+      if (filter_status != Filter::FILTER_OK)
+        break;
+    }
+  }
+  return true;
 }
 
 }  // namespace
@@ -49,35 +114,89 @@ int main(int argc, char* argv[]) {
     filter_types.push_back(filter_type);
   }
 
+  net::SdchManager sdch_manager;
   net::MockFilterContext filter_context;
-  std::unique_ptr<Filter> filter(Filter::Factory(filter_types, filter_context));
-  if (!filter) {
-    std::cerr << "Couldn't create the decoder." << std::endl;
-    return 1;
+  if (command_line.HasSwitch(kDictionarySwitch)) {
+    GURL url(command_line.GetSwitchValueASCII(kUrlSwitch));
+    if (!url.is_valid()) {
+      std::cerr << "A dictionary needs a valid --" << kUrlSwitch << "."
+                << std::endl;
+      return 1;
+    }
+    std::string dictionary_text;
+    if (!base::ReadFileToString(
+            command_line.GetSwitchValuePath(kDictionarySwitch),
+            &dictionary_text)) {
+      std::cerr << "Couldn't read the dictionary." << std::endl;
+      return 1;
+    }
+    std::string server_hash;
+    net::SdchProblemCode rv =
+        sdch_manager.AddSdchDictionary(dictionary_text, url, &server_hash);
+    if (rv != net::SDCH_OK) {
+      std::cerr << "Couldn't load the dictionary: error " << rv << "."
+                << std::endl;
+      return 1;
+    }
+    filter_context.GetModifiableURLRequestContext()->set_sdch_manager(
+        &sdch_manager);
+    filter_context.SetURL(url);
+    filter_context.SetSdchResponse(sdch_manager.GetDictionarySet(url));
   }
 
-  net::IOBuffer* pre_filter_buf = filter->stream_buffer();
-  int pre_filter_buf_len = filter->stream_buffer_size();
-  while (std::cin) {
-    std::cin.read(pre_filter_buf->data(), pre_filter_buf_len);
-    int pre_filter_data_len = std::cin.gcount();
-    filter->FlushStreamBuffer(pre_filter_data_len);
+  if (!command_line.HasSwitch(kThroughputSwitch)) {
+    std::unique_ptr<Filter> filter(
+        Filter::Factory(filter_types, filter_context));
+    if (!filter) {
+      std::cerr << "Couldn't create the decoder." << std::endl;
+      return 1;
+    }
+    int64_t output_size = 0;
+    if (!Decode(filter.get(), &std::cin, &std::cout, &output_size)) {
+      std::cerr << "Couldn't decode stdin." << std::endl;
+      return 1;
+    }
+    return 0;
+  }
 
-    while (true) {
-      const int kPostFilterBufLen = 4096;
-      char post_filter_buf[kPostFilterBufLen];
-      int post_filter_data_len = kPostFilterBufLen;
-      Filter::FilterStatus filter_status =
-          filter->ReadData(post_filter_buf, &post_filter_data_len);
-      std::cout.write(post_filter_buf, post_filter_data_len);
-      if (filter_status == Filter::FILTER_ERROR) {
-        std::cerr << "Couldn't decode stdin." << std::endl;
-        return 1;
-      } else if (filter_status != Filter::FILTER_OK) {
-        break;
-      }
+  int iterations = 0;
+  if (!base::StringToInt(command_line.GetSwitchValueASCII(kThroughputSwitch),
+                         &iterations) ||
+      iterations <= 0) {
+    std::cerr << "Invalid number of iterations." << std::endl;
+    return 1;
+  }
+  std::ostringstream stdin_contents;
+  stdin_contents << std::cin.rdbuf();
+  const std::string input = stdin_contents.str();
+
+  int64_t output_size = 0;
+  base::TimeDelta elapsed;
+  for (int i = 0; i < iterations; ++i) {
+    std::istringstream input_stream(input);
+    base::TimeTicks start = base::TimeTicks::Now();
+    std::unique_ptr<Filter> filter(
+        Filter::Factory(filter_types, filter_context));
+    if (!filter) {
+      std::cerr << "Couldn't create the decoder." << std::endl;
+      return 1;
+    }
+    if (!Decode(filter.get(), &input_stream, nullptr, &output_size)) {
+      std::cerr << "Couldn't decode stdin." << std::endl;
+      return 1;
     }
+    elapsed += base::TimeTicks::Now() - start;
   }
 
+  const double kMegabyte = 1024 * 1024;
+  std::cout << "Input: " << input.size() << " bytes" << std::endl;
+  std::cout << "Output: " << output_size / iterations << " bytes" << std::endl;
+  std::cout << "Time: " << elapsed.InMillisecondsF() / iterations
+            << " ms per iteration" << std::endl;
+  std::cout << "Throughput: "
+            << output_size / kMegabyte / elapsed.InSecondsF()
+            << " MB/s of decoded data, "
+            << input.size() * iterations / kMegabyte / elapsed.InSecondsF()
+            << " MB/s of encoded data" << std::endl;
   return 0;
 }
@@ -0,0 +1,179 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_batch_packet_writer.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+
+#include "base/logging.h"
+#include "net/base/ip_endpoint.h"
+#include "net/tools/quic/quic_socket_utils.h"
+
+namespace net {
+
+struct QuicBatchPacketWriter::Packet {
+  const QuicPacketWriter* owner;
+  iovec iov;
+  sockaddr_storage raw_address;
+  // Large enough to hold either IPv4 or IPv6 packet info.
+  char cbuf[CMSG_SPACE(sizeof(in6_pktinfo))];
+  char buffer[kMaxPacketSize];
+};
+
+QuicBatchPacketWriter::QuicBatchPacketWriter(int fd)
+    : QuicDefaultPacketWriter(fd),
+      packets_(new Packet[kMaxPacketsPerBatch]),
+      mmsg_hdrs_(new mmsghdr[kMaxPacketsPerBatch]),
+      num_packets_(0),
+      num_sent_(0) {
+  static_assert(sizeof(Packet::cbuf) >= CMSG_SPACE(sizeof(in_pktinfo)),
+                "cbuf is too small for IPv4 packet info");
+}
+
+QuicBatchPacketWriter::~QuicBatchPacketWriter() {}
+
+WriteResult QuicBatchPacketWriter::WritePacket(const char* buffer,
+                                               size_t buf_len,
+                                               const IPAddress& self_address,
+                                               const IPEndPoint& peer_address,
+                                               PerPacketOptions* options) {
+  return WritePacketForOwner(nullptr, buffer, buf_len, self_address,
+                             peer_address, options);
+}
+
+bool QuicBatchPacketWriter::IsWriteBlockedDataBuffered() const {
+  return true;
+}
+
+void QuicBatchPacketWriter::SetWritable() {
+  QuicDefaultPacketWriter::SetWritable();
+  // Sends the packets held back while blocked, so that there is room for new
+  // ones. Errors are reported to the owners of the packets later.
+  SendHeldBackPackets();
+}
+
+bool QuicBatchPacketWriter::IsBatchMode() const {
+  return true;
+}
+
+WriteResult QuicBatchPacketWriter::Flush() {
+  return FlushForOwner(nullptr);
+}
+
+WriteResult QuicBatchPacketWriter::WritePacketForOwner(
+    const QuicPacketWriter* owner,
+    const char* buffer,
+    size_t buf_len,
+    const IPAddress& self_address,
+    const IPEndPoint& peer_address,
+    PerPacketOptions* options) {
+  DCHECK(!IsWriteBlocked());
+  DCHECK(nullptr == options)
+      << "QuicBatchPacketWriter does not accept any options.";
+  DCHECK_LE(buf_len, kMaxPacketSize);
+  // A full batch is flushed right away, and stays full only while the writer
+  // is blocked.
+  DCHECK_LT(num_packets_, kMaxPacketsPerBatch);
+
+  int error_code = 0;
+  if (TakeError(owner, &error_code))
+    return WriteResult(WRITE_STATUS_ERROR, error_code);
+
+  Packet* packet = &packets_[num_packets_];
+  packet->owner = owner;
+  memcpy(packet->buffer, buffer, buf_len);
+  packet->iov.iov_base = packet->buffer;
+  packet->iov.iov_len = buf_len;
+
+  mmsghdr* mmsg_hdr = &mmsg_hdrs_[num_packets_];
+  memset(mmsg_hdr, 0, sizeof(*mmsg_hdr));
+  msghdr* hdr = &mmsg_hdr->msg_hdr;
+  socklen_t address_len = sizeof(packet->raw_address);
+  CHECK(peer_address.ToSockAddr(
+      reinterpret_cast<sockaddr*>(&packet->raw_address), &address_len));
+  hdr->msg_name = &packet->raw_address;
+  hdr->msg_namelen = address_len;
+  hdr->msg_iov = &packet->iov;
+  hdr->msg_iovlen = 1;
+  if (!self_address.empty()) {
+    hdr->msg_control = packet->cbuf;
+    hdr->msg_controllen = sizeof(packet->cbuf);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(hdr);
+    QuicSocketUtils::SetIpInfoInCmsg(self_address, cmsg);
+    hdr->msg_controllen = cmsg->cmsg_len;
+  }
+  ++num_packets_;
+
+  if (num_packets_ == kMaxPacketsPerBatch) {
+    // The packet is held back even if the socket is write blocked, so only
+    // errors are reported for it.
+    SendHeldBackPackets();
+    if (TakeError(owner, &error_code))
+      return WriteResult(WRITE_STATUS_ERROR, error_code);
+  }
+  return WriteResult(WRITE_STATUS_OK, buf_len);
+}
+
+WriteResult QuicBatchPacketWriter::FlushForOwner(
+    const QuicPacketWriter* owner) {
+  const WriteResult result = SendHeldBackPackets();
+  int error_code = 0;
+  if (TakeError(owner, &error_code))
+    return WriteResult(WRITE_STATUS_ERROR, error_code);
+  return result;
+}
+
+void QuicBatchPacketWriter::RemoveOwner(const QuicPacketWriter* owner) {
+  DCHECK(owner);
+  errors_.erase(owner);
+  // A new owner could be created at the same address, so its held back
+  // packets must not be attributed to |owner| anymore.
+  for (size_t i = num_sent_; i < num_packets_; ++i) {
+    if (packets_[i].owner == owner)
+      packets_[i].owner = nullptr;
+  }
+}
+
+WriteResult QuicBatchPacketWriter::SendHeldBackPackets() {
+  int bytes_written = 0;
+  while (num_sent_ < num_packets_) {
+    const int rc = sendmmsg(fd(), &mmsg_hdrs_[num_sent_],
+                            num_packets_ - num_sent_, 0);
+    if (rc < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        set_write_blocked(true);
+        return WriteResult(WRITE_STATUS_BLOCKED, errno);
+      }
+      // sendmmsg() only fails if the first packet could not be sent. Drop it
+      // and carry on with the others.
+      DVLOG(1) << "Failed to send packet: " << strerror(errno);
+      errors_[packets_[num_sent_].owner] = errno;
+      ++num_sent_;
+      continue;
+    }
+    for (int i = 0; i < rc; ++i)
+      bytes_written += mmsg_hdrs_[num_sent_ + i].msg_len;
+    num_sent_ += rc;
+  }
+
+  num_packets_ = 0;
+  num_sent_ = 0;
+  return WriteResult(WRITE_STATUS_OK, bytes_written);
+}
+
+bool QuicBatchPacketWriter::TakeError(const QuicPacketWriter* owner,
+                                      int* error_code) {
+  auto it = errors_.find(owner);
+  if (it == errors_.end())
+    return false;
+  *error_code = it->second;
+  errors_.erase(it);
+  return true;
+}
+
+}  // namespace net
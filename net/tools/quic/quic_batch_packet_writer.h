@@ -0,0 +1,86 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
+#define NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include <map>
+#include <memory>
+
+#include "base/macros.h"
+#include "net/tools/quic/quic_default_packet_writer.h"
+
+namespace net {
+
+// Packet writer which holds written packets back and sends them with a single
+// sendmmsg() call when flushed, or when kMaxPacketsPerBatch of them are held
+// back. When the socket is write blocked, the packets which could not be sent
+// remain held back, and are sent as soon as the writer is made writable again.
+//
+// The writer is shared by all connections of a server, so a flush can send
+// packets of any connection. Each held back packet records its owner, and an
+// error sending it is kept for that owner until it next writes or flushes.
+class QuicBatchPacketWriter : public QuicDefaultPacketWriter {
+ public:
+  // Maximum number of packets held back.
+  static const size_t kMaxPacketsPerBatch = 16;
+
+  explicit QuicBatchPacketWriter(int fd);
+  ~QuicBatchPacketWriter() override;
+
+  // QuicPacketWriter
+  WriteResult WritePacket(const char* buffer,
+                          size_t buf_len,
+                          const IPAddress& self_address,
+                          const IPEndPoint& peer_address,
+                          PerPacketOptions* options) override;
+  bool IsWriteBlockedDataBuffered() const override;
+  void SetWritable() override;
+  bool IsBatchMode() const override;
+  WriteResult Flush() override;
+  WriteResult WritePacketForOwner(const QuicPacketWriter* owner,
+                                  const char* buffer,
+                                  size_t buf_len,
+                                  const IPAddress& self_address,
+                                  const IPEndPoint& peer_address,
+                                  PerPacketOptions* options) override;
+  WriteResult FlushForOwner(const QuicPacketWriter* owner) override;
+  void RemoveOwner(const QuicPacketWriter* owner) override;
+
+  size_t num_held_back_packets() const { return num_packets_ - num_sent_; }
+
+ private:
+  struct Packet;
+
+  // Sends the held back packets, and records the errors for their owners.
+  // Returns a WRITE_STATUS_BLOCKED result if the socket is write blocked, and
+  // a WRITE_STATUS_OK result with the number of bytes sent otherwise.
+  WriteResult SendHeldBackPackets();
+
+  // Returns true and removes the error recorded for |owner|, if any.
+  bool TakeError(const QuicPacketWriter* owner, int* error_code);
+
+  // Storage of the held back packets. |mmsg_hdrs_[i]| points into
+  // |packets_[i]|.
+  std::unique_ptr<Packet[]> packets_;
+  std::unique_ptr<mmsghdr[]> mmsg_hdrs_;
+
+  // Number of packets in |packets_|, of which the first |num_sent_| have been
+  // sent.
+  size_t num_packets_;
+  size_t num_sent_;
+
+  // The last error sending a packet of each owner, which has not been
+  // reported yet. Packets written without an owner have a null owner.
+  std::map<const QuicPacketWriter*, int> errors_;
+
+  DISALLOW_COPY_AND_ASSIGN(QuicBatchPacketWriter);
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_QUIC_QUIC_BATCH_PACKET_WRITER_H_
@@ -0,0 +1,231 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_batch_packet_writer.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "base/strings/string_number_conversions.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/tools/quic/quic_per_connection_packet_writer.h"
+#include "net/tools/quic/quic_socket_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using std::string;
+
+namespace net {
+namespace test {
+namespace {
+
+// Creates a UDP socket bound to an ephemeral loopback port, and returns its
+// address in |address|.
+int CreateLoopbackSocket(IPEndPoint* address) {
+  bool overflow_supported = false;
+  const IPEndPoint any_port(IPAddress::IPv4Localhost(), 0);
+  int fd = QuicSocketUtils::CreateUDPSocket(any_port, &overflow_supported);
+  if (fd < 0)
+    return -1;
+  SockaddrStorage storage;
+  if (!any_port.ToSockAddr(storage.addr, &storage.addr_len) ||
+      bind(fd, storage.addr, storage.addr_len) != 0 ||
+      getsockname(fd, storage.addr, &storage.addr_len) != 0 ||
+      !address->FromSockAddr(storage.addr, storage.addr_len)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+class QuicBatchPacketWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    receiver_fd_ = CreateLoopbackSocket(&receiver_address_);
+    ASSERT_LE(0, receiver_fd_);
+    sender_fd_ = CreateLoopbackSocket(&sender_address_);
+    ASSERT_LE(0, sender_fd_);
+    writer_.reset(new QuicBatchPacketWriter(sender_fd_));
+  }
+
+  void TearDown() override {
+    writer_.reset();
+    close(sender_fd_);
+    close(receiver_fd_);
+  }
+
+  WriteResult Write(const string& payload) {
+    return writer_->WritePacket(payload.data(), payload.size(),
+                                sender_address_.address(), receiver_address_,
+                                nullptr);
+  }
+
+  // Reads a packet from the receiving socket. Returns false if there is none.
+  bool Read(string* payload) {
+    char buffer[kMaxPacketSize];
+    IPAddress self_address;
+    IPEndPoint peer_address;
+    QuicTime timestamp = QuicTime::Zero();
+    int bytes_read = QuicSocketUtils::ReadPacket(
+        receiver_fd_, buffer, sizeof(buffer), nullptr, &self_address,
+        &timestamp, &peer_address);
+    if (bytes_read < 0)
+      return false;
+    EXPECT_EQ(receiver_address_.address(), self_address);
+    EXPECT_EQ(sender_address_, peer_address);
+    payload->assign(buffer, bytes_read);
+    return true;
+  }
+
+  int sender_fd_;
+  int receiver_fd_;
+  IPEndPoint sender_address_;
+  IPEndPoint receiver_address_;
+  std::unique_ptr<QuicBatchPacketWriter> writer_;
+};
+
+TEST_F(QuicBatchPacketWriterTest, HoldsPacketsBackUntilFlush) {
+  EXPECT_TRUE(writer_->IsBatchMode());
+  EXPECT_TRUE(writer_->IsWriteBlockedDataBuffered());
+
+  const string kPayloads[] = {"foo", "bar", "bazqux"};
+  for (const string& payload : kPayloads) {
+    WriteResult result = Write(payload);
+    EXPECT_EQ(WRITE_STATUS_OK, result.status);
+    EXPECT_EQ(static_cast<int>(payload.size()), result.bytes_written);
+  }
+  EXPECT_EQ(arraysize(kPayloads), writer_->num_held_back_packets());
+
+  string payload;
+  EXPECT_FALSE(Read(&payload));
+
+  WriteResult result = writer_->Flush();
+  EXPECT_EQ(WRITE_STATUS_OK, result.status);
+  EXPECT_EQ(12, result.bytes_written);
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+  for (const string& expected_payload : kPayloads) {
+    ASSERT_TRUE(Read(&payload));
+    EXPECT_EQ(expected_payload, payload);
+  }
+  EXPECT_FALSE(Read(&payload));
+
+  // Flushing with no packet held back sends nothing.
+  result = writer_->Flush();
+  EXPECT_EQ(WRITE_STATUS_OK, result.status);
+  EXPECT_EQ(0, result.bytes_written);
+  EXPECT_FALSE(Read(&payload));
+}
+
+TEST_F(QuicBatchPacketWriterTest, FlushesFullBatch) {
+  for (size_t i = 0; i < QuicBatchPacketWriter::kMaxPacketsPerBatch; ++i) {
+    EXPECT_EQ(i, writer_->num_held_back_packets());
+    EXPECT_EQ(WRITE_STATUS_OK, Write(base::SizeTToString(i)).status);
+  }
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+
+  string payload;
+  for (size_t i = 0; i < QuicBatchPacketWriter::kMaxPacketsPerBatch; ++i) {
+    ASSERT_TRUE(Read(&payload));
+    EXPECT_EQ(base::SizeTToString(i), payload);
+  }
+  EXPECT_FALSE(Read(&payload));
+}
+
+TEST_F(QuicBatchPacketWriterTest, SetWritableSendsHeldBackPackets) {
+  EXPECT_EQ(WRITE_STATUS_OK, Write("foo").status);
+  writer_->SetWritable();
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+
+  string payload;
+  ASSERT_TRUE(Read(&payload));
+  EXPECT_EQ("foo", payload);
+}
+
+TEST_F(QuicBatchPacketWriterTest, ReportsErrorsOnlyToOwner) {
+  QuicPerConnectionPacketWriter writer_a(writer_.get());
+  QuicPerConnectionPacketWriter writer_b(writer_.get());
+  // Sending to port 0 fails.
+  const IPEndPoint bad_address(receiver_address_.address(), 0);
+
+  EXPECT_EQ(WRITE_STATUS_OK,
+            writer_a.WritePacket("foo", 3, sender_address_.address(),
+                                 receiver_address_, nullptr)
+                .status);
+  EXPECT_EQ(WRITE_STATUS_OK,
+            writer_b.WritePacket("bar", 3, sender_address_.address(),
+                                 bad_address, nullptr)
+                .status);
+
+  // The flush fails to send |writer_b|'s packet, which is not reported to
+  // |writer_a|.
+  WriteResult result = writer_a.Flush();
+  EXPECT_EQ(WRITE_STATUS_OK, result.status);
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+  string payload;
+  ASSERT_TRUE(Read(&payload));
+  EXPECT_EQ("foo", payload);
+  EXPECT_FALSE(Read(&payload));
+
+  // The error is reported once, to |writer_b|.
+  result = writer_b.Flush();
+  EXPECT_EQ(WRITE_STATUS_ERROR, result.status);
+  EXPECT_EQ(EINVAL, result.error_code);
+  EXPECT_EQ(WRITE_STATUS_OK, writer_b.Flush().status);
+  EXPECT_EQ(WRITE_STATUS_OK, writer_->Flush().status);
+}
+
+TEST_F(QuicBatchPacketWriterTest, ReportsErrorsOfFullBatchOnlyToOwner) {
+  QuicPerConnectionPacketWriter writer_a(writer_.get());
+  QuicPerConnectionPacketWriter writer_b(writer_.get());
+  const IPEndPoint bad_address(receiver_address_.address(), 0);
+
+  EXPECT_EQ(WRITE_STATUS_OK,
+            writer_b.WritePacket("bar", 3, sender_address_.address(),
+                                 bad_address, nullptr)
+                .status);
+  // The last packet written by |writer_a| flushes the full batch.
+  for (size_t i = 1; i < QuicBatchPacketWriter::kMaxPacketsPerBatch; ++i) {
+    EXPECT_EQ(WRITE_STATUS_OK,
+              writer_a.WritePacket("foo", 3, sender_address_.address(),
+                                   receiver_address_, nullptr)
+                  .status);
+  }
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+
+  // |writer_b| gets the error when it writes its next packet, which is not
+  // sent.
+  WriteResult result =
+      writer_b.WritePacket("baz", 3, sender_address_.address(),
+                           receiver_address_, nullptr);
+  EXPECT_EQ(WRITE_STATUS_ERROR, result.status);
+  EXPECT_EQ(EINVAL, result.error_code);
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+}
+
+TEST_F(QuicBatchPacketWriterTest, RemovedOwnerErrorsAreNotReported) {
+  std::unique_ptr<QuicPerConnectionPacketWriter> writer_a(
+      new QuicPerConnectionPacketWriter(writer_.get()));
+  const IPEndPoint bad_address(receiver_address_.address(), 0);
+
+  EXPECT_EQ(WRITE_STATUS_OK,
+            writer_a->WritePacket("foo", 3, sender_address_.address(),
+                                  bad_address, nullptr)
+                .status);
+  writer_a.reset();
+
+  // A new owner, possibly at the same address, doesn't get the error.
+  QuicPerConnectionPacketWriter writer_b(writer_.get());
+  EXPECT_EQ(WRITE_STATUS_OK, writer_b.Flush().status);
+  // The packet is still sent, and its error goes to the shared writer.
+  EXPECT_EQ(0u, writer_->num_held_back_packets());
+  EXPECT_EQ(WRITE_STATUS_ERROR, writer_->Flush().status);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace net
@@ -30,9 +30,6 @@
 #define SO_RXQ_OVFL 40
 #endif
 
-// TODO(rtenneti): Add support for MMSG_MORE.
-#define MMSG_MORE 0
-
 using base::StringPiece;
 using std::string;
 using std::vector;
@@ -4,6 +4,8 @@
 
 #include "net/tools/quic/quic_dispatcher.h"
 
+#include <string.h>
+
 #include <utility>
 
 #include "base/debug/stack_trace.h"
@@ -280,6 +282,18 @@ bool QuicDispatcher::HasPendingWrites() const {
   return !write_blocked_list_.empty();
 }
 
+void QuicDispatcher::FlushWriter() {
+  if (!writer_->IsBatchMode() || writer_->IsWriteBlocked()) {
+    return;
+  }
+  // If the socket is write blocked, the packets which could not be sent are
+  // sent by the writer itself once it is writable again.
+  const WriteResult result = writer_->Flush();
+  if (result.status == WRITE_STATUS_ERROR) {
+    DVLOG(1) << "Failed to flush the writer: " << strerror(result.error_code);
+  }
+}
+
 void QuicDispatcher::Shutdown() {
   while (!session_map_.empty()) {
     QuicServerSessionBase* session = session_map_.begin()->second;
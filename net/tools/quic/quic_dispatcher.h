@@ -69,6 +69,11 @@ class QuicDispatcher : public QuicServerSessionBase::Visitor,
   // Returns true if there's anything in the blocked writer list.
   virtual bool HasPendingWrites() const;
 
+  // Sends the packets held back by a batch mode writer, such as the public
+  // resets and connection closes written by the time wait list manager.
+  // Called once the packets read from the socket have been processed.
+  void FlushWriter();
+
   // Sends ConnectionClose frames to all connected clients.
   void Shutdown();
 
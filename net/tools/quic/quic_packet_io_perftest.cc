@@ -0,0 +1,151 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the packet rate of the QUIC server packet path over loopback, with
+// one system call per packet (QuicDefaultPacketWriter and recvmsg()) and with
+// batched system calls (QuicBatchPacketWriter and QuicPacketReader).
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/quic/quic_clock.h"
+#include "net/tools/quic/quic_batch_packet_writer.h"
+#include "net/tools/quic/quic_default_packet_writer.h"
+#include "net/tools/quic/quic_packet_reader.h"
+#include "net/tools/quic/quic_process_packet_interface.h"
+#include "net/tools/quic/quic_socket_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace net {
+namespace {
+
+const int kNumPackets = 200000;
+const size_t kPacketSize = 1200;
+
+// Matches the size of the batches sent and read, so that the receive buffer
+// never overflows.
+const int kPacketsPerRound = QuicBatchPacketWriter::kMaxPacketsPerBatch;
+
+int CreateLoopbackSocket(IPEndPoint* address) {
+  bool overflow_supported = false;
+  const IPEndPoint any_port(IPAddress::IPv4Localhost(), 0);
+  int fd = QuicSocketUtils::CreateUDPSocket(any_port, &overflow_supported);
+  if (fd < 0)
+    return -1;
+  SockaddrStorage storage;
+  if (!any_port.ToSockAddr(storage.addr, &storage.addr_len) ||
+      bind(fd, storage.addr, storage.addr_len) != 0 ||
+      getsockname(fd, storage.addr, &storage.addr_len) != 0 ||
+      !address->FromSockAddr(storage.addr, storage.addr_len)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+class CountingPacketProcessor : public ProcessPacketInterface {
+ public:
+  CountingPacketProcessor() : num_packets_(0) {}
+
+  void ProcessPacket(const IPEndPoint& server_address,
+                     const IPEndPoint& client_address,
+                     const QuicReceivedPacket& packet) override {
+    ++num_packets_;
+  }
+
+  int num_packets() const { return num_packets_; }
+
+ private:
+  int num_packets_;
+};
+
+class QuicPacketIOPerfTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    receiver_fd_ = CreateLoopbackSocket(&receiver_address_);
+    ASSERT_LE(0, receiver_fd_);
+    sender_fd_ = CreateLoopbackSocket(&sender_address_);
+    ASSERT_LE(0, sender_fd_);
+  }
+
+  void TearDown() override {
+    close(sender_fd_);
+    close(receiver_fd_);
+  }
+
+  // Sends kNumPackets packets with |writer| and reads them back, a round of
+  // kPacketsPerRound packets at a time, then reports the packet rate.
+  void RunTest(const std::string& trace,
+               QuicDefaultPacketWriter* writer,
+               bool batch_reads) {
+    const std::string payload(kPacketSize, 'q');
+    QuicPacketReader reader;
+    CountingPacketProcessor processor;
+    int num_received = 0;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int sent = 0; sent < kNumPackets; sent += kPacketsPerRound) {
+      for (int i = 0; i < kPacketsPerRound; ++i) {
+        ASSERT_EQ(WRITE_STATUS_OK,
+                  writer->WritePacket(payload.data(), payload.size(),
+                                      sender_address_.address(),
+                                      receiver_address_, nullptr)
+                      .status);
+      }
+      ASSERT_EQ(WRITE_STATUS_OK, writer->Flush().status);
+
+      if (batch_reads) {
+        while (reader.ReadAndDispatchPackets(receiver_fd_,
+                                             receiver_address_.port(), clock_,
+                                             &processor, nullptr)) {
+        }
+        num_received = processor.num_packets();
+      } else {
+        char buffer[kMaxPacketSize];
+        IPAddress self_address;
+        IPEndPoint peer_address;
+        QuicTime timestamp = QuicTime::Zero();
+        while (QuicSocketUtils::ReadPacket(receiver_fd_, buffer,
+                                           sizeof(buffer), nullptr,
+                                           &self_address, &timestamp,
+                                           &peer_address) >= 0) {
+          ++num_received;
+        }
+      }
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    EXPECT_EQ(kNumPackets, num_received);
+    perf_test::PrintResult("packet_io", "", trace,
+                           kNumPackets / elapsed.InSecondsF(), "packets/s",
+                           true);
+  }
+
+  QuicClock clock_;
+  int sender_fd_;
+  int receiver_fd_;
+  IPEndPoint sender_address_;
+  IPEndPoint receiver_address_;
+};
+
+TEST_F(QuicPacketIOPerfTest, Unbatched) {
+  QuicDefaultPacketWriter writer(sender_fd_);
+  RunTest("unbatched", &writer, false);
+}
+
+TEST_F(QuicPacketIOPerfTest, Batched) {
+  QuicBatchPacketWriter writer(sender_fd_);
+  RunTest("batched", &writer, true);
+}
+
+}  // namespace
+}  // namespace net
@@ -21,8 +21,6 @@
 #include "net/tools/quic/quic_process_packet_interface.h"
 #include "net/tools/quic/quic_socket_utils.h"
 
-#define MMSG_MORE 0
-
 #ifndef SO_RXQ_OVFL
 #define SO_RXQ_OVFL 40
 #endif
@@ -89,6 +87,7 @@ bool QuicPacketReader::ReadAndDispatchManyPackets(
     hdr->msg_namelen = sizeof(sockaddr_storage);
     DCHECK_EQ(1, hdr->msg_iovlen);
     hdr->msg_controllen = QuicSocketUtils::kSpaceForCmsg;
+    hdr->msg_flags = 0;
   }
 
   int packets_read =
@@ -100,23 +99,36 @@ bool QuicPacketReader::ReadAndDispatchManyPackets(
 
   QuicTime fallback_timestamp = QuicTime::Zero();
   for (int i = 0; i < packets_read; ++i) {
+    msghdr* hdr = &mmsg_hdr_[i].msg_hdr;
     if (mmsg_hdr_[i].msg_len == 0) {
       continue;
     }
 
-    if (mmsg_hdr_[i].msg_hdr.msg_controllen >= QuicSocketUtils::kSpaceForCmsg) {
-      QUIC_BUG << "Incorrectly set control length: "
-               << mmsg_hdr_[i].msg_hdr.msg_controllen << ", expected "
-               << QuicSocketUtils::kSpaceForCmsg;
+    if (hdr->msg_flags & MSG_TRUNC) {
+      // The packet is larger than any valid QUIC packet.
+      DVLOG(1) << "Dropping truncated packet of at least "
+               << mmsg_hdr_[i].msg_len << " bytes.";
       continue;
     }
+    if (hdr->msg_flags & MSG_CTRUNC) {
+      // Some ancillary data did not fit. The packet is still usable if the
+      // server address made it.
+      DVLOG(1) << "Truncated control data: " << hdr->msg_controllen
+               << " bytes.";
+    }
 
-    IPEndPoint client_address = IPEndPoint(packets_[i].raw_address);
+    IPEndPoint client_address;
+    if (!client_address.FromSockAddr(
+            reinterpret_cast<const sockaddr*>(&packets_[i].raw_address),
+            hdr->msg_namelen)) {
+      QUIC_BUG << "Unable to get client address.";
+      continue;
+    }
     IPAddress server_ip;
     QuicTime packet_timestamp = QuicTime::Zero();
-    QuicSocketUtils::GetAddressAndTimestampFromMsghdr(
-        &mmsg_hdr_[i].msg_hdr, &server_ip, &packet_timestamp);
-    if (!IsInitializedAddress(server_ip)) {
+    QuicSocketUtils::GetAddressAndTimestampFromMsghdr(hdr, &server_ip,
+                                                      &packet_timestamp);
+    if (server_ip.empty()) {
       QUIC_BUG << "Unable to get server address.";
       continue;
     }
@@ -137,8 +149,10 @@ bool QuicPacketReader::ReadAndDispatchManyPackets(
   }
 
   if (packets_dropped != nullptr) {
-    QuicSocketUtils::GetOverflowFromMsghdr(&mmsg_hdr_[0].msg_hdr,
-                                           packets_dropped);
+    // The overflow count is as of the reception of each packet, so the last
+    // one has the most recent count.
+    QuicSocketUtils::GetOverflowFromMsghdr(
+        &mmsg_hdr_[packets_read - 1].msg_hdr, packets_dropped);
   }
 
   // We may not have read all of the packets available on the socket.
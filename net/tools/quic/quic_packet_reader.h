@@ -16,7 +16,13 @@
 #include "net/tools/quic/quic_process_packet_interface.h"
 #include "net/tools/quic/quic_socket_utils.h"
 
+// recvmmsg() is used to read several packets with a single system call where
+// it is available.
+#if defined(__linux__)
+#define MMSG_MORE 1
+#else
 #define MMSG_MORE 0
+#endif
 
 namespace net {
 
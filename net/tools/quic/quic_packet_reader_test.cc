@@ -0,0 +1,162 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/quic/quic_packet_reader.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/sockaddr_storage.h"
+#include "net/quic/test_tools/mock_clock.h"
+#include "net/tools/quic/quic_process_packet_interface.h"
+#include "net/tools/quic/quic_socket_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using std::string;
+
+namespace net {
+namespace test {
+namespace {
+
+const int kPort = 443;
+
+// Creates a UDP socket bound to an ephemeral loopback port, and returns its
+// address in |address|.
+int CreateLoopbackSocket(IPEndPoint* address) {
+  bool overflow_supported = false;
+  const IPEndPoint any_port(IPAddress::IPv4Localhost(), 0);
+  int fd = QuicSocketUtils::CreateUDPSocket(any_port, &overflow_supported);
+  if (fd < 0)
+    return -1;
+  SockaddrStorage storage;
+  if (!any_port.ToSockAddr(storage.addr, &storage.addr_len) ||
+      bind(fd, storage.addr, storage.addr_len) != 0 ||
+      getsockname(fd, storage.addr, &storage.addr_len) != 0 ||
+      !address->FromSockAddr(storage.addr, storage.addr_len)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+class RecordingProcessor : public ProcessPacketInterface {
+ public:
+  struct Packet {
+    IPEndPoint server_address;
+    IPEndPoint client_address;
+    string payload;
+  };
+
+  void ProcessPacket(const IPEndPoint& server_address,
+                     const IPEndPoint& client_address,
+                     const QuicReceivedPacket& packet) override {
+    packets_.push_back(
+        {server_address, client_address,
+         string(packet.data(), packet.length())});
+  }
+
+  const std::vector<Packet>& packets() const { return packets_; }
+
+ private:
+  std::vector<Packet> packets_;
+};
+
+class QuicPacketReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    receiver_fd_ = CreateLoopbackSocket(&receiver_address_);
+    ASSERT_LE(0, receiver_fd_);
+    sender_fd_ = CreateLoopbackSocket(&sender_address_);
+    ASSERT_LE(0, sender_fd_);
+  }
+
+  void TearDown() override {
+    close(sender_fd_);
+    close(receiver_fd_);
+  }
+
+  void Send(const string& payload) {
+    SockaddrStorage storage;
+    ASSERT_TRUE(receiver_address_.ToSockAddr(storage.addr, &storage.addr_len));
+    ASSERT_EQ(static_cast<ssize_t>(payload.size()),
+              sendto(sender_fd_, payload.data(), payload.size(), 0,
+                     storage.addr, storage.addr_len));
+  }
+
+  bool ReadAndDispatchPackets() {
+    return reader_.ReadAndDispatchPackets(receiver_fd_, kPort, clock_,
+                                          &processor_, nullptr);
+  }
+
+  int sender_fd_;
+  int receiver_fd_;
+  IPEndPoint sender_address_;
+  IPEndPoint receiver_address_;
+  MockClock clock_;
+  RecordingProcessor processor_;
+  QuicPacketReader reader_;
+};
+
+TEST_F(QuicPacketReaderTest, ReadsSeveralPacketsPerCall) {
+  const string kPayloads[] = {"foo", "bar", "bazqux"};
+  for (const string& payload : kPayloads)
+    Send(payload);
+
+#if MMSG_MORE
+  // All of the packets are read at once, and there are no more to read.
+  EXPECT_FALSE(ReadAndDispatchPackets());
+#else
+  while (ReadAndDispatchPackets()) {
+  }
+#endif
+  ASSERT_EQ(arraysize(kPayloads), processor_.packets().size());
+  for (size_t i = 0; i < arraysize(kPayloads); ++i) {
+    const RecordingProcessor::Packet& packet = processor_.packets()[i];
+    EXPECT_EQ(kPayloads[i], packet.payload);
+    EXPECT_EQ(IPEndPoint(receiver_address_.address(), kPort),
+              packet.server_address);
+    EXPECT_EQ(sender_address_, packet.client_address);
+  }
+
+  EXPECT_FALSE(ReadAndDispatchPackets());
+  EXPECT_EQ(arraysize(kPayloads), processor_.packets().size());
+}
+
+#if MMSG_MORE
+TEST_F(QuicPacketReaderTest, ReadsFullBatch) {
+  for (int i = 0; i < kNumPacketsPerReadMmsgCall + 1; ++i)
+    Send(base::IntToString(i));
+
+  // A full batch may leave packets on the socket.
+  EXPECT_TRUE(ReadAndDispatchPackets());
+  EXPECT_EQ(static_cast<size_t>(kNumPacketsPerReadMmsgCall),
+            processor_.packets().size());
+  EXPECT_FALSE(ReadAndDispatchPackets());
+  ASSERT_EQ(static_cast<size_t>(kNumPacketsPerReadMmsgCall + 1),
+            processor_.packets().size());
+  for (int i = 0; i < kNumPacketsPerReadMmsgCall + 1; ++i)
+    EXPECT_EQ(base::IntToString(i), processor_.packets()[i].payload);
+}
+
+TEST_F(QuicPacketReaderTest, DropsOnlyTruncatedPackets) {
+  Send("foo");
+  Send(string(kMaxPacketSize + 1, 'a'));
+  Send("bar");
+
+  EXPECT_FALSE(ReadAndDispatchPackets());
+  ASSERT_EQ(2u, processor_.packets().size());
+  EXPECT_EQ("foo", processor_.packets()[0].payload);
+  EXPECT_EQ("bar", processor_.packets()[1].payload);
+}
+#endif
+
+}  // namespace
+}  // namespace test
+}  // namespace net
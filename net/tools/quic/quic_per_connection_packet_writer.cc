@@ -10,7 +10,9 @@ QuicPerConnectionPacketWriter::QuicPerConnectionPacketWriter(
     QuicPacketWriter* shared_writer)
     : shared_writer_(shared_writer) {}
 
-QuicPerConnectionPacketWriter::~QuicPerConnectionPacketWriter() {}
+QuicPerConnectionPacketWriter::~QuicPerConnectionPacketWriter() {
+  shared_writer_->RemoveOwner(this);
+}
 
 WriteResult QuicPerConnectionPacketWriter::WritePacket(
     const char* buffer,
@@ -18,8 +20,9 @@ WriteResult QuicPerConnectionPacketWriter::WritePacket(
     const IPAddress& self_address,
     const IPEndPoint& peer_address,
     PerPacketOptions* options) {
-  return shared_writer_->WritePacket(buffer, buf_len, self_address,
-                                     peer_address, options);
+  return shared_writer_->WritePacketForOwner(this, buffer, buf_len,
+                                             self_address, peer_address,
+                                             options);
 }
 
 bool QuicPerConnectionPacketWriter::IsWriteBlockedDataBuffered() const {
@@ -39,4 +42,12 @@ QuicByteCount QuicPerConnectionPacketWriter::GetMaxPacketSize(
   return shared_writer_->GetMaxPacketSize(peer_address);
 }
 
+bool QuicPerConnectionPacketWriter::IsBatchMode() const {
+  return shared_writer_->IsBatchMode();
+}
+
+WriteResult QuicPerConnectionPacketWriter::Flush() {
+  return shared_writer_->FlushForOwner(this);
+}
+
 }  // namespace net
@@ -13,7 +13,9 @@
 
 namespace net {
 
-// A connection-specific packet writer that wraps a shared writer.
+// A connection-specific packet writer that wraps a shared writer. When the
+// shared writer is in batch mode, only errors sending this connection's
+// packets are reported.
 class QuicPerConnectionPacketWriter : public QuicPacketWriter {
  public:
   // Does not take ownership of |shared_writer|.
@@ -33,6 +35,8 @@ class QuicPerConnectionPacketWriter : public QuicPacketWriter {
   bool IsWriteBlocked() const override;
   void SetWritable() override;
   QuicByteCount GetMaxPacketSize(const IPEndPoint& peer_address) const override;
+  bool IsBatchMode() const override;
+  WriteResult Flush() override;
 
  private:
   QuicPacketWriter* shared_writer_;  // Not owned.
@@ -21,6 +21,7 @@
 #include "net/quic/quic_crypto_stream.h"
 #include "net/quic/quic_data_reader.h"
 #include "net/quic/quic_protocol.h"
+#include "net/tools/quic/quic_batch_packet_writer.h"
 #include "net/tools/quic/quic_dispatcher.h"
 #include "net/tools/quic/quic_epoll_alarm_factory.h"
 #include "net/tools/quic/quic_epoll_clock.h"
@@ -142,7 +143,7 @@ bool QuicServer::CreateUDPSocketAndListen(const IPEndPoint& address) {
 }
 
 QuicDefaultPacketWriter* QuicServer::CreateWriter(int fd) {
-  return new QuicDefaultPacketWriter(fd);
+  return new QuicBatchPacketWriter(fd);
 }
 
 QuicDispatcher* QuicServer::CreateQuicDispatcher() {
@@ -189,6 +190,11 @@ void QuicServer::OnEvent(int fd, EpollEvent* event) {
       event->out_ready_mask |= EPOLLOUT;
     }
   }
+  if (event->in_events & (EPOLLIN | EPOLLOUT)) {
+    // Send what was written while handling the event in as few system calls
+    // as possible.
+    dispatcher_->FlushWriter();
+  }
   if (event->in_events & EPOLLERR) {
   }
 }
@@ -14,6 +14,12 @@
 // To test that the disk cache doesn't generate critical errors with regular
 // application level crashes, edit stress_support.h.
 
+// With --clients=N, the application instead measures the latency of the cache
+// operations of N clients sharing the cache, like the requests of a busy
+// proxy, and prints the median and 99th percentile of each operation after
+// --operations of them (10000 by default).
+
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -25,6 +31,7 @@
 #include "base/files/file_path.h"
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/macros.h"
 #include "base/message_loop/message_loop.h"
 #include "base/path_service.h"
 #include "base/process/launch.h"
@@ -37,6 +44,7 @@
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 #include "net/base/test_completion_callback.h"
@@ -51,10 +59,16 @@
 #endif
 
 using base::Time;
+using base::TimeDelta;
+using base::TimeTicks;
 
 const int kError = -1;
 const int kExpectedCrash = 100;
 
+const char kClientsSwitch[] = "clients";
+const char kOperationsSwitch[] = "operations";
+const int kDefaultOperations = 10000;
+
 // Starts a new process.
 int RunSlave(int iteration) {
   base::FilePath exe;
@@ -113,7 +127,12 @@ const int kBufferSize = 2000;
 const int kReadSize = 20;
 
 // Things that an entry can be doing.
-enum Operation { NONE, OPEN, CREATE, READ, WRITE, DOOM };
+enum Operation { NONE, OPEN, CREATE, READ, WRITE, DOOM, MAX_OPERATION };
+
+const char* const kOperationNames[] = {"none",  "open",  "create",
+                                       "read",  "write", "doom"};
+static_assert(arraysize(kOperationNames) == MAX_OPERATION,
+              "kOperationNames must name every Operation");
 
 // This class encapsulates a cache entry and the operations performed on that
 // entry. An entry is opened or created as needed, the current content is then
@@ -141,31 +160,61 @@ class EntryWrapper {
   void OnDeleteDone(int result);
   void DoIdle();
 
+  // Sets |state_| to |operation| and starts timing it.
+  void StartOperation(Operation operation);
+
+  // Records the latency of the operation in |state_|.
+  void OperationDone();
+
   disk_cache::Entry* entry_;
   Operation state_;
+  TimeTicks operation_start_;
   scoped_refptr<net::IOBuffer> buffer_;
 };
 
 // The data that the main thread is working on.
 struct Data {
-  Data() : pendig_operations(0), writes(0), iteration(0), cache(nullptr) {}
+  explicit Data(int num_entries)
+      : pendig_operations(0),
+        writes(0),
+        iteration(0),
+        max_operations(0),
+        operations(0),
+        cache(nullptr),
+        entries(num_entries) {}
 
   int pendig_operations;  // Counter of simultaneous operations.
   int writes;             // How many writes since this iteration started.
   int iteration;          // The iteration (number of crashes).
+  int max_operations;     // Operations to time, or zero to run forever.
+  int operations;         // Operations timed so far.
   disk_cache::BackendImpl* cache;
   std::string keys[kNumKeys];
-  EntryWrapper entries[kNumEntries];
+  std::vector<EntryWrapper> entries;
+  std::vector<TimeDelta> latencies[MAX_OPERATION];
 };
 
 Data* g_data = nullptr;
 
+void EntryWrapper::StartOperation(Operation operation) {
+  state_ = operation;
+  if (g_data->max_operations)
+    operation_start_ = TimeTicks::Now();
+}
+
+void EntryWrapper::OperationDone() {
+  if (!g_data->max_operations)
+    return;
+  g_data->latencies[state_].push_back(TimeTicks::Now() - operation_start_);
+  g_data->operations++;
+}
+
 void EntryWrapper::DoOpen(int key) {
   DCHECK_EQ(state_, NONE);
   if (entry_)
     return DoRead();
 
-  state_ = OPEN;
+  StartOperation(OPEN);
   int rv = g_data->cache->OpenEntry(
       g_data->keys[key], &entry_,
       base::Bind(&EntryWrapper::OnOpenDone, base::Unretained(this), key));
@@ -174,11 +223,12 @@ void EntryWrapper::DoOpen(int key) {
 }
 
 void EntryWrapper::OnOpenDone(int key, int result) {
+  OperationDone();
   if (result == net::OK)
     return DoRead();
 
   CHECK_EQ(state_, OPEN);
-  state_ = CREATE;
+  StartOperation(CREATE);
   result = g_data->cache->CreateEntry(
       g_data->keys[key], &entry_,
       base::Bind(&EntryWrapper::OnOpenDone, base::Unretained(this), key));
@@ -191,7 +241,7 @@ void EntryWrapper::DoRead() {
   if (!current_size)
     return DoWrite();
 
-  state_ = READ;
+  StartOperation(READ);
   memset(buffer_->data(), 'k', kReadSize);
   int rv = entry_->ReadData(
       0, 0, buffer_.get(), kReadSize,
@@ -202,6 +252,7 @@ void EntryWrapper::DoRead() {
 
 void EntryWrapper::OnReadDone(int result) {
   DCHECK_EQ(state_, READ);
+  OperationDone();
   CHECK_EQ(result, kReadSize);
   CHECK_EQ(0, memcmp(buffer_->data(), "Write: ", 7));
   DoWrite();
@@ -210,7 +261,7 @@ void EntryWrapper::OnReadDone(int result) {
 void EntryWrapper::DoWrite() {
   bool truncate = (rand() % 2 == 0);
   int size = kBufferSize - (rand() % 20) * kBufferSize / 20;
-  state_ = WRITE;
+  StartOperation(WRITE);
   base::snprintf(buffer_->data(), kBufferSize,
                  "Write: %d iter: %d, size: %d, truncate: %d     ",
                  g_data->writes, g_data->iteration, size, truncate ? 1 : 0);
@@ -225,7 +276,8 @@ void EntryWrapper::DoWrite() {
 void EntryWrapper::OnWriteDone(int size, int result) {
   DCHECK_EQ(state_, WRITE);
   CHECK_EQ(size, result);
-  if (!(g_data->writes++ % 100))
+  OperationDone();
+  if (!(g_data->writes++ % 100) && !g_data->max_operations)
     printf("Entries: %d    \r", g_data->writes);
 
   int random = rand() % 100;
@@ -245,7 +297,7 @@ void EntryWrapper::OnWriteDone(int size, int result) {
 }
 
 void EntryWrapper::DoDelete(const std::string& key) {
-  state_ = DOOM;
+  StartOperation(DOOM);
   int rv = g_data->cache->DoomEntry(
       key, base::Bind(&EntryWrapper::OnDeleteDone, base::Unretained(this)));
   if (rv != net::ERR_IO_PENDING)
@@ -254,6 +306,7 @@ void EntryWrapper::DoDelete(const std::string& key) {
 
 void EntryWrapper::OnDeleteDone(int result) {
   DCHECK_EQ(state_, DOOM);
+  OperationDone();
   if (entry_) {
     entry_->Close();
     entry_ = nullptr;
@@ -263,10 +316,40 @@ void EntryWrapper::OnDeleteDone(int result) {
 
 void LoopTask();
 
+// Returns true when the latency of |max_operations| has been measured.
+bool TimedEnoughOperations() {
+  return g_data->max_operations &&
+         g_data->operations >= g_data->max_operations;
+}
+
+// Prints the median and 99th percentile latency of each operation.
+void PrintLatencies() {
+  printf("Clients: %d, operations: %d\n",
+         static_cast<int>(g_data->entries.size()), g_data->operations);
+  for (int operation = OPEN; operation < MAX_OPERATION; operation++) {
+    std::vector<TimeDelta>& latencies = g_data->latencies[operation];
+    if (latencies.empty())
+      continue;
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-8s count: %6d  p50: %8.3f ms  p99: %8.3f ms\n",
+           kOperationNames[operation], static_cast<int>(latencies.size()),
+           latencies[latencies.size() / 2].InMillisecondsF(),
+           latencies[latencies.size() * 99 / 100].InMillisecondsF());
+  }
+}
+
 void EntryWrapper::DoIdle() {
   state_ = NONE;
   g_data->pendig_operations--;
-  DCHECK(g_data->pendig_operations);
+  if (TimedEnoughOperations()) {
+    // Let the operations in flight finish, then report.
+    if (!g_data->pendig_operations) {
+      PrintLatencies();
+      base::MessageLoop::current()->QuitWhenIdle();
+    }
+    return;
+  }
+  DCHECK(g_data->pendig_operations || g_data->max_operations);
   base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE,
                                                 base::Bind(&LoopTask));
 }
@@ -274,15 +357,16 @@ void EntryWrapper::DoIdle() {
 // The task that keeps the main thread busy. Whenever an entry becomes idle this
 // task is executed again.
 void LoopTask() {
-  if (g_data->pendig_operations >= kNumEntries)
+  const int num_entries = static_cast<int>(g_data->entries.size());
+  if (g_data->pendig_operations >= num_entries || TimedEnoughOperations())
     return;
 
-  int slot = rand() % kNumEntries;
+  int slot = rand() % num_entries;
   if (g_data->entries[slot].state() == NONE) {
     // Each slot will have some keys assigned to it so that the same entry will
     // not be open by two slots, which means that the state is well known at
     // all times.
-    int keys_per_entry = kNumKeys / kNumEntries;
+    int keys_per_entry = kNumKeys / num_entries;
     int key = rand() % keys_per_entry + keys_per_entry * slot;
     g_data->pendig_operations++;
     g_data->entries[slot].DoOpen(key);
@@ -292,10 +376,12 @@ void LoopTask() {
                                                 base::Bind(&LoopTask));
 }
 
-// This thread will loop forever, adding and removing entries from the cache.
-// iteration is the current crash cycle, so the entries on the cache are marked
-// to know which instance of the application wrote them.
-void StressTheCache(int iteration) {
+// This thread will loop forever, adding and removing entries from the cache,
+// with |num_entries| entries in use at a time, unless |max_operations| is set,
+// in which case it returns after timing that many operations. iteration is the
+// current crash cycle, so the entries on the cache are marked to know which
+// instance of the application wrote them.
+void StressTheCache(int iteration, int num_entries, int max_operations) {
   int cache_size = 0x2000000;  // 32MB.
   uint32_t mask = 0xfff;       // 4096 entries.
 
@@ -308,8 +394,9 @@ void StressTheCache(int iteration) {
           base::Thread::Options(base::MessageLoop::TYPE_IO, 0)))
     return;
 
-  g_data = new Data();
+  g_data = new Data(num_entries);
   g_data->iteration = iteration;
+  g_data->max_operations = max_operations;
   g_data->cache = new disk_cache::BackendImpl(
       path, mask, cache_thread.task_runner().get(), NULL);
   g_data->cache->SetMaxSize(cache_size);
@@ -407,9 +494,39 @@ const GUID kStressCacheTraceProviderName = {
         { 0x9a, 0xbf, 0xd5, 0x43, 0x83, 0xf1, 0x4a, 0xd } };
 #endif
 
+// Measures the latency of the operations of |num_clients| clients.
+int LatencyCode(int num_clients, int num_operations) {
+  if (num_clients < 1 || num_clients > kNumKeys || num_operations < 1) {
+    printf("Invalid number of clients or operations\n");
+    return kError;
+  }
+
+  base::MessageLoopForIO message_loop;
+  StressTheCache(0, num_clients, num_operations);
+  return 0;
+}
+
 int main(int argc, const char* argv[]) {
   // Setup an AtExitManager so Singleton objects will be destructed.
   base::AtExitManager at_exit_manager;
+  base::CommandLine::Init(argc, argv);
+
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (command_line.HasSwitch(kClientsSwitch)) {
+    int num_clients = 0;
+    int num_operations = kDefaultOperations;
+    if (!base::StringToInt(command_line.GetSwitchValueASCII(kClientsSwitch),
+                           &num_clients) ||
+        (command_line.HasSwitch(kOperationsSwitch) &&
+         !base::StringToInt(
+             command_line.GetSwitchValueASCII(kOperationsSwitch),
+             &num_operations))) {
+      printf("Usage: stress_cache --clients=N [--operations=M]\n");
+      return kError;
+    }
+    return LatencyCode(num_clients, num_operations);
+  }
 
   if (argc < 2)
     return MasterCode();
@@ -420,7 +537,6 @@ int main(int argc, const char* argv[]) {
 #if defined(OS_WIN)
   logging::LogEventProvider::Initialize(kStressCacheTraceProviderName);
 #else
-  base::CommandLine::Init(argc, argv);
   logging::LoggingSettings settings;
   settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG;
   logging::InitLogging(settings);
@@ -438,6 +554,6 @@ int main(int argc, const char* argv[]) {
     return kError;
   }
 
-  StressTheCache(iteration);
+  StressTheCache(iteration, kNumEntries, 0);
   return 0;
 }
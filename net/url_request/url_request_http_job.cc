@@ -731,6 +731,9 @@ void URLRequestHttpJob::AddExtraHeaders() {
       advertised_encodings += ", sdch";
     if (advertise_brotli)
       advertised_encodings += ", br";
+    // Shared Brotli is decoded with the dictionaries advertised for SDCH.
+    if (advertise_brotli && dictionaries_advertised_)
+      advertised_encodings += ", sbr";
     // Tell the server what compression formats are supported.
     request_info_.extra_headers.SetHeader(HttpRequestHeaders::kAcceptEncoding,
                                           advertised_encodings);